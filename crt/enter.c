@@ -18,6 +18,7 @@
 #include <syslog.h>
 #include <unistd.h>
 
+#include <myst/aio.h>
 #include <myst/gcov.h>
 #include <myst/kernel.h>
 #include <myst/libc.h>
@@ -34,6 +35,10 @@ typedef long (*syscall_callback_t)(long n, long params[6]);
 
 static syscall_callback_t _syscall_callback;
 
+typedef long (*clock_gettime_callback_t)(clockid_t, struct timespec*);
+
+static clock_gettime_callback_t _clock_gettime_callback;
+
 void myst_trace_ptr(const char* msg, const void* ptr);
 
 void myst_trace(const char* msg);
@@ -44,6 +49,8 @@ void myst_dump_argv(int argc, const char* argv[]);
 
 static void _create_itimer_thread(void);
 
+static void _create_aio_threads(void);
+
 static int myst_retrieve_wanted_secrets(void);
 
 int myst_pre_launch_hook()
@@ -55,12 +62,22 @@ int myst_pre_launch_hook()
 
 long myst_syscall(long n, long params[6])
 {
-    if ((n == SYS_setitimer) || (n == SYS_getitimer))
+    /* clock_gettime() is the hottest syscall: skip the kernel entry */
+    if (n == SYS_clock_gettime && _clock_gettime_callback)
+    {
+        clockid_t clk_id = (clockid_t)params[0];
+        struct timespec* tp = (struct timespec*)params[1];
+        return (*_clock_gettime_callback)(clk_id, tp);
+    }
+
+    if ((n == SYS_setitimer) || (n == SYS_timer_settime) ||
+        (n == SYS_timerfd_settime))
     {
-        /* itimer is requested by SYS_settimer returning EAGAIN. If this happens
-         * we need to create the thread and re-invoke it */
+        /* the kernel's timer thread is requested by arming a timer returning
+         * MYST_ENEEDTHREADS. If this happens we need to create the thread and
+         * re-invoke it */
         long ret = (*_syscall_callback)(n, params);
-        if (ret == -EAGAIN)
+        if (ret == -MYST_ENEEDTHREADS)
         {
             _create_itimer_thread();
             return (*_syscall_callback)(n, params);
@@ -69,6 +86,20 @@ long myst_syscall(long n, long params[6])
             return ret;
     }
 
+    if (n == SYS_io_setup)
+    {
+        /* the first io_setup() returns MYST_ENEEDTHREADS to have the AIO
+         * worker threads created, after which it is re-invoked */
+        long ret = (*_syscall_callback)(n, params);
+        if (ret == -MYST_ENEEDTHREADS)
+        {
+            _create_aio_threads();
+            return (*_syscall_callback)(n, params);
+        }
+        else
+            return ret;
+    }
+
     if (n == SYS_fork)
     {
         /* fork is implemented in the CRT rather than the kernel.
@@ -181,6 +212,7 @@ void myst_enter_crt(
     if (args)
     {
         _wanted_secrets = args->wanted_secrets;
+        _clock_gettime_callback = args->clock_gettime;
     }
     _dlstart_c((size_t*)stack, (size_t*)dynv);
 }
@@ -189,7 +221,7 @@ static void* _itimer_thread(void* arg)
 {
     (void)arg;
 
-    /* Enter the kernel on the itimer thread */
+    /* Enter the kernel on the itimer thread (the kernel's timer thread) */
     long params[6] = {0};
     myst_syscall(SYS_myst_run_itimer, params);
 
@@ -225,6 +257,47 @@ static void _create_itimer_thread(void)
     }
 }
 
+static void* _aio_thread(void* arg)
+{
+    (void)arg;
+
+    /* Enter the kernel on the AIO worker thread */
+    long params[6] = {0};
+    myst_syscall(SYS_myst_run_aio, params);
+
+    return NULL;
+}
+
+// Create the AIO worker threads in user-space (see _create_itimer_thread()).
+static void _create_aio_threads(void)
+{
+    pthread_attr_t attr;
+    const char* func = __FUNCTION__;
+
+    if (pthread_attr_init(&attr) != 0)
+    {
+        fprintf(stderr, "%s(): pthread_attr_init() failed\n", func);
+        abort();
+    }
+
+    if (pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED) != 0)
+    {
+        fprintf(stderr, "%s(): pthread_attr_setdetachstate() failed\n", func);
+        abort();
+    }
+
+    for (size_t i = 0; i < MYST_AIO_NUM_WORKERS; i++)
+    {
+        pthread_t thread;
+
+        if (pthread_create(&thread, &attr, _aio_thread, NULL) != 0)
+        {
+            fprintf(stderr, "%s(): pthread_create() failed\n", func);
+            abort();
+        }
+    }
+}
+
 bool myst_get_exec_stack_option()
 {
     long params[6] = {0};
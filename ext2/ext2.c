@@ -13,6 +13,7 @@
 #include <myst/eraise.h>
 #include <myst/ext2.h>
 #include <myst/hex.h>
+#include <myst/iov.h>
 #include <myst/paths.h>
 #include <myst/round.h>
 #include <myst/strarr.h>
@@ -3572,14 +3573,18 @@ done:
     return ret;
 }
 
-int64_t ext2_read(myst_fs_t* fs, myst_file_t* file, void* data, uint64_t size)
+/* read size bytes from the file offset into the vector at the cursor */
+static int64_t _read_vec(
+    myst_fs_t* fs,
+    myst_file_t* file,
+    myst_iov_cursor_t* cursor,
+    uint64_t size)
 {
     int64_t ret = 0;
     ext2_t* ext2 = (ext2_t*)fs;
     uint32_t first;
     uint32_t i;
     uint64_t r;
-    uint8_t* end = (uint8_t*)data;
     size_t num_blocks;
     bool eof = false;
     ext2_block_t* block = NULL;
@@ -3588,7 +3593,7 @@ int64_t ext2_read(myst_fs_t* fs, myst_file_t* file, void* data, uint64_t size)
         ERAISE(-ENOMEM);
 
     /* Check parameters */
-    if (!_ext2_valid(ext2) || !_file_valid(file) || !data)
+    if (!_ext2_valid(ext2) || !_file_valid(file))
         ERAISE(-EINVAL);
 
     /* fail if file has been opened for write only */
@@ -3644,9 +3649,8 @@ int64_t ext2_read(myst_fs_t* fs, myst_file_t* file, void* data, uint64_t size)
             }
 
             /* Copy data to user buffer */
-            memcpy(end, block->data + offset, n);
+            myst_iov_cursor_scatter(cursor, block->data + offset, n);
             r -= n;
-            end += n;
             file->shared->offset += n;
         }
     }
@@ -3664,17 +3668,33 @@ done:
     return ret;
 }
 
-int64_t ext2_write(
+int64_t ext2_read(myst_fs_t* fs, myst_file_t* file, void* data, uint64_t size)
+{
+    int64_t ret = 0;
+    struct iovec iov = {data, size};
+    myst_iov_cursor_t cursor;
+
+    if (!data)
+        ERAISE(-EINVAL);
+
+    myst_iov_cursor_init(&cursor, &iov, 1);
+    ret = _read_vec(fs, file, &cursor, size);
+
+done:
+    return ret;
+}
+
+/* write size bytes from the vector at the cursor to the file offset */
+static int64_t _write_vec(
     myst_fs_t* fs,
     myst_file_t* file,
-    const void* data,
+    myst_iov_cursor_t* cursor,
     uint64_t size)
 {
     int64_t ret = 0;
     ext2_t* ext2 = (ext2_t*)fs;
     uint32_t first; /* the first block to be written */
     uint64_t r;     /* remaining bytes to be written */
-    uint8_t* p = (uint8_t*)data;
     uint32_t blkno = 0;
     size_t file_size;
     struct locals
@@ -3684,7 +3704,7 @@ int64_t ext2_write(
     struct locals* locals = NULL;
 
     /* check parameters */
-    if (!_ext2_valid(ext2) || !_file_valid(file) || (!data && size))
+    if (!_ext2_valid(ext2) || !_file_valid(file))
         ERAISE(-EINVAL);
 
     if (!(locals = malloc(sizeof(struct locals))))
@@ -3747,7 +3767,8 @@ int64_t ext2_write(
             n = _min_size(r, ext2->block_size - block_offset);
 
             /* copy buffer bytes onto block */
-            memcpy(locals->block.data + block_offset, p, n);
+            myst_iov_cursor_gather(
+                cursor, locals->block.data + block_offset, n);
 
             /* write the block */
             ECHECK(_write_block(ext2, blkno, &locals->block));
@@ -3766,7 +3787,6 @@ int64_t ext2_write(
             file->shared->offset += n;
 
             r -= n;
-            p += n;
         }
     }
 
@@ -3794,6 +3814,26 @@ done:
     return ret;
 }
 
+int64_t ext2_write(
+    myst_fs_t* fs,
+    myst_file_t* file,
+    const void* data,
+    uint64_t size)
+{
+    int64_t ret = 0;
+    struct iovec iov = {(void*)data, size};
+    myst_iov_cursor_t cursor;
+
+    if (!data && size)
+        ERAISE(-EINVAL);
+
+    myst_iov_cursor_init(&cursor, &iov, 1);
+    ret = _write_vec(fs, file, &cursor, size);
+
+done:
+    return ret;
+}
+
 off_t ext2_lseek(myst_fs_t* fs, myst_file_t* file, off_t offset, int whence)
 {
     off_t ret = 0;
@@ -4980,12 +5020,17 @@ static ssize_t _ext2_readv(
 {
     ext2_t* ext2 = (ext2_t*)fs;
     ssize_t ret = 0;
+    ssize_t len;
+    myst_iov_cursor_t cursor;
 
     if (!_ext2_valid(ext2) || !_file_valid(file))
         ERAISE(-EINVAL);
 
-    ret = myst_fdops_readv(&fs->fdops, file, iov, iovcnt);
-    ECHECK(ret);
+    ECHECK(len = myst_iov_len(iov, iovcnt));
+
+    /* read directly into the vector */
+    myst_iov_cursor_init(&cursor, iov, iovcnt);
+    ECHECK(ret = _read_vec(fs, file, &cursor, (uint64_t)len));
 
 done:
     return ret;
@@ -4999,12 +5044,17 @@ static ssize_t _ext2_writev(
 {
     ext2_t* ext2 = (ext2_t*)fs;
     ssize_t ret = 0;
+    ssize_t len;
+    myst_iov_cursor_t cursor;
 
     if (!_ext2_valid(ext2) || !_file_valid(file))
         ERAISE(-EINVAL);
 
-    ret = myst_fdops_writev(&fs->fdops, file, iov, iovcnt);
-    ECHECK(ret);
+    ECHECK(len = myst_iov_len(iov, iovcnt));
+
+    /* write directly from the vector (updating the inode once) */
+    myst_iov_cursor_init(&cursor, iov, iovcnt);
+    ECHECK(ret = _write_vec(fs, file, &cursor, (uint64_t)len));
 
 done:
     return ret;
@@ -0,0 +1,888 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <myst/cpio.h>
+#include <myst/round.h>
+#include <myst/strarr.h>
+#include <myst/strings.h>
+
+/*
+**==============================================================================
+**
+** Multithreaded CPIO packing and unpacking (for myst mkcpio and excpio).
+**
+** The packer is a pipeline: a walker thread lists the source tree in exactly
+** the order used by myst_cpio_pack(), reader threads stat and read the files
+** ahead of the writer, and the calling thread writes the archive in order
+** through a large buffer. Files larger than PACK_INLINE_MAX are not read
+** into memory; the writer copies them with copy_file_range().
+**
+** The unpacker maps the archive, creates the directories in archive order,
+** and then writes the files and creates the symbolic links on all threads.
+**
+**==============================================================================
+*/
+
+#define MAX_THREADS 16
+
+/* maximum number of entries read ahead of the writer */
+#define PACK_WINDOW 256
+
+/* larger files are copied directly into the archive by the writer */
+#define PACK_INLINE_MAX (256 * 1024)
+
+#define PACK_BUFFER_SIZE (4 * 1024 * 1024)
+
+/* size of the symbolic link target buffer (as in myst_cpio_pack()) */
+#define LINK_TARGET_MAX 4096
+
+static size_t _num_threads(size_t num_threads)
+{
+    if (num_threads == 0)
+    {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        num_threads = (n > 0) ? (size_t)n : 1;
+    }
+
+    return num_threads > MAX_THREADS ? MAX_THREADS : num_threads;
+}
+
+static int _write_all(int fd, const void* data, size_t size)
+{
+    const uint8_t* p = (const uint8_t*)data;
+
+    while (size > 0)
+    {
+        ssize_t n = write(fd, p, size);
+
+        if (n < 0 && errno == EINTR)
+            continue;
+
+        if (n <= 0)
+            return -1;
+
+        p += n;
+        size -= (size_t)n;
+    }
+
+    return 0;
+}
+
+/*
+**==============================================================================
+**
+** packing:
+**
+**==============================================================================
+*/
+
+typedef struct pack_job
+{
+    char* path;       /* path of the file */
+    const char* name; /* name within the archive (points into path) */
+    bool ready;       /* set by the reader */
+    int err;
+    struct stat st;
+    int fd;       /* large regular files (copied by the writer) */
+    void* data;   /* small regular files and symbolic link targets */
+    size_t size;  /* size of data */
+} pack_job_t;
+
+typedef struct packer
+{
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    const char* source;
+    pack_job_t** jobs;
+    size_t num_jobs;
+    size_t capacity;
+    size_t next_read;  /* next job to be claimed by a reader */
+    size_t next_write; /* next job to be written */
+    bool walk_done;
+    bool failed;
+} packer_t;
+
+static void _pack_fail(packer_t* packer)
+{
+    pthread_mutex_lock(&packer->lock);
+    packer->failed = true;
+    pthread_cond_broadcast(&packer->cond);
+    pthread_mutex_unlock(&packer->lock);
+}
+
+static void _free_job(pack_job_t* job)
+{
+    if (job)
+    {
+        if (job->fd >= 0)
+            close(job->fd);
+
+        free(job->data);
+        free(job->path);
+        free(job);
+    }
+}
+
+static int _add_job(packer_t* packer, const char* path)
+{
+    int ret = -1;
+    pack_job_t* job;
+    const char* p;
+
+    if (!(job = calloc(1, sizeof(pack_job_t))))
+        goto done;
+
+    job->fd = -1;
+
+    if (!(job->path = strdup(path)))
+        goto done;
+
+    /* remove the source directory from the name */
+    p = job->path + strlen(packer->source);
+
+    if (*p == '/')
+        p++;
+
+    job->name = p;
+
+    pthread_mutex_lock(&packer->lock);
+    {
+        if (packer->num_jobs == packer->capacity)
+        {
+            size_t n = packer->capacity ? packer->capacity * 2 : 1024;
+            pack_job_t** jobs;
+
+            if (!(jobs = realloc(packer->jobs, n * sizeof(pack_job_t*))))
+            {
+                pthread_mutex_unlock(&packer->lock);
+                goto done;
+            }
+
+            packer->jobs = jobs;
+            packer->capacity = n;
+        }
+
+        packer->jobs[packer->num_jobs++] = job;
+        job = NULL;
+        pthread_cond_broadcast(&packer->cond);
+    }
+    pthread_mutex_unlock(&packer->lock);
+
+    ret = 0;
+
+done:
+
+    _free_job(job);
+
+    return ret;
+}
+
+/* list the tree in the same order as _pack() in utils/cpio.c */
+static int _walk(packer_t* packer, const char* root)
+{
+    int ret = -1;
+    DIR* dir = NULL;
+    struct dirent* ent;
+    char path[MYST_CPIO_PATH_MAX];
+    myst_strarr_t dirs = MYST_STRARR_INITIALIZER;
+
+    if (__atomic_load_n(&packer->failed, __ATOMIC_RELAXED))
+        goto done;
+
+    if (!(dir = opendir(root)))
+        goto done;
+
+    /* Append this directory to the CPIO archive. */
+    if (strcmp(packer->source, root) != 0)
+    {
+        if (_add_job(packer, root) != 0)
+            goto done;
+    }
+
+    /* Find all children of this directory. */
+    while ((ent = readdir(dir)))
+    {
+        if (strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0)
+        {
+            continue;
+        }
+
+        *path = '\0';
+
+        if (strcmp(root, ".") != 0)
+        {
+            MYST_STRLCAT(path, root);
+            MYST_STRLCAT(path, "/");
+        }
+
+        MYST_STRLCAT(path, ent->d_name);
+
+        if (ent->d_type & DT_DIR)
+        {
+            if (myst_strarr_append(&dirs, path) != 0)
+                goto done;
+        }
+        else
+        {
+            if (_add_job(packer, path) != 0)
+                goto done;
+        }
+    }
+
+    /* Recurse into child directories */
+    for (size_t i = 0; i < dirs.size; i++)
+    {
+        if (_walk(packer, dirs.data[i]) != 0)
+            goto done;
+    }
+
+    ret = 0;
+
+done:
+
+    if (dir)
+        closedir(dir);
+
+    myst_strarr_release(&dirs);
+
+    return ret;
+}
+
+static void* _walker_thread(void* arg)
+{
+    packer_t* packer = (packer_t*)arg;
+
+    if (_walk(packer, packer->source) != 0)
+        _pack_fail(packer);
+
+    pthread_mutex_lock(&packer->lock);
+    packer->walk_done = true;
+    pthread_cond_broadcast(&packer->cond);
+    pthread_mutex_unlock(&packer->lock);
+
+    return NULL;
+}
+
+/* stat the file and read its data (or open it if it is large) */
+static int _read_job(pack_job_t* job)
+{
+    if (lstat(job->path, &job->st) != 0)
+        return -1;
+
+    if (S_ISREG(job->st.st_mode))
+    {
+        size_t size;
+
+        if ((job->fd = open(job->path, O_RDONLY)) < 0)
+            return -1;
+
+        /* Resolve TOC-TOU by getting the statbuf again */
+        if (fstat(job->fd, &job->st) != 0)
+            return -1;
+
+        if ((size = (size_t)job->st.st_size) > PACK_INLINE_MAX)
+            return 0;
+
+        if (size && !(job->data = malloc(size)))
+            return -1;
+
+        while (job->size < size)
+        {
+            uint8_t* p = (uint8_t*)job->data + job->size;
+            ssize_t n = read(job->fd, p, size - job->size);
+
+            if (n < 0 && errno == EINTR)
+                continue;
+
+            if (n <= 0)
+                return -1;
+
+            job->size += (size_t)n;
+        }
+
+        close(job->fd);
+        job->fd = -1;
+    }
+    else if (S_ISLNK(job->st.st_mode))
+    {
+        ssize_t n;
+
+        if (!(job->data = malloc(LINK_TARGET_MAX)))
+            return -1;
+
+        n = readlink(job->path, job->data, LINK_TARGET_MAX);
+
+        if (n <= 0 || n >= LINK_TARGET_MAX)
+            return -1;
+
+        job->size = (size_t)n;
+    }
+
+    return 0;
+}
+
+static void* _reader_thread(void* arg)
+{
+    packer_t* packer = (packer_t*)arg;
+
+    pthread_mutex_lock(&packer->lock);
+
+    for (;;)
+    {
+        pack_job_t* job;
+
+        if (packer->failed)
+            break;
+
+        if (packer->next_read == packer->num_jobs ||
+            packer->next_read >= packer->next_write + PACK_WINDOW)
+        {
+            if (packer->walk_done && packer->next_read == packer->num_jobs)
+                break;
+
+            pthread_cond_wait(&packer->cond, &packer->lock);
+            continue;
+        }
+
+        job = packer->jobs[packer->next_read++];
+        pthread_mutex_unlock(&packer->lock);
+
+        job->err = _read_job(job);
+
+        pthread_mutex_lock(&packer->lock);
+        job->ready = true;
+        pthread_cond_broadcast(&packer->cond);
+    }
+
+    pthread_mutex_unlock(&packer->lock);
+
+    return NULL;
+}
+
+typedef struct out
+{
+    int fd;
+    uint8_t* buf;
+    size_t size;
+} out_t;
+
+static int _flush(out_t* out)
+{
+    if (out->size && _write_all(out->fd, out->buf, out->size) != 0)
+        return -1;
+
+    out->size = 0;
+    return 0;
+}
+
+static int _put(out_t* out, const void* data, size_t size)
+{
+    if (size == 0)
+        return 0;
+
+    if (out->size + size > PACK_BUFFER_SIZE)
+    {
+        if (_flush(out) != 0)
+            return -1;
+
+        if (size > PACK_BUFFER_SIZE)
+            return _write_all(out->fd, data, size);
+    }
+
+    memcpy(out->buf + out->size, data, size);
+    out->size += size;
+    return 0;
+}
+
+/* copy size bytes from the file into the archive without buffering */
+static int _copy_file(out_t* out, int fd, size_t size)
+{
+    bool fallback = false;
+
+    if (_flush(out) != 0)
+        return -1;
+
+    while (size > 0)
+    {
+        ssize_t n;
+
+        if (!fallback)
+        {
+            n = copy_file_range(fd, NULL, out->fd, NULL, size, 0);
+
+            if (n < 0 && (errno == ENOSYS || errno == EXDEV ||
+                          errno == EINVAL || errno == EOPNOTSUPP))
+            {
+                fallback = true;
+                continue;
+            }
+        }
+        else
+        {
+            /* use the output buffer as the bounce buffer */
+            size_t count = size < PACK_BUFFER_SIZE ? size : PACK_BUFFER_SIZE;
+
+            if ((n = read(fd, out->buf, count)) > 0 &&
+                _write_all(out->fd, out->buf, (size_t)n) != 0)
+            {
+                return -1;
+            }
+        }
+
+        if (n < 0 && errno == EINTR)
+            continue;
+
+        /* fail if the file was truncated */
+        if (n <= 0)
+            return -1;
+
+        size -= (size_t)n;
+    }
+
+    return 0;
+}
+
+static int _write_job(out_t* out, pack_job_t* job)
+{
+    myst_cpio_entry_t ent;
+    uint8_t hdr[MYST_CPIO_ENTRY_HEADER_MAX];
+    static const uint8_t zeros[4];
+    ssize_t n;
+    size_t size;
+
+    if (job->err != 0)
+        return -1;
+
+    memset(&ent, 0, sizeof(ent));
+    ent.mode = job->st.st_mode;
+    ent.size = S_ISDIR(job->st.st_mode) ? 0 : (size_t)job->st.st_size;
+
+    if (MYST_STRLCPY(ent.name, job->name) >= sizeof(ent.name))
+        return -1;
+
+    if ((n = myst_cpio_format_entry(&ent, hdr, sizeof(hdr))) < 0)
+        return -1;
+
+    /* character devices and fifos are skipped */
+    if (n == 0)
+        return 0;
+
+    if (_put(out, hdr, (size_t)n) != 0)
+        return -1;
+
+    if (job->fd >= 0)
+    {
+        size = (size_t)job->st.st_size;
+
+        if (_copy_file(out, job->fd, size) != 0)
+            return -1;
+    }
+    else
+    {
+        size = job->size;
+
+        if (_put(out, job->data, size) != 0)
+            return -1;
+    }
+
+    /* Pad the data to a four-byte boundary. */
+    if (size % 4 && _put(out, zeros, 4 - size % 4) != 0)
+        return -1;
+
+    return 0;
+}
+
+int myst_cpio_pack_parallel(
+    const char* source,
+    const char* target,
+    size_t num_threads)
+{
+    int ret = -1;
+    myst_cpio_t* cpio = NULL;
+    packer_t packer;
+    pthread_t walker;
+    pthread_t readers[MAX_THREADS];
+    size_t num_readers = 0;
+    bool walker_started = false;
+    out_t out = {-1, NULL, 0};
+
+    memset(&packer, 0, sizeof(packer));
+    pthread_mutex_init(&packer.lock, NULL);
+    pthread_cond_init(&packer.cond, NULL);
+    packer.source = source;
+
+    if (!source || !target)
+        goto done;
+
+    if (!(out.buf = malloc(PACK_BUFFER_SIZE)))
+        goto done;
+
+    /* writes the "." entry */
+    if (!(cpio = myst_cpio_open(target, MYST_CPIO_FLAG_CREATE)))
+        goto done;
+
+    out.fd = myst_cpio_get_fd(cpio);
+
+    if (pthread_create(&walker, NULL, _walker_thread, &packer) != 0)
+        goto done;
+
+    walker_started = true;
+
+    num_threads = _num_threads(num_threads);
+
+    for (size_t i = 0; i < num_threads; i++)
+    {
+        if (pthread_create(&readers[i], NULL, _reader_thread, &packer) != 0)
+            break;
+
+        num_readers++;
+    }
+
+    if (num_readers == 0)
+        goto done;
+
+    /* write the entries in order */
+    for (;;)
+    {
+        pack_job_t* job;
+
+        pthread_mutex_lock(&packer.lock);
+
+        while (!packer.failed &&
+               !(packer.next_write < packer.num_jobs &&
+                 packer.jobs[packer.next_write]->ready) &&
+               !(packer.walk_done && packer.next_write == packer.num_jobs))
+        {
+            pthread_cond_wait(&packer.cond, &packer.lock);
+        }
+
+        if (packer.failed || packer.next_write == packer.num_jobs)
+        {
+            pthread_mutex_unlock(&packer.lock);
+            break;
+        }
+
+        job = packer.jobs[packer.next_write];
+        pthread_mutex_unlock(&packer.lock);
+
+        if (_write_job(&out, job) != 0)
+        {
+            _pack_fail(&packer);
+            break;
+        }
+
+        _free_job(job);
+
+        /* let the readers move the window forward */
+        pthread_mutex_lock(&packer.lock);
+        packer.jobs[packer.next_write++] = NULL;
+        pthread_cond_broadcast(&packer.cond);
+        pthread_mutex_unlock(&packer.lock);
+    }
+
+    if (packer.failed || _flush(&out) != 0)
+        goto done;
+
+    ret = 0;
+
+done:
+
+    if (ret != 0)
+        _pack_fail(&packer);
+
+    if (walker_started)
+        pthread_join(walker, NULL);
+
+    for (size_t i = 0; i < num_readers; i++)
+        pthread_join(readers[i], NULL);
+
+    for (size_t i = packer.next_write; i < packer.num_jobs; i++)
+        _free_job(packer.jobs[i]);
+
+    free(packer.jobs);
+    free(out.buf);
+
+    /* writes the trailer */
+    if (cpio && myst_cpio_close(cpio) != 0)
+        ret = -1;
+
+    pthread_cond_destroy(&packer.cond);
+    pthread_mutex_destroy(&packer.lock);
+
+    return ret;
+}
+
+/*
+**==============================================================================
+**
+** unpacking:
+**
+**==============================================================================
+*/
+
+typedef struct unpack_job
+{
+    char* path;
+    const void* data;
+    size_t size;
+    uint32_t mode;
+} unpack_job_t;
+
+typedef struct unpacker
+{
+    unpack_job_t* jobs;
+    size_t num_jobs;
+    size_t next; /* next job (atomic) */
+    int failed;  /* atomic */
+} unpacker_t;
+
+static int _unpack_job(const unpack_job_t* job)
+{
+    int ret = -1;
+    int fd = -1;
+
+    if (S_ISREG(job->mode))
+    {
+        if ((fd = open(job->path, O_WRONLY | O_CREAT, 0666)) < 0)
+            goto done;
+
+        if (_write_all(fd, job->data, job->size) != 0)
+            goto done;
+
+        if (close(fd) != 0)
+        {
+            fd = -1;
+            goto done;
+        }
+
+        fd = -1;
+    }
+    else
+    {
+        char target[PATH_MAX];
+
+        if (job->size < 1 || job->size >= sizeof(target))
+            goto done;
+
+        memcpy(target, job->data, job->size);
+        target[job->size] = '\0';
+
+        if (symlink(target, job->path) != 0)
+            goto done;
+    }
+
+    ret = 0;
+
+done:
+
+    if (fd >= 0)
+        close(fd);
+
+    return ret;
+}
+
+static void* _unpacker_thread(void* arg)
+{
+    unpacker_t* unpacker = (unpacker_t*)arg;
+
+    while (!__atomic_load_n(&unpacker->failed, __ATOMIC_RELAXED))
+    {
+        size_t i = __atomic_fetch_add(&unpacker->next, 1, __ATOMIC_RELAXED);
+
+        if (i >= unpacker->num_jobs)
+            break;
+
+        if (_unpack_job(&unpacker->jobs[i]) != 0)
+        {
+            fprintf(
+                stderr,
+                "*** cpio: failed to create %s\n",
+                unpacker->jobs[i].path);
+            __atomic_store_n(&unpacker->failed, 1, __ATOMIC_RELAXED);
+        }
+    }
+
+    return NULL;
+}
+
+int myst_cpio_unpack_parallel(
+    const char* source,
+    const char* target,
+    size_t num_threads)
+{
+    int ret = -1;
+    int fd = -1;
+    void* data = MAP_FAILED;
+    size_t size = 0;
+    size_t pos = 0;
+    unpacker_t unpacker;
+    size_t capacity = 0;
+    pthread_t threads[MAX_THREADS];
+    size_t nthreads = 0;
+    struct locals
+    {
+        myst_cpio_entry_t entry;
+        char path[MYST_CPIO_PATH_MAX];
+    };
+    struct locals* locals = NULL;
+
+    memset(&unpacker, 0, sizeof(unpacker));
+
+    if (!source || !target)
+        goto done;
+
+    if (!(locals = malloc(sizeof(struct locals))))
+        goto done;
+
+    /* map the archive */
+    {
+        struct stat st;
+
+        if ((fd = open(source, O_RDONLY)) < 0)
+            goto done;
+
+        if (fstat(fd, &st) != 0 || st.st_size <= 0)
+            goto done;
+
+        size = (size_t)st.st_size;
+
+        data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (data == MAP_FAILED)
+            goto done;
+    }
+
+    if (access(target, R_OK) != 0 && mkdir(target, 0766) != 0)
+        goto done;
+
+    /* create the directories in order and collect the files and links */
+    for (;;)
+    {
+        const void* file_data;
+        int r;
+
+        r = myst_cpio_next_entry(data, size, &pos, &locals->entry, &file_data);
+
+        if (r == 0)
+            break;
+
+        if (r < 0)
+            goto done;
+
+        if (strcmp(locals->entry.name, ".") == 0)
+            continue;
+
+        MYST_STRLCPY(locals->path, target);
+        MYST_STRLCAT(locals->path, "/");
+        MYST_STRLCAT(locals->path, locals->entry.name);
+
+        if (S_ISDIR(locals->entry.mode))
+        {
+            struct stat st;
+
+            if (stat(locals->path, &st) == 0)
+            {
+                if (!S_ISDIR(st.st_mode))
+                {
+                    fprintf(
+                        stderr,
+                        "*** cpio: already exists: %s\n",
+                        locals->path);
+                    goto done;
+                }
+            }
+            else if (mkdir(locals->path, locals->entry.mode) != 0)
+            {
+                goto done;
+            }
+        }
+        else if (S_ISREG(locals->entry.mode) || S_ISLNK(locals->entry.mode))
+        {
+            unpack_job_t* job;
+
+            if (unpacker.num_jobs == capacity)
+            {
+                size_t n = capacity ? capacity * 2 : 1024;
+                unpack_job_t* jobs;
+
+                if (!(jobs = realloc(unpacker.jobs, n * sizeof(unpack_job_t))))
+                    goto done;
+
+                unpacker.jobs = jobs;
+                capacity = n;
+            }
+
+            job = &unpacker.jobs[unpacker.num_jobs];
+
+            if (!(job->path = strdup(locals->path)))
+                goto done;
+
+            job->data = file_data;
+            job->size = locals->entry.size;
+            job->mode = locals->entry.mode;
+            unpacker.num_jobs++;
+        }
+        else
+        {
+            goto done;
+        }
+    }
+
+    /* write the files on all threads (including this one) */
+    num_threads = _num_threads(num_threads);
+
+    for (size_t i = 1; i < num_threads; i++)
+    {
+        if (pthread_create(
+                &threads[nthreads], NULL, _unpacker_thread, &unpacker) != 0)
+        {
+            break;
+        }
+
+        nthreads++;
+    }
+
+    _unpacker_thread(&unpacker);
+
+    for (size_t i = 0; i < nthreads; i++)
+        pthread_join(threads[i], NULL);
+
+    if (unpacker.failed)
+        goto done;
+
+    ret = 0;
+
+done:
+
+    for (size_t i = 0; i < unpacker.num_jobs; i++)
+        free(unpacker.jobs[i].path);
+
+    free(unpacker.jobs);
+
+    if (data != MAP_FAILED)
+        munmap(data, size);
+
+    if (fd >= 0)
+        close(fd);
+
+    if (locals)
+        free(locals);
+
+    return ret;
+}
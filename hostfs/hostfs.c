@@ -7,6 +7,7 @@
 #include <dirent.h>
 #include <fcntl.h>
 #include <limits.h>
+#include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/ioctl.h>
@@ -17,12 +18,386 @@
 #include <myst/fs.h>
 #include <myst/hostfs.h>
 #include <myst/iov.h>
+#include <myst/kernel.h>
 #include <myst/realpath.h>
+#include <myst/spinlock.h>
 #include <myst/strings.h>
 #include <myst/syscall.h>
 #include <myst/tcall.h>
 #include <myst/uid_gid.h>
 
+/*
+**==============================================================================
+**
+** attribute cache:
+**
+** Results of stat(), lstat() and readlink() (including ENOENT and ENOTDIR
+** failures) and complete directory listings are cached by path so that
+** repeated metadata queries are answered without a host call. Entries live
+** for __myst_kernel_args.hostfs_cache_ttl milliseconds (zero disables the
+** cache). Any change made through this hostfs instance flushes the whole
+** cache; changes made directly on the host become visible when the entries
+** expire.
+**
+**==============================================================================
+*/
+
+/* number of direct-mapped cache slots */
+#define CACHE_SIZE 1024
+
+/* largest directory listing kept in the cache */
+#define CACHE_MAX_LISTING (256 * 1024)
+
+typedef struct cache_entry
+{
+    char* path;
+    uint64_t hash;
+    uint64_t generation; /* stale unless equal to cache_t.generation */
+    uint64_t expires;    /* monotonic time in nanoseconds */
+    uid_t host_uid;      /* credentials the host calls were made with */
+    gid_t host_gid;
+    bool have_stat;
+    bool have_lstat;
+    int stat_ret;
+    int lstat_ret;
+    struct stat stat;
+    struct stat lstat;
+    char* link;    /* readlink() result (local path) */
+    void* listing; /* linux_dirent64 records of the whole directory */
+    size_t listing_size;
+} cache_entry_t;
+
+typedef struct cache
+{
+    myst_spinlock_t lock;
+    uint64_t ttl;        /* nanoseconds */
+    uint64_t generation; /* incremented by every flush */
+    cache_entry_t* entries;
+} cache_t;
+
+typedef enum cache_kind
+{
+    CACHE_STAT,
+    CACHE_LSTAT,
+} cache_kind_t;
+
+static uint64_t _cache_now(void)
+{
+    struct timespec ts;
+
+    if (myst_syscall_clock_gettime(CLOCK_MONOTONIC, &ts) != 0)
+        return UINT64_MAX;
+
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+/* sample before a host call; results are dropped if a flush intervenes */
+static uint64_t _cache_generation(cache_t* cache)
+{
+    return __atomic_load_n(&cache->generation, __ATOMIC_ACQUIRE);
+}
+
+static uint64_t _cache_hash(const char* path)
+{
+    uint64_t h = 0xcbf29ce484222325;
+
+    while (*path)
+    {
+        h ^= (uint8_t)*path++;
+        h *= 0x100000001b3;
+    }
+
+    return h;
+}
+
+static void _cache_clear_entry(cache_entry_t* entry)
+{
+    free(entry->path);
+    free(entry->link);
+    free(entry->listing);
+    memset(entry, 0, sizeof(cache_entry_t));
+}
+
+/* find a live entry for this path (called with the cache lock held) */
+static cache_entry_t* _cache_find(
+    cache_t* cache,
+    const char* path,
+    uid_t host_uid,
+    gid_t host_gid)
+{
+    const uint64_t hash = _cache_hash(path);
+    cache_entry_t* entry;
+
+    if (!cache->entries)
+        return NULL;
+
+    entry = &cache->entries[hash % CACHE_SIZE];
+
+    if (!entry->path || entry->hash != hash ||
+        entry->generation != _cache_generation(cache) ||
+        entry->host_uid != host_uid || entry->host_gid != host_gid ||
+        strcmp(entry->path, path) != 0)
+    {
+        return NULL;
+    }
+
+    if (_cache_now() >= entry->expires)
+        return NULL;
+
+    return entry;
+}
+
+/* find or create the entry for this path (called with the lock held) */
+static cache_entry_t* _cache_claim(
+    cache_t* cache,
+    uint64_t generation,
+    const char* path,
+    uid_t host_uid,
+    gid_t host_gid)
+{
+    const uint64_t hash = _cache_hash(path);
+    cache_entry_t* entry;
+
+    /* the host call raced with a change made through this file system */
+    if (generation != _cache_generation(cache))
+        return NULL;
+
+    if (!cache->entries)
+    {
+        if (!(cache->entries = calloc(CACHE_SIZE, sizeof(cache_entry_t))))
+            return NULL;
+    }
+
+    if ((entry = _cache_find(cache, path, host_uid, host_gid)))
+        return entry;
+
+    entry = &cache->entries[hash % CACHE_SIZE];
+    _cache_clear_entry(entry);
+
+    if (!(entry->path = strdup(path)))
+        return NULL;
+
+    entry->hash = hash;
+    entry->generation = generation;
+    entry->expires = _cache_now() + cache->ttl;
+    entry->host_uid = host_uid;
+    entry->host_gid = host_gid;
+
+    return entry;
+}
+
+static bool _cache_get_stat(
+    cache_t* cache,
+    const char* path,
+    cache_kind_t kind,
+    uid_t host_uid,
+    gid_t host_gid,
+    struct stat* statbuf,
+    int* ret)
+{
+    bool found = false;
+    cache_entry_t* entry;
+
+    if (!cache->ttl)
+        return false;
+
+    myst_spin_lock(&cache->lock);
+
+    if ((entry = _cache_find(cache, path, host_uid, host_gid)))
+    {
+        if (kind == CACHE_STAT && entry->have_stat)
+        {
+            *statbuf = entry->stat;
+            *ret = entry->stat_ret;
+            found = true;
+        }
+        else if (kind == CACHE_LSTAT && entry->have_lstat)
+        {
+            *statbuf = entry->lstat;
+            *ret = entry->lstat_ret;
+            found = true;
+        }
+    }
+
+    myst_spin_unlock(&cache->lock);
+
+    return found;
+}
+
+static void _cache_put_stat(
+    cache_t* cache,
+    uint64_t generation,
+    const char* path,
+    cache_kind_t kind,
+    uid_t host_uid,
+    gid_t host_gid,
+    const struct stat* statbuf,
+    long ret)
+{
+    cache_entry_t* entry;
+
+    /* other failures may be transient or depend on the caller */
+    if (!cache->ttl || (ret != 0 && ret != -ENOENT && ret != -ENOTDIR))
+        return;
+
+    myst_spin_lock(&cache->lock);
+
+    entry = _cache_claim(cache, generation, path, host_uid, host_gid);
+
+    if (entry)
+    {
+        if (kind == CACHE_STAT)
+        {
+            entry->have_stat = true;
+            entry->stat_ret = (int)ret;
+            entry->stat = *statbuf;
+        }
+        else
+        {
+            entry->have_lstat = true;
+            entry->lstat_ret = (int)ret;
+            entry->lstat = *statbuf;
+        }
+    }
+
+    myst_spin_unlock(&cache->lock);
+}
+
+static bool _cache_get_link(
+    cache_t* cache,
+    const char* path,
+    uid_t host_uid,
+    gid_t host_gid,
+    char* buf,
+    size_t size)
+{
+    bool found = false;
+    cache_entry_t* entry;
+
+    if (!cache->ttl)
+        return false;
+
+    myst_spin_lock(&cache->lock);
+
+    if ((entry = _cache_find(cache, path, host_uid, host_gid)) && entry->link)
+    {
+        myst_strlcpy(buf, entry->link, size);
+        found = true;
+    }
+
+    myst_spin_unlock(&cache->lock);
+
+    return found;
+}
+
+static void _cache_put_link(
+    cache_t* cache,
+    uint64_t generation,
+    const char* path,
+    uid_t host_uid,
+    gid_t host_gid,
+    const char* link)
+{
+    cache_entry_t* entry;
+
+    if (!cache->ttl)
+        return;
+
+    myst_spin_lock(&cache->lock);
+
+    entry = _cache_claim(cache, generation, path, host_uid, host_gid);
+
+    if (entry && !entry->link)
+        entry->link = strdup(link);
+
+    myst_spin_unlock(&cache->lock);
+}
+
+/* copy a cached listing into a newly allocated buffer */
+static void* _cache_get_listing(
+    cache_t* cache,
+    const char* path,
+    uid_t host_uid,
+    gid_t host_gid,
+    size_t* size)
+{
+    void* listing = NULL;
+    cache_entry_t* entry;
+
+    if (!cache->ttl)
+        return NULL;
+
+    myst_spin_lock(&cache->lock);
+
+    if ((entry = _cache_find(cache, path, host_uid, host_gid)) &&
+        entry->listing)
+    {
+        if ((listing = malloc(entry->listing_size)))
+        {
+            memcpy(listing, entry->listing, entry->listing_size);
+            *size = entry->listing_size;
+        }
+    }
+
+    myst_spin_unlock(&cache->lock);
+
+    return listing;
+}
+
+static void _cache_put_listing(
+    cache_t* cache,
+    uint64_t generation,
+    const char* path,
+    uid_t host_uid,
+    gid_t host_gid,
+    const void* listing,
+    size_t size)
+{
+    cache_entry_t* entry;
+    void* copy;
+
+    if (!cache->ttl || size == 0 || size > CACHE_MAX_LISTING)
+        return;
+
+    if (!(copy = malloc(size)))
+        return;
+
+    memcpy(copy, listing, size);
+
+    myst_spin_lock(&cache->lock);
+
+    entry = _cache_claim(cache, generation, path, host_uid, host_gid);
+
+    if (entry && !entry->listing)
+    {
+        entry->listing = copy;
+        entry->listing_size = size;
+        copy = NULL;
+    }
+
+    myst_spin_unlock(&cache->lock);
+
+    free(copy);
+}
+
+/* invalidate every entry (stale entries are released when reclaimed) */
+static void _cache_flush(cache_t* cache)
+{
+    __atomic_fetch_add(&cache->generation, 1, __ATOMIC_RELEASE);
+}
+
+static void _cache_free(cache_t* cache)
+{
+    if (cache->entries)
+    {
+        for (size_t i = 0; i < CACHE_SIZE; i++)
+            _cache_clear_entry(&cache->entries[i]);
+
+        free(cache->entries);
+        cache->entries = NULL;
+    }
+}
+
 /*
 **==============================================================================
 **
@@ -41,6 +416,7 @@ typedef struct hostfs
     uint64_t magic;
     char source[PATH_MAX]; /* source argument to myst_mount() */
     char target[PATH_MAX]; /* target argument to myst_mount() */
+    cache_t cache;
 } hostfs_t;
 
 static int _get_host_uid_gid(uid_t* host_uid, gid_t* host_gid)
@@ -106,11 +482,28 @@ static int _to_local_path(
 
 #define FILE_MAGIC 0xb02950b846ff4d31
 
+/* directory records are fetched from the host this many bytes at a time */
+#define DIR_CHUNK_SIZE (64 * 1024)
+
+/* buffered directory records (see _fs_getdents64()) */
+typedef struct hostfs_dir
+{
+    uint8_t* data;       /* linux_dirent64 records */
+    size_t size;         /* bytes of records in data */
+    size_t capacity;     /* bytes allocated for data */
+    size_t offset;       /* offset of the next record to return */
+    off_t pos;           /* d_off of the last record returned (or start) */
+    bool eof;            /* the host reported the end of the directory */
+    bool whole;          /* data holds every record from the first one */
+    uint64_t generation; /* cache generation before the first chunk */
+} hostfs_dir_t;
+
 struct myst_file
 {
     uint64_t magic;
     char realpath[PATH_MAX];
     int fd;
+    hostfs_dir_t* dir;
 };
 
 static bool _file_valid(const myst_file_t* file)
@@ -118,6 +511,16 @@ static bool _file_valid(const myst_file_t* file)
     return file && file->magic == FILE_MAGIC;
 }
 
+static void _free_dir(myst_file_t* file)
+{
+    if (file->dir)
+    {
+        free(file->dir->data);
+        free(file->dir);
+        file->dir = NULL;
+    }
+}
+
 /*
 **==============================================================================
 **
@@ -134,6 +537,7 @@ static int _fs_release(myst_fs_t* fs)
     if (!_hostfs_valid(hostfs))
         ERAISE(-EINVAL);
 
+    _cache_free(&hostfs->cache);
     memset(hostfs, 0xdd, sizeof(hostfs_t));
     free(hostfs);
 
@@ -155,6 +559,9 @@ static int _fs_mount(myst_fs_t* fs, const char* source, const char* target)
     if (myst_strlcpy(hostfs->source, source, PATH_MAX) >= PATH_MAX)
         ERAISE(-ENAMETOOLONG);
 
+    /* paths looked up before the mount were relative to the host root */
+    _cache_flush(&hostfs->cache);
+
 done:
     return ret;
 }
@@ -192,6 +599,9 @@ static int _fs_open(
     long params[6] = {(long)path, flags, mode, host_uid, host_gid};
     ECHECK((tret = myst_tcall(SYS_open, params)));
 
+    if (flags & (O_CREAT | O_TRUNC))
+        _cache_flush(&hostfs->cache);
+
     if (tret > MYST_FDTABLE_SIZE)
         ERAISE(-EINVAL);
 
@@ -235,6 +645,28 @@ static off_t _fs_lseek(
     if (!_hostfs_valid(hostfs) || !_file_valid(file))
         ERAISE(-EINVAL);
 
+    if (file->dir)
+    {
+        const off_t pos = file->dir->pos;
+
+        if (whence == SEEK_CUR && offset == 0)
+        {
+            ret = pos;
+            goto done;
+        }
+
+        _free_dir(file);
+
+        /* the host offset is ahead of the records returned so far (or still
+         * at the start for a cached listing): move it back to the position
+         * of the stream before seeking relative to it */
+        if (whence == SEEK_CUR)
+        {
+            long params[6] = {file->fd, pos, SEEK_SET};
+            ECHECK(myst_tcall(SYS_lseek, params));
+        }
+    }
+
     long params[6] = {file->fd, offset, whence};
     ECHECK((tret = myst_tcall(SYS_lseek, params)));
 
@@ -288,6 +720,9 @@ static ssize_t _fs_write(
     long params[6] = {file->fd, (long)buf, count};
     ECHECK((tret = myst_tcall(SYS_write, params)));
 
+    if (tret > 0)
+        _cache_flush(&hostfs->cache);
+
     ret = tret;
 
 done:
@@ -340,6 +775,9 @@ static ssize_t _fs_pwrite(
     long params[6] = {file->fd, (long)buf, count, offset};
     ECHECK((tret = myst_tcall(SYS_pwrite64, params)));
 
+    if (tret > 0)
+        _cache_flush(&hostfs->cache);
+
     ret = tret;
 
 done:
@@ -355,11 +793,10 @@ static ssize_t _fs_readv(
     hostfs_t* hostfs = (hostfs_t*)fs;
     ssize_t ret = 0;
 
-    if (!_hostfs_valid(hostfs) || !file)
+    if (!_hostfs_valid(hostfs) || !_file_valid(file))
         ERAISE(-EINVAL);
 
-    ret = myst_fdops_readv(&fs->fdops, file, iov, iovcnt);
-    ECHECK(ret);
+    ECHECK(ret = myst_tcall_readv(file->fd, iov, iovcnt));
 
 done:
     return ret;
@@ -374,11 +811,13 @@ static ssize_t _fs_writev(
     hostfs_t* hostfs = (hostfs_t*)fs;
     ssize_t ret = 0;
 
-    if (!_hostfs_valid(hostfs) || !file)
+    if (!_hostfs_valid(hostfs) || !_file_valid(file))
         ERAISE(-EINVAL);
 
-    ret = myst_fdops_writev(&fs->fdops, file, iov, iovcnt);
-    ECHECK(ret);
+    ECHECK(ret = myst_tcall_writev(file->fd, iov, iovcnt));
+
+    if (ret > 0)
+        _cache_flush(&hostfs->cache);
 
 done:
     return ret;
@@ -399,6 +838,7 @@ static int _fs_close(myst_fs_t* fs, myst_file_t* file)
     if (tret != 0)
         ERAISE(-EINVAL);
 
+    _free_dir(file);
     memset(file, 0xdd, sizeof(myst_file_t));
     free(file);
 
@@ -418,6 +858,30 @@ static int _fs_access(myst_fs_t* fs, const char* pathname, int mode)
     if (!_hostfs_valid(hostfs) || !pathname)
         ERAISE(-EINVAL);
 
+    /* existence checks can be answered by a cached stat() result */
+    if (mode == F_OK && hostfs->cache.ttl)
+    {
+        struct stat buf;
+        int r;
+        uid_t host_uid;
+        gid_t host_gid;
+
+        ECHECK(_get_host_uid_gid(&host_uid, &host_gid));
+
+        if (_cache_get_stat(
+                &hostfs->cache,
+                pathname,
+                CACHE_STAT,
+                host_uid,
+                host_gid,
+                &buf,
+                &r))
+        {
+            ECHECK(r);
+            goto done;
+        }
+    }
+
     ECHECK(_to_host_path(hostfs, path, sizeof(path), pathname));
 
     long params[6] = {(long)path, mode};
@@ -453,6 +917,7 @@ static int _fs_stat(myst_fs_t* fs, const char* pathname, struct stat* statbuf)
     char path[PATH_MAX];
     uid_t host_uid;
     gid_t host_gid;
+    uint64_t generation;
 
     myst_assume(hostfs->magic == HOSTFS_MAGIC);
 
@@ -464,19 +929,46 @@ static int _fs_stat(myst_fs_t* fs, const char* pathname, struct stat* statbuf)
     if (!_hostfs_valid(hostfs) || !pathname || !statbuf)
         ERAISE(-EINVAL);
 
+    if (_cache_get_stat(
+            &hostfs->cache,
+            pathname,
+            CACHE_STAT,
+            host_uid,
+            host_gid,
+            statbuf,
+            &ret))
+    {
+        goto done;
+    }
+
     ECHECK(_to_host_path(hostfs, path, sizeof(path), pathname));
 
+    generation = _cache_generation(&hostfs->cache);
+
     long params[6] = {
         (long)path, (long)statbuf, (long)host_uid, (long)host_gid};
-    ECHECK((tret = myst_tcall(SYS_stat, params)));
+    tret = myst_tcall(SYS_stat, params);
+
+    if (tret == 0)
+        ECHECK(_map_stat_to_enc_ids(statbuf));
+
+    _cache_put_stat(
+        &hostfs->cache,
+        generation,
+        pathname,
+        CACHE_STAT,
+        host_uid,
+        host_gid,
+        statbuf,
+        tret);
+
+    ECHECK(tret);
 
     if (tret != 0)
         ERAISE(-EINVAL);
 
     ret = tret;
 
-    ECHECK(_map_stat_to_enc_ids(statbuf));
-
 done:
     return ret;
 }
@@ -489,25 +981,53 @@ static int _fs_lstat(myst_fs_t* fs, const char* pathname, struct stat* statbuf)
     char path[PATH_MAX];
     uid_t host_uid;
     gid_t host_gid;
+    uint64_t generation;
 
     if (!_hostfs_valid(hostfs) || !pathname || !statbuf)
         ERAISE(-EINVAL);
 
     ECHECK(_get_host_uid_gid(&host_uid, &host_gid));
 
+    if (_cache_get_stat(
+            &hostfs->cache,
+            pathname,
+            CACHE_LSTAT,
+            host_uid,
+            host_gid,
+            statbuf,
+            &ret))
+    {
+        goto done;
+    }
+
     ECHECK(_to_host_path(hostfs, path, sizeof(path), pathname));
 
+    generation = _cache_generation(&hostfs->cache);
+
     long params[6] = {
         (long)path, (long)statbuf, (long)host_uid, (long)host_gid};
-    ECHECK((tret = myst_tcall(SYS_lstat, params)));
+    tret = myst_tcall(SYS_lstat, params);
+
+    if (tret == 0)
+        ECHECK(_map_stat_to_enc_ids(statbuf));
+
+    _cache_put_stat(
+        &hostfs->cache,
+        generation,
+        pathname,
+        CACHE_LSTAT,
+        host_uid,
+        host_gid,
+        statbuf,
+        tret);
+
+    ECHECK(tret);
 
     if (tret != 0)
         ERAISE(-EINVAL);
 
     ret = tret;
 
-    ECHECK(_map_stat_to_enc_ids(statbuf));
-
 done:
     return ret;
 }
@@ -551,6 +1071,7 @@ static int _fs_link(myst_fs_t* fs, const char* oldpath, const char* newpath)
 
     long params[6] = {(long)opath, (long)npath};
     ECHECK((tret = myst_tcall(SYS_link, params)));
+    _cache_flush(&hostfs->cache);
 
     if (tret != 0)
         ERAISE(-EINVAL);
@@ -575,6 +1096,7 @@ static int _fs_unlink(myst_fs_t* fs, const char* pathname)
 
     long params[6] = {(long)path};
     ECHECK((tret = myst_tcall(SYS_unlink, params)));
+    _cache_flush(&hostfs->cache);
 
     if (tret != 0)
         ERAISE(-EINVAL);
@@ -601,6 +1123,7 @@ static int _fs_rename(myst_fs_t* fs, const char* oldpath, const char* newpath)
 
     long params[6] = {(long)opath, (long)npath};
     ECHECK((tret = myst_tcall(SYS_rename, params)));
+    _cache_flush(&hostfs->cache);
 
     if (tret != 0)
         ERAISE(-EINVAL);
@@ -625,6 +1148,7 @@ static int _fs_truncate(myst_fs_t* fs, const char* path, off_t length)
 
     long params[6] = {(long)hpath, length};
     ECHECK((tret = myst_tcall(SYS_truncate, params)));
+    _cache_flush(&hostfs->cache);
 
     if (tret != 0)
         ERAISE(-EINVAL);
@@ -646,6 +1170,7 @@ static int _fs_ftruncate(myst_fs_t* fs, myst_file_t* file, off_t length)
 
     long params[6] = {file->fd, length};
     ECHECK((tret = myst_tcall(SYS_ftruncate, params)));
+    _cache_flush(&hostfs->cache);
 
     if (tret != 0)
         ERAISE(-EINVAL);
@@ -674,6 +1199,7 @@ static int _fs_mkdir(myst_fs_t* fs, const char* pathname, mode_t mode)
 
     long params[6] = {(long)path, (long)mode, (long)host_uid, (long)host_gid};
     ECHECK((tret = myst_tcall(SYS_mkdir, params)));
+    _cache_flush(&hostfs->cache);
 
     if (tret != 0)
         ERAISE(-EINVAL);
@@ -702,6 +1228,7 @@ static int _fs_rmdir(myst_fs_t* fs, const char* pathname)
 
     long params[6] = {(long)path, (long)host_uid, (long)host_gid};
     ECHECK((tret = myst_tcall(SYS_rmdir, params)));
+    _cache_flush(&hostfs->cache);
 
     if (tret != 0)
         ERAISE(-EINVAL);
@@ -712,6 +1239,69 @@ done:
     return ret;
 }
 
+/* fetch the next chunk of directory records from the host */
+static int _fill_dir(hostfs_t* hostfs, myst_file_t* file)
+{
+    int ret = 0;
+    hostfs_dir_t* dir = file->dir;
+    size_t start = 0;
+    uid_t host_uid;
+    gid_t host_gid;
+    long tret;
+
+    /* keep accumulating a whole listing while it may still be cached */
+    if (dir->whole && dir->size + DIR_CHUNK_SIZE <= CACHE_MAX_LISTING)
+        start = dir->size;
+    else
+        dir->whole = false;
+
+    if (start + DIR_CHUNK_SIZE > dir->capacity)
+    {
+        size_t capacity = start + DIR_CHUNK_SIZE;
+        uint8_t* data;
+
+        if (!(data = realloc(dir->data, capacity)))
+            ERAISE(-ENOMEM);
+
+        dir->data = data;
+        dir->capacity = capacity;
+    }
+
+    /* a listing is only as fresh as its first chunk */
+    if (start == 0)
+        dir->generation = _cache_generation(&hostfs->cache);
+
+    long params[6] = {file->fd, (long)(dir->data + start), DIR_CHUNK_SIZE};
+    ECHECK((tret = myst_tcall(SYS_getdents64, params)));
+
+    if (tret > DIR_CHUNK_SIZE)
+        ERAISE(-EIO);
+
+    dir->size = start + (size_t)tret;
+    dir->offset = start;
+
+    if (tret == 0)
+    {
+        dir->eof = true;
+
+        if (dir->whole)
+        {
+            ECHECK(_get_host_uid_gid(&host_uid, &host_gid));
+            _cache_put_listing(
+                &hostfs->cache,
+                dir->generation,
+                file->realpath,
+                host_uid,
+                host_gid,
+                dir->data,
+                dir->size);
+        }
+    }
+
+done:
+    return ret;
+}
+
 static int _fs_getdents64(
     myst_fs_t* fs,
     myst_file_t* file,
@@ -720,7 +1310,8 @@ static int _fs_getdents64(
 {
     int ret = 0;
     hostfs_t* hostfs = (hostfs_t*)fs;
-    long tret;
+    hostfs_dir_t* dir;
+    size_t n = 0;
 
     if (!_hostfs_valid(hostfs) || !_file_valid(file) || !dirp)
         ERAISE(-EINVAL);
@@ -728,12 +1319,85 @@ static int _fs_getdents64(
     if (count == 0)
         goto done;
 
-    /* ATTN: check sizes of respective dirent structures */
+    /* start a new stream (from the cached listing if there is one) */
+    if (!(dir = file->dir))
+    {
+        uid_t host_uid;
+        gid_t host_gid;
+        off_t tret;
 
-    long params[6] = {file->fd, (long)dirp, count};
-    ECHECK((tret = myst_tcall(SYS_getdents64, params)));
+        if (!(dir = calloc(1, sizeof(hostfs_dir_t))))
+            ERAISE(-ENOMEM);
 
-    ret = tret;
+        file->dir = dir;
+
+        /* where the stream starts (see _fs_lseek()); only a stream that
+         * starts at the beginning can use the cache */
+        {
+            long params[6] = {file->fd, 0, SEEK_CUR};
+            ECHECK((tret = myst_tcall(SYS_lseek, params)));
+            dir->pos = tret;
+            dir->whole = (hostfs->cache.ttl && tret == 0);
+        }
+
+        if (dir->whole)
+        {
+            ECHECK(_get_host_uid_gid(&host_uid, &host_gid));
+
+            if ((dir->data = _cache_get_listing(
+                     &hostfs->cache,
+                     file->realpath,
+                     host_uid,
+                     host_gid,
+                     &dir->size)))
+            {
+                dir->capacity = dir->size;
+                dir->eof = true;
+                dir->whole = false;
+            }
+        }
+    }
+
+    /* hand out whole records while they fit */
+    while (n < count)
+    {
+        struct dirent* ent;
+
+        if (dir->offset == dir->size)
+        {
+            if (dir->eof || n > 0)
+                break;
+
+            ECHECK(_fill_dir(hostfs, file));
+            continue;
+        }
+
+        ent = (struct dirent*)(dir->data + dir->offset);
+
+        /* the records come from the host: never trust their lengths */
+        if (dir->size - dir->offset < offsetof(struct dirent, d_name) + 1 ||
+            ent->d_reclen < offsetof(struct dirent, d_name) + 1 ||
+            ent->d_reclen > dir->size - dir->offset)
+        {
+            ERAISE(-EIO);
+        }
+
+        if (ent->d_reclen > count - n)
+        {
+            /* the buffer cannot hold even one record */
+            if (n == 0)
+                ERAISE(-EINVAL);
+
+            break;
+        }
+
+        memcpy((uint8_t*)dirp + n, ent, ent->d_reclen);
+        n += ent->d_reclen;
+        dir->offset += ent->d_reclen;
+        dir->pos = ent->d_off;
+    }
+
+    ret = (int)n;
 
 done:
     return ret;
@@ -750,21 +1414,38 @@ static ssize_t _fs_readlink(
     long tret;
     char path[PATH_MAX];
     char target[PATH_MAX];
+    uid_t host_uid;
+    gid_t host_gid;
+    uint64_t generation;
 
     if (!_hostfs_valid(hostfs) || !pathname || !buf || !bufsiz)
         ERAISE(-EINVAL);
 
-    ECHECK(_to_host_path(hostfs, path, PATH_MAX, pathname));
+    ECHECK(_get_host_uid_gid(&host_uid, &host_gid));
+
+    /* path receives the local form of the link target */
+    if (!_cache_get_link(
+            &hostfs->cache, pathname, host_uid, host_gid, path, PATH_MAX))
+    {
+        ECHECK(_to_host_path(hostfs, path, PATH_MAX, pathname));
 
-    long params[6] = {(long)path, (long)target, PATH_MAX};
-    ECHECK((tret = myst_tcall(SYS_readlink, params)));
+        generation = _cache_generation(&hostfs->cache);
 
-    if (tret < PATH_MAX)
-        target[tret] = '\0';
-    else
-        target[PATH_MAX - 1] = '\0';
+        long params[6] = {(long)path, (long)target, PATH_MAX};
+        ECHECK((tret = myst_tcall(SYS_readlink, params)));
+
+        if (tret < PATH_MAX)
+            target[tret] = '\0';
+        else
+            target[PATH_MAX - 1] = '\0';
+
+        ECHECK(_to_local_path(hostfs, path, PATH_MAX, target));
 
-    ECHECK(_to_local_path(hostfs, buf, bufsiz, target));
+        _cache_put_link(
+            &hostfs->cache, generation, pathname, host_uid, host_gid, path);
+    }
+
+    myst_strlcpy(buf, path, bufsiz);
     tret = strlen(buf);
 
     ret = tret;
@@ -801,6 +1482,7 @@ static int _fs_symlink(myst_fs_t* fs, const char* target, const char* linkpath)
     long params[6] = {
         (long)host_target, (long)host_linkpath, (long)host_uid, (long)host_gid};
     ECHECK((tret = myst_tcall(SYS_symlink, params)));
+    _cache_flush(&hostfs->cache);
 
     ret = tret;
 
@@ -905,6 +1587,7 @@ static int _fs_dup(
         ERAISE(-ENOMEM);
 
     *new_file = *file;
+    new_file->dir = NULL;
 
     long params[6] = {file->fd};
     ECHECK((tret = myst_tcall(SYS_dup, params)));
@@ -1019,6 +1702,7 @@ static int _fs_futimens(
     long params[6] = {
         (long)file->fd, (long)NULL, (long)times, 0, host_uid, host_gid};
     ECHECK((tret = myst_tcall(SYS_utimensat, params)));
+    _cache_flush(&hostfs->cache);
     ret = tret;
 
 done:
@@ -1061,6 +1745,7 @@ static int _fs_chown(
                       (long)host_uid,
                       (long)host_gid};
     ECHECK((tret = myst_tcall(SYS_chown, params)));
+    _cache_flush(&hostfs->cache);
 
 done:
     return ret;
@@ -1097,6 +1782,7 @@ static int _fs_fchown(
                       (long)host_uid,
                       (long)host_gid};
     ECHECK((tret = myst_tcall(SYS_fchown, params)));
+    _cache_flush(&hostfs->cache);
 
 done:
     return ret;
@@ -1138,6 +1824,7 @@ static int _fs_lchown(
                       (long)host_uid,
                       (long)host_gid};
     ECHECK((tret = myst_tcall(SYS_lchown, params)));
+    _cache_flush(&hostfs->cache);
 
 done:
     return ret;
@@ -1163,6 +1850,7 @@ static int _fs_chmod(myst_fs_t* fs, const char* pathname, mode_t mode)
 
     long params[6] = {(long)path, (long)mode, (long)host_uid, (long)host_gid};
     ECHECK((tret = myst_tcall(SYS_chmod, params)));
+    _cache_flush(&hostfs->cache);
 
 done:
     return ret;
@@ -1183,6 +1871,7 @@ static int _fs_fchmod(myst_fs_t* fs, myst_file_t* file, mode_t mode)
 
     long params[6] = {file->fd, (long)mode, (long)host_uid, (long)host_gid};
     ECHECK((tret = myst_tcall(SYS_fchmod, params)));
+    _cache_flush(&hostfs->cache);
 
 done:
     return ret;
@@ -1313,6 +2002,7 @@ int myst_init_hostfs(myst_fs_t** fs_out)
 
     hostfs->magic = HOSTFS_MAGIC;
     hostfs->base = _base;
+    hostfs->cache.ttl = __myst_kernel_args.hostfs_cache_ttl * 1000000;
     myst_strlcpy(hostfs->target, "/", sizeof(hostfs->target));
 
     *fs_out = &hostfs->base;
@@ -1331,4 +2021,12 @@ bool myst_is_hostfs(const myst_fs_t* fs)
     return _hostfs_valid((hostfs_t*)fs);
 }
 
+void myst_hostfs_invalidate(myst_fs_t* fs)
+{
+    hostfs_t* hostfs = (hostfs_t*)fs;
+
+    if (_hostfs_valid(hostfs))
+        _cache_flush(&hostfs->cache);
+}
+
 #endif /* MYST_ENABLE_HOSTFS */
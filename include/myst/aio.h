@@ -0,0 +1,72 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#ifndef _MYST_AIO_H
+#define _MYST_AIO_H
+
+#include <stdint.h>
+#include <time.h>
+
+/*
+**==============================================================================
+**
+** Linux native asynchronous I/O (io_setup, io_submit, io_getevents, ...).
+**
+** The definitions below follow <linux/aio_abi.h>, which is not available to
+** the kernel. Submitted requests are queued per process and executed by a
+** pool of MYST_AIO_NUM_WORKERS worker threads. Like the itimer thread, the
+** workers are created by the C runtime (on the first io_setup() call) and
+** then enter the kernel for good with SYS_myst_run_aio.
+**
+**==============================================================================
+*/
+
+#define MYST_AIO_NUM_WORKERS 4
+
+typedef unsigned long aio_context_t;
+
+enum
+{
+    IOCB_CMD_PREAD = 0,
+    IOCB_CMD_PWRITE = 1,
+    IOCB_CMD_FSYNC = 2,
+    IOCB_CMD_FDSYNC = 3,
+    IOCB_CMD_POLL = 5,
+    IOCB_CMD_NOOP = 6,
+    IOCB_CMD_PREADV = 7,
+    IOCB_CMD_PWRITEV = 8,
+};
+
+/* aio_flags: notify the eventfd given by aio_resfd on completion */
+#define IOCB_FLAG_RESFD (1 << 0)
+
+struct io_event
+{
+    uint64_t data; /* the aio_data field of the iocb */
+    uint64_t obj;  /* the address of the iocb */
+    int64_t res;   /* result (bytes transferred or -errno) */
+    int64_t res2;  /* secondary result */
+};
+
+struct iocb
+{
+    uint64_t aio_data;
+    uint32_t aio_key;
+    int32_t aio_rw_flags;
+    uint16_t aio_lio_opcode;
+    int16_t aio_reqprio;
+    uint32_t aio_fildes;
+    uint64_t aio_buf;
+    uint64_t aio_nbytes;
+    int64_t aio_offset;
+    uint64_t aio_reserved2;
+    uint32_t aio_flags;
+    uint32_t aio_resfd;
+};
+
+typedef struct myst_process myst_process_t;
+
+/* release the process's AIO state (after its threads have exited) */
+void myst_aio_free(myst_process_t* process);
+
+#endif /* _MYST_AIO_H */
@@ -14,8 +14,17 @@ struct clock_ctrl
     volatile long now;
     unsigned long interval;
     volatile int done;
+
+    /* odd while the host is updating now and tsc (seqlock) */
+    volatile unsigned long seq;
+
+    /* the host TSC when now was last updated */
+    volatile unsigned long tsc;
 };
 
 int myst_setup_clock(struct clock_ctrl*);
 
+/* called when the RDTSC instruction is emulated (too slow to interpolate) */
+void myst_clock_disable_tsc(void);
+
 #endif /* _MYST_CLOCK_H */
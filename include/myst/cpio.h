@@ -86,6 +86,36 @@ int myst_cpio_pack(const char* source, const char* target);
 
 int myst_cpio_unpack(const char* source, const char* target);
 
+/* get the file descriptor of the archive (for writers that do their own I/O) */
+int myst_cpio_get_fd(myst_cpio_t* cpio);
+
+/* Format the header and the name of an entry (padded to a four-byte boundary)
+ * into the given buffer exactly as myst_cpio_write_entry() writes them.
+ * Returns the number of bytes, 0 if the entry is not archived (character
+ * devices and fifos), or -1 on error. The buffer never needs more than
+ * MYST_CPIO_ENTRY_HEADER_MAX bytes.
+ */
+ssize_t myst_cpio_format_entry(
+    const myst_cpio_entry_t* entry,
+    void* buf,
+    size_t size);
+
+#define MYST_CPIO_ENTRY_HEADER_MAX (112 + MYST_CPIO_PATH_MAX)
+
+/* Multithreaded versions of myst_cpio_pack() and myst_cpio_unpack() (host
+ * only). The archive is byte-identical to the one myst_cpio_pack() creates.
+ * If num_threads is zero, one thread per CPU is used.
+ */
+int myst_cpio_pack_parallel(
+    const char* source,
+    const char* target,
+    size_t num_threads);
+
+int myst_cpio_unpack_parallel(
+    const char* source,
+    const char* target,
+    size_t num_threads);
+
 int myst_cpio_next_entry(
     const void* data,
     size_t size,
@@ -0,0 +1,104 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#ifndef _MYST_CPIOINDEX_H
+#define _MYST_CPIOINDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <myst/buf.h>
+#include <myst/defs.h>
+
+/*
+**==============================================================================
+**
+** CPIO archive index:
+**
+** An index of a CPIO archive that lets the kernel mount the archive directly
+** instead of unpacking it entry by entry. The index is appended to the
+** archive (after the trailer, where CPIO readers ignore it) at an 8-byte
+** aligned offset and is laid out as follows:
+**
+**     [header][inodes][strings][footer]
+**
+** Inode 0 is the root directory. The children of every directory are stored
+** in consecutive inodes, sorted by name, and always after the directory
+** itself. Names are NUL-terminated base names held in the string table. The
+** data of regular files and the targets of symbolic links are referenced by
+** their offsets within the archive, so they are never copied.
+**
+** The footer is the last thing in the image and gives the offset of the
+** header, so the index can be found without scanning the archive.
+**
+**==============================================================================
+*/
+
+#define MYST_CPIO_INDEX_MAGIC 0x5844494f4950434d /* "MCPIOIDX" */
+#define MYST_CPIO_INDEX_VERSION 1
+
+typedef struct myst_cpio_index_header
+{
+    uint64_t magic;
+    uint32_t version;
+    uint32_t num_inodes;
+    uint64_t archive_size; /* size of the CPIO archive preceding the index */
+    uint64_t strings_size; /* size of the string table */
+} myst_cpio_index_header_t;
+
+typedef struct myst_cpio_index_inode
+{
+    uint32_t mode;         /* type and permissions */
+    uint32_t name;         /* offset of the base name in the string table */
+    uint32_t first_child;  /* directories: index of the first child */
+    uint32_t num_children; /* directories: number of children */
+    uint32_t num_subdirs;  /* directories: number of child directories */
+    uint32_t reserved;
+    uint64_t offset; /* offset of the file data or link target in archive */
+    uint64_t size;   /* size of the file data or link target */
+} myst_cpio_index_inode_t;
+
+typedef struct myst_cpio_index_footer
+{
+    uint64_t offset; /* offset of the header within the image */
+    uint64_t magic;
+} myst_cpio_index_footer_t;
+
+/* a validated index (points into the image) */
+typedef struct myst_cpio_index
+{
+    const uint8_t* archive;
+    size_t archive_size;
+    const myst_cpio_index_inode_t* inodes;
+    size_t num_inodes;
+    const char* strings;
+    size_t strings_size;
+} myst_cpio_index_t;
+
+/* Build the index of the given CPIO archive. The output (including any
+ * alignment padding and the footer) is meant to be appended to the archive.
+ */
+int myst_cpio_index_build(
+    const void* cpio_data,
+    size_t cpio_size,
+    myst_buf_t* index_out);
+
+/* append an index to the CPIO archive file at the given path */
+int myst_cpio_index_append(const char* path);
+
+/* Find and validate the index at the end of the image. Returns -ENOENT if
+ * the image has no index and -EINVAL if the index is malformed.
+ */
+int myst_cpio_index_find(
+    const void* image,
+    size_t image_size,
+    myst_cpio_index_t* index);
+
+MYST_INLINE const char* myst_cpio_index_name(
+    const myst_cpio_index_t* index,
+    const myst_cpio_index_inode_t* inode)
+{
+    return index->strings + inode->name;
+}
+
+#endif /* _MYST_CPIOINDEX_H */
@@ -0,0 +1,25 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#ifndef _MYST_CPUID_H
+#define _MYST_CPUID_H
+
+#include <stdint.h>
+
+#include <myst/defs.h>
+
+/* execute CPUID for the given leaf and subleaf */
+MYST_INLINE void myst_cpuid(
+    uint32_t leaf,
+    uint32_t subleaf,
+    uint32_t* eax,
+    uint32_t* ebx,
+    uint32_t* ecx,
+    uint32_t* edx)
+{
+    __asm__ volatile("cpuid"
+                     : "=a"(*eax), "=b"(*ebx), "=c"(*ecx), "=d"(*edx)
+                     : "a"(leaf), "c"(subleaf));
+}
+
+#endif /* _MYST_CPUID_H */
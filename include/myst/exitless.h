@@ -0,0 +1,146 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#ifndef _MYST_EXITLESS_H
+#define _MYST_EXITLESS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <myst/defs.h>
+
+/*
+**==============================================================================
+**
+** Exitless tcall transport:
+**
+** A request queue that lives in host memory and is polled by dedicated host
+** worker threads. A caller claims a free slot, fills in the tcall number and
+** parameters, and spins until a worker has executed the call. If no worker
+** is awake, or no worker picks the request up within the spin budget, the
+** caller reclaims the slot and falls back to a regular tcall (an OCALL in
+** the SGX target). A request that a worker already runs cannot be taken
+** back; if it outlasts the spin budget, the caller yields its CPU through a
+** regular tcall between polls instead of spinning.
+**
+** Only tcalls that never block indefinitely on the host are eligible. They
+** are grouped into classes that can be enabled independently.
+**
+**==============================================================================
+*/
+
+/* tcall classes that may be routed through the exitless queue */
+#define MYST_EXITLESS_SOCKETS 0x1
+#define MYST_EXITLESS_FILES 0x2
+#define MYST_EXITLESS_CLOCK 0x4
+#define MYST_EXITLESS_ALL \
+    (MYST_EXITLESS_SOCKETS | MYST_EXITLESS_FILES | MYST_EXITLESS_CLOCK)
+
+#define MYST_EXITLESS_NUM_SLOTS 64
+
+/* per-slot staging area for targets that do not share an address space */
+#define MYST_EXITLESS_DATA_SIZE 8192
+
+#define MYST_EXITLESS_DEFAULT_WORKERS 2
+#define MYST_EXITLESS_MAX_WORKERS 16
+
+/* polls before a posted request is reclaimed by the caller */
+#define MYST_EXITLESS_DEFAULT_SPIN_COUNT 4096
+
+typedef enum myst_exitless_slot_state
+{
+    MYST_EXITLESS_SLOT_FREE = 0, /* available to callers */
+    MYST_EXITLESS_SLOT_CLAIMED,  /* owned by a caller (being filled in) */
+    MYST_EXITLESS_SLOT_POSTED,   /* waiting for a worker */
+    MYST_EXITLESS_SLOT_BUSY,     /* being executed by a worker */
+    MYST_EXITLESS_SLOT_DONE,     /* result is available to the caller */
+} myst_exitless_slot_state_t;
+
+typedef struct myst_exitless_slot
+{
+    volatile uint32_t state;
+    uint32_t padding;
+    long n;
+    long params[6];
+    long ret;
+    uint8_t data[MYST_EXITLESS_DATA_SIZE];
+} myst_exitless_slot_t;
+
+typedef struct myst_exitless
+{
+    /* bitmask of MYST_EXITLESS_* classes enabled by the host */
+    uint32_t classes;
+
+    uint32_t num_workers;
+    uint64_t spin_count;
+
+    /* number of workers currently polling the slots */
+    volatile uint32_t num_awake;
+
+    /* futex word that parked workers wait on */
+    volatile uint32_t wake_seq;
+
+    volatile uint32_t stop;
+
+    /* number of calls that fell back to a regular tcall */
+    volatile uint64_t num_fallbacks;
+
+    myst_exitless_slot_t slots[MYST_EXITLESS_NUM_SLOTS];
+} myst_exitless_t;
+
+/* return the MYST_EXITLESS_* classes the given tcall belongs to (or zero) */
+uint32_t myst_exitless_class(long n);
+
+/* parse a comma-separated list such as "sockets,files,clock" (or "all") */
+int myst_exitless_parse_classes(const char* str, uint32_t* classes);
+
+/* claim a free slot; returns NULL if the caller should use a regular tcall */
+myst_exitless_slot_t* myst_exitless_acquire(myst_exitless_t* queue);
+
+/* yields the CPU through a regular tcall while a long request runs */
+typedef void (*myst_exitless_yield_t)(void);
+
+/* post the request in the claimed slot and wait for the result; returns
+ * -EAGAIN if no worker picked up the request (slot stays claimed). Once a
+ * worker runs the request, the caller polls for the result spin_count times
+ * and then calls yield() between polls */
+int myst_exitless_post(
+    myst_exitless_t* queue,
+    myst_exitless_slot_t* slot,
+    long n,
+    const long params[6],
+    long* ret,
+    myst_exitless_yield_t yield);
+
+/* return a claimed slot to the queue */
+void myst_exitless_release(myst_exitless_slot_t* slot);
+
+/* acquire, post and release (for targets that share the address space) */
+int myst_exitless_call(
+    myst_exitless_t* queue,
+    long n,
+    const long params[6],
+    long* ret,
+    myst_exitless_yield_t yield);
+
+/*
+**==============================================================================
+**
+** host-side interface:
+**
+**==============================================================================
+*/
+
+typedef long (*myst_exitless_handler_t)(long n, long params[6]);
+
+myst_exitless_t* myst_exitless_create(
+    uint32_t classes,
+    size_t num_workers,
+    myst_exitless_handler_t handler);
+
+/* wake parked workers after a caller had to fall back */
+void myst_exitless_wake(myst_exitless_t* queue);
+
+void myst_exitless_free(myst_exitless_t* queue);
+
+#endif /* _MYST_EXITLESS_H */
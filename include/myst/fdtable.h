@@ -15,8 +15,10 @@
 #include <myst/fs.h>
 #include <myst/inotifydev.h>
 #include <myst/pipedev.h>
+#include <myst/signalfddev.h>
 #include <myst/sockdev.h>
 #include <myst/spinlock.h>
+#include <myst/timerfddev.h>
 #include <myst/ttydev.h>
 
 #define MYST_FDTABLE_SIZE 2048
@@ -31,6 +33,8 @@ typedef enum myst_fdtable_type
     MYST_FDTABLE_TYPE_EPOLL,
     MYST_FDTABLE_TYPE_INOTIFY,
     MYST_FDTABLE_TYPE_EVENTFD,
+    MYST_FDTABLE_TYPE_TIMERFD,
+    MYST_FDTABLE_TYPE_SIGNALFD,
 } myst_fdtable_type_t;
 
 typedef struct myst_fdtable_entry
@@ -156,6 +160,27 @@ MYST_INLINE int myst_fdtable_get_eventfd(
     return myst_fdtable_get(fdtable, fd, type, (void**)device, (void**)eventfd);
 }
 
+MYST_INLINE int myst_fdtable_get_timerfd(
+    myst_fdtable_t* fdtable,
+    int fd,
+    myst_timerfddev_t** device,
+    myst_timerfd_t** timerfd)
+{
+    const myst_fdtable_type_t type = MYST_FDTABLE_TYPE_TIMERFD;
+    return myst_fdtable_get(fdtable, fd, type, (void**)device, (void**)timerfd);
+}
+
+MYST_INLINE int myst_fdtable_get_signalfd(
+    myst_fdtable_t* fdtable,
+    int fd,
+    myst_signalfddev_t** device,
+    myst_signalfd_t** signalfd)
+{
+    const myst_fdtable_type_t type = MYST_FDTABLE_TYPE_SIGNALFD;
+    return myst_fdtable_get(
+        fdtable, fd, type, (void**)device, (void**)signalfd);
+}
+
 int myst_fdtable_get_any(
     myst_fdtable_t* fdtable,
     int fd,
@@ -163,6 +188,20 @@ int myst_fdtable_get_any(
     void** device,
     void** object);
 
+/* bit masks of fdtable types for myst_fdtable_get_host_fd() */
+#define MYST_FDTABLE_MASK(TYPE) (1u << (TYPE))
+
+/* get the host file descriptor that backs fd, which must be a hostfs file
+ * or a host socket (as permitted by the types mask); returns -ENOTSUP if the
+ * fd is not backed by a host file descriptor (pipes keep their data in the
+ * kernel, so they are never backed by one) */
+int myst_fdtable_get_host_fd(
+    myst_fdtable_t* fdtable,
+    int fd,
+    uint32_t types,
+    myst_fdtable_type_t* type,
+    void** device);
+
 /* get the fdtable for the current thread */
 myst_fdtable_t* myst_fdtable_current(void);
 
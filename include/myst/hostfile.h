@@ -12,4 +12,8 @@
 // not include the terminator in the size)
 int myst_load_host_file(const char* path, void** data, size_t* size);
 
+// Check that a file on the host file system exists and can be opened for
+// reading (without reading its contents)
+int myst_check_host_file(const char* path);
+
 #endif /* _MYST_HOSTFILE_H */
@@ -10,4 +10,7 @@ int myst_init_hostfs(myst_fs_t** fs_out);
 
 bool myst_is_hostfs(const myst_fs_t* fs);
 
+/* discard cached attributes after host files were modified directly */
+void myst_hostfs_invalidate(myst_fs_t* fs);
+
 #endif /* _MYST_HOSTFS_H */
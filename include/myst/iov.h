@@ -4,6 +4,7 @@
 #ifndef _MYST_IOV_H
 #define _MYST_IOV_H
 
+#include <stddef.h>
 #include <sys/uio.h>
 
 ssize_t myst_iov_len(const struct iovec* iov, int iovcnt);
@@ -16,4 +17,31 @@ long myst_iov_scatter(
     const void* buf,
     size_t len);
 
+/* A position within an IO vector, used to copy to and from the vector in
+ * pieces without first flattening it. */
+typedef struct myst_iov_cursor
+{
+    const struct iovec* iov;
+    int iovcnt;
+    int index;
+    size_t offset;
+} myst_iov_cursor_t;
+
+void myst_iov_cursor_init(
+    myst_iov_cursor_t* cursor,
+    const struct iovec* iov,
+    int iovcnt);
+
+/* copy up to count bytes from the vector to buf (returns bytes copied) */
+size_t myst_iov_cursor_gather(
+    myst_iov_cursor_t* cursor,
+    void* buf,
+    size_t count);
+
+/* copy up to count bytes from buf to the vector (returns bytes copied) */
+size_t myst_iov_cursor_scatter(
+    myst_iov_cursor_t* cursor,
+    const void* buf,
+    size_t count);
+
 #endif /* _MYST_IOV_H */
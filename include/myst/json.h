@@ -40,11 +40,19 @@ typedef enum _json_type
 
 const char* json_result_string(json_result_t result);
 
+/* A string within the JSON text (not zero-terminated) */
+typedef struct _json_slice
+{
+    const char* data;
+    size_t size;
+} json_slice_t;
+
 typedef union _json_union {
     unsigned char boolean;
     int64_t integer;
     double real;
     char* string;
+    json_slice_t slice; /* strings (slice.data is the same as string) */
 } json_union_t;
 
 typedef enum _json_reason
@@ -86,11 +94,19 @@ typedef struct _json_node
 
     /* The array index (if an array) */
     size_t index;
+
+    /* Length of the name */
+    size_t name_size;
 } json_node_t;
 
 typedef struct _json_parser_options
 {
     int allow_whitespace;
+
+    /* If non-zero, the parser does not modify the JSON text. Strings (and
+     * names in the path) are passed as slices of the text which are neither
+     * zero-terminated nor unescaped (see json_slice_unescape()). */
+    int zero_copy;
 } json_parser_options_t;
 
 typedef void (*json_trace_t)(
@@ -117,7 +133,8 @@ struct _json_parser
 };
 
 /* This function initializes the JSON parser. The parser destroys its input
- * text.
+ * text (unless the zero_copy option is set). The parser itself never
+ * allocates memory.
  *     - json_data - zero-terminated JSON text (modified during parsing).
  *     - json_size - length of the JSON text excluding the zero terminator.
  *     - callback - called repeatedly during parsing.
@@ -272,4 +289,61 @@ void json_dump_path(json_write_t write, void* stream, json_parser_t* parser);
 /* This function retrieves the index of the current array element */
 unsigned long json_get_array_index(json_parser_t* parser);
 
+/* This function unescapes a string slice passed by a parser in zero_copy
+ * mode into the given buffer and zero-terminates it. The unescaped string is
+ * never longer than the slice, so a buffer of slice->size + 1 bytes is always
+ * large enough.
+ */
+json_result_t json_slice_unescape(
+    const json_slice_t* slice,
+    char* buf,
+    size_t buf_size);
+
+/*
+**==============================================================================
+**
+** json_trie_t:
+**
+** A path matcher compiled from a set of json_match() patterns. Parsers with
+** many patterns build the trie once and call json_trie_match() at each value
+** rather than trying json_match() with every pattern in turn. The nodes are
+** provided by the caller, so building and matching never allocate memory.
+**
+**==============================================================================
+*/
+
+typedef struct _json_trie_node
+{
+    const char* name; /* path element (points into the pattern) */
+    size_t name_size;
+    long child;   /* index of the first child (or -1) */
+    long sibling; /* index of the next sibling (or -1) */
+    long id;      /* identifier of the pattern that ends here (or -1) */
+} json_trie_node_t;
+
+typedef struct _json_trie
+{
+    json_trie_node_t* nodes;
+    size_t num_nodes;
+    size_t max_nodes;
+} json_trie_t;
+
+/* This function initializes an empty trie that uses the given nodes */
+json_result_t json_trie_init(
+    json_trie_t* trie,
+    json_trie_node_t* nodes,
+    size_t max_nodes);
+
+/* This function adds a pattern (with the syntax of json_match()) to the trie.
+ * The pattern must remain valid for the lifetime of the trie. The id must be
+ * non-negative and is returned by json_trie_match() when the pattern matches.
+ */
+json_result_t json_trie_add(json_trie_t* trie, const char* pattern, long id);
+
+/* This function matches the path currently being parsed against the trie and
+ * returns the id of the matching pattern or -1 if there is none. An element
+ * that matches a name exactly takes precedence over a "#" element.
+ */
+long json_trie_match(const json_trie_t* trie, const json_parser_t* parser);
+
 #endif /* _MYST_JSON_H */
@@ -61,6 +61,9 @@ typedef struct _myst_wanted_secrets_config
 typedef struct myst_crt_args
 {
     myst_wanted_secrets_t* wanted_secrets;
+
+    /* fast clock_gettime() entry (bypasses the kernel syscall entry) */
+    long (*clock_gettime)(clockid_t clk_id, struct timespec* tp);
 } myst_crt_args_t;
 
 typedef struct _myst_strace_config
@@ -238,6 +241,10 @@ typedef struct myst_kernel_args
     // CPUs reported by sched_getaffinity().
     size_t max_affinity_cpus;
 
+    // From the --hostfs-cache-ttl=<msec> option. Lifetime of cached hostfs
+    // attributes and directory listings (zero disables the cache).
+    size_t hostfs_cache_ttl;
+
     // mode the fork implementation uses.
     // selection between a fork/exec model,
     // or a more traditional fork model with limits
@@ -14,4 +14,12 @@ myst_fs_t* myst_lockfs_target(myst_fs_t* fs);
 
 bool myst_is_lockfs(const myst_fs_t* fs);
 
+/* Let operations that only inspect the file system (pread, stat, access,
+ * readlink, realpath, statfs) run concurrently under a shared lock. Only
+ * enable this for file systems whose inspecting operations are safe to run
+ * in parallel with each other. Must be called before the file system is in
+ * use.
+ */
+int myst_lockfs_set_shared_reads(myst_fs_t* fs, bool enable);
+
 #endif /* _MYST_LOCKFS_H */
@@ -0,0 +1,64 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#ifndef _MYST_MEMOPS_H
+#define _MYST_MEMOPS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <myst/defs.h>
+
+/*
+**==============================================================================
+**
+** Vectorized implementations of the kernel's memory and string primitives.
+**
+** The SSE2 variants run on any x86-64 processor and are used until
+** myst_memops_init() selects the best variants for the processor (AVX2 for
+** comparisons and small or medium copies, "rep movsb/stosb" for large ones
+** when ERMS is available). The kernel's memcpy(), memmove(), memset(),
+** memcmp() and strlen() call through __myst_memops.
+**
+**==============================================================================
+*/
+
+/* processor features used by the variants */
+#define MYST_MEMOPS_AVX2 0x1
+#define MYST_MEMOPS_ERMS 0x2
+
+typedef struct myst_memops
+{
+    void* (*memcpy)(void* dest, const void* src, size_t n);
+    void* (*memmove)(void* dest, const void* src, size_t n);
+    void* (*memset)(void* s, int c, size_t n);
+    int (*memcmp)(const void* s1, const void* s2, size_t n);
+    size_t (*strlen)(const char* s);
+} myst_memops_t;
+
+extern myst_memops_t __myst_memops;
+
+/* return the MYST_MEMOPS_* features supported by this processor */
+uint32_t myst_memops_features(void);
+
+/* select the variants (called once during kernel startup) */
+void myst_memops_init(void);
+
+void* myst_memcpy_sse2(void* dest, const void* src, size_t n);
+void* myst_memcpy_avx2(void* dest, const void* src, size_t n);
+void* myst_memcpy_erms(void* dest, const void* src, size_t n);
+
+void* myst_memmove_sse2(void* dest, const void* src, size_t n);
+void* myst_memmove_avx2(void* dest, const void* src, size_t n);
+
+void* myst_memset_sse2(void* s, int c, size_t n);
+void* myst_memset_avx2(void* s, int c, size_t n);
+void* myst_memset_erms(void* s, int c, size_t n);
+
+int myst_memcmp_sse2(const void* s1, const void* s2, size_t n);
+int myst_memcmp_avx2(const void* s1, const void* s2, size_t n);
+
+size_t myst_strlen_sse2(const char* s);
+size_t myst_strlen_avx2(const char* s);
+
+#endif /* _MYST_MEMOPS_H */
@@ -28,6 +28,13 @@
 
 #define MYST_MREMAP_MAYMOVE 1
 
+#define MYST_MADV_NORMAL 0
+#define MYST_MADV_RANDOM 1
+#define MYST_MADV_SEQUENTIAL 2
+#define MYST_MADV_WILLNEED 3
+#define MYST_MADV_DONTNEED 4
+#define MYST_MADV_FREE 8
+
 #define MYST_MMAN_ERROR_SIZE 256
 
 /* Virtual Address Descriptor */
@@ -109,6 +116,16 @@ typedef struct myst_mman
     /* Heap locking */
     myst_rspinlock_t lock;
 
+    /* Total bytes discarded by myst_mman_madvise(MYST_MADV_DONTNEED) (the
+     * discarded bytes are only freed if they also count as released) */
+    size_t dontneed_size;
+
+    /* Total bytes marked lazily reclaimable by MYST_MADV_FREE */
+    size_t lazyfree_size;
+
+    /* Total bytes whose backing memory was released to the host */
+    size_t released_size;
+
     /* Error string */
     char err[MYST_MMAN_ERROR_SIZE];
 
@@ -152,6 +169,8 @@ void myst_mman_dump_vads(myst_mman_t* mman);
 
 int myst_mman_mprotect(myst_mman_t* mman, void* addr, size_t len, int prot);
 
+int myst_mman_madvise(myst_mman_t* mman, void* addr, size_t len, int advice);
+
 int myst_mman_get_prot(
     myst_mman_t* mman,
     void* addr,
@@ -49,6 +49,8 @@ void* myst_mremap(
 
 int myst_mprotect(const void* addr, const size_t len, const int prot);
 
+int myst_madvise(void* addr, size_t length, int advice);
+
 int myst_get_total_ram(size_t* size);
 
 int myst_get_free_ram(size_t* size);
@@ -64,6 +66,9 @@ typedef struct myst_mman_stats
     size_t free_size;
     size_t used_size;
     size_t total_size;
+    size_t dontneed_size; /* bytes discarded with MADV_DONTNEED */
+    size_t lazyfree_size; /* bytes marked reclaimable with MADV_FREE */
+    size_t released_size; /* bytes released to the host */
 } myst_mman_stats_t;
 
 void myst_mman_stats(myst_mman_stats_t* buf);
@@ -0,0 +1,40 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#ifndef _MYST_NUMA_H
+#define _MYST_NUMA_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <myst/defs.h>
+
+/* node masks are kept in a single word */
+#define MYST_NUMA_MAX_NODES 64
+
+/* take a snapshot of the host's NUMA topology (called once during boot) */
+int myst_numa_setup(void);
+
+/* the mask of the NUMA nodes that were online at boot (never empty) */
+uint64_t myst_numa_online_nodes(void);
+
+/* one more than the highest CPU the kernel may run on (set at boot) */
+unsigned myst_numa_ncpus(void);
+
+/* get the current CPU and node, without leaving the kernel if possible */
+long myst_numa_getcpu(unsigned* cpu, unsigned* node);
+
+/* like myst_numa_getcpu() but returns false rather than calling the host */
+bool myst_numa_getcpu_fast(unsigned* cpu, unsigned* node);
+
+/* apply the memory policy of the calling thread to a new private mapping */
+void myst_numa_apply_mempolicy(void* addr, size_t length);
+
+/* forget the mbind() policies of the calling process within the range */
+int myst_numa_unmap(void* addr, size_t length);
+
+/* forget the mbind() policies of an exiting (or exec'ing) process */
+void myst_numa_release_process(pid_t pid);
+
+#endif /* _MYST_NUMA_H */
@@ -27,6 +27,10 @@ typedef struct myst_options
     size_t main_stack_size;
     size_t thread_stack_size;
     size_t max_affinity_cpus;
+    uint32_t exitless_classes;
+    size_t exitless_workers;
+    size_t host_staging_buffer_size;
+    size_t hostfs_cache_ttl;
     char rootfs[PATH_MAX];
     myst_fork_mode_t fork_mode;
     myst_host_enc_uid_gid_mappings host_enc_uid_gid_mappings;
@@ -32,6 +32,19 @@ struct myst_pipedev
         const void* buf,
         size_t count);
 
+    /* like pd_read() and pd_write() but never block (see splice()) */
+    ssize_t (*pd_read_nonblock)(
+        myst_pipedev_t* pipedev,
+        myst_pipe_t* pipe,
+        void* buf,
+        size_t count);
+
+    ssize_t (*pd_write_nonblock)(
+        myst_pipedev_t* pipedev,
+        myst_pipe_t* pipe,
+        const void* buf,
+        size_t count);
+
     ssize_t (*pd_readv)(
         myst_pipedev_t* pipedev,
         myst_pipe_t* pipe,
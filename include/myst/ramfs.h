@@ -54,6 +54,29 @@ int myst_ramfs_set_buf(
     const void* buf,
     size_t buf_size);
 
+/* Mount an indexed CPIO archive (see <myst/cpioindex.h>) on the empty root
+ * directory. Entries are created on first access and file data refers to the
+ * image until modified, so the image must stay mapped. Returns -ENOENT if the
+ * image has no index.
+ */
+int myst_ramfs_load_index(myst_fs_t* fs, const void* image, size_t image_size);
+
+/* Produce the data of a lazy file (see myst_ramfs_create_lazy_file()) into
+ * the given buffer. */
+typedef int (*myst_ramfs_fill_callback_t)(void* arg, myst_buf_t* buf);
+
+/* Create a regular file whose data is produced by fill() when the file is
+ * first opened, stat'ed or truncated, for contents that are costly to produce
+ * and that may never be used. After that, it is an ordinary file. Returns
+ * -ENOTSUP if the parent directory is not on a RAM file system.
+ */
+int myst_ramfs_create_lazy_file(
+    myst_fs_t* fs,
+    const char* pathname,
+    mode_t mode,
+    myst_ramfs_fill_callback_t fill,
+    void* arg);
+
 int myst_create_virtual_file(
     myst_fs_t* fs,
     const char* pathname,
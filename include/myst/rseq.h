@@ -0,0 +1,52 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#ifndef _MYST_RSEQ_H
+#define _MYST_RSEQ_H
+
+#include <signal.h>
+#include <stdint.h>
+
+#include <myst/defs.h>
+#include <myst/thread.h>
+
+/* the area that a thread registers with rseq() (struct rseq on Linux) */
+typedef struct myst_rseq
+{
+    uint32_t cpu_id_start;
+    uint32_t cpu_id;
+    uint64_t rseq_cs; /* the current myst_rseq_cs_t (or zero) */
+    uint32_t flags;
+    uint32_t node_id;
+    uint32_t mm_cid;
+} MYST_ALIGN(32) myst_rseq_t;
+
+/* a critical section descriptor (struct rseq_cs on Linux) */
+typedef struct myst_rseq_cs
+{
+    uint32_t version;
+    uint32_t flags;
+    uint64_t start_ip;
+    uint64_t post_commit_offset;
+    uint64_t abort_ip;
+} MYST_ALIGN(32) myst_rseq_cs_t;
+
+long myst_syscall_rseq(
+    myst_rseq_t* rseq,
+    uint32_t rseq_len,
+    int flags,
+    uint32_t sig);
+
+/* follow the thread to the CPU it runs on now (on return to user space) */
+void myst_rseq_update(myst_thread_t* thread);
+
+/* restart the critical section that a signal handler interrupts */
+int myst_rseq_abort(myst_thread_t* thread, mcontext_t* mcontext);
+
+/* keep the registration of the forking thread in the child process */
+void myst_rseq_fork(myst_thread_t* parent, myst_thread_t* child);
+
+/* give up the registration of an exiting (or exec'ing) thread */
+void myst_rseq_release(myst_thread_t* thread);
+
+#endif /* _MYST_RSEQ_H */
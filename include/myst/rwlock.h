@@ -0,0 +1,38 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#ifndef _MYST_RWLOCK_H
+#define _MYST_RWLOCK_H
+
+#include <myst/spinlock.h>
+#include <myst/thread.h>
+
+/* Reader/writer lock. Waiters are served in FIFO order: a writer is granted
+ * the lock when all readers ahead of it have released it, and a run of
+ * consecutive readers is granted the lock together. Both locks are
+ * recursive: a writer may take either lock again, and a reader may take the
+ * read lock again even while a writer waits (each thread tracks the read
+ * locks it holds). A reader that asks for the write lock would wait for
+ * itself, so that upgrade panics instead of deadlocking.
+ */
+typedef struct myst_rwlock
+{
+    myst_spinlock_t lock;
+    size_t readers;            /* number of read locks held */
+    myst_thread_t* writer;     /* holder of the write lock */
+    size_t writer_refs;        /* recursion count of the write lock */
+    myst_thread_queue_t queue; /* waiting threads */
+} myst_rwlock_t;
+
+int myst_rwlock_init(myst_rwlock_t* rwlock);
+
+int myst_rwlock_rdlock(myst_rwlock_t* rwlock);
+
+int myst_rwlock_wrlock(myst_rwlock_t* rwlock);
+
+/* release a read or write lock held by the calling thread */
+int myst_rwlock_unlock(myst_rwlock_t* rwlock);
+
+int myst_rwlock_destroy(myst_rwlock_t* rwlock);
+
+#endif /* _MYST_RWLOCK_H */
@@ -5,12 +5,16 @@
 #define _MYST_SHM_H
 
 #include <myst/clock.h>
+#include <myst/exitless.h>
 
 /* Note: members of this struct are copied by value into the enclave */
 struct myst_shm
 {
     /* clock related shared fields */
     struct clock_ctrl* clock;
+
+    /* exitless tcall queue (null if disabled) */
+    struct myst_exitless* exitless;
 };
 
 int shm_create_clock(struct myst_shm* shm, unsigned long clock_tick);
@@ -0,0 +1,81 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#ifndef _MYST_SHMFS_H
+#define _MYST_SHMFS_H
+
+#include <stdbool.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <sys/types.h>
+
+#include <myst/fs.h>
+
+/*
+**==============================================================================
+**
+** shmfs lifetime management (the file system is mounted on /dev/shm)
+**
+**==============================================================================
+*/
+
+int shmfs_setup(void);
+
+int shmfs_teardown(void);
+
+bool myst_is_shmfs(const myst_fs_t* fs);
+
+/*
+**==============================================================================
+**
+** shared mappings
+**
+**==============================================================================
+*/
+
+/* Map the pages of a shared memory object with MAP_SHARED. The pages appear
+ * at the same address in every process, so MAP_FIXED fails with EINVAL unless
+ * addr is where the pages already are. */
+long myst_shmfs_mmap(
+    myst_fs_t* fs,
+    myst_file_t* file,
+    void* addr,
+    size_t length,
+    int prot,
+    int flags,
+    off_t offset);
+
+/* whether the range overlaps the pages of a shared memory object */
+bool myst_shmfs_is_shared(const void* addr, size_t length);
+
+/* madvise() the range except for the pages of shared memory objects, which
+ * other processes may still be using */
+int myst_shmfs_madvise(void* addr, size_t length, int advice);
+
+/* munmap() a range that overlaps shared memory objects: trim or split the
+ * calling process's mappings within the range (partial unmaps leave the
+ * object's pages in place) and unmap the private pages in between */
+int myst_shmfs_munmap(void* addr, size_t length);
+
+/* remove the mappings of an exiting (or exec'ing) process */
+void myst_shmfs_release_process(pid_t pid);
+
+/*
+**==============================================================================
+**
+** system calls
+**
+**==============================================================================
+*/
+
+long myst_syscall_memfd_create(const char* name, unsigned int flags);
+
+long myst_syscall_shmget(key_t key, size_t size, int shmflg);
+
+long myst_syscall_shmat(int shmid, const void* shmaddr, int shmflg);
+
+long myst_syscall_shmdt(const void* shmaddr);
+
+long myst_syscall_shmctl(int shmid, int cmd, struct shmid_ds* buf);
+
+#endif /* _MYST_SHMFS_H */
@@ -25,11 +25,25 @@ long myst_signal_sigprocmask(int how, const sigset_t* set, sigset_t* oldset);
 
 long myst_signal_process(myst_thread_t* thread);
 
+/* send a signal to the thread; the siginfo (if any) is copied */
+long myst_signal_queue(
+    myst_thread_t* thread,
+    unsigned signum,
+    const siginfo_t* siginfo);
+
+/* like myst_signal_queue() but frees the heap-allocated siginfo (if any) */
 long myst_signal_deliver(
     myst_thread_t* thread,
     unsigned signum,
     siginfo_t* siginfo);
 
+/* remove the lowest pending signal in mask from the thread's queue; returns
+ * the signal number or zero if none of the signals are pending */
+int myst_signal_dequeue(
+    myst_thread_t* thread,
+    uint64_t mask,
+    siginfo_t* siginfo);
+
 long myst_signal_sigpending(sigset_t* set, unsigned size);
 
 long myst_signal_clone(myst_thread_t* parent, myst_thread_t* child);
@@ -0,0 +1,95 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#ifndef _MYST_SIGNALFDDEV_H
+#define _MYST_SIGNALFDDEV_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include <myst/fdops.h>
+
+typedef struct myst_signalfddev myst_signalfddev_t;
+
+typedef struct myst_signalfd myst_signalfd_t;
+
+struct myst_signalfddev
+{
+    myst_fdops_t fdops;
+
+    int (*signalfd)(
+        myst_signalfddev_t* signalfddev,
+        uint64_t mask,
+        int flags,
+        myst_signalfd_t** signalfd_out);
+
+    int (*setmask)(
+        myst_signalfddev_t* signalfddev,
+        myst_signalfd_t* signalfd,
+        uint64_t mask);
+
+    ssize_t (*read)(
+        myst_signalfddev_t* signalfddev,
+        myst_signalfd_t* signalfd,
+        void* buf,
+        size_t count);
+
+    ssize_t (*write)(
+        myst_signalfddev_t* signalfddev,
+        myst_signalfd_t* signalfd,
+        const void* buf,
+        size_t count);
+
+    ssize_t (*readv)(
+        myst_signalfddev_t* signalfddev,
+        myst_signalfd_t* signalfd,
+        const struct iovec* iov,
+        int iovcnt);
+
+    ssize_t (*writev)(
+        myst_signalfddev_t* signalfddev,
+        myst_signalfd_t* signalfd,
+        const struct iovec* iov,
+        int iovcnt);
+
+    int (*fstat)(
+        myst_signalfddev_t* signalfddev,
+        myst_signalfd_t* signalfd,
+        struct stat* statbuf);
+
+    int (*fcntl)(
+        myst_signalfddev_t* signalfddev,
+        myst_signalfd_t* signalfd,
+        int cmd,
+        long arg);
+
+    int (*ioctl)(
+        myst_signalfddev_t* signalfddev,
+        myst_signalfd_t* signalfd,
+        unsigned long request,
+        long arg);
+
+    int (*dup)(
+        myst_signalfddev_t* signalfddev,
+        const myst_signalfd_t* signalfd,
+        myst_signalfd_t** signalfd_out);
+
+    int (*close)(myst_signalfddev_t* signalfddev, myst_signalfd_t* signalfd);
+
+    int (*target_fd)(
+        myst_signalfddev_t* signalfddev,
+        myst_signalfd_t* signalfd);
+
+    int (*get_events)(
+        myst_signalfddev_t* signalfddev,
+        myst_signalfd_t* signalfd);
+};
+
+myst_signalfddev_t* myst_signalfddev_get(void);
+
+/* called whenever a signal is queued to wake the signalfds waiting for it */
+void myst_signalfd_notify(unsigned signum);
+
+#endif /* _MYST_SIGNALFDDEV_H */
@@ -14,6 +14,11 @@ typedef struct myst_sockdev myst_sockdev_t;
 
 typedef struct myst_sock myst_sock_t;
 
+/* defined by <sys/socket.h> only when _GNU_SOURCE is defined */
+struct mmsghdr;
+
+struct timespec;
+
 struct myst_sockdev
 {
     myst_fdops_t fdops;
@@ -84,6 +89,23 @@ struct myst_sockdev
         struct msghdr* msg,
         int flags);
 
+    /* optional (may be null): send several messages with one host call */
+    int (*sd_sendmmsg)(
+        myst_sockdev_t* sd,
+        myst_sock_t* sock,
+        struct mmsghdr* msgvec,
+        unsigned int vlen,
+        int flags);
+
+    /* optional (may be null): receive several messages with one host call */
+    int (*sd_recvmmsg)(
+        myst_sockdev_t* sd,
+        myst_sock_t* sock,
+        struct mmsghdr* msgvec,
+        unsigned int vlen,
+        int flags,
+        struct timespec* timeout);
+
     int (*sd_shutdown)(myst_sockdev_t* sd, myst_sock_t* sock, int how);
 
     int (*sd_getsockopt)(
@@ -24,6 +24,13 @@
 
 #define UDP_PACKET_MAX_LENGTH (75 * 1024)
 
+/* Returned (negated) by a system call that needs the CRT to create kernel
+ * threads before it can complete (see crt/enter.c). The CRT then invokes
+ * the system call again, so applications never see this value, which lies
+ * outside the range of the Linux error numbers.
+ */
+#define MYST_ENEEDTHREADS 4000
+
 MYST_INLINE long myst_syscall0(long n)
 {
     unsigned long ret;
@@ -205,6 +212,8 @@ long myst_syscall_clock_getres(clockid_t clk_id, struct timespec* res);
 
 long myst_syscall_clock_gettime(clockid_t clk_id, struct timespec* tp);
 
+long myst_vdso_clock_gettime(clockid_t clk_id, struct timespec* tp);
+
 long myst_syscall_clock_settime(clockid_t clk_id, struct timespec* tp);
 
 long myst_syscall_gettimeofday(struct timeval* tv, struct timezone* tz);
@@ -289,12 +298,58 @@ long myst_syscall_copy_file_range(
     size_t len,
     unsigned int flags);
 
+long myst_syscall_splice(
+    int fd_in,
+    off_t* off_in,
+    int fd_out,
+    off_t* off_out,
+    size_t len,
+    unsigned int flags);
+
+long myst_syscall_vmsplice(
+    int fd,
+    const struct iovec* iov,
+    size_t nr_segs,
+    unsigned int flags);
+
 long myst_syscall_sethostname(const char* hostname, size_t len);
 
 long myst_syscall_umask(mode_t mask);
 
 long myst_syscall_run_itimer(myst_process_t* process);
 
+struct iocb;
+struct io_event;
+
+long myst_syscall_io_setup(
+    myst_process_t* process,
+    unsigned int nr_events,
+    unsigned long* ctx_idp);
+
+long myst_syscall_io_destroy(myst_process_t* process, unsigned long ctx_id);
+
+long myst_syscall_io_submit(
+    myst_process_t* process,
+    unsigned long ctx_id,
+    long nr,
+    struct iocb** iocbpp);
+
+long myst_syscall_io_cancel(
+    myst_process_t* process,
+    unsigned long ctx_id,
+    struct iocb* iocb,
+    struct io_event* result);
+
+long myst_syscall_io_getevents(
+    myst_process_t* process,
+    unsigned long ctx_id,
+    long min_nr,
+    long nr,
+    struct io_event* events,
+    struct timespec* timeout);
+
+long myst_syscall_run_aio(myst_process_t* process);
+
 long myst_syscall_setitimer(
     myst_process_t* process,
     int which,
@@ -306,8 +361,69 @@ int myst_syscall_getitimer(
     int which,
     struct itimerval* curr_value);
 
+struct sigevent;
+
+long myst_syscall_timer_create(
+    myst_process_t* process,
+    clockid_t clockid,
+    struct sigevent* sevp,
+    int* timerid);
+
+long myst_syscall_timer_settime(
+    myst_process_t* process,
+    int timerid,
+    int flags,
+    const struct itimerspec* new_value,
+    struct itimerspec* old_value);
+
+long myst_syscall_timer_gettime(
+    myst_process_t* process,
+    int timerid,
+    struct itimerspec* curr_value);
+
+long myst_syscall_timer_getoverrun(myst_process_t* process, int timerid);
+
+long myst_syscall_timer_delete(myst_process_t* process, int timerid);
+
+/* release the itimer and POSIX timers (after the process threads exited) */
+void myst_itimer_free(myst_process_t* process);
+
+long myst_syscall_timerfd_create(clockid_t clockid, int flags);
+
+long myst_syscall_timerfd_settime(
+    int fd,
+    int flags,
+    const struct itimerspec* new_value,
+    struct itimerspec* old_value);
+
+long myst_syscall_timerfd_gettime(int fd, struct itimerspec* curr_value);
+
+long myst_syscall_signalfd(
+    int fd,
+    const sigset_t* mask,
+    size_t sizemask,
+    int flags);
+
+long myst_syscall_membarrier(int cmd, unsigned int flags, int cpu_id);
+
 long myst_syscall_fsync(int fd);
 
+long myst_syscall_fdatasync(int fd);
+
+ssize_t myst_syscall_preadv2(
+    int fd,
+    const struct iovec* iov,
+    int iovcnt,
+    off_t offset,
+    int flags);
+
+ssize_t myst_syscall_pwritev2(
+    int fd,
+    const struct iovec* iov,
+    int iovcnt,
+    off_t offset,
+    int flags);
+
 long myst_syscall_uname(struct utsname* buf);
 
 long myst_syscall_getuid();
@@ -348,6 +464,26 @@ long myst_syscall_sched_setaffinity(
 
 long myst_syscall_getcpu(unsigned* cpu, unsigned* node);
 
+long myst_syscall_set_mempolicy(
+    int mode,
+    const unsigned long* nodemask,
+    unsigned long maxnode);
+
+long myst_syscall_get_mempolicy(
+    int* mode,
+    unsigned long* nodemask,
+    unsigned long maxnode,
+    void* addr,
+    unsigned long flags);
+
+long myst_syscall_mbind(
+    void* addr,
+    unsigned long len,
+    int mode,
+    const unsigned long* nodemask,
+    unsigned long maxnode,
+    unsigned flags);
+
 long myst_syscall_chown(const char* pathname, uid_t owner, gid_t group);
 long myst_syscall_fchown(int fd, uid_t owner, gid_t group);
 long myst_syscall_lchown(const char* pathname, uid_t owner, gid_t group);
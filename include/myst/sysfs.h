@@ -0,0 +1,19 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#ifndef _MYST_SYSFS_H
+#define _MYST_SYSFS_H
+
+/*
+**==============================================================================
+**
+** sysfs lifetime management (the file system is mounted on /sys)
+**
+**==============================================================================
+*/
+
+int sysfs_setup(void);
+
+int sysfs_teardown(void);
+
+#endif /* _MYST_SYSFS_H */
@@ -11,6 +11,7 @@
 #include <sys/epoll.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <time.h>
 #include <unistd.h>
 
@@ -66,6 +67,10 @@ typedef enum myst_tcall_number
     MYST_TCALL_SENDTO_BLOCK,
     MYST_TCALL_RECVMSG_BLOCK,
     MYST_TCALL_SENDMSG_BLOCK,
+    MYST_TCALL_RECVMMSG_BLOCK,
+    MYST_TCALL_SENDMMSG_BLOCK,
+    MYST_TCALL_READV_BLOCK,
+    MYST_TCALL_WRITEV_BLOCK,
 } myst_tcall_number_t;
 
 long myst_tcall(long n, long params[6]);
@@ -167,6 +172,19 @@ int myst_tcall_load_fssig(const char* path, myst_fssig_t* fssig);
 
 int myst_tcall_mprotect(void* addr, size_t len, int prot);
 
+int myst_tcall_madvise(void* addr, size_t len, int advice);
+
+long myst_tcall_membarrier(int cmd, unsigned int flags);
+
+/* the node mask is passed by value (at most 64 nodes) */
+long myst_tcall_mbind(
+    void* addr,
+    size_t len,
+    int mode,
+    uint64_t nodemask,
+    unsigned long maxnode,
+    unsigned int flags);
+
 long myst_gcov(const char* func, long params[6]);
 
 long myst_tcall_close(int fd);
@@ -181,6 +199,10 @@ long myst_tcall_read(int fd, void* buf, size_t count);
 
 long myst_tcall_write(int fd, const void* buf, size_t count);
 
+long myst_tcall_readv(int fd, const struct iovec* iov, int iovcnt);
+
+long myst_tcall_writev(int fd, const struct iovec* iov, int iovcnt);
+
 long myst_tcall_poll(struct pollfd* fds, nfds_t nfds, int timeout);
 
 long myst_tcall_pipe2(int pipefd[2], int flags);
@@ -226,10 +248,30 @@ ssize_t myst_tcall_sendmsg(int sockfd, const struct msghdr* msg, int flags);
 
 ssize_t myst_tcall_recvmsg(int sockfd, struct msghdr* msg, int flags);
 
+/* defined by <sys/socket.h> only when _GNU_SOURCE is defined */
+struct mmsghdr;
+
+/* send or receive up to vlen messages with a single host call */
+long myst_tcall_sendmmsg(
+    int sockfd,
+    struct mmsghdr* msgvec,
+    unsigned int vlen,
+    int flags);
+
+long myst_tcall_recvmmsg(
+    int sockfd,
+    struct mmsghdr* msgvec,
+    unsigned int vlen,
+    int flags);
+
 long myst_tcall_read_block(int fd, void* buf, size_t count);
 
 long myst_tcall_write_block(int fd, const void* buf, size_t count);
 
+long myst_tcall_readv_block(int fd, const struct iovec* iov, int iovcnt);
+
+long myst_tcall_writev_block(int fd, const struct iovec* iov, int iovcnt);
+
 int myst_tcall_accept4_block(
     int sockfd,
     struct sockaddr* addr,
@@ -264,4 +306,17 @@ ssize_t myst_tcall_sendmsg_block(
 
 ssize_t myst_tcall_recvmsg_block(int sockfd, struct msghdr* msg, int flags);
 
+/* block until at least one message can be sent or received */
+long myst_tcall_sendmmsg_block(
+    int sockfd,
+    struct mmsghdr* msgvec,
+    unsigned int vlen,
+    int flags);
+
+long myst_tcall_recvmmsg_block(
+    int sockfd,
+    struct mmsghdr* msgvec,
+    unsigned int vlen,
+    int flags);
+
 #endif /* _MYST_TCALL_H */
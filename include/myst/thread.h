@@ -87,15 +87,26 @@ typedef struct myst_robust_list_head
     volatile void* volatile pending;
 } myst_robust_list_head_t;
 
-/* When we have more of than one signal queued we need a list of them. */
+/* When we have more of than one signal queued we need a list of them. The
+ * items come from a preallocated pool (see kernel/signal.c) */
 struct siginfo_list_item
 {
-    siginfo_t* siginfo;
+    siginfo_t siginfo;
+    bool has_siginfo; /* false if the signal was sent without a siginfo */
+    bool pooled;      /* true if the item belongs to the preallocated pool */
     struct siginfo_list_item* next;
 };
 
 typedef struct myst_itimer myst_itimer_t;
 
+typedef struct myst_aio myst_aio_t;
+
+/* the CPU ids handed out by rseq() are below this bound (CPU_SETSIZE) */
+#define MYST_RSEQ_MAX_CPUS 1024
+
+/* the number of distinct rwlocks that a thread may hold for reading */
+#define MYST_THREAD_MAX_RDLOCKS 8
+
 struct myst_process
 {
     /* the session id (see getsid() function) */
@@ -198,13 +209,25 @@ struct myst_process
      */
     int sigstop_futex;
 
-    /* itimer thread needs to be initialized by the CRT once. This boolean
-     * returns if it has not been done yet so it can be initiated. */
-    bool itimer_thread_requested;
-
-    /* itimer data. this structure has too many other objects in it that make it
-     * hard to not be a pointer so it gets initialized when there are calls. */
+    /* ITIMER_REAL and POSIX timers (created by the first timer syscall). The
+     * timers themselves are run by the kernel's timer thread */
     myst_itimer_t* itimer;
+
+    /* the CRT was asked for a timer thread for this process (the threads of
+     * all the processes take turns running the timers) */
+    bool ticker_requested;
+
+    /* AIO worker threads are created by the CRT on the first io_setup() */
+    bool aio_threads_requested;
+
+    /* AIO contexts and request queue (created by the first io_setup()) */
+    myst_aio_t* aio;
+
+    /* MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED was called */
+    bool membarrier_registered;
+
+    /* the CPU ids owned by threads that registered with rseq() */
+    uint64_t rseq_cpus[MYST_RSEQ_MAX_CPUS / 64];
 };
 
 struct myst_thread
@@ -338,6 +361,33 @@ struct myst_thread
     /* the kernel stack that were allocated to handle the exec system call */
     myst_kstack_t* exec_kstack;
 
+    /* the kernel stack that this thread keeps across system calls (see
+     * myst_syscall()); null while a system call is running on it */
+    myst_kstack_t* cached_kstack;
+
+    /* the NUMA memory policy (see SYS_set_mempolicy) */
+    struct
+    {
+        int mode;
+        uint64_t nodemask;
+    } mempolicy;
+
+    /* the read locks held by this thread (see myst_rwlock_rdlock()) */
+    struct
+    {
+        struct myst_rwlock* rwlock; /* null if the slot is free */
+        size_t refs;
+    } rdlocks[MYST_THREAD_MAX_RDLOCKS];
+
+    /* the restartable sequences area (see SYS_rseq) */
+    struct
+    {
+        struct myst_rseq* area; /* null if not registered */
+        uint32_t len;
+        uint32_t sig;
+        uint32_t cpu; /* the CPU id this thread owns */
+    } rseq;
+
     /* when fork needs to wait for child to call exec or exit, wait on this
      * fuxtex. Child set to 1 and signals futex. */
     int fork_exec_futex_wait;
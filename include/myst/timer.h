@@ -0,0 +1,100 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#ifndef _MYST_TIMER_H
+#define _MYST_TIMER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+/*
+**==============================================================================
+**
+** Kernel timers.
+**
+** All kernel timers (ITIMER_REAL, POSIX timers and timerfds) live on a single
+** hierarchical timer wheel with a resolution of MYST_TIMER_TICK_NSEC. The
+** wheel is advanced by one ticker thread at a time, which sleeps until the
+** next tick that has work to do. Like the AIO workers, tickers are created by
+** the C runtime: the first syscall of a process that needs one returns
+** -MYST_ENEEDTHREADS (see myst_timer_request_ticker()) and the CRT then enters
+** the kernel for good on a new thread with SYS_myst_run_itimer. The tickers of
+** the other processes stand by and take over when the running one goes away.
+**
+** Note that this is still one (mostly idle) thread per process that uses
+** timers, not a single kernel-owned ticker: the kernel cannot create threads
+** of its own, and a ticker borrowed from one process would go away when that
+** process exits. What the wheel removes is the per-timer work of those
+** threads: only one of them ever runs, and it wakes only when a timer is due.
+**
+** Expiration times are absolute CLOCK_MONOTONIC times in nanoseconds.
+**
+**==============================================================================
+*/
+
+#define MYST_TIMER_TICK_NSEC 1000000UL
+
+typedef struct myst_timer myst_timer_t;
+
+/* Called on the ticker thread with the number of expirations (at least one)
+ * since the previous call. Callbacks must not re-arm their own timer.
+ */
+typedef void (*myst_timer_callback_t)(myst_timer_t* timer, uint64_t n);
+
+struct myst_timer
+{
+    /* the fields below are private to kernel/timer.c */
+    myst_timer_t* prev;
+    myst_timer_t* next;
+    int slot;          /* the wheel slot holding the timer or -1 */
+    uint64_t expires;  /* the next expiration or zero if disarmed */
+    uint64_t interval; /* the reload interval or zero (one shot) */
+    myst_timer_callback_t callback;
+    void* arg;
+};
+
+/* the current CLOCK_MONOTONIC time in nanoseconds */
+uint64_t myst_timer_now(void);
+
+void myst_timer_init(
+    myst_timer_t* timer,
+    myst_timer_callback_t callback,
+    void* arg);
+
+/* Arm the timer (or disarm it if expires is zero). Waits for the callback to
+ * return if it is running, so the callback never sees the previous setting.
+ */
+void myst_timer_set(myst_timer_t* timer, uint64_t expires, uint64_t interval);
+
+/* get the time until the next expiration (zero if disarmed) and interval */
+void myst_timer_get(
+    myst_timer_t* timer,
+    uint64_t* remaining,
+    uint64_t* interval);
+
+/* Validate the clock of a POSIX timer or timerfd */
+int myst_timer_check_clock(clockid_t clockid);
+
+/* Arm the timer with the given itimerspec (relative or absolute on the given
+ * clock) and optionally return its previous setting.
+ */
+int myst_timer_settime(
+    myst_timer_t* timer,
+    clockid_t clockid,
+    bool abstime,
+    const struct itimerspec* new_value,
+    struct itimerspec* old_value);
+
+void myst_timer_gettime(myst_timer_t* timer, struct itimerspec* curr_value);
+
+/* Return -MYST_ENEEDTHREADS once if the calling process has no ticker thread
+ * (so that the CRT creates it) and wait for the ticker requested by another
+ * thread otherwise.
+ */
+int myst_timer_request_ticker(void);
+
+/* body of the ticker thread (created by the CRT) */
+long myst_syscall_run_timers(void);
+
+#endif /* _MYST_TIMER_H */
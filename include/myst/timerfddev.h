@@ -0,0 +1,95 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#ifndef _MYST_TIMERFDDEV_H
+#define _MYST_TIMERFDDEV_H
+
+#include <stddef.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <time.h>
+
+#include <myst/fdops.h>
+
+typedef struct myst_timerfddev myst_timerfddev_t;
+
+typedef struct myst_timerfd myst_timerfd_t;
+
+struct myst_timerfddev
+{
+    myst_fdops_t fdops;
+
+    int (*timerfd)(
+        myst_timerfddev_t* timerfddev,
+        clockid_t clockid,
+        int flags,
+        myst_timerfd_t** timerfd_out);
+
+    int (*settime)(
+        myst_timerfddev_t* timerfddev,
+        myst_timerfd_t* timerfd,
+        int flags,
+        const struct itimerspec* new_value,
+        struct itimerspec* old_value);
+
+    int (*gettime)(
+        myst_timerfddev_t* timerfddev,
+        myst_timerfd_t* timerfd,
+        struct itimerspec* curr_value);
+
+    ssize_t (*read)(
+        myst_timerfddev_t* timerfddev,
+        myst_timerfd_t* timerfd,
+        void* buf,
+        size_t count);
+
+    ssize_t (*write)(
+        myst_timerfddev_t* timerfddev,
+        myst_timerfd_t* timerfd,
+        const void* buf,
+        size_t count);
+
+    ssize_t (*readv)(
+        myst_timerfddev_t* timerfddev,
+        myst_timerfd_t* timerfd,
+        const struct iovec* iov,
+        int iovcnt);
+
+    ssize_t (*writev)(
+        myst_timerfddev_t* timerfddev,
+        myst_timerfd_t* timerfd,
+        const struct iovec* iov,
+        int iovcnt);
+
+    int (*fstat)(
+        myst_timerfddev_t* timerfddev,
+        myst_timerfd_t* timerfd,
+        struct stat* statbuf);
+
+    int (*fcntl)(
+        myst_timerfddev_t* timerfddev,
+        myst_timerfd_t* timerfd,
+        int cmd,
+        long arg);
+
+    int (*ioctl)(
+        myst_timerfddev_t* timerfddev,
+        myst_timerfd_t* timerfd,
+        unsigned long request,
+        long arg);
+
+    int (*dup)(
+        myst_timerfddev_t* timerfddev,
+        const myst_timerfd_t* timerfd,
+        myst_timerfd_t** timerfd_out);
+
+    int (*close)(myst_timerfddev_t* timerfddev, myst_timerfd_t* timerfd);
+
+    int (*target_fd)(myst_timerfddev_t* timerfddev, myst_timerfd_t* timerfd);
+
+    int (*get_events)(myst_timerfddev_t* timerfddev, myst_timerfd_t* timerfd);
+};
+
+myst_timerfddev_t* myst_timerfddev_get(void);
+
+#endif /* _MYST_TIMERFDDEV_H */
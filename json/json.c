@@ -70,50 +70,6 @@ static void _trace_result(
     }
 }
 
-static void* _malloc(json_parser_t* parser, size_t size)
-{
-    if (!parser || !parser->allocator || !parser->allocator->ja_malloc)
-        return NULL;
-
-    return (*parser->allocator->ja_malloc)(size);
-}
-
-static void _free(json_parser_t* parser, void* ptr)
-{
-    if (!parser || !parser->allocator || !parser->allocator->ja_free || !ptr)
-        return;
-
-    return (*parser->allocator->ja_free)(ptr);
-}
-
-static size_t _split(
-    char* s,
-    const char sep,
-    const char* tokens[],
-    size_t num_tokens)
-{
-    size_t n = 0;
-
-    for (;;)
-    {
-        if (n == num_tokens)
-            return (size_t)-1;
-
-        tokens[n++] = s;
-
-        /* Skip non-separator characters */
-        while (*s && *s != sep)
-            s++;
-
-        if (!*s)
-            break;
-
-        *s++ = '\0';
-    }
-
-    return n;
-}
-
 static unsigned char _char_to_nibble(char c)
 {
     c = (char)myst_tolower(c);
@@ -196,7 +152,98 @@ done:
     return result;
 }
 
-static json_result_t _get_string(json_parser_t* parser, char** str)
+/* Unescape the n characters at src into dst, which may be the same as src
+ * since the output is never longer than the input. On entry, *dst_size is the
+ * size of dst; on return, it is the length of the unescaped string.
+ */
+static json_result_t _unescape(
+    json_parser_t* parser,
+    const char* src,
+    size_t n,
+    char* dst,
+    size_t* dst_size)
+{
+    json_result_t result = JSON_OK;
+    const char* end = src + n;
+    size_t size = 0;
+
+    while (src != end)
+    {
+        char c = *src++;
+
+        /* Handled escaped characters */
+        if (c == '\\')
+        {
+            if (src == end)
+                RAISE(JSON_EOF);
+
+            switch (*src++)
+            {
+                case '"':
+                    c = '"';
+                    break;
+                case '\\':
+                    c = '\\';
+                    break;
+                case '/':
+                    c = '/';
+                    break;
+                case 'b':
+                    c = '\b';
+                    break;
+                case 'f':
+                    c = '\f';
+                    break;
+                case 'n':
+                    c = '\n';
+                    break;
+                case 'r':
+                    c = '\r';
+                    break;
+                case 't':
+                    c = '\t';
+                    break;
+                case 'u':
+                {
+                    uint32_t x;
+
+                    /* Expecting 4 hex digits: XXXX */
+                    if (end - src < 4)
+                        RAISE(JSON_EOF);
+
+                    if (_hex_str4_to_u32(src, &x) != 0)
+                        RAISE(JSON_BAD_SYNTAX);
+
+                    if (x >= 256)
+                    {
+                        /* ATTN.B: UTF-8 not supported yet! */
+                        RAISE(JSON_UNSUPPORTED);
+                    }
+
+                    c = (char)x;
+                    src += 4;
+                    break;
+                }
+                default:
+                {
+                    RAISE(JSON_FAILED);
+                }
+            }
+        }
+
+        if (size == *dst_size)
+            RAISE(JSON_BUFFER_OVERFLOW);
+
+        dst[size++] = c;
+    }
+
+    *dst_size = size;
+
+done:
+    return result;
+}
+
+static json_result_t _get_string(json_parser_t* parser, json_slice_t* slice)
 {
     json_result_t result = JSON_OK;
     char* start = parser->ptr;
@@ -204,9 +251,6 @@ static json_result_t _get_string(json_parser_t* parser, char** str)
     const char* end = parser->end;
     int escaped = 0;
 
-    /* Save the start of the string */
-    *str = p;
-
     /* Find the closing quote */
     while (p != end && *p != '"')
     {
@@ -235,138 +279,124 @@ static json_result_t _get_string(json_parser_t* parser, char** str)
     /* Update the os */
     parser->ptr += p - start + 1;
 
-    /* Skip modification of text if only scanning */
-    if (parser->scan)
+    slice->data = start;
+    slice->size = (size_t)(p - start);
+
+    /* Leave the text as is if only scanning or in zero-copy mode */
+    if (parser->scan || parser->options.zero_copy)
     {
         result = JSON_OK;
         goto done;
     }
 
-    /* Overwrite the '"' character */
-    *p = '\0';
-    end = p;
-
-    /* Process escaped characters (if any) */
+    /* Process escaped characters (if any) in place */
     if (escaped)
-    {
-        p = start;
+        CHECK(_unescape(parser, start, slice->size, start, &slice->size));
 
-        while (*p)
-        {
-            /* Handled escaped characters */
-            if (*p == '\\')
-            {
-                p++;
+    /* Overwrite the '"' character (or the end of the unescaped string) */
+    start[slice->size] = '\0';
 
-                if (!*p)
-                    RAISE(JSON_EOF);
+done:
+    return result;
+}
 
-                switch (*p)
-                {
-                    case '"':
-                        p[-1] = '"';
-                        memmove(p, p + 1, (size_t)(end - p));
-                        end--;
-                        break;
-                    case '\\':
-                        p[-1] = '\\';
-                        memmove(p, p + 1, (size_t)(end - p));
-                        end--;
-                        break;
-                    case '/':
-                        p[-1] = '/';
-                        memmove(p, p + 1, (size_t)(end - p));
-                        end--;
-                        break;
-                    case 'b':
-                        p[-1] = '\b';
-                        memmove(p, p + 1, (size_t)(end - p));
-                        end--;
-                        break;
-                    case 'f':
-                        p[-1] = '\f';
-                        memmove(p, p + 1, (size_t)(end - p));
-                        end--;
-                        break;
-                    case 'n':
-                        p[-1] = '\n';
-                        memmove(p, p + 1, (size_t)(end - p));
-                        end--;
-                        break;
-                    case 'r':
-                        p[-1] = '\r';
-                        memmove(p, p + 1, (size_t)(end - p));
-                        end--;
-                        break;
-                    case 't':
-                        p[-1] = '\t';
-                        memmove(p, p + 1, (size_t)(end - p));
-                        end--;
-                        break;
-                    case 'u':
-                    {
-                        uint32_t x;
+static int _expect(json_parser_t* parser, const char* str, size_t len)
+{
+    if (parser->end - parser->ptr >= (ptrdiff_t)len &&
+        memcmp(parser->ptr, str, len) == 0)
+    {
+        parser->ptr += len;
+        return 0;
+    }
 
-                        p++;
+    return -1;
+}
 
-                        /* Expecting 4 hex digits: XXXX */
-                        if (end - p < 4)
-                            RAISE(JSON_EOF);
+static json_result_t _get_value(json_parser_t* parser);
 
-                        if (_hex_str4_to_u32(p, &x) != 0)
-                            RAISE(JSON_BAD_SYNTAX);
+/* Count the elements of the array whose first element (if any) starts at
+ * parser->ptr without parsing them. This is a single pass over the text that
+ * neither invokes the callback nor allocates memory. The syntax is checked
+ * later when the array is parsed.
+ */
+static json_result_t _count_array_elements(json_parser_t* parser, size_t* count)
+{
+    json_result_t result = JSON_OK;
+    const char* p = parser->ptr;
+    const char* end = parser->end;
+    size_t depth = 0;
+    size_t n = 0;
+    int in_token = 0;
 
-                        if (x >= 256)
-                        {
-                            /* ATTN.B: UTF-8 not supported yet! */
-                            RAISE(JSON_UNSUPPORTED);
-                        }
+    while (p != end)
+    {
+        const char c = *p++;
 
-                        /* Overwrite '\' character */
-                        p[-2] = (char)x;
+        if (c == '"')
+        {
+            /* Strings are elements of their own */
+            if (depth == 0)
+                n++;
 
-                        /* Remove "uXXXX" */
-                        memmove(p - 1, p + 4, (size_t)(end - p - 3));
+            in_token = 0;
 
-                        p = p - 1;
-                        end -= 5;
-                        break;
-                    }
-                    default:
-                    {
-                        RAISE(JSON_FAILED);
-                    }
-                }
+            while (p != end && *p != '"')
+            {
+                if (*p++ == '\\' && p != end)
+                    p++;
             }
-            else
+
+            if (p == end)
+                RAISE(JSON_EOF);
+
+            p++;
+        }
+        else if (c == '[' || c == '{')
+        {
+            if (depth++ == 0)
+                n++;
+
+            in_token = 0;
+        }
+        else if (c == ']' || c == '}')
+        {
+            if (depth == 0)
             {
+                if (c != ']')
+                    RAISE(JSON_BAD_SYNTAX);
+
+                *count = n;
+                goto done;
+            }
+
+            depth--;
+        }
+        else if (c == '/' && p != end && *p == '/')
+        {
+            /* Skip comment lines */
+            while (p != end && *p != '\n' && *p != '\r')
                 p++;
+
+            in_token = 0;
+        }
+        else if (depth == 0)
+        {
+            if (c == ',' || myst_isspace(c))
+                in_token = 0;
+            else if (!in_token)
+            {
+                n++;
+                in_token = 1;
             }
         }
     }
 
-#if 0
-    Dump(stdout, "GETSTRING", *str, strlen(*str));
-#endif
+    RAISE(JSON_EOF);
 
 done:
     return result;
 }
 
-static int _expect(json_parser_t* parser, const char* str, size_t len)
-{
-    if (parser->end - parser->ptr >= (ptrdiff_t)len &&
-        memcmp(parser->ptr, str, len) == 0)
-    {
-        parser->ptr += len;
-        return 0;
-    }
-
-    return -1;
-}
-
-static json_result_t _get_value(json_parser_t* parser);
-
 static json_result_t _get_array(json_parser_t* parser, size_t* array_size)
 {
     json_result_t result = JSON_OK;
@@ -413,15 +443,28 @@ done:
     return result;
 }
 
-static int strtou64(uint64_t* x, const char* str)
+/* Convert a name that consists only of decimal digits to an integer */
+static int _slice_to_u64(const json_slice_t* slice, uint64_t* x)
 {
-    char* end;
+    uint64_t n = 0;
 
-    *x = strtoul(str, &end, 10);
-
-    if (!end || *end != '\0')
+    if (slice->size == 0)
         return -1;
 
+    for (size_t i = 0; i < slice->size; i++)
+    {
+        const char c = slice->data[i];
+
+        if (c < '0' || c > '9')
+            return -1;
+
+        if (n > (UINT64_MAX - (uint64_t)(c - '0')) / 10)
+            return -1;
+
+        n = n * 10 + (uint64_t)(c - '0');
+    }
+
+    *x = n;
     return 0;
 }
 
@@ -457,14 +500,14 @@ static json_result_t _get_object(json_parser_t* parser)
             json_union_t un;
 
             /* Get name */
-            CHECK(_get_string(parser, (char**)&un.string));
+            CHECK(_get_string(parser, &un.slice));
 
             /* Insert node */
             {
                 uint64_t n;
-                json_node_t node = {un.string, 0, 0, 0};
+                json_node_t node = {un.string, 0, 0, 0, un.slice.size};
 
-                if (strtou64(&n, un.string) == 0)
+                if (_slice_to_u64(&un.slice, &n) == 0)
                     node.number = n;
                 else
                     node.number = UINT64_MAX;
@@ -566,7 +609,6 @@ static json_result_t _get_value(json_parser_t* parser)
 {
     json_result_t result = JSON_OK;
     char c;
-    json_parser_t* scanner = NULL;
 
     /* Skip whitespace */
     CHECK(skip_whitespace(parser));
@@ -634,18 +676,9 @@ static json_result_t _get_value(json_parser_t* parser)
             {
                 size_t array_size = 0;
 
-                if (!(scanner = _malloc(parser, sizeof(json_parser_t))))
-                    RAISE(JSON_OUT_OF_MEMORY);
-
-                memcpy(scanner, parser, sizeof(json_parser_t));
-                scanner->scan = 1;
-
-                if (_get_array(scanner, &array_size) != JSON_OK)
+                if (_count_array_elements(parser, &array_size) != JSON_OK)
                     RAISE(JSON_BAD_SYNTAX);
 
-                _free(parser, scanner);
-                scanner = NULL;
-
                 un.integer = (signed long long)array_size;
 
                 parser->path[parser->depth - 1].size = array_size;
@@ -666,7 +699,7 @@ static json_result_t _get_value(json_parser_t* parser)
         {
             json_union_t un;
 
-            if (_get_string(parser, (char**)&un.string) != JSON_OK)
+            if (_get_string(parser, &un.slice) != JSON_OK)
                 RAISE(JSON_BAD_SYNTAX);
 
             CHECK(_invoke_callback(
@@ -689,10 +722,6 @@ static json_result_t _get_value(json_parser_t* parser)
     }
 
 done:
-
-    if (scanner)
-        _free(parser, scanner);
-
     return result;
 }
 
@@ -763,35 +792,21 @@ done:
 json_result_t json_match(json_parser_t* parser, const char* pattern)
 {
     json_result_t result = JSON_UNEXPECTED;
-    char buf[256];
-    char* ptr = NULL;
-    const char* pattern_path[JSON_MAX_NESTING];
-    size_t pattern_depth = 0;
-    unsigned long n = 0;
-    size_t pattern_len;
+    size_t pattern_depth = 1;
+    const char* p;
 
     if (!parser || !pattern)
         RAISE(JSON_BAD_PARAMETER);
 
-    /* Make a copy of the pattern that can be modified */
+    /* Count the elements of the pattern */
+    for (p = pattern; *p; p++)
     {
-        pattern_len = strlen(pattern);
-
-        if (pattern_len < sizeof(buf))
-            ptr = buf;
-        else if (!(ptr = _malloc(parser, pattern_len + 1)))
-            RAISE(JSON_OUT_OF_MEMORY);
-
-        *ptr = '\0';
-        strncat(ptr, pattern, pattern_len);
+        if (*p == '.')
+            pattern_depth++;
     }
 
-    /* Split the pattern into tokens */
-    if ((pattern_depth = _split(ptr, '.', pattern_path, JSON_MAX_NESTING)) ==
-        (size_t)-1)
-    {
+    if (pattern_depth > JSON_MAX_NESTING)
         RAISE(JSON_NESTING_OVERFLOW);
-    }
 
     /* Return false if the path sizes are different */
     if (parser->depth != pattern_depth)
@@ -800,31 +815,199 @@ json_result_t json_match(json_parser_t* parser, const char* pattern)
         goto done;
     }
 
-    /* Compare the elements */
+    /* Compare the elements (without copying the pattern) */
+    p = pattern;
+
     for (size_t i = 0; i < pattern_depth; i++)
     {
-        if (strcmp(pattern_path[i], "#") == 0)
+        const json_node_t* node = &parser->path[i];
+        size_t len = 0;
+
+        while (p[len] && p[len] != '.')
+            len++;
+
+        if (len == 1 && *p == '#')
         {
-            if (strtou64(&n, parser->path[i].name) != 0)
+            if (node->number == UINT64_MAX)
                 RAISE(JSON_TYPE_MISMATCH);
         }
-        else if (strcmp(pattern_path[i], parser->path[i].name) != 0)
+        else if (len != node->name_size || memcmp(p, node->name, len) != 0)
         {
             result = JSON_NO_MATCH;
             goto done;
         }
+
+        p += len + 1;
     }
 
     result = JSON_OK;
 
 done:
+    return result;
+}
+
+json_result_t json_slice_unescape(
+    const json_slice_t* slice,
+    char* buf,
+    size_t buf_size)
+{
+    json_result_t result = JSON_UNEXPECTED;
+    json_parser_t* parser = NULL;
+    size_t size;
+
+    if (!slice || (!slice->data && slice->size) || !buf || !buf_size)
+        RAISE(JSON_BAD_PARAMETER);
 
-    if (ptr && ptr != buf)
-        _free(parser, ptr);
+    /* Leave room for the zero-terminator */
+    size = buf_size - 1;
+    CHECK(_unescape(parser, slice->data, slice->size, buf, &size));
+    buf[size] = '\0';
 
+    result = JSON_OK;
+
+done:
     return result;
 }
 
+/*
+**==============================================================================
+**
+** json_trie_t:
+**
+**==============================================================================
+*/
+
+static long _trie_new_node(json_trie_t* trie, const char* name, size_t size)
+{
+    json_trie_node_t* node;
+
+    if (trie->num_nodes == trie->max_nodes)
+        return -1;
+
+    node = &trie->nodes[trie->num_nodes];
+    node->name = name;
+    node->name_size = size;
+    node->child = -1;
+    node->sibling = -1;
+    node->id = -1;
+
+    return (long)trie->num_nodes++;
+}
+
+json_result_t json_trie_init(
+    json_trie_t* trie,
+    json_trie_node_t* nodes,
+    size_t max_nodes)
+{
+    if (!trie || !nodes || !max_nodes)
+        return JSON_BAD_PARAMETER;
+
+    trie->nodes = nodes;
+    trie->num_nodes = 0;
+    trie->max_nodes = max_nodes;
+
+    /* node 0 is the root (the empty path) */
+    _trie_new_node(trie, "", 0);
+
+    return JSON_OK;
+}
+
+json_result_t json_trie_add(json_trie_t* trie, const char* pattern, long id)
+{
+    long parent = 0;
+    const char* p = pattern;
+    size_t depth = 0;
+
+    if (!trie || !trie->nodes || !pattern || id < 0)
+        return JSON_BAD_PARAMETER;
+
+    for (;;)
+    {
+        size_t len = 0;
+        long index;
+
+        while (p[len] && p[len] != '.')
+            len++;
+
+        if (++depth > JSON_MAX_NESTING)
+            return JSON_NESTING_OVERFLOW;
+
+        /* Find the child with this name */
+        for (index = trie->nodes[parent].child; index != -1;
+             index = trie->nodes[index].sibling)
+        {
+            const json_trie_node_t* node = &trie->nodes[index];
+
+            if (node->name_size == len && memcmp(node->name, p, len) == 0)
+                break;
+        }
+
+        /* Or append a new child */
+        if (index == -1)
+        {
+            if ((index = _trie_new_node(trie, p, len)) == -1)
+                return JSON_BUFFER_OVERFLOW;
+
+            trie->nodes[index].sibling = trie->nodes[parent].child;
+            trie->nodes[parent].child = index;
+        }
+
+        parent = index;
+
+        if (!p[len])
+            break;
+
+        p += len + 1;
+    }
+
+    if (trie->nodes[parent].id != -1)
+        return JSON_BAD_PARAMETER;
+
+    trie->nodes[parent].id = id;
+
+    return JSON_OK;
+}
+
+long json_trie_match(const json_trie_t* trie, const json_parser_t* parser)
+{
+    long index = 0;
+
+    if (!trie || !trie->nodes || !trie->num_nodes || !parser)
+        return -1;
+
+    for (size_t i = 0; i < parser->depth; i++)
+    {
+        const json_node_t* elem = &parser->path[i];
+        long wildcard = -1;
+        long child;
+
+        for (child = trie->nodes[index].child; child != -1;
+             child = trie->nodes[child].sibling)
+        {
+            const json_trie_node_t* node = &trie->nodes[child];
+
+            if (node->name_size == elem->name_size &&
+                memcmp(node->name, elem->name, elem->name_size) == 0)
+            {
+                break;
+            }
+
+            if (node->name_size == 1 && node->name[0] == '#' &&
+                elem->number != UINT64_MAX)
+            {
+                wildcard = child;
+            }
+        }
+
+        if (child == -1 && (child = wildcard) == -1)
+            return -1;
+
+        index = child;
+    }
+
+    return trie->nodes[index].id;
+}
+
 const char* json_result_string(json_result_t result)
 {
     switch (result)
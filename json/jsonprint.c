@@ -274,7 +274,7 @@ json_result_t json_print(
     json_parser_t parser_buf;
     json_parser_t* parser = &parser_buf;
     callback_data_t callback_data = {0, 0, 0, write, stream};
-    json_parser_options_t options;
+    json_parser_options_t options = {0};
 
     extern int printf(const char* fmt, ...);
     memset(&parser_buf, 0, sizeof(parser_buf));
@@ -334,8 +334,7 @@ void json_dump_path(json_write_t write, void* stream, json_parser_t* parser)
 
         for (size_t i = 0; i < depth; i++)
         {
-            (*write)(
-                stream, parser->path[i].name, strlen(parser->path[i].name));
+            (*write)(stream, parser->path[i].name, parser->path[i].name_size);
 
             if (parser->path[i].size)
             {
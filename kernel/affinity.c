@@ -8,6 +8,7 @@
 #include <myst/eraise.h>
 #include <myst/kernel.h>
 #include <myst/mmanutils.h>
+#include <myst/numa.h>
 #include <myst/syscall.h>
 #include <myst/thread.h>
 
@@ -97,8 +98,13 @@ long myst_syscall_getcpu(unsigned* cpu, unsigned* node)
 {
     long ret = 0;
 
-    long params[6] = {(long)cpu, (long)node, (long)NULL};
-    ECHECK((ret = myst_tcall(SYS_getcpu, params)));
+    if (cpu && myst_is_bad_addr_write(cpu, sizeof(unsigned)))
+        ERAISE(-EFAULT);
+
+    if (node && myst_is_bad_addr_write(node, sizeof(unsigned)))
+        ERAISE(-EFAULT);
+
+    ECHECK((ret = myst_numa_getcpu(cpu, node)));
 
 done:
     return ret;
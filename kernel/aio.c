@@ -0,0 +1,800 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <assert.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+
+#include <myst/aio.h>
+#include <myst/cond.h>
+#include <myst/eraise.h>
+#include <myst/fdtable.h>
+#include <myst/futex.h>
+#include <myst/mutex.h>
+#include <myst/process.h>
+#include <myst/syscall.h>
+#include <myst/thread.h>
+#include <myst/times.h>
+
+#define MYST_AIO_CONTEXT_MAGIC 0x8f7c2e5b61a04d93
+
+/* largest number of events per context (same as the Linux aio-max-nr) */
+#define MAX_EVENTS 65536
+
+/* largest number of contiguous requests merged into a single transfer */
+#define MAX_BATCH 16
+
+typedef struct request request_t;
+
+typedef struct context context_t;
+
+struct request
+{
+    request_t* next;
+    context_t* ctx;
+    struct iocb* user_iocb; /* reported in io_event.obj */
+    struct iocb iocb;       /* private copy of the caller's iocb */
+};
+
+struct context
+{
+    /* The first words mirror the header of the Linux AIO ring, whose address
+     * is the aio_context_t. libaio reads completions straight from the ring
+     * when the magic field matches; leaving it zero makes it fall back to
+     * io_getevents().
+     */
+    struct
+    {
+        uint32_t id;
+        uint32_t nr;
+        uint32_t head;
+        uint32_t tail;
+        uint32_t magic;
+        uint32_t compat_features;
+        uint32_t incompat_features;
+        uint32_t header_length;
+    } ring;
+
+    uint64_t magic;
+    context_t* next;
+
+    /* requests submitted but not yet completed */
+    size_t num_pending;
+
+    /* circular buffer of completions */
+    struct io_event* events;
+    size_t max_events;
+    size_t head;
+    size_t count;
+
+    /* signaled when a request completes (or the context is destroyed) */
+    myst_cond_t cond;
+
+    /* threads waiting in io_getevents() */
+    size_t num_waiters;
+
+    bool destroying;
+};
+
+/* the requests carried out together by a worker */
+typedef struct batch
+{
+    size_t count;
+    request_t* reqs[MAX_BATCH];
+    long res[MAX_BATCH];
+    struct iovec iov[MAX_BATCH];
+} batch_t;
+
+typedef struct myst_aio
+{
+    /* protects all fields below (and all contexts) */
+    myst_mutex_t mutex;
+
+    /* signaled when requests are queued */
+    myst_cond_t cond;
+
+    /* the queue of submitted requests */
+    request_t* head;
+    request_t* tail;
+
+    context_t* contexts;
+
+    _Atomic(size_t) num_workers;
+} myst_aio_t;
+
+static bool _valid_context(context_t* ctx)
+{
+    return ctx && ctx->magic == MYST_AIO_CONTEXT_MAGIC;
+}
+
+/* find the context (caller holds the mutex) */
+static context_t* _find_context(myst_aio_t* aio, aio_context_t ctx_id)
+{
+    for (context_t* p = aio->contexts; p; p = p->next)
+    {
+        if ((aio_context_t)p == ctx_id && _valid_context(p))
+            return p;
+    }
+
+    return NULL;
+}
+
+/* set up the process state, asking the CRT to create the workers first */
+static long _init_aio(myst_process_t* process)
+{
+    bool wanted_status = false;
+
+    if (__atomic_compare_exchange_n(
+            &process->aio_threads_requested,
+            &wanted_status,
+            true,
+            false,
+            __ATOMIC_RELEASE,
+            __ATOMIC_ACQUIRE))
+    {
+        myst_aio_t* aio;
+
+        if (!(aio = calloc(1, sizeof(myst_aio_t))))
+        {
+            process->aio_threads_requested = false;
+            return -ENOMEM;
+        }
+
+        __atomic_store_n(&process->aio, aio, __ATOMIC_RELEASE);
+
+        /* have the CRT launch the worker threads and call again */
+        return -MYST_ENEEDTHREADS;
+    }
+
+    /* wait for the aio state and for at least one worker to start */
+    while (!__atomic_load_n(&process->aio, __ATOMIC_ACQUIRE) ||
+           process->aio->num_workers == 0)
+    {
+        __asm__ __volatile__("pause" : : : "memory");
+    }
+
+    return 0;
+}
+
+long myst_syscall_io_setup(
+    myst_process_t* process,
+    unsigned int nr_events,
+    aio_context_t* ctx_idp)
+{
+    long ret = 0;
+    myst_aio_t* aio;
+    context_t* ctx = NULL;
+
+    if (!ctx_idp)
+        ERAISE(-EFAULT);
+
+    /* the caller must zero the context identifier */
+    if (*ctx_idp != 0 || nr_events == 0)
+        ERAISE(-EINVAL);
+
+    if (nr_events > MAX_EVENTS)
+        ERAISE(-EAGAIN);
+
+    /* (may ask the CRT to start the workers and call again) */
+    if ((ret = _init_aio(process)) != 0)
+        goto done;
+    aio = process->aio;
+
+    if (!(ctx = calloc(1, sizeof(context_t))))
+        ERAISE(-ENOMEM);
+
+    if (!(ctx->events = calloc(nr_events, sizeof(struct io_event))))
+        ERAISE(-ENOMEM);
+
+    ctx->ring.nr = nr_events;
+    ctx->ring.header_length = sizeof(ctx->ring);
+    ctx->magic = MYST_AIO_CONTEXT_MAGIC;
+    ctx->max_events = nr_events;
+
+    myst_mutex_lock(&aio->mutex);
+    ctx->next = aio->contexts;
+    aio->contexts = ctx;
+    myst_mutex_unlock(&aio->mutex);
+
+    *ctx_idp = (aio_context_t)ctx;
+    ctx = NULL;
+
+done:
+
+    if (ctx)
+    {
+        free(ctx->events);
+        free(ctx);
+    }
+
+    return ret;
+}
+
+long myst_syscall_io_destroy(myst_process_t* process, aio_context_t ctx_id)
+{
+    long ret = 0;
+    myst_aio_t* aio = process->aio;
+    context_t* ctx;
+    bool locked = false;
+
+    if (!aio)
+        ERAISE(-EINVAL);
+
+    myst_mutex_lock(&aio->mutex);
+    locked = true;
+
+    if (!(ctx = _find_context(aio, ctx_id)) || ctx->destroying)
+        ERAISE(-EINVAL);
+
+    ctx->destroying = true;
+
+    /* wake the io_getevents() callers, which then return */
+    myst_cond_broadcast(&ctx->cond, SIZE_MAX, FUTEX_BITSET_MATCH_ANY);
+
+    /* like Linux, wait for the requests in flight to complete */
+    while (ctx->num_pending || ctx->num_waiters)
+        myst_cond_wait_no_signal_processing(&ctx->cond, &aio->mutex);
+
+    for (context_t** p = &aio->contexts; *p; p = &(*p)->next)
+    {
+        if (*p == ctx)
+        {
+            *p = ctx->next;
+            break;
+        }
+    }
+
+    ctx->magic = 0;
+    free(ctx->events);
+    free(ctx);
+
+done:
+
+    if (locked)
+        myst_mutex_unlock(&aio->mutex);
+
+    return ret;
+}
+
+static long _check_iocb(const struct iocb* iocb)
+{
+    long ret = 0;
+    myst_fdtable_type_t type;
+    void* device;
+    void* object;
+
+    if (iocb->aio_reserved2 || (iocb->aio_flags & ~(uint32_t)IOCB_FLAG_RESFD))
+        ERAISE_QUIET(-EINVAL);
+
+    switch (iocb->aio_lio_opcode)
+    {
+        case IOCB_CMD_PREAD:
+        case IOCB_CMD_PWRITE:
+        case IOCB_CMD_PREADV:
+        case IOCB_CMD_PWRITEV:
+        {
+            if (!iocb->aio_buf && iocb->aio_nbytes)
+                ERAISE_QUIET(-EFAULT);
+
+            if (iocb->aio_offset < 0)
+                ERAISE_QUIET(-EINVAL);
+
+            break;
+        }
+        case IOCB_CMD_FSYNC:
+        case IOCB_CMD_FDSYNC:
+        case IOCB_CMD_NOOP:
+        {
+            break;
+        }
+        default:
+        {
+            /* IOCB_CMD_POLL is not supported */
+            ERAISE_QUIET(-EINVAL);
+        }
+    }
+
+    if (myst_fdtable_get_any(
+            myst_fdtable_current(),
+            (int)iocb->aio_fildes,
+            &type,
+            &device,
+            &object) != 0)
+    {
+        ERAISE_QUIET(-EBADF);
+    }
+
+done:
+    return ret;
+}
+
+/* queue a request (the caller holds the mutex) */
+static long _enqueue(myst_aio_t* aio, context_t* ctx, struct iocb* iocb)
+{
+    long ret = 0;
+    request_t* req;
+
+    if (!iocb)
+        ERAISE_QUIET(-EFAULT);
+
+    if ((ret = _check_iocb(iocb)) != 0)
+        goto done;
+
+    /* leave room in the ring for every pending completion */
+    if (ctx->num_pending + ctx->count >= ctx->max_events)
+        ERAISE_QUIET(-EAGAIN);
+
+    if (!(req = calloc(1, sizeof(request_t))))
+        ERAISE(-ENOMEM);
+
+    req->ctx = ctx;
+    req->user_iocb = iocb;
+    req->iocb = *iocb;
+
+    if (aio->tail)
+        aio->tail->next = req;
+    else
+        aio->head = req;
+
+    aio->tail = req;
+    ctx->num_pending++;
+
+done:
+    return ret;
+}
+
+long myst_syscall_io_submit(
+    myst_process_t* process,
+    aio_context_t ctx_id,
+    long nr,
+    struct iocb** iocbpp)
+{
+    long ret = 0;
+    myst_aio_t* aio = process->aio;
+    context_t* ctx;
+    long i;
+    bool locked = false;
+
+    if (!aio || nr < 0)
+        ERAISE(-EINVAL);
+
+    if (nr && !iocbpp)
+        ERAISE(-EFAULT);
+
+    myst_mutex_lock(&aio->mutex);
+    locked = true;
+
+    if (!(ctx = _find_context(aio, ctx_id)) || ctx->destroying)
+        ERAISE(-EINVAL);
+
+    for (i = 0; i < nr; i++)
+    {
+        long r;
+
+        if ((r = _enqueue(aio, ctx, iocbpp[i])) != 0)
+        {
+            /* report the error only if no request was queued */
+            if (i == 0)
+                ERAISE_QUIET(r);
+
+            break;
+        }
+    }
+
+    if (i > 0)
+        myst_cond_broadcast(&aio->cond, (size_t)i, FUTEX_BITSET_MATCH_ANY);
+
+    ret = i;
+
+done:
+
+    if (locked)
+        myst_mutex_unlock(&aio->mutex);
+
+    return ret;
+}
+
+long myst_syscall_io_cancel(
+    myst_process_t* process,
+    aio_context_t ctx_id,
+    struct iocb* iocb,
+    struct io_event* result)
+{
+    long ret = 0;
+    myst_aio_t* aio = process->aio;
+    bool locked = false;
+    request_t* prev = NULL;
+
+    (void)result;
+
+    if (!aio)
+        ERAISE(-EINVAL);
+
+    if (!iocb)
+        ERAISE(-EFAULT);
+
+    myst_mutex_lock(&aio->mutex);
+    locked = true;
+
+    if (!_find_context(aio, ctx_id))
+        ERAISE(-EINVAL);
+
+    /* a request still in the queue is cancelled with -ECANCELED */
+    for (request_t* p = aio->head; p; prev = p, p = p->next)
+    {
+        if (p->user_iocb == iocb && (aio_context_t)p->ctx == ctx_id)
+        {
+            context_t* ctx = p->ctx;
+            struct io_event* ev;
+
+            if (prev)
+                prev->next = p->next;
+            else
+                aio->head = p->next;
+
+            if (aio->tail == p)
+                aio->tail = prev;
+
+            /* like Linux, the completion is delivered through the ring */
+            ev = &ctx->events[(ctx->head + ctx->count) % ctx->max_events];
+            ev->data = p->iocb.aio_data;
+            ev->obj = (uint64_t)p->user_iocb;
+            ev->res = -ECANCELED;
+            ev->res2 = 0;
+            ctx->count++;
+            ctx->num_pending--;
+            myst_cond_broadcast(&ctx->cond, SIZE_MAX, FUTEX_BITSET_MATCH_ANY);
+
+            free(p);
+
+            /* like Linux, report that the completion is in the ring */
+            ret = -EINPROGRESS;
+            goto done;
+        }
+    }
+
+    /* the request is executing or has completed */
+    ERAISE_QUIET(-EAGAIN);
+
+done:
+
+    if (locked)
+        myst_mutex_unlock(&aio->mutex);
+
+    return ret;
+}
+
+long myst_syscall_io_getevents(
+    myst_process_t* process,
+    aio_context_t ctx_id,
+    long min_nr,
+    long nr,
+    struct io_event* events,
+    struct timespec* timeout)
+{
+    long ret = 0;
+    myst_aio_t* aio = process->aio;
+    context_t* ctx;
+    long n = 0;
+    struct timespec start;
+    bool locked = false;
+
+    if (!aio || min_nr < 0 || nr < 0 || min_nr > nr)
+        ERAISE(-EINVAL);
+
+    if (nr && !events)
+        ERAISE(-EFAULT);
+
+    if (timeout && !is_timespec_valid(timeout))
+        ERAISE(-EINVAL);
+
+    if (timeout)
+        myst_syscall_clock_gettime(CLOCK_MONOTONIC, &start);
+
+    myst_mutex_lock(&aio->mutex);
+    locked = true;
+
+    if (!(ctx = _find_context(aio, ctx_id)) || ctx->destroying)
+        ERAISE(-EINVAL);
+
+    ctx->num_waiters++;
+
+    for (;;)
+    {
+        struct timespec now;
+        struct timespec rem;
+        long lapsed;
+        int r;
+
+        /* harvest the available completions */
+        while (n < nr && ctx->count)
+        {
+            events[n++] = ctx->events[ctx->head];
+            ctx->head = (ctx->head + 1) % ctx->max_events;
+            ctx->count--;
+        }
+
+        if (n >= min_nr || n == nr)
+            break;
+
+        if (!timeout)
+        {
+            r = myst_cond_wait_no_signal_processing(&ctx->cond, &aio->mutex);
+        }
+        else
+        {
+            myst_syscall_clock_gettime(CLOCK_MONOTONIC, &now);
+            lapsed = myst_lapsed_nsecs(&start, &now);
+
+            if (lapsed >= timespec_to_nanos(timeout))
+                break;
+
+            nanos_to_timespec(&rem, timespec_to_nanos(timeout) - lapsed);
+            r = myst_cond_timedwait(
+                &ctx->cond, &aio->mutex, &rem, FUTEX_BITSET_MATCH_ANY);
+        }
+
+        /* return the events collected so far when interrupted */
+        if (r == -EINTR && n == 0)
+            ret = -EINTR;
+
+        if (r == -EINTR || ctx->destroying)
+            break;
+    }
+
+    /* let io_destroy() proceed once the last waiter is gone */
+    if (--ctx->num_waiters == 0 && ctx->destroying)
+        myst_cond_broadcast(&ctx->cond, SIZE_MAX, FUTEX_BITSET_MATCH_ANY);
+
+    if (ret == 0)
+        ret = n;
+
+done:
+
+    if (locked)
+        myst_mutex_unlock(&aio->mutex);
+
+    return ret;
+}
+
+/* whether next continues the transfer of req (so they can be merged) */
+static bool _mergeable(const request_t* req, const request_t* next)
+{
+    const struct iocb* a = &req->iocb;
+    const struct iocb* b = &next->iocb;
+
+    if (a->aio_lio_opcode != IOCB_CMD_PREAD &&
+        a->aio_lio_opcode != IOCB_CMD_PWRITE)
+    {
+        return false;
+    }
+
+    return b->aio_lio_opcode == a->aio_lio_opcode &&
+           b->aio_fildes == a->aio_fildes &&
+           b->aio_offset == a->aio_offset + (int64_t)a->aio_nbytes;
+}
+
+/* Dequeue the next request along with the queued requests that continue it
+ * (same fd and operation, contiguous offsets) so that they can be carried out
+ * by a single (host) call. The caller holds the mutex.
+ */
+static size_t _dequeue(myst_aio_t* aio, batch_t* batch)
+{
+    batch->count = 0;
+
+    while (aio->head && batch->count < MAX_BATCH)
+    {
+        request_t* req = aio->head;
+        const size_t n = batch->count;
+
+        if (n > 0 && !_mergeable(batch->reqs[n - 1], req))
+            break;
+
+        if ((aio->head = req->next) == NULL)
+            aio->tail = NULL;
+
+        req->next = NULL;
+        batch->reqs[batch->count++] = req;
+    }
+
+    return batch->count;
+}
+
+static long _execute(const struct iocb* iocb)
+{
+    const int fd = (int)iocb->aio_fildes;
+    void* buf = (void*)iocb->aio_buf;
+    const size_t count = (size_t)iocb->aio_nbytes;
+    const off_t offset = (off_t)iocb->aio_offset;
+
+    switch (iocb->aio_lio_opcode)
+    {
+        case IOCB_CMD_PREAD:
+            return myst_syscall_pread(fd, buf, count, offset);
+        case IOCB_CMD_PWRITE:
+            return myst_syscall_pwrite(fd, buf, count, offset);
+        case IOCB_CMD_PREADV:
+            return myst_syscall_preadv2(fd, buf, (int)count, offset, 0);
+        case IOCB_CMD_PWRITEV:
+            return myst_syscall_pwritev2(fd, buf, (int)count, offset, 0);
+        case IOCB_CMD_FSYNC:
+            return myst_syscall_fsync(fd);
+        case IOCB_CMD_FDSYNC:
+            return myst_syscall_fdatasync(fd);
+        case IOCB_CMD_NOOP:
+            return 0;
+        default:
+            return -EINVAL;
+    }
+}
+
+/* carry out a batch of requests, storing their results in batch->res[] */
+static void _execute_batch(batch_t* batch)
+{
+    const size_t n = batch->count;
+    const struct iocb* first = &batch->reqs[0]->iocb;
+    long total;
+
+    if (n == 1)
+    {
+        batch->res[0] = _execute(first);
+        return;
+    }
+
+    for (size_t i = 0; i < n; i++)
+    {
+        batch->iov[i].iov_base = (void*)batch->reqs[i]->iocb.aio_buf;
+        batch->iov[i].iov_len = batch->reqs[i]->iocb.aio_nbytes;
+    }
+
+    if (first->aio_lio_opcode == IOCB_CMD_PREAD)
+    {
+        total = myst_syscall_preadv2(
+            (int)first->aio_fildes, batch->iov, (int)n, first->aio_offset, 0);
+    }
+    else
+    {
+        total = myst_syscall_pwritev2(
+            (int)first->aio_fildes, batch->iov, (int)n, first->aio_offset, 0);
+    }
+
+    /* split the result across the requests (in offset order) */
+    for (size_t i = 0; i < n; i++)
+    {
+        if (total < 0)
+        {
+            batch->res[i] = total;
+        }
+        else
+        {
+            size_t m = batch->iov[i].iov_len;
+
+            if (m > (size_t)total)
+                m = (size_t)total;
+
+            batch->res[i] = (long)m;
+            total -= (long)m;
+        }
+    }
+}
+
+static void _notify(int resfd)
+{
+    const uint64_t one = 1;
+
+    /* errors are ignored, as on Linux */
+    myst_syscall_write(resfd, &one, sizeof(one));
+}
+
+/* post the completions of a batch (the caller holds the mutex) */
+static void _complete(batch_t* batch)
+{
+    for (size_t i = 0; i < batch->count; i++)
+    {
+        request_t* req = batch->reqs[i];
+        context_t* ctx = req->ctx;
+        struct io_event* ev;
+
+        /* io_submit() reserved a slot for every pending request */
+        assert(ctx->count < ctx->max_events);
+
+        ev = &ctx->events[(ctx->head + ctx->count) % ctx->max_events];
+        ev->data = req->iocb.aio_data;
+        ev->obj = (uint64_t)req->user_iocb;
+        ev->res = batch->res[i];
+        ev->res2 = 0;
+        ctx->count++;
+        ctx->num_pending--;
+
+        myst_cond_broadcast(&ctx->cond, SIZE_MAX, FUTEX_BITSET_MATCH_ANY);
+    }
+}
+
+/* Body of the worker threads (created by the CRT). Never returns. */
+long myst_syscall_run_aio(myst_process_t* process)
+{
+    myst_aio_t* aio;
+    batch_t* batch;
+
+    while (!(aio = __atomic_load_n(&process->aio, __ATOMIC_ACQUIRE)))
+        __asm__ __volatile__("pause" : : : "memory");
+
+    if (!(batch = malloc(sizeof(batch_t))))
+        return -ENOMEM;
+
+    myst_mutex_lock(&aio->mutex);
+
+    /* the CRT may start more workers than needed (see io_setup()) */
+    if (aio->num_workers == MYST_AIO_NUM_WORKERS)
+    {
+        myst_mutex_unlock(&aio->mutex);
+        free(batch);
+        return 0;
+    }
+
+    aio->num_workers++;
+
+    for (;;)
+    {
+        if (_dequeue(aio, batch) == 0)
+        {
+            myst_cond_wait(&aio->cond, &aio->mutex);
+            continue;
+        }
+
+        myst_mutex_unlock(&aio->mutex);
+        _execute_batch(batch);
+        myst_mutex_lock(&aio->mutex);
+
+        _complete(batch);
+
+        myst_mutex_unlock(&aio->mutex);
+        {
+            /* signal the eventfds once the events can be harvested */
+            for (size_t i = 0; i < batch->count; i++)
+            {
+                const struct iocb* iocb = &batch->reqs[i]->iocb;
+
+                if (iocb->aio_flags & IOCB_FLAG_RESFD)
+                    _notify((int)iocb->aio_resfd);
+
+                free(batch->reqs[i]);
+            }
+        }
+        myst_mutex_lock(&aio->mutex);
+    }
+
+    /* unreachable */
+    myst_mutex_unlock(&aio->mutex);
+    free(batch);
+    return 0;
+}
+
+void myst_aio_free(myst_process_t* process)
+{
+    myst_aio_t* aio = process->aio;
+
+    if (!aio)
+        return;
+
+    for (request_t* p = aio->head; p;)
+    {
+        request_t* next = p->next;
+        free(p);
+        p = next;
+    }
+
+    for (context_t* p = aio->contexts; p;)
+    {
+        context_t* next = p->next;
+        free(p->events);
+        free(p);
+        p = next;
+    }
+
+    free(aio);
+    process->aio = NULL;
+}
@@ -3,13 +3,93 @@
 #include <sys/sendfile.h>
 
 #include <myst/eraise.h>
+#include <myst/fdtable.h>
+#include <myst/hostfs.h>
 #include <myst/syscall.h>
+#include <myst/tcall.h>
+
+/* size of the bounce buffer used when the host cannot do the copy */
+#define CHUNK_SIZE (64 * 1024)
 
 MYST_INLINE size_t _min(size_t x, size_t y)
 {
     return (x < y) ? x : y;
 }
 
+/* Let the host copy the data when both fds are hostfs files. Returns
+ * -ENOTSUP if the caller must copy the data itself.
+ */
+static long _host_copy_file_range(
+    int fd_in,
+    off_t* off_in,
+    int fd_out,
+    off_t* off_out,
+    size_t len,
+    unsigned int flags)
+{
+    long ret = 0;
+    myst_fdtable_t* fdtable = myst_fdtable_current();
+    const uint32_t types = MYST_FDTABLE_MASK(MYST_FDTABLE_TYPE_FILE);
+    void* out_device;
+    int host_fd_in;
+    int host_fd_out;
+    off_t in = off_in ? *off_in : 0;
+    off_t out = off_out ? *off_out : 0;
+    long n;
+
+    host_fd_in = myst_fdtable_get_host_fd(fdtable, fd_in, types, NULL, NULL);
+
+    if (host_fd_in < 0)
+        ERAISE_QUIET(host_fd_in);
+
+    host_fd_out =
+        myst_fdtable_get_host_fd(fdtable, fd_out, types, NULL, &out_device);
+
+    if (host_fd_out < 0)
+        ERAISE_QUIET(host_fd_out);
+
+    {
+        long params[6] = {
+            host_fd_in,
+            off_in ? (long)&in : 0,
+            host_fd_out,
+            off_out ? (long)&out : 0,
+            (long)len,
+            flags,
+        };
+
+        n = myst_tcall(SYS_copy_file_range, params);
+
+        /* older host kernels refuse some copies that the kernel path handles */
+        if (n == -EXDEV || n == -ENOSYS || n == -EOPNOTSUPP)
+            ERAISE_QUIET(-ENOTSUP);
+
+        ECHECK(n);
+    }
+
+    if ((size_t)n > len || (off_in && in != *off_in + n) ||
+        (off_out && out != *off_out + n))
+    {
+        ERAISE(-EIO);
+    }
+
+#ifdef MYST_ENABLE_HOSTFS
+    if (n > 0)
+        myst_hostfs_invalidate(out_device);
+#endif
+
+    if (off_in)
+        *off_in = in;
+
+    if (off_out)
+        *off_out = out;
+
+    ret = n;
+
+done:
+    return ret;
+}
+
 long myst_syscall_copy_file_range(
     int fd_in,
     off_t* off_in,
@@ -20,11 +100,7 @@ long myst_syscall_copy_file_range(
 {
     long ret = 0;
     ssize_t nwritten = 0;
-    struct locals
-    {
-        char buf[BUFSIZ];
-    };
-    struct locals* locals = NULL;
+    char* buf = NULL;
 
     if (flags != 0)
         ERAISE(-EINVAL);
@@ -39,6 +115,13 @@ long myst_syscall_copy_file_range(
         (off_out < off_in && off_in < off_out + len))
         ERAISE(-EINVAL);
 
+    ret = _host_copy_file_range(fd_in, off_in, fd_out, off_out, len, flags);
+
+    if (ret != -ENOTSUP)
+        goto done;
+
+    ret = 0;
+
     struct stat sbuf_in;
     struct stat sbuf_out;
     ECHECK(fstat(fd_in, &sbuf_in));
@@ -52,7 +135,7 @@ long myst_syscall_copy_file_range(
     if (out_flags & O_APPEND)
         ERAISE(-EBADF);
 
-    if (!(locals = malloc(sizeof(struct locals))))
+    if (!(buf = malloc(CHUNK_SIZE)))
         ERAISE(-ENOMEM);
 
     off_t cur_off_in;
@@ -82,10 +165,14 @@ long myst_syscall_copy_file_range(
         size_t r = len;
         while (r > 0)
         {
-            n = pread(fd_in, locals->buf, _min(r, BUFSIZ), cur_off_in);
-            ECHECK(n);
+            n = pread(fd_in, buf, _min(r, CHUNK_SIZE), cur_off_in);
+            ECHECK_ERRNO(n);
+
+            /* stop at the end of the input file */
+            if (n == 0)
+                break;
 
-            ssize_t m = pwrite(fd_out, locals->buf, n, cur_off_out);
+            ssize_t m = pwrite(fd_out, buf, n, cur_off_out);
             ECHECK_ERRNO(m);
 
             nwritten += m;
@@ -118,8 +205,8 @@ long myst_syscall_copy_file_range(
 
 done:
 
-    if (locals)
-        free(locals);
+    if (buf)
+        free(buf);
 
     return ret;
 }
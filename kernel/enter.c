@@ -8,6 +8,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <myst/aio.h>
 #include <myst/appenv.h>
 #include <myst/atexit.h>
 #include <myst/clock.h>
@@ -29,8 +30,10 @@
 #include <myst/initfini.h>
 #include <myst/kernel.h>
 #include <myst/limit.h>
+#include <myst/memops.h>
 #include <myst/mmanutils.h>
 #include <myst/mount.h>
+#include <myst/numa.h>
 #include <myst/options.h>
 #include <myst/panic.h>
 #include <myst/printf.h>
@@ -38,10 +41,12 @@
 #include <myst/procfs.h>
 #include <myst/pubkey.h>
 #include <myst/ramfs.h>
+#include <myst/shmfs.h>
 #include <myst/signal.h>
 #include <myst/stack.h>
 #include <myst/strings.h>
 #include <myst/syscall.h>
+#include <myst/sysfs.h>
 #include <myst/syslog.h>
 #include <myst/thread.h>
 #include <myst/time.h>
@@ -53,6 +58,9 @@
 
 static myst_fs_t* _fs;
 
+/* whether the rootfs was mounted from its index (rather than unpacked) */
+static bool _rootfs_indexed;
+
 long myst_tcall(long n, long params[6])
 {
     void* fs = NULL;
@@ -105,6 +113,32 @@ done:
     return ret;
 }
 
+/* load a host /etc file when it is first accessed */
+static int _load_host_etc_file(void* arg, myst_buf_t* buf)
+{
+    int ret = 0;
+    const char* path = (const char*)arg;
+    void* data = NULL;
+    size_t size;
+
+    /* the boot only checked the file, so report read failures here */
+    if ((ret = myst_load_host_file(path, &data, &size)) != 0)
+    {
+        myst_eprintf("kernel: failed to load host file %s: %d\n", path, ret);
+        ERAISE(ret);
+    }
+
+    if (myst_buf_append(buf, data, size) != 0)
+        ERAISE(-ENOMEM);
+
+done:
+
+    if (data)
+        free(data);
+
+    return ret;
+}
+
 static int _copy_host_etc_files()
 {
     int ret = 0;
@@ -113,8 +147,8 @@ static int _copy_host_etc_files()
     void* buf = NULL;
     size_t buf_size;
     struct stat statbuf;
-
-    ECHECK(myst_load_host_file(resolv_file, &buf, &buf_size));
+    char* suffix = NULL;
+    myst_fs_t* fs;
 
     if (stat(resolv_file, &statbuf) == 0)
     {
@@ -148,6 +182,34 @@ static int _copy_host_etc_files()
             }
         }
     }
+
+    /* Fail the boot if the host file is missing or unreadable, as before */
+    if ((ret = myst_check_host_file(resolv_file)) != 0)
+    {
+        myst_eprintf(
+            "kernel: cannot read host file %s: %d\n", resolv_file, ret);
+        ERAISE(ret);
+    }
+
+    /* On ramfs, defer loading the host file until it is first accessed */
+    if (!(suffix = malloc(PATH_MAX)))
+        ERAISE(-ENOMEM);
+
+    ECHECK(myst_mount_resolve(resolv_file, suffix, &fs));
+
+    ret = myst_ramfs_create_lazy_file(
+        fs, suffix, 0644, _load_host_etc_file, (void*)resolv_file);
+
+    if (ret == 0)
+        goto done;
+
+    if (ret != -ENOTSUP)
+        ERAISE(ret);
+
+    ret = 0;
+
+    ECHECK(myst_load_host_file(resolv_file, &buf, &buf_size));
+
     if ((fd = creat(resolv_file, 0644)) < 0)
     {
         myst_eprintf("kernel: failed to open file %s\n", resolv_file);
@@ -167,6 +229,9 @@ done:
     if (buf)
         free(buf);
 
+    if (suffix)
+        free(suffix);
+
     return ret;
 }
 
@@ -294,9 +359,10 @@ done:
     return ret;
 }
 
-static int _setup_ramfs(void)
+static int _setup_ramfs(const void* rootfs_data, size_t rootfs_size)
 {
     int ret = 0;
+    int r;
 
     if (myst_init_ramfs(myst_mount_resolve, &_fs) != 0)
     {
@@ -304,6 +370,12 @@ static int _setup_ramfs(void)
         ERAISE(-EINVAL);
     }
 
+    /* mount the CPIO archive directly if it was indexed at package time */
+    if ((r = myst_ramfs_load_index(_fs, rootfs_data, rootfs_size)) == 0)
+        _rootfs_indexed = true;
+    else if (r != -ENOENT)
+        myst_eprintf("kernel: ignoring bad rootfs index: %d\n", r);
+
     if (myst_mount(_fs, "/", "/", false) != 0)
     {
         myst_eprintf("cannot mount root file system\n");
@@ -574,7 +646,7 @@ static int _mount_rootfs(myst_kernel_args_t* args, myst_fstype_t fstype)
         case MYST_FSTYPE_RAMFS:
         {
             /* Setup the RAM file system */
-            if (_setup_ramfs() != 0)
+            if (_setup_ramfs(args->rootfs_data, args->rootfs_size) != 0)
             {
                 myst_eprintf(
                     "failed to setup RAMFS rootfs: %s\n", args->rootfs);
@@ -631,6 +703,58 @@ done:
     return ret;
 }
 
+/*
+**==============================================================================
+**
+** boot phases:
+**
+** With --perf, the time spent in each phase of booting is recorded and
+** printed with the total boot time. The first phase covers everything that
+** happens before the kernel is entered (measured from the start time passed
+** by the target).
+**
+**==============================================================================
+*/
+
+#define MAX_BOOT_PHASES 16
+
+static struct
+{
+    const char* name;
+    long nsec;
+} _boot_phases[MAX_BOOT_PHASES];
+
+static size_t _num_boot_phases;
+static struct timespec _boot_phase_start;
+
+/* record the time since the end of the previous phase */
+static void _end_boot_phase(const char* name)
+{
+    struct timespec now;
+
+    if (!__myst_kernel_args.perf)
+        return;
+
+    if (myst_syscall_clock_gettime(CLOCK_REALTIME, &now) != 0)
+        return;
+
+    if (_num_boot_phases == 0)
+    {
+        _boot_phase_start.tv_sec = __myst_kernel_args.start_time_sec;
+        _boot_phase_start.tv_nsec = __myst_kernel_args.start_time_nsec;
+    }
+
+    if (_num_boot_phases < MAX_BOOT_PHASES)
+    {
+        _boot_phases[_num_boot_phases].name = name;
+        _boot_phases[_num_boot_phases].nsec =
+            myst_lapsed_nsecs(&_boot_phase_start, &now);
+        _num_boot_phases++;
+    }
+
+    _boot_phase_start = now;
+}
+
 static void _print_boottime(void)
 {
     struct timespec now;
@@ -649,6 +773,16 @@ static void _print_boottime(void)
 
         myst_eprintf("%s", yellow);
         myst_eprintf("=== boot time: %.4lfsec", secs);
+
+        for (size_t i = 0; i < _num_boot_phases; i++)
+        {
+            const double phase_secs =
+                (double)_boot_phases[i].nsec / (double)NANO_IN_SECOND;
+
+            myst_eprintf(
+                "\n    %-24s %.4lfsec", _boot_phases[i].name, phase_secs);
+        }
+
         myst_eprintf("%s\n", reset);
     }
 }
@@ -671,6 +805,9 @@ int myst_enter_kernel(myst_kernel_args_t* args)
     if (!args)
         myst_crash();
 
+    /* select the memcpy(), memset(), etc. variants for this processor */
+    myst_memops_init();
+
     myst_register_stack(args->enter_stack, args->enter_stack_size);
 
     /* args->myst_syscall() can be called from enclave exception handlers */
@@ -724,6 +861,8 @@ int myst_enter_kernel(myst_kernel_args_t* args)
     if (myst_setup_mman(args->mman_data, args->mman_size) != 0)
         ERAISE(-EINVAL);
 
+    _end_boot_phase("target startup");
+
     /* call global constructors within the kernel */
     myst_call_init_functions();
 
@@ -768,6 +907,8 @@ int myst_enter_kernel(myst_kernel_args_t* args)
 
     myst_copy_host_uid_gid_mappings(&args->host_enc_uid_gid_mappings);
 
+    _end_boot_phase("main thread");
+
     /* determine the rootfs file system type (RAMFS, EXT2FS, OR HOSTFS) */
     if ((tmp_ret = _get_fstype(args, &fstype)) != 0)
     {
@@ -780,10 +921,12 @@ int myst_enter_kernel(myst_kernel_args_t* args)
 
     /* Mount the root file system */
     ECHECK(_mount_rootfs(args, fstype));
+    _end_boot_phase("mount rootfs");
 
     /* Generate TLS credentials if needed */
     ECHECK(myst_init_tls_credential_files(
         _getenv(args->envp, WANT_CREDENTIALS), _tmpfs ? _tmpfs : _fs, fstype));
+    _end_boot_phase("TLS credentials");
 
     /* Setup virtual proc filesystem */
     procfs_setup();
@@ -799,8 +942,10 @@ int myst_enter_kernel(myst_kernel_args_t* args)
         ERAISE(-EINVAL);
     }
 
-    /* Unpack the CPIO from memory */
-    if (fstype == MYST_FSTYPE_RAMFS &&
+    _end_boot_phase("procfs and TTY devices");
+
+    /* Unpack the CPIO from memory (unless mounted from its index) */
+    if (fstype == MYST_FSTYPE_RAMFS && !_rootfs_indexed &&
         myst_cpio_mem_unpack(
             args->rootfs_data, args->rootfs_size, "/", _create_mem_file) != 0)
     {
@@ -808,15 +953,28 @@ int myst_enter_kernel(myst_kernel_args_t* args)
         ERAISE(-EINVAL);
     }
 
+    _end_boot_phase("unpack rootfs");
+
     /* Setup devfs */
     devfs_setup();
 
+    /* Setup shared memory objects under /dev/shm */
+    ECHECK(shmfs_setup());
+
+    /* Snapshot the host's NUMA topology and expose it under /sys */
+    ECHECK(myst_numa_setup());
+    ECHECK(sysfs_setup());
+
     /* Create top-level proc entries */
     create_proc_root_entries();
 
+    _end_boot_phase("devfs and proc entries");
+
     ECHECK(_process_mount_configuration(args->mounts));
+    _end_boot_phase("mount configuration");
 
     ECHECK(_copy_host_etc_files());
+    _end_boot_phase("host /etc files");
 
     /* Set the 'run-proc' which is called by the target to run new threads */
     ECHECK(myst_tcall_set_run_thread_function(myst_run_thread));
@@ -895,6 +1053,13 @@ int myst_enter_kernel(myst_kernel_args_t* args)
             thread->exit_kstack = NULL;
         }
 
+        /* release the kernel stack cached across system calls if any */
+        if (thread->cached_kstack)
+        {
+            myst_put_kstack(thread->cached_kstack);
+            thread->cached_kstack = NULL;
+        }
+
         /* Wait for all child threads to shutdown */
         {
             myst_assume(thread->group_prev == NULL);
@@ -937,8 +1102,9 @@ int myst_enter_kernel(myst_kernel_args_t* args)
             process->fdtable = NULL;
         }
 
-        if (process->itimer)
-            free(process->itimer);
+        myst_itimer_free(process);
+
+        myst_aio_free(process);
 
         /* Remove ourself from /proc/<pid> so other processes know we have gone
          * if they check */
@@ -996,6 +1162,12 @@ int myst_enter_kernel(myst_kernel_args_t* args)
     /* Tear down the proc file system */
     procfs_teardown();
 
+    /* Tear down the shm file system */
+    shmfs_teardown();
+
+    /* Tear down the sys file system */
+    sysfs_teardown();
+
     /* Tear down the dev file system */
     devfs_teardown();
 
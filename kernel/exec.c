@@ -26,6 +26,7 @@
 #include <myst/process.h>
 #include <myst/reloc.h>
 #include <myst/round.h>
+#include <myst/rseq.h>
 #include <myst/setjmp.h>
 #include <myst/signal.h>
 #include <myst/spinlock.h>
@@ -907,6 +908,7 @@ int myst_exec(
     long hashbang_file = -1;
     myst_args_t new_argv;
     size_t num_bytes_read;
+    myst_crt_args_t args = {0};
 
     if (thread_stack_size)
         _thread_stack_size = thread_stack_size;
@@ -1123,6 +1125,12 @@ int myst_exec(
         myst_fdtable_cloexec(fdtable);
     }
 
+    /* like Linux, the new program must register for membarrier() again */
+    process->membarrier_registered = false;
+
+    /* and for rseq() (the old area is gone with the old image) */
+    myst_rseq_release(thread);
+
     /* register the new CRT symbols with the debugger */
     if (__myst_kernel_args.debug_symbols)
         ECHECK(_add_crt_symbols(crt_data, crt_size));
@@ -1146,8 +1154,14 @@ int myst_exec(
     if (callback)
         (*callback)(callback_arg);
 
+    /* every CRT gets the clock entry (execve passes no CRT args) */
+    if (crt_args)
+        args = *crt_args;
+
+    args.clock_gettime = myst_vdso_clock_gettime;
+
     /* enter the C-runtime on the target thread descriptor */
-    (*enter)(sp, dynv, myst_syscall, crt_args);
+    (*enter)(sp, dynv, myst_syscall, &args);
 
     /* unreachable */
 
@@ -10,6 +10,7 @@
 #include <myst/atexit.h>
 #include <myst/eraise.h>
 #include <myst/fdtable.h>
+#include <myst/hostfs.h>
 #include <myst/once.h>
 #include <myst/panic.h>
 #include <myst/pipedev.h>
@@ -517,6 +518,63 @@ done:
     return ret;
 }
 
+int myst_fdtable_get_host_fd(
+    myst_fdtable_t* fdtable,
+    int fd,
+    uint32_t types,
+    myst_fdtable_type_t* type_out,
+    void** device_out)
+{
+    int ret = 0;
+    myst_fdtable_type_t type;
+    void* device;
+    void* object;
+    myst_fdops_t* fdops;
+
+    ECHECK(myst_fdtable_get_any(fdtable, fd, &type, &device, &object));
+
+    if (!(types & MYST_FDTABLE_MASK(type)))
+        ERAISE_QUIET(-ENOTSUP);
+
+    switch (type)
+    {
+        case MYST_FDTABLE_TYPE_FILE:
+        {
+#ifdef MYST_ENABLE_HOSTFS
+            /* only hostfs files are backed by host files */
+            if (!myst_is_hostfs(device))
+                ERAISE_QUIET(-ENOTSUP);
+            break;
+#else
+            ERAISE_QUIET(-ENOTSUP);
+#endif
+        }
+        case MYST_FDTABLE_TYPE_SOCK:
+        {
+            /* exclude Unix domain sockets (the udsdev device) */
+            if (device != myst_sockdev_get())
+                ERAISE_QUIET(-ENOTSUP);
+            break;
+        }
+        default:
+        {
+            ERAISE_QUIET(-ENOTSUP);
+        }
+    }
+
+    fdops = device;
+    ECHECK(ret = (*fdops->fd_target_fd)(fdops, object));
+
+    if (type_out)
+        *type_out = type;
+
+    if (device_out)
+        *device_out = device;
+
+done:
+    return ret;
+}
+
 myst_fdtable_t* myst_fdtable_current(void)
 {
     myst_process_t* process = myst_process_self();
@@ -542,6 +600,10 @@ static const char* _type_name(myst_fdtable_type_t type)
             return "inotify";
         case MYST_FDTABLE_TYPE_EVENTFD:
             return "eventfd";
+        case MYST_FDTABLE_TYPE_TIMERFD:
+            return "timerfd";
+        case MYST_FDTABLE_TYPE_SIGNALFD:
+            return "signalfd";
         case MYST_FDTABLE_TYPE_NONE:
             return "none";
     }
@@ -115,3 +115,18 @@ done:
 
     return ret;
 }
+
+int myst_check_host_file(const char* path)
+{
+    int ret = 0;
+    int fd;
+
+    if (!path)
+        ERAISE(-EINVAL);
+
+    ECHECK(fd = _host_open(path, O_RDONLY, 0));
+    _host_close(fd);
+
+done:
+    return ret;
+}
@@ -1,163 +1,169 @@
 // Copyright (c) Microsoft Corporation.
 // Licensed under the MIT License.
 
-#include <assert.h>
+#include <errno.h>
 #include <limits.h>
+#include <signal.h>
 #include <stdint.h>
-#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
-#include <myst/clock.h>
-#include <myst/cond.h>
 #include <myst/eraise.h>
 #include <myst/kernel.h>
 #include <myst/mutex.h>
 #include <myst/process.h>
+#include <myst/signal.h>
 #include <myst/syscall.h>
 #include <myst/thread.h>
-#include <myst/time.h>
+#include <myst/timer.h>
 #include <myst/timeval.h>
 
-typedef struct myst_itimer
+#ifndef SIGEV_THREAD_ID
+#define SIGEV_THREAD_ID 4
+#endif
+
+/* the kernel's struct sigevent (with the sigev_notify_thread_id field) */
+struct ksigevent
 {
-    myst_cond_t cond;
-    uint64_t real_interval;   /* ITIMER_REAL interval */
-    uint64_t real_value;      /* ITIMER_REAL value */
-    uint64_t wait_start_time; /* time we enter wait */
-    myst_mutex_t mutex;
-    _Atomic(int) initialized;
-} myst_itimer_t;
+    union sigval sigev_value;
+    int sigev_signo;
+    int sigev_notify;
+    int sigev_tid;
+};
 
-/* get time as microseconds since epoch: return 0 on failure */
-static uint64_t _get_current_time(void)
+/* a timer created by timer_create() */
+typedef struct posix_timer posix_timer_t;
+
+struct posix_timer
 {
-    uint64_t ret;
-    struct timespec ts;
-    struct timeval tv;
+    posix_timer_t* next;
+    int id;
+    clockid_t clockid;
+    struct ksigevent sev;
+    myst_process_t* process;
+    _Atomic(int) overrun;
+    myst_timer_t timer;
+};
 
-    if (myst_syscall_clock_gettime(CLOCK_REALTIME, &ts) != 0)
-        return 0;
+typedef struct myst_itimer
+{
+    myst_timer_t real;     /* ITIMER_REAL */
+    myst_mutex_t mutex;    /* protects the fields below */
+    posix_timer_t* timers; /* POSIX timers of the process */
+    int next_id;           /* the next POSIX timer id */
+} myst_itimer_t;
 
-    /* downgrade from nanosecond to microsecond granularity */
-    tv.tv_sec = ts.tv_sec;
-    tv.tv_usec = ts.tv_nsec / 1000;
+static void _real_callback(myst_timer_t* timer, uint64_t n)
+{
+    myst_process_t* process = (myst_process_t*)timer->arg;
+    siginfo_t siginfo = {0};
 
-    /* convert timeval to uint64 */
-    if (myst_timeval_to_uint64(&tv, &ret) != 0)
-        return 0;
+    (void)n;
 
-    return ret;
+    siginfo.si_code = SI_KERNEL;
+    siginfo.si_signo = SIGALRM;
+    myst_signal_queue(process->main_process_thread, SIGALRM, &siginfo);
 }
 
-static void _update_and_check_expiration(
+/* deliver the signal to the given thread of the process (or fail) */
+static int _deliver_to_thread(
     myst_process_t* process,
-    uint64_t start,
-    uint64_t end)
+    int tid,
+    int sig,
+    const siginfo_t* siginfo)
 {
-    uint64_t elapsed = end - start;
+    myst_thread_t* main = process->main_process_thread;
+    myst_thread_t* target = NULL;
+    int ret = -ESRCH;
 
-    /* update the timer */
-    if (elapsed < process->itimer->real_value)
-        process->itimer->real_value -= elapsed;
-    else
-        process->itimer->real_value = 0;
-
-    /* if timer expired */
-    if (process->itimer->real_value == 0)
+    myst_spin_lock(main->thread_lock);
     {
-        myst_syscall_kill(process->pid, SIGALRM);
-        process->itimer->real_value = process->itimer->real_interval;
+        for (myst_thread_t* t = main; t && !target; t = t->group_next)
+        {
+            if (t->tid == tid)
+                target = t;
+        }
+
+        for (myst_thread_t* t = main->group_prev; t && !target;
+             t = t->group_prev)
+        {
+            if (t->tid == tid)
+                target = t;
+        }
+
+        if (target)
+            ret = (int)myst_signal_queue(target, (unsigned)sig, siginfo);
     }
+    myst_spin_unlock(main->thread_lock);
+
+    return ret;
 }
 
-long myst_syscall_run_itimer(myst_process_t* process)
+static void _posix_timer_callback(myst_timer_t* timer, uint64_t n)
 {
-    myst_mutex_lock(&process->itimer->mutex);
-    {
-        process->itimer->initialized = 1;
+    posix_timer_t* p = (posix_timer_t*)timer->arg;
+    const struct ksigevent* sev = &p->sev;
+    siginfo_t siginfo = {0};
 
-        for (;;)
-        {
-            struct timespec buf;
-            struct timespec* to;
+    /* one signal is sent per expiration batch; the rest are overruns */
+    p->overrun = (n - 1 > INT_MAX) ? INT_MAX : (int)(n - 1);
 
-            /* if ITIMER_REAL is non-zero */
-            if (process->itimer->real_value == 0)
-            {
-                to = NULL;
-            }
-            else
-            {
-                size_t real_time = process->itimer->real_value;
-
-                to = &buf;
-                to->tv_sec = real_time / 1000000;
-                to->tv_nsec = (real_time * 1000) % NANO_IN_SECOND;
-            }
+    if (sev->sigev_notify == SIGEV_NONE)
+        return;
 
-            process->itimer->wait_start_time = _get_current_time();
-            int r = myst_cond_timedwait(
-                &process->itimer->cond,
-                &process->itimer->mutex,
-                to,
-                FUTEX_BITSET_MATCH_ANY);
-            uint64_t end = _get_current_time();
+    siginfo.si_signo = sev->sigev_signo;
+    siginfo.si_code = SI_TIMER;
+    siginfo.si_timerid = p->id;
+    siginfo.si_overrun = p->overrun;
+    siginfo.si_value = sev->sigev_value;
 
-            assert(process->itimer->wait_start_time != 0);
-            assert(end != 0);
-            assert(end >= process->itimer->wait_start_time);
-
-            /* if received a signal on condition */
-            if (r == 0)
-            {
-                /* no-op */
-            }
-            else
-            {
-                /* Any other response, including timeout, we need to update the
-                 * timer so our wait is accurate on the next iteration */
-                _update_and_check_expiration(
-                    process, process->itimer->wait_start_time, end);
-            }
-        }
+    if (sev->sigev_notify == SIGEV_THREAD_ID)
+    {
+        _deliver_to_thread(
+            p->process, sev->sigev_tid, sev->sigev_signo, &siginfo);
+    }
+    else
+    {
+        myst_signal_queue(
+            p->process->main_process_thread, sev->sigev_signo, &siginfo);
     }
-    myst_mutex_unlock(&process->itimer->mutex);
-
-    return 0;
 }
 
-static long _init_itimer(myst_process_t* process)
+static myst_itimer_t* _get_itimer(myst_process_t* process)
 {
-    /* Need to make sure things are initialized for this process */
-    bool wanted_status = false;
-    if (__atomic_compare_exchange_n(
-            &process->itimer_thread_requested,
-            &wanted_status,
-            true,
+    myst_itimer_t* itimer;
+    myst_itimer_t* expected = NULL;
+
+    if ((itimer = __atomic_load_n(&process->itimer, __ATOMIC_ACQUIRE)))
+        return itimer;
+
+    if (!(itimer = calloc(1, sizeof(myst_itimer_t))))
+        return NULL;
+
+    myst_timer_init(&itimer->real, _real_callback, process);
+
+    if (!__atomic_compare_exchange_n(
+            &process->itimer,
+            &expected,
+            itimer,
             false,
-            __ATOMIC_RELEASE,
+            __ATOMIC_ACQ_REL,
             __ATOMIC_ACQUIRE))
     {
-        /* First we need to allocate the structure */
-        process->itimer = calloc(1, sizeof(myst_itimer_t));
-        if (process->itimer == NULL)
-        {
-            process->itimer_thread_requested = false;
-            return -ENOMEM;
-        }
-
-        /* This is a specialized error that we specifically return to launch the
-         * thread in the CRT. */
-        return -EAGAIN;
+        /* another thread got there first */
+        free(itimer);
+        itimer = expected;
     }
 
-    /* wait for itimer thread to obtain the mutex for the first time */
-    while (process->itimer->initialized == 0)
-    {
-        __asm__ __volatile__("pause" : : : "memory");
-    }
+    return itimer;
+}
+
+long myst_syscall_run_itimer(myst_process_t* process)
+{
+    (void)process;
 
-    return 0;
+    /* the CRT's itimer thread has become the kernel's ticker thread */
+    return myst_syscall_run_timers();
 }
 
 long myst_syscall_setitimer(
@@ -167,6 +173,7 @@ long myst_syscall_setitimer(
     struct itimerval* old_value)
 {
     long ret = 0;
+    myst_itimer_t* itimer;
     uint64_t interval;
     uint64_t value;
 
@@ -184,39 +191,25 @@ long myst_syscall_setitimer(
     ECHECK(myst_timeval_to_uint64(&new_value->it_interval, &interval));
     ECHECK(myst_timeval_to_uint64(&new_value->it_value, &value));
 
-    ECHECK(_init_itimer(process));
+    if (!(itimer = _get_itimer(process)))
+        ERAISE(-ENOMEM);
 
-    myst_mutex_lock(&process->itimer->mutex);
-    {
-        if (old_value)
-        {
-            uint64_t end = _get_current_time();
-            uint64_t elapsed = end - process->itimer->wait_start_time;
-            uint64_t real_value = process->itimer->real_value;
-
-            if (elapsed < real_value)
-                real_value -= elapsed;
-            else
-                real_value = 0;
-
-            myst_uint64_to_timeval(
-                process->itimer->real_interval, &old_value->it_interval);
-            myst_uint64_to_timeval(real_value, &old_value->it_value);
-        }
+    if (value)
+        ECHECK(myst_timer_request_ticker());
 
-        /* set the new value for the itimer */
-        process->itimer->real_interval = interval;
-        process->itimer->real_value = value;
+    if (old_value)
+        ECHECK(myst_syscall_getitimer(process, which, old_value));
 
-        /* signal the itimer thread */
-        if (myst_cond_signal(&process->itimer->cond, FUTEX_BITSET_MATCH_ANY) !=
-            0)
-        {
-            myst_mutex_unlock(&process->itimer->mutex);
-            ERAISE(-ENOSYS);
-        }
+    if (value)
+    {
+        /* itimers have microsecond granularity */
+        myst_timer_set(
+            &itimer->real, myst_timer_now() + value * 1000, interval * 1000);
+    }
+    else
+    {
+        myst_timer_set(&itimer->real, 0, 0);
     }
-    myst_mutex_unlock(&process->itimer->mutex);
 
 done:
     return ret;
@@ -228,6 +221,9 @@ int myst_syscall_getitimer(
     struct itimerval* curr_value)
 {
     int ret = 0;
+    myst_itimer_t* itimer;
+    uint64_t remaining;
+    uint64_t interval;
 
     /* ATTN: only ITIMER_REAL is supported so far */
     if (which != ITIMER_REAL || !curr_value)
@@ -236,28 +232,277 @@ int myst_syscall_getitimer(
     if (curr_value && !myst_is_addr_within_kernel(curr_value))
         ERAISE(-EFAULT);
 
-    if (curr_value)
-        memset(curr_value, 0, sizeof(struct itimerval));
+    memset(curr_value, 0, sizeof(struct itimerval));
+
+    if (!(itimer = _get_itimer(process)))
+        ERAISE(-ENOMEM);
+
+    myst_timer_get(&itimer->real, &remaining, &interval);
+
+    /* round up so that an armed timer never reads as disarmed */
+    myst_uint64_to_timeval((remaining + 999) / 1000, &curr_value->it_value);
+    myst_uint64_to_timeval(interval / 1000, &curr_value->it_interval);
+
+done:
+    return ret;
+}
+
+/* find the POSIX timer with the given id (the caller holds the mutex) */
+static posix_timer_t* _find_timer(myst_itimer_t* itimer, int id)
+{
+    for (posix_timer_t* p = itimer->timers; p; p = p->next)
+    {
+        if (p->id == id)
+            return p;
+    }
+
+    return NULL;
+}
+
+long myst_syscall_timer_create(
+    myst_process_t* process,
+    clockid_t clockid,
+    struct sigevent* sevp,
+    int* timerid)
+{
+    long ret = 0;
+    myst_itimer_t* itimer;
+    posix_timer_t* p = NULL;
+    bool locked = false;
+
+    if (!timerid || !myst_is_addr_within_kernel(timerid))
+        ERAISE(-EFAULT);
+
+    if (sevp && !myst_is_addr_within_kernel(sevp))
+        ERAISE(-EFAULT);
+
+    ECHECK(myst_timer_check_clock(clockid));
+
+    if (!(itimer = _get_itimer(process)))
+        ERAISE(-ENOMEM);
+
+    if (!(p = calloc(1, sizeof(posix_timer_t))))
+        ERAISE(-ENOMEM);
+
+    p->clockid = clockid;
+    p->process = process;
+    myst_timer_init(&p->timer, _posix_timer_callback, p);
+
+    if (sevp)
+    {
+        memcpy(&p->sev, sevp, sizeof(p->sev));
+
+        switch (p->sev.sigev_notify)
+        {
+            case SIGEV_NONE:
+                break;
+            case SIGEV_SIGNAL:
+            case SIGEV_THREAD_ID:
+            {
+                if (p->sev.sigev_signo <= 0 || p->sev.sigev_signo >= NSIG)
+                    ERAISE(-EINVAL);
+                break;
+            }
+            default:
+            {
+                /* SIGEV_THREAD is implemented by the C library */
+                ERAISE(-EINVAL);
+            }
+        }
+    }
+    else
+    {
+        p->sev.sigev_notify = SIGEV_SIGNAL;
+        p->sev.sigev_signo = SIGALRM;
+    }
+
+    myst_mutex_lock(&itimer->mutex);
+    locked = true;
+
+    p->id = itimer->next_id++;
+
+    /* without a sigevent, the signal carries the timer id */
+    if (!sevp)
+        p->sev.sigev_value.sival_int = p->id;
+
+    p->next = itimer->timers;
+    itimer->timers = p;
+    *timerid = p->id;
+    p = NULL;
+
+done:
+
+    if (locked)
+        myst_mutex_unlock(&itimer->mutex);
+
+    if (p)
+        free(p);
+
+    return ret;
+}
+
+long myst_syscall_timer_settime(
+    myst_process_t* process,
+    int timerid,
+    int flags,
+    const struct itimerspec* new_value,
+    struct itimerspec* old_value)
+{
+    long ret = 0;
+    myst_itimer_t* itimer;
+    posix_timer_t* p;
+    bool locked = false;
+
+    if (!new_value || !myst_is_addr_within_kernel(new_value))
+        ERAISE(-EFAULT);
+
+    if (old_value && !myst_is_addr_within_kernel(old_value))
+        ERAISE(-EFAULT);
+
+    if (!(itimer = _get_itimer(process)))
+        ERAISE(-EINVAL);
+
+    /* fail on a bad timer before asking for a ticker */
+    myst_mutex_lock(&itimer->mutex);
+    p = _find_timer(itimer, timerid);
+    myst_mutex_unlock(&itimer->mutex);
+
+    if (!p)
+        ERAISE(-EINVAL);
+
+    if (new_value->it_value.tv_sec || new_value->it_value.tv_nsec)
+        ECHECK(myst_timer_request_ticker());
+
+    myst_mutex_lock(&itimer->mutex);
+    locked = true;
+
+    if (!(p = _find_timer(itimer, timerid)))
+        ERAISE(-EINVAL);
+
+    ECHECK(myst_timer_settime(
+        &p->timer,
+        p->clockid,
+        (flags & TIMER_ABSTIME),
+        new_value,
+        old_value));
+
+done:
+
+    if (locked)
+        myst_mutex_unlock(&itimer->mutex);
+
+    return ret;
+}
+
+long myst_syscall_timer_gettime(
+    myst_process_t* process,
+    int timerid,
+    struct itimerspec* curr_value)
+{
+    long ret = 0;
+    myst_itimer_t* itimer;
+    posix_timer_t* p;
+    bool locked = false;
+
+    if (!curr_value || !myst_is_addr_within_kernel(curr_value))
+        ERAISE(-EFAULT);
+
+    if (!(itimer = _get_itimer(process)))
+        ERAISE(-EINVAL);
+
+    myst_mutex_lock(&itimer->mutex);
+    locked = true;
+
+    if (!(p = _find_timer(itimer, timerid)))
+        ERAISE(-EINVAL);
+
+    myst_timer_gettime(&p->timer, curr_value);
+
+done:
+
+    if (locked)
+        myst_mutex_unlock(&itimer->mutex);
+
+    return ret;
+}
+
+long myst_syscall_timer_getoverrun(myst_process_t* process, int timerid)
+{
+    long ret = 0;
+    myst_itimer_t* itimer;
+    posix_timer_t* p;
+    bool locked = false;
+
+    if (!(itimer = _get_itimer(process)))
+        ERAISE(-EINVAL);
+
+    myst_mutex_lock(&itimer->mutex);
+    locked = true;
 
-    ECHECK(_init_itimer(process));
+    if (!(p = _find_timer(itimer, timerid)))
+        ERAISE(-EINVAL);
+
+    ret = p->overrun;
+
+done:
+
+    if (locked)
+        myst_mutex_unlock(&itimer->mutex);
 
-    myst_mutex_lock(&process->itimer->mutex);
+    return ret;
+}
+
+long myst_syscall_timer_delete(myst_process_t* process, int timerid)
+{
+    long ret = 0;
+    myst_itimer_t* itimer;
+    posix_timer_t* p = NULL;
+
+    if (!(itimer = _get_itimer(process)))
+        ERAISE(-EINVAL);
+
+    myst_mutex_lock(&itimer->mutex);
     {
-        uint64_t end = _get_current_time();
-        uint64_t elapsed = end - process->itimer->wait_start_time;
-        uint64_t real_value = process->itimer->real_value;
-
-        if (elapsed < real_value)
-            real_value -= elapsed;
-        else
-            real_value = 0;
-
-        myst_uint64_to_timeval(real_value, &curr_value->it_value);
-        myst_uint64_to_timeval(
-            process->itimer->real_interval, &curr_value->it_interval);
+        for (posix_timer_t** pp = &itimer->timers; *pp; pp = &(*pp)->next)
+        {
+            if ((*pp)->id == timerid)
+            {
+                p = *pp;
+                *pp = p->next;
+                break;
+            }
+        }
     }
-    myst_mutex_unlock(&process->itimer->mutex);
+    myst_mutex_unlock(&itimer->mutex);
+
+    if (!p)
+        ERAISE(-EINVAL);
+
+    /* waits for the callback if it is running */
+    myst_timer_set(&p->timer, 0, 0);
+    free(p);
 
 done:
     return ret;
 }
+
+void myst_itimer_free(myst_process_t* process)
+{
+    myst_itimer_t* itimer = process->itimer;
+
+    if (!itimer)
+        return;
+
+    myst_timer_set(&itimer->real, 0, 0);
+
+    for (posix_timer_t* p = itimer->timers; p;)
+    {
+        posix_timer_t* next = p->next;
+        myst_timer_set(&p->timer, 0, 0);
+        free(p);
+        p = next;
+    }
+
+    free(itimer);
+    process->itimer = NULL;
+}
@@ -14,6 +14,7 @@
 #include <myst/eraise.h>
 #include <myst/kernel.h>
 #include <myst/list.h>
+#include <myst/memops.h>
 #include <myst/panic.h>
 #include <myst/printf.h>
 #include <myst/spinlock.h>
@@ -29,8 +30,6 @@
 **==============================================================================
 */
 
-#define USE_LOOP_UNROLLING
-
 char* strdup(const char* s)
 {
     char* p;
@@ -83,184 +82,31 @@ char* strncpy(char* dest, const char* src, size_t n)
     return dest;
 }
 
-#pragma GCC push_options
-#pragma GCC optimize "-O3"
+/* these dispatch to the variants selected by myst_memops_init() */
+
 void* memset(void* s, int c, size_t n)
 {
-    uint8_t* p = (uint8_t*)s;
-
-    /* copy while more bytes and not 8-byte aligned */
-    while (n && (((ptrdiff_t)p) & 0x000000000000000f))
-    {
-        *p++ = (uint8_t)c;
-        n--;
-    }
-
-    /* if more bytes and p is 8-byte aligned */
-    if (n > sizeof(__uint128_t) && ((ptrdiff_t)p & 0x000000000000000f) == 0)
-    {
-        __uint128_t* pp = (__uint128_t*)p;
-        size_t nn = n / sizeof(__uint128_t);
-        __uint128_t cc;
-
-        memset(&cc, c, sizeof(cc));
-
-        while (nn > 8)
-        {
-            pp[0] = cc;
-            pp[1] = cc;
-            pp[2] = cc;
-            pp[3] = cc;
-            pp[4] = cc;
-            pp[5] = cc;
-            pp[6] = cc;
-            pp[7] = cc;
-            pp += 8;
-            nn -= 8;
-        }
-
-        while (nn > 0)
-        {
-            *pp++ = cc;
-            nn--;
-        }
-
-        p = (uint8_t*)pp;
-        n %= sizeof(__uint128_t);
-    }
-
-    /* handle remaining bytes if any */
-    while (n > 0)
-    {
-        *p++ = (uint8_t)c;
-        n--;
-    }
-
-    return s;
+    return (*__myst_memops.memset)(s, c, n);
 }
-#pragma GCC pop_options
 
 void* memcpy(void* dest, const void* src, size_t n)
 {
-    uint8_t* p = (uint8_t*)dest;
-    const uint8_t* q = (const uint8_t*)src;
-
-    /* if dest and src are 8-byte aligned */
-    if (((uint64_t)p & 0x0000000000000007) == 0 &&
-        ((uint64_t)q & 0x0000000000000007) == 0)
-    {
-        uint64_t* pp = (uint64_t*)p;
-        const uint64_t* qq = (const uint64_t*)q;
-        size_t nn = n / 8;
-
-#ifdef USE_LOOP_UNROLLING
-
-        while (nn >= 8)
-        {
-            pp[0] = qq[0];
-            pp[1] = qq[1];
-            pp[2] = qq[2];
-            pp[3] = qq[3];
-            pp[4] = qq[4];
-            pp[5] = qq[5];
-            pp[6] = qq[6];
-            pp[7] = qq[7];
-            pp += 8;
-            qq += 8;
-            nn -= 8;
-        }
-
-#endif /* USE_LOOP_UNROLLING */
-
-        while (nn--)
-            *pp++ = *qq++;
-
-        n %= 8;
-        p = (uint8_t*)pp;
-        q = (const uint8_t*)qq;
-    }
-
-    while (n--)
-        *p++ = *q++;
-
-    return dest;
+    return (*__myst_memops.memcpy)(dest, src, n);
 }
 
 int memcmp(const void* s1, const void* s2, size_t n)
 {
-    unsigned char* p = (unsigned char*)s1;
-    unsigned char* q = (unsigned char*)s2;
-
-    while (n--)
-    {
-        if (*p < *q)
-            return -1;
-        else if (*p > *q)
-            return 1;
-
-        p++;
-        q++;
-    }
-
-    return 0;
+    return (*__myst_memops.memcmp)(s1, s2, n);
 }
 
-void* memmove(void* dest_, const void* src_, size_t n)
+void* memmove(void* dest, const void* src, size_t n)
 {
-    uint8_t* dest = (uint8_t*)dest_;
-    const uint8_t* src = (const uint8_t*)src_;
-
-    if (dest != src && n > 0)
-    {
-        if (dest <= src)
-        {
-            memcpy(dest, src, n);
-        }
-        else
-        {
-            for (src += n, dest += n; n--; dest--, src--)
-                dest[-1] = src[-1];
-        }
-    }
-
-    return dest_;
+    return (*__myst_memops.memmove)(dest, src, n);
 }
 
 size_t strlen(const char* s)
 {
-#ifdef USE_LOOP_UNROLLING
-
-    const char* p = s;
-
-    while (p[0] && p[1] && p[2] && p[3] && p[4] && p[5])
-        p += 6;
-
-    if (!p[0])
-        return (size_t)(p - s);
-    if (!p[1])
-        return (size_t)(p - s + 1);
-    if (!p[2])
-        return (size_t)(p - s + 2);
-    if (!p[3])
-        return (size_t)(p - s + 3);
-    if (!p[4])
-        return (size_t)(p - s + 4);
-    if (!p[5])
-        return (size_t)(p - s + 5);
-
-    /* Unreachable */
-    return 0;
-
-#else /* USE_LOOP_UNROLLING */
-
-    size_t n = 0;
-
-    while (*s++)
-        n++;
-
-    return n;
-
-#endif /* USE_LOOP_UNROLLING */
+    return (*__myst_memops.strlen)(s);
 }
 
 int strcmp(const char* s1, const char* s2)
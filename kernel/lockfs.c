@@ -6,7 +6,7 @@
 
 #include <myst/eraise.h>
 #include <myst/lockfs.h>
-#include <myst/mutex.h>
+#include <myst/rwlock.h>
 #include <myst/thread.h>
 
 #define LOCKFS_MAGIC 0x94639c1a101f4a1d
@@ -15,7 +15,8 @@ typedef struct lockfs
 {
     myst_fs_t base;
     uint64_t magic;
-    myst_mutex_t lock;
+    myst_rwlock_t lock;
+    bool shared_reads; /* see myst_lockfs_set_shared_reads() */
     myst_fs_t* fs;
 } lockfs_t;
 
@@ -25,19 +26,19 @@ typedef struct lockfs_sighandler
     myst_thread_sig_handler_t sig_handler;
 
     // our condition variable details to clean up;
-    myst_mutex_t* lock;
+    myst_rwlock_t* lock;
 
 } lockfs_sighandler_t;
 
 static void _unlock_sighandler(MYST_UNUSED unsigned signum, void* _sig_handler)
 {
     lockfs_sighandler_t* sig_handler = (lockfs_sighandler_t*)_sig_handler;
-    myst_mutex_unlock(sig_handler->lock);
+    myst_rwlock_unlock(sig_handler->lock);
 }
 
 static void _install_sig_handler(
     lockfs_sighandler_t* sig_handler,
-    myst_mutex_t* lock)
+    myst_rwlock_t* lock)
 {
     memset(sig_handler, 0, sizeof(*sig_handler));
 
@@ -52,6 +53,30 @@ static void _uninstall_sig_handler(lockfs_sighandler_t* sig_handler)
     myst_thread_sig_handler_uninstall(&sig_handler->sig_handler);
 }
 
+/* lock the file system for an operation that may modify it */
+static void _lock(lockfs_t* lockfs, lockfs_sighandler_t* sig_handler)
+{
+    myst_rwlock_wrlock(&lockfs->lock);
+    _install_sig_handler(sig_handler, &lockfs->lock);
+}
+
+/* lock the file system for an operation that only inspects it */
+static void _lock_shared(lockfs_t* lockfs, lockfs_sighandler_t* sig_handler)
+{
+    if (lockfs->shared_reads)
+        myst_rwlock_rdlock(&lockfs->lock);
+    else
+        myst_rwlock_wrlock(&lockfs->lock);
+
+    _install_sig_handler(sig_handler, &lockfs->lock);
+}
+
+static void _unlock(lockfs_t* lockfs, lockfs_sighandler_t* sig_handler)
+{
+    _uninstall_sig_handler(sig_handler);
+    myst_rwlock_unlock(&lockfs->lock);
+}
+
 static bool _lockfs_valid(const lockfs_t* lockfs)
 {
     return lockfs && lockfs->magic == LOCKFS_MAGIC;
@@ -81,11 +106,9 @@ static int _fs_mount(myst_fs_t* fs, const char* source, const char* target)
     if (!_lockfs_valid(lockfs))
         ERAISE(-EINVAL);
 
-    myst_mutex_lock(&lockfs->lock);
-    _install_sig_handler(&sig_handler, &lockfs->lock);
+    _lock(lockfs, &sig_handler);
     ret = (*lockfs->fs->fs_mount)(lockfs->fs, source, target);
-    _uninstall_sig_handler(&sig_handler);
-    myst_mutex_unlock(&lockfs->lock);
+    _unlock(lockfs, &sig_handler);
 
 done:
     return ret;
@@ -105,11 +128,9 @@ static int _fs_creat(
     if (!_lockfs_valid(lockfs))
         ERAISE(-EINVAL);
 
-    myst_mutex_lock(&lockfs->lock);
-    _install_sig_handler(&sig_handler, &lockfs->lock);
+    _lock(lockfs, &sig_handler);
     ret = (*lockfs->fs->fs_creat)(lockfs->fs, pathname, mode, fs_out, file_out);
-    _uninstall_sig_handler(&sig_handler);
-    myst_mutex_unlock(&lockfs->lock);
+    _unlock(lockfs, &sig_handler);
 
 done:
     return ret;
@@ -130,12 +151,10 @@ static int _fs_open(
     if (!_lockfs_valid(lockfs))
         ERAISE(-EINVAL);
 
-    myst_mutex_lock(&lockfs->lock);
-    _install_sig_handler(&sig_handler, &lockfs->lock);
+    _lock(lockfs, &sig_handler);
     ret = (*lockfs->fs->fs_open)(
         lockfs->fs, pathname, flags, mode, fs_out, file_out);
-    _uninstall_sig_handler(&sig_handler);
-    myst_mutex_unlock(&lockfs->lock);
+    _unlock(lockfs, &sig_handler);
 
 done:
     return ret;
@@ -154,11 +173,9 @@ static off_t _fs_lseek(
     if (!_lockfs_valid(lockfs))
         ERAISE(-EINVAL);
 
-    myst_mutex_lock(&lockfs->lock);
-    _install_sig_handler(&sig_handler, &lockfs->lock);
+    _lock(lockfs, &sig_handler);
     ret = (*lockfs->fs->fs_lseek)(lockfs->fs, file, offset, whence);
-    _uninstall_sig_handler(&sig_handler);
-    myst_mutex_unlock(&lockfs->lock);
+    _unlock(lockfs, &sig_handler);
 
 done:
     return ret;
@@ -177,11 +194,9 @@ static ssize_t _fs_read(
     if (!_lockfs_valid(lockfs))
         ERAISE(-EINVAL);
 
-    myst_mutex_lock(&lockfs->lock);
-    _install_sig_handler(&sig_handler, &lockfs->lock);
+    _lock(lockfs, &sig_handler);
     ret = (*lockfs->fs->fs_read)(lockfs->fs, file, buf, count);
-    _uninstall_sig_handler(&sig_handler);
-    myst_mutex_unlock(&lockfs->lock);
+    _unlock(lockfs, &sig_handler);
 
 done:
     return ret;
@@ -200,11 +215,9 @@ static ssize_t _fs_write(
     if (!_lockfs_valid(lockfs))
         ERAISE(-EINVAL);
 
-    myst_mutex_lock(&lockfs->lock);
-    _install_sig_handler(&sig_handler, &lockfs->lock);
+    _lock(lockfs, &sig_handler);
     ret = (*lockfs->fs->fs_write)(lockfs->fs, file, buf, count);
-    _uninstall_sig_handler(&sig_handler);
-    myst_mutex_unlock(&lockfs->lock);
+    _unlock(lockfs, &sig_handler);
 
 done:
     return ret;
@@ -224,11 +237,9 @@ static ssize_t _fs_pread(
     if (!_lockfs_valid(lockfs))
         ERAISE(-EINVAL);
 
-    myst_mutex_lock(&lockfs->lock);
-    _install_sig_handler(&sig_handler, &lockfs->lock);
+    _lock_shared(lockfs, &sig_handler);
     ret = (*lockfs->fs->fs_pread)(lockfs->fs, file, buf, count, offset);
-    _uninstall_sig_handler(&sig_handler);
-    myst_mutex_unlock(&lockfs->lock);
+    _unlock(lockfs, &sig_handler);
 
 done:
     return ret;
@@ -248,11 +259,9 @@ static ssize_t _fs_pwrite(
     if (!_lockfs_valid(lockfs))
         ERAISE(-EINVAL);
 
-    myst_mutex_lock(&lockfs->lock);
-    _install_sig_handler(&sig_handler, &lockfs->lock);
+    _lock(lockfs, &sig_handler);
     ret = (*lockfs->fs->fs_pwrite)(lockfs->fs, file, buf, count, offset);
-    _uninstall_sig_handler(&sig_handler);
-    myst_mutex_unlock(&lockfs->lock);
+    _unlock(lockfs, &sig_handler);
 
 done:
     return ret;
@@ -271,11 +280,9 @@ static ssize_t _fs_readv(
     if (!_lockfs_valid(lockfs))
         ERAISE(-EINVAL);
 
-    myst_mutex_lock(&lockfs->lock);
-    _install_sig_handler(&sig_handler, &lockfs->lock);
+    _lock(lockfs, &sig_handler);
     ret = (*lockfs->fs->fs_readv)(lockfs->fs, file, iov, iovcnt);
-    _uninstall_sig_handler(&sig_handler);
-    myst_mutex_unlock(&lockfs->lock);
+    _unlock(lockfs, &sig_handler);
 
 done:
     return ret;
@@ -294,11 +301,9 @@ static ssize_t _fs_writev(
     if (!_lockfs_valid(lockfs))
         ERAISE(-EINVAL);
 
-    myst_mutex_lock(&lockfs->lock);
-    _install_sig_handler(&sig_handler, &lockfs->lock);
+    _lock(lockfs, &sig_handler);
     ret = (*lockfs->fs->fs_writev)(lockfs->fs, file, iov, iovcnt);
-    _uninstall_sig_handler(&sig_handler);
-    myst_mutex_unlock(&lockfs->lock);
+    _unlock(lockfs, &sig_handler);
 
 done:
     return ret;
@@ -313,11 +318,9 @@ static int _fs_close(myst_fs_t* fs, myst_file_t* file)
     if (!_lockfs_valid(lockfs))
         ERAISE(-EINVAL);
 
-    myst_mutex_lock(&lockfs->lock);
-    _install_sig_handler(&sig_handler, &lockfs->lock);
+    _lock(lockfs, &sig_handler);
     ret = (*lockfs->fs->fs_close)(lockfs->fs, file);
-    _uninstall_sig_handler(&sig_handler);
-    myst_mutex_unlock(&lockfs->lock);
+    _unlock(lockfs, &sig_handler);
 
 done:
     return ret;
@@ -332,11 +335,9 @@ static int _fs_access(myst_fs_t* fs, const char* pathname, int mode)
     if (!_lockfs_valid(lockfs))
         ERAISE(-EINVAL);
 
-    myst_mutex_lock(&lockfs->lock);
-    _install_sig_handler(&sig_handler, &lockfs->lock);
+    _lock_shared(lockfs, &sig_handler);
     ret = (*lockfs->fs->fs_access)(lockfs->fs, pathname, mode);
-    _uninstall_sig_handler(&sig_handler);
-    myst_mutex_unlock(&lockfs->lock);
+    _unlock(lockfs, &sig_handler);
 
 done:
     return ret;
@@ -351,11 +352,9 @@ static int _fs_stat(myst_fs_t* fs, const char* pathname, struct stat* statbuf)
     if (!_lockfs_valid(lockfs))
         ERAISE(-EINVAL);
 
-    myst_mutex_lock(&lockfs->lock);
-    _install_sig_handler(&sig_handler, &lockfs->lock);
+    _lock_shared(lockfs, &sig_handler);
     ret = (*lockfs->fs->fs_stat)(lockfs->fs, pathname, statbuf);
-    _uninstall_sig_handler(&sig_handler);
-    myst_mutex_unlock(&lockfs->lock);
+    _unlock(lockfs, &sig_handler);
 
 done:
     return ret;
@@ -370,11 +369,9 @@ static int _fs_lstat(myst_fs_t* fs, const char* pathname, struct stat* statbuf)
     if (!_lockfs_valid(lockfs))
         ERAISE(-EINVAL);
 
-    myst_mutex_lock(&lockfs->lock);
-    _install_sig_handler(&sig_handler, &lockfs->lock);
+    _lock_shared(lockfs, &sig_handler);
     ret = (*lockfs->fs->fs_lstat)(lockfs->fs, pathname, statbuf);
-    _uninstall_sig_handler(&sig_handler);
-    myst_mutex_unlock(&lockfs->lock);
+    _unlock(lockfs, &sig_handler);
 
 done:
     return ret;
@@ -389,11 +386,9 @@ static int _fs_fstat(myst_fs_t* fs, myst_file_t* file, struct stat* statbuf)
     if (!_lockfs_valid(lockfs))
         ERAISE(-EINVAL);
 
-    myst_mutex_lock(&lockfs->lock);
-    _install_sig_handler(&sig_handler, &lockfs->lock);
+    _lock_shared(lockfs, &sig_handler);
     ret = (*lockfs->fs->fs_fstat)(lockfs->fs, file, statbuf);
-    _uninstall_sig_handler(&sig_handler);
-    myst_mutex_unlock(&lockfs->lock);
+    _unlock(lockfs, &sig_handler);
 
 done:
     return ret;
@@ -408,11 +403,9 @@ static int _fs_link(myst_fs_t* fs, const char* oldpath, const char* newpath)
     if (!_lockfs_valid(lockfs))
         ERAISE(-EINVAL);
 
-    myst_mutex_lock(&lockfs->lock);
-    _install_sig_handler(&sig_handler, &lockfs->lock);
+    _lock(lockfs, &sig_handler);
     ret = (*lockfs->fs->fs_link)(lockfs->fs, oldpath, newpath);
-    _uninstall_sig_handler(&sig_handler);
-    myst_mutex_unlock(&lockfs->lock);
+    _unlock(lockfs, &sig_handler);
 
 done:
     return ret;
@@ -427,11 +420,9 @@ static int _fs_unlink(myst_fs_t* fs, const char* pathname)
     if (!_lockfs_valid(lockfs))
         ERAISE(-EINVAL);
 
-    myst_mutex_lock(&lockfs->lock);
-    _install_sig_handler(&sig_handler, &lockfs->lock);
+    _lock(lockfs, &sig_handler);
     ret = (*lockfs->fs->fs_unlink)(lockfs->fs, pathname);
-    _uninstall_sig_handler(&sig_handler);
-    myst_mutex_unlock(&lockfs->lock);
+    _unlock(lockfs, &sig_handler);
 
 done:
     return ret;
@@ -446,11 +437,9 @@ static int _fs_rename(myst_fs_t* fs, const char* oldpath, const char* newpath)
     if (!_lockfs_valid(lockfs))
         ERAISE(-EINVAL);
 
-    myst_mutex_lock(&lockfs->lock);
-    _install_sig_handler(&sig_handler, &lockfs->lock);
+    _lock(lockfs, &sig_handler);
     ret = (*lockfs->fs->fs_rename)(lockfs->fs, oldpath, newpath);
-    _uninstall_sig_handler(&sig_handler);
-    myst_mutex_unlock(&lockfs->lock);
+    _unlock(lockfs, &sig_handler);
 
 done:
     return ret;
@@ -465,11 +454,9 @@ static int _fs_truncate(myst_fs_t* fs, const char* pathname, off_t length)
     if (!_lockfs_valid(lockfs))
         ERAISE(-EINVAL);
 
-    myst_mutex_lock(&lockfs->lock);
-    _install_sig_handler(&sig_handler, &lockfs->lock);
+    _lock(lockfs, &sig_handler);
     ret = (*lockfs->fs->fs_truncate)(lockfs->fs, pathname, length);
-    _uninstall_sig_handler(&sig_handler);
-    myst_mutex_unlock(&lockfs->lock);
+    _unlock(lockfs, &sig_handler);
 
 done:
     return ret;
@@ -484,11 +471,9 @@ static int _fs_ftruncate(myst_fs_t* fs, myst_file_t* file, off_t length)
     if (!_lockfs_valid(lockfs))
         ERAISE(-EINVAL);
 
-    myst_mutex_lock(&lockfs->lock);
-    _install_sig_handler(&sig_handler, &lockfs->lock);
+    _lock(lockfs, &sig_handler);
     ret = (*lockfs->fs->fs_ftruncate)(lockfs->fs, file, length);
-    _uninstall_sig_handler(&sig_handler);
-    myst_mutex_unlock(&lockfs->lock);
+    _unlock(lockfs, &sig_handler);
 
 done:
     return ret;
@@ -503,11 +488,9 @@ static int _fs_mkdir(myst_fs_t* fs, const char* pathname, mode_t mode)
     if (!_lockfs_valid(lockfs))
         ERAISE(-EINVAL);
 
-    myst_mutex_lock(&lockfs->lock);
-    _install_sig_handler(&sig_handler, &lockfs->lock);
+    _lock(lockfs, &sig_handler);
     ret = (*lockfs->fs->fs_mkdir)(lockfs->fs, pathname, mode);
-    _uninstall_sig_handler(&sig_handler);
-    myst_mutex_unlock(&lockfs->lock);
+    _unlock(lockfs, &sig_handler);
 
 done:
     return ret;
@@ -522,11 +505,9 @@ static int _fs_rmdir(myst_fs_t* fs, const char* pathname)
     if (!_lockfs_valid(lockfs))
         ERAISE(-EINVAL);
 
-    myst_mutex_lock(&lockfs->lock);
-    _install_sig_handler(&sig_handler, &lockfs->lock);
+    _lock(lockfs, &sig_handler);
     ret = (*lockfs->fs->fs_rmdir)(lockfs->fs, pathname);
-    _uninstall_sig_handler(&sig_handler);
-    myst_mutex_unlock(&lockfs->lock);
+    _unlock(lockfs, &sig_handler);
 
 done:
     return ret;
@@ -545,11 +526,9 @@ static int _fs_getdents64(
     if (!_lockfs_valid(lockfs))
         ERAISE(-EINVAL);
 
-    myst_mutex_lock(&lockfs->lock);
-    _install_sig_handler(&sig_handler, &lockfs->lock);
+    _lock(lockfs, &sig_handler);
     ret = (*lockfs->fs->fs_getdents64)(lockfs->fs, file, dirp, count);
-    _uninstall_sig_handler(&sig_handler);
-    myst_mutex_unlock(&lockfs->lock);
+    _unlock(lockfs, &sig_handler);
 
 done:
     return ret;
@@ -568,11 +547,9 @@ static ssize_t _fs_readlink(
     if (!_lockfs_valid(lockfs))
         ERAISE(-EINVAL);
 
-    myst_mutex_lock(&lockfs->lock);
-    _install_sig_handler(&sig_handler, &lockfs->lock);
+    _lock_shared(lockfs, &sig_handler);
     ret = (*lockfs->fs->fs_readlink)(lockfs->fs, pathname, buf, bufsiz);
-    _uninstall_sig_handler(&sig_handler);
-    myst_mutex_unlock(&lockfs->lock);
+    _unlock(lockfs, &sig_handler);
 
 done:
     return ret;
@@ -587,11 +564,9 @@ static int _fs_symlink(myst_fs_t* fs, const char* target, const char* linkpath)
     if (!_lockfs_valid(lockfs))
         ERAISE(-EINVAL);
 
-    myst_mutex_lock(&lockfs->lock);
-    _install_sig_handler(&sig_handler, &lockfs->lock);
+    _lock(lockfs, &sig_handler);
     ret = (*lockfs->fs->fs_symlink)(lockfs->fs, target, linkpath);
-    _uninstall_sig_handler(&sig_handler);
-    myst_mutex_unlock(&lockfs->lock);
+    _unlock(lockfs, &sig_handler);
 
 done:
     return ret;
@@ -610,11 +585,9 @@ static int _fs_realpath(
     if (!_lockfs_valid(lockfs))
         ERAISE(-EINVAL);
 
-    myst_mutex_lock(&lockfs->lock);
-    _install_sig_handler(&sig_handler, &lockfs->lock);
+    _lock_shared(lockfs, &sig_handler);
     ret = (*lockfs->fs->fs_realpath)(lockfs->fs, file, buf, size);
-    _uninstall_sig_handler(&sig_handler);
-    myst_mutex_unlock(&lockfs->lock);
+    _unlock(lockfs, &sig_handler);
 
 done:
     return ret;
@@ -629,11 +602,9 @@ static int _fs_fcntl(myst_fs_t* fs, myst_file_t* file, int cmd, long arg)
     if (!_lockfs_valid(lockfs))
         ERAISE(-EINVAL);
 
-    myst_mutex_lock(&lockfs->lock);
-    _install_sig_handler(&sig_handler, &lockfs->lock);
+    _lock(lockfs, &sig_handler);
     ret = (*lockfs->fs->fs_fcntl)(lockfs->fs, file, cmd, arg);
-    _uninstall_sig_handler(&sig_handler);
-    myst_mutex_unlock(&lockfs->lock);
+    _unlock(lockfs, &sig_handler);
 
 done:
     return ret;
@@ -652,11 +623,9 @@ static int _fs_ioctl(
     if (!_lockfs_valid(lockfs))
         ERAISE(-EINVAL);
 
-    myst_mutex_lock(&lockfs->lock);
-    _install_sig_handler(&sig_handler, &lockfs->lock);
+    _lock(lockfs, &sig_handler);
     ret = (*lockfs->fs->fs_ioctl)(lockfs->fs, file, request, arg);
-    _uninstall_sig_handler(&sig_handler);
-    myst_mutex_unlock(&lockfs->lock);
+    _unlock(lockfs, &sig_handler);
 
 done:
     return ret;
@@ -674,11 +643,9 @@ static int _fs_dup(
     if (!_lockfs_valid(lockfs))
         ERAISE(-EINVAL);
 
-    myst_mutex_lock(&lockfs->lock);
-    _install_sig_handler(&sig_handler, &lockfs->lock);
+    _lock(lockfs, &sig_handler);
     ret = (*lockfs->fs->fs_dup)(lockfs->fs, file, file_out);
-    _uninstall_sig_handler(&sig_handler);
-    myst_mutex_unlock(&lockfs->lock);
+    _unlock(lockfs, &sig_handler);
 
 done:
     return ret;
@@ -693,11 +660,9 @@ static int _fs_target_fd(myst_fs_t* fs, myst_file_t* file)
     if (!_lockfs_valid(lockfs))
         ERAISE(-EINVAL);
 
-    myst_mutex_lock(&lockfs->lock);
-    _install_sig_handler(&sig_handler, &lockfs->lock);
+    _lock_shared(lockfs, &sig_handler);
     ret = (*lockfs->fs->fs_target_fd)(lockfs->fs, file);
-    _uninstall_sig_handler(&sig_handler);
-    myst_mutex_unlock(&lockfs->lock);
+    _unlock(lockfs, &sig_handler);
 
 done:
     return ret;
@@ -712,11 +677,9 @@ static int _fs_get_events(myst_fs_t* fs, myst_file_t* file)
     if (!_lockfs_valid(lockfs))
         ERAISE(-EINVAL);
 
-    myst_mutex_lock(&lockfs->lock);
-    _install_sig_handler(&sig_handler, &lockfs->lock);
+    _lock_shared(lockfs, &sig_handler);
     ret = (*lockfs->fs->fs_get_events)(lockfs->fs, file);
-    _uninstall_sig_handler(&sig_handler);
-    myst_mutex_unlock(&lockfs->lock);
+    _unlock(lockfs, &sig_handler);
 
 done:
     return ret;
@@ -731,11 +694,9 @@ static int _fs_statfs(myst_fs_t* fs, const char* pathname, struct statfs* buf)
     if (!_lockfs_valid(lockfs))
         ERAISE(-EINVAL);
 
-    myst_mutex_lock(&lockfs->lock);
-    _install_sig_handler(&sig_handler, &lockfs->lock);
+    _lock_shared(lockfs, &sig_handler);
     ret = (*lockfs->fs->fs_statfs)(lockfs->fs, pathname, buf);
-    _uninstall_sig_handler(&sig_handler);
-    myst_mutex_unlock(&lockfs->lock);
+    _unlock(lockfs, &sig_handler);
 
 done:
     return ret;
@@ -750,11 +711,9 @@ static int _fs_fstatfs(myst_fs_t* fs, myst_file_t* file, struct statfs* buf)
     if (!_lockfs_valid(lockfs))
         ERAISE(-EINVAL);
 
-    myst_mutex_lock(&lockfs->lock);
-    _install_sig_handler(&sig_handler, &lockfs->lock);
+    _lock_shared(lockfs, &sig_handler);
     ret = (*lockfs->fs->fs_fstatfs)(lockfs->fs, file, buf);
-    _uninstall_sig_handler(&sig_handler);
-    myst_mutex_unlock(&lockfs->lock);
+    _unlock(lockfs, &sig_handler);
 
 done:
     return ret;
@@ -772,11 +731,9 @@ static int _fs_futimens(
     if (!_lockfs_valid(lockfs))
         ERAISE(-EINVAL);
 
-    myst_mutex_lock(&lockfs->lock);
-    _install_sig_handler(&sig_handler, &lockfs->lock);
+    _lock(lockfs, &sig_handler);
     ret = (*lockfs->fs->fs_futimens)(lockfs->fs, file, times);
-    _uninstall_sig_handler(&sig_handler);
-    myst_mutex_unlock(&lockfs->lock);
+    _unlock(lockfs, &sig_handler);
 
 done:
     return ret;
@@ -795,11 +752,9 @@ static int _fs_chown(
     if (!_lockfs_valid(lockfs))
         ERAISE(-EINVAL);
 
-    myst_mutex_lock(&lockfs->lock);
-    _install_sig_handler(&sig_handler, &lockfs->lock);
+    _lock(lockfs, &sig_handler);
     ret = (*lockfs->fs->fs_chown)(lockfs->fs, pathname, owner, group);
-    _uninstall_sig_handler(&sig_handler);
-    myst_mutex_unlock(&lockfs->lock);
+    _unlock(lockfs, &sig_handler);
 
 done:
     return ret;
@@ -818,11 +773,9 @@ static int _fs_fchown(
     if (!_lockfs_valid(lockfs))
         ERAISE(-EINVAL);
 
-    myst_mutex_lock(&lockfs->lock);
-    _install_sig_handler(&sig_handler, &lockfs->lock);
+    _lock(lockfs, &sig_handler);
     ret = (*lockfs->fs->fs_fchown)(lockfs->fs, file, owner, group);
-    _uninstall_sig_handler(&sig_handler);
-    myst_mutex_unlock(&lockfs->lock);
+    _unlock(lockfs, &sig_handler);
 
 done:
     return ret;
@@ -841,11 +794,9 @@ static int _fs_lchown(
     if (!_lockfs_valid(lockfs))
         ERAISE(-EINVAL);
 
-    myst_mutex_lock(&lockfs->lock);
-    _install_sig_handler(&sig_handler, &lockfs->lock);
+    _lock(lockfs, &sig_handler);
     ret = (*lockfs->fs->fs_lchown)(lockfs->fs, pathname, owner, group);
-    _uninstall_sig_handler(&sig_handler);
-    myst_mutex_unlock(&lockfs->lock);
+    _unlock(lockfs, &sig_handler);
 
 done:
     return ret;
@@ -860,11 +811,9 @@ static int _fs_chmod(myst_fs_t* fs, const char* pathname, mode_t mode)
     if (!_lockfs_valid(lockfs))
         ERAISE(-EINVAL);
 
-    myst_mutex_lock(&lockfs->lock);
-    _install_sig_handler(&sig_handler, &lockfs->lock);
+    _lock(lockfs, &sig_handler);
     ret = (*lockfs->fs->fs_chmod)(lockfs->fs, pathname, mode);
-    _uninstall_sig_handler(&sig_handler);
-    myst_mutex_unlock(&lockfs->lock);
+    _unlock(lockfs, &sig_handler);
 
 done:
     return ret;
@@ -879,11 +828,9 @@ static int _fs_fchmod(myst_fs_t* fs, myst_file_t* file, mode_t mode)
     if (!_lockfs_valid(lockfs))
         ERAISE(-EINVAL);
 
-    myst_mutex_lock(&lockfs->lock);
-    _install_sig_handler(&sig_handler, &lockfs->lock);
+    _lock(lockfs, &sig_handler);
     ret = (*lockfs->fs->fs_fchmod)(lockfs->fs, file, mode);
-    _uninstall_sig_handler(&sig_handler);
-    myst_mutex_unlock(&lockfs->lock);
+    _unlock(lockfs, &sig_handler);
 
 done:
     return ret;
@@ -898,11 +845,9 @@ static int _fs_fdatasync(myst_fs_t* fs, myst_file_t* file)
     if (!_lockfs_valid(lockfs))
         ERAISE(-EINVAL);
 
-    myst_mutex_lock(&lockfs->lock);
-    _install_sig_handler(&sig_handler, &lockfs->lock);
+    _lock(lockfs, &sig_handler);
     ret = (*lockfs->fs->fs_fdatasync)(lockfs->fs, file);
-    _uninstall_sig_handler(&sig_handler);
-    myst_mutex_unlock(&lockfs->lock);
+    _unlock(lockfs, &sig_handler);
 
 done:
     return ret;
@@ -917,11 +862,9 @@ static int _fs_fsync(myst_fs_t* fs, myst_file_t* file)
     if (!_lockfs_valid(lockfs))
         ERAISE(-EINVAL);
 
-    myst_mutex_lock(&lockfs->lock);
-    _install_sig_handler(&sig_handler, &lockfs->lock);
+    _lock(lockfs, &sig_handler);
     ret = (*lockfs->fs->fs_fsync)(lockfs->fs, file);
-    _uninstall_sig_handler(&sig_handler);
-    myst_mutex_unlock(&lockfs->lock);
+    _unlock(lockfs, &sig_handler);
 
 done:
     return ret;
@@ -936,11 +879,9 @@ static int _fs_release_tree(myst_fs_t* fs, const char* pathname)
     if (!_lockfs_valid(lockfs) || !pathname)
         ERAISE(-EINVAL);
 
-    myst_mutex_lock(&lockfs->lock);
-    _install_sig_handler(&sig_handler, &lockfs->lock);
+    _lock(lockfs, &sig_handler);
     ret = (*lockfs->fs->fs_release_tree)(lockfs->fs, pathname);
-    _uninstall_sig_handler(&sig_handler);
-    myst_mutex_unlock(&lockfs->lock);
+    _unlock(lockfs, &sig_handler);
 
 done:
     return ret;
@@ -1020,6 +961,7 @@ int myst_lockfs_init(myst_fs_t* fs, myst_fs_t** lockfs_out)
 
     lockfs->base = _base;
     lockfs->magic = LOCKFS_MAGIC;
+    myst_rwlock_init(&lockfs->lock);
     lockfs->fs = fs;
     *lockfs_out = &lockfs->base;
 
@@ -1038,3 +980,14 @@ bool myst_is_lockfs(const myst_fs_t* fs)
 {
     return _lockfs_valid((lockfs_t*)fs);
 }
+
+int myst_lockfs_set_shared_reads(myst_fs_t* fs, bool enable)
+{
+    lockfs_t* lockfs = (lockfs_t*)fs;
+
+    if (!_lockfs_valid(lockfs))
+        return -EINVAL;
+
+    lockfs->shared_reads = enable;
+    return 0;
+}
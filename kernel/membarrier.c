@@ -0,0 +1,209 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <errno.h>
+#include <sys/mman.h>
+
+#include <myst/defs.h>
+#include <myst/eraise.h>
+#include <myst/mutex.h>
+#include <myst/once.h>
+#include <myst/panic.h>
+#include <myst/spinlock.h>
+#include <myst/syscall.h>
+#include <myst/tcall.h>
+#include <myst/thread.h>
+
+/*
+**==============================================================================
+**
+** membarrier(MEMBARRIER_CMD_PRIVATE_EXPEDITED)
+**
+** On return, every other thread of the calling process must have executed a
+** full memory barrier. Threads running enclave code cannot be interrupted
+** from within the enclave: the interrupt signal is blocked while a thread is
+** inside the enclave and only breaks host calls. Instead, the kernel has the
+** host send inter-processor interrupts to every CPU running a thread of the
+** host process, which forces those threads out of the enclave (a serializing
+** event), and waits until all CPUs have acknowledged them:
+**
+**     - with the host's own membarrier(PRIVATE_EXPEDITED) when available
+**     - otherwise by flipping the protection of a resident kernel page, which
+**       makes the host shoot down the TLB of every such CPU (this is the
+**       fallback that runtimes use in user space when membarrier is missing)
+**
+** All processes share one host process, so the barrier also reaches threads
+** of other processes, which is harmless.
+**
+**==============================================================================
+*/
+
+#define MEMBARRIER_CMD_QUERY 0
+#define MEMBARRIER_CMD_PRIVATE_EXPEDITED (1 << 3)
+#define MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED (1 << 4)
+
+#define SUPPORTED_COMMANDS \
+    (MEMBARRIER_CMD_PRIVATE_EXPEDITED | \
+     MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED)
+
+typedef enum method
+{
+    METHOD_NONE,
+    METHOD_HOST_MEMBARRIER,
+    METHOD_HOST_MPROTECT,
+} method_t;
+
+static method_t _method;
+static myst_once_t _once;
+
+/* serializes use of the page below */
+static myst_mutex_t _mutex;
+
+/* page whose protection is flipped by the mprotect fallback */
+static uint8_t _page[PAGE_SIZE] MYST_ALIGN(PAGE_SIZE);
+
+static int _flip_page(void)
+{
+    int ret = 0;
+
+    myst_mutex_lock(&_mutex);
+    {
+        /* the page must be resident for the host to flush it */
+        *(volatile uint8_t*)_page = 1;
+
+        ret = myst_tcall_mprotect(_page, PAGE_SIZE, PROT_READ);
+
+        if (ret == 0)
+        {
+            ret = myst_tcall_mprotect(_page, PAGE_SIZE, PROT_READ | PROT_WRITE);
+
+            /* the kernel cannot continue with a read-only data page */
+            if (ret != 0)
+                myst_panic("membarrier: failed to restore page protection");
+        }
+    }
+    myst_mutex_unlock(&_mutex);
+
+    return ret;
+}
+
+static void _select_method(void)
+{
+    const int cmd = MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED;
+
+    /* the host process registers once on behalf of all processes */
+    if (myst_tcall_membarrier(cmd, 0) == 0)
+        _method = METHOD_HOST_MEMBARRIER;
+    else if (_flip_page() == 0)
+        _method = METHOD_HOST_MPROTECT;
+    else
+        _method = METHOD_NONE;
+}
+
+static method_t _get_method(void)
+{
+    myst_once(&_once, _select_method);
+    return _method;
+}
+
+/* whether the thread is the only thread of its process */
+static bool _single_threaded(myst_thread_t* thread)
+{
+    myst_process_t* process = thread->process;
+    bool ret = true;
+
+    myst_spin_lock(&process->thread_group_lock);
+    {
+        for (myst_thread_t* t = process->main_process_thread; t;
+             t = t->group_next)
+        {
+            if (t != thread && t->thread_status == MYST_RUNNING)
+            {
+                ret = false;
+                break;
+            }
+        }
+    }
+    myst_spin_unlock(&process->thread_group_lock);
+
+    return ret;
+}
+
+static int _private_expedited(myst_thread_t* thread)
+{
+    int ret = 0;
+
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    /* there is nobody to synchronize with */
+    if (_single_threaded(thread))
+        goto done;
+
+    switch (_get_method())
+    {
+        case METHOD_HOST_MEMBARRIER:
+        {
+            const int cmd = MEMBARRIER_CMD_PRIVATE_EXPEDITED;
+            ECHECK(myst_tcall_membarrier(cmd, 0));
+            break;
+        }
+        case METHOD_HOST_MPROTECT:
+        {
+            ECHECK(_flip_page());
+            break;
+        }
+        default:
+        {
+            ERAISE(-EINVAL);
+        }
+    }
+
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+done:
+    return ret;
+}
+
+long myst_syscall_membarrier(int cmd, unsigned int flags, int cpu_id)
+{
+    long ret = 0;
+    myst_thread_t* thread = myst_thread_self();
+
+    (void)cpu_id;
+
+    if (flags != 0)
+        ERAISE(-EINVAL);
+
+    switch (cmd)
+    {
+        case MEMBARRIER_CMD_QUERY:
+        {
+            if (_get_method() != METHOD_NONE)
+                ret = SUPPORTED_COMMANDS;
+            break;
+        }
+        case MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED:
+        {
+            if (_get_method() == METHOD_NONE)
+                ERAISE(-EINVAL);
+
+            thread->process->membarrier_registered = true;
+            break;
+        }
+        case MEMBARRIER_CMD_PRIVATE_EXPEDITED:
+        {
+            if (!thread->process->membarrier_registered)
+                ERAISE(-EPERM);
+
+            ECHECK(_private_expedited(thread));
+            break;
+        }
+        default:
+        {
+            ERAISE(-EINVAL);
+        }
+    }
+
+done:
+    return ret;
+}
@@ -0,0 +1,636 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <myst/cpuid.h>
+#include <myst/memops.h>
+
+/* keep GCC from turning the loops below back into calls to memcpy() */
+#pragma GCC optimize "no-tree-loop-distribute-patterns"
+
+/* unaligned vector and scalar types (aliasing any memory) */
+typedef char v16_t __attribute__((vector_size(16), aligned(1), may_alias));
+typedef char v32_t __attribute__((vector_size(32), aligned(1), may_alias));
+typedef char a16_t __attribute__((vector_size(16), aligned(16), may_alias));
+typedef char a32_t __attribute__((vector_size(32), aligned(32), may_alias));
+typedef char v16qi_t __attribute__((vector_size(16)));
+typedef char v32qi_t __attribute__((vector_size(32)));
+typedef uint64_t u64_t __attribute__((aligned(1), may_alias));
+typedef uint32_t u32_t __attribute__((aligned(1), may_alias));
+typedef uint16_t u16_t __attribute__((aligned(1), may_alias));
+
+#define AVX2 __attribute__((target("avx2")))
+#define INLINE static __inline__ __attribute__((always_inline))
+
+/* sizes at and above which "rep movsb" and "rep stosb" are used with ERMS */
+#define ERMS_MEMCPY_THRESHOLD 2048
+#define ERMS_MEMSET_THRESHOLD 2048
+
+myst_memops_t __myst_memops = {
+    .memcpy = myst_memcpy_sse2,
+    .memmove = myst_memmove_sse2,
+    .memset = myst_memset_sse2,
+    .memcmp = myst_memcmp_sse2,
+    .strlen = myst_strlen_sse2,
+};
+
+/* used by the ERMS variants below their thresholds */
+static void* (*_erms_memcpy_fallback)(void*, const void*, size_t) =
+    myst_memcpy_sse2;
+static void* (*_erms_memset_fallback)(void*, int, size_t) = myst_memset_sse2;
+
+/*
+**==============================================================================
+**
+** feature detection:
+**
+**==============================================================================
+*/
+
+static uint64_t _xgetbv(uint32_t index)
+{
+    uint32_t eax;
+    uint32_t edx;
+
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(index));
+    return ((uint64_t)edx << 32) | eax;
+}
+
+uint32_t myst_memops_features(void)
+{
+    uint32_t features = 0;
+    uint32_t max_leaf;
+    uint32_t eax, ebx, ecx, edx;
+    bool os_avx = false;
+
+    myst_cpuid(0, 0, &max_leaf, &ebx, &ecx, &edx);
+
+    if (max_leaf >= 1)
+    {
+        myst_cpuid(1, 0, &eax, &ebx, &ecx, &edx);
+
+        /* AVX is usable only if the YMM state is enabled in XCR0 (in an
+         * enclave, XCR0 reflects the XFRM the enclave was created with) */
+        const uint32_t osxsave = (1u << 27);
+        const uint32_t avx = (1u << 28);
+
+        if ((ecx & osxsave) && (ecx & avx))
+            os_avx = ((_xgetbv(0) & 0x6) == 0x6);
+    }
+
+    if (max_leaf >= 7)
+    {
+        myst_cpuid(7, 0, &eax, &ebx, &ecx, &edx);
+
+        if (os_avx && (ebx & (1u << 5)))
+            features |= MYST_MEMOPS_AVX2;
+
+        if (ebx & (1u << 9))
+            features |= MYST_MEMOPS_ERMS;
+    }
+
+    return features;
+}
+
+void myst_memops_init(void)
+{
+    const uint32_t features = myst_memops_features();
+    myst_memops_t ops = __myst_memops;
+
+    if (features & MYST_MEMOPS_AVX2)
+    {
+        ops.memcpy = myst_memcpy_avx2;
+        ops.memmove = myst_memmove_avx2;
+        ops.memset = myst_memset_avx2;
+        ops.memcmp = myst_memcmp_avx2;
+        ops.strlen = myst_strlen_avx2;
+        _erms_memcpy_fallback = myst_memcpy_avx2;
+        _erms_memset_fallback = myst_memset_avx2;
+    }
+
+    if (features & MYST_MEMOPS_ERMS)
+    {
+        ops.memcpy = myst_memcpy_erms;
+        ops.memset = myst_memset_erms;
+    }
+
+    __myst_memops = ops;
+}
+
+/*
+**==============================================================================
+**
+** copying:
+**
+** Copies of up to two vectors load everything before storing anything. Longer
+** copies load the first and last vector up front, copy the aligned middle in
+** the direction that is safe for overlapping buffers, and then store the
+** first and last vector. So every routine here is also a valid memmove().
+**
+**==============================================================================
+*/
+
+/* copy up to 32 bytes */
+INLINE void _copy_small(uint8_t* d, const uint8_t* s, size_t n)
+{
+    if (n >= 16)
+    {
+        v16_t a = *(const v16_t*)s;
+        v16_t b = *(const v16_t*)(s + n - 16);
+        *(v16_t*)d = a;
+        *(v16_t*)(d + n - 16) = b;
+    }
+    else if (n >= 8)
+    {
+        uint64_t a = *(const u64_t*)s;
+        uint64_t b = *(const u64_t*)(s + n - 8);
+        *(u64_t*)d = a;
+        *(u64_t*)(d + n - 8) = b;
+    }
+    else if (n >= 4)
+    {
+        uint32_t a = *(const u32_t*)s;
+        uint32_t b = *(const u32_t*)(s + n - 4);
+        *(u32_t*)d = a;
+        *(u32_t*)(d + n - 4) = b;
+    }
+    else if (n >= 2)
+    {
+        uint16_t a = *(const u16_t*)s;
+        uint16_t b = *(const u16_t*)(s + n - 2);
+        *(u16_t*)d = a;
+        *(u16_t*)(d + n - 2) = b;
+    }
+    else if (n == 1)
+    {
+        *d = *s;
+    }
+}
+
+/* copy n > 32 bytes, 16 bytes at a time */
+INLINE void _copy_sse2(uint8_t* d, const uint8_t* s, size_t n)
+{
+    const v16_t head = *(const v16_t*)s;
+    const v16_t tail = *(const v16_t*)(s + n - 16);
+
+    if ((uintptr_t)d - (uintptr_t)s >= n)
+    {
+        /* forward (no overlap or dest below src) */
+        uint8_t* end = d + n - 16;
+        size_t skew = 16 - ((uintptr_t)d & 15);
+        uint8_t* p = d + skew;
+        const uint8_t* q = s + skew;
+
+        while (p + 64 <= end)
+        {
+            v16_t a = *(const v16_t*)q;
+            v16_t b = *(const v16_t*)(q + 16);
+            v16_t c = *(const v16_t*)(q + 32);
+            v16_t e = *(const v16_t*)(q + 48);
+            *(a16_t*)p = a;
+            *(a16_t*)(p + 16) = b;
+            *(a16_t*)(p + 32) = c;
+            *(a16_t*)(p + 48) = e;
+            p += 64;
+            q += 64;
+        }
+
+        while (p < end)
+        {
+            *(a16_t*)p = *(const v16_t*)q;
+            p += 16;
+            q += 16;
+        }
+    }
+    else
+    {
+        /* backward (dest overlaps the end of src) */
+        uint8_t* p = d + n - ((uintptr_t)(d + n) & 15);
+        const uint8_t* q = s + (p - d);
+
+        while (p >= d + 64)
+        {
+            p -= 64;
+            q -= 64;
+            v16_t a = *(const v16_t*)q;
+            v16_t b = *(const v16_t*)(q + 16);
+            v16_t c = *(const v16_t*)(q + 32);
+            v16_t e = *(const v16_t*)(q + 48);
+            *(a16_t*)p = a;
+            *(a16_t*)(p + 16) = b;
+            *(a16_t*)(p + 32) = c;
+            *(a16_t*)(p + 48) = e;
+        }
+
+        while (p >= d + 16)
+        {
+            p -= 16;
+            q -= 16;
+            *(a16_t*)p = *(const v16_t*)q;
+        }
+    }
+
+    *(v16_t*)d = head;
+    *(v16_t*)(d + n - 16) = tail;
+}
+
+/* copy n > 64 bytes, 32 bytes at a time */
+AVX2 INLINE void _copy_avx2(uint8_t* d, const uint8_t* s, size_t n)
+{
+    const v32_t head = *(const v32_t*)s;
+    const v32_t tail = *(const v32_t*)(s + n - 32);
+
+    if ((uintptr_t)d - (uintptr_t)s >= n)
+    {
+        uint8_t* end = d + n - 32;
+        size_t skew = 32 - ((uintptr_t)d & 31);
+        uint8_t* p = d + skew;
+        const uint8_t* q = s + skew;
+
+        while (p + 128 <= end)
+        {
+            v32_t a = *(const v32_t*)q;
+            v32_t b = *(const v32_t*)(q + 32);
+            v32_t c = *(const v32_t*)(q + 64);
+            v32_t e = *(const v32_t*)(q + 96);
+            *(a32_t*)p = a;
+            *(a32_t*)(p + 32) = b;
+            *(a32_t*)(p + 64) = c;
+            *(a32_t*)(p + 96) = e;
+            p += 128;
+            q += 128;
+        }
+
+        while (p < end)
+        {
+            *(a32_t*)p = *(const v32_t*)q;
+            p += 32;
+            q += 32;
+        }
+    }
+    else
+    {
+        uint8_t* p = d + n - ((uintptr_t)(d + n) & 31);
+        const uint8_t* q = s + (p - d);
+
+        while (p >= d + 128)
+        {
+            p -= 128;
+            q -= 128;
+            v32_t a = *(const v32_t*)q;
+            v32_t b = *(const v32_t*)(q + 32);
+            v32_t c = *(const v32_t*)(q + 64);
+            v32_t e = *(const v32_t*)(q + 96);
+            *(a32_t*)p = a;
+            *(a32_t*)(p + 32) = b;
+            *(a32_t*)(p + 64) = c;
+            *(a32_t*)(p + 96) = e;
+        }
+
+        while (p >= d + 32)
+        {
+            p -= 32;
+            q -= 32;
+            *(a32_t*)p = *(const v32_t*)q;
+        }
+    }
+
+    *(v32_t*)d = head;
+    *(v32_t*)(d + n - 32) = tail;
+}
+
+void* myst_memmove_sse2(void* dest, const void* src, size_t n)
+{
+    if (n <= 32)
+        _copy_small(dest, src, n);
+    else
+        _copy_sse2(dest, src, n);
+
+    return dest;
+}
+
+void* myst_memcpy_sse2(void* dest, const void* src, size_t n)
+{
+    return myst_memmove_sse2(dest, src, n);
+}
+
+AVX2 void* myst_memmove_avx2(void* dest, const void* src, size_t n)
+{
+    if (n <= 32)
+    {
+        _copy_small(dest, src, n);
+    }
+    else if (n <= 64)
+    {
+        v32_t a = *(const v32_t*)src;
+        v32_t b = *(const v32_t*)((const uint8_t*)src + n - 32);
+        *(v32_t*)dest = a;
+        *(v32_t*)((uint8_t*)dest + n - 32) = b;
+    }
+    else
+    {
+        _copy_avx2(dest, src, n);
+    }
+
+    return dest;
+}
+
+AVX2 void* myst_memcpy_avx2(void* dest, const void* src, size_t n)
+{
+    return myst_memmove_avx2(dest, src, n);
+}
+
+/* not a valid memmove(): "rep movsb" only copies forward */
+void* myst_memcpy_erms(void* dest, const void* src, size_t n)
+{
+    void* d = dest;
+
+    if (n < ERMS_MEMCPY_THRESHOLD)
+        return (*_erms_memcpy_fallback)(dest, src, n);
+
+    __asm__ volatile("rep movsb"
+                     : "+D"(d), "+S"(src), "+c"(n)
+                     :
+                     : "memory");
+
+    return dest;
+}
+
+/*
+**==============================================================================
+**
+** filling:
+**
+**==============================================================================
+*/
+
+/* fill up to 32 bytes */
+INLINE void _fill_small(uint8_t* p, uint8_t c, size_t n)
+{
+    const uint64_t cc = 0x0101010101010101ull * c;
+
+    if (n >= 16)
+    {
+        *(u64_t*)p = cc;
+        *(u64_t*)(p + 8) = cc;
+        *(u64_t*)(p + n - 16) = cc;
+        *(u64_t*)(p + n - 8) = cc;
+    }
+    else if (n >= 8)
+    {
+        *(u64_t*)p = cc;
+        *(u64_t*)(p + n - 8) = cc;
+    }
+    else if (n >= 4)
+    {
+        *(u32_t*)p = (uint32_t)cc;
+        *(u32_t*)(p + n - 4) = (uint32_t)cc;
+    }
+    else if (n >= 2)
+    {
+        *(u16_t*)p = (uint16_t)cc;
+        *(u16_t*)(p + n - 2) = (uint16_t)cc;
+    }
+    else if (n == 1)
+    {
+        *p = c;
+    }
+}
+
+void* myst_memset_sse2(void* s, int c, size_t n)
+{
+    uint8_t* p = s;
+
+    if (n <= 32)
+    {
+        _fill_small(p, (uint8_t)c, n);
+    }
+    else
+    {
+        const v16_t v = (v16_t){0} + (char)c;
+        uint8_t* end = p + n - 16;
+        uint8_t* q = p + 16 - ((uintptr_t)p & 15);
+
+        *(v16_t*)p = v;
+
+        while (q + 64 <= end)
+        {
+            *(a16_t*)q = v;
+            *(a16_t*)(q + 16) = v;
+            *(a16_t*)(q + 32) = v;
+            *(a16_t*)(q + 48) = v;
+            q += 64;
+        }
+
+        while (q < end)
+        {
+            *(a16_t*)q = v;
+            q += 16;
+        }
+
+        *(v16_t*)end = v;
+    }
+
+    return s;
+}
+
+AVX2 void* myst_memset_avx2(void* s, int c, size_t n)
+{
+    uint8_t* p = s;
+
+    if (n <= 32)
+    {
+        _fill_small(p, (uint8_t)c, n);
+    }
+    else if (n <= 64)
+    {
+        const v32_t v = (v32_t){0} + (char)c;
+        *(v32_t*)p = v;
+        *(v32_t*)(p + n - 32) = v;
+    }
+    else
+    {
+        const v32_t v = (v32_t){0} + (char)c;
+        uint8_t* end = p + n - 32;
+        uint8_t* q = p + 32 - ((uintptr_t)p & 31);
+
+        *(v32_t*)p = v;
+
+        while (q + 128 <= end)
+        {
+            *(a32_t*)q = v;
+            *(a32_t*)(q + 32) = v;
+            *(a32_t*)(q + 64) = v;
+            *(a32_t*)(q + 96) = v;
+            q += 128;
+        }
+
+        while (q < end)
+        {
+            *(a32_t*)q = v;
+            q += 32;
+        }
+
+        *(v32_t*)end = v;
+    }
+
+    return s;
+}
+
+void* myst_memset_erms(void* s, int c, size_t n)
+{
+    void* p = s;
+
+    if (n < ERMS_MEMSET_THRESHOLD)
+        return (*_erms_memset_fallback)(s, c, n);
+
+    __asm__ volatile("rep stosb" : "+D"(p), "+c"(n) : "a"(c) : "memory");
+
+    return s;
+}
+
+/*
+**==============================================================================
+**
+** comparing and scanning:
+**
+**==============================================================================
+*/
+
+INLINE int _compare_bytes(const uint8_t* p, const uint8_t* q, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        if (p[i] != q[i])
+            return (int)p[i] - (int)q[i];
+    }
+
+    return 0;
+}
+
+/* bit i of the result is set if byte i of a and b are equal */
+INLINE uint32_t _equal_mask16(v16_t a, v16_t b)
+{
+    return (uint32_t)__builtin_ia32_pmovmskb128((v16qi_t)(a == b));
+}
+
+AVX2 INLINE uint32_t _equal_mask32(v32_t a, v32_t b)
+{
+    return (uint32_t)__builtin_ia32_pmovmskb256((v32qi_t)(a == b));
+}
+
+int myst_memcmp_sse2(const void* s1, const void* s2, size_t n)
+{
+    const uint8_t* p = s1;
+    const uint8_t* q = s2;
+    size_t i = 0;
+    uint32_t mask;
+
+    if (n < 16)
+        return _compare_bytes(p, q, n);
+
+    for (; i + 16 <= n; i += 16)
+    {
+        mask = _equal_mask16(*(const v16_t*)(p + i), *(const v16_t*)(q + i));
+
+        if (mask != 0xffff)
+            goto differ;
+    }
+
+    if (i == n)
+        return 0;
+
+    /* compare the last 16 bytes (overlapping bytes already compared) */
+    i = n - 16;
+    mask = _equal_mask16(*(const v16_t*)(p + i), *(const v16_t*)(q + i));
+
+    if (mask == 0xffff)
+        return 0;
+
+differ:
+    i += (size_t)__builtin_ctz(~mask);
+    return (int)p[i] - (int)q[i];
+}
+
+AVX2 int myst_memcmp_avx2(const void* s1, const void* s2, size_t n)
+{
+    const uint8_t* p = s1;
+    const uint8_t* q = s2;
+    size_t i = 0;
+    uint32_t mask;
+
+    if (n < 32)
+        return myst_memcmp_sse2(s1, s2, n);
+
+    for (; i + 32 <= n; i += 32)
+    {
+        mask = _equal_mask32(*(const v32_t*)(p + i), *(const v32_t*)(q + i));
+
+        if (mask != 0xffffffff)
+            goto differ;
+    }
+
+    if (i == n)
+        return 0;
+
+    i = n - 32;
+    mask = _equal_mask32(*(const v32_t*)(p + i), *(const v32_t*)(q + i));
+
+    if (mask == 0xffffffff)
+        return 0;
+
+differ:
+    i += (size_t)__builtin_ctz(~mask);
+    return (int)p[i] - (int)q[i];
+}
+
+/* Aligned loads never cross a page boundary, so reading a whole vector that
+ * contains the terminator cannot fault even if it extends past the string.
+ */
+size_t myst_strlen_sse2(const char* s)
+{
+    const size_t skew = (uintptr_t)s & 15;
+    const char* p = s - skew;
+    const v16_t zero = {0};
+    uint32_t mask;
+
+    /* ignore matches before the start of the string */
+    mask = _equal_mask16(*(const a16_t*)p, zero) >> skew;
+
+    if (mask)
+        return (size_t)__builtin_ctz(mask);
+
+    for (;;)
+    {
+        p += 16;
+        mask = _equal_mask16(*(const a16_t*)p, zero);
+
+        if (mask)
+            return (size_t)(p - s) + (size_t)__builtin_ctz(mask);
+    }
+}
+
+AVX2 size_t myst_strlen_avx2(const char* s)
+{
+    const size_t skew = (uintptr_t)s & 31;
+    const char* p = s - skew;
+    const v32_t zero = {0};
+    uint32_t mask;
+
+    mask = _equal_mask32(*(const a32_t*)p, zero) >> skew;
+
+    if (mask)
+        return (size_t)__builtin_ctz(mask);
+
+    for (;;)
+    {
+        p += 32;
+        mask = _equal_mask32(*(const a32_t*)p, zero);
+
+        if (mask)
+            return (size_t)(p - s) + (size_t)__builtin_ctz(mask);
+    }
+}
@@ -1880,6 +1880,195 @@ done:
     return ret;
 }
 
+/* Discard the contents of the given pages so that the next access sees zeros */
+static int _madvise_dontneed(myst_mman_t* mman, void* addr, size_t length)
+{
+    size_t start_page_index = ((uintptr_t)addr - mman->start) / PAGE_SIZE;
+    size_t npages = length / PAGE_SIZE;
+    size_t i = 0;
+
+    /* Let the host release the pages and zero-fill them on the next access */
+    if (myst_tcall_madvise(addr, length, MYST_MADV_DONTNEED) == 0)
+    {
+        mman->released_size += length;
+        return 0;
+    }
+
+    /* Otherwise zero-fill runs of pages with the same protection (the pages
+     * stay committed to the mapping and the free memory does not grow) */
+    while (i < npages)
+    {
+        const uint8_t prot = mman->prot_vector[start_page_index + i];
+        uint8_t* run = (uint8_t*)addr + i * PAGE_SIZE;
+        size_t n = 1;
+
+        while (i + n < npages &&
+               mman->prot_vector[start_page_index + i + n] == prot)
+        {
+            n++;
+        }
+
+        if ((prot & ~MYST_PENDING_ZEROING_FLAG) == MYST_PROT_NONE)
+        {
+            /* defer to the mprotect() that makes the pages accessible */
+            memset(
+                &mman->prot_vector[start_page_index + i],
+                MYST_PENDING_ZEROING_FLAG,
+                n);
+        }
+        else if (prot & MYST_PROT_WRITE)
+        {
+            memset(run, 0, n * PAGE_SIZE);
+        }
+        else
+        {
+            /* For readonly memory, need to set w permission first to clear the
+             * memory */
+            if (myst_tcall_mprotect(run, n * PAGE_SIZE, prot | MYST_PROT_WRITE))
+            {
+                _mman_set_err(mman, "mprotect tcall failed");
+                return -EINVAL;
+            }
+
+            memset(run, 0, n * PAGE_SIZE);
+
+            if (myst_tcall_mprotect(run, n * PAGE_SIZE, prot))
+            {
+                _mman_set_err(mman, "mprotect tcall failed");
+                return -EINVAL;
+            }
+        }
+
+        i += n;
+    }
+
+    return 0;
+}
+
+/*
+**
+** myst_mman_madvise()
+**
+**     Advise the mman about the expected use of a range of mapped pages.
+**
+** Parameters:
+**     [IN] mman - mman structure
+**     [IN] addr - starting address of the memory region (page aligned)
+**     [IN] len - length of the memory region in bytes
+**     [IN] advice - MYST_MADV_????
+**
+** Returns:
+**     0 if operation succeeded
+**
+** Implementation:
+**     MYST_MADV_DONTNEED discards the contents of the pages. The pages are
+**     first offered back to the host with a madvise() TCALL, which releases
+**     the backing memory and zero-fills it on the next access. When the host
+**     cannot take the pages back (SGX enclave memory), inaccessible pages are
+**     flagged for zero-filling by the next mprotect() and the others are
+**     zero-filled immediately. The pages then stay committed: they remain
+**     part of the mapping, so they are not returned to the free memory of
+**     the mman either, and only released_size reflects memory given back.
+**
+**     MYST_MADV_FREE lets the host reclaim the pages lazily. The contents of
+**     such pages are undefined until they are written again, so keeping them
+**     intact is also correct when the host refuses.
+**
+**     The remaining advice values are hints, which are accepted and ignored.
+**     In particular, file mappings are read in full by mmap(), so there is
+**     nothing to prefetch for MYST_MADV_WILLNEED.
+**
+*/
+int myst_mman_madvise(myst_mman_t* mman, void* addr, size_t len, int advice)
+{
+    int ret = 0;
+    uintptr_t end = 0;
+    bool locked = false;
+
+    if (len == 0)
+        return 0;
+
+    _mman_lock(mman, &locked);
+
+    _mman_clear_err(mman);
+
+    /* Check for valid mman parameter */
+    if (!mman || mman->magic != MYST_MMAN_MAGIC || !addr)
+    {
+        _mman_set_err(mman, "invalid parameter");
+        ret = -EINVAL;
+        goto done;
+    }
+
+    if (!_mman_is_sane(mman))
+    {
+        ret = -EINVAL;
+        goto done;
+    }
+
+    /* ADDR must be page aligned */
+    if ((uintptr_t)addr % PAGE_SIZE)
+    {
+        _mman_set_err(
+            mman, "bad addr parameter: must be multiple of page size");
+        ret = -EINVAL;
+        goto done;
+    }
+
+    /* Round len to multiple of page size */
+    if (myst_round_up(len, PAGE_SIZE, &len) != 0)
+    {
+        _mman_set_err(mman, "rounding error: len");
+        ret = -EINVAL;
+        goto done;
+    }
+
+    /* The range must lie within the break or the mapped memory */
+    if ((uintptr_t)addr < mman->start ||
+        __builtin_add_overflow((uintptr_t)addr, len, &end) ||
+        end > mman->end ||
+        ((uintptr_t)addr < mman->map && end > mman->brk &&
+         mman->brk < mman->map))
+    {
+        _mman_set_err(mman, "bad addr parameter: range is not mapped");
+        ret = -ENOMEM;
+        goto done;
+    }
+
+    switch (advice)
+    {
+        case MYST_MADV_DONTNEED:
+        {
+            if ((ret = _madvise_dontneed(mman, addr, len)) == 0)
+                mman->dontneed_size += len;
+            break;
+        }
+        case MYST_MADV_FREE:
+        {
+            if (myst_tcall_madvise(addr, len, MYST_MADV_FREE) == 0)
+                mman->lazyfree_size += len;
+            break;
+        }
+        case MYST_MADV_NORMAL:
+        case MYST_MADV_RANDOM:
+        case MYST_MADV_SEQUENTIAL:
+        case MYST_MADV_WILLNEED:
+        {
+            break;
+        }
+        default:
+        {
+            _mman_set_err(mman, "bad advice parameter");
+            ret = -EINVAL;
+            break;
+        }
+    }
+
+done:
+    _mman_unlock(mman, &locked);
+    return ret;
+}
+
 /*
 **
 ** myst_mman_is_sane()
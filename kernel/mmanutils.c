@@ -19,6 +19,7 @@
 #include <myst/mman.h>
 #include <myst/mmanutils.h>
 #include <myst/mutex.h>
+#include <myst/numa.h>
 #include <myst/once.h>
 #include <myst/panic.h>
 #include <myst/printf.h>
@@ -26,6 +27,7 @@
 #include <myst/procfs.h>
 #include <myst/refstr.h>
 #include <myst/round.h>
+#include <myst/shmfs.h>
 #include <myst/strings.h>
 #include <myst/syscall.h>
 #include <myst/trace.h>
@@ -535,6 +537,76 @@ int myst_mprotect(const void* addr, const size_t len, const int prot)
     return (myst_mman_mprotect(&_mman, (void*)addr, len, prot));
 }
 
+int myst_madvise(void* addr, size_t length, int advice)
+{
+    int ret = 0;
+    bool locked = false;
+    size_t index;
+    vectors_t v = _get_vectors();
+
+    if (!addr || ((uint64_t)addr % PAGE_SIZE))
+        ERAISE(-EINVAL);
+
+    if (!length)
+        goto done;
+
+    /* the other advice values are hints that do not touch the pages */
+    if (advice != MYST_MADV_DONTNEED && advice != MYST_MADV_FREE)
+    {
+        ECHECK(myst_mman_madvise(&_mman, addr, length, advice));
+        goto done;
+    }
+
+    /* fail with ENOMEM if the range is not mapped */
+    ECHECK(myst_mman_madvise(&_mman, addr, length, MYST_MADV_NORMAL));
+
+    ECHECK(myst_round_up(length, PAGE_SIZE, &length));
+
+    /* the processes share the mman: only discard pages of the caller */
+    if (myst_mman_pids_test(addr, length, myst_getpid()) != (ssize_t)length)
+        ERAISE(-ENOMEM);
+
+    ECHECK((index = _get_page_index(addr, length)));
+
+    /* File mappings are written back by msync() and munmap() like shared
+     * mappings, so their pages keep their contents (as in the page cache) and
+     * the advice only applies to the runs of anonymous pages in between.
+     */
+    _rlock(&locked);
+    {
+        const size_t n = index + length / PAGE_SIZE;
+        size_t i = index;
+
+        while (i < n)
+        {
+            size_t j = i;
+
+            if (v.fdmappings[i].used == MYST_FDMAPPING_USED)
+            {
+                i++;
+                continue;
+            }
+
+            while (j < n && v.fdmappings[j].used != MYST_FDMAPPING_USED)
+                j++;
+
+            ECHECK(myst_mman_madvise(
+                &_mman,
+                (uint8_t*)_mman_start + i * PAGE_SIZE,
+                (j - i) * PAGE_SIZE,
+                advice));
+
+            i = j;
+        }
+    }
+    _runlock(&locked);
+
+done:
+    _runlock(&locked);
+
+    return ret;
+}
+
 typedef struct fdlist
 {
     int fd;
@@ -708,6 +780,10 @@ int myst_release_process_mappings(pid_t pid)
     if (pid <= 0)
         ERAISE(-EINVAL);
 
+    /* shm object pages are not owned by the process */
+    myst_shmfs_release_process(pid);
+    myst_numa_release_process(pid);
+
     {
         uint8_t* addr = (uint8_t*)_mman.map;
         size_t length = ((uint8_t*)_mman.end) - addr;
@@ -1121,6 +1197,9 @@ void myst_mman_stats(myst_mman_stats_t* buf)
     buf->map_size = _mman.end - _mman.map;
     buf->free_size = _mman.map - _mman.brk;
     buf->used_size = buf->brk_size + buf->map_size;
+    buf->dontneed_size = _mman.dontneed_size;
+    buf->lazyfree_size = _mman.lazyfree_size;
+    buf->released_size = _mman.released_size;
 }
 
 typedef enum mman_pids_op
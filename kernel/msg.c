@@ -2,6 +2,8 @@
 // Licensed under the MIT License.
 
 #define _GNU_SOURCE
+#include <sys/uio.h>
+
 #include <myst/eraise.h>
 #include <myst/fdtable.h>
 #include <myst/msg.h>
@@ -53,6 +55,17 @@ long myst_syscall_sendmmsg(
 
     ECHECK(myst_fdtable_get_sock(fdtable, sockfd, &sd, &sock));
 
+    /* Linux silently truncates vlen to UIO_MAXIOV */
+    if (vlen > UIO_MAXIOV)
+        vlen = UIO_MAXIOV;
+
+    /* send all messages with a single call if the device supports it */
+    if (sd->sd_sendmmsg)
+    {
+        ret = (*sd->sd_sendmmsg)(sd, sock, msgvec, vlen, flags);
+        goto done;
+    }
+
     for (cnt = 0; cnt < vlen; cnt++)
     {
         ret = (*sd->sd_sendmsg)(sd, sock, &msgvec[cnt].msg_hdr, flags);
@@ -96,6 +109,18 @@ long myst_syscall_recvmmsg(
         expire = timespec_to_nanos(timeout);
         myst_syscall_clock_gettime(CLOCK_MONOTONIC, &start);
     }
+
+    /* Linux silently truncates vlen to UIO_MAXIOV */
+    if (vlen > UIO_MAXIOV)
+        vlen = UIO_MAXIOV;
+
+    /* receive all messages with a single call if the device supports it */
+    if (sd->sd_recvmmsg)
+    {
+        ret = (*sd->sd_recvmmsg)(sd, sock, msgvec, vlen, flags, timeout);
+        goto done;
+    }
+
     for (cnt = 0; cnt < vlen; cnt++)
     {
         // The MSG_WAITFORONE flag is only recognizable by recvmmsg
@@ -106,7 +131,7 @@ long myst_syscall_recvmmsg(
         msgvec[cnt].msg_len = ret;
         // Turns on MSG_DONTWAIT after the first message has been
         // received.
-        if (cnt == 1 && flags & MSG_WAITFORONE)
+        if (cnt == 0 && flags & MSG_WAITFORONE)
             flags |= MSG_DONTWAIT;
         if (timeout)
         {
@@ -0,0 +1,711 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include <myst/cpuid.h>
+#include <myst/defs.h>
+#include <myst/eraise.h>
+#include <myst/hostfile.h>
+#include <myst/mmanutils.h>
+#include <myst/numa.h>
+#include <myst/process.h>
+#include <myst/round.h>
+#include <myst/spinlock.h>
+#include <myst/syscall.h>
+#include <myst/tcall.h>
+#include <myst/thread.h>
+
+/*
+**==============================================================================
+**
+** NUMA support
+**
+** The kernel takes a snapshot of the host's NUMA topology during boot and
+** exposes it unchanged (see sysfs.c), so NUMA-aware runtimes see the sockets
+** they actually run on.
+**
+** getcpu() is served in the kernel with RDPID, which reads IA32_TSC_AUX.
+** Linux loads that MSR with (node << 12) | cpu on every CPU (this is what its
+** vDSO getcpu() uses). RDTSCP returns the same value but raises #UD inside
+** SGX1 enclaves, so it is not used. RDPID is only trusted after it matched
+** the host's getcpu() during boot; otherwise getcpu() is a host call.
+**
+** Memory policies set with set_mempolicy() are recorded per thread and
+** passed down to the host for every private mapping the thread creates. The
+** policies of address ranges (mbind) are recorded per process and passed down
+** to the host as well. The host applies them to the memory region that backs
+** the range, which places the pages on the Linux target. The EPC pages that
+** back an SGX enclave are not subject to host policies (the SGX target
+** declines with ENOTSUP): there the policies are recorded and reported but
+** have no effect on placement.
+**
+**==============================================================================
+*/
+
+#define MPOL_DEFAULT 0
+#define MPOL_PREFERRED 1
+#define MPOL_BIND 2
+#define MPOL_INTERLEAVE 3
+#define MPOL_LOCAL 4
+#define MPOL_PREFERRED_MANY 5
+
+/* mode flags of set_mempolicy() and mbind() */
+#define MPOL_F_STATIC_NODES (1 << 15)
+#define MPOL_F_RELATIVE_NODES (1 << 14)
+#define MPOL_MODE_FLAGS (MPOL_F_STATIC_NODES | MPOL_F_RELATIVE_NODES)
+
+/* flags of get_mempolicy() */
+#define MPOL_F_NODE (1 << 0)
+#define MPOL_F_ADDR (1 << 1)
+#define MPOL_F_MEMS_ALLOWED (1 << 2)
+
+/* flags of mbind() */
+#define MPOL_MF_STRICT (1 << 0)
+#define MPOL_MF_MOVE (1 << 1)
+#define MPOL_MF_MOVE_ALL (1 << 2)
+
+#define NODE_LIST_PATH "/sys/devices/system/node/online"
+
+/* IA32_TSC_AUX as loaded by Linux */
+#define TSC_AUX_CPU_MASK 0xfff
+#define TSC_AUX_NODE_SHIFT 12
+
+/* CPUID.(EAX=07H,ECX=0):ECX.RDPID[bit 22] */
+#define CPUID_7_ECX_RDPID (1u << 22)
+
+/* a policy set with mbind() (until the range is unmapped) */
+typedef struct range_policy range_policy_t;
+
+struct range_policy
+{
+    range_policy_t* next;
+    pid_t pid;
+    uint8_t* addr;
+    size_t length;
+    int mode;
+    uint64_t nodemask;
+};
+
+static range_policy_t* _range_policies;
+static myst_spinlock_t _range_policies_lock = MYST_SPINLOCK_INITIALIZER;
+
+static uint64_t _online_nodes = 1;
+static unsigned _ncpus = 1;
+static bool _use_rdpid;
+
+MYST_INLINE uint64_t _rdpid(void)
+{
+    uint64_t r;
+    __asm__ volatile("rdpid %0" : "=r"(r));
+    return r;
+}
+
+static long _host_getcpu(unsigned* cpu, unsigned* node)
+{
+    long params[6] = {(long)cpu, (long)node, (long)NULL};
+    return myst_tcall(SYS_getcpu, params);
+}
+
+static bool _check_rdpid(void)
+{
+    uint32_t max_leaf;
+    uint32_t eax;
+    uint32_t ebx;
+    uint32_t ecx;
+    uint32_t edx;
+
+    myst_cpuid(0, 0, &max_leaf, &ebx, &ecx, &edx);
+
+    if (max_leaf < 7)
+        return false;
+
+    myst_cpuid(7, 0, &eax, &ebx, &ecx, &edx);
+
+    if (!(ecx & CPUID_7_ECX_RDPID))
+        return false;
+
+    /* the thread may migrate during the host call, so only compare when
+     * RDPID returned the same value before and after it */
+    for (size_t i = 0; i < 8; i++)
+    {
+        unsigned cpu;
+        unsigned node;
+        const uint64_t before = _rdpid();
+
+        if (_host_getcpu(&cpu, &node) != 0)
+            return false;
+
+        if (_rdpid() != before)
+            continue;
+
+        return (before & TSC_AUX_CPU_MASK) == cpu &&
+               (before >> TSC_AUX_NODE_SHIFT) == node;
+    }
+
+    return false;
+}
+
+/* parse a list such as "0-1,4" into a node mask */
+static int _parse_node_list(const char* str, uint64_t* mask)
+{
+    int ret = 0;
+    const char* p = str;
+    uint64_t m = 0;
+
+    while (*p && *p != '\n')
+    {
+        char* end;
+        unsigned long first;
+        unsigned long last;
+
+        first = strtoul(p, &end, 10);
+
+        if (end == p)
+            ERAISE(-EINVAL);
+
+        last = first;
+        p = end;
+
+        if (*p == '-')
+        {
+            p++;
+            last = strtoul(p, &end, 10);
+
+            if (end == p || last < first)
+                ERAISE(-EINVAL);
+
+            p = end;
+        }
+
+        if (last >= MYST_NUMA_MAX_NODES)
+            ERAISE(-ERANGE);
+
+        for (unsigned long i = first; i <= last; i++)
+            m |= (1UL << i);
+
+        if (*p == ',')
+            p++;
+        else if (*p && *p != '\n')
+            ERAISE(-EINVAL);
+    }
+
+    if (m == 0)
+        ERAISE(-EINVAL);
+
+    *mask = m;
+
+done:
+    return ret;
+}
+
+int myst_numa_setup(void)
+{
+    void* data = NULL;
+    size_t size;
+
+    /* hosts without NUMA support have a single node */
+    if (myst_load_host_file(NODE_LIST_PATH, &data, &size) == 0)
+    {
+        if (_parse_node_list(data, &_online_nodes) != 0)
+            _online_nodes = 1;
+
+        free(data);
+    }
+
+    /* the boot thread may run on any CPU (up to max_affinity_cpus) */
+    {
+        cpu_set_t set;
+
+        if (myst_syscall_sched_getaffinity(0, sizeof(set), &set) > 0)
+        {
+            for (unsigned cpu = 0; cpu < CPU_SETSIZE; cpu++)
+            {
+                if (CPU_ISSET(cpu, &set))
+                    _ncpus = cpu + 1;
+            }
+        }
+    }
+
+    _use_rdpid = _check_rdpid();
+
+    return 0;
+}
+
+uint64_t myst_numa_online_nodes(void)
+{
+    return _online_nodes;
+}
+
+unsigned myst_numa_ncpus(void)
+{
+    return _ncpus;
+}
+
+bool myst_numa_getcpu_fast(unsigned* cpu, unsigned* node)
+{
+    if (!_use_rdpid)
+        return false;
+
+    const uint64_t aux = _rdpid();
+
+    if (cpu)
+        *cpu = (unsigned)(aux & TSC_AUX_CPU_MASK);
+
+    if (node)
+        *node = (unsigned)(aux >> TSC_AUX_NODE_SHIFT);
+
+    return true;
+}
+
+long myst_numa_getcpu(unsigned* cpu, unsigned* node)
+{
+    if (myst_numa_getcpu_fast(cpu, node))
+        return 0;
+
+    return _host_getcpu(cpu, node);
+}
+
+/*
+**==============================================================================
+**
+** memory policies
+**
+**==============================================================================
+*/
+
+/* copy in a node mask of maxnode - 1 bits (as Linux does) */
+static int _get_nodemask(
+    const unsigned long* nodemask,
+    unsigned long maxnode,
+    uint64_t* mask)
+{
+    int ret = 0;
+    size_t nwords;
+
+    *mask = 0;
+
+    if (!nodemask || maxnode <= 1)
+        goto done;
+
+    maxnode--;
+
+    if (maxnode > PAGE_SIZE * 8)
+        ERAISE(-EINVAL);
+
+    nwords = (maxnode + 63) / 64;
+
+    if (myst_is_bad_addr_read(nodemask, nwords * sizeof(unsigned long)))
+        ERAISE(-EFAULT);
+
+    for (size_t i = 0; i < nwords; i++)
+    {
+        unsigned long word = nodemask[i];
+        const unsigned long nbits = maxnode - (i * 64);
+
+        if (nbits < 64)
+            word &= (1UL << nbits) - 1;
+
+        if (i == 0)
+            *mask = word;
+        else if (word)
+            ERAISE(-EINVAL); /* there are at most 64 nodes */
+    }
+
+done:
+    return ret;
+}
+
+static int _check_policy(int mode, uint64_t mask)
+{
+    int ret = 0;
+    const int flags = mode & MPOL_MODE_FLAGS;
+
+    if (mode & ~(0xff | MPOL_MODE_FLAGS))
+        ERAISE(-EINVAL);
+
+    if (flags == MPOL_MODE_FLAGS)
+        ERAISE(-EINVAL);
+
+    switch (mode & ~MPOL_MODE_FLAGS)
+    {
+        case MPOL_DEFAULT:
+        case MPOL_LOCAL:
+        {
+            if (mask || flags)
+                ERAISE(-EINVAL);
+            break;
+        }
+        case MPOL_PREFERRED:
+        {
+            /* an empty mask means local allocation */
+            break;
+        }
+        case MPOL_BIND:
+        case MPOL_INTERLEAVE:
+        case MPOL_PREFERRED_MANY:
+        {
+            if (!mask)
+                ERAISE(-EINVAL);
+            break;
+        }
+        default:
+        {
+            ERAISE(-EINVAL);
+        }
+    }
+
+    /* relative masks are remapped onto the online nodes */
+    if (mask && !(flags & MPOL_F_RELATIVE_NODES) && !(mask & _online_nodes))
+        ERAISE(-EINVAL);
+
+done:
+    return ret;
+}
+
+/* pass a policy down to the host, which declines with ENOTSUP if it cannot
+ * apply policies to this memory (EPC pages) */
+static long _host_mbind(
+    void* addr,
+    size_t length,
+    int mode,
+    uint64_t mask,
+    unsigned flags)
+{
+    long ret = myst_tcall_mbind(
+        addr, length, mode, mask, MYST_NUMA_MAX_NODES + 1, flags);
+
+    return (ret == -ENOTSUP) ? 0 : ret;
+}
+
+/* remove the policies of the process within the range, splitting the ones
+ * that extend beyond it (the caller holds the lock) */
+static int _remove_range_policies(pid_t pid, uint8_t* start, uint8_t* end)
+{
+    int ret = 0;
+
+    for (range_policy_t** p = &_range_policies; *p;)
+    {
+        range_policy_t* rp = *p;
+        uint8_t* rp_end = rp->addr + rp->length;
+
+        if (rp->pid != pid || rp->addr >= end || rp_end <= start)
+        {
+            p = &rp->next;
+            continue;
+        }
+
+        if (rp->addr < start && rp_end > end)
+        {
+            range_policy_t* tail;
+
+            if (!(tail = malloc(sizeof(range_policy_t))))
+                ERAISE(-ENOMEM);
+
+            *tail = *rp;
+            tail->addr = end;
+            tail->length = (size_t)(rp_end - end);
+            rp->next = tail;
+        }
+
+        if (rp->addr < start)
+        {
+            rp->length = (size_t)(start - rp->addr);
+            p = &rp->next;
+        }
+        else if (rp_end > end)
+        {
+            rp->addr = end;
+            rp->length = (size_t)(rp_end - end);
+            p = &rp->next;
+        }
+        else
+        {
+            *p = rp->next;
+            free(rp);
+        }
+    }
+
+done:
+    return ret;
+}
+
+/* the policy of the page at addr (null if it has the default policy) */
+static const range_policy_t* _find_range_policy(pid_t pid, const void* addr)
+{
+    for (const range_policy_t* p = _range_policies; p; p = p->next)
+    {
+        if (p->pid == pid && (const uint8_t*)addr >= p->addr &&
+            (const uint8_t*)addr < p->addr + p->length)
+        {
+            return p;
+        }
+    }
+
+    return NULL;
+}
+
+void myst_numa_apply_mempolicy(void* addr, size_t length)
+{
+    myst_thread_t* thread = myst_thread_self();
+
+    /* like the page allocator of Linux, the policy never fails a mapping */
+    if (thread->mempolicy.mode != MPOL_DEFAULT)
+    {
+        _host_mbind(
+            addr,
+            length,
+            thread->mempolicy.mode,
+            thread->mempolicy.nodemask,
+            MPOL_MF_MOVE);
+    }
+}
+
+int myst_numa_unmap(void* addr, size_t length)
+{
+    int ret = 0;
+    uint8_t* start = addr;
+
+    if (!__atomic_load_n(&_range_policies, __ATOMIC_ACQUIRE) || !length)
+        return 0;
+
+    if (myst_round_up(length, PAGE_SIZE, &length) < 0)
+        return -EINVAL;
+
+    myst_spin_lock(&_range_policies_lock);
+    ret = _remove_range_policies(myst_getpid(), start, start + length);
+    myst_spin_unlock(&_range_policies_lock);
+
+    return ret;
+}
+
+void myst_numa_release_process(pid_t pid)
+{
+    if (!__atomic_load_n(&_range_policies, __ATOMIC_ACQUIRE))
+        return;
+
+    myst_spin_lock(&_range_policies_lock);
+
+    for (range_policy_t** p = &_range_policies; *p;)
+    {
+        range_policy_t* rp = *p;
+
+        if (rp->pid == pid)
+        {
+            *p = rp->next;
+            free(rp);
+            continue;
+        }
+
+        p = &rp->next;
+    }
+
+    myst_spin_unlock(&_range_policies_lock);
+}
+
+long myst_syscall_set_mempolicy(
+    int mode,
+    const unsigned long* nodemask,
+    unsigned long maxnode)
+{
+    long ret = 0;
+    myst_thread_t* thread = myst_thread_self();
+    uint64_t mask;
+
+    ECHECK(_get_nodemask(nodemask, maxnode, &mask));
+    ECHECK(_check_policy(mode, mask));
+
+    thread->mempolicy.mode = mode;
+    thread->mempolicy.nodemask = mask;
+
+done:
+    return ret;
+}
+
+long myst_syscall_get_mempolicy(
+    int* mode,
+    unsigned long* nodemask,
+    unsigned long maxnode,
+    void* addr,
+    unsigned long flags)
+{
+    long ret = 0;
+    myst_thread_t* thread = myst_thread_self();
+    int policy = thread->mempolicy.mode;
+    uint64_t mask = thread->mempolicy.nodemask;
+
+    if (flags & ~(MPOL_F_NODE | MPOL_F_ADDR | MPOL_F_MEMS_ALLOWED))
+        ERAISE(-EINVAL);
+
+    if (flags & MPOL_F_MEMS_ALLOWED)
+    {
+        if (flags & (MPOL_F_NODE | MPOL_F_ADDR))
+            ERAISE(-EINVAL);
+
+        policy = MPOL_DEFAULT;
+        mask = _online_nodes;
+    }
+    else if (flags & MPOL_F_ADDR)
+    {
+        const pid_t pid = myst_getpid();
+        const range_policy_t* rp;
+        void* page = (void*)((uintptr_t)addr & ~(PAGE_SIZE - 1));
+
+        /* the address must be mapped by the calling process */
+        if (myst_mman_pids_test(page, PAGE_SIZE, pid) != (ssize_t)PAGE_SIZE)
+            ERAISE(-EFAULT);
+
+        /* the policy set with mbind() (the thread's policy does not apply) */
+        myst_spin_lock(&_range_policies_lock);
+        {
+            if ((rp = _find_range_policy(pid, addr)))
+            {
+                policy = rp->mode;
+                mask = rp->nodemask;
+            }
+            else
+            {
+                policy = MPOL_DEFAULT;
+                mask = 0;
+            }
+        }
+        myst_spin_unlock(&_range_policies_lock);
+
+        /* the node of the page at addr (approximated by the local node) */
+        if (flags & MPOL_F_NODE)
+        {
+            unsigned node;
+            ECHECK(myst_numa_getcpu(NULL, &node));
+            policy = (int)node;
+        }
+    }
+    else
+    {
+        if (addr)
+            ERAISE(-EINVAL);
+
+        /* the next node used for interleaving */
+        if (flags & MPOL_F_NODE)
+        {
+            if ((policy & ~MPOL_MODE_FLAGS) != MPOL_INTERLEAVE)
+                ERAISE(-EINVAL);
+
+            policy = __builtin_ctzll(mask);
+        }
+    }
+
+    if (nodemask)
+    {
+        const unsigned long nr_nodes = 64 - __builtin_clzll(_online_nodes);
+        size_t nwords;
+
+        if (maxnode < nr_nodes)
+            ERAISE(-EINVAL);
+
+        nwords = (maxnode - 1 + 63) / 64;
+
+        if (myst_is_bad_addr_write(nodemask, nwords * sizeof(unsigned long)))
+            ERAISE(-EFAULT);
+
+        memset(nodemask, 0, nwords * sizeof(unsigned long));
+
+        if (nwords)
+            nodemask[0] = mask;
+    }
+
+    if (mode)
+    {
+        if (myst_is_bad_addr_write(mode, sizeof(int)))
+            ERAISE(-EFAULT);
+
+        *mode = policy;
+    }
+
+done:
+    return ret;
+}
+
+long myst_syscall_mbind(
+    void* addr,
+    unsigned long len,
+    int mode,
+    const unsigned long* nodemask,
+    unsigned long maxnode,
+    unsigned flags)
+{
+    long ret = 0;
+    uint64_t mask;
+    size_t length;
+    const pid_t pid = myst_getpid();
+    range_policy_t* rp = NULL;
+    uint8_t* start = addr;
+
+    if ((uintptr_t)addr % PAGE_SIZE)
+        ERAISE(-EINVAL);
+
+    if (flags & ~(MPOL_MF_STRICT | MPOL_MF_MOVE | MPOL_MF_MOVE_ALL))
+        ERAISE(-EINVAL);
+
+    ECHECK(_get_nodemask(nodemask, maxnode, &mask));
+    ECHECK(_check_policy(mode, mask));
+
+    if (myst_round_up(len, PAGE_SIZE, &length) < 0)
+        ERAISE(-EINVAL);
+
+    if (length == 0)
+        goto done;
+
+    /* the range must be mapped by the calling process */
+    if (myst_mman_pids_test(addr, length, pid) != (ssize_t)length)
+        ERAISE(-EFAULT);
+
+    if (mode != MPOL_DEFAULT)
+    {
+        if (!(rp = calloc(1, sizeof(range_policy_t))))
+            ERAISE(-ENOMEM);
+
+        rp->pid = pid;
+        rp->addr = start;
+        rp->length = length;
+        rp->mode = mode;
+        rp->nodemask = mask;
+    }
+
+    /* All the pages that back the kernel's memory belong to one host process,
+     * so MPOL_MF_MOVE_ALL needs no more than MPOL_MF_MOVE. The host reports
+     * pages that it could not move (MPOL_MF_STRICT) with EIO. */
+    {
+        unsigned host_flags = flags & MPOL_MF_STRICT;
+
+        if (flags & (MPOL_MF_MOVE | MPOL_MF_MOVE_ALL))
+            host_flags |= MPOL_MF_MOVE;
+
+        ECHECK(_host_mbind(addr, length, mode, mask, host_flags));
+    }
+
+    myst_spin_lock(&_range_policies_lock);
+    {
+        if ((ret = _remove_range_policies(pid, start, start + length)) == 0 &&
+            rp)
+        {
+            rp->next = _range_policies;
+            _range_policies = rp;
+            rp = NULL;
+        }
+    }
+    myst_spin_unlock(&_range_policies_lock);
+
+    ECHECK(ret);
+
+done:
+
+    if (rp)
+        free(rp);
+
+    return ret;
+}
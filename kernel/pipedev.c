@@ -278,11 +278,12 @@ static ssize_t _write(int fd, const void* buf, size_t count, bool nonblock)
         return myst_tcall_write_block(fd, buf, count);
 }
 
-static ssize_t _pd_read(
+static ssize_t _read_pipe(
     myst_pipedev_t* pipedev,
     myst_pipe_t* pipe,
     void* buf,
-    size_t count)
+    size_t count,
+    bool nonblock)
 {
     ssize_t ret = 0;
     ssize_t nread = 0;
@@ -326,8 +327,6 @@ static ssize_t _pd_read(
 
             if (min) /* there is data in the buffer */
             {
-                const bool nonblock = (pipe->fl_flags & O_NONBLOCK);
-
                 memcpy(ptr, shared->buf.data, min);
                 ECHECK(myst_buf_remove(&shared->buf, 0, min));
                 rem -= min;
@@ -377,7 +376,7 @@ static ssize_t _pd_read(
                 if (shared->nwriters == 0)
                     break;
 
-                if ((pipe->fl_flags & O_NONBLOCK))
+                if (nonblock)
                 {
                     if (nread == 0)
                         ERAISE(-EAGAIN);
@@ -414,11 +413,34 @@ done:
     return ret;
 }
 
-static ssize_t _pd_write(
+static ssize_t _pd_read(
     myst_pipedev_t* pipedev,
     myst_pipe_t* pipe,
-    const void* buf,
+    void* buf,
     size_t count)
+{
+    if (!_valid_pipe(pipe))
+        return -EBADF;
+
+    return _read_pipe(
+        pipedev, pipe, buf, count, (pipe->fl_flags & O_NONBLOCK));
+}
+
+static ssize_t _pd_read_nonblock(
+    myst_pipedev_t* pipedev,
+    myst_pipe_t* pipe,
+    void* buf,
+    size_t count)
+{
+    return _read_pipe(pipedev, pipe, buf, count, true);
+}
+
+static ssize_t _write_pipe(
+    myst_pipedev_t* pipedev,
+    myst_pipe_t* pipe,
+    const void* buf,
+    size_t count,
+    bool nonblock)
 {
     ssize_t ret = 0;
     bool locked = false;
@@ -470,8 +492,6 @@ static ssize_t _pd_write(
 
             if (min) /* there is space in the buffer */
             {
-                const bool nonblock = (pipe->fl_flags & O_NONBLOCK);
-
                 ECHECK(myst_buf_append(&shared->buf, ptr, min));
                 rem -= min;
                 ptr += min;
@@ -519,7 +539,7 @@ static ssize_t _pd_write(
             }
             else /* the buffer is full */
             {
-                if ((pipe->fl_flags & O_NONBLOCK))
+                if (nonblock)
                 {
                     if (nwritten == 0)
                         ERAISE(-EAGAIN);
@@ -562,6 +582,28 @@ done:
     return ret;
 }
 
+static ssize_t _pd_write(
+    myst_pipedev_t* pipedev,
+    myst_pipe_t* pipe,
+    const void* buf,
+    size_t count)
+{
+    if (!_valid_pipe(pipe))
+        return -EBADF;
+
+    return _write_pipe(
+        pipedev, pipe, buf, count, (pipe->fl_flags & O_NONBLOCK));
+}
+
+static ssize_t _pd_write_nonblock(
+    myst_pipedev_t* pipedev,
+    myst_pipe_t* pipe,
+    const void* buf,
+    size_t count)
+{
+    return _write_pipe(pipedev, pipe, buf, count, true);
+}
+
 static ssize_t _pd_readv(
     myst_pipedev_t* pipedev,
     myst_pipe_t* pipe,
@@ -744,6 +786,19 @@ static int _pd_ioctl(
             ERAISE(-EINVAL);
             break;
         }
+        case FIONREAD:
+        {
+            int* val = (int*)arg;
+            bool locked = false;
+
+            if (!val)
+                ERAISE(-EINVAL);
+
+            _lock(&pipe->shared->lock, &locked);
+            *val = (int)_nbytes(pipe->shared);
+            _unlock(&pipe->shared->lock, &locked);
+            break;
+        }
         case FIONBIO:
         {
             int* val = (int*)arg;
@@ -952,6 +1007,8 @@ extern myst_pipedev_t* myst_pipedev_get(void)
         .pd_pipe2 = _pd_pipe2,
         .pd_read = _pd_read,
         .pd_write = _pd_write,
+        .pd_read_nonblock = _pd_read_nonblock,
+        .pd_write_nonblock = _pd_write_nonblock,
         .pd_readv = _pd_readv,
         .pd_writev = _pd_writev,
         .pd_fstat = _pd_fstat,
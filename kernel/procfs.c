@@ -181,6 +181,7 @@ static int _meminfo_vcallback(
     size_t totalram;
     size_t freeram;
     size_t cached = 0;
+    myst_mman_stats_t stats;
 
     (void)entrypath;
 
@@ -189,6 +190,7 @@ static int _meminfo_vcallback(
 
     ECHECK(myst_get_total_ram(&totalram));
     ECHECK(myst_get_free_ram(&freeram));
+    myst_mman_stats(&stats);
 
     myst_buf_clear(vbuf);
     char tmp[128];
@@ -200,6 +202,17 @@ static int _meminfo_vcallback(
     ECHECK(myst_snprintf(tmp, n, "Cached:         %lu\n", cached));
     ECHECK(myst_buf_append(vbuf, tmp, strlen(tmp)));
 
+    /* cumulative madvise() statistics (only MadvReleased counts memory that
+     * was actually given back; discarded SGX pages remain in use) */
+    ECHECK(myst_snprintf(
+        tmp, n, "MadvDontneed:   %lu\n", stats.dontneed_size));
+    ECHECK(myst_buf_append(vbuf, tmp, strlen(tmp)));
+    ECHECK(myst_snprintf(tmp, n, "MadvFree:       %lu\n", stats.lazyfree_size));
+    ECHECK(myst_buf_append(vbuf, tmp, strlen(tmp)));
+    ECHECK(myst_snprintf(
+        tmp, n, "MadvReleased:   %lu\n", stats.released_size));
+    ECHECK(myst_buf_append(vbuf, tmp, strlen(tmp)));
+
 done:
 
     if (ret != 0)
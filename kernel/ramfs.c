@@ -14,11 +14,14 @@
 #include <myst/buf.h>
 #include <myst/bufu64.h>
 #include <myst/clock.h>
+#include <myst/cpioindex.h>
 #include <myst/devfs.h>
 #include <myst/eraise.h>
 #include <myst/fs.h>
 #include <myst/id.h>
+#include <myst/iov.h>
 #include <myst/lockfs.h>
+#include <myst/mutex.h>
 #include <myst/panic.h>
 #include <myst/paths.h>
 #include <myst/printf.h>
@@ -59,6 +62,8 @@ typedef struct ramfs
     myst_mount_resolve_callback_t resolve;
     size_t ninodes;
     myst_fs_t* lockfs;
+    myst_cpio_index_t index; /* set by myst_ramfs_load_index() */
+    myst_mutex_t lazy_lock;  /* serializes the creation of lazy contents */
 } ramfs_t;
 
 static bool _ramfs_valid(const ramfs_t* ramfs)
@@ -76,6 +81,8 @@ static bool _ramfs_valid(const ramfs_t* ramfs)
 
 #define INODE_MAGIC 0xcdfbdd61258a4c9d
 
+typedef struct dirhash dirhash_t;
+
 struct inode
 {
     uint64_t magic;
@@ -85,11 +92,21 @@ struct inode
     struct timespec mtime; /* time of last modification */
     size_t nlink;          /* number of hard links to this inode */
     size_t nopens;         /* number of times file is currently opened */
-    myst_buf_t buf;        /* file or directory data */
+    myst_buf_t buf;        /* directory entries or symbolic link target */
+    size_t nvacant;        /* number of removed directory entries */
+    dirhash_t* dirhash;    /* name index (large directories only) */
+    size_t size;           /* size of the file data */
+    uint8_t** chunks;      /* file data chunks (null entries are holes) */
+    size_t nchunks;        /* number of elements in chunks[] */
+    size_t nallocated;     /* number of allocated chunks */
     const void* data;      /* set by myst_ramfs_set_buf() */
     uid_t uid;             /* user ID who created */
     gid_t gid;             /* group ID who created */
     myst_vcallback_t v_cb; /* callback(s) for virtual files */
+    myst_spinlock_t lock;  /* guards timestamps (updated by shared readers) */
+    const myst_cpio_index_inode_t* lazy; /* entries not created yet */
+    myst_ramfs_fill_callback_t fill;     /* produces the data on first use */
+    void* fill_arg;
 };
 
 #define ACCESS 1
@@ -101,6 +118,12 @@ static bool _inode_valid(const inode_t* inode)
     return inode && inode->magic == INODE_MAGIC;
 }
 
+/* the index entry of a lazy directory (see _inode_materialize()) */
+static const myst_cpio_index_inode_t* _inode_lazy(const inode_t* inode)
+{
+    return __atomic_load_n(&inode->lazy, __ATOMIC_ACQUIRE);
+}
+
 static bool _is_virtual_inode(const inode_t* inode)
 {
     return inode && (inode->v_cb.open_cb || inode->v_cb.close_cb ||
@@ -116,6 +139,8 @@ static void _update_timestamps(inode_t* inode, int flags)
     if (myst_syscall_clock_gettime(CLOCK_REALTIME, &ts) != 0)
         myst_panic("clock_gettime() failed");
 
+    myst_spin_lock(&inode->lock);
+
     if (flags & ACCESS)
         inode->atime = ts;
 
@@ -124,14 +149,495 @@ static void _update_timestamps(inode_t* inode, int flags)
 
     if (flags & MODIFY)
         inode->mtime = ts;
+
+    myst_spin_unlock(&inode->lock);
+}
+
+static bool _is_chunked(const inode_t* inode)
+{
+    /* directories and symbolic links keep their contents in inode->buf */
+    return !S_ISDIR(inode->mode) && !S_ISLNK(inode->mode);
+}
+
+/*
+**==============================================================================
+**
+** file data:
+**
+** The data of regular files is stored in CHUNK_SIZE chunks referenced from a
+** geometrically grown array of chunk pointers, so extending a file never
+** moves existing data. Null chunk pointers represent holes, which read back
+** as zeros. Bytes of a chunk beyond the end of file are always zero. Files
+** whose data was set with myst_ramfs_set_buf() refer to the caller's buffer
+** until they are first modified.
+**
+**==============================================================================
+*/
+
+#define CHUNK_SIZE PAGE_SIZE
+
+static void _data_release(inode_t* inode)
+{
+    for (size_t i = 0; i < inode->nchunks; i++)
+        free(inode->chunks[i]);
+
+    free(inode->chunks);
+    inode->chunks = NULL;
+    inode->nchunks = 0;
+    inode->nallocated = 0;
+}
+
+/* grow the chunks array to hold at least nchunks elements */
+static int _data_reserve(inode_t* inode, size_t nchunks)
+{
+    int ret = 0;
+    uint8_t** chunks;
+    size_t n;
+
+    if (nchunks <= inode->nchunks)
+        goto done;
+
+    n = inode->nchunks ? inode->nchunks * 2 : 1;
+
+    if (n < nchunks)
+        n = nchunks;
+
+    if (!(chunks = realloc(inode->chunks, n * sizeof(uint8_t*))))
+        ERAISE(-ENOMEM);
+
+    memset(chunks + inode->nchunks, 0, (n - inode->nchunks) * sizeof(uint8_t*));
+    inode->chunks = chunks;
+    inode->nchunks = n;
+
+done:
+    return ret;
+}
+
+static ssize_t _data_read(
+    const inode_t* inode,
+    size_t offset,
+    void* buf,
+    size_t count)
+{
+    uint8_t* p = buf;
+    size_t n;
+
+    if (offset >= inode->size)
+        return 0;
+
+    if (count > inode->size - offset)
+        count = inode->size - offset;
+
+    if (inode->data)
+    {
+        memcpy(buf, (const uint8_t*)inode->data + offset, count);
+        return (ssize_t)count;
+    }
+
+    for (size_t r = count; r > 0; r -= n, p += n, offset += n)
+    {
+        const size_t index = offset / CHUNK_SIZE;
+        const size_t off = offset % CHUNK_SIZE;
+
+        n = CHUNK_SIZE - off;
+
+        if (n > r)
+            n = r;
+
+        if (index < inode->nchunks && inode->chunks[index])
+            memcpy(p, inode->chunks[index] + off, n);
+        else
+            memset(p, 0, n);
+    }
+
+    return (ssize_t)count;
+}
+
+static int _data_unshare(inode_t* inode);
+
+static int _data_write(
+    inode_t* inode,
+    size_t offset,
+    const void* buf,
+    size_t count)
+{
+    int ret = 0;
+    const uint8_t* p = buf;
+    size_t end;
+    size_t n;
+
+    if (__builtin_add_overflow(offset, count, &end) || end > SSIZE_MAX)
+        ERAISE(-EFBIG);
+
+    ECHECK(_data_unshare(inode));
+    ECHECK(_data_reserve(inode, (end + CHUNK_SIZE - 1) / CHUNK_SIZE));
+
+    for (size_t r = count; r > 0; r -= n, p += n, offset += n)
+    {
+        const size_t index = offset / CHUNK_SIZE;
+        const size_t off = offset % CHUNK_SIZE;
+
+        n = CHUNK_SIZE - off;
+
+        if (n > r)
+            n = r;
+
+        if (!inode->chunks[index])
+        {
+            /* only partially written chunks need to be zero-filled */
+            if (n == CHUNK_SIZE)
+                inode->chunks[index] = malloc(CHUNK_SIZE);
+            else
+                inode->chunks[index] = calloc(1, CHUNK_SIZE);
+
+            if (!inode->chunks[index])
+                ERAISE(-ENOMEM);
+
+            inode->nallocated++;
+        }
+
+        memcpy(inode->chunks[index] + off, p, n);
+
+        if (offset + n > inode->size)
+            inode->size = offset + n;
+    }
+
+done:
+    return ret;
+}
+
+/* copy data set by myst_ramfs_set_buf() into chunks before modifying it */
+static int _data_unshare(inode_t* inode)
+{
+    int ret = 0;
+    const void* data = inode->data;
+    const size_t size = inode->size;
+
+    if (!data)
+        goto done;
+
+    inode->data = NULL;
+    inode->size = 0;
+
+    if ((ret = _data_write(inode, 0, data, size)) != 0)
+    {
+        _data_release(inode);
+        inode->data = data;
+        inode->size = size;
+        ERAISE(ret);
+    }
+
+done:
+    return ret;
+}
+
+static int _data_truncate(inode_t* inode, size_t length)
+{
+    int ret = 0;
+
+    if (length > SSIZE_MAX)
+        ERAISE(-EFBIG);
+
+    if (length == 0)
+    {
+        _data_release(inode);
+        inode->data = NULL;
+    }
+    else if (length < inode->size)
+    {
+        /* release the chunks past the new end of file */
+        for (size_t i = (length + CHUNK_SIZE - 1) / CHUNK_SIZE;
+             i < inode->nchunks;
+             i++)
+        {
+            if (inode->chunks[i])
+            {
+                free(inode->chunks[i]);
+                inode->chunks[i] = NULL;
+                inode->nallocated--;
+            }
+        }
+
+        /* zero the tail of the last chunk */
+        if (!inode->data && (length % CHUNK_SIZE))
+        {
+            const size_t index = length / CHUNK_SIZE;
+            const size_t off = length % CHUNK_SIZE;
+
+            if (index < inode->nchunks && inode->chunks[index])
+                memset(inode->chunks[index] + off, 0, CHUNK_SIZE - off);
+        }
+    }
+    else if (length > inode->size)
+    {
+        /* the caller's buffer cannot be extended */
+        ECHECK(_data_unshare(inode));
+    }
+
+    /* extending the file creates a hole */
+    inode->size = length;
+
+done:
+    return ret;
+}
+
+/*
+**==============================================================================
+**
+** directory entries:
+**
+** Directory entries are stored in inode->buf as an array of struct dirent.
+** Removing an entry clears its d_ino and leaves a vacant slot so that the
+** offsets of the remaining entries stay valid for open directory streams.
+** Vacant slots are compacted once they outnumber the live entries while the
+** directory is not open. Directories with at least DIRHASH_MIN_ENTRIES
+** entries also have a hash index from names to entry slots.
+**
+**==============================================================================
+*/
+
+#define DIRHASH_MIN_ENTRIES 32
+
+typedef struct dirhash_entry
+{
+    struct dirhash_entry* next;
+    uint64_t hash;
+    size_t index; /* index of the entry in the directory buffer */
+} dirhash_entry_t;
+
+struct dirhash
+{
+    dirhash_entry_t** buckets;
+    size_t nbuckets; /* a power of two */
+    size_t nentries;
+};
+
+static struct dirent* _dirents(const inode_t* dir)
+{
+    return (struct dirent*)dir->buf.data;
+}
+
+static size_t _num_slots(const inode_t* dir)
+{
+    return dir->buf.size / sizeof(struct dirent);
+}
+
+/* number of live entries (including "." and "..") */
+static size_t _num_dirents(const inode_t* dir)
+{
+    return _num_slots(dir) - dir->nvacant;
+}
+
+/* FNV-1a */
+static uint64_t _hash_name(const char* name)
+{
+    uint64_t hash = 0xcbf29ce484222325;
+
+    while (*name)
+    {
+        hash ^= (uint8_t)*name++;
+        hash *= 0x100000001b3;
+    }
+
+    return hash;
+}
+
+static void _dirhash_free(inode_t* dir)
+{
+    dirhash_t* dh = dir->dirhash;
+
+    if (!dh)
+        return;
+
+    for (size_t i = 0; i < dh->nbuckets; i++)
+    {
+        for (dirhash_entry_t* p = dh->buckets[i]; p;)
+        {
+            dirhash_entry_t* next = p->next;
+            free(p);
+            p = next;
+        }
+    }
+
+    free(dh->buckets);
+    free(dh);
+    dir->dirhash = NULL;
+}
+
+static int _dirhash_rehash(dirhash_t* dh, size_t nbuckets)
+{
+    int ret = 0;
+    dirhash_entry_t** buckets;
+
+    if (!(buckets = calloc(nbuckets, sizeof(dirhash_entry_t*))))
+        ERAISE(-ENOMEM);
+
+    for (size_t i = 0; i < dh->nbuckets; i++)
+    {
+        for (dirhash_entry_t* p = dh->buckets[i]; p;)
+        {
+            dirhash_entry_t* next = p->next;
+            const size_t slot = p->hash & (nbuckets - 1);
+
+            p->next = buckets[slot];
+            buckets[slot] = p;
+            p = next;
+        }
+    }
+
+    free(dh->buckets);
+    dh->buckets = buckets;
+    dh->nbuckets = nbuckets;
+
+done:
+    return ret;
+}
+
+static int _dirhash_insert(dirhash_t* dh, const char* name, size_t index)
+{
+    int ret = 0;
+    dirhash_entry_t* entry;
+    size_t slot;
+
+    /* keep the load factor at or below one */
+    if (dh->nentries >= dh->nbuckets)
+        ECHECK(_dirhash_rehash(dh, dh->nbuckets * 2));
+
+    if (!(entry = malloc(sizeof(dirhash_entry_t))))
+        ERAISE(-ENOMEM);
+
+    entry->hash = _hash_name(name);
+    entry->index = index;
+    slot = entry->hash & (dh->nbuckets - 1);
+    entry->next = dh->buckets[slot];
+    dh->buckets[slot] = entry;
+    dh->nentries++;
+
+done:
+    return ret;
+}
+
+static void _dirhash_remove(dirhash_t* dh, const char* name, size_t index)
+{
+    const uint64_t hash = _hash_name(name);
+    dirhash_entry_t** pp = &dh->buckets[hash & (dh->nbuckets - 1)];
+
+    for (; *pp; pp = &(*pp)->next)
+    {
+        if ((*pp)->index == index)
+        {
+            dirhash_entry_t* entry = *pp;
+            *pp = entry->next;
+            free(entry);
+            dh->nentries--;
+            return;
+        }
+    }
+}
+
+/* (re)build the index of a directory from its live entries */
+static int _dirhash_build(inode_t* dir)
+{
+    int ret = 0;
+    const struct dirent* ents = _dirents(dir);
+    const size_t nslots = _num_slots(dir);
+    dirhash_t* dh;
+    size_t nbuckets = 64;
+
+    _dirhash_free(dir);
+
+    while (nbuckets < nslots)
+        nbuckets *= 2;
+
+    if (!(dh = calloc(1, sizeof(dirhash_t))))
+        ERAISE(-ENOMEM);
+
+    dir->dirhash = dh;
+
+    if (!(dh->buckets = calloc(nbuckets, sizeof(dirhash_entry_t*))))
+    {
+        _dirhash_free(dir);
+        ERAISE(-ENOMEM);
+    }
+
+    dh->nbuckets = nbuckets;
+
+    for (size_t i = 0; i < nslots; i++)
+    {
+        if (ents[i].d_ino && _dirhash_insert(dh, ents[i].d_name, i) != 0)
+        {
+            _dirhash_free(dir);
+            ERAISE(-ENOMEM);
+        }
+    }
+
+done:
+    return ret;
+}
+
+/* return the slot index of the named entry or -1 if not found */
+static ssize_t _dirent_find(const inode_t* dir, const char* name)
+{
+    const struct dirent* ents = _dirents(dir);
+
+    if (dir->dirhash)
+    {
+        const dirhash_t* dh = dir->dirhash;
+        const uint64_t hash = _hash_name(name);
+        const dirhash_entry_t* p = dh->buckets[hash & (dh->nbuckets - 1)];
+
+        for (; p; p = p->next)
+        {
+            if (p->hash == hash && strcmp(ents[p->index].d_name, name) == 0)
+                return (ssize_t)p->index;
+        }
+
+        return -1;
+    }
+
+    for (size_t i = 0, n = _num_slots(dir); i < n; i++)
+    {
+        if (ents[i].d_ino && strcmp(ents[i].d_name, name) == 0)
+            return (ssize_t)i;
+    }
+
+    return -1;
+}
+
+/* squeeze out vacant slots (invalidates the offsets of open streams) */
+static void _dirents_compact(inode_t* dir)
+{
+    struct dirent* ents = _dirents(dir);
+    const size_t nslots = _num_slots(dir);
+    size_t n = 0;
+
+    for (size_t i = 0; i < nslots; i++)
+    {
+        if (ents[i].d_ino)
+        {
+            if (n != i)
+                ents[n] = ents[i];
+
+            ents[n].d_off = (off_t)(n * sizeof(struct dirent));
+            n++;
+        }
+    }
+
+    dir->buf.size = n * sizeof(struct dirent);
+    dir->nvacant = 0;
+
+    /* on failure the index is dropped and lookups fall back to scanning */
+    if (dir->dirhash)
+        _dirhash_build(dir);
 }
 
 static void _inode_free(ramfs_t* ramfs, inode_t* inode)
 {
     if (inode)
     {
-        if (inode->buf.data != inode->data)
-            myst_buf_release(&inode->buf);
+        myst_buf_release(&inode->buf);
+        _dirhash_free(inode);
+        _data_release(inode);
         memset(inode, 0xdd, sizeof(inode_t));
         free(inode);
 
@@ -186,6 +692,21 @@ static int _inode_add_dirent(
             ERAISE(-ENOMEM);
     }
 
+    /* Index the new entry */
+    if (dir->dirhash)
+    {
+        if (_dirhash_insert(dir->dirhash, name, _num_slots(dir) - 1) != 0)
+        {
+            dir->buf.size -= sizeof(struct dirent);
+            ERAISE(-ENOMEM);
+        }
+    }
+    else if (_num_dirents(dir) >= DIRHASH_MIN_ENTRIES)
+    {
+        /* lookups keep working (by scanning) if this fails */
+        _dirhash_build(dir);
+    }
+
     _update_timestamps(dir, CHANGE | MODIFY);
 
 done:
@@ -198,9 +719,16 @@ done:
 
 static bool _inode_is_empty_dir(const inode_t* inode)
 {
+    const myst_cpio_index_inode_t* lazy;
+
+    if (!inode || !S_ISDIR(inode->mode))
+        return false;
+
+    if ((lazy = _inode_lazy(inode)))
+        return lazy->num_children == 0;
+
     /* empty directories have two entries: "." and ".." */
-    const size_t empty_size = (2 * sizeof(struct dirent));
-    return inode && S_ISDIR(inode->mode) && inode->buf.size == empty_size;
+    return _num_dirents(inode) == 2;
 }
 
 #if 0
@@ -220,7 +748,8 @@ static void _dump_dirents(const inode_t* inode)
 
     while (p != end)
     {
-        printf("name{%s}\n", p->d_name);
+        if (p->d_ino)
+            printf("name{%s}\n", p->d_name);
         p++;
     }
 
@@ -265,64 +794,201 @@ static int _inode_new(
         ECHECK(_inode_add_dirent(inode, inode, DT_DIR, "."));
         inode->nlink++; /* self link */
 
-        /* Add the ".." entry */
-        ECHECK(_inode_add_dirent(inode, parent, DT_DIR, ".."));
+        /* Add the ".." entry */
+        ECHECK(_inode_add_dirent(inode, parent, DT_DIR, ".."));
+    }
+
+    /* Add this inode to the parent's directory table (if not root) */
+    if (parent != inode)
+    {
+        uint8_t type;
+
+        if (S_ISDIR(mode))
+            type = DT_DIR;
+        else if (S_ISREG(mode) || S_ISCHR(mode))
+            type = DT_REG;
+        else if (S_ISLNK(mode))
+            type = DT_LNK;
+        else
+        {
+            ERAISE(-EINVAL);
+        }
+
+        /* add new inode to parent directory */
+        {
+            ECHECK(_inode_add_dirent(parent, inode, type, name));
+
+            if (S_ISDIR(inode->mode))
+                parent->nlink++;
+        }
+    }
+
+    _update_timestamps(inode, ACCESS | CHANGE | MODIFY);
+
+    if (inode_out)
+        *inode_out = inode;
+
+    ramfs->ninodes++;
+    inode = NULL;
+
+done:
+
+    if (inode)
+        _inode_free(ramfs, inode);
+
+    return ret;
+}
+
+/*
+**==============================================================================
+**
+** lazy directories:
+**
+** Directories mounted from an indexed CPIO archive (see
+** myst_ramfs_load_index()) are created without their entries, which are
+** created from the index when the directory is first accessed. The link count
+** of a lazy directory already includes its child directories. Since lookups
+** may run under a shared lock, the entries are created under lazy_lock and
+** inode->lazy is cleared only after they all exist.
+**
+**==============================================================================
+*/
+
+static int _inode_new_from_index(
+    ramfs_t* ramfs,
+    inode_t* parent,
+    const myst_cpio_index_inode_t* entry)
+{
+    int ret = 0;
+    const myst_cpio_index_t* index = &ramfs->index;
+    const char* name = myst_cpio_index_name(index, entry);
+    inode_t* inode;
+
+    ECHECK(_inode_new(ramfs, parent, name, entry->mode, &inode));
+
+    if (S_ISDIR(entry->mode))
+    {
+        inode->lazy = entry;
+        inode->nlink += entry->num_subdirs;
+    }
+    else if (S_ISLNK(entry->mode))
+    {
+        const char* target = (const char*)index->archive + entry->offset;
+
+        if (myst_buf_append(&inode->buf, target, entry->size) != 0 ||
+            myst_buf_append(&inode->buf, "", 1) != 0)
+        {
+            ERAISE(-ENOMEM);
+        }
+    }
+    else
+    {
+        /* refer to the archive until the file is modified */
+        inode->data = index->archive + entry->offset;
+        inode->size = entry->size;
+    }
+
+done:
+    return ret;
+}
+
+/* create the entries of a lazy directory */
+static int _inode_materialize(ramfs_t* ramfs, inode_t* dir)
+{
+    int ret = 0;
+    const myst_cpio_index_inode_t* lazy;
+    bool locked = false;
+
+    if (!_inode_lazy(dir))
+        goto done;
+
+    myst_mutex_lock(&ramfs->lazy_lock);
+    locked = true;
+
+    /* another thread may have created the entries in the meantime */
+    if (!(lazy = dir->lazy))
+        goto done;
+
+    if (myst_buf_reserve(
+            &dir->buf, (2 + lazy->num_children) * sizeof(struct dirent)) != 0)
+    {
+        ERAISE(-ENOMEM);
     }
 
-    /* Add this inode to the parent's directory table (if not root) */
-    if (parent != inode)
+    for (size_t i = 0; i < lazy->num_children; i++)
     {
-        uint8_t type;
+        const myst_cpio_index_inode_t* entry =
+            &ramfs->index.inodes[lazy->first_child + i];
 
-        if (S_ISDIR(mode))
-            type = DT_DIR;
-        else if (S_ISREG(mode) || S_ISCHR(mode))
-            type = DT_REG;
-        else if (S_ISLNK(mode))
-            type = DT_LNK;
-        else
+        /* a partially populated directory is better than duplicate entries */
+        if ((ret = _inode_new_from_index(ramfs, dir, entry)) != 0)
         {
-            ERAISE(-EINVAL);
+            __atomic_store_n(&dir->lazy, NULL, __ATOMIC_RELEASE);
+            ERAISE(ret);
         }
 
-        /* add new inode to parent directory */
-        {
-            ECHECK(_inode_add_dirent(parent, inode, type, name));
-
-            if (S_ISDIR(inode->mode))
-                parent->nlink++;
-        }
+        /* (already counted) */
+        if (S_ISDIR(entry->mode))
+            dir->nlink--;
     }
 
-    _update_timestamps(inode, ACCESS | CHANGE | MODIFY);
+    __atomic_store_n(&dir->lazy, NULL, __ATOMIC_RELEASE);
 
-    if (inode_out)
-        *inode_out = inode;
+done:
 
-    ramfs->ninodes++;
-    inode = NULL;
+    if (locked)
+        myst_mutex_unlock(&ramfs->lazy_lock);
+
+    return ret;
+}
+
+/* produce the data of a file created by myst_ramfs_create_lazy_file() */
+static int _inode_fill(ramfs_t* ramfs, inode_t* inode)
+{
+    int ret = 0;
+    myst_buf_t buf = MYST_BUF_INITIALIZER;
+    bool locked = false;
+
+    if (!__atomic_load_n(&inode->fill, __ATOMIC_ACQUIRE))
+        goto done;
+
+    myst_mutex_lock(&ramfs->lazy_lock);
+    locked = true;
+
+    if (!inode->fill)
+        goto done;
+
+    /* on failure, the next access tries again */
+    ECHECK((*inode->fill)(inode->fill_arg, &buf));
+    ECHECK(_data_write(inode, 0, buf.data, buf.size));
+    _update_timestamps(inode, CHANGE | MODIFY);
+
+    __atomic_store_n(&inode->fill, NULL, __ATOMIC_RELEASE);
 
 done:
 
-    if (inode)
-        _inode_free(ramfs, inode);
+    if (locked)
+        myst_mutex_unlock(&ramfs->lazy_lock);
+
+    myst_buf_release(&buf);
 
     return ret;
 }
 
-static inode_t* _inode_find_child(const inode_t* inode, const char* name)
+static inode_t* _inode_find_child(
+    ramfs_t* ramfs,
+    inode_t* inode,
+    const char* name)
 {
-    struct dirent* ents = (struct dirent*)inode->buf.data;
-    size_t nents = inode->buf.size / sizeof(struct dirent);
+    ssize_t index;
 
-    for (size_t i = 0; i < nents; i++)
-    {
-        if (strcmp(ents[i].d_name, name) == 0)
-            return (inode_t*)ents[i].d_ino;
-    }
+    if (_inode_materialize(ramfs, inode) != 0)
+        return NULL;
+
+    if ((index = _dirent_find(inode, name)) < 0)
+        return NULL;
 
-    /* Not found */
-    return NULL;
+    return (inode_t*)_dirents(inode)[index].d_ino;
 }
 
 /* Perform a depth-first release of all inodes */
@@ -338,12 +1004,20 @@ static void _inode_release_all(
     /* Free the children first */
     if (d_type == DT_DIR)
     {
+        /* discount the child directories that were never created */
+        if (inode->lazy)
+        {
+            inode->nlink -= inode->lazy->num_subdirs;
+            inode->lazy = NULL;
+        }
+
         for (size_t i = 0; i < nents; i++)
         {
             const struct dirent* ent = &ents[i];
             inode_t* child;
 
-            if (strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0)
+            if (!ent->d_ino || strcmp(ent->d_name, ".") == 0 ||
+                strcmp(ent->d_name, "..") == 0)
             {
                 continue;
             }
@@ -378,40 +1052,33 @@ static void _inode_release_all(
 static int _inode_remove_dirent(inode_t* inode, const char* name)
 {
     int ret = 0;
-    struct dirent* ents = (struct dirent*)inode->buf.data;
-    size_t nents = inode->buf.size / sizeof(struct dirent);
-    size_t index = (size_t)-1;
+    struct dirent* ents = _dirents(inode);
+    ssize_t index;
 
     if (!S_ISDIR(inode->mode))
         ERAISE(-ENOTDIR);
 
-    for (size_t i = 0; i < nents; i++)
-    {
-        if (strcmp(ents[i].d_name, name) == 0)
-        {
-            const size_t pos = i * sizeof(struct dirent);
-            const size_t size = sizeof(struct dirent);
-
-            /* clear the entry */
-            memset(&ents[i], 0, sizeof(struct dirent));
+    if ((index = _dirent_find(inode, name)) < 0)
+        ERAISE(-ENOENT);
 
-            if (myst_buf_remove(&inode->buf, pos, size) != 0)
-                ERAISE(-ENOMEM);
+    if (inode->dirhash)
+        _dirhash_remove(inode->dirhash, name, (size_t)index);
 
-            index = i;
-            break;
-        }
+    /* Vacate the slot (or drop it if it is the last one) */
+    if ((size_t)index + 1 == _num_slots(inode))
+    {
+        inode->buf.size -= sizeof(struct dirent);
     }
-
-    if (index == (size_t)-1)
-        ERAISE(-ENOENT);
-
-    /* Adjust d_off for entries following the deleted entry */
-    for (size_t i = index + 1; i < nents - 1; i++)
+    else
     {
-        ents[i].d_off -= (off_t)sizeof(struct dirent);
+        ents[index].d_ino = 0;
+        memset(ents[index].d_name, 0, sizeof(ents[index].d_name));
+        inode->nvacant++;
     }
 
+    if (inode->nopens == 0 && inode->nvacant > _num_dirents(inode))
+        _dirents_compact(inode);
+
     /* update the time fields */
     _update_timestamps(inode, CHANGE | MODIFY);
 
@@ -460,26 +1127,61 @@ static bool _file_valid(const myst_file_t* file)
     return file && file->shared && file->shared->magic == FILE_MAGIC;
 }
 
-static void* _file_data(const myst_file_t* file)
+/* the buffer holding the file contents (null for chunked file data) */
+static myst_buf_t* _file_buf(myst_file_t* file)
 {
-    return (file->shared->inode->v_cb.open_cb) ? file->shared->vbuf.data
-                                               : file->shared->inode->buf.data;
+    inode_t* inode = file->shared->inode;
+
+    if (inode->v_cb.open_cb)
+        return &file->shared->vbuf;
+
+    return _is_chunked(inode) ? NULL : &inode->buf;
 }
 
-static size_t _file_size(const myst_file_t* file)
+static size_t _file_size(myst_file_t* file)
 {
-    return (file->shared->inode->v_cb.open_cb) ? file->shared->vbuf.size
-                                               : file->shared->inode->buf.size;
+    myst_buf_t* buf = _file_buf(file);
+    return buf ? buf->size : file->shared->inode->size;
 }
 
-static void* _file_current(myst_file_t* file)
+static ssize_t _file_read_at(
+    myst_file_t* file,
+    size_t offset,
+    void* data,
+    size_t count)
 {
-    return (uint8_t*)_file_data(file) + file->shared->offset;
+    myst_buf_t* buf = _file_buf(file);
+
+    if (!buf)
+        return _data_read(file->shared->inode, offset, data, count);
+
+    if (offset >= buf->size)
+        return 0;
+
+    if (count > buf->size - offset)
+        count = buf->size - offset;
+
+    memcpy(data, buf->data + offset, count);
+    return (ssize_t)count;
 }
 
-static void* _file_at(myst_file_t* file, size_t offset)
+static int _file_write_at(
+    myst_file_t* file,
+    size_t offset,
+    const void* data,
+    size_t count)
 {
-    return (uint8_t*)_file_data(file) + offset;
+    myst_buf_t* buf = _file_buf(file);
+    const size_t end = offset + count;
+
+    if (!buf)
+        return _data_write(file->shared->inode, offset, data, count);
+
+    if (end > buf->size && myst_buf_resize(buf, end) != 0)
+        return -ENOMEM;
+
+    memcpy(buf->data + offset, data, count);
+    return 0;
 }
 
 /*
@@ -553,7 +1255,7 @@ static int _path_to_inode_recursive(
                 ERAISE_QUIET(-ENOTDIR);
 
             inode_t* p;
-            if (!(p = _inode_find_child(parent, toks[i])))
+            if (!(p = _inode_find_child(ramfs, parent, toks[i])))
                 ERAISE_QUIET(-ENOENT);
 
             if (!S_ISLNK(p->mode))
@@ -910,8 +1612,15 @@ static int _fs_open(
         if ((flags & O_DIRECTORY) && !S_ISDIR(inode->mode))
             ERAISE(-ENOTDIR);
 
+        ECHECK(_inode_fill(ramfs, inode));
+
         if ((flags & O_TRUNC))
-            myst_buf_clear(&inode->buf);
+        {
+            if (_is_chunked(inode))
+                ECHECK(_data_truncate(inode, 0));
+            else
+                myst_buf_clear(&inode->buf);
+        }
 
         /* Get the realpath of this file */
         ECHECK(_path_to_inode_realpath(
@@ -1038,11 +1747,12 @@ static off_t _fs_lseek(
         }
     }
 
-    /* ATTN: support seeking beyond the end of file, deficiency compared with
-     * EXT2FS support */
+    if (new_offset < 0)
+        ERAISE(-EINVAL);
 
-    /* Check whether new offset if out of range */
-    if (new_offset < 0 || new_offset > (off_t)_file_size(file))
+    /* Seeking beyond the end is only supported for file data (a later write
+     * leaves a hole) */
+    if (_file_buf(file) && new_offset > (off_t)_file_size(file))
         ERAISE(-EINVAL);
 
     file->shared->offset = (size_t)new_offset;
@@ -1063,7 +1773,7 @@ static ssize_t _fs_read(
 {
     ramfs_t* ramfs = (ramfs_t*)fs;
     ssize_t ret = 0;
-    size_t n;
+    ssize_t n;
 
     if (!_ramfs_valid(ramfs))
         ERAISE(-EINVAL);
@@ -1089,28 +1799,18 @@ static ssize_t _fs_read(
         goto done;
     }
 
-    /* If offset is beyond end of file, return 0 */
-    if (file->shared->offset >= _file_size(file))
-        goto done;
-
-    /* Read count bytes from the file or directory */
+    /* Read up to count bytes from the file or directory */
+    if ((n = _file_read_at(file, file->shared->offset, buf, count)) == 0)
     {
-        size_t remaining = _file_size(file) - file->shared->offset;
-
-        if (remaining == 0)
-        {
-            /* end of file */
-            goto done;
-        }
-
-        n = (count < remaining) ? count : remaining;
-        memcpy(buf, _file_current(file), n);
-        file->shared->offset += n;
+        /* end of file */
+        goto done;
     }
 
+    file->shared->offset += (size_t)n;
+
     _update_timestamps(file->shared->inode, ACCESS);
 
-    ret = (ssize_t)n;
+    ret = n;
 
 done:
     return ret;
@@ -1153,23 +1853,13 @@ static ssize_t _fs_write(
     if ((file->shared->operating & O_APPEND))
         file->shared->offset = _file_size(file);
 
-    /* Verify that the offset is in bounds */
-    if (file->shared->offset > _file_size(file))
+    /* Verify that the offset is in bounds (file data may have holes) */
+    if (_file_buf(file) && file->shared->offset > _file_size(file))
         ERAISE(-EINVAL);
 
     /* Write count bytes to the file or directory */
-    {
-        size_t new_offset = file->shared->offset + count;
-
-        if (new_offset > _file_size(file))
-        {
-            if (myst_buf_resize(&file->shared->inode->buf, new_offset) != 0)
-                ERAISE(-ENOMEM);
-        }
-
-        memcpy(_file_current(file), buf, count);
-        file->shared->offset = new_offset;
-    }
+    ECHECK(_file_write_at(file, file->shared->offset, buf, count));
+    file->shared->offset += count;
 
     _update_timestamps(file->shared->inode, MODIFY | CHANGE);
 
@@ -1188,7 +1878,7 @@ static ssize_t _fs_pread(
 {
     ramfs_t* ramfs = (ramfs_t*)fs;
     ssize_t ret = 0;
-    size_t n;
+    ssize_t n;
 
     if (!_ramfs_valid(ramfs))
         ERAISE(-EINVAL);
@@ -1214,26 +1904,19 @@ static ssize_t _fs_pread(
     }
 
     /* Verify that the offset is in bounds */
-    if ((size_t)offset > _file_size(file))
+    if (_file_buf(file) && (size_t)offset > _file_size(file))
         ERAISE(-EINVAL);
 
-    /* Read count bytes from the file or directory */
+    /* Read up to count bytes from the file or directory */
+    if ((n = _file_read_at(file, (size_t)offset, buf, count)) == 0)
     {
-        size_t remaining = _file_size(file) - (size_t)offset;
-
-        if (remaining == 0)
-        {
-            /* end of file */
-            goto done;
-        }
-
-        n = (count < remaining) ? count : remaining;
-        memcpy(buf, _file_at(file, (size_t)offset), n);
+        /* end of file */
+        goto done;
     }
 
     _update_timestamps(file->shared->inode, ACCESS);
 
-    ret = (ssize_t)n;
+    ret = n;
 
 done:
     return ret;
@@ -1279,15 +1962,7 @@ static ssize_t _fs_pwrite(
         if ((file->shared->operating & O_APPEND))
             offset = _file_size(file);
 
-        size_t new_offset = (size_t)offset + count;
-
-        if (new_offset > _file_size(file))
-        {
-            if (myst_buf_resize(&file->shared->inode->buf, new_offset) != 0)
-                ERAISE(-ENOMEM);
-        }
-
-        memcpy(_file_at(file, (size_t)offset), buf, count);
+        ECHECK(_file_write_at(file, (size_t)offset, buf, count));
     }
 
     _update_timestamps(file->shared->inode, CHANGE | MODIFY);
@@ -1306,26 +1981,53 @@ static ssize_t _fs_readv(
 {
     ssize_t ret = 0;
     ramfs_t* ramfs = (ramfs_t*)fs;
-    ssize_t total = 0;
+    size_t total = 0;
 
     if (!_ramfs_valid(ramfs) || !_file_valid(file))
         ERAISE(-EINVAL);
 
+    ECHECK(myst_iov_len(iov, iovcnt));
+
+    if (file->shared->access == O_WRONLY || file->shared->access == O_PATH)
+        ERAISE(-EBADF);
+
+    /* read straight into each element, updating the file once */
     for (int i = 0; i < iovcnt; i++)
     {
         ssize_t n;
         void* buf = iov[i].iov_base;
         size_t count = iov[i].iov_len;
+        size_t offset = file->shared->offset + total;
+
+        if (count == 0)
+            continue;
+
+        /* virtual files produce their contents per call */
+        if (file->shared->inode->v_cb.read_cb)
+            n = (*fs->fs_read)(fs, file, buf, count);
+        else
+            n = _file_read_at(file, offset, buf, count);
 
-        ECHECK((n = (*fs->fs_read)(fs, file, buf, count)));
+        if (n < 0)
+        {
+            if (total == 0)
+                ERAISE(n);
+            break;
+        }
 
-        total += n;
+        total += (size_t)n;
 
         if ((size_t)n < count)
             break;
     }
 
-    ret = total;
+    if (total && !file->shared->inode->v_cb.read_cb)
+    {
+        file->shared->offset += total;
+        _update_timestamps(file->shared->inode, ACCESS);
+    }
+
+    ret = (ssize_t)total;
 
 done:
     return ret;
@@ -1339,26 +2041,87 @@ static ssize_t _fs_writev(
 {
     ssize_t ret = 0;
     ramfs_t* ramfs = (ramfs_t*)fs;
-    ssize_t total = 0;
+    ssize_t len;
+    size_t offset;
+    size_t total = 0;
+    myst_buf_t* buf;
 
     if (!_ramfs_valid(ramfs) || !_file_valid(file))
         ERAISE(-EINVAL);
 
+    ECHECK(len = myst_iov_len(iov, iovcnt));
+
+    /* virtual files consume their contents per call */
+    if (file->shared->inode->v_cb.write_cb)
+    {
+        for (int i = 0; i < iovcnt; i++)
+        {
+            ssize_t n;
+            const void* p = iov[i].iov_base;
+            const size_t count = iov[i].iov_len;
+
+            ECHECK((n = (*fs->fs_write)(fs, file, p, count)));
+            total += (size_t)n;
+
+            if ((size_t)n < count)
+                break;
+        }
+
+        ret = (ssize_t)total;
+        goto done;
+    }
+
+    if (len == 0)
+        goto done;
+
+    if (file->shared->access == O_RDONLY || file->shared->access == O_PATH)
+        ERAISE(-EBADF);
+
+    /* append always writes to the end of the file */
+    if ((file->shared->operating & O_APPEND))
+        file->shared->offset = _file_size(file);
+
+    offset = file->shared->offset;
+
+    /* Verify that the offset is in bounds (file data may have holes) */
+    if ((buf = _file_buf(file)))
+    {
+        if (offset > buf->size)
+            ERAISE(-EINVAL);
+
+        /* grow the file once for the whole vector */
+        if (offset + (size_t)len > buf->size)
+        {
+            if (myst_buf_resize(buf, offset + (size_t)len) != 0)
+                ERAISE(-ENOMEM);
+        }
+    }
+
+    /* write straight from each element, updating the file once */
     for (int i = 0; i < iovcnt; i++)
     {
-        ssize_t n;
-        const void* buf = iov[i].iov_base;
-        size_t count = iov[i].iov_len;
+        const size_t count = iov[i].iov_len;
+        int r;
 
-        ECHECK((n = (*fs->fs_write)(fs, file, buf, count)));
+        if (count == 0)
+            continue;
 
-        total += n;
+        r = _file_write_at(file, offset + total, iov[i].iov_base, count);
 
-        if ((size_t)n < count)
+        if (r != 0)
+        {
+            if (total == 0)
+                ERAISE(r);
             break;
+        }
+
+        total += count;
     }
 
-    ret = total;
+    file->shared->offset += total;
+    _update_timestamps(file->shared->inode, MODIFY | CHANGE);
+
+    ret = (ssize_t)total;
 
 done:
     return ret;
@@ -1387,16 +2150,22 @@ static int _fs_close(myst_fs_t* fs, myst_file_t* file)
         if (file->shared->inode->v_cb.open_cb)
             myst_buf_release(&file->shared->vbuf);
 
-        file->shared->inode->nopens--;
+        inode_t* inode = file->shared->inode;
+
+        inode->nopens--;
 
         /* handle case where file was deleted while open */
-        if (file->shared->inode->nopens == 0 && file->shared->inode->nlink == 0)
+        if (inode->nopens == 0 && inode->nlink == 0)
         {
-            _inode_free(ramfs, file->shared->inode);
+            _inode_free(ramfs, inode);
         }
         else
         {
-            _update_timestamps(file->shared->inode, ACCESS);
+            /* entries removed while the directory was being read */
+            if (inode->nopens == 0 && inode->nvacant > _num_dirents(inode))
+                _dirents_compact(inode);
+
+            _update_timestamps(inode, ACCESS);
         }
 
         memset(file->shared, 0xdd, sizeof(myst_file_t));
@@ -1468,8 +2237,9 @@ static int _stat(inode_t* inode, struct stat* statbuf)
 {
     int ret = 0;
     struct stat buf;
-    off_t rounded;
+    off_t rounded = 0;
     size_t size;
+    const myst_cpio_index_inode_t* lazy;
 
     if (!_inode_valid(inode) || !statbuf)
         ERAISE(-EINVAL);
@@ -1479,9 +2249,21 @@ static int _stat(inode_t* inode, struct stat* statbuf)
     {
         size = 0;
     }
+    else if (_is_chunked(inode) && !inode->data)
+    {
+        /* holes do not occupy blocks */
+        size = inode->size;
+        rounded = (off_t)(inode->nallocated * CHUNK_SIZE);
+    }
+    else if ((lazy = _inode_lazy(inode)))
+    {
+        /* the size the directory will have once its entries exist */
+        size = (2 + lazy->num_children) * sizeof(struct dirent);
+        ECHECK(myst_round_up_signed(size, BLKSIZE, &rounded));
+    }
     else
     {
-        size = inode->buf.size;
+        size = _is_chunked(inode) ? inode->size : inode->buf.size;
         ECHECK(myst_round_up_signed(size, BLKSIZE, &rounded));
     }
 
@@ -1496,9 +2278,11 @@ static int _stat(inode_t* inode, struct stat* statbuf)
     buf.st_size = (off_t)size;
     buf.st_blksize = BLKSIZE;
     buf.st_blocks = rounded / BLKSIZE;
+    myst_spin_lock(&inode->lock);
     buf.st_ctim = inode->ctime;
     buf.st_mtim = inode->mtime;
     buf.st_atim = inode->atime;
+    myst_spin_unlock(&inode->lock);
 
     *statbuf = buf;
 
@@ -1532,6 +2316,7 @@ static int _fs_stat(myst_fs_t* fs, const char* pathname, struct stat* statbuf)
         ECHECK((ret = tfs->fs_stat(tfs, locals->suffix, statbuf)));
         goto done;
     }
+    ECHECK(_inode_fill(ramfs, inode));
     ERAISE(_stat(inode, statbuf));
 
 done:
@@ -1568,6 +2353,7 @@ static int _fs_lstat(myst_fs_t* fs, const char* pathname, struct stat* statbuf)
         ECHECK(tfs->fs_lstat(tfs, locals->suffix, statbuf));
         goto done;
     }
+    ECHECK(_inode_fill(ramfs, inode));
     ERAISE(_stat(inode, statbuf));
 
 done:
@@ -1634,7 +2420,7 @@ static int _fs_link(myst_fs_t* fs, const char* oldpath, const char* newpath)
         ramfs, locals->new_dirname, true, NULL, &new_parent, NULL, NULL));
 
     /* Fail if newpath already exists */
-    if (_inode_find_child(new_parent, locals->new_basename) != NULL)
+    if (_inode_find_child(ramfs, new_parent, locals->new_basename) != NULL)
         ERAISE(-EEXIST);
 
     /* Add the directory entry for the newpath */
@@ -1782,7 +2568,7 @@ static int _fs_rename(myst_fs_t* fs, const char* oldpath, const char* newpath)
         ramfs, locals->new_dirname, true, NULL, &new_parent, NULL, NULL));
 
     /* Get the newpath inode (if any) */
-    new_inode = _inode_find_child(new_parent, locals->new_basename);
+    new_inode = _inode_find_child(ramfs, new_parent, locals->new_basename);
 
     /* Succeed if oldpath and newpath refer to the same inode */
     if (new_inode == old_inode)
@@ -1874,8 +2660,8 @@ static int _fs_truncate(myst_fs_t* fs, const char* pathname, off_t length)
     if (_is_virtual_inode(inode))
         ERAISE(-EINVAL);
 
-    if (myst_buf_resize(&inode->buf, (size_t)length) != 0)
-        ERAISE(-ENOMEM);
+    ECHECK(_inode_fill(ramfs, inode));
+    ECHECK(_data_truncate(inode, (size_t)length));
 
     _update_timestamps(inode, CHANGE | MODIFY);
 
@@ -1905,8 +2691,7 @@ static int _fs_ftruncate(myst_fs_t* fs, myst_file_t* file, off_t length)
     if (_is_virtual_inode(file->shared->inode))
         ERAISE(-EINVAL);
 
-    if (myst_buf_resize(&file->shared->inode->buf, (size_t)length) != 0)
-        ERAISE(-ENOMEM);
+    ECHECK(_data_truncate(file->shared->inode, (size_t)length));
 
     _update_timestamps(file->shared->inode, CHANGE | MODIFY);
 
@@ -1956,7 +2741,7 @@ static int _fs_mkdir(myst_fs_t* fs, const char* pathname, mode_t mode)
         ERAISE(-ENOTDIR);
 
     /* Check whether the pathname already exists */
-    if (_inode_find_child(parent, locals->basename) != NULL)
+    if (_inode_find_child(ramfs, parent, locals->basename) != NULL)
         ERAISE(-EEXIST);
 
     /* create the directory */
@@ -2006,7 +2791,7 @@ static int _fs_rmdir(myst_fs_t* fs, const char* pathname)
         ERAISE(-ENOTDIR);
 
     /* Make sure the directory has no children */
-    if (child->buf.size > (2 * sizeof(struct dirent)))
+    if (!_inode_is_empty_dir(child))
         ERAISE(-ENOTEMPTY);
 
     /* Get the parent inode */
@@ -2066,11 +2851,13 @@ static int _fs_getdents64(
     if (count == 0)
         goto done;
 
+    ECHECK(_inode_materialize(ramfs, file->shared->inode));
+
     /* in case an entry was deleted (by unlink) during this iteration */
     if (file->shared->offset >= file->shared->inode->buf.size)
         file->shared->offset = file->shared->inode->buf.size;
 
-    for (size_t i = 0; i < n; i++)
+    for (size_t i = 0; i < n;)
     {
         ssize_t r;
 
@@ -2082,6 +2869,12 @@ static int _fs_getdents64(
         if (r != sizeof(locals->ent))
             myst_panic("unexpected");
 
+        /* Skip the slots of removed entries */
+        if (locals->ent.d_ino == 0)
+            continue;
+
+        i++;
+
         *dirp = locals->ent;
         bytes += sizeof(struct dirent);
         dirp++;
@@ -2200,7 +2993,8 @@ static int _fs_symlink(myst_fs_t* fs, const char* target, const char* linkpath)
         goto done;
     }
 
-    /* Create the new link inode */
+    /* Create the new link inode (after the existing entries) */
+    ECHECK(_inode_materialize(ramfs, parent));
     ECHECK(
         _inode_new(ramfs, parent, locals->basename, (S_IFLNK | 0777), &inode));
 
@@ -2970,6 +3764,9 @@ int myst_init_ramfs(
     ECHECK(_init_ramfs(resolve_cb, &ramfs));
     ECHECK(myst_lockfs_init(ramfs, &lockfs));
     ((ramfs_t*)ramfs)->lockfs = lockfs;
+
+    /* inspecting operations do not modify the tree (see _update_timestamps) */
+    ECHECK(myst_lockfs_set_shared_reads(lockfs, true));
     ramfs = NULL;
     *fs_out = lockfs;
 
@@ -3008,15 +3805,104 @@ int myst_ramfs_set_buf(
 
     ECHECK(_path_to_inode(ramfs, pathname, true, NULL, &inode, NULL, NULL));
 
-    if (inode->buf.data != inode->data)
-        myst_buf_clear(&inode->buf);
+    if (!_is_chunked(inode))
+        ERAISE(-EINVAL);
 
+    /* refer to the caller's buffer until the file is modified */
+    _data_release(inode);
     inode->data = buf;
-    inode->buf.data = (void*)buf;
-    inode->buf.size = buf_size;
+    inode->size = buf_size;
+
+done:
+
+    return ret;
+}
+
+int myst_ramfs_load_index(myst_fs_t* fs, const void* image, size_t image_size)
+{
+    int ret = 0;
+    ramfs_t* ramfs = _ramfs(fs);
+    inode_t* root;
+    myst_cpio_index_t index;
+
+    if (!_ramfs_valid(ramfs))
+        ERAISE(-EINVAL);
+
+    if (!image)
+        ERAISE(-EINVAL);
+
+    if ((ret = myst_cpio_index_find(image, image_size, &index)) != 0)
+        goto done;
+
+    root = ramfs->root;
+
+    /* the index can only be loaded into an empty file system */
+    if (ramfs->index.inodes || !_inode_is_empty_dir(root))
+        ERAISE(-EBUSY);
+
+    ramfs->index = index;
+    root->nlink += index.inodes[0].num_subdirs;
+    __atomic_store_n(&root->lazy, &index.inodes[0], __ATOMIC_RELEASE);
+
+done:
+    return ret;
+}
+
+int myst_ramfs_create_lazy_file(
+    myst_fs_t* fs,
+    const char* pathname,
+    mode_t mode,
+    myst_ramfs_fill_callback_t fill,
+    void* arg)
+{
+    int ret = 0;
+    ramfs_t* ramfs = _ramfs(fs);
+    inode_t* parent;
+    inode_t* inode;
+    struct locals
+    {
+        char dirname[PATH_MAX];
+        char basename[PATH_MAX];
+        char suffix[PATH_MAX];
+    };
+    struct locals* locals = NULL;
+    myst_fs_t* tfs = NULL;
+
+    if (!_ramfs_valid(ramfs))
+        ERAISE_QUIET(-ENOTSUP);
+
+    if (!pathname || !fill)
+        ERAISE(-EINVAL);
+
+    if (!(locals = malloc(sizeof(struct locals))))
+        ERAISE(-ENOMEM);
+
+    ECHECK(_split_path(pathname, locals->dirname, locals->basename));
+
+    /* the parent directory must belong to this file system */
+    ECHECK(_path_to_inode(
+        ramfs, locals->dirname, true, NULL, &parent, locals->suffix, &tfs));
+
+    if (tfs)
+        ERAISE_QUIET(-ENOTSUP);
+
+    if (!S_ISDIR(parent->mode))
+        ERAISE(-ENOTDIR);
+
+    if (_inode_find_child(ramfs, parent, locals->basename))
+        ERAISE(-EEXIST);
+
+    ECHECK(_inode_new(
+        ramfs, parent, locals->basename, S_IFREG | (mode & 07777), &inode));
+
+    inode->fill_arg = arg;
+    __atomic_store_n(&inode->fill, fill, __ATOMIC_RELEASE);
 
 done:
 
+    if (locals)
+        free(locals);
+
     return ret;
 }
 
@@ -3131,6 +4017,10 @@ int set_overrides_for_special_fs(myst_fs_t* fs)
 
     ramfs->base.fs_fdatasync = ramfs->base.fs_fsync = _einval_override;
 
+    /* virtual files rebuild their contents while paths are resolved */
+    if (ramfs->lockfs)
+        ECHECK(myst_lockfs_set_shared_reads(ramfs->lockfs, false));
+
 done:
     return ret;
 }
@@ -0,0 +1,267 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <signal.h>
+#include <sys/mman.h>
+
+#include <myst/eraise.h>
+#include <myst/mmanutils.h>
+#include <myst/numa.h>
+#include <myst/rseq.h>
+#include <myst/signal.h>
+#include <myst/thread.h>
+
+/*
+**==============================================================================
+**
+** Restartable sequences (rseq)
+**
+** A restartable sequence relies on the OS to abort it whenever another
+** thread may have run on the same CPU, or when a signal handler interrupts
+** it. The kernel cannot see the host preempting or migrating a thread that
+** runs enclave (or application) code, so the cpu_id that it reports is not
+** simply the host CPU. Instead, each registered thread owns a CPU id that no
+** other thread of its process holds at the same time:
+**
+**     - the id is claimed at registration, preferring the current host CPU
+**     - on the way back to user space, the thread moves to the id of the
+**       host CPU it now runs on if that id is free (this keeps the per-CPU
+**       data close to the CPU in the common case)
+**     - the id is released when the thread unregisters, exits or execs
+**     - a child process created by fork() keeps the id of the forking thread
+**
+** No two threads can then be inside critical sections for the same cpu_id,
+** and the only remaining way to interrupt a critical section is a signal
+** handler on the same thread, which aborts it (see myst_rseq_abort()). Ids
+** stay below the number of CPUs that the process can run on; registration
+** fails with ENOMEM when all of them are taken, and the C runtime then falls
+** back to its non-rseq paths for that thread.
+**
+**==============================================================================
+*/
+
+#define RSEQ_FLAG_UNREGISTER (1 << 0)
+
+#define RSEQ_CPU_ID_UNINITIALIZED ((uint32_t)-1)
+
+/* the size of the original struct rseq (later fields are optional) */
+#define RSEQ_ORIG_SIZE 32
+
+MYST_STATIC_ASSERT(sizeof(myst_rseq_t) == RSEQ_ORIG_SIZE);
+
+static unsigned _ncpus(void)
+{
+    const unsigned ncpus = myst_numa_ncpus();
+    return ncpus < MYST_RSEQ_MAX_CPUS ? ncpus : MYST_RSEQ_MAX_CPUS;
+}
+
+static bool _claim(myst_process_t* process, uint32_t cpu)
+{
+    uint64_t* word = &process->rseq_cpus[cpu / 64];
+    const uint64_t bit = (uint64_t)1 << (cpu % 64);
+
+    return !(__atomic_fetch_or(word, bit, __ATOMIC_ACQ_REL) & bit);
+}
+
+static void _unclaim(myst_process_t* process, uint32_t cpu)
+{
+    uint64_t* word = &process->rseq_cpus[cpu / 64];
+    const uint64_t bit = (uint64_t)1 << (cpu % 64);
+
+    __atomic_fetch_and(word, ~bit, __ATOMIC_RELEASE);
+}
+
+static int _claim_any(
+    myst_process_t* process,
+    uint32_t preferred,
+    uint32_t* cpu)
+{
+    const unsigned ncpus = _ncpus();
+
+    if (preferred < ncpus && _claim(process, preferred))
+    {
+        *cpu = preferred;
+        return 0;
+    }
+
+    for (uint32_t i = 0; i < ncpus; i++)
+    {
+        if (_claim(process, i))
+        {
+            *cpu = i;
+            return 0;
+        }
+    }
+
+    return -ENOMEM;
+}
+
+static void _set_cpu(myst_rseq_t* area, uint32_t cpu, uint32_t node)
+{
+    area->cpu_id_start = cpu;
+    __atomic_store_n(&area->cpu_id, cpu, __ATOMIC_RELAXED);
+    area->node_id = node;
+    area->mm_cid = cpu;
+}
+
+long myst_syscall_rseq(
+    myst_rseq_t* rseq,
+    uint32_t rseq_len,
+    int flags,
+    uint32_t sig)
+{
+    long ret = 0;
+    myst_thread_t* thread = myst_thread_self();
+    unsigned cpu = 0;
+    unsigned node = 0;
+
+    if (flags & RSEQ_FLAG_UNREGISTER)
+    {
+        if (flags & ~RSEQ_FLAG_UNREGISTER)
+            ERAISE(-EINVAL);
+
+        if (!thread->rseq.area || thread->rseq.area != rseq)
+            ERAISE(-EINVAL);
+
+        if (thread->rseq.len != rseq_len)
+            ERAISE(-EINVAL);
+
+        if (thread->rseq.sig != sig)
+            ERAISE(-EPERM);
+
+        _set_cpu(rseq, 0, 0);
+        rseq->cpu_id = RSEQ_CPU_ID_UNINITIALIZED;
+        myst_rseq_release(thread);
+        goto done;
+    }
+
+    if (flags)
+        ERAISE(-EINVAL);
+
+    if (thread->rseq.area)
+    {
+        if (thread->rseq.area != rseq || thread->rseq.len != rseq_len)
+            ERAISE(-EINVAL);
+
+        if (thread->rseq.sig != sig)
+            ERAISE(-EPERM);
+
+        ERAISE(-EBUSY);
+    }
+
+    if ((uintptr_t)rseq % RSEQ_ORIG_SIZE || rseq_len < RSEQ_ORIG_SIZE)
+        ERAISE(-EINVAL);
+
+    if (myst_is_bad_addr_read_write(rseq, rseq_len))
+        ERAISE(-EFAULT);
+
+    /* a failure only loses the preference for the current CPU */
+    myst_numa_getcpu(&cpu, &node);
+
+    ECHECK(_claim_any(thread->process, cpu, &thread->rseq.cpu));
+
+    thread->rseq.area = rseq;
+    thread->rseq.len = rseq_len;
+    thread->rseq.sig = sig;
+
+    _set_cpu(rseq, thread->rseq.cpu, node);
+
+done:
+    return ret;
+}
+
+void myst_rseq_update(myst_thread_t* thread)
+{
+    unsigned cpu;
+    unsigned node;
+
+    if (!myst_numa_getcpu_fast(&cpu, &node))
+        return;
+
+    if (cpu == thread->rseq.cpu || cpu >= _ncpus())
+        return;
+
+    /* stay on the old id if another thread owns the id of this CPU */
+    if (!_claim(thread->process, cpu))
+        return;
+
+    _unclaim(thread->process, thread->rseq.cpu);
+    thread->rseq.cpu = cpu;
+
+    _set_cpu(thread->rseq.area, cpu, node);
+}
+
+int myst_rseq_abort(myst_thread_t* thread, mcontext_t* mcontext)
+{
+    int ret = 0;
+    myst_rseq_t* area = thread->rseq.area;
+    const myst_rseq_cs_t* cs;
+    uint64_t ip;
+    uint64_t end;
+
+    if (!area || !(cs = (const myst_rseq_cs_t*)area->rseq_cs))
+        goto done;
+
+    if (myst_is_bad_addr_read(cs, sizeof(myst_rseq_cs_t)))
+        ERAISE(-EFAULT);
+
+    ip = (uint64_t)mcontext->gregs[REG_RIP];
+
+    /* the descriptor is left behind when the critical section completes */
+    if (ip - cs->start_ip >= cs->post_commit_offset)
+    {
+        area->rseq_cs = 0;
+        goto done;
+    }
+
+    if (cs->version != 0)
+        ERAISE(-EINVAL);
+
+    if (__builtin_add_overflow(cs->start_ip, cs->post_commit_offset, &end))
+        ERAISE(-EINVAL);
+
+    if (cs->abort_ip - cs->start_ip < cs->post_commit_offset)
+        ERAISE(-EINVAL);
+
+    /* the abort handler is preceded by the signature */
+    {
+        const uint32_t* sig = (const uint32_t*)cs->abort_ip - 1;
+
+        if (myst_is_bad_addr_read(sig, sizeof(uint32_t)))
+            ERAISE(-EFAULT);
+
+        if (*sig != thread->rseq.sig)
+            ERAISE(-EPERM);
+    }
+
+    area->rseq_cs = 0;
+    mcontext->gregs[REG_RIP] = (greg_t)cs->abort_ip;
+
+done:
+    return ret;
+}
+
+void myst_rseq_fork(myst_thread_t* parent, myst_thread_t* child)
+{
+    if (!parent->rseq.area)
+        return;
+
+    /* the child process starts with only this thread, so the id is free */
+    child->rseq = parent->rseq;
+    _claim(child->process, child->rseq.cpu);
+}
+
+void myst_rseq_release(myst_thread_t* thread)
+{
+    if (!thread->rseq.area)
+        return;
+
+    _unclaim(thread->process, thread->rseq.cpu);
+
+    thread->rseq.area = NULL;
+    thread->rseq.len = 0;
+    thread->rseq.sig = 0;
+    thread->rseq.cpu = 0;
+}
@@ -0,0 +1,289 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <errno.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include <myst/defs.h>
+#include <myst/panic.h>
+#include <myst/rwlock.h>
+#include <myst/signal.h>
+#include <myst/tcall.h>
+#include <myst/thread.h>
+
+/* queue bitsets that tell waiting readers and writers apart */
+#define WAIT_READ 1
+#define WAIT_WRITE 2
+
+int myst_rwlock_init(myst_rwlock_t* rw)
+{
+    if (!rw)
+        return -EINVAL;
+
+    memset(rw, 0, sizeof(myst_rwlock_t));
+
+    return 0;
+}
+
+/* threads to wake once the spinlock is released */
+typedef struct wakers
+{
+    myst_thread_t* threads[16];
+    size_t count;
+} wakers_t;
+
+/* Caller manages the spinlock. Hands the lock to the waiters at the front of
+ * the queue (if they can have it) and removes them from the queue.
+ */
+static void _grant(myst_rwlock_t* rw, wakers_t* wakers)
+{
+    for (;;)
+    {
+        myst_thread_t* thread = rw->queue.front;
+
+        if (rw->writer || !thread)
+            return;
+
+        if (thread->qbitset == WAIT_WRITE)
+        {
+            if (rw->readers > 0)
+                return;
+
+            rw->writer = thread;
+            rw->writer_refs = 1;
+        }
+        else
+        {
+            rw->readers++;
+        }
+
+        myst_thread_queue_pop_front(&rw->queue);
+
+        /* rare: more granted readers than slots */
+        if (wakers->count == MYST_COUNTOF(wakers->threads))
+            myst_tcall_wake(thread->event);
+        else
+            wakers->threads[wakers->count++] = thread;
+    }
+}
+
+static void _wake(wakers_t* wakers)
+{
+    for (size_t i = 0; i < wakers->count; i++)
+        myst_tcall_wake(wakers->threads[i]->event);
+}
+
+/* the index of the slot that records the read lock of THREAD on RW */
+static int _find_rdlock(myst_thread_t* thread, myst_rwlock_t* rw)
+{
+    for (int i = 0; i < MYST_THREAD_MAX_RDLOCKS; i++)
+    {
+        if (thread->rdlocks[i].rwlock == rw)
+            return i;
+    }
+
+    return -1;
+}
+
+/* record a new read lock of THREAD on RW */
+static void _add_rdlock(myst_thread_t* thread, myst_rwlock_t* rw)
+{
+    int i;
+
+    if ((i = _find_rdlock(thread, NULL)) < 0)
+        myst_panic("thread %d holds too many read locks", thread->tid);
+
+    thread->rdlocks[i].rwlock = rw;
+    thread->rdlocks[i].refs = 1;
+}
+
+static int _lock(myst_rwlock_t* rw, bool write)
+{
+    myst_thread_t* self = myst_thread_self();
+    wakers_t wakers = {.count = 0};
+    int i;
+
+    if (!rw)
+        return -EINVAL;
+
+    myst_spin_lock(&rw->lock);
+    {
+        /* the writer may take either lock again */
+        if (rw->writer == self)
+        {
+            rw->writer_refs++;
+            myst_spin_unlock(&rw->lock);
+            return 0;
+        }
+
+        /* a reader may take the read lock again, even ahead of waiting
+         * writers (which wait for this reader) */
+        if ((i = _find_rdlock(self, rw)) >= 0)
+        {
+            if (write)
+                myst_panic("read lock upgraded to a write lock");
+
+            self->rdlocks[i].refs++;
+            myst_spin_unlock(&rw->lock);
+            return 0;
+        }
+
+        /* take the lock if nobody holds or is waiting for it */
+        if (!rw->writer && !rw->queue.front && (!write || rw->readers == 0))
+        {
+            if (write)
+            {
+                rw->writer = self;
+                rw->writer_refs = 1;
+            }
+            else
+            {
+                rw->readers++;
+                _add_rdlock(self, rw);
+            }
+
+            myst_spin_unlock(&rw->lock);
+            return 0;
+        }
+
+        myst_thread_queue_push_back_bitset(
+            &rw->queue, self, write ? WAIT_WRITE : WAIT_READ);
+    }
+    myst_spin_unlock(&rw->lock);
+
+    /* Loop until the lock is handed to SELF */
+    for (;;)
+    {
+        long r;
+
+        myst_spin_lock(&rw->lock);
+        {
+            /* waiters are removed from the queue when granted the lock */
+            if (self->queue != &rw->queue)
+            {
+                if (!write)
+                    _add_rdlock(self, rw);
+
+                myst_spin_unlock(&rw->lock);
+                return 0;
+            }
+
+            /* check whether any signals were raised on this thread */
+            if (myst_signal_has_active_signals(self))
+            {
+                myst_thread_queue_remove_thread(&rw->queue, self);
+                _grant(rw, &wakers);
+                myst_spin_unlock(&rw->lock);
+                _wake(&wakers);
+                return -EINTR;
+            }
+        }
+        myst_spin_unlock(&rw->lock);
+
+        /* Ask host to wait for an event on this thread */
+        self->signal.waiting_on_event = true;
+        if ((r = myst_tcall_wait(self->event, NULL)) != 0)
+            myst_panic("myst_tcall_wait(): %ld: %d", r, *(int*)self->event);
+        self->signal.waiting_on_event = false;
+    }
+
+    /* Unreachable! */
+}
+
+int myst_rwlock_rdlock(myst_rwlock_t* rw)
+{
+    int ret;
+    myst_thread_t* self = myst_thread_self();
+
+    /* repeat as long as there is an -EINTR error */
+    while ((ret = _lock(rw, false)) == -EINTR)
+    {
+        /* check for signals */
+        myst_signal_process(self);
+    }
+
+    return ret;
+}
+
+int myst_rwlock_wrlock(myst_rwlock_t* rw)
+{
+    int ret;
+    myst_thread_t* self = myst_thread_self();
+
+    /* repeat as long as there is an -EINTR error */
+    while ((ret = _lock(rw, true)) == -EINTR)
+    {
+        /* check for signals */
+        myst_signal_process(self);
+    }
+
+    return ret;
+}
+
+int myst_rwlock_unlock(myst_rwlock_t* rw)
+{
+    int ret = 0;
+    myst_thread_t* self = myst_thread_self();
+    wakers_t wakers = {.count = 0};
+    int i;
+
+    if (!rw)
+        return -EINVAL;
+
+    myst_spin_lock(&rw->lock);
+    {
+        if (rw->writer == self)
+        {
+            if (--rw->writer_refs == 0)
+            {
+                rw->writer = NULL;
+                _grant(rw, &wakers);
+            }
+        }
+        else if ((i = _find_rdlock(self, rw)) >= 0)
+        {
+            if (--self->rdlocks[i].refs == 0)
+            {
+                self->rdlocks[i].rwlock = NULL;
+
+                if (--rw->readers == 0)
+                    _grant(rw, &wakers);
+            }
+        }
+        else
+        {
+            /* the caller does not hold the lock */
+            ret = -EPERM;
+        }
+    }
+    myst_spin_unlock(&rw->lock);
+
+    _wake(&wakers);
+
+    return ret;
+}
+
+int myst_rwlock_destroy(myst_rwlock_t* rw)
+{
+    int ret = 0;
+
+    if (!rw)
+        return -EINVAL;
+
+    myst_spin_lock(&rw->lock);
+    {
+        if (myst_thread_queue_empty(&rw->queue) && !rw->writer &&
+            rw->readers == 0)
+        {
+            memset(rw, 0, sizeof(myst_rwlock_t));
+        }
+        else
+        {
+            ret = -EBUSY;
+        }
+    }
+    myst_spin_unlock(&rw->lock);
+
+    return ret;
+}
@@ -3,23 +3,84 @@
 #include <sys/sendfile.h>
 
 #include <myst/eraise.h>
+#include <myst/fdtable.h>
+#include <myst/hostfs.h>
 #include <myst/syscall.h>
+#include <myst/tcall.h>
+
+/* size of the bounce buffer used when the host cannot do the copy */
+#define CHUNK_SIZE (64 * 1024)
 
 MYST_INLINE size_t _min(size_t x, size_t y)
 {
     return (x < y) ? x : y;
 }
 
+/* Let the host copy the data when in_fd is a hostfs file and out_fd is a
+ * hostfs file or a host socket, so that the data never enters the kernel.
+ * Returns -ENOTSUP if the caller must copy the data itself.
+ */
+static long _host_sendfile(int out_fd, int in_fd, off_t* offset, size_t count)
+{
+    long ret = 0;
+    myst_fdtable_t* fdtable = myst_fdtable_current();
+    const uint32_t in_types = MYST_FDTABLE_MASK(MYST_FDTABLE_TYPE_FILE);
+    const uint32_t out_types = in_types |
+                               MYST_FDTABLE_MASK(MYST_FDTABLE_TYPE_SOCK);
+    myst_fdtable_type_t out_type;
+    void* out_device;
+    int host_in_fd;
+    int host_out_fd;
+    off_t off = offset ? *offset : 0;
+    long n;
+
+    host_in_fd =
+        myst_fdtable_get_host_fd(fdtable, in_fd, in_types, NULL, NULL);
+
+    if (host_in_fd < 0)
+        ERAISE_QUIET(host_in_fd);
+
+    host_out_fd = myst_fdtable_get_host_fd(
+        fdtable, out_fd, out_types, &out_type, &out_device);
+
+    if (host_out_fd < 0)
+        ERAISE_QUIET(host_out_fd);
+
+    {
+        long params[6] = {
+            host_out_fd, host_in_fd, offset ? (long)&off : 0, (long)count};
+
+        /* host sockets are non-blocking on the host, so fall back to the
+         * kernel path (which blocks as required) if the socket is not ready */
+        if ((n = myst_tcall(SYS_sendfile, params)) == -EAGAIN)
+            ERAISE_QUIET(-ENOTSUP);
+
+        ECHECK(n);
+    }
+
+    if ((size_t)n > count || (offset && off != *offset + n))
+        ERAISE(-EIO);
+
+#ifdef MYST_ENABLE_HOSTFS
+    if (n > 0 && out_type == MYST_FDTABLE_TYPE_FILE)
+        myst_hostfs_invalidate(out_device);
+#endif
+
+    if (offset)
+        *offset = off;
+
+    ret = n;
+
+done:
+    return ret;
+}
+
 long myst_syscall_sendfile(int out_fd, int in_fd, off_t* offset, size_t count)
 {
     long ret = 0;
     ssize_t nwritten = 0;
     off_t original_offset = 0;
-    struct locals
-    {
-        char buf[BUFSIZ];
-    };
-    struct locals* locals = NULL;
+    char* buf = NULL;
 
     // Note: according to the Linux documentation, in_fd must be a file that
     // can be passed as the fd argument to mmap(). It cannot be a socket.
@@ -30,7 +91,12 @@ long myst_syscall_sendfile(int out_fd, int in_fd, off_t* offset, size_t count)
     if (out_fd < 0 || in_fd < 0)
         ERAISE(-EINVAL);
 
-    if (!(locals = malloc(sizeof(struct locals))))
+    if ((ret = _host_sendfile(out_fd, in_fd, offset, count)) != -ENOTSUP)
+        goto done;
+
+    ret = 0;
+
+    if (!(buf = malloc(CHUNK_SIZE)))
         ERAISE(-ENOMEM);
 
     /* if offset is not null, set file offset to this value */
@@ -48,9 +114,9 @@ long myst_syscall_sendfile(int out_fd, int in_fd, off_t* offset, size_t count)
         ssize_t n;
         size_t r = count;
 
-        while (r > 0 && (n = read(in_fd, locals->buf, _min(r, BUFSIZ))) > 0)
+        while (r > 0 && (n = read(in_fd, buf, _min(r, CHUNK_SIZE))) > 0)
         {
-            ssize_t m = write(out_fd, locals->buf, n);
+            ssize_t m = write(out_fd, buf, n);
 
             if (m == -1 && errno == EAGAIN)
             {
@@ -101,8 +167,8 @@ long myst_syscall_sendfile(int out_fd, int in_fd, off_t* offset, size_t count)
 
 done:
 
-    if (locals)
-        free(locals);
+    if (buf)
+        free(buf);
 
     return ret;
 }
@@ -222,6 +222,15 @@ static void _mem_command(int argc, char** argv)
     n = locals->buf.brk_size;
     printf("brk used     =%11zu (%zumb)\n", n, n / mb);
 
+    n = locals->buf.dontneed_size;
+    printf("dontneed     =%11zu (%zumb)\n", n, n / mb);
+
+    n = locals->buf.lazyfree_size;
+    printf("lazyfree     =%11zu (%zumb)\n", n, n / mb);
+
+    n = locals->buf.released_size;
+    printf("released     =%11zu (%zumb)\n", n, n / mb);
+
     n = __myst_kernel_args.rootfs_size;
     printf("cpio size    =%11zu (%zumb)\n", n, n / mb);
 
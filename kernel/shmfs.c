@@ -0,0 +1,2564 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/shm.h>
+#include <sys/stat.h>
+
+#include <myst/eraise.h>
+#include <myst/fdtable.h>
+#include <myst/file.h>
+#include <myst/iov.h>
+#include <myst/lockfs.h>
+#include <myst/mmanutils.h>
+#include <myst/mount.h>
+#include <myst/mutex.h>
+#include <myst/panic.h>
+#include <myst/printf.h>
+#include <myst/process.h>
+#include <myst/round.h>
+#include <myst/shmfs.h>
+#include <myst/strings.h>
+#include <myst/syscall.h>
+
+/*
+**==============================================================================
+**
+** shmfs: in-kernel shared memory objects
+**
+** A shared memory object is a run of mman pages that every process sees at
+** the same address (all processes share one address space). Mapping an object
+** with MAP_SHARED, or attaching a System V segment with shmat(), returns the
+** object's own pages, so all mappers observe each other's stores without any
+** copying and without involving the host.
+**
+** Objects are reached in one of three ways:
+**
+**     - by name: the file system is mounted on /dev/shm (shm_open())
+**     - by file descriptor only: memfd_create()
+**     - by System V identifier: shmget()
+**
+** An object lives until no name, open file, segment or mapping refers to it.
+** The pages of a mapped object cannot move, so the object only grows while
+** mapped if the mman can extend its pages in place.
+**
+**==============================================================================
+*/
+
+#ifndef F_SEAL_FUTURE_WRITE
+#define F_SEAL_FUTURE_WRITE 0x0010
+#endif
+
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
+
+#ifndef MFD_ALLOW_SEALING
+#define MFD_ALLOW_SEALING 0x0002U
+#endif
+
+#ifndef SHM_DEST
+#define SHM_DEST 01000
+#endif
+
+/* NAME_MAX less the "memfd:" prefix */
+#define MFD_NAME_MAX 249
+
+#define TMPFS_MAGIC 0x01021994
+
+#define IPC_64 0x0100
+
+#define ALL_SEALS                                              \
+    (F_SEAL_SEAL | F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | \
+     F_SEAL_FUTURE_WRITE)
+
+#define SHMFS_MAGIC 0x5a0c2f6b91d34e07
+#define OBJECT_MAGIC 0x93b5e1f07c2d4a68
+#define FILE_MAGIC 0x2d7f4a90c61e8b35
+
+typedef struct object object_t;
+
+struct object
+{
+    uint64_t magic;
+    object_t* next;
+    char* name;         /* the name (or the memfd_create() name) */
+    bool linked;        /* whether the name appears under /dev/shm */
+    bool memfd;         /* whether created by memfd_create() */
+    int shmid;          /* the System V identifier (or -1) */
+    key_t key;          /* the System V key */
+    bool removed;       /* whether IPC_RMID removed the System V segment */
+    size_t nrefs;       /* name, segment, open files and mappings */
+    size_t nmaps;       /* number of mappings (and attachments) */
+    size_t nwritable;   /* number of writable mappings */
+    uint8_t* addr;      /* the pages (or null) */
+    size_t capacity;    /* size of the pages in bytes */
+    size_t size;        /* size of the object in bytes */
+    unsigned int seals; /* F_SEAL_* flags */
+    mode_t mode;
+    uid_t uid;
+    gid_t gid;
+    uid_t cuid;
+    gid_t cgid;
+    pid_t cpid; /* the creator of the System V segment */
+    pid_t lpid; /* the last process to call shmat() or shmdt() */
+    time_t attach_time;
+    time_t detach_time;
+    struct timespec atime;
+    struct timespec mtime;
+    struct timespec ctime;
+};
+
+typedef struct mapping mapping_t;
+
+struct mapping
+{
+    mapping_t* next;
+    object_t* object;
+    pid_t pid;
+    uint8_t* addr;
+    size_t length;
+    bool writable;
+    bool attached; /* whether created by shmat() */
+};
+
+typedef struct shmfs
+{
+    myst_fs_t base;
+    uint64_t magic;
+    char target[PATH_MAX];
+} shmfs_t;
+
+struct myst_file_shared
+{
+    uint64_t magic;
+    object_t* object; /* null for the /dev/shm directory */
+    size_t offset;
+    int access;    /* (O_RDONLY | O_RDWR | O_WRONLY | O_PATH) */
+    int operating; /* (O_APPEND | O_NONBLOCK) */
+    size_t use_count;
+};
+
+struct myst_file
+{
+    myst_file_shared_t* shared;
+    int fdflags; /* file descriptor flags: FD_CLOEXEC */
+};
+
+/* the mounted (lockfs) file system */
+static myst_fs_t* _fs;
+
+/* the mutex guards the objects and the mappings */
+static myst_mutex_t _mutex;
+static object_t* _objects;
+static mapping_t* _mappings;
+static int _next_shmid;
+
+MYST_INLINE void _lock(bool* locked)
+{
+    myst_mutex_lock(&_mutex);
+    *locked = true;
+}
+
+MYST_INLINE void _unlock(bool* locked)
+{
+    if (*locked)
+    {
+        myst_mutex_unlock(&_mutex);
+        *locked = false;
+    }
+}
+
+MYST_INLINE bool _shmfs_valid(const shmfs_t* shmfs)
+{
+    return shmfs && shmfs->magic == SHMFS_MAGIC;
+}
+
+MYST_INLINE bool _file_valid(const myst_file_t* file)
+{
+    return file && file->shared && file->shared->magic == FILE_MAGIC;
+}
+
+MYST_INLINE bool _readable(int access)
+{
+    return access == O_RDONLY || access == O_RDWR;
+}
+
+MYST_INLINE bool _writable(int access)
+{
+    return access == O_WRONLY || access == O_RDWR;
+}
+
+static void _now(struct timespec* ts)
+{
+    if (myst_syscall_clock_gettime(CLOCK_REALTIME, ts) != 0)
+        memset(ts, 0, sizeof(struct timespec));
+}
+
+static time_t _seconds(void)
+{
+    struct timespec ts;
+    _now(&ts);
+    return ts.tv_sec;
+}
+
+/*
+**==============================================================================
+**
+** objects
+**
+**==============================================================================
+*/
+
+static int _object_new(const char* name, mode_t mode, object_t** object_out)
+{
+    int ret = 0;
+    object_t* object = NULL;
+
+    if (!(object = calloc(1, sizeof(object_t))))
+        ERAISE(-ENOMEM);
+
+    if (!(object->name = strdup(name)))
+        ERAISE(-ENOMEM);
+
+    object->magic = OBJECT_MAGIC;
+    object->shmid = -1;
+    object->seals = F_SEAL_SEAL;
+    object->mode = S_IFREG | (mode & 07777);
+    object->uid = object->cuid = myst_syscall_geteuid();
+    object->gid = object->cgid = myst_syscall_getegid();
+    _now(&object->ctime);
+    object->atime = object->ctime;
+    object->mtime = object->ctime;
+
+    object->next = _objects;
+    _objects = object;
+
+    *object_out = object;
+    object = NULL;
+
+done:
+
+    if (object)
+    {
+        free(object->name);
+        free(object);
+    }
+
+    return ret;
+}
+
+/* drop a reference and free the object if that was the last one */
+static void _object_release(object_t* object)
+{
+    if (--object->nrefs > 0)
+        return;
+
+    for (object_t** p = &_objects; *p; p = &(*p)->next)
+    {
+        if (*p == object)
+        {
+            *p = object->next;
+            break;
+        }
+    }
+
+    if (object->addr)
+        myst_munmap(object->addr, object->capacity);
+
+    free(object->name);
+    memset(object, 0xdd, sizeof(object_t));
+    free(object);
+}
+
+/* make sure the pages hold at least length bytes */
+static int _object_reserve(object_t* object, size_t length)
+{
+    int ret = 0;
+    size_t capacity;
+    void* addr;
+
+    if (length <= object->capacity)
+        goto done;
+
+    if (myst_round_up(length, PAGE_SIZE, &capacity) != 0)
+        ERAISE(-EFBIG);
+
+    if (!object->addr)
+    {
+        const int prot = PROT_READ | PROT_WRITE;
+        const int flags = MAP_ANONYMOUS | MAP_PRIVATE;
+
+        addr = (void*)myst_mmap(NULL, capacity, prot, flags, -1, 0);
+    }
+    else
+    {
+        /* mapped pages cannot move, so only grow them in place */
+        const int flags = object->nmaps ? 0 : MREMAP_MAYMOVE;
+
+        addr = myst_mremap(object->addr, object->capacity, capacity, flags, 0);
+    }
+
+    if ((long)addr < 0)
+        ERAISE(-ENOMEM);
+
+    object->addr = addr;
+    object->capacity = capacity;
+
+done:
+    return ret;
+}
+
+static int _object_truncate(object_t* object, size_t size)
+{
+    int ret = 0;
+
+    if (size < object->size && (object->seals & F_SEAL_SHRINK))
+        ERAISE(-EPERM);
+
+    if (size > object->size && (object->seals & F_SEAL_GROW))
+        ERAISE(-EPERM);
+
+    if (size > object->size)
+    {
+        ECHECK(_object_reserve(object, size));
+    }
+    else if (size < object->size)
+    {
+        size_t capacity;
+
+        /* growing the object again must read back zeros */
+        memset(object->addr + size, 0, object->size - size);
+
+        /* give unneeded pages back to the mman unless they are mapped */
+        if (object->nmaps == 0 &&
+            myst_round_up(size, PAGE_SIZE, &capacity) == 0 &&
+            capacity < object->capacity)
+        {
+            if (capacity == 0)
+            {
+                myst_munmap(object->addr, object->capacity);
+                object->addr = NULL;
+                object->capacity = 0;
+            }
+            else if (
+                (long)myst_mremap(
+                    object->addr, object->capacity, capacity, 0, 0) >= 0)
+            {
+                object->capacity = capacity;
+            }
+        }
+    }
+
+    object->size = size;
+    _now(&object->mtime);
+    object->ctime = object->mtime;
+
+done:
+    return ret;
+}
+
+static ssize_t _object_read(
+    object_t* object,
+    size_t offset,
+    void* buf,
+    size_t count)
+{
+    if (offset >= object->size)
+        return 0;
+
+    if (count > object->size - offset)
+        count = object->size - offset;
+
+    memcpy(buf, object->addr + offset, count);
+    _now(&object->atime);
+
+    return (ssize_t)count;
+}
+
+static ssize_t _object_write(
+    object_t* object,
+    size_t offset,
+    const void* buf,
+    size_t count)
+{
+    ssize_t ret = 0;
+    size_t end;
+
+    if (object->seals & (F_SEAL_WRITE | F_SEAL_FUTURE_WRITE))
+        ERAISE(-EPERM);
+
+    if (__builtin_add_overflow(offset, count, &end) || end > SSIZE_MAX)
+        ERAISE(-EFBIG);
+
+    if (end > object->size)
+    {
+        if (object->seals & F_SEAL_GROW)
+            ERAISE(-EPERM);
+
+        ECHECK(_object_reserve(object, end));
+    }
+
+    memcpy(object->addr + offset, buf, count);
+
+    if (end > object->size)
+        object->size = end;
+
+    _now(&object->mtime);
+    object->ctime = object->mtime;
+    ret = (ssize_t)count;
+
+done:
+    return ret;
+}
+
+static object_t* _find_name(const char* name)
+{
+    for (object_t* p = _objects; p; p = p->next)
+    {
+        if (p->linked && strcmp(p->name, name) == 0)
+            return p;
+    }
+
+    return NULL;
+}
+
+static object_t* _find_shmid(int shmid)
+{
+    for (object_t* p = _objects; p; p = p->next)
+    {
+        if (p->shmid >= 0 && p->shmid == shmid)
+            return p;
+    }
+
+    return NULL;
+}
+
+static int _check_access(const object_t* object, int access)
+{
+    int ret = 0;
+
+    if (_readable(access) && !(object->mode & S_IRUSR))
+        ERAISE(-EACCES);
+
+    if (_writable(access) && !(object->mode & S_IWUSR))
+        ERAISE(-EACCES);
+
+done:
+    return ret;
+}
+
+static void _stat(const object_t* object, struct stat* buf)
+{
+    memset(buf, 0, sizeof(struct stat));
+    buf->st_blksize = PAGE_SIZE;
+
+    if (!object)
+    {
+        /* the /dev/shm directory */
+        buf->st_ino = 1;
+        buf->st_mode = S_IFDIR | S_ISVTX | 0777;
+        buf->st_nlink = 2;
+        return;
+    }
+
+    buf->st_ino = (ino_t)object;
+    buf->st_mode = object->mode;
+    buf->st_nlink = object->linked ? 1 : 0;
+    buf->st_uid = object->uid;
+    buf->st_gid = object->gid;
+    buf->st_size = (off_t)object->size;
+    buf->st_blocks = (blkcnt_t)(object->capacity / 512);
+    buf->st_atim = object->atime;
+    buf->st_mtim = object->mtime;
+    buf->st_ctim = object->ctime;
+}
+
+/*
+**==============================================================================
+**
+** mappings
+**
+**==============================================================================
+*/
+
+static void _mapping_release(mapping_t* mapping)
+{
+    object_t* object = mapping->object;
+
+    object->nmaps--;
+
+    if (mapping->writable)
+        object->nwritable--;
+
+    if (mapping->attached)
+    {
+        object->detach_time = _seconds();
+        object->lpid = myst_getpid();
+    }
+
+    _object_release(object);
+    free(mapping);
+}
+
+static int _mapping_add(
+    object_t* object,
+    size_t offset,
+    size_t length,
+    bool writable,
+    bool attached)
+{
+    int ret = 0;
+    mapping_t* mapping;
+
+    if (!(mapping = calloc(1, sizeof(mapping_t))))
+        ERAISE(-ENOMEM);
+
+    mapping->object = object;
+    mapping->pid = myst_getpid();
+    mapping->addr = object->addr + offset;
+    mapping->length = length;
+    mapping->writable = writable;
+    mapping->attached = attached;
+
+    mapping->next = _mappings;
+    _mappings = mapping;
+
+    object->nrefs++;
+    object->nmaps++;
+
+    if (writable)
+        object->nwritable++;
+
+done:
+    return ret;
+}
+
+long myst_shmfs_mmap(
+    myst_fs_t* fs,
+    myst_file_t* file,
+    void* addr,
+    size_t length,
+    int prot,
+    int flags,
+    off_t offset)
+{
+    long ret = 0;
+    object_t* object;
+    const bool writable = (prot & PROT_WRITE);
+    bool locked = false;
+    size_t end;
+
+    if (!myst_is_shmfs(fs) || !_file_valid(file) || !length)
+        ERAISE(-EINVAL);
+
+    if (!(object = file->shared->object))
+        ERAISE(-ENODEV);
+
+    if (offset < 0 || (offset % PAGE_SIZE))
+        ERAISE(-EINVAL);
+
+    if (!_readable(file->shared->access))
+        ERAISE(-EACCES);
+
+    if (writable && !_writable(file->shared->access))
+        ERAISE(-EACCES);
+
+    ECHECK(myst_round_up(length, PAGE_SIZE, &length));
+
+    if (__builtin_add_overflow((size_t)offset, length, &end))
+        ERAISE(-EOVERFLOW);
+
+    _lock(&locked);
+
+    if (writable && (object->seals & (F_SEAL_WRITE | F_SEAL_FUTURE_WRITE)))
+        ERAISE(-EPERM);
+
+    /* back the whole mapping, even beyond the end of the object */
+    ECHECK(_object_reserve(object, end));
+
+    /* The pages are shared by every process (there is one address space),
+     * so they appear in one place and cannot be moved to a MAP_FIXED address
+     * (a fixed mapping of the very same place is accepted) */
+    if ((flags & MAP_FIXED) && (uint8_t*)addr != object->addr + offset)
+        ERAISE(-EINVAL);
+
+    ECHECK(_mapping_add(object, (size_t)offset, length, writable, false));
+    _now(&object->atime);
+
+    ret = (long)(object->addr + offset);
+
+done:
+    _unlock(&locked);
+    return ret;
+}
+
+bool myst_shmfs_is_shared(const void* addr, size_t length)
+{
+    bool ret = false;
+    const uint8_t* start = addr;
+    const uint8_t* end = start + length;
+    bool locked = false;
+
+    /* avoid the mutex when there are no objects at all */
+    if (!__atomic_load_n(&_objects, __ATOMIC_ACQUIRE))
+        return false;
+
+    _lock(&locked);
+
+    for (const object_t* p = _objects; p; p = p->next)
+    {
+        if (p->addr && start < p->addr + p->capacity && end > p->addr)
+        {
+            ret = true;
+            break;
+        }
+    }
+
+    _unlock(&locked);
+
+    return ret;
+}
+
+int myst_shmfs_madvise(void* addr, size_t length, int advice)
+{
+    int ret = 0;
+    uint8_t* start = addr;
+    uint8_t* end;
+
+    if (!addr || ((uintptr_t)addr % PAGE_SIZE))
+        ERAISE(-EINVAL);
+
+    if (!length)
+        goto done;
+
+    ECHECK(myst_round_up(length, PAGE_SIZE, &length));
+    end = start + length;
+
+    /* advise the runs of pages between the objects, in address order */
+    while (start < end)
+    {
+        const uint8_t* next_start = end;
+        const uint8_t* next_end = end;
+        bool locked = false;
+
+        _lock(&locked);
+
+        for (const object_t* p = _objects; p; p = p->next)
+        {
+            const uint8_t* obj_start = p->addr;
+            const uint8_t* obj_end = p->addr + p->capacity;
+
+            if (!p->addr || obj_end <= start || obj_start >= end)
+                continue;
+
+            if (obj_start < next_start)
+            {
+                next_start = obj_start;
+                next_end = obj_end;
+            }
+        }
+
+        _unlock(&locked);
+
+        if (next_start > start)
+            ECHECK(myst_madvise(start, next_start - start, advice));
+
+        start = (uint8_t*)next_end;
+    }
+
+done:
+    return ret;
+}
+
+/* split a mapping at the given page, which becomes the start of a new
+ * mapping of the same object that follows it (the caller holds the lock) */
+static int _mapping_split(mapping_t* mapping, uint8_t* at)
+{
+    int ret = 0;
+    object_t* object = mapping->object;
+    mapping_t* tail;
+
+    if (!(tail = calloc(1, sizeof(mapping_t))))
+        ERAISE(-ENOMEM);
+
+    *tail = *mapping;
+    tail->addr = at;
+    tail->length = (size_t)(mapping->addr + mapping->length - at);
+    mapping->length = (size_t)(at - mapping->addr);
+
+    tail->next = mapping->next;
+    mapping->next = tail;
+
+    object->nrefs++;
+    object->nmaps++;
+
+    if (tail->writable)
+        object->nwritable++;
+
+done:
+    return ret;
+}
+
+/* unmap private pages, as munmap() does for pages outside of any object */
+static int _munmap_private(void* addr, size_t length)
+{
+    int ret = 0;
+
+    ECHECK(myst_munmap(addr, length));
+
+    /* set ownership this mapping to nobody */
+    if (myst_mman_pids_set(addr, length, 0) != 0)
+        myst_panic("myst_mman_pids_set()");
+
+done:
+    return ret;
+}
+
+/* Unmap a range that overlaps shm objects. The mappings of the calling
+ * process are trimmed or split to the parts outside the range (the pages
+ * belong to the object and stay in place for the other mappers), and the
+ * private pages between the objects are unmapped as usual. */
+int myst_shmfs_munmap(void* addr, size_t length)
+{
+    int ret = 0;
+    uint8_t* start = addr;
+    uint8_t* end;
+    const pid_t pid = myst_getpid();
+    bool locked = false;
+
+    if (!addr || ((uintptr_t)addr % PAGE_SIZE) || !length)
+        ERAISE(-EINVAL);
+
+    ECHECK(myst_round_up(length, PAGE_SIZE, &length));
+    end = start + length;
+
+    /* Unmap the runs of private pages between the objects, in address order
+     * (before the mappings go away, which may free an object's pages) */
+    for (uint8_t* run = start; run < end;)
+    {
+        const uint8_t* next_start = end;
+        const uint8_t* next_end = end;
+
+        _lock(&locked);
+
+        for (const object_t* p = _objects; p; p = p->next)
+        {
+            const uint8_t* obj_start = p->addr;
+            const uint8_t* obj_end = p->addr + p->capacity;
+
+            if (!p->addr || obj_end <= run || obj_start >= end)
+                continue;
+
+            if (obj_start < next_start)
+            {
+                next_start = obj_start;
+                next_end = obj_end;
+            }
+        }
+
+        _unlock(&locked);
+
+        if (next_start > run)
+            ECHECK(_munmap_private(run, (size_t)(next_start - run)));
+
+        run = (uint8_t*)next_end;
+    }
+
+    _lock(&locked);
+
+    for (mapping_t** p = &_mappings; *p;)
+    {
+        mapping_t* mapping = *p;
+        uint8_t* map_start = mapping->addr;
+        uint8_t* map_end = mapping->addr + mapping->length;
+
+        if (mapping->pid != pid || map_start >= end || map_end <= start)
+        {
+            p = &mapping->next;
+            continue;
+        }
+
+        if (map_start >= start && map_end <= end)
+        {
+            /* the range covers the whole mapping */
+            *p = mapping->next;
+            _mapping_release(mapping);
+            continue;
+        }
+
+        /* keep the part after the range as a mapping of its own */
+        if (map_end > end)
+            ECHECK(_mapping_split(mapping, end));
+
+        /* keep the part before the range */
+        if (map_start < start)
+        {
+            mapping->length = (size_t)(start - map_start);
+            p = &mapping->next;
+            continue;
+        }
+
+        /* the range covers the head of the mapping */
+        *p = mapping->next;
+        _mapping_release(mapping);
+    }
+
+done:
+    _unlock(&locked);
+    return ret;
+}
+
+void myst_shmfs_release_process(pid_t pid)
+{
+    bool locked = false;
+
+    if (!__atomic_load_n(&_mappings, __ATOMIC_ACQUIRE))
+        return;
+
+    _lock(&locked);
+
+    for (mapping_t** p = &_mappings; *p;)
+    {
+        mapping_t* mapping = *p;
+
+        if (mapping->pid == pid)
+        {
+            *p = mapping->next;
+            _mapping_release(mapping);
+            continue;
+        }
+
+        p = &mapping->next;
+    }
+
+    _unlock(&locked);
+}
+
+/*
+**==============================================================================
+**
+** file system operations
+**
+**==============================================================================
+*/
+
+/* get the object name from an absolute path within the file system (the name
+ * is null for the root directory itself) */
+static int _path_to_name(const char* pathname, const char** name_out)
+{
+    int ret = 0;
+    const char* name;
+
+    if (!pathname || pathname[0] != '/')
+        ERAISE(-EINVAL);
+
+    name = pathname + 1;
+
+    if (*name == '\0')
+        name = NULL;
+    else if (strchr(name, '/'))
+        ERAISE(-ENOENT);
+    else if (strlen(name) > NAME_MAX)
+        ERAISE(-ENAMETOOLONG);
+
+    *name_out = name;
+
+done:
+    return ret;
+}
+
+/* get the object for the path (the object is null for the root directory) */
+static int _path_to_object(const char* pathname, object_t** object_out)
+{
+    int ret = 0;
+    const char* name;
+    object_t* object = NULL;
+
+    ECHECK(_path_to_name(pathname, &name));
+
+    if (name && !(object = _find_name(name)))
+        ERAISE(-ENOENT);
+
+    *object_out = object;
+
+done:
+    return ret;
+}
+
+static int _fs_release(myst_fs_t* fs)
+{
+    int ret = 0;
+    shmfs_t* shmfs = (shmfs_t*)fs;
+
+    if (!_shmfs_valid(shmfs))
+        ERAISE(-EINVAL);
+
+    memset(shmfs, 0xdd, sizeof(shmfs_t));
+    free(shmfs);
+
+done:
+    return ret;
+}
+
+static int _fs_mount(myst_fs_t* fs, const char* source, const char* target)
+{
+    int ret = 0;
+    shmfs_t* shmfs = (shmfs_t*)fs;
+
+    (void)source;
+
+    if (!_shmfs_valid(shmfs) || !target)
+        ERAISE(-EINVAL);
+
+    if (myst_strlcpy(shmfs->target, target, PATH_MAX) >= PATH_MAX)
+        ERAISE(-ENAMETOOLONG);
+
+done:
+    return ret;
+}
+
+static myst_file_t* _file_new(object_t* object, int access, int operating)
+{
+    myst_file_t* file;
+
+    if (!(file = calloc(1, sizeof(myst_file_t))))
+        return NULL;
+
+    if (!(file->shared = calloc(1, sizeof(myst_file_shared_t))))
+    {
+        free(file);
+        return NULL;
+    }
+
+    file->shared->magic = FILE_MAGIC;
+    file->shared->object = object;
+    file->shared->access = access;
+    file->shared->operating = operating;
+    file->shared->use_count = 1;
+
+    return file;
+}
+
+static int _fs_open(
+    myst_fs_t* fs,
+    const char* pathname,
+    int flags,
+    mode_t mode,
+    myst_fs_t** fs_out,
+    myst_file_t** file_out)
+{
+    int ret = 0;
+    shmfs_t* shmfs = (shmfs_t*)fs;
+    const char* name;
+    object_t* object = NULL;
+    myst_file_t* file = NULL;
+    bool locked = false;
+    int access;
+
+    if (!_shmfs_valid(shmfs) || !file_out)
+        ERAISE(-EINVAL);
+
+    ECHECK(_path_to_name(pathname, &name));
+
+    if (flags & O_PATH)
+        access = O_PATH;
+    else
+        access = flags & (O_RDONLY | O_WRONLY | O_RDWR);
+
+    _lock(&locked);
+
+    if (!name)
+    {
+        /* the /dev/shm directory */
+        if ((flags & O_CREAT) && (flags & O_EXCL))
+            ERAISE(-EEXIST);
+
+        if (_writable(access))
+            ERAISE(-EISDIR);
+    }
+    else if ((object = _find_name(name)))
+    {
+        if ((flags & O_CREAT) && (flags & O_EXCL))
+            ERAISE(-EEXIST);
+
+        if (flags & O_DIRECTORY)
+            ERAISE(-ENOTDIR);
+
+        ECHECK(_check_access(object, access));
+
+        if ((flags & O_TRUNC) && _writable(access))
+            ECHECK(_object_truncate(object, 0));
+    }
+    else
+    {
+        if (!(flags & O_CREAT) || (flags & O_DIRECTORY))
+            ERAISE(-ENOENT);
+
+        ECHECK(_object_new(name, mode, &object));
+
+        /* the name holds a reference */
+        object->linked = true;
+        object->nrefs = 1;
+    }
+
+    if (!(file = _file_new(object, access, flags & (O_APPEND | O_NONBLOCK))))
+        ERAISE(-ENOMEM);
+
+    if (flags & O_CLOEXEC)
+        file->fdflags = FD_CLOEXEC;
+
+    if (object)
+        object->nrefs++;
+
+    if (fs_out)
+        *fs_out = _fs;
+
+    *file_out = file;
+
+done:
+    _unlock(&locked);
+    return ret;
+}
+
+static int _fs_creat(
+    myst_fs_t* fs,
+    const char* pathname,
+    mode_t mode,
+    myst_fs_t** fs_out,
+    myst_file_t** file_out)
+{
+    const int flags = O_CREAT | O_WRONLY | O_TRUNC;
+    return _fs_open(fs, pathname, flags, mode, fs_out, file_out);
+}
+
+static off_t _fs_lseek(
+    myst_fs_t* fs,
+    myst_file_t* file,
+    off_t offset,
+    int whence)
+{
+    off_t ret = 0;
+    shmfs_t* shmfs = (shmfs_t*)fs;
+    bool locked = false;
+    off_t base;
+
+    if (!_shmfs_valid(shmfs) || !_file_valid(file))
+        ERAISE(-EINVAL);
+
+    if (file->shared->access == O_PATH)
+        ERAISE(-EBADF);
+
+    _lock(&locked);
+
+    switch (whence)
+    {
+        case SEEK_SET:
+            base = 0;
+            break;
+        case SEEK_CUR:
+            base = (off_t)file->shared->offset;
+            break;
+        case SEEK_END:
+            base = 0;
+            if (file->shared->object)
+                base = (off_t)file->shared->object->size;
+            break;
+        default:
+            ERAISE(-EINVAL);
+    }
+
+    if (__builtin_add_overflow(base, offset, &ret) || ret < 0)
+        ERAISE(-EINVAL);
+
+    file->shared->offset = (size_t)ret;
+
+done:
+    _unlock(&locked);
+    return ret;
+}
+
+static ssize_t _fs_pread(
+    myst_fs_t* fs,
+    myst_file_t* file,
+    void* buf,
+    size_t count,
+    off_t offset)
+{
+    ssize_t ret = 0;
+    shmfs_t* shmfs = (shmfs_t*)fs;
+    bool locked = false;
+
+    if (!_shmfs_valid(shmfs) || !_file_valid(file) || offset < 0)
+        ERAISE(-EINVAL);
+
+    if (!buf && count)
+        ERAISE(-EINVAL);
+
+    if (!_readable(file->shared->access))
+        ERAISE(-EBADF);
+
+    if (!file->shared->object)
+        ERAISE(-EISDIR);
+
+    _lock(&locked);
+    ret = _object_read(file->shared->object, (size_t)offset, buf, count);
+
+done:
+    _unlock(&locked);
+    return ret;
+}
+
+static ssize_t _fs_read(
+    myst_fs_t* fs,
+    myst_file_t* file,
+    void* buf,
+    size_t count)
+{
+    ssize_t ret = 0;
+    shmfs_t* shmfs = (shmfs_t*)fs;
+    bool locked = false;
+
+    if (!_shmfs_valid(shmfs) || !_file_valid(file))
+        ERAISE(-EINVAL);
+
+    if (!buf && count)
+        ERAISE(-EINVAL);
+
+    if (!_readable(file->shared->access))
+        ERAISE(-EBADF);
+
+    if (!file->shared->object)
+        ERAISE(-EISDIR);
+
+    _lock(&locked);
+    ret = _object_read(file->shared->object, file->shared->offset, buf, count);
+    file->shared->offset += (size_t)ret;
+
+done:
+    _unlock(&locked);
+    return ret;
+}
+
+static ssize_t _fs_readv(
+    myst_fs_t* fs,
+    myst_file_t* file,
+    const struct iovec* iov,
+    int iovcnt)
+{
+    ssize_t ret = 0;
+    shmfs_t* shmfs = (shmfs_t*)fs;
+    bool locked = false;
+    size_t total = 0;
+
+    if (!_shmfs_valid(shmfs) || !_file_valid(file))
+        ERAISE(-EINVAL);
+
+    ECHECK(myst_iov_len(iov, iovcnt));
+
+    if (!_readable(file->shared->access))
+        ERAISE(-EBADF);
+
+    if (!file->shared->object)
+        ERAISE(-EISDIR);
+
+    _lock(&locked);
+
+    for (int i = 0; i < iovcnt; i++)
+    {
+        const size_t len = iov[i].iov_len;
+        ssize_t n = _object_read(
+            file->shared->object,
+            file->shared->offset + total,
+            iov[i].iov_base,
+            len);
+
+        total += (size_t)n;
+
+        if ((size_t)n < len)
+            break;
+    }
+
+    file->shared->offset += total;
+    ret = (ssize_t)total;
+
+done:
+    _unlock(&locked);
+    return ret;
+}
+
+static ssize_t _fs_pwrite(
+    myst_fs_t* fs,
+    myst_file_t* file,
+    const void* buf,
+    size_t count,
+    off_t offset)
+{
+    ssize_t ret = 0;
+    shmfs_t* shmfs = (shmfs_t*)fs;
+    object_t* object;
+    bool locked = false;
+
+    if (!_shmfs_valid(shmfs) || !_file_valid(file) || offset < 0)
+        ERAISE(-EINVAL);
+
+    if (!buf && count)
+        ERAISE(-EINVAL);
+
+    if (!_writable(file->shared->access))
+        ERAISE(-EBADF);
+
+    if (!(object = file->shared->object))
+        ERAISE(-EISDIR);
+
+    _lock(&locked);
+
+    /* like Linux, pwrite() appends when the file was opened with O_APPEND */
+    if (file->shared->operating & O_APPEND)
+        offset = (off_t)object->size;
+
+    ECHECK(ret = _object_write(object, (size_t)offset, buf, count));
+
+done:
+    _unlock(&locked);
+    return ret;
+}
+
+static ssize_t _fs_write(
+    myst_fs_t* fs,
+    myst_file_t* file,
+    const void* buf,
+    size_t count)
+{
+    ssize_t ret = 0;
+    shmfs_t* shmfs = (shmfs_t*)fs;
+    object_t* object;
+    bool locked = false;
+
+    if (!_shmfs_valid(shmfs) || !_file_valid(file))
+        ERAISE(-EINVAL);
+
+    if (!buf && count)
+        ERAISE(-EINVAL);
+
+    if (!_writable(file->shared->access))
+        ERAISE(-EBADF);
+
+    if (!(object = file->shared->object))
+        ERAISE(-EISDIR);
+
+    _lock(&locked);
+
+    if (file->shared->operating & O_APPEND)
+        file->shared->offset = object->size;
+
+    ECHECK(ret = _object_write(object, file->shared->offset, buf, count));
+    file->shared->offset += (size_t)ret;
+
+done:
+    _unlock(&locked);
+    return ret;
+}
+
+static ssize_t _fs_writev(
+    myst_fs_t* fs,
+    myst_file_t* file,
+    const struct iovec* iov,
+    int iovcnt)
+{
+    ssize_t ret = 0;
+    shmfs_t* shmfs = (shmfs_t*)fs;
+    object_t* object;
+    bool locked = false;
+    size_t total = 0;
+
+    if (!_shmfs_valid(shmfs) || !_file_valid(file))
+        ERAISE(-EINVAL);
+
+    ECHECK(myst_iov_len(iov, iovcnt));
+
+    if (!_writable(file->shared->access))
+        ERAISE(-EBADF);
+
+    if (!(object = file->shared->object))
+        ERAISE(-EISDIR);
+
+    _lock(&locked);
+
+    if (file->shared->operating & O_APPEND)
+        file->shared->offset = object->size;
+
+    for (int i = 0; i < iovcnt; i++)
+    {
+        ssize_t n = _object_write(
+            object,
+            file->shared->offset + total,
+            iov[i].iov_base,
+            iov[i].iov_len);
+
+        /* report the error only if nothing was written */
+        if (n < 0)
+        {
+            if (total == 0)
+                ERAISE(n);
+            break;
+        }
+
+        total += (size_t)n;
+    }
+
+    file->shared->offset += total;
+    ret = (ssize_t)total;
+
+done:
+    _unlock(&locked);
+    return ret;
+}
+
+static int _fs_close(myst_fs_t* fs, myst_file_t* file)
+{
+    int ret = 0;
+    shmfs_t* shmfs = (shmfs_t*)fs;
+    bool locked = false;
+
+    if (!_shmfs_valid(shmfs) || !_file_valid(file))
+        ERAISE(-EINVAL);
+
+    _lock(&locked);
+
+    if (--file->shared->use_count == 0)
+    {
+        if (file->shared->object)
+            _object_release(file->shared->object);
+
+        memset(file->shared, 0xdd, sizeof(myst_file_shared_t));
+        free(file->shared);
+    }
+
+    memset(file, 0xdd, sizeof(myst_file_t));
+    free(file);
+
+done:
+    _unlock(&locked);
+    return ret;
+}
+
+static int _fs_access(myst_fs_t* fs, const char* pathname, int mode)
+{
+    int ret = 0;
+    shmfs_t* shmfs = (shmfs_t*)fs;
+    object_t* object;
+    bool locked = false;
+
+    if (!_shmfs_valid(shmfs))
+        ERAISE(-EINVAL);
+
+    if (mode != F_OK && (mode & ~(R_OK | W_OK | X_OK)))
+        ERAISE(-EINVAL);
+
+    _lock(&locked);
+    ECHECK(_path_to_object(pathname, &object));
+
+    if (object)
+    {
+        if ((mode & R_OK) && !(object->mode & S_IRUSR))
+            ERAISE(-EACCES);
+
+        if ((mode & W_OK) && !(object->mode & S_IWUSR))
+            ERAISE(-EACCES);
+
+        if ((mode & X_OK) && !(object->mode & S_IXUSR))
+            ERAISE(-EACCES);
+    }
+
+done:
+    _unlock(&locked);
+    return ret;
+}
+
+static int _fs_stat(myst_fs_t* fs, const char* pathname, struct stat* statbuf)
+{
+    int ret = 0;
+    shmfs_t* shmfs = (shmfs_t*)fs;
+    object_t* object;
+    bool locked = false;
+
+    if (!_shmfs_valid(shmfs) || !statbuf)
+        ERAISE(-EINVAL);
+
+    _lock(&locked);
+    ECHECK(_path_to_object(pathname, &object));
+    _stat(object, statbuf);
+
+done:
+    _unlock(&locked);
+    return ret;
+}
+
+static int _fs_fstat(myst_fs_t* fs, myst_file_t* file, struct stat* statbuf)
+{
+    int ret = 0;
+    shmfs_t* shmfs = (shmfs_t*)fs;
+    bool locked = false;
+
+    if (!_shmfs_valid(shmfs) || !_file_valid(file) || !statbuf)
+        ERAISE(-EINVAL);
+
+    _lock(&locked);
+    _stat(file->shared->object, statbuf);
+
+done:
+    _unlock(&locked);
+    return ret;
+}
+
+static int _fs_link(myst_fs_t* fs, const char* oldpath, const char* newpath)
+{
+    (void)fs;
+    (void)oldpath;
+    (void)newpath;
+    return -EPERM;
+}
+
+static int _fs_unlink(myst_fs_t* fs, const char* pathname)
+{
+    int ret = 0;
+    shmfs_t* shmfs = (shmfs_t*)fs;
+    object_t* object;
+    bool locked = false;
+
+    if (!_shmfs_valid(shmfs))
+        ERAISE(-EINVAL);
+
+    _lock(&locked);
+    ECHECK(_path_to_object(pathname, &object));
+
+    if (!object)
+        ERAISE(-EISDIR);
+
+    /* the object lives on while it is open or mapped */
+    object->linked = false;
+    _now(&object->ctime);
+    _object_release(object);
+
+done:
+    _unlock(&locked);
+    return ret;
+}
+
+static int _fs_rename(myst_fs_t* fs, const char* oldpath, const char* newpath)
+{
+    int ret = 0;
+    shmfs_t* shmfs = (shmfs_t*)fs;
+    object_t* object;
+    object_t* target;
+    const char* name;
+    char* new_name = NULL;
+    bool locked = false;
+
+    if (!_shmfs_valid(shmfs))
+        ERAISE(-EINVAL);
+
+    _lock(&locked);
+    ECHECK(_path_to_object(oldpath, &object));
+    ECHECK(_path_to_name(newpath, &name));
+
+    if (!object || !name)
+        ERAISE(-EBUSY);
+
+    if ((target = _find_name(name)) == object)
+        goto done;
+
+    if (!(new_name = strdup(name)))
+        ERAISE(-ENOMEM);
+
+    if (target)
+    {
+        target->linked = false;
+        _object_release(target);
+    }
+
+    free(object->name);
+    object->name = new_name;
+    new_name = NULL;
+    _now(&object->ctime);
+
+done:
+    _unlock(&locked);
+
+    if (new_name)
+        free(new_name);
+
+    return ret;
+}
+
+static int _fs_truncate(myst_fs_t* fs, const char* pathname, off_t length)
+{
+    int ret = 0;
+    shmfs_t* shmfs = (shmfs_t*)fs;
+    object_t* object;
+    bool locked = false;
+
+    if (!_shmfs_valid(shmfs) || length < 0)
+        ERAISE(-EINVAL);
+
+    _lock(&locked);
+    ECHECK(_path_to_object(pathname, &object));
+
+    if (!object)
+        ERAISE(-EISDIR);
+
+    ECHECK(_check_access(object, O_WRONLY));
+    ECHECK(_object_truncate(object, (size_t)length));
+
+done:
+    _unlock(&locked);
+    return ret;
+}
+
+static int _fs_ftruncate(myst_fs_t* fs, myst_file_t* file, off_t length)
+{
+    int ret = 0;
+    shmfs_t* shmfs = (shmfs_t*)fs;
+    bool locked = false;
+
+    if (!_shmfs_valid(shmfs) || !_file_valid(file) || length < 0)
+        ERAISE(-EINVAL);
+
+    if (!file->shared->object || !_writable(file->shared->access))
+        ERAISE(-EINVAL);
+
+    _lock(&locked);
+    ECHECK(_object_truncate(file->shared->object, (size_t)length));
+
+done:
+    _unlock(&locked);
+    return ret;
+}
+
+static int _fs_mkdir(myst_fs_t* fs, const char* pathname, mode_t mode)
+{
+    int ret = 0;
+    shmfs_t* shmfs = (shmfs_t*)fs;
+    const char* name;
+
+    (void)mode;
+
+    if (!_shmfs_valid(shmfs))
+        ERAISE(-EINVAL);
+
+    ECHECK(_path_to_name(pathname, &name));
+
+    /* the namespace is flat */
+    ERAISE(name ? -EPERM : -EEXIST);
+
+done:
+    return ret;
+}
+
+static int _fs_rmdir(myst_fs_t* fs, const char* pathname)
+{
+    int ret = 0;
+    shmfs_t* shmfs = (shmfs_t*)fs;
+    object_t* object;
+    bool locked = false;
+
+    if (!_shmfs_valid(shmfs))
+        ERAISE(-EINVAL);
+
+    _lock(&locked);
+    ECHECK(_path_to_object(pathname, &object));
+    ERAISE(object ? -ENOTDIR : -EBUSY);
+
+done:
+    _unlock(&locked);
+    return ret;
+}
+
+static int _fs_getdents64(
+    myst_fs_t* fs,
+    myst_file_t* file,
+    struct dirent* dirp,
+    size_t count)
+{
+    int ret = 0;
+    shmfs_t* shmfs = (shmfs_t*)fs;
+    bool locked = false;
+    size_t bytes = 0;
+    const object_t* next = NULL;
+
+    if (!_shmfs_valid(shmfs) || !_file_valid(file) || !dirp)
+        ERAISE(-EINVAL);
+
+    if (file->shared->object)
+        ERAISE(-ENOTDIR);
+
+    _lock(&locked);
+
+    /* the offset is the index of the next entry: ".", ".." then the names */
+    if (file->shared->offset >= 2)
+    {
+        size_t n = file->shared->offset - 2;
+
+        for (next = _objects; next; next = next->next)
+        {
+            if (next->linked && n-- == 0)
+                break;
+        }
+    }
+
+    while (bytes + sizeof(struct dirent) <= count)
+    {
+        struct dirent* ent = (struct dirent*)((uint8_t*)dirp + bytes);
+        const size_t index = file->shared->offset;
+
+        memset(ent, 0, sizeof(struct dirent));
+
+        if (index < 2)
+        {
+            ent->d_ino = 1;
+            ent->d_type = DT_DIR;
+            myst_strlcpy(ent->d_name, index ? ".." : ".", sizeof(ent->d_name));
+
+            if (index == 1)
+                next = _objects;
+        }
+        else
+        {
+            while (next && !next->linked)
+                next = next->next;
+
+            if (!next)
+                break;
+
+            ent->d_ino = (ino_t)next;
+            ent->d_type = DT_REG;
+            myst_strlcpy(ent->d_name, next->name, sizeof(ent->d_name));
+            next = next->next;
+        }
+
+        ent->d_off = (off_t)(index + 1);
+        ent->d_reclen = sizeof(struct dirent);
+        file->shared->offset++;
+        bytes += sizeof(struct dirent);
+    }
+
+    if (bytes == 0 && count < sizeof(struct dirent))
+        ERAISE(-EINVAL);
+
+    ret = (int)bytes;
+
+done:
+    _unlock(&locked);
+    return ret;
+}
+
+static ssize_t _fs_readlink(
+    myst_fs_t* fs,
+    const char* pathname,
+    char* buf,
+    size_t bufsiz)
+{
+    ssize_t ret = 0;
+    shmfs_t* shmfs = (shmfs_t*)fs;
+    object_t* object;
+    bool locked = false;
+
+    (void)buf;
+    (void)bufsiz;
+
+    if (!_shmfs_valid(shmfs))
+        ERAISE(-EINVAL);
+
+    _lock(&locked);
+    ECHECK(_path_to_object(pathname, &object));
+
+    /* there are no symbolic links */
+    ERAISE(-EINVAL);
+
+done:
+    _unlock(&locked);
+    return ret;
+}
+
+static int _fs_symlink(myst_fs_t* fs, const char* target, const char* linkpath)
+{
+    (void)fs;
+    (void)target;
+    (void)linkpath;
+    return -EPERM;
+}
+
+static int _fs_realpath(
+    myst_fs_t* fs,
+    myst_file_t* file,
+    char* buf,
+    size_t size)
+{
+    int ret = 0;
+    shmfs_t* shmfs = (shmfs_t*)fs;
+    const object_t* object;
+    bool locked = false;
+
+    if (!_shmfs_valid(shmfs) || !_file_valid(file) || !buf || !size)
+        ERAISE(-EINVAL);
+
+    _lock(&locked);
+
+    if (!(object = file->shared->object))
+    {
+        if (myst_strlcpy(buf, shmfs->target, size) >= size)
+            ERAISE(-ENAMETOOLONG);
+    }
+    else if (object->memfd)
+    {
+        ECHECK(myst_snprintf(buf, size, "/memfd:%s (deleted)", object->name));
+    }
+    else
+    {
+        const char* deleted = object->linked ? "" : " (deleted)";
+        const char* target = shmfs->target;
+
+        /* avoid a double slash when mounted on the root */
+        if (strcmp(target, "/") == 0)
+            target = "";
+
+        ECHECK(
+            myst_snprintf(buf, size, "%s/%s%s", target, object->name, deleted));
+    }
+
+done:
+    _unlock(&locked);
+    return ret;
+}
+
+static int _add_seals(myst_file_t* file, unsigned int seals)
+{
+    int ret = 0;
+    object_t* object = file->shared->object;
+
+    if (!object || (seals & ~(unsigned int)ALL_SEALS))
+        ERAISE(-EINVAL);
+
+    if (!_writable(file->shared->access))
+        ERAISE(-EPERM);
+
+    if (object->seals & F_SEAL_SEAL)
+        ERAISE(-EPERM);
+
+    if ((seals & F_SEAL_WRITE) && object->nwritable)
+        ERAISE(-EBUSY);
+
+    object->seals |= seals;
+
+done:
+    return ret;
+}
+
+static int _fs_fcntl(myst_fs_t* fs, myst_file_t* file, int cmd, long arg)
+{
+    int ret = 0;
+    shmfs_t* shmfs = (shmfs_t*)fs;
+    bool locked = false;
+
+    if (!_shmfs_valid(shmfs) || !_file_valid(file))
+        ERAISE(-EINVAL);
+
+    _lock(&locked);
+
+    switch (cmd)
+    {
+        case F_GETFD:
+        {
+            ret = file->fdflags;
+            break;
+        }
+        case F_SETFD:
+        {
+            file->fdflags = (arg & FD_CLOEXEC) ? FD_CLOEXEC : 0;
+            break;
+        }
+        case F_GETFL:
+        {
+            ret = file->shared->access | file->shared->operating;
+            break;
+        }
+        case F_SETFL:
+        {
+            file->shared->operating = (int)arg & (O_APPEND | O_NONBLOCK);
+            break;
+        }
+        case F_SETLK:
+        case F_SETLKW:
+        {
+            /* ATTN: silently ignore locking for now */
+            break;
+        }
+        case F_ADD_SEALS:
+        {
+            ECHECK(_add_seals(file, (unsigned int)arg));
+            break;
+        }
+        case F_GET_SEALS:
+        {
+            if (!file->shared->object)
+                ERAISE(-EINVAL);
+
+            ret = (int)file->shared->object->seals;
+            break;
+        }
+        default:
+        {
+            ERAISE(-ENOTSUP);
+        }
+    }
+
+done:
+    _unlock(&locked);
+    return ret;
+}
+
+static int _fs_ioctl(
+    myst_fs_t* fs,
+    myst_file_t* file,
+    unsigned long request,
+    long arg)
+{
+    int ret = 0;
+    shmfs_t* shmfs = (shmfs_t*)fs;
+
+    (void)arg;
+
+    if (!_shmfs_valid(shmfs) || !_file_valid(file))
+        ERAISE(-EINVAL);
+
+    switch (request)
+    {
+        case FIOCLEX:
+            file->fdflags = FD_CLOEXEC;
+            break;
+        case FIONCLEX:
+            file->fdflags = 0;
+            break;
+        default:
+            ERAISE(-ENOTTY);
+    }
+
+done:
+    return ret;
+}
+
+static int _fs_dup(
+    myst_fs_t* fs,
+    const myst_file_t* file,
+    myst_file_t** file_out)
+{
+    int ret = 0;
+    shmfs_t* shmfs = (shmfs_t*)fs;
+    myst_file_t* new_file;
+    bool locked = false;
+
+    if (!_shmfs_valid(shmfs) || !_file_valid(file) || !file_out)
+        ERAISE(-EINVAL);
+
+    if (!(new_file = calloc(1, sizeof(myst_file_t))))
+        ERAISE(-ENOMEM);
+
+    _lock(&locked);
+
+    /* the new descriptor shares the open file description */
+    new_file->shared = file->shared;
+    new_file->shared->use_count++;
+    new_file->fdflags = 0;
+
+    *file_out = new_file;
+
+done:
+    _unlock(&locked);
+    return ret;
+}
+
+static int _fs_target_fd(myst_fs_t* fs, myst_file_t* file)
+{
+    (void)fs;
+    (void)file;
+    return -ENOTSUP;
+}
+
+static int _fs_get_events(myst_fs_t* fs, myst_file_t* file)
+{
+    int ret = 0;
+    shmfs_t* shmfs = (shmfs_t*)fs;
+
+    if (!_shmfs_valid(shmfs) || !_file_valid(file))
+        ERAISE(-EINVAL);
+
+    ret = POLLIN | POLLOUT;
+
+done:
+    return ret;
+}
+
+static void _statfs(struct statfs* buf)
+{
+    memset(buf, 0, sizeof(struct statfs));
+    buf->f_type = TMPFS_MAGIC;
+    buf->f_bsize = PAGE_SIZE;
+    buf->f_frsize = PAGE_SIZE;
+    buf->f_namelen = NAME_MAX;
+}
+
+static int _fs_statfs(myst_fs_t* fs, const char* pathname, struct statfs* buf)
+{
+    int ret = 0;
+    shmfs_t* shmfs = (shmfs_t*)fs;
+    object_t* object;
+    bool locked = false;
+
+    if (!_shmfs_valid(shmfs) || !buf)
+        ERAISE(-EINVAL);
+
+    _lock(&locked);
+    ECHECK(_path_to_object(pathname, &object));
+    _statfs(buf);
+
+done:
+    _unlock(&locked);
+    return ret;
+}
+
+static int _fs_fstatfs(myst_fs_t* fs, myst_file_t* file, struct statfs* buf)
+{
+    int ret = 0;
+    shmfs_t* shmfs = (shmfs_t*)fs;
+
+    if (!_shmfs_valid(shmfs) || !_file_valid(file) || !buf)
+        ERAISE(-EINVAL);
+
+    _statfs(buf);
+
+done:
+    return ret;
+}
+
+static int _fs_futimens(
+    myst_fs_t* fs,
+    myst_file_t* file,
+    const struct timespec times[2])
+{
+    int ret = 0;
+    shmfs_t* shmfs = (shmfs_t*)fs;
+    object_t* object;
+    struct timespec now;
+    bool locked = false;
+
+    if (!_shmfs_valid(shmfs) || !_file_valid(file))
+        ERAISE(-EINVAL);
+
+    if (!(object = file->shared->object))
+        goto done;
+
+    _lock(&locked);
+    _now(&now);
+
+    if (!times)
+    {
+        object->atime = now;
+        object->mtime = now;
+    }
+    else
+    {
+        if (times[0].tv_nsec == UTIME_NOW)
+            object->atime = now;
+        else if (times[0].tv_nsec != UTIME_OMIT)
+            object->atime = times[0];
+
+        if (times[1].tv_nsec == UTIME_NOW)
+            object->mtime = now;
+        else if (times[1].tv_nsec != UTIME_OMIT)
+            object->mtime = times[1];
+    }
+
+    object->ctime = now;
+
+done:
+    _unlock(&locked);
+    return ret;
+}
+
+static void _chown(object_t* object, uid_t owner, gid_t group)
+{
+    if (!object)
+        return;
+
+    if (owner != -1u)
+        object->uid = owner;
+
+    if (group != -1u)
+        object->gid = group;
+
+    _now(&object->ctime);
+}
+
+static int _fs_chown(myst_fs_t* fs, const char* path, uid_t owner, gid_t group)
+{
+    int ret = 0;
+    shmfs_t* shmfs = (shmfs_t*)fs;
+    object_t* object;
+    bool locked = false;
+
+    if (!_shmfs_valid(shmfs))
+        ERAISE(-EINVAL);
+
+    _lock(&locked);
+    ECHECK(_path_to_object(path, &object));
+    _chown(object, owner, group);
+
+done:
+    _unlock(&locked);
+    return ret;
+}
+
+static int _fs_fchown(
+    myst_fs_t* fs,
+    myst_file_t* file,
+    uid_t owner,
+    gid_t group)
+{
+    int ret = 0;
+    shmfs_t* shmfs = (shmfs_t*)fs;
+    bool locked = false;
+
+    if (!_shmfs_valid(shmfs) || !_file_valid(file))
+        ERAISE(-EINVAL);
+
+    _lock(&locked);
+    _chown(file->shared->object, owner, group);
+
+done:
+    _unlock(&locked);
+    return ret;
+}
+
+static void _chmod(object_t* object, mode_t mode)
+{
+    if (!object)
+        return;
+
+    object->mode = (object->mode & S_IFMT) | (mode & 07777);
+    _now(&object->ctime);
+}
+
+static int _fs_chmod(myst_fs_t* fs, const char* pathname, mode_t mode)
+{
+    int ret = 0;
+    shmfs_t* shmfs = (shmfs_t*)fs;
+    object_t* object;
+    bool locked = false;
+
+    if (!_shmfs_valid(shmfs))
+        ERAISE(-EINVAL);
+
+    _lock(&locked);
+    ECHECK(_path_to_object(pathname, &object));
+    _chmod(object, mode);
+
+done:
+    _unlock(&locked);
+    return ret;
+}
+
+static int _fs_fchmod(myst_fs_t* fs, myst_file_t* file, mode_t mode)
+{
+    int ret = 0;
+    shmfs_t* shmfs = (shmfs_t*)fs;
+    bool locked = false;
+
+    if (!_shmfs_valid(shmfs) || !_file_valid(file))
+        ERAISE(-EINVAL);
+
+    _lock(&locked);
+    _chmod(file->shared->object, mode);
+
+done:
+    _unlock(&locked);
+    return ret;
+}
+
+static int _fs_fsync_and_fdatasync(myst_fs_t* fs, myst_file_t* file)
+{
+    int ret = 0;
+    shmfs_t* shmfs = (shmfs_t*)fs;
+
+    if (!_shmfs_valid(shmfs) || !_file_valid(file))
+        ERAISE(-EINVAL);
+
+done:
+    return ret;
+}
+
+static int _fs_release_tree(myst_fs_t* fs, const char* pathname)
+{
+    (void)fs;
+    (void)pathname;
+    return -ENOTSUP;
+}
+
+/*
+**==============================================================================
+**
+** memfd_create()
+**
+**==============================================================================
+*/
+
+long myst_syscall_memfd_create(const char* name, unsigned int flags)
+{
+    long ret = 0;
+    myst_fdtable_t* fdtable = myst_fdtable_current();
+    object_t* object = NULL;
+    myst_file_t* file = NULL;
+    bool locked = false;
+    int fd;
+
+    if (!name)
+        ERAISE(-EFAULT);
+
+    if (strlen(name) > MFD_NAME_MAX)
+        ERAISE(-EINVAL);
+
+    if (flags & ~(MFD_CLOEXEC | MFD_ALLOW_SEALING))
+        ERAISE(-EINVAL);
+
+    if (!_fs)
+        ERAISE(-ENOSYS);
+
+    _lock(&locked);
+
+    ECHECK(_object_new(name, 0777, &object));
+    object->memfd = true;
+
+    /* the open file holds the only reference */
+    object->nrefs = 1;
+
+    if (flags & MFD_ALLOW_SEALING)
+        object->seals = 0;
+
+    if (!(file = _file_new(object, O_RDWR, 0)))
+    {
+        _object_release(object);
+        ERAISE(-ENOMEM);
+    }
+
+    if (flags & MFD_CLOEXEC)
+        file->fdflags = FD_CLOEXEC;
+
+    _unlock(&locked);
+
+    fd = myst_fdtable_assign(fdtable, MYST_FDTABLE_TYPE_FILE, _fs, file);
+
+    if (fd < 0)
+    {
+        (*_fs->fs_close)(_fs, file);
+        ERAISE(fd);
+    }
+
+    if ((ret = myst_add_fd_link(_fs, file, fd)) != 0)
+    {
+        myst_fdtable_remove(fdtable, fd);
+        (*_fs->fs_close)(_fs, file);
+        ERAISE(ret);
+    }
+
+    ret = fd;
+
+done:
+    _unlock(&locked);
+    return ret;
+}
+
+/*
+**==============================================================================
+**
+** System V shared memory
+**
+**==============================================================================
+*/
+
+long myst_syscall_shmget(key_t key, size_t size, int shmflg)
+{
+    long ret = 0;
+    object_t* object = NULL;
+    bool locked = false;
+    char name[16];
+    int r;
+
+    _lock(&locked);
+
+    if (key != IPC_PRIVATE)
+    {
+        for (object_t* p = _objects; p; p = p->next)
+        {
+            if (p->shmid >= 0 && !p->removed && p->key == key)
+            {
+                object = p;
+                break;
+            }
+        }
+    }
+
+    if (object)
+    {
+        if ((shmflg & IPC_CREAT) && (shmflg & IPC_EXCL))
+            ERAISE(-EEXIST);
+
+        if (size > object->size)
+            ERAISE(-EINVAL);
+
+        ret = object->shmid;
+        goto done;
+    }
+
+    if (key != IPC_PRIVATE && !(shmflg & IPC_CREAT))
+        ERAISE(-ENOENT);
+
+    if (size == 0 || size > SSIZE_MAX)
+        ERAISE(-EINVAL);
+
+    /* Linux names segments SYSV<key> in /proc/<pid>/maps */
+    ECHECK(myst_snprintf(name, sizeof(name), "SYSV%08x", (unsigned int)key));
+    ECHECK(_object_new(name, (mode_t)shmflg & 0777, &object));
+
+    /* the segment holds a reference until IPC_RMID */
+    object->nrefs = 1;
+    object->key = key;
+    object->cpid = myst_getpid();
+    object->shmid = _next_shmid;
+
+    if ((r = _object_reserve(object, size)) != 0)
+    {
+        _object_release(object);
+        ERAISE(r);
+    }
+
+    object->size = size;
+    _next_shmid = (_next_shmid == INT_MAX) ? 0 : _next_shmid + 1;
+    ret = object->shmid;
+
+done:
+    _unlock(&locked);
+    return ret;
+}
+
+long myst_syscall_shmat(int shmid, const void* shmaddr, int shmflg)
+{
+    long ret = 0;
+    object_t* object;
+    bool locked = false;
+    const bool writable = !(shmflg & SHM_RDONLY);
+
+    _lock(&locked);
+
+    if (!(object = _find_shmid(shmid)))
+        ERAISE(-EINVAL);
+
+    /* the segment can only be attached where its pages already are */
+    if (shmaddr)
+    {
+        uintptr_t addr = (uintptr_t)shmaddr;
+
+        if (shmflg & SHM_RND)
+            addr -= addr % PAGE_SIZE;
+
+        if (addr != (uintptr_t)object->addr)
+            ERAISE(-EINVAL);
+    }
+
+    ECHECK(_mapping_add(object, 0, object->capacity, writable, true));
+    object->attach_time = _seconds();
+    object->lpid = myst_getpid();
+
+    ret = (long)object->addr;
+
+done:
+    _unlock(&locked);
+    return ret;
+}
+
+long myst_syscall_shmdt(const void* shmaddr)
+{
+    long ret = 0;
+    const pid_t pid = myst_getpid();
+    bool locked = false;
+
+    _lock(&locked);
+
+    for (mapping_t** p = &_mappings; *p; p = &(*p)->next)
+    {
+        mapping_t* mapping = *p;
+
+        if (mapping->pid == pid && mapping->attached &&
+            mapping->addr == shmaddr)
+        {
+            *p = mapping->next;
+            _mapping_release(mapping);
+            goto done;
+        }
+    }
+
+    ERAISE(-EINVAL);
+
+done:
+    _unlock(&locked);
+    return ret;
+}
+
+static void _shmid_ds(const object_t* object, struct shmid_ds* buf)
+{
+    memset(buf, 0, sizeof(struct shmid_ds));
+    buf->shm_perm.__key = object->key;
+    buf->shm_perm.uid = object->uid;
+    buf->shm_perm.gid = object->gid;
+    buf->shm_perm.cuid = object->cuid;
+    buf->shm_perm.cgid = object->cgid;
+    buf->shm_perm.mode = (object->mode & 0777);
+
+    if (object->removed)
+        buf->shm_perm.mode |= SHM_DEST;
+
+    buf->shm_segsz = object->size;
+    buf->shm_atime = object->attach_time;
+    buf->shm_dtime = object->detach_time;
+    buf->shm_ctime = object->ctime.tv_sec;
+    buf->shm_cpid = object->cpid;
+    buf->shm_lpid = object->lpid;
+    buf->shm_nattch = object->nmaps;
+}
+
+long myst_syscall_shmctl(int shmid, int cmd, struct shmid_ds* buf)
+{
+    long ret = 0;
+    object_t* object;
+    bool locked = false;
+
+    /* ignore the IPC_64 flag, which every modern libc passes */
+    cmd &= ~IPC_64;
+
+    _lock(&locked);
+
+    if (!(object = _find_shmid(shmid)))
+        ERAISE(-EINVAL);
+
+    switch (cmd)
+    {
+        case IPC_STAT:
+        case SHM_STAT:
+        {
+            if (!buf || myst_is_bad_addr_write(buf, sizeof(*buf)))
+                ERAISE(-EFAULT);
+
+            _shmid_ds(object, buf);
+
+            if (cmd == SHM_STAT)
+                ret = object->shmid;
+
+            break;
+        }
+        case IPC_SET:
+        {
+            if (!buf || myst_is_bad_addr_read(buf, sizeof(*buf)))
+                ERAISE(-EFAULT);
+
+            object->uid = buf->shm_perm.uid;
+            object->gid = buf->shm_perm.gid;
+            object->mode = S_IFREG | (buf->shm_perm.mode & 0777);
+            _now(&object->ctime);
+            break;
+        }
+        case IPC_RMID:
+        {
+            /* destroy the segment after the last detach */
+            if (!object->removed)
+            {
+                object->removed = true;
+                object->key = IPC_PRIVATE;
+                _object_release(object);
+            }
+            break;
+        }
+        case SHM_LOCK:
+        case SHM_UNLOCK:
+        {
+            /* enclave pages are never swapped */
+            break;
+        }
+        default:
+        {
+            ERAISE(-EINVAL);
+        }
+    }
+
+done:
+    _unlock(&locked);
+    return ret;
+}
+
+/*
+**==============================================================================
+**
+** setup and teardown
+**
+**==============================================================================
+*/
+
+bool myst_is_shmfs(const myst_fs_t* fs)
+{
+    return fs && fs == _fs;
+}
+
+int shmfs_setup(void)
+{
+    int ret = 0;
+    shmfs_t* shmfs = NULL;
+    myst_fs_t* lockfs = NULL;
+    // clang-format off
+    static myst_fs_t _base =
+    {
+        {
+            .fd_read = (void*)_fs_read,
+            .fd_write = (void*)_fs_write,
+            .fd_readv = (void*)_fs_readv,
+            .fd_writev = (void*)_fs_writev,
+            .fd_fstat = (void*)_fs_fstat,
+            .fd_fcntl = (void*)_fs_fcntl,
+            .fd_ioctl = (void*)_fs_ioctl,
+            .fd_dup = (void*)_fs_dup,
+            .fd_close = (void*)_fs_close,
+            .fd_target_fd = (void*)_fs_target_fd,
+            .fd_get_events = (void*)_fs_get_events,
+        },
+        .fs_release = _fs_release,
+        .fs_mount = _fs_mount,
+        .fs_creat = _fs_creat,
+        .fs_open = _fs_open,
+        .fs_lseek = _fs_lseek,
+        .fs_read = _fs_read,
+        .fs_write = _fs_write,
+        .fs_pread = _fs_pread,
+        .fs_pwrite = _fs_pwrite,
+        .fs_readv = _fs_readv,
+        .fs_writev = _fs_writev,
+        .fs_close = _fs_close,
+        .fs_access = _fs_access,
+        .fs_stat = _fs_stat,
+        .fs_lstat = _fs_stat,
+        .fs_fstat = _fs_fstat,
+        .fs_link = _fs_link,
+        .fs_unlink = _fs_unlink,
+        .fs_rename = _fs_rename,
+        .fs_truncate = _fs_truncate,
+        .fs_ftruncate = _fs_ftruncate,
+        .fs_mkdir = _fs_mkdir,
+        .fs_rmdir = _fs_rmdir,
+        .fs_getdents64 = _fs_getdents64,
+        .fs_readlink = _fs_readlink,
+        .fs_symlink = _fs_symlink,
+        .fs_realpath = _fs_realpath,
+        .fs_fcntl = _fs_fcntl,
+        .fs_ioctl = _fs_ioctl,
+        .fs_dup = _fs_dup,
+        .fs_target_fd = _fs_target_fd,
+        .fs_get_events = _fs_get_events,
+        .fs_statfs = _fs_statfs,
+        .fs_fstatfs = _fs_fstatfs,
+        .fs_futimens = _fs_futimens,
+        .fs_chown = _fs_chown,
+        .fs_fchown = _fs_fchown,
+        .fs_lchown = _fs_chown,
+        .fs_chmod = _fs_chmod,
+        .fs_fchmod = _fs_fchmod,
+        .fs_fdatasync = _fs_fsync_and_fdatasync,
+        .fs_fsync = _fs_fsync_and_fdatasync,
+        .fs_release_tree = _fs_release_tree,
+    };
+    // clang-format on
+
+    if (!(shmfs = calloc(1, sizeof(shmfs_t))))
+        ERAISE(-ENOMEM);
+
+    shmfs->base = _base;
+    shmfs->magic = SHMFS_MAGIC;
+    myst_strlcpy(shmfs->target, "/", sizeof(shmfs->target));
+
+    /* always wrap shmfs inside lockfs */
+    ECHECK(myst_lockfs_init(&shmfs->base, &lockfs));
+    shmfs = NULL;
+
+    if (myst_mkdirhier("/dev/shm", 01777) != 0)
+    {
+        myst_eprintf("cannot create mount point for shmfs\n");
+        ERAISE(-EINVAL);
+    }
+
+    if (myst_mount(lockfs, "/", "/dev/shm", false) != 0)
+    {
+        myst_eprintf("cannot mount shm file system\n");
+        ERAISE(-EINVAL);
+    }
+
+    _fs = lockfs;
+    lockfs = NULL;
+
+done:
+
+    if (lockfs)
+        (*lockfs->fs_release)(lockfs);
+
+    if (shmfs)
+        free(shmfs);
+
+    return ret;
+}
+
+int shmfs_teardown(void)
+{
+    bool locked = false;
+
+    _lock(&locked);
+
+    /* the pages themselves go away with the mman */
+    while (_mappings)
+    {
+        mapping_t* mapping = _mappings;
+        _mappings = mapping->next;
+        free(mapping);
+    }
+
+    while (_objects)
+    {
+        object_t* object = _objects;
+        _objects = object->next;
+        free(object->name);
+        free(object);
+    }
+
+    _unlock(&locked);
+
+    if (_fs && (*_fs->fs_release)(_fs) != 0)
+    {
+        myst_eprintf("failed to release shmfs\n");
+        return -1;
+    }
+
+    _fs = NULL;
+
+    return 0;
+}
@@ -10,13 +10,22 @@
 #include <myst/fsgs.h>
 #include <myst/printf.h>
 #include <myst/process.h>
+#include <myst/rseq.h>
 #include <myst/signal.h>
+#include <myst/signalfddev.h>
 #include <myst/time.h>
 
 //#define TRACE
 
 #define MYST_SIG_UNBLOCKED(mask) \
-    (~mask) | ((uint64_t)1 << (SIGKILL - 1)) | ((uint64_t)1 << (SIGSTOP - 1));
+    ((~(mask)) | ((uint64_t)1 << (SIGKILL - 1)) | \
+     ((uint64_t)1 << (SIGSTOP - 1)))
+
+/* signals below this number are standard signals, which are not queued */
+#define MYST_SIGRTMIN 32
+
+/* number of preallocated siginfo_list_item structures */
+#define MYST_SIGINFO_POOL_SIZE 256
 
 static int _check_signum(unsigned signum)
 {
@@ -165,24 +174,80 @@ done:
     return ret;
 }
 
+/*
+**==============================================================================
+**
+** Pending signals are kept in per-thread lists of siginfo_list_item. Rather
+** than allocating an item (and a siginfo) for every signal sent, items are
+** taken from a preallocated pool shared by all threads, falling back on the
+** heap once the pool is exhausted. Items are allocated without holding the
+** thread's signal lock.
+**
+**==============================================================================
+*/
+
+static struct siginfo_list_item _pool[MYST_SIGINFO_POOL_SIZE];
+static size_t _pool_used; /* number of items ever taken from _pool */
+static struct siginfo_list_item* _pool_free;
+static myst_spinlock_t _pool_lock = MYST_SPINLOCK_INITIALIZER;
+
+static struct siginfo_list_item* _new_item(void)
+{
+    struct siginfo_list_item* item = NULL;
+
+    myst_spin_lock(&_pool_lock);
+    {
+        if (_pool_free)
+        {
+            item = _pool_free;
+            _pool_free = item->next;
+        }
+        else if (_pool_used < MYST_SIGINFO_POOL_SIZE)
+        {
+            item = &_pool[_pool_used++];
+        }
+    }
+    myst_spin_unlock(&_pool_lock);
+
+    if (item)
+    {
+        memset(item, 0, sizeof(struct siginfo_list_item));
+        item->pooled = true;
+    }
+    else if (!(item = calloc(1, sizeof(struct siginfo_list_item))))
+    {
+        return NULL;
+    }
+
+    return item;
+}
+
+static void _free_item(struct siginfo_list_item* item)
+{
+    if (item->pooled)
+    {
+        myst_spin_lock(&_pool_lock);
+        item->next = _pool_free;
+        _pool_free = item;
+        myst_spin_unlock(&_pool_lock);
+    }
+    else
+    {
+        free(item);
+    }
+}
+
 void myst_signal_free_siginfos(myst_thread_t* thread)
 {
     for (int i = 0; i < NSIG - 1; i++)
     {
-        if (thread->signal.siginfos[i])
+        for (struct siginfo_list_item* p = thread->signal.siginfos[i]; p;)
         {
-            for (struct siginfo_list_item* p = thread->signal.siginfos[i]; p;)
-            {
-                struct siginfo_list_item* next = p->next;
-                if (p->siginfo)
-                {
-                    free(p->siginfo);
-                    p->siginfo = NULL;
-                }
-                free(p);
-                p = next;
-            }
+            struct siginfo_list_item* next = p->next;
+            _free_item(p);
+            p = next;
         }
+
         thread->signal.siginfos[i] = NULL;
     }
 }
@@ -410,6 +475,27 @@ static long _handle_one_signal(
     }
 
     posix_sigaction_t* action = &process->signal.sigactions[signum - 1];
+    posix_sigaction_t default_action = {.handler = (uint64_t)SIG_DFL};
+
+    /* a handler must not run inside an interrupted rseq critical section: it
+     * resumes at the abort handler instead. If the section cannot be aborted,
+     * the handler does not run and SIGSEGV kills the process (as on Linux) */
+    if (mcontext && thread->rseq.area &&
+        action->handler != (uint64_t)SIG_DFL &&
+        action->handler != (uint64_t)SIG_IGN)
+    {
+        if (myst_rseq_abort(thread, mcontext) == 0)
+        {
+            context.uc_mcontext.gregs[REG_RIP] = mcontext->gregs[REG_RIP];
+        }
+        else
+        {
+            signum = SIGSEGV;
+            mask = (uint64_t)1 << (signum - 1);
+            action = &default_action;
+        }
+    }
+
     if (action->handler == (uint64_t)SIG_DFL)
     {
         // Some signals are ignored completely, so only call handler if it is
@@ -554,6 +640,15 @@ int myst_signal_has_active_signals(myst_thread_t* thread)
 
 long myst_signal_process(myst_thread_t* thread)
 {
+    /* This is called on every syscall entry and exit: return without taking
+     * any locks unless a signal is pending and unblocked, or the process
+     * has been stopped */
+    if (!myst_signal_has_active_signals(thread) &&
+        !__atomic_load_n(&thread->process->sigstop_futex, __ATOMIC_ACQUIRE))
+    {
+        return 0;
+    }
+
     /* If we are waiting due to sigstop then block now */
     _myst_sigstop_wait();
 
@@ -570,21 +665,19 @@ long myst_signal_process(myst_thread_t* thread)
 
         while (thread->signal.siginfos[bitnum])
         {
-            // Create a local copy and free the global one.
-            siginfo_t local_siginfo = {0};
+            // Create a local copy and release the item.
+            siginfo_t local_siginfo;
             siginfo_t* siginfo = NULL;
-            struct siginfo_list_item* next =
-                thread->signal.siginfos[bitnum]->next;
+            struct siginfo_list_item* item = thread->signal.siginfos[bitnum];
 
-            if (thread->signal.siginfos[bitnum]->siginfo)
+            if (item->has_siginfo)
             {
-                local_siginfo = *(thread->signal.siginfos[bitnum]->siginfo);
+                local_siginfo = item->siginfo;
                 siginfo = &local_siginfo;
-
-                free(thread->signal.siginfos[bitnum]->siginfo);
             }
-            free(thread->signal.siginfos[bitnum]);
-            thread->signal.siginfos[bitnum] = next;
+
+            thread->signal.siginfos[bitnum] = item->next;
+            _free_item(item);
 
             myst_spin_unlock(&thread->signal.lock);
 
@@ -605,10 +698,10 @@ long myst_signal_process(myst_thread_t* thread)
 }
 #pragma GCC diagnostic pop
 
-long myst_signal_deliver(
+long myst_signal_queue(
     myst_thread_t* thread,
     unsigned signum,
-    siginfo_t* siginfo)
+    const siginfo_t* siginfo)
 {
     long ret = 0;
     struct siginfo_list_item* new_item = NULL;
@@ -644,33 +737,38 @@ long myst_signal_deliver(
 
     uint64_t mask = (uint64_t)1 << (signum - 1);
 
+    /* allocate before taking the lock (this may fall back on the heap) */
+    if (!(new_item = _new_item()))
     {
-        new_item = calloc(1, sizeof(struct siginfo_list_item));
-        if (new_item == NULL)
-        {
-            ret = -ENOMEM;
-            goto done;
-        }
-        new_item->siginfo = siginfo;
+        /* like Linux, fail real-time signals that cannot be queued */
+        ret = (signum >= MYST_SIGRTMIN) ? -EAGAIN : -ENOMEM;
+        goto done;
+    }
 
+    if (siginfo)
+    {
+        new_item->siginfo = *siginfo;
+        new_item->has_siginfo = true;
+    }
+
+    {
         // Multiple threads could be trying to deliver a signal
         // to this thread simultaneously. Protect with a lock.
         myst_spin_lock(&thread->signal.lock);
 
-        if (thread->signal.siginfos[signum - 1] == NULL)
-        {
-            thread->signal.siginfos[signum - 1] = new_item;
-        }
-        else
+        struct siginfo_list_item** ptr = &thread->signal.siginfos[signum - 1];
+
+        /* a standard signal that is already pending is not queued again */
+        if (*ptr == NULL || signum >= MYST_SIGRTMIN)
         {
-            struct siginfo_list_item* ptr = thread->signal.siginfos[signum - 1];
-            while (ptr->next != NULL)
-                ptr = ptr->next;
-            ptr->next = new_item;
+            while (*ptr)
+                ptr = &(*ptr)->next;
+
+            *ptr = new_item;
+            new_item = NULL;
         }
+
         thread->signal.pending |= mask;
-        siginfo = NULL;
-        new_item = NULL;
 
         myst_spin_unlock(&thread->signal.lock);
 
@@ -681,6 +779,9 @@ long myst_signal_deliver(
         }
     }
 
+    /* wake any signalfd waiting for this signal */
+    myst_signalfd_notify(signum);
+
 #if (MYST_INTERRUPT_WITH_SIGNAL == 1)
     /* Wake up the thread if blocked in the target */
     myst_interrupt_thread(thread);
@@ -700,15 +801,72 @@ long myst_signal_deliver(
     }
 
 done:
-    if (siginfo)
-        free(siginfo); // Free the siginfo object if not delivered.
-
     if (new_item)
-        free(new_item); // free if allocated and not inserted
+        _free_item(new_item); // free if allocated and not inserted
+
+    return ret;
+}
+
+long myst_signal_deliver(
+    myst_thread_t* thread,
+    unsigned signum,
+    siginfo_t* siginfo)
+{
+    long ret = myst_signal_queue(thread, signum, siginfo);
+
+    /* the siginfo was copied into the queue (or the signal was not sent) */
+    if (siginfo)
+        free(siginfo);
 
     return ret;
 }
 
+int myst_signal_dequeue(
+    myst_thread_t* thread,
+    uint64_t mask,
+    siginfo_t* siginfo)
+{
+    int signum = 0;
+
+    /* SIGKILL and SIGSTOP are never dequeued by the caller */
+    mask &= ~MYST_SIG_UNBLOCKED(~(uint64_t)0);
+
+    /* avoid taking the lock if there is nothing to dequeue */
+    if (!(thread->signal.pending & mask))
+        return 0;
+
+    myst_spin_lock(&thread->signal.lock);
+    {
+        uint64_t active_signals = thread->signal.pending & mask;
+
+        if (active_signals)
+        {
+            unsigned bitnum = __builtin_ctzl(active_signals);
+            struct siginfo_list_item* item = thread->signal.siginfos[bitnum];
+
+            signum = (int)bitnum + 1;
+            memset(siginfo, 0, sizeof(siginfo_t));
+
+            if (item)
+            {
+                if (item->has_siginfo)
+                    *siginfo = item->siginfo;
+
+                thread->signal.siginfos[bitnum] = item->next;
+                _free_item(item);
+            }
+
+            siginfo->si_signo = signum;
+
+            if (!thread->signal.siginfos[bitnum])
+                thread->signal.pending &= ~((uint64_t)1 << bitnum);
+        }
+    }
+    myst_spin_unlock(&thread->signal.lock);
+
+    return signum;
+}
+
 long myst_signal_sigpending(sigset_t* set, unsigned size)
 {
     if (size > sizeof(sigset_t) || !set)
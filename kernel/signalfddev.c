@@ -0,0 +1,617 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/signalfd.h>
+
+#include <myst/eraise.h>
+#include <myst/signal.h>
+#include <myst/signalfddev.h>
+#include <myst/spinlock.h>
+#include <myst/syscall.h>
+#include <myst/tcall.h>
+#include <myst/thread.h>
+
+#define MAGIC 0x5f9dfdd0
+
+/* SIGKILL and SIGSTOP cannot be read from a signalfd */
+#define UNREADABLE_SIGNALS \
+    (((uint64_t)1 << (SIGKILL - 1)) | ((uint64_t)1 << (SIGSTOP - 1)))
+
+/*
+**==============================================================================
+**
+** A signalfd is backed by a host eventfd that is signaled whenever a signal
+** in the signalfd mask is queued (see myst_signalfd_notify()). This lets
+** poll() and epoll() wait on signalfds along with the other host file
+** descriptors. read() dequeues the pending signals of the calling thread and
+** then those of its process, then clears the eventfd unless more signals in
+** the mask are still pending.
+**
+** The eventfd is signaled for signals queued to any process, so a signalfd
+** may occasionally appear readable when it is not; read() then fails with
+** EAGAIN (non-blocking) or waits for the next signal.
+**
+**==============================================================================
+*/
+
+/* the signalfd state shared by the duplicates of a signalfd */
+typedef struct shared
+{
+    struct shared* prev;
+    struct shared* next;
+    _Atomic(size_t) nrefs;
+    _Atomic(uint64_t) mask;
+    int fd; /* the host eventfd signaled by myst_signalfd_notify() */
+    _Atomic(bool) nonblock;
+} shared_t;
+
+struct myst_signalfd
+{
+    uint32_t magic;
+    int fd; /* the duplicate of the host eventfd for this file descriptor */
+    shared_t* shared;
+};
+
+/* the list of all signalfds, walked by myst_signalfd_notify() */
+static shared_t* _head;
+static _Atomic(size_t) _count;
+static myst_spinlock_t _lock = MYST_SPINLOCK_INITIALIZER;
+
+MYST_INLINE long _sys_eventfd2(unsigned int initval, int flags)
+{
+    long params[6] = {(long)initval, (long)flags};
+    return myst_tcall(SYS_eventfd2, params);
+}
+
+MYST_INLINE bool _valid_signalfd(const myst_signalfd_t* signalfd)
+{
+    return signalfd && signalfd->magic == MAGIC;
+}
+
+static void _signal_eventfd(int fd)
+{
+    uint64_t one = 1;
+
+    /* errors (counter overflow) are ignored */
+    myst_tcall_write(fd, &one, sizeof(one));
+}
+
+static void _register(shared_t* shared)
+{
+    myst_spin_lock(&_lock);
+    {
+        shared->prev = NULL;
+        shared->next = _head;
+
+        if (_head)
+            _head->prev = shared;
+
+        _head = shared;
+        _count++;
+    }
+    myst_spin_unlock(&_lock);
+}
+
+static void _unregister(shared_t* shared)
+{
+    myst_spin_lock(&_lock);
+    {
+        if (shared->prev)
+            shared->prev->next = shared->next;
+        else
+            _head = shared->next;
+
+        if (shared->next)
+            shared->next->prev = shared->prev;
+
+        _count--;
+    }
+    myst_spin_unlock(&_lock);
+}
+
+void myst_signalfd_notify(unsigned signum)
+{
+    const uint64_t bit = (uint64_t)1 << (signum - 1);
+
+    /* the common case: nobody is using signalfd */
+    if (_count == 0)
+        return;
+
+    myst_spin_lock(&_lock);
+    {
+        for (shared_t* p = _head; p; p = p->next)
+        {
+            if (p->mask & bit)
+                _signal_eventfd(p->fd);
+        }
+    }
+    myst_spin_unlock(&_lock);
+}
+
+static bool _has_pending(uint64_t mask)
+{
+    myst_thread_t* thread = myst_thread_self();
+    myst_thread_t* main = thread->process->main_process_thread;
+
+    return (thread->signal.pending & mask) || (main->signal.pending & mask);
+}
+
+/* clear the host eventfd unless signals in the mask are still pending */
+static void _rearm(shared_t* shared)
+{
+    uint64_t count;
+
+    /* clear first so that signals queued meanwhile are not missed */
+    myst_tcall_read(shared->fd, &count, sizeof(count));
+
+    if (_has_pending(shared->mask))
+        _signal_eventfd(shared->fd);
+}
+
+static void _to_signalfd_siginfo(
+    const siginfo_t* si,
+    struct signalfd_siginfo* ssi)
+{
+    memset(ssi, 0, sizeof(struct signalfd_siginfo));
+
+    ssi->ssi_signo = (uint32_t)si->si_signo;
+    ssi->ssi_errno = si->si_errno;
+    ssi->ssi_code = si->si_code;
+
+    /* the fields of siginfo_t overlap, so only copy the meaningful ones */
+    if (si->si_code == SI_TIMER)
+    {
+        ssi->ssi_tid = (uint32_t)si->si_timerid;
+        ssi->ssi_overrun = (uint32_t)si->si_overrun;
+        ssi->ssi_int = si->si_value.sival_int;
+        ssi->ssi_ptr = (uint64_t)si->si_value.sival_ptr;
+    }
+    else if (si->si_code > 0 && si->si_signo == SIGCHLD)
+    {
+        ssi->ssi_pid = (uint32_t)si->si_pid;
+        ssi->ssi_uid = si->si_uid;
+        ssi->ssi_status = si->si_status;
+        ssi->ssi_utime = (uint64_t)si->si_utime;
+        ssi->ssi_stime = (uint64_t)si->si_stime;
+    }
+    else if (si->si_code > 0 && si->si_signo == SIGPOLL)
+    {
+        ssi->ssi_band = (uint32_t)si->si_band;
+        ssi->ssi_fd = si->si_fd;
+    }
+    else if (
+        si->si_code > 0 &&
+        (si->si_signo == SIGSEGV || si->si_signo == SIGBUS ||
+         si->si_signo == SIGILL || si->si_signo == SIGFPE ||
+         si->si_signo == SIGTRAP))
+    {
+        ssi->ssi_addr = (uint64_t)si->si_addr;
+    }
+    else
+    {
+        ssi->ssi_pid = (uint32_t)si->si_pid;
+        ssi->ssi_uid = si->si_uid;
+
+        if (si->si_code == SI_QUEUE || si->si_code == SI_MESGQ)
+        {
+            ssi->ssi_int = si->si_value.sival_int;
+            ssi->ssi_ptr = (uint64_t)si->si_value.sival_ptr;
+        }
+    }
+}
+
+/* dequeue up to n signals in the mask; returns the number dequeued */
+static size_t _dequeue(uint64_t mask, struct signalfd_siginfo* buf, size_t n)
+{
+    myst_thread_t* thread = myst_thread_self();
+    myst_thread_t* main = thread->process->main_process_thread;
+    size_t i;
+
+    for (i = 0; i < n; i++)
+    {
+        siginfo_t siginfo;
+
+        /* thread-directed signals first, then process-directed signals */
+        if (!myst_signal_dequeue(thread, mask, &siginfo) &&
+            (main == thread || !myst_signal_dequeue(main, mask, &siginfo)))
+        {
+            break;
+        }
+
+        _to_signalfd_siginfo(&siginfo, &buf[i]);
+    }
+
+    return i;
+}
+
+static int _signalfd_signalfd(
+    myst_signalfddev_t* signalfddev,
+    uint64_t mask,
+    int flags,
+    myst_signalfd_t** signalfd_out)
+{
+    int ret = 0;
+    myst_signalfd_t* signalfd = NULL;
+    shared_t* shared = NULL;
+    int efd_flags = EFD_NONBLOCK;
+
+    if (!signalfddev || !signalfd_out)
+        ERAISE(-EINVAL);
+
+    if (flags & ~(SFD_NONBLOCK | SFD_CLOEXEC))
+        ERAISE(-EINVAL);
+
+    if (flags & SFD_CLOEXEC)
+        efd_flags |= EFD_CLOEXEC;
+
+    if (!(signalfd = calloc(1, sizeof(myst_signalfd_t))))
+        ERAISE(-ENOMEM);
+
+    signalfd->magic = MAGIC;
+    signalfd->fd = -1;
+
+    if (!(shared = calloc(1, sizeof(shared_t))))
+        ERAISE(-ENOMEM);
+
+    shared->nrefs = 1;
+    shared->mask = mask & ~UNREADABLE_SIGNALS;
+    shared->nonblock = (flags & SFD_NONBLOCK);
+
+    /* create the host eventfd and its duplicate for this file descriptor */
+    ECHECK(shared->fd = _sys_eventfd2(0, efd_flags));
+    ECHECK(signalfd->fd = myst_tcall_dup(shared->fd));
+
+    _register(shared);
+
+    /* signals in the mask may already be pending */
+    _rearm(shared);
+
+    signalfd->shared = shared;
+    shared = NULL;
+    *signalfd_out = signalfd;
+    signalfd = NULL;
+
+done:
+
+    if (shared)
+    {
+        if (shared->fd >= 0)
+            myst_tcall_close(shared->fd);
+
+        free(shared);
+    }
+
+    if (signalfd)
+        free(signalfd);
+
+    return ret;
+}
+
+static int _signalfd_setmask(
+    myst_signalfddev_t* signalfddev,
+    myst_signalfd_t* signalfd,
+    uint64_t mask)
+{
+    int ret = 0;
+
+    if (!signalfddev || !_valid_signalfd(signalfd))
+        ERAISE(-EINVAL);
+
+    signalfd->shared->mask = mask & ~UNREADABLE_SIGNALS;
+    _rearm(signalfd->shared);
+
+done:
+    return ret;
+}
+
+static ssize_t _signalfd_read(
+    myst_signalfddev_t* signalfddev,
+    myst_signalfd_t* signalfd,
+    void* buf,
+    size_t count)
+{
+    ssize_t ret = 0;
+    const size_t size = sizeof(struct signalfd_siginfo);
+    shared_t* shared;
+
+    if (!signalfddev || !_valid_signalfd(signalfd))
+        ERAISE(-EBADF);
+
+    if (!buf || count < size)
+        ERAISE(-EINVAL);
+
+    shared = signalfd->shared;
+
+    for (;;)
+    {
+        struct pollfd fds = {.fd = signalfd->fd, .events = POLLIN};
+        size_t n = _dequeue(shared->mask, buf, count / size);
+
+        _rearm(shared);
+
+        if (n > 0)
+        {
+            ret = (ssize_t)(n * size);
+            break;
+        }
+
+        if (shared->nonblock)
+            ERAISE(-EAGAIN);
+
+        /* wait for the next signal, checking for other signals regularly */
+        ECHECK(myst_tcall_poll(&fds, 1, 500));
+
+        if (myst_signal_has_active_signals(myst_thread_self()))
+            ERAISE(-EINTR);
+    }
+
+done:
+    return ret;
+}
+
+static ssize_t _signalfd_write(
+    myst_signalfddev_t* signalfddev,
+    myst_signalfd_t* signalfd,
+    const void* buf,
+    size_t count)
+{
+    ssize_t ret = 0;
+
+    (void)buf;
+    (void)count;
+
+    if (!signalfddev || !_valid_signalfd(signalfd))
+        ERAISE(-EBADF);
+
+    /* signalfds are not writable */
+    ERAISE(-EINVAL);
+
+done:
+    return ret;
+}
+
+static ssize_t _signalfd_readv(
+    myst_signalfddev_t* signalfddev,
+    myst_signalfd_t* signalfd,
+    const struct iovec* iov,
+    int iovcnt)
+{
+    ssize_t ret = 0;
+
+    if (!signalfddev || !_valid_signalfd(signalfd))
+        ERAISE(-EINVAL);
+
+    ret = myst_fdops_readv(&signalfddev->fdops, signalfd, iov, iovcnt);
+    ECHECK(ret);
+
+done:
+
+    return ret;
+}
+
+static ssize_t _signalfd_writev(
+    myst_signalfddev_t* signalfddev,
+    myst_signalfd_t* signalfd,
+    const struct iovec* iov,
+    int iovcnt)
+{
+    ssize_t ret = 0;
+
+    if (!signalfddev || !_valid_signalfd(signalfd))
+        ERAISE(-EINVAL);
+
+    ret = myst_fdops_writev(&signalfddev->fdops, signalfd, iov, iovcnt);
+    ECHECK(ret);
+
+done:
+
+    return ret;
+}
+
+static int _signalfd_fstat(
+    myst_signalfddev_t* signalfddev,
+    myst_signalfd_t* signalfd,
+    struct stat* statbuf)
+{
+    int ret = 0;
+
+    if (!signalfddev || !_valid_signalfd(signalfd) || !statbuf)
+        ERAISE(-EINVAL);
+
+    ECHECK(myst_tcall_fstat(signalfd->fd, statbuf));
+
+done:
+    return ret;
+}
+
+static int _signalfd_fcntl(
+    myst_signalfddev_t* signalfddev,
+    myst_signalfd_t* signalfd,
+    int cmd,
+    long arg)
+{
+    int ret = 0;
+    long r;
+
+    if (!signalfddev || !_valid_signalfd(signalfd))
+        ERAISE(-EINVAL);
+
+    /* O_NONBLOCK is emulated since the host eventfd is always non-blocking */
+    if (cmd == F_SETFL)
+    {
+        ECHECK((r = myst_tcall_fcntl(signalfd->fd, cmd, arg | O_NONBLOCK)));
+        signalfd->shared->nonblock = (arg & O_NONBLOCK);
+        ret = r;
+        goto done;
+    }
+
+    ECHECK((r = myst_tcall_fcntl(signalfd->fd, cmd, arg)));
+
+    if (cmd == F_GETFL && !signalfd->shared->nonblock)
+        r &= ~O_NONBLOCK;
+
+    ret = r;
+
+done:
+
+    return ret;
+}
+
+static int _signalfd_ioctl(
+    myst_signalfddev_t* signalfddev,
+    myst_signalfd_t* signalfd,
+    unsigned long request,
+    long arg)
+{
+    int ret = 0;
+
+    (void)arg;
+
+    if (!signalfddev || !_valid_signalfd(signalfd))
+        ERAISE(-EBADF);
+
+    if (request == TIOCGWINSZ)
+        ERAISE(-EINVAL);
+
+    ERAISE(-ENOTSUP);
+
+done:
+
+    return ret;
+}
+
+static int _signalfd_dup(
+    myst_signalfddev_t* signalfddev,
+    const myst_signalfd_t* signalfd,
+    myst_signalfd_t** signalfd_out)
+{
+    int ret = 0;
+    myst_signalfd_t* new_signalfd = NULL;
+
+    if (signalfd_out)
+        *signalfd_out = NULL;
+
+    if (!signalfddev || !_valid_signalfd(signalfd) || !signalfd_out)
+        ERAISE(-EINVAL);
+
+    if (!(new_signalfd = calloc(1, sizeof(myst_signalfd_t))))
+        ERAISE(-ENOMEM);
+
+    ECHECK(new_signalfd->fd = myst_tcall_dup(signalfd->fd));
+    new_signalfd->magic = MAGIC;
+    new_signalfd->shared = signalfd->shared;
+    new_signalfd->shared->nrefs++;
+
+    *signalfd_out = new_signalfd;
+    new_signalfd = NULL;
+
+done:
+
+    if (new_signalfd)
+        free(new_signalfd);
+
+    return ret;
+}
+
+static int _signalfd_close(
+    myst_signalfddev_t* signalfddev,
+    myst_signalfd_t* signalfd)
+{
+    int ret = 0;
+    shared_t* shared;
+
+    if (!signalfddev || !_valid_signalfd(signalfd))
+        ERAISE(-EBADF);
+
+    shared = signalfd->shared;
+
+    /* release the shared state with the last file descriptor */
+    if (--shared->nrefs == 0)
+    {
+        _unregister(shared);
+        myst_tcall_close(shared->fd);
+        free(shared);
+    }
+
+    ECHECK(myst_tcall_close(signalfd->fd));
+
+    memset(signalfd, 0, sizeof(myst_signalfd_t));
+    free(signalfd);
+
+done:
+    return ret;
+}
+
+static int _signalfd_target_fd(
+    myst_signalfddev_t* signalfddev,
+    myst_signalfd_t* signalfd)
+{
+    int ret = 0;
+
+    if (!signalfddev || !_valid_signalfd(signalfd))
+        ERAISE(-EINVAL);
+
+    ret = signalfd->fd;
+
+done:
+    return ret;
+}
+
+static int _signalfd_get_events(
+    myst_signalfddev_t* signalfddev,
+    myst_signalfd_t* signalfd)
+{
+    int ret = 0;
+
+    if (!signalfddev || !_valid_signalfd(signalfd))
+        ERAISE(-EINVAL);
+
+    /* poll the host eventfd instead */
+    ret = -ENOTSUP;
+
+done:
+    return ret;
+}
+
+extern myst_signalfddev_t* myst_signalfddev_get(void)
+{
+    // clang-format off
+    static myst_signalfddev_t _signalfddev =
+    {
+        {
+            .fd_read = (void*)_signalfd_read,
+            .fd_write = (void*)_signalfd_write,
+            .fd_readv = (void*)_signalfd_readv,
+            .fd_writev = (void*)_signalfd_writev,
+            .fd_fstat = (void*)_signalfd_fstat,
+            .fd_fcntl = (void*)_signalfd_fcntl,
+            .fd_ioctl = (void*)_signalfd_ioctl,
+            .fd_dup = (void*)_signalfd_dup,
+            .fd_close = (void*)_signalfd_close,
+            .fd_target_fd = (void*)_signalfd_target_fd,
+            .fd_get_events = (void*)_signalfd_get_events,
+        },
+        .signalfd = _signalfd_signalfd,
+        .setmask = _signalfd_setmask,
+        .read = _signalfd_read,
+        .write = _signalfd_write,
+        .readv = _signalfd_readv,
+        .writev = _signalfd_writev,
+        .fstat = _signalfd_fstat,
+        .fcntl = _signalfd_fcntl,
+        .ioctl = _signalfd_ioctl,
+        .dup = _signalfd_dup,
+        .close = _signalfd_close,
+        .target_fd = _signalfd_target_fd,
+        .get_events = _signalfd_get_events,
+    };
+    // clang-format on
+
+    return &_signalfddev;
+}
@@ -1,6 +1,7 @@
 // Copyright (c) Microsoft Corporation.
 // Licensed under the MIT License.
 
+#define _GNU_SOURCE
 #include <errno.h>
 #include <limits.h>
 #include <stdlib.h>
@@ -16,6 +17,7 @@
 #include <myst/syscall.h>
 #include <myst/syslog.h>
 #include <myst/tcall.h>
+#include <myst/times.h>
 
 #define MAGIC 0xc436d7e6
 
@@ -404,6 +406,124 @@ done:
     return ret;
 }
 
+static int _sd_sendmmsg(
+    myst_sockdev_t* sd,
+    myst_sock_t* sock,
+    struct mmsghdr* msgvec,
+    unsigned int vlen,
+    int flags)
+{
+    int ret = 0;
+    unsigned int cnt = 0;
+    long n;
+
+    if (!sd || !_valid_sock(sock))
+        ERAISE(-EINVAL);
+
+    if (vlen == 0)
+        goto done;
+
+    if (sock->nonblock || (flags & MSG_DONTWAIT))
+    {
+        ECHECK(n = myst_tcall_sendmmsg(sock->fd, msgvec, vlen, flags));
+        ret = (int)n;
+        goto done;
+    }
+
+    /* the target may send fewer messages than requested (it sends at least
+     * one), so repeat the call until all messages have been sent */
+    while (cnt < vlen)
+    {
+        n = myst_tcall_sendmmsg_block(
+            sock->fd, msgvec + cnt, vlen - cnt, flags);
+
+        if (n < 0)
+        {
+            /* only fail if no messages were sent */
+            if (cnt > 0)
+                break;
+
+            ERAISE((int)n);
+        }
+
+        cnt += (unsigned int)n;
+    }
+
+    ret = (int)cnt;
+
+done:
+    return ret;
+}
+
+static int _sd_recvmmsg(
+    myst_sockdev_t* sd,
+    myst_sock_t* sock,
+    struct mmsghdr* msgvec,
+    unsigned int vlen,
+    int flags,
+    struct timespec* timeout)
+{
+    int ret = 0;
+    unsigned int cnt = 0;
+    struct timespec start;
+    long n;
+
+    if (!sd || !_valid_sock(sock))
+        ERAISE(-EINVAL);
+
+    if (vlen == 0)
+        goto done;
+
+    /* the target only receives messages that are already queued */
+    if (sock->nonblock || (flags & MSG_DONTWAIT))
+    {
+        ECHECK(n = myst_tcall_recvmmsg(sock->fd, msgvec, vlen, flags));
+        ret = (int)n;
+        goto done;
+    }
+
+    if (timeout)
+        myst_syscall_clock_gettime(CLOCK_MONOTONIC, &start);
+
+    /* Each call blocks until at least one message arrives and then returns
+     * all queued messages. Like Linux, the timeout is only checked after
+     * messages are received. */
+    while (cnt < vlen)
+    {
+        n = myst_tcall_recvmmsg_block(
+            sock->fd, msgvec + cnt, vlen - cnt, flags & ~MSG_WAITFORONE);
+
+        if (n < 0)
+        {
+            /* only fail if no messages were received */
+            if (cnt > 0)
+                break;
+
+            ERAISE((int)n);
+        }
+
+        cnt += (unsigned int)n;
+
+        if (flags & MSG_WAITFORONE)
+            break;
+
+        if (timeout)
+        {
+            struct timespec now;
+
+            myst_syscall_clock_gettime(CLOCK_MONOTONIC, &now);
+
+            if (myst_lapsed_nsecs(&start, &now) >= timespec_to_nanos(timeout))
+                break;
+        }
+    }
+
+    ret = (int)cnt;
+
+done:
+    return ret;
+}
+
 static int _sd_shutdown(myst_sockdev_t* sd, myst_sock_t* sock, int how)
 {
     ssize_t ret = 0;
@@ -564,8 +684,10 @@ static ssize_t _sd_readv(
     if (!sd || !_valid_sock(sock))
         ERAISE(-EINVAL);
 
-    ret = myst_fdops_readv(&sd->fdops, sock, iov, iovcnt);
-    ECHECK(ret);
+    if (sock->nonblock)
+        ECHECK(ret = myst_tcall_readv(sock->fd, iov, iovcnt));
+    else
+        ECHECK(ret = myst_tcall_readv_block(sock->fd, iov, iovcnt));
 
 done:
     return ret;
@@ -582,8 +704,10 @@ static ssize_t _sd_writev(
     if (!sd || !_valid_sock(sock))
         ERAISE(-EINVAL);
 
-    ret = myst_fdops_writev(&sd->fdops, sock, iov, iovcnt);
-    ECHECK(ret);
+    if (sock->nonblock)
+        ECHECK(ret = myst_tcall_writev(sock->fd, iov, iovcnt));
+    else
+        ECHECK(ret = myst_tcall_writev_block(sock->fd, iov, iovcnt));
 
 done:
     return ret;
@@ -790,6 +914,8 @@ myst_sockdev_t* myst_sockdev_get(void)
         .sd_recvfrom = _sd_recvfrom,
         .sd_sendmsg = _sd_sendmsg,
         .sd_recvmsg = _sd_recvmsg,
+        .sd_sendmmsg = _sd_sendmmsg,
+        .sd_recvmmsg = _sd_recvmmsg,
         .sd_shutdown = _sd_shutdown,
         .sd_getsockopt = _sd_getsockopt,
         .sd_setsockopt = _sd_setsockopt,
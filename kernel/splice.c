@@ -0,0 +1,231 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/ioctl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <myst/eraise.h>
+#include <myst/fdtable.h>
+#include <myst/pipedev.h>
+#include <myst/syscall.h>
+
+/* largest amount of data moved by one splice() call */
+#define CHUNK_SIZE (64 * 1024)
+
+#define SPLICE_FLAGS \
+    (SPLICE_F_MOVE | SPLICE_F_NONBLOCK | SPLICE_F_MORE | SPLICE_F_GIFT)
+
+MYST_INLINE size_t _min(size_t x, size_t y)
+{
+    return (x < y) ? x : y;
+}
+
+/* get the pipe that fd refers to (or null if fd is not a pipe) */
+static int _get_pipe(int fd, myst_pipedev_t** pipedev, myst_pipe_t** pipe)
+{
+    int ret = 0;
+    myst_fdtable_type_t type;
+    void* device;
+    void* object;
+
+    ECHECK(myst_fdtable_get_any(
+        myst_fdtable_current(), fd, &type, &device, &object));
+
+    if (type == MYST_FDTABLE_TYPE_PIPE)
+    {
+        *pipedev = device;
+        *pipe = object;
+    }
+    else
+    {
+        *pipedev = NULL;
+        *pipe = NULL;
+    }
+
+done:
+    return ret;
+}
+
+static int _is_pipe(int fd, bool* is_pipe)
+{
+    int ret = 0;
+    myst_pipedev_t* pipedev;
+    myst_pipe_t* pipe;
+
+    ECHECK(_get_pipe(fd, &pipedev, &pipe));
+    *is_pipe = (pipe != NULL);
+
+done:
+    return ret;
+}
+
+/* Pipes keep their data in the kernel, so splice() cannot be delegated to
+ * the host (one end is always a pipe). Instead the data is moved through a
+ * single kernel buffer, with at most one read and one write per call.
+ */
+long myst_syscall_splice(
+    int fd_in,
+    off_t* off_in,
+    int fd_out,
+    off_t* off_out,
+    size_t len,
+    unsigned int flags)
+{
+    long ret = 0;
+    myst_pipedev_t* in_pipedev;
+    myst_pipedev_t* out_pipedev;
+    myst_pipe_t* in_pipe;
+    myst_pipe_t* out_pipe;
+    const bool nonblock = (flags & SPLICE_F_NONBLOCK);
+    size_t size = _min(len, CHUNK_SIZE);
+    char* buf = NULL;
+    ssize_t n;
+    ssize_t nwritten = 0;
+
+    if (flags & ~SPLICE_FLAGS)
+        ERAISE(-EINVAL);
+
+    ECHECK(_get_pipe(fd_in, &in_pipedev, &in_pipe));
+    ECHECK(_get_pipe(fd_out, &out_pipedev, &out_pipe));
+
+    /* one of the file descriptors must refer to a pipe */
+    if (!in_pipe && !out_pipe)
+        ERAISE(-EINVAL);
+
+    if ((in_pipe && off_in) || (out_pipe && off_out))
+        ERAISE(-ESPIPE);
+
+    if (len == 0)
+        goto done;
+
+    /* do not write more than the pipe can hold (the caller may be the only
+     * reader, so blocking on a full pipe would deadlock) */
+    if (out_pipe)
+    {
+        long pipesz = myst_syscall_fcntl(fd_out, F_GETPIPE_SZ, 0);
+
+        if (pipesz > 0)
+            size = _min(size, (size_t)pipesz);
+
+        /* SPLICE_F_NONBLOCK: consume no more input than fits right now */
+        if (nonblock && pipesz > 0)
+        {
+            int nbytes = 0;
+
+            ECHECK(out_pipedev->pd_ioctl(
+                out_pipedev, out_pipe, FIONREAD, (long)&nbytes));
+
+            if ((size_t)nbytes >= (size_t)pipesz)
+                ERAISE(-EAGAIN);
+
+            size = _min(size, (size_t)pipesz - (size_t)nbytes);
+        }
+    }
+
+    if (!(buf = malloc(size)))
+        ERAISE(-ENOMEM);
+
+    /* SPLICE_F_NONBLOCK only affects the pipe ends (as on Linux) */
+    if (in_pipe && nonblock)
+    {
+        myst_pipedev_t* pd = in_pipedev;
+        ECHECK(n = pd->pd_read_nonblock(pd, in_pipe, buf, size));
+    }
+    else if (off_in)
+        n = pread(fd_in, buf, size, *off_in);
+    else
+        n = read(fd_in, buf, size);
+
+    ECHECK_ERRNO(n);
+
+    while (nwritten < n)
+    {
+        const size_t rem = n - nwritten;
+        ssize_t m;
+
+        if (out_pipe && nonblock)
+        {
+            const char* p = buf + nwritten;
+
+            if ((m = out_pipedev->pd_write_nonblock(
+                     out_pipedev, out_pipe, p, rem)) < 0)
+            {
+                errno = (int)-m;
+                m = -1;
+            }
+        }
+        else if (off_out)
+            m = pwrite(fd_out, buf + nwritten, rem, *off_out + nwritten);
+        else
+            m = write(fd_out, buf + nwritten, rem);
+
+        if (m < 0)
+        {
+            /* report any bytes that were written */
+            if (nwritten > 0)
+                break;
+
+            ERAISE(-errno);
+        }
+
+        nwritten += m;
+    }
+
+    /* return unwritten input to a file (data read from a pipe is consumed) */
+    if (nwritten < n && !in_pipe && !off_in)
+        lseek(fd_in, -(n - nwritten), SEEK_CUR);
+
+    if (off_in)
+        *off_in += nwritten;
+
+    if (off_out)
+        *off_out += nwritten;
+
+    ret = nwritten;
+
+done:
+
+    if (buf)
+        free(buf);
+
+    return ret;
+}
+
+long myst_syscall_vmsplice(
+    int fd,
+    const struct iovec* iov,
+    size_t nr_segs,
+    unsigned int flags)
+{
+    long ret = 0;
+    bool is_pipe;
+    long fl_flags;
+
+    if (flags & ~SPLICE_FLAGS)
+        ERAISE(-EINVAL);
+
+    if (!iov && nr_segs)
+        ERAISE(-EFAULT);
+
+    if (nr_segs > IOV_MAX)
+        ERAISE(-EINVAL);
+
+    ECHECK(_is_pipe(fd, &is_pipe));
+
+    if (!is_pipe)
+        ERAISE(-EBADF);
+
+    ECHECK(fl_flags = myst_syscall_fcntl(fd, F_GETFL, 0));
+
+    /* the pages are copied, so SPLICE_F_GIFT has no effect */
+    if ((fl_flags & O_ACCMODE) == O_RDONLY)
+        ECHECK(ret = myst_syscall_readv(fd, iov, (int)nr_segs));
+    else
+        ECHECK(ret = myst_syscall_writev(fd, iov, (int)nr_segs));
+
+done:
+    return ret;
+}
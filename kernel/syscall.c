@@ -27,6 +27,7 @@
 #include <sys/vfs.h>
 #include <unistd.h>
 
+#include <myst/aio.h>
 #include <myst/backtrace.h>
 #include <myst/barrier.h>
 #include <myst/blkdev.h>
@@ -61,6 +62,7 @@
 #include <myst/mmanutils.h>
 #include <myst/mount.h>
 #include <myst/msg.h>
+#include <myst/numa.h>
 #include <myst/once.h>
 #include <myst/options.h>
 #include <myst/panic.h>
@@ -72,7 +74,9 @@
 #include <myst/ramfs.h>
 #include <myst/realpath.h>
 #include <myst/round.h>
+#include <myst/rseq.h>
 #include <myst/setjmp.h>
+#include <myst/shmfs.h>
 #include <myst/signal.h>
 #include <myst/sockdev.h>
 #include <myst/spinlock.h>
@@ -84,6 +88,7 @@
 #include <myst/tee.h>
 #include <myst/thread.h>
 #include <myst/time.h>
+#include <myst/timer.h>
 #include <myst/times.h>
 #include <myst/trace.h>
 
@@ -242,46 +247,52 @@ static bool _trace_syscall_return(long n, long ret)
     return false;
 }
 
-__attribute__((format(printf, 2, 3))) static void _strace(
+__attribute__((format(printf, 2, 3))) static void _strace_impl(
     long n,
     const char* fmt,
     ...)
 {
-    if (_trace_syscall(n))
-    {
-        char null_char = '\0';
-        char* buf = &null_char;
-        const bool isatty = myst_syscall_isatty(STDERR_FILENO) == 1;
-        const char* blue = isatty ? COLOR_GREEN : "";
-        const char* reset = isatty ? COLOR_RESET : "";
+    char null_char = '\0';
+    char* buf = &null_char;
+    const bool isatty = myst_syscall_isatty(STDERR_FILENO) == 1;
+    const char* blue = isatty ? COLOR_GREEN : "";
+    const char* reset = isatty ? COLOR_RESET : "";
 
-        if (fmt)
-        {
-            const size_t buf_size = 1024;
+    if (fmt)
+    {
+        const size_t buf_size = 1024;
 
-            if (!(buf = malloc(buf_size)))
-                myst_panic("out of memory");
+        if (!(buf = malloc(buf_size)))
+            myst_panic("out of memory");
 
-            va_list ap;
-            va_start(ap, fmt);
-            vsnprintf(buf, buf_size, fmt, ap);
-            va_end(ap);
-        }
+        va_list ap;
+        va_start(ap, fmt);
+        vsnprintf(buf, buf_size, fmt, ap);
+        va_end(ap);
+    }
 
-        myst_eprintf(
-            "=== %s%s%s(%s): pid=%d tid=%d\n",
-            blue,
-            _syscall_str(n),
-            reset,
-            buf,
-            myst_getpid(),
-            myst_gettid());
+    myst_eprintf(
+        "=== %s%s%s(%s): pid=%d tid=%d\n",
+        blue,
+        _syscall_str(n),
+        reset,
+        buf,
+        myst_getpid(),
+        myst_gettid());
 
-        if (buf != &null_char)
-            free(buf);
-    }
+    if (buf != &null_char)
+        free(buf);
 }
 
+/* trace the system call; the arguments are only evaluated (and formatted)
+ * when the system call is traced */
+#define _strace(N, ...)                     \
+    do                                      \
+    {                                       \
+        if (_trace_syscall(N))              \
+            _strace_impl((N), __VA_ARGS__); \
+    } while (0)
+
 long myst_syscall_unmap_on_exit(myst_thread_t* thread, void* ptr, size_t size)
 {
     long ret = 0;
@@ -2126,6 +2137,128 @@ done:
     return ret;
 }
 
+long myst_syscall_timerfd_create(clockid_t clockid, int flags)
+{
+    long ret = 0;
+    const myst_fdtable_type_t type = MYST_FDTABLE_TYPE_TIMERFD;
+    myst_timerfddev_t* dev = myst_timerfddev_get();
+    myst_timerfd_t* obj = NULL;
+    myst_fdtable_t* fdtable = myst_fdtable_current();
+    int fd;
+
+    if (!dev)
+        ERAISE(-EINVAL);
+
+    ECHECK((*dev->timerfd)(dev, clockid, flags, &obj));
+
+    if ((fd = myst_fdtable_assign(fdtable, type, dev, obj)) < 0)
+    {
+        myst_fdtable_remove(fdtable, fd);
+        (*dev->close)(dev, obj);
+        ERAISE(fd);
+    }
+
+    ret = fd;
+
+done:
+    return ret;
+}
+
+long myst_syscall_timerfd_settime(
+    int fd,
+    int flags,
+    const struct itimerspec* new_value,
+    struct itimerspec* old_value)
+{
+    long ret = 0;
+    myst_fdtable_t* fdtable = myst_fdtable_current();
+    myst_timerfddev_t* dev;
+    myst_timerfd_t* obj;
+
+    ECHECK(myst_fdtable_get_timerfd(fdtable, fd, &dev, &obj));
+
+    if (new_value &&
+        (new_value->it_value.tv_sec || new_value->it_value.tv_nsec))
+    {
+        ECHECK(myst_timer_request_ticker());
+    }
+
+    ECHECK((*dev->settime)(dev, obj, flags, new_value, old_value));
+
+done:
+    return ret;
+}
+
+long myst_syscall_timerfd_gettime(int fd, struct itimerspec* curr_value)
+{
+    long ret = 0;
+    myst_fdtable_t* fdtable = myst_fdtable_current();
+    myst_timerfddev_t* dev;
+    myst_timerfd_t* obj;
+
+    ECHECK(myst_fdtable_get_timerfd(fdtable, fd, &dev, &obj));
+    ECHECK((*dev->gettime)(dev, obj, curr_value));
+
+done:
+    return ret;
+}
+
+long myst_syscall_signalfd(
+    int fd,
+    const sigset_t* mask,
+    size_t sizemask,
+    int flags)
+{
+    long ret = 0;
+    const myst_fdtable_type_t type = MYST_FDTABLE_TYPE_SIGNALFD;
+    myst_signalfddev_t* dev = myst_signalfddev_get();
+    myst_signalfd_t* obj = NULL;
+    myst_fdtable_t* fdtable = myst_fdtable_current();
+    uint64_t bits;
+
+    if (!dev)
+        ERAISE(-EINVAL);
+
+    /* the mask is the kernel's 64-bit signal set */
+    if (sizemask != sizeof(uint64_t))
+        ERAISE(-EINVAL);
+
+    if (!mask)
+        ERAISE(-EFAULT);
+
+    memcpy(&bits, mask, sizeof(bits));
+
+    /* change the mask of an existing signalfd */
+    if (fd != -1)
+    {
+        myst_fdtable_type_t actual_type;
+
+        ECHECK(myst_fdtable_get_any(
+            fdtable, fd, &actual_type, (void**)&dev, (void**)&obj));
+
+        if (actual_type != type)
+            ERAISE(-EINVAL);
+
+        ECHECK((*dev->setmask)(dev, obj, bits));
+        ret = fd;
+        goto done;
+    }
+
+    ECHECK((*dev->signalfd)(dev, bits, flags, &obj));
+
+    if ((fd = myst_fdtable_assign(fdtable, type, dev, obj)) < 0)
+    {
+        myst_fdtable_remove(fdtable, fd);
+        (*dev->close)(dev, obj);
+        ERAISE(fd);
+    }
+
+    ret = fd;
+
+done:
+    return ret;
+}
+
 long myst_syscall_inotify_init1(int flags)
 {
     long ret = 0;
@@ -2192,11 +2325,27 @@ static size_t _count_args(const char* const args[])
     return n;
 }
 
+/* decodes the arguments of the system call, traces it, and handles it */
+typedef long (*syscall_handler_t)(long n, long params[6]);
+
+/* the system call is handled by myst_syscall() on the caller's stack, without
+ * switching thread descriptors, accounting kernel time, processing signals,
+ * or tracing (for cheap system calls that never block) */
+#define SYSCALL_DIRECT 0x1
+
+/* an entry in the fast lane (see _fast_syscalls[]) */
+typedef struct syscall_entry
+{
+    syscall_handler_t handler;
+    uint32_t flags;
+} syscall_entry_t;
+
 typedef struct syscall_args
 {
     long n;
     long* params;
     myst_kstack_t* kstack;
+    const syscall_entry_t* entry; /* null if not in the fast lane */
 } syscall_args_t;
 
 long myst_syscall_execveat(
@@ -2969,27 +3118,6 @@ done:
     return ret;
 }
 
-long myst_syscall_mbind(
-    void* addr,
-    unsigned long len,
-    int mode,
-    const unsigned long* nodemask,
-    unsigned long maxnode,
-    unsigned flags)
-{
-    long ret = 0;
-
-    /* ATTN: stub implementation */
-
-    (void)addr;
-    (void)len;
-    (void)mode;
-    (void)nodemask;
-    (void)maxnode;
-    (void)flags;
-    return ret;
-}
-
 long myst_syscall_get_process_thread_stack(void** stack, size_t* stack_size)
 {
     long ret = 0;
@@ -3131,6 +3259,307 @@ void myst_dump_ramfs(void)
     myst_strarr_release(&paths);
 }
 
+/*
+**==============================================================================
+**
+** The system call fast lane
+**
+** The switch statement in _syscall() handles system calls. A few of the
+** hottest ones are handled in front of it: _fast_syscalls[] maps their
+** numbers to handlers of their own. Reaching such a handler costs about as
+** much as reaching a case of the switch (which compiles to a jump table);
+** what the table buys is SYSCALL_DIRECT, which lets a system call skip the
+** kernel entry (stack switch, time accounting and signal processing)
+** altogether. tests/syscallperf compares the three paths. Only add a system
+** call here when that benchmark shows a gain.
+**
+**==============================================================================
+*/
+
+static long _sys_read(long n, long params[6])
+{
+    int fd = (int)params[0];
+    void* buf = (void*)params[1];
+    size_t count = (size_t)params[2];
+
+    _strace(n, "fd=%d buf=%p count=%zu", fd, buf, count);
+
+    return _return(n, myst_syscall_read(fd, buf, count));
+}
+
+static long _sys_write(long n, long params[6])
+{
+    int fd = (int)params[0];
+    const void* buf = (const void*)params[1];
+    size_t count = (size_t)params[2];
+    long ret;
+
+    _strace(n, "fd=%d buf=%p count=%zu", fd, buf, count);
+
+    if (!buf && count)
+        ret = -EINVAL;
+    else if (buf && myst_is_bad_addr_read(buf, count))
+        ret = -EFAULT;
+    else
+        ret = myst_syscall_write(fd, buf, count);
+
+    return _return(n, ret);
+}
+
+static long _sys_pread64(long n, long params[6])
+{
+    int fd = (int)params[0];
+    void* buf = (void*)params[1];
+    size_t count = (size_t)params[2];
+    off_t offset = (off_t)params[3];
+
+    _strace(n, "fd=%d buf=%p count=%zu offset=%ld", fd, buf, count, offset);
+
+    return _return(n, myst_syscall_pread(fd, buf, count, offset));
+}
+
+static long _sys_pwrite64(long n, long params[6])
+{
+    int fd = (int)params[0];
+    void* buf = (void*)params[1];
+    size_t count = (size_t)params[2];
+    off_t offset = (off_t)params[3];
+
+    _strace(n, "fd=%d buf=%p count=%zu offset=%ld", fd, buf, count, offset);
+
+    return _return(n, myst_syscall_pwrite(fd, buf, count, offset));
+}
+
+static long _sys_close(long n, long params[6])
+{
+    int fd = (int)params[0];
+
+    _strace(n, "fd=%d", fd);
+
+    return _return(n, myst_syscall_close(fd));
+}
+
+static long _sys_fstat(long n, long params[6])
+{
+    int fd = (int)params[0];
+    void* statbuf = (void*)params[1];
+
+    _strace(n, "fd=%d statbuf=%p", fd, statbuf);
+
+    return _return(n, myst_syscall_fstat(fd, statbuf));
+}
+
+static long _sys_lseek(long n, long params[6])
+{
+    int fd = (int)params[0];
+    off_t offset = (off_t)params[1];
+    int whence = (int)params[2];
+
+    _strace(n, "fd=%d offset=%ld whence=%d", fd, offset, whence);
+
+    return _return(n, myst_syscall_lseek(fd, offset, whence));
+}
+
+static long _sys_readv(long n, long params[6])
+{
+    int fd = (int)params[0];
+    const struct iovec* iov = (const struct iovec*)params[1];
+    int iovcnt = (int)params[2];
+
+    _strace(n, "fd=%d iov=%p iovcnt=%d", fd, iov, iovcnt);
+
+    return _return(n, myst_syscall_readv(fd, iov, iovcnt));
+}
+
+static long _sys_writev(long n, long params[6])
+{
+    int fd = (int)params[0];
+    const struct iovec* iov = (const struct iovec*)params[1];
+    int iovcnt = (int)params[2];
+
+    _strace(n, "fd=%d iov=%p iovcnt=%d", fd, iov, iovcnt);
+
+    return _return(n, myst_syscall_writev(fd, iov, iovcnt));
+}
+
+static long _sys_sched_yield(long n, long params[6])
+{
+    (void)params;
+
+    _strace(n, NULL);
+
+    return _return(n, myst_syscall_sched_yield());
+}
+
+static long _sys_getpid(long n, long params[6])
+{
+    (void)params;
+
+    _strace(n, NULL);
+
+    return _return(n, myst_getpid());
+}
+
+static long _sys_getppid(long n, long params[6])
+{
+    (void)params;
+
+    _strace(n, NULL);
+
+    return _return(n, myst_getppid());
+}
+
+static long _sys_gettid(long n, long params[6])
+{
+    (void)params;
+
+    _strace(n, NULL);
+
+    return _return(n, myst_gettid());
+}
+
+static long _sys_gettimeofday(long n, long params[6])
+{
+    struct timeval* tv = (struct timeval*)params[0];
+    struct timezone* tz = (void*)params[1];
+
+    _strace(n, "tv=%p tz=%p", tv, tz);
+
+    return _return(n, myst_syscall_gettimeofday(tv, tz));
+}
+
+static long _sys_time(long n, long params[6])
+{
+    time_t* tloc = (time_t*)params[0];
+
+    _strace(n, "tloc=%p", tloc);
+
+    return _return(n, myst_syscall_time(tloc));
+}
+
+static long _sys_futex(long n, long params[6])
+{
+    int* uaddr = (int*)params[0];
+    int futex_op = (int)params[1];
+    int val = (int)params[2];
+    long arg = (long)params[3];
+    int* uaddr2 = (int*)params[4];
+    int val3 = (int)params[5];
+    int futex_op2 = futex_op & ~FUTEX_PRIVATE;
+
+    if (futex_op2 == FUTEX_WAIT || futex_op2 == FUTEX_WAIT_BITSET)
+    {
+        const struct timespec* timeout = (const struct timespec*)params[3];
+        struct timespec_buf buf;
+
+        _strace(
+            n,
+            "uaddr=0x%lx(%d) futex_op=%u(%s) val=%d, "
+            "timeout=%s uaddr2=0x%lx val3=%d",
+            (long)uaddr,
+            (uaddr ? *uaddr : -1),
+            futex_op,
+            _futex_op_str(futex_op),
+            val,
+            _format_timespec(&buf, timeout),
+            (long)uaddr2,
+            val3);
+    }
+    else
+    {
+        _strace(
+            n,
+            "uaddr=0x%lx(%d) futex_op=%u(%s) val=%d arg=%li "
+            "uaddr2=0x%lx val3=%d",
+            (long)uaddr,
+            (uaddr ? *uaddr : -1),
+            futex_op,
+            _futex_op_str(futex_op),
+            val,
+            arg,
+            (long)uaddr2,
+            val3);
+    }
+
+    return _return(
+        n, myst_syscall_futex(uaddr, futex_op, val, arg, uaddr2, val3));
+}
+
+static long _sys_getcpu(long n, long params[6])
+{
+    unsigned* cpu = (unsigned*)params[0];
+    unsigned* node = (unsigned*)params[1];
+    struct getcpu_cache* tcache = (struct getcpu_cache*)params[2];
+
+    _strace(n, "cpu=%p node=%p, tcache=%p", cpu, node, tcache);
+
+    /* unused since Linux 2.6.24 */
+    (void)tcache;
+
+    return _return(n, myst_syscall_getcpu(cpu, node));
+}
+
+/* SYSCALL_DIRECT: the clock is read without entering the kernel proper */
+static long _sys_clock_gettime(long n, long params[6])
+{
+    clockid_t clk_id = (clockid_t)params[0];
+    struct timespec* tp = (struct timespec*)params[1];
+
+    (void)n;
+
+    return myst_syscall_clock_gettime(clk_id, tp);
+}
+
+/* SYSCALL_DIRECT: this can only be performed on the caller's stack and
+ * before the fsbase is changed by _syscall() */
+static long _sys_arch_prctl(long n, long params[6])
+{
+    int code = (int)params[0];
+    unsigned long* addr = (unsigned long*)params[1];
+
+    (void)n;
+
+    return myst_syscall_arch_prctl(code, addr);
+}
+
+#define FAST_SYSCALL(NAME, FLAGS) [SYS_##NAME] = {_sys_##NAME, FLAGS}
+
+// clang-format off
+static const syscall_entry_t _fast_syscalls[] =
+{
+    FAST_SYSCALL(read, 0),
+    FAST_SYSCALL(write, 0),
+    FAST_SYSCALL(close, 0),
+    FAST_SYSCALL(fstat, 0),
+    FAST_SYSCALL(lseek, 0),
+    FAST_SYSCALL(pread64, 0),
+    FAST_SYSCALL(pwrite64, 0),
+    FAST_SYSCALL(readv, 0),
+    FAST_SYSCALL(writev, 0),
+    FAST_SYSCALL(sched_yield, 0),
+    FAST_SYSCALL(getpid, 0),
+    FAST_SYSCALL(gettimeofday, 0),
+    FAST_SYSCALL(getppid, 0),
+    FAST_SYSCALL(arch_prctl, SYSCALL_DIRECT),
+    FAST_SYSCALL(gettid, 0),
+    FAST_SYSCALL(time, 0),
+    FAST_SYSCALL(futex, 0),
+    FAST_SYSCALL(clock_gettime, SYSCALL_DIRECT),
+    FAST_SYSCALL(getcpu, 0),
+};
+// clang-format on
+
+MYST_INLINE const syscall_entry_t* _fast_syscall(long n)
+{
+    if ((unsigned long)n < MYST_COUNTOF(_fast_syscalls) &&
+        _fast_syscalls[n].handler)
+    {
+        return &_fast_syscalls[n];
+    }
+
+    return NULL;
+}
+
 #define BREAK(RET)           \
     do                       \
     {                        \
@@ -3206,6 +3635,10 @@ static long _syscall(void* args_)
     myst_assume(target_td != NULL);
     myst_assume(thread != NULL);
 
+    /* system calls in the fast lane */
+    if (args->entry)
+        BREAK((*args->entry->handler)(n, params));
+
     switch (n)
     {
         case SYS_myst_trace:
@@ -3362,90 +3795,31 @@ static long _syscall(void* args_)
             long ret = myst_syscall_get_process_thread_stack(stack, stack_size);
             BREAK(_return(n, ret));
         }
-        case SYS_read:
+        case SYS_open:
         {
-            int fd = (int)x1;
-            void* buf = (void*)x2;
-            size_t count = (size_t)x3;
+            const char* path = (const char*)x1;
+            int flags = (int)x2;
+            mode_t mode = (mode_t)x3;
+            myst_process_t* process = myst_process_self();
+            long ret;
 
-            _strace(n, "fd=%d buf=%p count=%zu", fd, buf, count);
+            _strace(
+                n,
+                "path=\"%s\" flags=0%o mode=0%o umask=0%o",
+                path,
+                flags,
+                mode,
+                process->umask);
 
-            BREAK(_return(n, myst_syscall_read(fd, buf, count)));
-        }
-        case SYS_write:
-        {
-            int fd = (int)x1;
-            const void* buf = (const void*)x2;
-            size_t count = (size_t)x3;
-            long ret;
+            /* Apply umask */
+            /* ATTN: Implementaiton need to be updated if directory ACL is
+             * supported */
+            mode = mode & (~(process->umask));
 
-            _strace(n, "fd=%d buf=%p count=%zu", fd, buf, count);
-
-            if (!buf && count)
-                ret = -EINVAL;
-            else if (buf && myst_is_bad_addr_read(buf, count))
-                ret = -EFAULT;
-            else
-                ret = myst_syscall_write(fd, buf, count);
-            BREAK(_return(n, ret));
-        }
-        case SYS_pread64:
-        {
-            int fd = (int)x1;
-            void* buf = (void*)x2;
-            size_t count = (size_t)x3;
-            off_t offset = (off_t)x4;
-
-            _strace(
-                n, "fd=%d buf=%p count=%zu offset=%ld", fd, buf, count, offset);
-
-            BREAK(_return(n, myst_syscall_pread(fd, buf, count, offset)));
-        }
-        case SYS_pwrite64:
-        {
-            int fd = (int)x1;
-            void* buf = (void*)x2;
-            size_t count = (size_t)x3;
-            off_t offset = (off_t)x4;
-
-            _strace(
-                n, "fd=%d buf=%p count=%zu offset=%ld", fd, buf, count, offset);
-
-            BREAK(_return(n, myst_syscall_pwrite(fd, buf, count, offset)));
-        }
-        case SYS_open:
-        {
-            const char* path = (const char*)x1;
-            int flags = (int)x2;
-            mode_t mode = (mode_t)x3;
-            myst_process_t* process = myst_process_self();
-            long ret;
-
-            _strace(
-                n,
-                "path=\"%s\" flags=0%o mode=0%o umask=0%o",
-                path,
-                flags,
-                mode,
-                process->umask);
-
-            /* Apply umask */
-            /* ATTN: Implementaiton need to be updated if directory ACL is
-             * supported */
-            mode = mode & (~(process->umask));
-
-            ret = myst_syscall_open(path, flags, mode);
+            ret = myst_syscall_open(path, flags, mode);
 
             BREAK(_return(n, ret));
         }
-        case SYS_close:
-        {
-            int fd = (int)x1;
-
-            _strace(n, "fd=%d", fd);
-
-            BREAK(_return(n, myst_syscall_close(fd)));
-        }
         case SYS_stat:
         {
             const char* pathname = (const char*)x1;
@@ -3455,15 +3829,6 @@ static long _syscall(void* args_)
 
             BREAK(_return(n, myst_syscall_stat(pathname, statbuf)));
         }
-        case SYS_fstat:
-        {
-            int fd = (int)x1;
-            void* statbuf = (void*)x2;
-
-            _strace(n, "fd=%d statbuf=%p", fd, statbuf);
-
-            BREAK(_return(n, myst_syscall_fstat(fd, statbuf)));
-        }
         case SYS_lstat:
         {
             /* ATTN: remove this! */
@@ -3492,16 +3857,6 @@ static long _syscall(void* args_)
             ret = myst_syscall_poll(fds, nfds, timeout, false);
             BREAK(_return(n, ret));
         }
-        case SYS_lseek:
-        {
-            int fd = (int)x1;
-            off_t offset = (off_t)x2;
-            int whence = (int)x3;
-
-            _strace(n, "fd=%d offset=%ld whence=%d", fd, offset, whence);
-
-            BREAK(_return(n, myst_syscall_lseek(fd, offset, whence)));
-        }
         case SYS_mmap:
         {
             void* addr = (void*)x1;
@@ -3531,6 +3886,23 @@ static long _syscall(void* args_)
             if ((uintptr_t)addr % PAGE_SIZE || !length)
                 BREAK(_return(n, -EINVAL));
 
+            /* shared mappings of shm objects return the object's own pages,
+             * which belong to no particular process */
+            if ((flags & MAP_SHARED) && !(flags & MAP_ANONYMOUS) && fd >= 0)
+            {
+                myst_fdtable_t* fdtable = myst_fdtable_current();
+                myst_fs_t* fs;
+                myst_file_t* file;
+
+                if (myst_fdtable_get_file(fdtable, fd, &fs, &file) == 0 &&
+                    myst_is_shmfs(fs))
+                {
+                    long ret = myst_shmfs_mmap(
+                        fs, file, addr, length, prot, flags, offset);
+                    BREAK(_return(n, ret));
+                }
+            }
+
             /* mman supports non-null addr if - existing mapping, MAP_FIXED
              * passed in flags and process must own the existing mapping. */
             if (addr && length)
@@ -3574,6 +3946,8 @@ static long _syscall(void* args_)
                 if (myst_mman_pids_set(ptr, length, pid) != 0)
                     myst_panic("myst_mman_pids_set()");
 
+                myst_numa_apply_mempolicy(ptr, length);
+
                 ret = (long)ptr;
             }
 
@@ -3621,6 +3995,19 @@ static long _syscall(void* args_)
                 }
             }
 
+            /* the unmapped pages go back to the default policy */
+            {
+                long ret = myst_numa_unmap(addr, length);
+
+                if (ret != 0)
+                    BREAK(_return(n, ret));
+            }
+
+            /* shm object pages outlive the mapping (private pages within
+             * the range are unmapped by myst_shmfs_munmap() too) */
+            if (myst_shmfs_is_shared(addr, length))
+                BREAK(_return(n, myst_shmfs_munmap(addr, length)));
+
             long ret = (long)myst_munmap(addr, length);
 
             if (ret == 0)
@@ -3696,26 +4083,6 @@ static long _syscall(void* args_)
 
             BREAK(_return(n, myst_syscall_ioctl(fd, request, arg)));
         }
-        case SYS_readv:
-        {
-            int fd = (int)x1;
-            const struct iovec* iov = (const struct iovec*)x2;
-            int iovcnt = (int)x3;
-
-            _strace(n, "fd=%d iov=%p iovcnt=%d", fd, iov, iovcnt);
-
-            BREAK(_return(n, myst_syscall_readv(fd, iov, iovcnt)));
-        }
-        case SYS_writev:
-        {
-            int fd = (int)x1;
-            const struct iovec* iov = (const struct iovec*)x2;
-            int iovcnt = (int)x3;
-
-            _strace(n, "fd=%d iov=%p iovcnt=%d", fd, iov, iovcnt);
-
-            BREAK(_return(n, myst_syscall_writev(fd, iov, iovcnt)));
-        }
         case SYS_access:
         {
             const char* pathname = (const char*)x1;
@@ -3767,12 +4134,6 @@ static long _syscall(void* args_)
             ret = myst_syscall_select(nfds, rfds, wfds, efds, timeout);
             BREAK(_return(n, ret));
         }
-        case SYS_sched_yield:
-        {
-            _strace(n, NULL);
-
-            BREAK(_return(n, myst_syscall_sched_yield()));
-        }
         case SYS_mremap:
         {
             void* old_address = (void*)x1;
@@ -3844,14 +4205,42 @@ static long _syscall(void* args_)
 
             _strace(n, "addr=%p length=%zu advice=%d", addr, length, advice);
 
-            BREAK(_return(n, 0));
+            /* other processes may still be using shm object pages */
+            if (myst_shmfs_is_shared(addr, length))
+                BREAK(_return(n, myst_shmfs_madvise(addr, length, advice)));
+
+            BREAK(_return(n, myst_madvise(addr, length, advice)));
         }
         case SYS_shmget:
-            break;
+        {
+            key_t key = (key_t)x1;
+            size_t size = (size_t)x2;
+            int shmflg = (int)x3;
+
+            _strace(n, "key=%d size=%zu shmflg=%o", key, size, shmflg);
+
+            BREAK(_return(n, myst_syscall_shmget(key, size, shmflg)));
+        }
         case SYS_shmat:
-            break;
+        {
+            int shmid = (int)x1;
+            const void* shmaddr = (const void*)x2;
+            int shmflg = (int)x3;
+
+            _strace(n, "shmid=%d shmaddr=%p shmflg=%o", shmid, shmaddr, shmflg);
+
+            BREAK(_return(n, myst_syscall_shmat(shmid, shmaddr, shmflg)));
+        }
         case SYS_shmctl:
-            break;
+        {
+            int shmid = (int)x1;
+            int cmd = (int)x2;
+            struct shmid_ds* buf = (struct shmid_ds*)x3;
+
+            _strace(n, "shmid=%d cmd=%d buf=%p", shmid, cmd, buf);
+
+            BREAK(_return(n, myst_syscall_shmctl(shmid, cmd, buf)));
+        }
         case SYS_dup:
         {
             int oldfd = (int)x1;
@@ -3907,6 +4296,11 @@ static long _syscall(void* args_)
             _strace(n, NULL);
             BREAK(_return(n, myst_syscall_run_itimer(process)));
         }
+        case SYS_myst_run_aio:
+        {
+            _strace(n, NULL);
+            BREAK(_return(n, myst_syscall_run_aio(process)));
+        }
         case SYS_myst_start_shell:
         {
             _strace(n, NULL);
@@ -3945,11 +4339,6 @@ static long _syscall(void* args_)
                 n,
                 myst_syscall_setitimer(process, which, new_value, old_value)));
         }
-        case SYS_getpid:
-        {
-            _strace(n, NULL);
-            BREAK(_return(n, myst_getpid()));
-        }
         case SYS_clone:
         {
             /* unsupported: using SYS_myst_clone instead */
@@ -4154,7 +4543,13 @@ static long _syscall(void* args_)
         case SYS_semctl:
             break;
         case SYS_shmdt:
-            break;
+        {
+            const void* shmaddr = (const void*)x1;
+
+            _strace(n, "shmaddr=%p", shmaddr);
+
+            BREAK(_return(n, myst_syscall_shmdt(shmaddr)));
+        }
         case SYS_msgget:
             break;
         case SYS_msgsnd:
@@ -4429,16 +4824,6 @@ static long _syscall(void* args_)
 
             BREAK(_return(n, myst_syscall_umask(mask)));
         }
-        case SYS_gettimeofday:
-        {
-            struct timeval* tv = (struct timeval*)x1;
-            struct timezone* tz = (void*)x2;
-
-            _strace(n, "tv=%p tz=%p", tv, tz);
-
-            long ret = myst_syscall_gettimeofday(tv, tz);
-            BREAK(_return(n, ret));
-        }
         case SYS_getrlimit:
             break;
         case SYS_getrusage:
@@ -4500,11 +4885,6 @@ static long _syscall(void* args_)
             _strace(n, NULL);
             BREAK(_return(n, myst_syscall_getpgid(process->pid, thread)));
         }
-        case SYS_getppid:
-        {
-            _strace(n, NULL);
-            BREAK(_return(n, myst_getppid()));
-        }
         case SYS_getsid:
         {
             _strace(n, NULL);
@@ -4825,11 +5205,6 @@ static long _syscall(void* args_)
 
             BREAK(_return(n, ret));
         }
-        case SYS_arch_prctl:
-        {
-            /* this is handled in myst_syscall() */
-            break;
-        }
         case SYS_adjtimex:
             break;
         case SYS_setrlimit:
@@ -4925,11 +5300,6 @@ static long _syscall(void* args_)
             break;
         case SYS_security:
             break;
-        case SYS_gettid:
-        {
-            _strace(n, NULL);
-            BREAK(_return(n, myst_gettid()));
-        }
         case SYS_readahead:
             break;
         case SYS_setxattr:
@@ -4972,62 +5342,6 @@ static long _syscall(void* args_)
             long ret = myst_syscall_tgkill(tgid, tid, sig);
             BREAK(_return(n, ret));
         }
-        case SYS_time:
-        {
-            time_t* tloc = (time_t*)x1;
-
-            _strace(n, "tloc=%p", tloc);
-            long ret = myst_syscall_time(tloc);
-            BREAK(_return(n, ret));
-        }
-        case SYS_futex:
-        {
-            int* uaddr = (int*)x1;
-            int futex_op = (int)x2;
-            int val = (int)x3;
-            long arg = (long)x4;
-            int* uaddr2 = (int*)x5;
-            int val3 = (int)x6;
-            int futex_op2 = futex_op & ~FUTEX_PRIVATE;
-
-            if (futex_op2 == FUTEX_WAIT || futex_op2 == FUTEX_WAIT_BITSET)
-            {
-                const struct timespec* timeout = (const struct timespec*)x4;
-                struct timespec_buf buf;
-
-                _strace(
-                    n,
-                    "uaddr=0x%lx(%d) futex_op=%u(%s) val=%d, "
-                    "timeout=%s uaddr2=0x%lx val3=%d",
-                    (long)uaddr,
-                    (uaddr ? *uaddr : -1),
-                    futex_op,
-                    _futex_op_str(futex_op),
-                    val,
-                    _format_timespec(&buf, timeout),
-                    (long)uaddr2,
-                    val3);
-            }
-            else
-            {
-                _strace(
-                    n,
-                    "uaddr=0x%lx(%d) futex_op=%u(%s) val=%d arg=%li "
-                    "uaddr2=0x%lx val3=%d",
-                    (long)uaddr,
-                    (uaddr ? *uaddr : -1),
-                    futex_op,
-                    _futex_op_str(futex_op),
-                    val,
-                    arg,
-                    (long)uaddr2,
-                    val3);
-            }
-
-            BREAK(_return(
-                n,
-                myst_syscall_futex(uaddr, futex_op, val, arg, uaddr2, val3)));
-        }
         case SYS_sched_setaffinity:
         {
             pid_t pid = (pid_t)x1;
@@ -5082,15 +5396,67 @@ static long _syscall(void* args_)
             BREAK(_return(n, 0));
         }
         case SYS_io_setup:
-            break;
+        {
+            unsigned int nr_events = (unsigned int)x1;
+            aio_context_t* ctx_idp = (aio_context_t*)x2;
+
+            _strace(n, "nr_events=%u ctx_idp=%p", nr_events, ctx_idp);
+
+            BREAK(_return(
+                n, myst_syscall_io_setup(process, nr_events, ctx_idp)));
+        }
         case SYS_io_destroy:
-            break;
+        {
+            aio_context_t ctx_id = (aio_context_t)x1;
+
+            _strace(n, "ctx_id=%lx", ctx_id);
+
+            BREAK(_return(n, myst_syscall_io_destroy(process, ctx_id)));
+        }
         case SYS_io_getevents:
-            break;
+        {
+            aio_context_t ctx_id = (aio_context_t)x1;
+            long min_nr = (long)x2;
+            long nr = (long)x3;
+            struct io_event* events = (struct io_event*)x4;
+            struct timespec* timeout = (struct timespec*)x5;
+
+            _strace(
+                n,
+                "ctx_id=%lx min_nr=%ld nr=%ld events=%p timeout=%p",
+                ctx_id,
+                min_nr,
+                nr,
+                events,
+                timeout);
+
+            BREAK(_return(
+                n,
+                myst_syscall_io_getevents(
+                    process, ctx_id, min_nr, nr, events, timeout)));
+        }
         case SYS_io_submit:
-            break;
+        {
+            aio_context_t ctx_id = (aio_context_t)x1;
+            long nr = (long)x2;
+            struct iocb** iocbpp = (struct iocb**)x3;
+
+            _strace(n, "ctx_id=%lx nr=%ld iocbpp=%p", ctx_id, nr, iocbpp);
+
+            BREAK(_return(
+                n, myst_syscall_io_submit(process, ctx_id, nr, iocbpp)));
+        }
         case SYS_io_cancel:
-            break;
+        {
+            aio_context_t ctx_id = (aio_context_t)x1;
+            struct iocb* iocb = (struct iocb*)x2;
+            struct io_event* result = (struct io_event*)x3;
+
+            _strace(n, "ctx_id=%lx iocb=%p result=%p", ctx_id, iocb, result);
+
+            BREAK(_return(
+                n, myst_syscall_io_cancel(process, ctx_id, iocb, result)));
+        }
         case SYS_get_thread_area:
             break;
         case SYS_lookup_dcookie:
@@ -5155,33 +5521,72 @@ static long _syscall(void* args_)
             BREAK(_return(n, 0));
         }
         case SYS_timer_create:
-            break;
+        {
+            clockid_t clockid = (clockid_t)x1;
+            struct sigevent* sevp = (struct sigevent*)x2;
+            int* timerid = (int*)x3;
+
+            _strace(n, "clockid=%d sevp=%p timerid=%p", clockid, sevp, timerid);
+
+            BREAK(_return(
+                n,
+                myst_syscall_timer_create(process, clockid, sevp, timerid)));
+        }
         case SYS_timer_settime:
-            break;
+        {
+            int timerid = (int)x1;
+            int flags = (int)x2;
+            const struct itimerspec* new_value = (void*)x3;
+            struct itimerspec* old_value = (void*)x4;
+
+            _strace(
+                n,
+                "timerid=%d flags=%d new_value=%p old_value=%p",
+                timerid,
+                flags,
+                new_value,
+                old_value);
+
+            BREAK(_return(
+                n,
+                myst_syscall_timer_settime(
+                    process, timerid, flags, new_value, old_value)));
+        }
         case SYS_timer_gettime:
-            break;
+        {
+            int timerid = (int)x1;
+            struct itimerspec* curr_value = (void*)x2;
+
+            _strace(n, "timerid=%d curr_value=%p", timerid, curr_value);
+
+            BREAK(_return(
+                n, myst_syscall_timer_gettime(process, timerid, curr_value)));
+        }
         case SYS_timer_getoverrun:
-            break;
+        {
+            int timerid = (int)x1;
+
+            _strace(n, "timerid=%d", timerid);
+
+            BREAK(_return(n, myst_syscall_timer_getoverrun(process, timerid)));
+        }
         case SYS_timer_delete:
-            break;
-        case SYS_clock_settime:
         {
-            clockid_t clk_id = (clockid_t)x1;
-            struct timespec* tp = (struct timespec*)x2;
-            struct timespec_buf buf;
+            int timerid = (int)x1;
 
-            _strace(n, "clk_id=%u tp=%s", clk_id, _format_timespec(&buf, tp));
+            _strace(n, "timerid=%d", timerid);
 
-            BREAK(_return(n, myst_syscall_clock_settime(clk_id, tp)));
+            BREAK(_return(n, myst_syscall_timer_delete(process, timerid)));
         }
-        case SYS_clock_gettime:
+        case SYS_clock_settime:
         {
             clockid_t clk_id = (clockid_t)x1;
             struct timespec* tp = (struct timespec*)x2;
+            struct timespec_buf buf;
 
-            _strace(n, "clk_id=%u tp=%p", clk_id, tp);
+            _strace(n, "clk_id=%u tp=%s", clk_id, _format_timespec(&buf, tp));
 
-            BREAK(_return(n, myst_syscall_clock_gettime(clk_id, tp)));
+            BREAK(_return(n, myst_syscall_clock_settime(clk_id, tp)));
         }
         case SYS_clock_getres:
         {
@@ -5265,9 +5670,38 @@ static long _syscall(void* args_)
             BREAK(_return(n, ret));
         }
         case SYS_set_mempolicy:
-            break;
+        {
+            int mode = (int)x1;
+            const unsigned long* nodemask = (const unsigned long*)x2;
+            unsigned long maxnode = (unsigned long)x3;
+
+            _strace(
+                n, "mode=%d nodemask=%p maxnode=%lu", mode, nodemask, maxnode);
+
+            long ret = myst_syscall_set_mempolicy(mode, nodemask, maxnode);
+            BREAK(_return(n, ret));
+        }
         case SYS_get_mempolicy:
-            break;
+        {
+            int* mode = (int*)x1;
+            unsigned long* nodemask = (unsigned long*)x2;
+            unsigned long maxnode = (unsigned long)x3;
+            void* addr = (void*)x4;
+            unsigned long flags = (unsigned long)x5;
+
+            _strace(
+                n,
+                "mode=%p nodemask=%p maxnode=%lu addr=%p flags=%lu",
+                mode,
+                nodemask,
+                maxnode,
+                addr,
+                flags);
+
+            long ret = myst_syscall_get_mempolicy(
+                mode, nodemask, maxnode, addr, flags);
+            BREAK(_return(n, ret));
+        }
         case SYS_mq_open:
             break;
         case SYS_mq_unlink:
@@ -5575,13 +6009,50 @@ static long _syscall(void* args_)
             BREAK(_return(n, ret));
         }
         case SYS_splice:
-            break;
+        {
+            int fd_in = (int)x1;
+            off_t* off_in = (off_t*)x2;
+            int fd_out = (int)x3;
+            off_t* off_out = (off_t*)x4;
+            size_t len = (size_t)x5;
+            unsigned int flags = (unsigned int)x6;
+
+            _strace(
+                n,
+                "fd_in=%d off_in=%p fd_out=%d off_out=%p len=%zu flags=%u",
+                fd_in,
+                off_in,
+                fd_out,
+                off_out,
+                len,
+                flags);
+
+            BREAK(_return(
+                n,
+                myst_syscall_splice(
+                    fd_in, off_in, fd_out, off_out, len, flags)));
+        }
         case SYS_tee:
             break;
         case SYS_sync_file_range:
             break;
         case SYS_vmsplice:
-            break;
+        {
+            int fd = (int)x1;
+            const struct iovec* iov = (const struct iovec*)x2;
+            size_t nr_segs = (size_t)x3;
+            unsigned int flags = (unsigned int)x4;
+
+            _strace(
+                n,
+                "fd=%d iov=%p nr_segs=%zu flags=%u",
+                fd,
+                iov,
+                nr_segs,
+                flags);
+
+            BREAK(_return(n, myst_syscall_vmsplice(fd, iov, nr_segs, flags)));
+        }
         case SYS_move_pages:
             break;
         case SYS_utimensat:
@@ -5626,9 +6097,25 @@ static long _syscall(void* args_)
             BREAK(_return(n, ret));
         }
         case SYS_signalfd:
-            break;
+        {
+            int fd = (int)x1;
+            const sigset_t* mask = (const sigset_t*)x2;
+            size_t sizemask = (size_t)x3;
+
+            _strace(n, "fd=%d mask=%p sizemask=%zu", fd, mask, sizemask);
+
+            long ret = myst_syscall_signalfd(fd, mask, sizemask, 0);
+            BREAK(_return(n, ret));
+        }
         case SYS_timerfd_create:
-            break;
+        {
+            clockid_t clockid = (clockid_t)x1;
+            int flags = (int)x2;
+
+            _strace(n, "clockid=%d flags=%d", clockid, flags);
+
+            BREAK(_return(n, myst_syscall_timerfd_create(clockid, flags)));
+        }
         case SYS_eventfd:
             break;
         case SYS_fallocate:
@@ -5645,9 +6132,33 @@ static long _syscall(void* args_)
             BREAK(_return(n, 0));
         }
         case SYS_timerfd_settime:
-            break;
+        {
+            int fd = (int)x1;
+            int flags = (int)x2;
+            const struct itimerspec* new_value = (void*)x3;
+            struct itimerspec* old_value = (void*)x4;
+
+            _strace(
+                n,
+                "fd=%d flags=%d new_value=%p old_value=%p",
+                fd,
+                flags,
+                new_value,
+                old_value);
+
+            BREAK(_return(
+                n,
+                myst_syscall_timerfd_settime(fd, flags, new_value, old_value)));
+        }
         case SYS_timerfd_gettime:
-            break;
+        {
+            int fd = (int)x1;
+            struct itimerspec* curr_value = (void*)x2;
+
+            _strace(n, "fd=%d curr_value=%p", fd, curr_value);
+
+            BREAK(_return(n, myst_syscall_timerfd_gettime(fd, curr_value)));
+        }
         case SYS_accept4:
         {
             int sockfd = (int)x1;
@@ -5675,7 +6186,23 @@ static long _syscall(void* args_)
             BREAK(_return(n, ret));
         }
         case SYS_signalfd4:
-            break;
+        {
+            int fd = (int)x1;
+            const sigset_t* mask = (const sigset_t*)x2;
+            size_t sizemask = (size_t)x3;
+            int flags = (int)x4;
+
+            _strace(
+                n,
+                "fd=%d mask=%p sizemask=%zu flags=%d",
+                fd,
+                mask,
+                sizemask,
+                flags);
+
+            long ret = myst_syscall_signalfd(fd, mask, sizemask, flags);
+            BREAK(_return(n, ret));
+        }
         case SYS_eventfd2:
         {
             unsigned int initval = (unsigned int)x1;
@@ -5837,21 +6364,6 @@ static long _syscall(void* args_)
         }
         case SYS_setns:
             break;
-        case SYS_getcpu:
-        {
-            unsigned* cpu = (unsigned*)x1;
-            unsigned* node = (unsigned*)x2;
-            struct getcpu_cache* tcache = (struct getcpu_cache*)x3;
-            long ret;
-
-            _strace(n, "cpu=%p node=%p, tcache=%p", cpu, node, tcache);
-
-            /* unused since Linux 2.6.24 */
-            (void)tcache;
-
-            ret = myst_syscall_getcpu(cpu, node);
-            BREAK(_return(n, ret));
-        }
         case SYS_process_vm_readv:
             break;
         case SYS_process_vm_writev:
@@ -5879,7 +6391,14 @@ static long _syscall(void* args_)
             BREAK(_return(n, myst_syscall_getrandom(buf, buflen, flags)));
         }
         case SYS_memfd_create:
-            break;
+        {
+            const char* name = (const char*)x1;
+            unsigned int flags = (unsigned int)x2;
+
+            _strace(n, "name=%s flags=%x", name, flags);
+
+            BREAK(_return(n, myst_syscall_memfd_create(name, flags)));
+        }
         case SYS_kexec_file_load:
             break;
         case SYS_bpf:
@@ -5911,15 +6430,12 @@ static long _syscall(void* args_)
         case SYS_membarrier:
         {
             int cmd = (int)x1;
-            int flags = (int)x2;
+            unsigned int flags = (unsigned int)x2;
+            int cpu_id = (int)x3;
 
-            _strace(n, "cmd=%d flags=%d", cmd, flags);
-            /* membarrier syscall relies on inter-processor-interrupt and the
-             * untrusted privileged SW layer such as the hypervisor or bare
-             * metal OS to sychronize code execution across CPU cores. Not
-             * supported.
-             */
-            BREAK(_return(n, -ENOSYS));
+            _strace(n, "cmd=%d flags=%u cpu_id=%d", cmd, flags, cpu_id);
+
+            BREAK(_return(n, myst_syscall_membarrier(cmd, flags, cpu_id)));
         }
         case SYS_mlock2:
             break;
@@ -5996,7 +6512,23 @@ static long _syscall(void* args_)
         case SYS_io_pgetevents:
             break;
         case SYS_rseq:
-            break;
+        {
+            myst_rseq_t* rseq = (myst_rseq_t*)x1;
+            uint32_t rseq_len = (uint32_t)x2;
+            int flags = (int)x3;
+            uint32_t sig = (uint32_t)x4;
+
+            _strace(
+                n,
+                "rseq=%p rseq_len=%u flags=%d sig=0x%x",
+                rseq,
+                rseq_len,
+                flags,
+                sig);
+
+            long ret = myst_syscall_rseq(rseq, rseq_len, flags, sig);
+            BREAK(_return(n, ret));
+        }
         case SYS_bind:
         {
             int sockfd = (int)x1;
@@ -6451,6 +6983,10 @@ done:
 
     myst_times_leave_kernel(n);
 
+    /* the thread may have been migrated to another host CPU */
+    if (thread->rseq.area)
+        myst_rseq_update(thread);
+
     // Process signals pending for this thread, if there is any.
     myst_signal_process(thread);
 
@@ -6462,34 +6998,63 @@ long myst_syscall(long n, long params[6])
 {
     long ret;
     myst_kstack_t* kstack;
-
-    // Call myst_syscall_clock_gettime() upfront to avoid triggering the
-    // overhead of myst_times_enter_kernel() and myst_times_leave_kernel(),
-    // which also read the clock.
-    if (n == SYS_clock_gettime)
+    myst_thread_t* thread = NULL;
+    uint64_t tsd;
+
+    const syscall_entry_t* entry = _fast_syscall(n);
+
+    // Handle direct system calls upfront, before the overhead of switching
+    // stacks, and of myst_times_enter_kernel() and myst_times_leave_kernel()
+    // (see SYSCALL_DIRECT).
+    if (entry && (entry->flags & SYSCALL_DIRECT))
+        return (*entry->handler)(n, params);
+
+    // Run on the kernel stack cached by this thread, which avoids the
+    // kernel-stack pool (a lock and stack registration) on every syscall.
+    // A nested syscall (made by a signal handler for instance) finds no
+    // cached stack and gets one from the pool. The thread is unknown for
+    // the first syscalls made by the C-runtime.
+    if (myst_tcall_get_tsd(&tsd) == 0 &&
+        myst_valid_thread((myst_thread_t*)tsd))
     {
-        clockid_t clk_id = (clockid_t)params[0];
-        struct timespec* tp = (struct timespec*)params[1];
-        return myst_syscall_clock_gettime(clk_id, tp);
+        thread = (myst_thread_t*)tsd;
+        kstack = __atomic_exchange_n(
+            &thread->cached_kstack, NULL, __ATOMIC_ACQ_REL);
     }
-
-    // Call myst_syscall_arch_prctl() upfront since it can only be performed
-    // on the caller's stack and before the fsbase is changed by the prologue
-    // code that follows.
-    if (n == SYS_arch_prctl)
+    else
     {
-        int code = (int)params[0];
-        unsigned long* addr = (unsigned long*)params[1];
-        return myst_syscall_arch_prctl(code, addr);
+        kstack = NULL;
     }
 
-    if (!(kstack = myst_get_kstack()))
+    if (!kstack && !(kstack = myst_get_kstack()))
         myst_panic("no more kernel stacks");
 
-    syscall_args_t args = {.n = n, .params = params, .kstack = kstack};
+    syscall_args_t args = {
+        .n = n, .params = params, .kstack = kstack, .entry = entry};
     ret = myst_call_on_stack(myst_kstack_end(kstack), _syscall, &args);
 
-    myst_put_kstack(kstack);
+    // Keep the kernel stack for the next syscall unless a nested syscall
+    // has already cached one. SYS_exit and a successful SYS_execve do not
+    // return here: they pass the kernel stack on to thread->exit_kstack and
+    // thread->exec_kstack instead.
+    if (thread)
+    {
+        myst_kstack_t* expected = NULL;
+
+        if (__atomic_compare_exchange_n(
+                &thread->cached_kstack,
+                &expected,
+                kstack,
+                false,
+                __ATOMIC_ACQ_REL,
+                __ATOMIC_ACQUIRE))
+        {
+            kstack = NULL;
+        }
+    }
+
+    if (kstack)
+        myst_put_kstack(kstack);
 
     return ret;
 }
@@ -6502,7 +7067,6 @@ long myst_syscall(long n, long params[6])
 **==============================================================================
 */
 
-static myst_spinlock_t _get_time_lock = MYST_SPINLOCK_INITIALIZER;
 static myst_spinlock_t _set_time_lock = MYST_SPINLOCK_INITIALIZER;
 
 long myst_syscall_clock_gettime(clockid_t clk_id, struct timespec* tp)
@@ -6537,11 +7101,35 @@ long myst_syscall_clock_gettime(clockid_t clk_id, struct timespec* tp)
         return 0;
     }
 
-    myst_spin_lock(&_get_time_lock);
+    /* the target clocks are lock-free */
     long params[6] = {(long)clk_id, (long)tp};
-    long ret = myst_tcall(MYST_TCALL_CLOCK_GETTIME, params);
-    myst_spin_unlock(&_get_time_lock);
-    return ret;
+    return myst_tcall(MYST_TCALL_CLOCK_GETTIME, params);
+}
+
+/* The clock_gettime() entry handed to the CRT (like the Linux vDSO): the
+ * common clocks go straight to the target without entering the kernel through
+ * myst_syscall(). The other clocks take the regular path.
+ */
+long myst_vdso_clock_gettime(clockid_t clk_id, struct timespec* tp)
+{
+    switch (clk_id)
+    {
+        case CLOCK_REALTIME:
+        case CLOCK_MONOTONIC:
+        case CLOCK_REALTIME_COARSE:
+        case CLOCK_MONOTONIC_COARSE:
+        case CLOCK_BOOTTIME:
+        {
+            long params[6] = {(long)clk_id, (long)tp};
+
+            if (!tp)
+                return -EFAULT;
+
+            return myst_tcall(MYST_TCALL_CLOCK_GETTIME, params);
+        }
+        default:
+            return myst_syscall_clock_gettime(clk_id, tp);
+    }
 }
 
 long myst_syscall_clock_settime(clockid_t clk_id, struct timespec* tp)
@@ -6604,7 +7192,7 @@ long myst_syscall_tgkill(int tgid, int tid, int sig)
     long ret = 0;
     myst_thread_t* thread = myst_thread_self();
     myst_thread_t* target = myst_find_thread(tid);
-    siginfo_t* siginfo;
+    siginfo_t siginfo = {0};
 
     if (target == NULL)
         ERAISE(-ESRCH);
@@ -6613,12 +7201,9 @@ long myst_syscall_tgkill(int tgid, int tid, int sig)
     if (tgid != thread->process->pid)
         ERAISE(-EINVAL);
 
-    if (!(siginfo = calloc(1, sizeof(siginfo_t))))
-        ERAISE(-ENOMEM);
-
-    siginfo->si_code = SI_TKILL;
-    siginfo->si_signo = sig;
-    myst_signal_deliver(target, sig, siginfo);
+    siginfo.si_code = SI_TKILL;
+    siginfo.si_signo = sig;
+    myst_signal_queue(target, sig, &siginfo);
 
 done:
     return ret;
@@ -6644,17 +7229,14 @@ long myst_syscall_kill(int pid, int sig)
         goto done;
 
     // Deliver signal
-    siginfo_t* siginfo;
-
-    if (!(siginfo = calloc(1, sizeof(siginfo_t))))
-        ERAISE(-ENOMEM);
+    siginfo_t siginfo = {0};
 
-    siginfo->si_code = SI_USER;
-    siginfo->si_signo = sig;
-    siginfo->si_pid = thread->process->pid;
-    siginfo->si_uid = thread->euid;
+    siginfo.si_code = SI_USER;
+    siginfo.si_signo = sig;
+    siginfo.si_pid = thread->process->pid;
+    siginfo.si_uid = thread->euid;
 
-    ret = myst_signal_deliver(process->main_process_thread, sig, siginfo);
+    ret = myst_signal_queue(process->main_process_thread, sig, &siginfo);
 
 done:
     myst_spin_unlock(&myst_process_list_lock);
@@ -0,0 +1,264 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <myst/eraise.h>
+#include <myst/file.h>
+#include <myst/fs.h>
+#include <myst/hostfile.h>
+#include <myst/mount.h>
+#include <myst/numa.h>
+#include <myst/printf.h>
+#include <myst/ramfs.h>
+#include <myst/strings.h>
+#include <myst/sysfs.h>
+
+/*
+**==============================================================================
+**
+** sysfs
+**
+** Exposes the CPU and NUMA topology under /sys/devices/system as the host
+** reported it during boot (libnuma, OpenMP runtimes and the JVM read these
+** files). The files are read from the host once, during setup.
+**
+**==============================================================================
+*/
+
+#define SYSFS_PATH_MAX 128
+
+typedef struct entry
+{
+    struct entry* next;
+    char* path; /* relative to the mount point */
+    char* data;
+    size_t size;
+} entry_t;
+
+static myst_fs_t* _sysfs;
+static entry_t* _entries;
+
+static const char* _cpu_files[] = {
+    "online",
+    "possible",
+    "present",
+};
+
+static const char* _node_files[] = {
+    "possible",
+    "has_cpu",
+    "has_memory",
+    "has_normal_memory",
+};
+
+static const char* _node_n_files[] = {
+    "cpulist",
+    "cpumap",
+    "distance",
+};
+
+static entry_t* _find(const char* path)
+{
+    while (*path == '/')
+        path++;
+
+    for (entry_t* e = _entries; e; e = e->next)
+    {
+        if (strcmp(e->path, path) == 0)
+            return e;
+    }
+
+    return NULL;
+}
+
+static int _vcallback(
+    myst_file_t* self,
+    myst_buf_t* vbuf,
+    const char* entrypath)
+{
+    int ret = 0;
+    entry_t* e;
+
+    (void)self;
+
+    if (!vbuf || !entrypath)
+        ERAISE(-EINVAL);
+
+    if (!(e = _find(entrypath)))
+        ERAISE(-ENOENT);
+
+    myst_buf_clear(vbuf);
+    ECHECK(myst_buf_append(vbuf, e->data, e->size));
+
+done:
+    return ret;
+}
+
+/* add a file with the given data, or with the data of the host file */
+static int _add_file(const char* path, const char* data)
+{
+    int ret = 0;
+    entry_t* e = NULL;
+    char buf[SYSFS_PATH_MAX];
+    char* p;
+
+    if (!(e = calloc(1, sizeof(entry_t))))
+        ERAISE(-ENOMEM);
+
+    if (!(e->path = strdup(path)))
+        ERAISE(-ENOMEM);
+
+    if (data)
+    {
+        if (!(e->data = strdup(data)))
+            ERAISE(-ENOMEM);
+
+        e->size = strlen(data);
+    }
+    else
+    {
+        void* host_data;
+
+        ECHECK(myst_snprintf(buf, sizeof(buf), "/sys/%s", path));
+        ECHECK(myst_load_host_file(buf, &host_data, &e->size));
+        e->data = host_data;
+    }
+
+    /* create the parent directory */
+    ECHECK(myst_snprintf(buf, sizeof(buf), "/sys/%s", path));
+
+    if ((p = strrchr(buf, '/')))
+        *p = '\0';
+
+    ECHECK(myst_mkdirhier(buf, 0777));
+
+    {
+        myst_vcallback_t v_cb = {0};
+        v_cb.open_cb = _vcallback;
+
+        ECHECK(myst_snprintf(buf, sizeof(buf), "/%s", path));
+        ECHECK(myst_create_virtual_file(
+            _sysfs, buf, S_IFREG | S_IRUSR | S_IRGRP | S_IROTH, v_cb));
+    }
+
+    e->next = _entries;
+    _entries = e;
+    e = NULL;
+
+done:
+
+    if (e)
+    {
+        free(e->path);
+        free(e->data);
+        free(e);
+    }
+
+    return ret;
+}
+
+static int _add_host_files(const char* dir, const char* names[], size_t count)
+{
+    int ret = 0;
+    char path[SYSFS_PATH_MAX];
+
+    for (size_t i = 0; i < count; i++)
+    {
+        ECHECK(myst_snprintf(path, sizeof(path), "%s/%s", dir, names[i]));
+
+        /* not every kernel has every file */
+        _add_file(path, NULL);
+    }
+
+done:
+    return ret;
+}
+
+int sysfs_setup(void)
+{
+    int ret = 0;
+    const uint64_t nodes = myst_numa_online_nodes();
+    char dir[SYSFS_PATH_MAX];
+
+    if (myst_init_ramfs(myst_mount_resolve, &_sysfs) != 0)
+    {
+        myst_eprintf("failed initialize the sys file system\n");
+        ERAISE(-EINVAL);
+    }
+
+    ECHECK(set_overrides_for_special_fs(_sysfs));
+
+    if (myst_mkdirhier("/sys", 0777) != 0)
+    {
+        myst_eprintf("cannot create mount point for sysfs\n");
+        ERAISE(-EINVAL);
+    }
+
+    if (myst_mount(_sysfs, "/", "/sys", false) != 0)
+    {
+        myst_eprintf("cannot mount sys file system\n");
+        ERAISE(-EINVAL);
+    }
+
+    ECHECK(_add_host_files(
+        "devices/system/cpu", _cpu_files, MYST_COUNTOF(_cpu_files)));
+
+    /* hosts without NUMA support have no node directory: present a single
+     * node that has all the CPUs */
+    if (_add_file("devices/system/node/online", NULL) != 0)
+    {
+        entry_t* cpus = _find("devices/system/cpu/online");
+
+        ECHECK(_add_file("devices/system/node/online", "0\n"));
+        ECHECK(_add_file("devices/system/node/possible", "0\n"));
+
+        if (cpus)
+            ECHECK(_add_file("devices/system/node/node0/cpulist", cpus->data));
+
+        goto done;
+    }
+
+    ECHECK(_add_host_files(
+        "devices/system/node", _node_files, MYST_COUNTOF(_node_files)));
+
+    for (unsigned node = 0; node < MYST_NUMA_MAX_NODES; node++)
+    {
+        if (!(nodes & (1UL << node)))
+            continue;
+
+        ECHECK(myst_snprintf(
+            dir, sizeof(dir), "devices/system/node/node%u", node));
+
+        ECHECK(
+            _add_host_files(dir, _node_n_files, MYST_COUNTOF(_node_n_files)));
+    }
+
+done:
+    return ret;
+}
+
+int sysfs_teardown(void)
+{
+    if ((*_sysfs->fs_release)(_sysfs) != 0)
+    {
+        myst_eprintf("failed to release sysfs\n");
+        return -1;
+    }
+
+    for (entry_t* e = _entries; e;)
+    {
+        entry_t* next = e->next;
+        free(e->path);
+        free(e->data);
+        free(e);
+        e = next;
+    }
+
+    _entries = NULL;
+
+    return 0;
+}
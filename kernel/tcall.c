@@ -235,6 +235,31 @@ int myst_tcall_mprotect(void* addr, size_t len, int prot)
     return myst_tcall(SYS_mprotect, params);
 }
 
+int myst_tcall_madvise(void* addr, size_t len, int advice)
+{
+    long params[6] = {(long)addr, (long)len, (long)advice};
+    return myst_tcall(SYS_madvise, params);
+}
+
+long myst_tcall_membarrier(int cmd, unsigned int flags)
+{
+    long params[6] = {cmd, flags};
+    return myst_tcall(SYS_membarrier, params);
+}
+
+long myst_tcall_mbind(
+    void* addr,
+    size_t len,
+    int mode,
+    uint64_t nodemask,
+    unsigned long maxnode,
+    unsigned int flags)
+{
+    long params[6] = {
+        (long)addr, (long)len, mode, (long)&nodemask, (long)maxnode, flags};
+    return myst_tcall(SYS_mbind, params);
+}
+
 #ifdef MYST_ENABLE_GCOV
 long myst_gcov(const char* func, long gcov_params[6])
 {
@@ -279,6 +304,18 @@ long myst_tcall_write(int fd, const void* buf, size_t count)
     return myst_tcall(SYS_write, params);
 }
 
+long myst_tcall_readv(int fd, const struct iovec* iov, int iovcnt)
+{
+    long params[6] = {fd, (long)iov, iovcnt};
+    return myst_tcall(SYS_readv, params);
+}
+
+long myst_tcall_writev(int fd, const struct iovec* iov, int iovcnt)
+{
+    long params[6] = {fd, (long)iov, iovcnt};
+    return myst_tcall(SYS_writev, params);
+}
+
 long myst_tcall_pipe2(int pipefd[2], int flags)
 {
     long params[6] = {(long)pipefd, flags};
@@ -356,6 +393,26 @@ ssize_t myst_tcall_recvmsg(int sockfd, struct msghdr* msg, int flags)
     return myst_tcall(SYS_recvmsg, params);
 }
 
+long myst_tcall_sendmmsg(
+    int sockfd,
+    struct mmsghdr* msgvec,
+    unsigned int vlen,
+    int flags)
+{
+    long params[6] = {(long)sockfd, (long)msgvec, (long)vlen, (long)flags};
+    return myst_tcall(SYS_sendmmsg, params);
+}
+
+long myst_tcall_recvmmsg(
+    int sockfd,
+    struct mmsghdr* msgvec,
+    unsigned int vlen,
+    int flags)
+{
+    long params[6] = {(long)sockfd, (long)msgvec, (long)vlen, (long)flags};
+    return myst_tcall(SYS_recvmmsg, params);
+}
+
 long myst_tcall_read_block(int fd, void* buf, size_t count)
 {
     long params[6] = {fd, (long)buf, count};
@@ -368,6 +425,18 @@ long myst_tcall_write_block(int fd, const void* buf, size_t count)
     return myst_tcall(MYST_TCALL_WRITE_BLOCK, params);
 }
 
+long myst_tcall_readv_block(int fd, const struct iovec* iov, int iovcnt)
+{
+    long params[6] = {fd, (long)iov, iovcnt};
+    return myst_tcall(MYST_TCALL_READV_BLOCK, params);
+}
+
+long myst_tcall_writev_block(int fd, const struct iovec* iov, int iovcnt)
+{
+    long params[6] = {fd, (long)iov, iovcnt};
+    return myst_tcall(MYST_TCALL_WRITEV_BLOCK, params);
+}
+
 int myst_tcall_accept4_block(
     int sockfd,
     struct sockaddr* addr,
@@ -435,3 +504,23 @@ ssize_t myst_tcall_recvmsg_block(int sockfd, struct msghdr* msg, int flags)
     long params[6] = {(long)sockfd, (long)msg, (long)flags};
     return myst_tcall(MYST_TCALL_RECVMSG_BLOCK, params);
 }
+
+long myst_tcall_sendmmsg_block(
+    int sockfd,
+    struct mmsghdr* msgvec,
+    unsigned int vlen,
+    int flags)
+{
+    long params[6] = {(long)sockfd, (long)msgvec, (long)vlen, (long)flags};
+    return myst_tcall(MYST_TCALL_SENDMMSG_BLOCK, params);
+}
+
+long myst_tcall_recvmmsg_block(
+    int sockfd,
+    struct mmsghdr* msgvec,
+    unsigned int vlen,
+    int flags)
+{
+    long params[6] = {(long)sockfd, (long)msgvec, (long)vlen, (long)flags};
+    return myst_tcall(MYST_TCALL_RECVMMSG_BLOCK, params);
+}
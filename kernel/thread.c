@@ -8,6 +8,7 @@
 #include <string.h>
 #include <sys/wait.h>
 
+#include <myst/aio.h>
 #include <myst/assume.h>
 #include <myst/atexit.h>
 #include <myst/atomic.h>
@@ -26,6 +27,7 @@
 #include <myst/panic.h>
 #include <myst/printf.h>
 #include <myst/procfs.h>
+#include <myst/rseq.h>
 #include <myst/setjmp.h>
 #include <myst/signal.h>
 #include <myst/spinlock.h>
@@ -280,17 +282,14 @@ void send_sigchld_to_parent(myst_process_t* process)
     if (parent == NULL) // should not happen
         return;
 
-    siginfo_t* siginfo;
+    siginfo_t siginfo = {0};
 
-    if (!(siginfo = calloc(1, sizeof(siginfo_t))))
-        return;
-
-    siginfo->si_code = SI_USER;
-    siginfo->si_signo = SIGCHLD;
-    siginfo->si_pid = process->pid;
-    siginfo->si_uid = process->main_process_thread->euid;
+    siginfo.si_code = SI_USER;
+    siginfo.si_signo = SIGCHLD;
+    siginfo.si_pid = process->pid;
+    siginfo.si_uid = process->main_process_thread->euid;
 
-    myst_signal_deliver(parent->main_process_thread, SIGCHLD, siginfo);
+    myst_signal_queue(parent->main_process_thread, SIGCHLD, &siginfo);
 }
 
 void myst_zombify_process(myst_process_t* process)
@@ -987,6 +986,16 @@ static long _run_thread(void* arg_)
             thread->exit_kstack = NULL;
         }
 
+        /* release the kernel stack cached across system calls */
+        if (thread->cached_kstack)
+        {
+            myst_put_kstack(thread->cached_kstack);
+            thread->cached_kstack = NULL;
+        }
+
+        /* give the rseq CPU id back to the process */
+        myst_rseq_release(thread);
+
         // Release the kernel stack that were set by SYS_execve.
         if (thread->exec_kstack)
         {
@@ -1013,8 +1022,13 @@ static long _run_thread(void* arg_)
                 }
             }
 
+            /* stop the timers before they can signal the exiting process */
+            myst_itimer_free(process);
+
             myst_signal_free(process);
 
+            myst_aio_free(process);
+
             /* Send SIGHUP to all our children */
             myst_send_sighup_child_processes(process);
 
@@ -1057,9 +1071,6 @@ static long _run_thread(void* arg_)
                 process->fdtable = NULL;
             }
 
-            if (process->itimer)
-                free(process->itimer);
-
             /* Only need to zombify the process thread.
             ATTN: referencing "process" after zombification is not safe,
             parent might have cleaned it up */
@@ -1238,6 +1249,9 @@ static long _syscall_clone(
         new_thread->clone.ctid = ctid;
         new_thread->pause_futex = 0;
 
+        /* the memory policy is inherited by child threads */
+        new_thread->mempolicy = current_thread->mempolicy;
+
         ECHECK(_get_entry_stack(new_thread));
 
         /* generate a thread id for this new thread and return on success*/
@@ -1347,6 +1361,12 @@ static long _syscall_clone_vfork(
         if (myst_signal_clone(parent_thread, child_thread) != 0)
             ERAISE(-ENOMEM);
 
+        /* the memory policy is inherited by child processes */
+        child_thread->mempolicy = parent_thread->mempolicy;
+
+        /* so is the rseq registration (the area is at the same address) */
+        myst_rseq_fork(parent_thread, child_thread);
+
         /* save the clone() arguments */
         child_thread->clone.fn = fn;
         child_thread->clone.child_stack = child_stack;
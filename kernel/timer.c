@@ -0,0 +1,613 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include <myst/clock.h>
+#include <myst/eraise.h>
+#include <myst/process.h>
+#include <myst/signal.h>
+#include <myst/spinlock.h>
+#include <myst/syscall.h>
+#include <myst/tcall.h>
+#include <myst/thread.h>
+#include <myst/timer.h>
+
+/*
+**==============================================================================
+**
+** Hierarchical timer wheel:
+**
+** The wheel has NUM_LEVELS levels of LEVEL_SIZE slots. A timer that expires
+** within LEVEL_SIZE^(L+1) ticks is kept on level L, in the slot given by bits
+** [LEVEL_BITS*L, LEVEL_BITS*(L+1)) of its expiration tick, so arming and
+** disarming take constant time. Whenever the lower bits of the current tick
+** wrap around, the next slot of the level above is cascaded: its timers are
+** re-inserted, which moves them at least one level down. Timers that are too
+** far out for the wheel wait on the top level and are cascaded until they fit.
+**
+** Each level has a bitmap of its non-empty slots, which lets the ticker find
+** the next tick that has work to do and sleep until then.
+**
+**==============================================================================
+*/
+
+#define LEVEL_BITS 6
+#define LEVEL_SIZE (1UL << LEVEL_BITS)
+#define LEVEL_MASK (LEVEL_SIZE - 1)
+#define NUM_LEVELS 4
+#define NUM_SLOTS (NUM_LEVELS * LEVEL_SIZE)
+#define MAX_DELTA ((1UL << (LEVEL_BITS * NUM_LEVELS)) - 1)
+
+/* the extra slot for the timers that are due */
+#define EXPIRED_SLOT NUM_SLOTS
+
+/* expirations are capped to about 146 years from now */
+#define MAX_NSEC ((uint64_t)1 << 62)
+
+static myst_spinlock_t _lock = MYST_SPINLOCK_INITIALIZER;
+static myst_timer_t* _slots[NUM_SLOTS + 1];
+static uint64_t _bitmaps[NUM_LEVELS];
+
+/* the timers expiring up to this tick have been collected */
+static uint64_t _tick;
+
+/* Every process that arms a timer gets a ticker thread of its own from its
+ * CRT, so that timers never outlive the tickers: a process that exits only
+ * takes its own ticker with it. One ticker runs the wheel at a time and the
+ * others stand by until it goes away (see myst_syscall_run_timers()). The
+ * standby tickers cost a thread each but never wake up on their own.
+ */
+typedef struct ticker
+{
+    struct ticker* next;
+    myst_thread_t* thread;
+} ticker_t;
+
+/* the registered tickers */
+static ticker_t* _tickers;
+
+/* the ticker running the wheel (null if there is none) */
+static myst_thread_t* _ticker;
+
+/* the tick at which the ticker wakes up next */
+static uint64_t _wakeup_tick = UINT64_MAX;
+
+/* the timer whose callback is running (with the lock released) */
+static myst_timer_t* volatile _running;
+
+uint64_t myst_timer_now(void)
+{
+    struct timespec ts;
+
+    if (myst_vdso_clock_gettime(CLOCK_MONOTONIC, &ts) != 0)
+        return 0;
+
+    return (uint64_t)ts.tv_sec * NANO_IN_SECOND + (uint64_t)ts.tv_nsec;
+}
+
+/* round up so that timers never fire early */
+static uint64_t _to_tick(uint64_t nsec)
+{
+    return (nsec + MYST_TIMER_TICK_NSEC - 1) / MYST_TIMER_TICK_NSEC;
+}
+
+static void _link(myst_timer_t* timer, size_t slot)
+{
+    myst_timer_t** head = &_slots[slot];
+
+    timer->prev = NULL;
+    timer->next = *head;
+
+    if (*head)
+        (*head)->prev = timer;
+
+    *head = timer;
+    timer->slot = (int)slot;
+
+    if (slot < NUM_SLOTS)
+        _bitmaps[slot / LEVEL_SIZE] |= 1UL << (slot % LEVEL_SIZE);
+}
+
+static void _unlink(myst_timer_t* timer)
+{
+    const size_t slot = (size_t)timer->slot;
+
+    if (timer->prev)
+        timer->prev->next = timer->next;
+    else
+        _slots[slot] = timer->next;
+
+    if (timer->next)
+        timer->next->prev = timer->prev;
+
+    if (!_slots[slot] && slot < NUM_SLOTS)
+        _bitmaps[slot / LEVEL_SIZE] &= ~(1UL << (slot % LEVEL_SIZE));
+
+    timer->prev = NULL;
+    timer->next = NULL;
+    timer->slot = -1;
+}
+
+static void _insert(myst_timer_t* timer)
+{
+    uint64_t tick = _to_tick(timer->expires);
+    uint64_t delta;
+    size_t level = 0;
+    size_t index;
+
+    if (tick <= _tick)
+    {
+        _link(timer, EXPIRED_SLOT);
+        return;
+    }
+
+    if ((delta = tick - _tick) > MAX_DELTA)
+    {
+        tick = _tick + MAX_DELTA;
+        delta = MAX_DELTA;
+    }
+
+    while (delta >> (LEVEL_BITS * (level + 1)))
+        level++;
+
+    index = (tick >> (LEVEL_BITS * level)) & LEVEL_MASK;
+    _link(timer, level * LEVEL_SIZE + index);
+}
+
+/* re-insert the timers of the upper level slots whose turn has come */
+static void _cascade(void)
+{
+    for (size_t level = 1; level < NUM_LEVELS; level++)
+    {
+        const size_t shift = LEVEL_BITS * level;
+        size_t slot;
+        myst_timer_t* timer;
+
+        /* stop at the first level whose lower bits did not wrap */
+        if (_tick & ((1UL << shift) - 1))
+            break;
+
+        slot = level * LEVEL_SIZE + ((_tick >> shift) & LEVEL_MASK);
+
+        while ((timer = _slots[slot]))
+        {
+            _unlink(timer);
+            _insert(timer);
+        }
+    }
+}
+
+/* move the timers that expire up to the given tick to the expired slot */
+static void _advance(uint64_t tick)
+{
+    while (_tick < tick)
+    {
+        myst_timer_t* timer;
+        size_t slot;
+
+        if (!(_bitmaps[0] | _bitmaps[1] | _bitmaps[2] | _bitmaps[3]))
+        {
+            _tick = tick;
+            break;
+        }
+
+        /* if level zero is empty, skip to its next wrap around */
+        if (!_bitmaps[0])
+        {
+            const uint64_t last = _tick | LEVEL_MASK;
+
+            if (last >= tick)
+            {
+                _tick = tick;
+                break;
+            }
+
+            _tick = last;
+        }
+
+        _tick++;
+
+        if ((_tick & LEVEL_MASK) == 0)
+            _cascade();
+
+        slot = _tick & LEVEL_MASK;
+
+        while ((timer = _slots[slot]))
+        {
+            _unlink(timer);
+            _link(timer, EXPIRED_SLOT);
+        }
+    }
+}
+
+/* get the next tick that has work to do (UINT64_MAX if none) */
+static uint64_t _next_tick(void)
+{
+    uint64_t next = UINT64_MAX;
+
+    if (_slots[EXPIRED_SLOT])
+        return _tick;
+
+    for (size_t level = 0; level < NUM_LEVELS; level++)
+    {
+        const size_t shift = LEVEL_BITS * level;
+        const uint64_t bitmap = _bitmaps[level];
+        uint64_t base;
+        uint64_t rotated;
+        uint64_t tick;
+        size_t r;
+
+        if (!bitmap)
+            continue;
+
+        /* find the first non-empty slot after the current one */
+        base = (_tick >> shift) + 1;
+        r = base & LEVEL_MASK;
+        rotated = r ? (bitmap >> r) | (bitmap << (LEVEL_SIZE - r)) : bitmap;
+        tick = (base + (uint64_t)__builtin_ctzl(rotated)) << shift;
+
+        if (tick < next)
+            next = tick;
+    }
+
+    return next;
+}
+
+void myst_timer_init(
+    myst_timer_t* timer,
+    myst_timer_callback_t callback,
+    void* arg)
+{
+    memset(timer, 0, sizeof(myst_timer_t));
+    timer->slot = -1;
+    timer->callback = callback;
+    timer->arg = arg;
+}
+
+void myst_timer_set(myst_timer_t* timer, uint64_t expires, uint64_t interval)
+{
+    myst_spin_lock(&_lock);
+
+    while (_running == timer)
+    {
+        myst_spin_unlock(&_lock);
+        __asm__ __volatile__("pause" : : : "memory");
+        myst_spin_lock(&_lock);
+    }
+
+    if (timer->slot != -1)
+        _unlink(timer);
+
+    timer->expires = expires;
+    timer->interval = expires ? interval : 0;
+
+    if (expires)
+    {
+        uint64_t tick;
+
+        if (_tick == 0)
+            _tick = myst_timer_now() / MYST_TIMER_TICK_NSEC;
+
+        _insert(timer);
+
+        tick = (timer->slot == EXPIRED_SLOT) ? _tick : _to_tick(expires);
+
+        /* wake the ticker if the timer expires before it would wake up */
+        if (_ticker && tick < _wakeup_tick)
+        {
+            _wakeup_tick = tick;
+            myst_tcall_wake(_ticker->event);
+        }
+    }
+
+    myst_spin_unlock(&_lock);
+}
+
+void myst_timer_get(
+    myst_timer_t* timer,
+    uint64_t* remaining,
+    uint64_t* interval)
+{
+    const uint64_t now = myst_timer_now();
+    uint64_t expires;
+
+    myst_spin_lock(&_lock);
+    expires = timer->expires;
+    *interval = timer->interval;
+    myst_spin_unlock(&_lock);
+
+    if (expires == 0)
+        *remaining = 0;
+    else if (expires > now)
+        *remaining = expires - now;
+    else
+        *remaining = 1; /* due but not fired yet */
+}
+
+int myst_timer_check_clock(clockid_t clockid)
+{
+    switch (clockid)
+    {
+        case CLOCK_REALTIME:
+        case CLOCK_MONOTONIC:
+        case CLOCK_BOOTTIME:
+        case CLOCK_REALTIME_ALARM:
+        case CLOCK_BOOTTIME_ALARM:
+            return 0;
+        default:
+            return -EINVAL;
+    }
+}
+
+static int _timespec_to_nsec(const struct timespec* ts, uint64_t* nsec)
+{
+    if (ts->tv_sec < 0 || ts->tv_nsec < 0 || ts->tv_nsec >= NANO_IN_SECOND)
+        return -EINVAL;
+
+    if ((uint64_t)ts->tv_sec >= MAX_NSEC / NANO_IN_SECOND)
+        *nsec = MAX_NSEC;
+    else
+        *nsec = (uint64_t)ts->tv_sec * NANO_IN_SECOND + (uint64_t)ts->tv_nsec;
+
+    return 0;
+}
+
+static void _nsec_to_timespec(uint64_t nsec, struct timespec* ts)
+{
+    ts->tv_sec = (time_t)(nsec / NANO_IN_SECOND);
+    ts->tv_nsec = (long)(nsec % NANO_IN_SECOND);
+}
+
+int myst_timer_settime(
+    myst_timer_t* timer,
+    clockid_t clockid,
+    bool abstime,
+    const struct itimerspec* new_value,
+    struct itimerspec* old_value)
+{
+    int ret = 0;
+    uint64_t value;
+    uint64_t interval;
+    uint64_t expires = 0;
+
+    ECHECK(_timespec_to_nsec(&new_value->it_value, &value));
+    ECHECK(_timespec_to_nsec(&new_value->it_interval, &interval));
+
+    if (old_value)
+        myst_timer_gettime(timer, old_value);
+
+    if (value)
+    {
+        const uint64_t now = myst_timer_now();
+
+        if (!abstime)
+        {
+            expires = now + value;
+        }
+        else if (clockid == CLOCK_REALTIME || clockid == CLOCK_REALTIME_ALARM)
+        {
+            struct timespec ts;
+            uint64_t realtime;
+
+            /* the wheel runs on the monotonic clock: convert once */
+            ECHECK(myst_vdso_clock_gettime(CLOCK_REALTIME, &ts));
+            ECHECK(_timespec_to_nsec(&ts, &realtime));
+            expires = (value > realtime) ? now + (value - realtime) : now;
+        }
+        else
+        {
+            expires = value;
+        }
+
+        /* zero would disarm the timer */
+        if (expires == 0)
+            expires = 1;
+    }
+
+    myst_timer_set(timer, expires, interval);
+
+done:
+    return ret;
+}
+
+void myst_timer_gettime(myst_timer_t* timer, struct itimerspec* curr_value)
+{
+    uint64_t remaining;
+    uint64_t interval;
+
+    myst_timer_get(timer, &remaining, &interval);
+    _nsec_to_timespec(remaining, &curr_value->it_value);
+    _nsec_to_timespec(interval, &curr_value->it_interval);
+}
+
+/* find the ticker of the given process (the caller holds the lock) */
+static ticker_t* _find_ticker(myst_process_t* process)
+{
+    for (ticker_t* p = _tickers; p; p = p->next)
+    {
+        if (p->thread->process == process)
+            return p;
+    }
+
+    return NULL;
+}
+
+int myst_timer_request_ticker(void)
+{
+    myst_process_t* process = myst_process_self();
+
+    for (;;)
+    {
+        myst_spin_lock(&_lock);
+
+        if (_find_ticker(process))
+        {
+            myst_spin_unlock(&_lock);
+            return 0;
+        }
+
+        if (!process->ticker_requested)
+        {
+            process->ticker_requested = true;
+            myst_spin_unlock(&_lock);
+            return -MYST_ENEEDTHREADS;
+        }
+
+        myst_spin_unlock(&_lock);
+
+        /* wait for the ticker requested by another thread */
+        __asm__ __volatile__("pause" : : : "memory");
+    }
+}
+
+/* run the callbacks of the expired timers (the caller holds the lock) */
+static void _expire(uint64_t now)
+{
+    myst_timer_t* timer;
+
+    while ((timer = _slots[EXPIRED_SLOT]))
+    {
+        uint64_t n = 1;
+
+        _unlink(timer);
+
+        if (timer->interval)
+        {
+            /* account for the periods missed since the expiration */
+            if (now > timer->expires)
+                n += (now - timer->expires) / timer->interval;
+
+            timer->expires += n * timer->interval;
+            _insert(timer);
+        }
+        else
+        {
+            timer->expires = 0;
+        }
+
+        _running = timer;
+        myst_spin_unlock(&_lock);
+
+        (*timer->callback)(timer, n);
+
+        myst_spin_lock(&_lock);
+        _running = NULL;
+    }
+}
+
+/* remove a ticker and hand the wheel over (the caller holds the lock) */
+static void _remove_ticker(ticker_t* ticker)
+{
+    for (ticker_t** p = &_tickers; *p; p = &(*p)->next)
+    {
+        if (*p == ticker)
+        {
+            *p = ticker->next;
+            break;
+        }
+    }
+
+    ticker->thread->process->ticker_requested = false;
+
+    if (_ticker == ticker->thread)
+    {
+        _ticker = NULL;
+        _wakeup_tick = UINT64_MAX;
+
+        /* wake a ticker that stands by (of another process) to take over */
+        if (_tickers)
+            myst_tcall_wake(_tickers->thread->event);
+    }
+}
+
+long myst_syscall_run_timers(void)
+{
+    myst_thread_t* self = myst_thread_self();
+    ticker_t ticker = {NULL, self};
+
+    myst_spin_lock(&_lock);
+
+    /* the CRT may have been asked for a ticker more than once */
+    if (_find_ticker(self->process))
+    {
+        myst_spin_unlock(&_lock);
+        return 0;
+    }
+
+    ticker.next = _tickers;
+    _tickers = &ticker;
+    self->process->ticker_requested = true;
+
+    for (;;)
+    {
+        struct timespec buf;
+        struct timespec* timeout = NULL;
+
+        if (!_ticker)
+            _ticker = self;
+
+        /* the tickers that stand by sleep until they are woken */
+        if (_ticker == self)
+        {
+            uint64_t now = myst_timer_now();
+
+            if (_tick == 0)
+                _tick = now / MYST_TIMER_TICK_NSEC;
+
+            _advance(now / MYST_TIMER_TICK_NSEC);
+            _expire(now);
+
+            if ((_wakeup_tick = _next_tick()) != UINT64_MAX)
+            {
+                const uint64_t wakeup = _wakeup_tick * MYST_TIMER_TICK_NSEC;
+
+                now = myst_timer_now();
+                _nsec_to_timespec(wakeup > now ? wakeup - now : 0, &buf);
+                timeout = &buf;
+            }
+        }
+
+        myst_spin_unlock(&_lock);
+        {
+            /* wakeups are not lost: myst_tcall_wake() is sticky */
+            self->signal.waiting_on_event = true;
+            myst_tcall_wait(self->event, timeout);
+            self->signal.waiting_on_event = false;
+
+            if (myst_signal_has_active_signals(self))
+            {
+                /* Stand down while processing the signals, which terminate
+                 * this thread when its process exits. Another ticker takes
+                 * over the wheel meanwhile, and the next timer syscall of
+                 * this process requests a new ticker if this one is gone.
+                 */
+                myst_spin_lock(&_lock);
+                _remove_ticker(&ticker);
+                myst_spin_unlock(&_lock);
+
+                myst_signal_process(self);
+
+                myst_spin_lock(&_lock);
+
+                if (_find_ticker(self->process))
+                {
+                    myst_spin_unlock(&_lock);
+                    return 0;
+                }
+
+                ticker.next = _tickers;
+                _tickers = &ticker;
+                self->process->ticker_requested = true;
+                myst_spin_unlock(&_lock);
+            }
+        }
+        myst_spin_lock(&_lock);
+    }
+
+    /* unreachable */
+    return 0;
+}
@@ -0,0 +1,495 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/timerfd.h>
+
+#include <myst/eraise.h>
+#include <myst/signal.h>
+#include <myst/syscall.h>
+#include <myst/tcall.h>
+#include <myst/thread.h>
+#include <myst/timer.h>
+#include <myst/timerfddev.h>
+
+#define MAGIC 0x71e4fdd0
+
+#ifndef TFD_TIMER_CANCEL_ON_SET
+#define TFD_TIMER_CANCEL_ON_SET (1 << 1)
+#endif
+
+/*
+**==============================================================================
+**
+** A timerfd is backed by a host eventfd: the timer callback adds the number
+** of expirations to the eventfd counter, and read() returns and clears the
+** counter, just like timerfd. This lets poll() and epoll() wait on timerfds
+** along with the other host file descriptors.
+**
+** The host eventfd is always non-blocking (so that it can be drained when the
+** timer is re-armed) and blocking reads are done by polling it.
+**
+**==============================================================================
+*/
+
+/* the timer state shared by the duplicates of a timerfd */
+typedef struct shared
+{
+    _Atomic(size_t) nrefs;
+    clockid_t clockid;
+    int fd; /* the host eventfd signaled by the timer callback */
+    _Atomic(bool) nonblock;
+    myst_timer_t timer;
+} shared_t;
+
+struct myst_timerfd
+{
+    uint32_t magic;
+    int fd; /* the duplicate of the host eventfd for this file descriptor */
+    shared_t* shared;
+};
+
+MYST_INLINE long _sys_eventfd2(unsigned int initval, int flags)
+{
+    long params[6] = {(long)initval, (long)flags};
+    return myst_tcall(SYS_eventfd2, params);
+}
+
+MYST_INLINE bool _valid_timerfd(const myst_timerfd_t* timerfd)
+{
+    return timerfd && timerfd->magic == MAGIC;
+}
+
+static void _callback(myst_timer_t* timer, uint64_t n)
+{
+    shared_t* shared = (shared_t*)timer->arg;
+
+    /* errors (counter overflow) are ignored */
+    myst_tcall_write(shared->fd, &n, sizeof(n));
+}
+
+static int _timerfd_timerfd(
+    myst_timerfddev_t* timerfddev,
+    clockid_t clockid,
+    int flags,
+    myst_timerfd_t** timerfd_out)
+{
+    int ret = 0;
+    myst_timerfd_t* timerfd = NULL;
+    shared_t* shared = NULL;
+    int efd_flags = EFD_NONBLOCK;
+
+    if (!timerfddev || !timerfd_out)
+        ERAISE(-EINVAL);
+
+    if (flags & ~(TFD_NONBLOCK | TFD_CLOEXEC))
+        ERAISE(-EINVAL);
+
+    ECHECK(myst_timer_check_clock(clockid));
+
+    if (flags & TFD_CLOEXEC)
+        efd_flags |= EFD_CLOEXEC;
+
+    if (!(timerfd = calloc(1, sizeof(myst_timerfd_t))))
+        ERAISE(-ENOMEM);
+
+    timerfd->magic = MAGIC;
+    timerfd->fd = -1;
+
+    if (!(shared = calloc(1, sizeof(shared_t))))
+        ERAISE(-ENOMEM);
+
+    shared->nrefs = 1;
+    shared->clockid = clockid;
+    shared->nonblock = (flags & TFD_NONBLOCK);
+    myst_timer_init(&shared->timer, _callback, shared);
+
+    /* create the host eventfd and its duplicate for this file descriptor */
+    ECHECK(shared->fd = _sys_eventfd2(0, efd_flags));
+    ECHECK(timerfd->fd = myst_tcall_dup(shared->fd));
+
+    timerfd->shared = shared;
+    shared = NULL;
+    *timerfd_out = timerfd;
+    timerfd = NULL;
+
+done:
+
+    if (shared)
+    {
+        if (shared->fd >= 0)
+            myst_tcall_close(shared->fd);
+
+        free(shared);
+    }
+
+    if (timerfd)
+        free(timerfd);
+
+    return ret;
+}
+
+static int _timerfd_settime(
+    myst_timerfddev_t* timerfddev,
+    myst_timerfd_t* timerfd,
+    int flags,
+    const struct itimerspec* new_value,
+    struct itimerspec* old_value)
+{
+    int ret = 0;
+    shared_t* shared;
+    uint64_t count;
+
+    if (!timerfddev || !_valid_timerfd(timerfd))
+        ERAISE(-EBADF);
+
+    if (!new_value)
+        ERAISE(-EFAULT);
+
+    /* ATTN: TFD_TIMER_CANCEL_ON_SET is accepted but clock changes are not
+     * reported */
+    if (flags & ~(TFD_TIMER_ABSTIME | TFD_TIMER_CANCEL_ON_SET))
+        ERAISE(-EINVAL);
+
+    shared = timerfd->shared;
+
+    if (old_value)
+        myst_timer_gettime(&shared->timer, old_value);
+
+    /* disarm the timer and discard the expirations of the old setting */
+    myst_timer_set(&shared->timer, 0, 0);
+    myst_tcall_read(shared->fd, &count, sizeof(count));
+
+    ECHECK(myst_timer_settime(
+        &shared->timer,
+        shared->clockid,
+        (flags & TFD_TIMER_ABSTIME),
+        new_value,
+        NULL));
+
+done:
+    return ret;
+}
+
+static int _timerfd_gettime(
+    myst_timerfddev_t* timerfddev,
+    myst_timerfd_t* timerfd,
+    struct itimerspec* curr_value)
+{
+    int ret = 0;
+
+    if (!timerfddev || !_valid_timerfd(timerfd))
+        ERAISE(-EBADF);
+
+    if (!curr_value)
+        ERAISE(-EFAULT);
+
+    myst_timer_gettime(&timerfd->shared->timer, curr_value);
+
+done:
+    return ret;
+}
+
+static ssize_t _timerfd_read(
+    myst_timerfddev_t* timerfddev,
+    myst_timerfd_t* timerfd,
+    void* buf,
+    size_t count)
+{
+    ssize_t ret = 0;
+
+    if (!timerfddev || !_valid_timerfd(timerfd))
+        ERAISE(-EBADF);
+
+    if (!buf || count < sizeof(uint64_t))
+        ERAISE(-EINVAL);
+
+    for (;;)
+    {
+        struct pollfd fds = {.fd = timerfd->fd, .events = POLLIN};
+        ssize_t nread = myst_tcall_read(timerfd->fd, buf, sizeof(uint64_t));
+
+        if (nread != -EAGAIN || timerfd->shared->nonblock)
+        {
+            ECHECK(nread);
+            ret = nread;
+            break;
+        }
+
+        /* wait for the next expiration, checking for signals regularly */
+        ECHECK(myst_tcall_poll(&fds, 1, 500));
+
+        if (myst_signal_has_active_signals(myst_thread_self()))
+            ERAISE(-EINTR);
+    }
+
+done:
+    return ret;
+}
+
+static ssize_t _timerfd_write(
+    myst_timerfddev_t* timerfddev,
+    myst_timerfd_t* timerfd,
+    const void* buf,
+    size_t count)
+{
+    ssize_t ret = 0;
+
+    (void)buf;
+    (void)count;
+
+    if (!timerfddev || !_valid_timerfd(timerfd))
+        ERAISE(-EBADF);
+
+    /* timerfds are not writable */
+    ERAISE(-EINVAL);
+
+done:
+    return ret;
+}
+
+static ssize_t _timerfd_readv(
+    myst_timerfddev_t* timerfddev,
+    myst_timerfd_t* timerfd,
+    const struct iovec* iov,
+    int iovcnt)
+{
+    ssize_t ret = 0;
+
+    if (!timerfddev || !_valid_timerfd(timerfd))
+        ERAISE(-EINVAL);
+
+    ret = myst_fdops_readv(&timerfddev->fdops, timerfd, iov, iovcnt);
+    ECHECK(ret);
+
+done:
+
+    return ret;
+}
+
+static ssize_t _timerfd_writev(
+    myst_timerfddev_t* timerfddev,
+    myst_timerfd_t* timerfd,
+    const struct iovec* iov,
+    int iovcnt)
+{
+    ssize_t ret = 0;
+
+    if (!timerfddev || !_valid_timerfd(timerfd))
+        ERAISE(-EINVAL);
+
+    ret = myst_fdops_writev(&timerfddev->fdops, timerfd, iov, iovcnt);
+    ECHECK(ret);
+
+done:
+
+    return ret;
+}
+
+static int _timerfd_fstat(
+    myst_timerfddev_t* timerfddev,
+    myst_timerfd_t* timerfd,
+    struct stat* statbuf)
+{
+    int ret = 0;
+
+    if (!timerfddev || !_valid_timerfd(timerfd) || !statbuf)
+        ERAISE(-EINVAL);
+
+    ECHECK(myst_tcall_fstat(timerfd->fd, statbuf));
+
+done:
+    return ret;
+}
+
+static int _timerfd_fcntl(
+    myst_timerfddev_t* timerfddev,
+    myst_timerfd_t* timerfd,
+    int cmd,
+    long arg)
+{
+    int ret = 0;
+    long r;
+
+    if (!timerfddev || !_valid_timerfd(timerfd))
+        ERAISE(-EINVAL);
+
+    /* O_NONBLOCK is emulated since the host eventfd is always non-blocking */
+    if (cmd == F_SETFL)
+    {
+        ECHECK((r = myst_tcall_fcntl(timerfd->fd, cmd, arg | O_NONBLOCK)));
+        timerfd->shared->nonblock = (arg & O_NONBLOCK);
+        ret = r;
+        goto done;
+    }
+
+    ECHECK((r = myst_tcall_fcntl(timerfd->fd, cmd, arg)));
+
+    if (cmd == F_GETFL && !timerfd->shared->nonblock)
+        r &= ~O_NONBLOCK;
+
+    ret = r;
+
+done:
+
+    return ret;
+}
+
+static int _timerfd_ioctl(
+    myst_timerfddev_t* timerfddev,
+    myst_timerfd_t* timerfd,
+    unsigned long request,
+    long arg)
+{
+    int ret = 0;
+
+    (void)arg;
+
+    if (!timerfddev || !_valid_timerfd(timerfd))
+        ERAISE(-EBADF);
+
+    if (request == TIOCGWINSZ)
+        ERAISE(-EINVAL);
+
+    ERAISE(-ENOTSUP);
+
+done:
+
+    return ret;
+}
+
+static int _timerfd_dup(
+    myst_timerfddev_t* timerfddev,
+    const myst_timerfd_t* timerfd,
+    myst_timerfd_t** timerfd_out)
+{
+    int ret = 0;
+    myst_timerfd_t* new_timerfd = NULL;
+
+    if (timerfd_out)
+        *timerfd_out = NULL;
+
+    if (!timerfddev || !_valid_timerfd(timerfd) || !timerfd_out)
+        ERAISE(-EINVAL);
+
+    if (!(new_timerfd = calloc(1, sizeof(myst_timerfd_t))))
+        ERAISE(-ENOMEM);
+
+    ECHECK(new_timerfd->fd = myst_tcall_dup(timerfd->fd));
+    new_timerfd->magic = MAGIC;
+    new_timerfd->shared = timerfd->shared;
+    new_timerfd->shared->nrefs++;
+
+    *timerfd_out = new_timerfd;
+    new_timerfd = NULL;
+
+done:
+
+    if (new_timerfd)
+        free(new_timerfd);
+
+    return ret;
+}
+
+static int _timerfd_close(
+    myst_timerfddev_t* timerfddev,
+    myst_timerfd_t* timerfd)
+{
+    int ret = 0;
+    shared_t* shared;
+
+    if (!timerfddev || !_valid_timerfd(timerfd))
+        ERAISE(-EBADF);
+
+    shared = timerfd->shared;
+
+    /* release the timer with the last file descriptor */
+    if (--shared->nrefs == 0)
+    {
+        myst_timer_set(&shared->timer, 0, 0);
+        myst_tcall_close(shared->fd);
+        free(shared);
+    }
+
+    ECHECK(myst_tcall_close(timerfd->fd));
+
+    memset(timerfd, 0, sizeof(myst_timerfd_t));
+    free(timerfd);
+
+done:
+    return ret;
+}
+
+static int _timerfd_target_fd(
+    myst_timerfddev_t* timerfddev,
+    myst_timerfd_t* timerfd)
+{
+    int ret = 0;
+
+    if (!timerfddev || !_valid_timerfd(timerfd))
+        ERAISE(-EINVAL);
+
+    ret = timerfd->fd;
+
+done:
+    return ret;
+}
+
+static int _timerfd_get_events(
+    myst_timerfddev_t* timerfddev,
+    myst_timerfd_t* timerfd)
+{
+    int ret = 0;
+
+    if (!timerfddev || !_valid_timerfd(timerfd))
+        ERAISE(-EINVAL);
+
+    /* poll the host eventfd instead */
+    ret = -ENOTSUP;
+
+done:
+    return ret;
+}
+
+extern myst_timerfddev_t* myst_timerfddev_get(void)
+{
+    // clang-format off
+    static myst_timerfddev_t _timerfddev =
+    {
+        {
+            .fd_read = (void*)_timerfd_read,
+            .fd_write = (void*)_timerfd_write,
+            .fd_readv = (void*)_timerfd_readv,
+            .fd_writev = (void*)_timerfd_writev,
+            .fd_fstat = (void*)_timerfd_fstat,
+            .fd_fcntl = (void*)_timerfd_fcntl,
+            .fd_ioctl = (void*)_timerfd_ioctl,
+            .fd_dup = (void*)_timerfd_dup,
+            .fd_close = (void*)_timerfd_close,
+            .fd_target_fd = (void*)_timerfd_target_fd,
+            .fd_get_events = (void*)_timerfd_get_events,
+        },
+        .timerfd = _timerfd_timerfd,
+        .settime = _timerfd_settime,
+        .gettime = _timerfd_gettime,
+        .read = _timerfd_read,
+        .write = _timerfd_write,
+        .readv = _timerfd_readv,
+        .writev = _timerfd_writev,
+        .fstat = _timerfd_fstat,
+        .fcntl = _timerfd_fcntl,
+        .ioctl = _timerfd_ioctl,
+        .dup = _timerfd_dup,
+        .close = _timerfd_close,
+        .target_fd = _timerfd_target_fd,
+        .get_events = _timerfd_get_events,
+    };
+    // clang-format on
+
+    return &_timerfddev;
+}
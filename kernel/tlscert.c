@@ -3,8 +3,11 @@
 
 #include <assert.h>
 #include <errno.h>
+#include <myst/buf.h>
 #include <myst/eraise.h>
+#include <myst/mutex.h>
 #include <myst/printf.h>
+#include <myst/ramfs.h>
 #include <myst/tcall.h>
 #include <myst/tee.h>
 #include <myst/tlscert.h>
@@ -14,6 +17,150 @@
 #include <stdlib.h>
 #include <string.h>
 
+/*
+**==============================================================================
+**
+** lazy credentials:
+**
+** Generating the credentials (which involves producing an attestation
+** report) is one of the most expensive steps of booting, yet many
+** applications never read them. On RAM file systems, the files are created
+** empty and the credentials are generated when one of them is first used.
+**
+**==============================================================================
+*/
+
+enum
+{
+    CERT,
+    PKEY,
+    REPORT,
+    NUM_CREDENTIALS
+};
+
+static struct
+{
+    myst_mutex_t mutex;
+    bool separate_report;
+    bool generated;
+    myst_buf_t bufs[NUM_CREDENTIALS];
+} _lazy;
+
+/* generate the credentials and copy them into the kernel (caller locks) */
+static int _generate_lazy_credentials(void)
+{
+    int ret = 0;
+    uint8_t* data[NUM_CREDENTIALS] = {NULL};
+    size_t sizes[NUM_CREDENTIALS] = {0};
+
+    if (!_lazy.separate_report)
+    {
+        long params[6] = {(long)&data[CERT],
+                          (long)&sizes[CERT],
+                          (long)&data[PKEY],
+                          (long)&sizes[PKEY]};
+        ECHECK(myst_tcall(MYST_TCALL_GEN_CREDS, params));
+    }
+    else
+    {
+        long params[6] = {(long)&data[CERT],
+                          (long)&sizes[CERT],
+                          (long)&data[PKEY],
+                          (long)&sizes[PKEY],
+                          (long)&data[REPORT],
+                          (long)&sizes[REPORT]};
+        ECHECK(myst_tcall(MYST_TCALL_GEN_CREDS_EX, params));
+    }
+
+    for (size_t i = 0; i < NUM_CREDENTIALS; i++)
+    {
+        if (sizes[i] && myst_buf_append(&_lazy.bufs[i], data[i], sizes[i]))
+            ERAISE(-ENOMEM);
+    }
+
+    _lazy.generated = true;
+
+done:
+
+    if (data[CERT] || data[PKEY] || data[REPORT])
+    {
+        long params[6] = {(long)data[CERT],
+                          (long)sizes[CERT],
+                          (long)data[PKEY],
+                          (long)sizes[PKEY],
+                          (long)data[REPORT],
+                          (long)sizes[REPORT]};
+        myst_tcall(MYST_TCALL_FREE_CREDS, params);
+    }
+
+    if (ret != 0)
+    {
+        for (size_t i = 0; i < NUM_CREDENTIALS; i++)
+            myst_buf_release(&_lazy.bufs[i]);
+    }
+
+    return ret;
+}
+
+static int _fill_credential(void* arg, myst_buf_t* buf)
+{
+    int ret = 0;
+    const size_t which = (size_t)arg;
+
+    myst_mutex_lock(&_lazy.mutex);
+
+    if (!_lazy.generated && (ret = _generate_lazy_credentials()) != 0)
+    {
+        myst_eprintf("kernel: failed to generate TLS credentials: %d\n", ret);
+        ERAISE(ret);
+    }
+
+    /* each file is filled once, so hand over the buffer */
+    *buf = _lazy.bufs[which];
+    memset(&_lazy.bufs[which], 0, sizeof(myst_buf_t));
+
+done:
+    myst_mutex_unlock(&_lazy.mutex);
+    return ret;
+}
+
+static int _create_lazy_tls_credentials(myst_fs_t* fs, bool separate_report)
+{
+    int ret = 0;
+    const char* paths[NUM_CREDENTIALS] = {
+        MYST_CERTIFICATE_PATH,
+        MYST_PRIVATE_KEY_PATH,
+        MYST_ATTESTATION_REPORT_PATH,
+    };
+    const size_t n = separate_report ? NUM_CREDENTIALS : REPORT;
+
+#ifdef USE_TMPFS
+    /* clip the "/tmp" prefix from the paths */
+    for (size_t i = 0; i < NUM_CREDENTIALS; i++)
+    {
+        const char prefix[] = "/tmp";
+        const size_t len = sizeof(prefix) - 1;
+
+        if (strncmp(paths[i], prefix, len) == 0)
+            paths[i] += len;
+    }
+#endif
+
+    _lazy.separate_report = separate_report;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        if ((ret = myst_ramfs_create_lazy_file(
+                 fs, paths[i], 0444, _fill_credential, (void*)i)) != 0)
+        {
+            goto done;
+        }
+    }
+
+done:
+    return ret;
+}
+
 static int _create_tls_credentials(myst_fs_t* fs, bool separate_report)
 {
     int ret = -EINVAL;
@@ -118,6 +265,8 @@ int myst_init_tls_credential_files(
     myst_fstype_t fstype)
 {
     int ret = 0;
+    bool separate_report;
+
     if (want_tls_creds == NULL)
         goto done;
 
@@ -129,11 +278,11 @@ int myst_init_tls_credential_files(
 
     if (strcmp(want_tls_creds, CERT_AND_PEMKEY) == 0)
     {
-        ECHECK(_create_tls_credentials(fs, false));
+        separate_report = false;
     }
     else if (strcmp(want_tls_creds, CERT_PEMKEY_REPORT) == 0)
     {
-        ECHECK(_create_tls_credentials(fs, true));
+        separate_report = true;
     }
     else
     {
@@ -141,6 +290,15 @@ int myst_init_tls_credential_files(
         ERAISE(-EINVAL);
     }
 
+    /* other file systems cannot defer the generation */
+    if ((ret = _create_lazy_tls_credentials(fs, separate_report)) == -ENOTSUP)
+    {
+        ret = 0;
+        ECHECK(_create_tls_credentials(fs, separate_report));
+    }
+
+    ECHECK(ret);
+
 done:
     return ret;
 }
\ No newline at end of file
@@ -678,6 +678,7 @@ long myst_tcall(long n, long params[6])
         case SYS_sethostname:
         case SYS_bind:
         case SYS_sendfile:
+        case SYS_copy_file_range:
         case SYS_accept:
         case SYS_shutdown:
         case SYS_listen:
@@ -700,6 +701,9 @@ long myst_tcall(long n, long params[6])
         case SYS_fstatfs:
         case SYS_lseek:
         case SYS_mprotect:
+        case SYS_madvise:
+        case SYS_membarrier:
+        case SYS_mbind:
         case SYS_sched_setaffinity:
         case SYS_sched_getaffinity:
         case SYS_getcpu:
@@ -715,6 +719,8 @@ long myst_tcall(long n, long params[6])
         case SYS_sendto:
         case SYS_sendmsg:
         case SYS_recvmsg:
+        case SYS_sendmmsg:
+        case SYS_recvmmsg:
         {
             return _forward_syscall(n, x1, x2, x3, x4, x5, x6);
         }
@@ -804,6 +810,24 @@ long myst_tcall(long n, long params[6])
             return myst_interruptible_syscall(
                 SYS_write, fd, POLLOUT, true, fd, buf, count);
         }
+        case MYST_TCALL_READV_BLOCK:
+        {
+            int fd = (int)x1;
+            const struct iovec* iov = (const struct iovec*)x2;
+            int iovcnt = (int)x3;
+
+            return myst_interruptible_syscall(
+                SYS_readv, fd, POLLIN, true, fd, iov, iovcnt);
+        }
+        case MYST_TCALL_WRITEV_BLOCK:
+        {
+            int fd = (int)x1;
+            const struct iovec* iov = (const struct iovec*)x2;
+            int iovcnt = (int)x3;
+
+            return myst_interruptible_syscall(
+                SYS_writev, fd, POLLOUT, true, fd, iov, iovcnt);
+        }
         case MYST_TCALL_CONNECT_BLOCK:
         {
             int sockfd = (int)x1;
@@ -901,6 +925,50 @@ long myst_tcall(long n, long params[6])
             return myst_interruptible_syscall(
                 SYS_recvmsg, sockfd, POLLIN, retry, sockfd, msg, flags);
         }
+        case MYST_TCALL_SENDMMSG_BLOCK:
+        {
+            int sockfd = (int)x1;
+            struct mmsghdr* msgvec = (struct mmsghdr*)x2;
+            unsigned int vlen = (unsigned int)x3;
+            int flags = (int)x4;
+            bool retry = true;
+
+            /* Don't retry EAGAIN|EINPPROGRESS if this flag is present */
+            if ((flags & MSG_DONTWAIT))
+                retry = false;
+
+            return myst_interruptible_syscall(
+                SYS_sendmmsg,
+                sockfd,
+                POLLOUT,
+                retry,
+                sockfd,
+                msgvec,
+                vlen,
+                flags);
+        }
+        case MYST_TCALL_RECVMMSG_BLOCK:
+        {
+            int sockfd = (int)x1;
+            struct mmsghdr* msgvec = (struct mmsghdr*)x2;
+            unsigned int vlen = (unsigned int)x3;
+            int flags = (int)x4;
+            bool retry = true;
+
+            /* Don't retry EAGAIN|EINPPROGRESS if these flags are present */
+            if ((flags & (MSG_ERRQUEUE | MSG_DONTWAIT)))
+                retry = false;
+
+            return myst_interruptible_syscall(
+                SYS_recvmmsg,
+                sockfd,
+                POLLIN,
+                retry,
+                sockfd,
+                msgvec,
+                vlen,
+                flags);
+        }
         default:
         {
             fprintf(stderr, "unhandled tcall: %ld\n", n);
@@ -226,6 +226,14 @@ long myst_tcall_poll_wake(void)
     return -ENOTSUP;
 }
 
+MYST_WEAK
+long myst_tcall_membarrier(int cmd, unsigned int flags)
+{
+    (void)cmd;
+    (void)flags;
+    return -ENOSYS;
+}
+
 static long _tcall_target_stat(myst_target_stat_t* buf)
 {
     long ret = 0;
@@ -625,6 +633,12 @@ long myst_tcall(long n, long params[6])
         case SYS_epoll_wait:
         case SYS_epoll_ctl:
         case SYS_eventfd2:
+        case SYS_sendfile:
+        case SYS_copy_file_range:
+        case SYS_sendmmsg:
+        case SYS_recvmmsg:
+        case SYS_readv:
+        case SYS_writev:
         case MYST_TCALL_ACCEPT4_BLOCK:
         case MYST_TCALL_CONNECT_BLOCK:
         case MYST_TCALL_READ_BLOCK:
@@ -633,6 +647,10 @@ long myst_tcall(long n, long params[6])
         case MYST_TCALL_RECVFROM_BLOCK:
         case MYST_TCALL_SENDMSG_BLOCK:
         case MYST_TCALL_RECVMSG_BLOCK:
+        case MYST_TCALL_SENDMMSG_BLOCK:
+        case MYST_TCALL_RECVMMSG_BLOCK:
+        case MYST_TCALL_READV_BLOCK:
+        case MYST_TCALL_WRITEV_BLOCK:
         {
             extern long myst_handle_tcall(long n, long params[6]);
             return myst_handle_tcall(n, params);
@@ -807,6 +825,20 @@ long myst_tcall(long n, long params[6])
             extern const void* __oe_get_enclave_base_address(void);
             return (long)__oe_get_enclave_base_address();
         }
+        case SYS_madvise:
+        {
+            /* enclave pages cannot be handed back to the host */
+            return -ENOTSUP;
+        }
+        case SYS_membarrier:
+        {
+            return myst_tcall_membarrier((int)x1, (unsigned int)x2);
+        }
+        case SYS_mbind:
+        {
+            /* EPC pages are not subject to host memory policies */
+            return -ENOTSUP;
+        }
         default:
         {
             printf("error: tcall=%ld\n", n);
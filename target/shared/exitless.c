@@ -0,0 +1,199 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <errno.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sys/syscall.h>
+
+#include <myst/exitless.h>
+#include <myst/tcall.h>
+
+/* slot search hint so concurrent callers start at different slots */
+static __thread uint32_t _hint;
+
+uint32_t myst_exitless_class(long n)
+{
+    switch (n)
+    {
+        /* read() and write() are issued for both host files and sockets */
+        case SYS_read:
+        case SYS_write:
+            return MYST_EXITLESS_FILES | MYST_EXITLESS_SOCKETS;
+        case SYS_pread64:
+        case SYS_pwrite64:
+        case SYS_lseek:
+        case SYS_fstat:
+        case SYS_fsync:
+        case SYS_fdatasync:
+        case SYS_ftruncate:
+        case SYS_close:
+            return MYST_EXITLESS_FILES;
+        case SYS_sendto:
+        case SYS_recvfrom:
+        case SYS_shutdown:
+        case SYS_listen:
+            return MYST_EXITLESS_SOCKETS;
+        case MYST_TCALL_CLOCK_GETTIME:
+        case MYST_TCALL_CLOCK_GETRES:
+            return MYST_EXITLESS_CLOCK;
+        default:
+            return 0;
+    }
+}
+
+int myst_exitless_parse_classes(const char* str, uint32_t* classes)
+{
+    const char* p = str;
+
+    if (!str || !classes)
+        return -EINVAL;
+
+    *classes = 0;
+
+    while (*p)
+    {
+        const char* end = strchr(p, ',');
+        size_t len = end ? (size_t)(end - p) : strlen(p);
+
+        if (len == 7 && strncmp(p, "sockets", len) == 0)
+            *classes |= MYST_EXITLESS_SOCKETS;
+        else if (len == 5 && strncmp(p, "files", len) == 0)
+            *classes |= MYST_EXITLESS_FILES;
+        else if (len == 5 && strncmp(p, "clock", len) == 0)
+            *classes |= MYST_EXITLESS_CLOCK;
+        else if (len == 3 && strncmp(p, "all", len) == 0)
+            *classes |= MYST_EXITLESS_ALL;
+        else if (len == 4 && strncmp(p, "none", len) == 0)
+            ;
+        else
+            return -EINVAL;
+
+        p += len;
+
+        if (*p == ',')
+            p++;
+    }
+
+    return 0;
+}
+
+myst_exitless_slot_t* myst_exitless_acquire(myst_exitless_t* queue)
+{
+    uint32_t start;
+
+    /* if all workers are parked, a regular tcall is cheaper than waiting
+     * (parked workers notice the fallback count change and resume polling) */
+    if (__atomic_load_n(&queue->num_awake, __ATOMIC_ACQUIRE) == 0)
+    {
+        __atomic_fetch_add(&queue->num_fallbacks, 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+
+    start = _hint;
+
+    for (uint32_t i = 0; i < MYST_EXITLESS_NUM_SLOTS; i++)
+    {
+        uint32_t index = (start + i) % MYST_EXITLESS_NUM_SLOTS;
+        myst_exitless_slot_t* slot = &queue->slots[index];
+        uint32_t expected = MYST_EXITLESS_SLOT_FREE;
+
+        if (__atomic_compare_exchange_n(
+                &slot->state,
+                &expected,
+                MYST_EXITLESS_SLOT_CLAIMED,
+                false,
+                __ATOMIC_ACQUIRE,
+                __ATOMIC_RELAXED))
+        {
+            _hint = index;
+            return slot;
+        }
+    }
+
+    __atomic_fetch_add(&queue->num_fallbacks, 1, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+int myst_exitless_post(
+    myst_exitless_t* queue,
+    myst_exitless_slot_t* slot,
+    long n,
+    const long params[6],
+    long* ret,
+    myst_exitless_yield_t yield)
+{
+    uint64_t spins = 0;
+    uint32_t state;
+
+    slot->n = n;
+
+    for (size_t i = 0; i < 6; i++)
+        slot->params[i] = params[i];
+
+    __atomic_store_n(&slot->state, MYST_EXITLESS_SLOT_POSTED, __ATOMIC_RELEASE);
+
+    /* wait for a worker to pick up the request */
+    while ((state = __atomic_load_n(&slot->state, __ATOMIC_ACQUIRE)) ==
+           MYST_EXITLESS_SLOT_POSTED)
+    {
+        if (++spins >= queue->spin_count)
+        {
+            uint32_t expected = MYST_EXITLESS_SLOT_POSTED;
+
+            /* take the request back unless a worker just claimed it */
+            if (__atomic_compare_exchange_n(
+                    &slot->state,
+                    &expected,
+                    MYST_EXITLESS_SLOT_CLAIMED,
+                    false,
+                    __ATOMIC_ACQUIRE,
+                    __ATOMIC_RELAXED))
+            {
+                __atomic_fetch_add(&queue->num_fallbacks, 1, __ATOMIC_RELAXED);
+                return -EAGAIN;
+            }
+        }
+
+        __builtin_ia32_pause();
+    }
+
+    /* wait for the worker to finish executing the request (it owns the slot
+     * now, so the request cannot be reissued): spin briefly, then yield */
+    for (spins = 0; state != MYST_EXITLESS_SLOT_DONE; spins++)
+    {
+        if (spins < queue->spin_count)
+            __builtin_ia32_pause();
+        else
+            (*yield)();
+
+        state = __atomic_load_n(&slot->state, __ATOMIC_ACQUIRE);
+    }
+
+    *ret = slot->ret;
+    return 0;
+}
+
+void myst_exitless_release(myst_exitless_slot_t* slot)
+{
+    __atomic_store_n(&slot->state, MYST_EXITLESS_SLOT_FREE, __ATOMIC_RELEASE);
+}
+
+int myst_exitless_call(
+    myst_exitless_t* queue,
+    long n,
+    const long params[6],
+    long* ret,
+    myst_exitless_yield_t yield)
+{
+    myst_exitless_slot_t* slot;
+    int r;
+
+    if (!(slot = myst_exitless_acquire(queue)))
+        return -EAGAIN;
+
+    r = myst_exitless_post(queue, slot, n, params, ret, yield);
+    myst_exitless_release(slot);
+
+    return r;
+}
@@ -0,0 +1,227 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <linux/futex.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <myst/exitless.h>
+
+/* polls of an empty queue before a worker yields its CPU */
+#define IDLE_SPIN_COUNT 16384
+
+/* yields (each followed by a poll) before a worker parks itself */
+#define IDLE_YIELD_COUNT 64
+
+/* parked workers re-check for fallbacks at this interval */
+#define PARK_TIMEOUT_NSEC 1000000
+
+typedef struct worker_set
+{
+    myst_exitless_t* queue;
+    myst_exitless_handler_t handler;
+    size_t num_threads;
+    pthread_t threads[MYST_EXITLESS_MAX_WORKERS];
+} worker_set_t;
+
+/* there is one queue per host process */
+static worker_set_t _workers;
+
+static bool _process_one(myst_exitless_t* queue, uint32_t* start)
+{
+    for (uint32_t i = 0; i < MYST_EXITLESS_NUM_SLOTS; i++)
+    {
+        uint32_t index = (*start + i) % MYST_EXITLESS_NUM_SLOTS;
+        myst_exitless_slot_t* slot = &queue->slots[index];
+        uint32_t expected = MYST_EXITLESS_SLOT_POSTED;
+
+        if (__atomic_load_n(&slot->state, __ATOMIC_RELAXED) != expected)
+            continue;
+
+        if (__atomic_compare_exchange_n(
+                &slot->state,
+                &expected,
+                MYST_EXITLESS_SLOT_BUSY,
+                false,
+                __ATOMIC_ACQUIRE,
+                __ATOMIC_RELAXED))
+        {
+            long params[6];
+
+            memcpy(params, slot->params, sizeof(params));
+            slot->ret = (*_workers.handler)(slot->n, params);
+
+            __atomic_store_n(
+                &slot->state, MYST_EXITLESS_SLOT_DONE, __ATOMIC_RELEASE);
+
+            *start = index + 1;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void _park(myst_exitless_t* queue)
+{
+    const struct timespec timeout = {0, PARK_TIMEOUT_NSEC};
+    uint64_t fallbacks = queue->num_fallbacks;
+
+    __atomic_fetch_sub(&queue->num_awake, 1, __ATOMIC_RELEASE);
+
+    for (;;)
+    {
+        uint32_t seq = __atomic_load_n(&queue->wake_seq, __ATOMIC_ACQUIRE);
+
+        if (__atomic_load_n(&queue->stop, __ATOMIC_ACQUIRE))
+            break;
+
+        syscall(
+            SYS_futex,
+            &queue->wake_seq,
+            FUTEX_WAIT_PRIVATE,
+            seq,
+            &timeout,
+            NULL,
+            0);
+
+        /* resume polling if woken or if callers fell back in the meantime */
+        if (__atomic_load_n(&queue->wake_seq, __ATOMIC_ACQUIRE) != seq ||
+            __atomic_load_n(&queue->num_fallbacks, __ATOMIC_RELAXED) !=
+                fallbacks)
+        {
+            break;
+        }
+    }
+
+    __atomic_fetch_add(&queue->num_awake, 1, __ATOMIC_RELEASE);
+}
+
+static void* _worker(void* arg)
+{
+    myst_exitless_t* queue = (myst_exitless_t*)arg;
+    uint32_t start = 0;
+    size_t idle = 0;
+
+    while (!__atomic_load_n(&queue->stop, __ATOMIC_ACQUIRE))
+    {
+        if (_process_one(queue, &start))
+        {
+            idle = 0;
+            continue;
+        }
+
+        if (++idle < IDLE_SPIN_COUNT)
+        {
+            __builtin_ia32_pause();
+            continue;
+        }
+
+        if (idle < IDLE_SPIN_COUNT + IDLE_YIELD_COUNT)
+        {
+            sched_yield();
+            continue;
+        }
+
+        _park(queue);
+        idle = 0;
+    }
+
+    __atomic_fetch_sub(&queue->num_awake, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+myst_exitless_t* myst_exitless_create(
+    uint32_t classes,
+    size_t num_workers,
+    myst_exitless_handler_t handler)
+{
+    myst_exitless_t* queue;
+    const int prot = PROT_READ | PROT_WRITE;
+    const int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+
+    if (!classes || !handler || _workers.queue)
+        return NULL;
+
+    if (num_workers == 0)
+        num_workers = MYST_EXITLESS_DEFAULT_WORKERS;
+
+    if (num_workers > MYST_EXITLESS_MAX_WORKERS)
+        num_workers = MYST_EXITLESS_MAX_WORKERS;
+
+    /* page-aligned and zero-filled (all slots start out free) */
+    queue = mmap(NULL, sizeof(myst_exitless_t), prot, flags, -1, 0);
+
+    if (queue == MAP_FAILED)
+        return NULL;
+
+    queue->classes = classes;
+    queue->num_workers = (uint32_t)num_workers;
+    queue->spin_count = MYST_EXITLESS_DEFAULT_SPIN_COUNT;
+
+    _workers.queue = queue;
+    _workers.handler = handler;
+
+    for (size_t i = 0; i < num_workers; i++)
+    {
+        __atomic_fetch_add(&queue->num_awake, 1, __ATOMIC_RELEASE);
+
+        if (pthread_create(&_workers.threads[i], NULL, _worker, queue) != 0)
+        {
+            __atomic_fetch_sub(&queue->num_awake, 1, __ATOMIC_RELEASE);
+            break;
+        }
+
+        _workers.num_threads++;
+    }
+
+    if (_workers.num_threads == 0)
+    {
+        munmap(queue, sizeof(myst_exitless_t));
+        memset(&_workers, 0, sizeof(_workers));
+        return NULL;
+    }
+
+    return queue;
+}
+
+void myst_exitless_wake(myst_exitless_t* queue)
+{
+    if (__atomic_load_n(&queue->num_awake, __ATOMIC_ACQUIRE) != 0)
+        return;
+
+    __atomic_fetch_add(&queue->wake_seq, 1, __ATOMIC_RELEASE);
+    syscall(SYS_futex, &queue->wake_seq, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+
+void myst_exitless_free(myst_exitless_t* queue)
+{
+    if (!queue || queue != _workers.queue)
+        return;
+
+    __atomic_store_n(&queue->stop, 1, __ATOMIC_RELEASE);
+    __atomic_fetch_add(&queue->wake_seq, 1, __ATOMIC_RELEASE);
+    syscall(
+        SYS_futex,
+        &queue->wake_seq,
+        FUTEX_WAKE_PRIVATE,
+        INT32_MAX,
+        NULL,
+        NULL,
+        0);
+
+    for (size_t i = 0; i < _workers.num_threads; i++)
+        pthread_join(_workers.threads[i], NULL);
+
+    munmap(queue, sizeof(myst_exitless_t));
+    memset(&_workers, 0, sizeof(_workers));
+}
@@ -4,6 +4,7 @@
 #include <poll.h>
 #include <stdarg.h>
 #include <sys/syscall.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include <myst/eraise.h>
@@ -78,6 +79,16 @@ long myst_interruptible_syscall(long n, int fd, short events, bool retry, ...)
                     syscall_ret = write((int)a, (void*)b, (size_t)c);
                     break;
                 }
+                case SYS_readv:
+                {
+                    syscall_ret = readv((int)a, (void*)b, (int)c);
+                    break;
+                }
+                case SYS_writev:
+                {
+                    syscall_ret = writev((int)a, (void*)b, (int)c);
+                    break;
+                }
                 case SYS_sendmsg:
                 {
                     syscall_ret = sendmsg((int)a, (void*)b, (int)c);
@@ -88,6 +99,18 @@ long myst_interruptible_syscall(long n, int fd, short events, bool retry, ...)
                     syscall_ret = recvmsg((int)a, (void*)b, (int)c);
                     break;
                 }
+                case SYS_sendmmsg:
+                {
+                    syscall_ret =
+                        sendmmsg((int)a, (void*)b, (unsigned int)c, (int)d);
+                    break;
+                }
+                case SYS_recvmmsg:
+                {
+                    syscall_ret = recvmmsg(
+                        (int)a, (void*)b, (unsigned int)c, (int)d, NULL);
+                    break;
+                }
                 case SYS_sendto:
                 {
                     syscall_ret = sendto(
@@ -0,0 +1,218 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#define _GNU_SOURCE
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <myst/aio.h>
+
+#define NUM_CHUNKS 32
+#define CHUNK_SIZE 4096
+
+static const char _path[] = "/tmp/aio.dat";
+
+static long _io_setup(unsigned nr, aio_context_t* ctx)
+{
+    return syscall(SYS_io_setup, nr, ctx);
+}
+
+static long _io_destroy(aio_context_t ctx)
+{
+    return syscall(SYS_io_destroy, ctx);
+}
+
+static long _io_submit(aio_context_t ctx, long nr, struct iocb** iocbpp)
+{
+    return syscall(SYS_io_submit, ctx, nr, iocbpp);
+}
+
+static long _io_getevents(
+    aio_context_t ctx,
+    long min_nr,
+    long nr,
+    struct io_event* events,
+    struct timespec* timeout)
+{
+    return syscall(SYS_io_getevents, ctx, min_nr, nr, events, timeout);
+}
+
+static void _prep(
+    struct iocb* cb,
+    int opcode,
+    int fd,
+    void* buf,
+    size_t count,
+    off_t offset)
+{
+    memset(cb, 0, sizeof(struct iocb));
+    cb->aio_lio_opcode = opcode;
+    cb->aio_fildes = fd;
+    cb->aio_buf = (uint64_t)buf;
+    cb->aio_nbytes = count;
+    cb->aio_offset = offset;
+    cb->aio_data = (uint64_t)offset;
+}
+
+/* wait for n completions, checking each against its iocb */
+static void _wait(aio_context_t ctx, struct iocb cbs[], long n)
+{
+    struct io_event events[NUM_CHUNKS];
+    long got = 0;
+
+    while (got < n)
+    {
+        long r = _io_getevents(ctx, 1, NUM_CHUNKS, events, NULL);
+        assert(r > 0);
+
+        for (long i = 0; i < r; i++)
+        {
+            struct iocb* cb = (struct iocb*)events[i].obj;
+
+            assert(cb >= cbs && cb < cbs + n);
+            assert(events[i].data == (uint64_t)cb->aio_offset);
+            assert(events[i].res == (int64_t)cb->aio_nbytes);
+        }
+
+        got += r;
+    }
+}
+
+static void _test_read_write(void)
+{
+    aio_context_t ctx = 0;
+    struct iocb cbs[NUM_CHUNKS];
+    struct iocb* ptrs[NUM_CHUNKS];
+    char* wbuf;
+    char* rbuf;
+    int fd;
+
+    assert((wbuf = malloc(NUM_CHUNKS * CHUNK_SIZE)));
+    assert((rbuf = calloc(NUM_CHUNKS, CHUNK_SIZE)));
+
+    for (size_t i = 0; i < NUM_CHUNKS * CHUNK_SIZE; i++)
+        wbuf[i] = (char)(i * 13);
+
+    assert((fd = open(_path, O_CREAT | O_TRUNC | O_RDWR, 0666)) >= 0);
+    assert(_io_setup(NUM_CHUNKS, &ctx) == 0);
+    assert(ctx != 0);
+
+    /* contiguous writes (which may be merged) */
+    for (size_t i = 0; i < NUM_CHUNKS; i++)
+    {
+        off_t off = (off_t)(i * CHUNK_SIZE);
+        _prep(&cbs[i], IOCB_CMD_PWRITE, fd, wbuf + off, CHUNK_SIZE, off);
+        ptrs[i] = &cbs[i];
+    }
+
+    assert(_io_submit(ctx, NUM_CHUNKS, ptrs) == NUM_CHUNKS);
+    _wait(ctx, cbs, NUM_CHUNKS);
+
+    /* reads in reverse order */
+    for (size_t i = 0; i < NUM_CHUNKS; i++)
+    {
+        size_t j = NUM_CHUNKS - 1 - i;
+        off_t off = (off_t)(j * CHUNK_SIZE);
+        _prep(&cbs[i], IOCB_CMD_PREAD, fd, rbuf + off, CHUNK_SIZE, off);
+        ptrs[i] = &cbs[i];
+    }
+
+    assert(_io_submit(ctx, NUM_CHUNKS, ptrs) == NUM_CHUNKS);
+    _wait(ctx, cbs, NUM_CHUNKS);
+    assert(memcmp(rbuf, wbuf, NUM_CHUNKS * CHUNK_SIZE) == 0);
+
+    /* bad file descriptor */
+    {
+        struct iocb* p = &cbs[0];
+        _prep(&cbs[0], IOCB_CMD_PREAD, 9999, rbuf, CHUNK_SIZE, 0);
+        assert(_io_submit(ctx, 1, &p) == -1 && errno == EBADF);
+    }
+
+    /* nothing pending: a zero timeout returns at once */
+    {
+        struct io_event ev;
+        struct timespec ts = {0, 0};
+        assert(_io_getevents(ctx, 1, 1, &ev, &ts) == 0);
+    }
+
+    assert(_io_destroy(ctx) == 0);
+    assert(_io_destroy(ctx) == -1 && errno == EINVAL);
+
+    close(fd);
+    free(wbuf);
+    free(rbuf);
+
+    printf("=== passed %s\n", __FUNCTION__);
+}
+
+static void _test_eventfd(void)
+{
+    aio_context_t ctx = 0;
+    struct iocb cb;
+    struct iocb* p = &cb;
+    struct io_event ev;
+    char buf[16];
+    uint64_t value = 0;
+    int efd;
+    int fd;
+
+    assert((efd = eventfd(0, 0)) >= 0);
+    assert((fd = open(_path, O_RDONLY)) >= 0);
+    assert(_io_setup(4, &ctx) == 0);
+
+    _prep(&cb, IOCB_CMD_PREAD, fd, buf, sizeof(buf), 0);
+    cb.aio_flags = IOCB_FLAG_RESFD;
+    cb.aio_resfd = efd;
+    assert(_io_submit(ctx, 1, &p) == 1);
+
+    /* the eventfd is signaled once the completion is available */
+    assert(read(efd, &value, sizeof(value)) == sizeof(value));
+    assert(value == 1);
+    assert(_io_getevents(ctx, 1, 1, &ev, NULL) == 1);
+    assert(ev.res == sizeof(buf));
+    assert(ev.obj == (uint64_t)&cb);
+
+    /* fsync */
+    _prep(&cb, IOCB_CMD_FSYNC, fd, NULL, 0, 0);
+    assert(_io_submit(ctx, 1, &p) == 1);
+    assert(_io_getevents(ctx, 1, 1, &ev, NULL) == 1);
+    assert(ev.res == 0);
+
+    assert(_io_destroy(ctx) == 0);
+    close(fd);
+    close(efd);
+
+    printf("=== passed %s\n", __FUNCTION__);
+}
+
+/* runs first: failed io_setup() calls must not start the workers */
+static void _test_setup_errors(void)
+{
+    aio_context_t ctx = 0;
+
+    assert(_io_setup(65537, &ctx) == -1 && errno == EAGAIN);
+    assert(_io_setup(0, &ctx) == -1 && errno == EINVAL);
+    assert(ctx == 0);
+
+    printf("=== passed %s\n", __FUNCTION__);
+}
+
+int main(int argc, const char* argv[])
+{
+    _test_setup_errors();
+    _test_read_write();
+    _test_eventfd();
+    unlink(_path);
+
+    printf("=== passed all tests (%s)\n", argv[0]);
+    return 0;
+}
@@ -2,6 +2,7 @@
 // Licensed under the MIT License.
 
 #include <assert.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -93,6 +94,57 @@ static int test_clock_get_time(long reference)
     return 0;
 }
 
+#define NUM_THREADS 4
+#define NUM_READS 100000
+
+static void* _read_monotonic(void* arg)
+{
+    long prev = 0;
+
+    (void)arg;
+
+    for (int i = 0; i < NUM_READS; i++)
+    {
+        struct timespec tp;
+        long timestamp;
+
+        assert(clock_gettime(CLOCK_MONOTONIC, &tp) == 0);
+        timestamp = tp.tv_sec * NANO_IN_SECOND + tp.tv_nsec;
+
+        // No backward clock, even while other threads read it
+        assert(timestamp >= prev);
+        prev = timestamp;
+    }
+
+    return NULL;
+}
+
+static int test_concurrent_clock_get_time()
+{
+    pthread_t threads[NUM_THREADS];
+    struct timespec start = {0};
+    struct timespec end = {0};
+
+    assert(clock_gettime(CLOCK_MONOTONIC, &start) == 0);
+
+    for (size_t i = 0; i < NUM_THREADS; i++)
+        assert(pthread_create(&threads[i], NULL, _read_monotonic, NULL) == 0);
+
+    for (size_t i = 0; i < NUM_THREADS; i++)
+        assert(pthread_join(threads[i], NULL) == 0);
+
+    assert(clock_gettime(CLOCK_MONOTONIC, &end) == 0);
+
+    long elapsed = (end.tv_sec - start.tv_sec) * NANO_IN_SECOND +
+                   (end.tv_nsec - start.tv_nsec);
+    printf(
+        "%d concurrent clock_gettime() calls: %ld ns per call\n",
+        NUM_THREADS * NUM_READS,
+        elapsed / (NUM_THREADS * NUM_READS));
+
+    return 0;
+}
+
 static int test_clock_set_time()
 {
     struct timespec tp0 = {0}, tp1 = {0}, tp2 = {0}, update_tp = {0};
@@ -181,6 +233,8 @@ int main(int argc, const char* argv[])
 
     assert(test_clock_get_time(now_from_cmdline) == 0);
 
+    assert(test_concurrent_clock_get_time() == 0);
+
     if (is_sgx_target())
     {
         assert(test_clock_set_time() == 0);
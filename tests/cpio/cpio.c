@@ -2,12 +2,14 @@
 // Licensed under the MIT License.
 
 #include <assert.h>
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include <myst/atexit.h>
 #include <myst/cpio.h>
+#include <myst/cpioindex.h>
 #include <myst/file.h>
 #include <myst/lsr.h>
 #include <myst/mount.h>
@@ -199,15 +201,195 @@ void test(const void* cpio_data, size_t cpio_size, bool load_from_memory)
     myst_strarr_release(&sorted);
 }
 
+void test_parallel(const void* cpio_data, size_t cpio_size)
+{
+    char template[] = "/tmp/mystXXXXXX";
+    char* tmpdir;
+    char archive[PATH_MAX];
+    char root[PATH_MAX];
+    char serial[PATH_MAX];
+    char parallel[PATH_MAX];
+    void* data1;
+    size_t size1;
+    void* data2;
+    size_t size2;
+
+    assert((tmpdir = mkdtemp(template)) != NULL);
+    snprintf(archive, sizeof(archive), "%s/cpio-archive", tmpdir);
+    snprintf(root, sizeof(root), "%s/root", tmpdir);
+    snprintf(serial, sizeof(serial), "%s/serial.cpio", tmpdir);
+    snprintf(parallel, sizeof(parallel), "%s/parallel.cpio", tmpdir);
+
+    /* unpack the archive on several threads */
+    assert(_create_cpio_file(archive, cpio_data, cpio_size) == 0);
+    assert(myst_cpio_unpack_parallel(archive, root, 4) == 0);
+
+    myst_strarr_t paths = MYST_STRARR_INITIALIZER;
+    assert(myst_lsr(root, &paths, true) == 0);
+    myst_strarr_sort(&paths);
+
+    myst_strarr_t sorted = MYST_STRARR_INITIALIZER;
+    {
+        for (size_t i = 0; i < _npaths; i++)
+            assert(myst_strarr_append(&sorted, _paths[i]) == 0);
+
+        myst_strarr_sort(&sorted);
+    }
+
+    assert(sorted.size == paths.size);
+
+    for (size_t i = 0; i < paths.size; i++)
+    {
+        char tmp[PATH_MAX];
+        snprintf(tmp, sizeof(tmp), "%s/%s", root, sorted.data[i]);
+        assert(strcmp(paths.data[i], tmp) == 0);
+    }
+
+    /* the parallel packer creates the same archive as the serial one */
+    assert(myst_cpio_pack(root, serial) == 0);
+    assert(myst_cpio_pack_parallel(root, parallel, 4) == 0);
+
+    assert(myst_load_file(serial, &data1, &size1) == 0);
+    assert(myst_load_file(parallel, &data2, &size2) == 0);
+    assert(size1 == size2);
+    assert(memcmp(data1, data2, size1) == 0);
+
+    free(data1);
+    free(data2);
+    myst_strarr_release(&paths);
+    myst_strarr_release(&sorted);
+}
+
+/* append the paths under the given index directory to the array */
+static void _walk_index(
+    const myst_cpio_index_t* index,
+    size_t ino,
+    const char* dirname,
+    myst_strarr_t* paths)
+{
+    const myst_cpio_index_inode_t* dir = &index->inodes[ino];
+
+    assert(S_ISDIR(dir->mode));
+
+    for (size_t i = 0; i < dir->num_children; i++)
+    {
+        const size_t child = dir->first_child + i;
+        const myst_cpio_index_inode_t* inode = &index->inodes[child];
+        const char* name = myst_cpio_index_name(index, inode);
+        char path[PATH_MAX];
+
+        /* the children are sorted by name */
+        if (i > 0)
+        {
+            const char* prev = myst_cpio_index_name(index, inode - 1);
+            assert(strcmp(prev, name) < 0);
+        }
+
+        if (*dirname)
+            snprintf(path, sizeof(path), "%s/%s", dirname, name);
+        else
+            snprintf(path, sizeof(path), "%s", name);
+
+        assert(myst_strarr_append(paths, path) == 0);
+
+        if (S_ISDIR(inode->mode))
+            _walk_index(index, child, path, paths);
+    }
+}
+
+void test_index(const void* cpio_data, size_t cpio_size)
+{
+    myst_buf_t buf = MYST_BUF_INITIALIZER;
+    myst_cpio_index_t index;
+    uint8_t* image;
+    size_t image_size;
+    myst_strarr_t paths = MYST_STRARR_INITIALIZER;
+    myst_strarr_t sorted = MYST_STRARR_INITIALIZER;
+
+    /* an archive without an index */
+    assert(myst_cpio_index_find(cpio_data, cpio_size, &index) == -ENOENT);
+
+    /* append the index to a copy of the archive */
+    assert(myst_cpio_index_build(cpio_data, cpio_size, &buf) == 0);
+    image_size = cpio_size + buf.size;
+    assert((image = malloc(image_size)));
+    memcpy(image, cpio_data, cpio_size);
+    memcpy(image + cpio_size, buf.data, buf.size);
+
+    /* the archive is still readable by CPIO readers */
+    assert(myst_is_cpio_archive(image, image_size));
+
+    assert(myst_cpio_index_find(image, image_size, &index) == 0);
+    assert(index.archive_size == cpio_size);
+    assert(index.num_inodes == _npaths + 1);
+
+    _walk_index(&index, 0, "", &paths);
+    myst_strarr_sort(&paths);
+
+    for (size_t i = 0; i < _npaths; i++)
+        assert(myst_strarr_append(&sorted, _paths[i]) == 0);
+
+    myst_strarr_sort(&sorted);
+
+    assert(sorted.size == paths.size);
+
+    for (size_t i = 0; i < paths.size; i++)
+        assert(strcmp(paths.data[i], sorted.data[i]) == 0);
+
+    /* file data is referenced in place */
+    {
+        size_t pos = 0;
+        myst_cpio_entry_t entry;
+        const void* file_data;
+
+        while (myst_cpio_next_entry(
+                   cpio_data, cpio_size, &pos, &entry, &file_data) == 1)
+        {
+            bool found = false;
+
+            if (!S_ISREG(entry.mode))
+                continue;
+
+            for (size_t i = 0; i < index.num_inodes; i++)
+            {
+                const myst_cpio_index_inode_t* inode = &index.inodes[i];
+                const uint8_t* p = (const uint8_t*)file_data;
+
+                if (inode->offset == (uint64_t)(p - (uint8_t*)cpio_data))
+                {
+                    assert(S_ISREG(inode->mode));
+                    assert(inode->size == entry.size);
+                    found = true;
+                }
+            }
+
+            assert(found);
+        }
+    }
+
+    /* a truncated index is rejected */
+    assert(myst_cpio_index_find(image, image_size - 1, &index) != 0);
+
+    myst_strarr_release(&paths);
+    myst_strarr_release(&sorted);
+    myst_buf_release(&buf);
+    free(image);
+}
+
 int main(int argc, const char* argv[])
 {
     void* data;
     size_t size;
     bool load_from_memory = true;
+    bool test_index_only = false;
+    bool test_parallel_only = false;
 
     if (argc != 3)
     {
-        fprintf(stderr, "Usage: %s <cpio-archive> <mem|file>\n", argv[0]);
+        fprintf(
+            stderr,
+            "Usage: %s <cpio-archive> <mem|file|index|parallel>\n",
+            argv[0]);
         return 1;
     }
 
@@ -219,6 +401,14 @@ int main(int argc, const char* argv[])
     {
         load_from_memory = false;
     }
+    else if (strcmp(argv[2], "index") == 0)
+    {
+        test_index_only = true;
+    }
+    else if (strcmp(argv[2], "parallel") == 0)
+    {
+        test_parallel_only = true;
+    }
     else
     {
         fprintf(stderr, "bad argument: %s\n", argv[2]);
@@ -230,7 +420,13 @@ int main(int argc, const char* argv[])
 
     assert(data != NULL);
     assert(size != 0);
-    test(data, size, load_from_memory);
+
+    if (test_index_only)
+        test_index(data, size);
+    else if (test_parallel_only)
+        test_parallel(data, size);
+    else
+        test(data, size, load_from_memory);
 
     free(data);
 
@@ -1061,6 +1061,87 @@ void test_rename_dir(void)
     assert(rename("/renamedir1", "/renamedir2") == 0);
 }
 
+static void test_sparse(void)
+{
+    int fd;
+    const off_t offset = 3 * 4096 + 100;
+    char buf[offset + sizeof(alpha)];
+    struct stat st;
+
+    assert((fd = open("/test_sparse", O_CREAT | O_TRUNC | O_RDWR, 0666)) >= 0);
+
+    /* writing beyond the end of file leaves a hole */
+    assert(lseek(fd, offset, SEEK_SET) == offset);
+    assert(write(fd, alpha, sizeof(alpha)) == sizeof(alpha));
+    assert(fstat(fd, &st) == 0);
+    assert(st.st_size == offset + sizeof(alpha));
+
+    assert(pread(fd, buf, sizeof(buf), 0) == sizeof(buf));
+
+    for (off_t i = 0; i < offset; i++)
+        assert(buf[i] == '\0');
+
+    assert(memcmp(buf + offset, alpha, sizeof(alpha)) == 0);
+
+    /* truncating and extending again reads back zeros */
+    assert(ftruncate(fd, offset + 2) == 0);
+    assert(ftruncate(fd, offset + sizeof(alpha)) == 0);
+    assert(pread(fd, buf, sizeof(alpha), offset) == sizeof(alpha));
+    assert(memcmp(buf, alpha, 2) == 0);
+
+    for (size_t i = 2; i < sizeof(alpha); i++)
+        assert(buf[i] == '\0');
+
+    close(fd);
+    assert(unlink("/test_sparse") == 0);
+
+    _passed(__FUNCTION__);
+}
+
+static void test_large_dir(void)
+{
+    const size_t n = 1000;
+    char path[PATH_MAX];
+    DIR* dir;
+    struct dirent* ent;
+    size_t count = 0;
+
+    assert(mkdir("/test_large_dir", 0777) == 0);
+
+    for (size_t i = 0; i < n; i++)
+    {
+        int fd;
+        snprintf(path, sizeof(path), "/test_large_dir/file%zu", i);
+        assert((fd = creat(path, 0666)) >= 0);
+        close(fd);
+    }
+
+    for (size_t i = 0; i < n; i += 7)
+    {
+        snprintf(path, sizeof(path), "/test_large_dir/file%zu", i);
+        assert(access(path, F_OK) == 0);
+    }
+
+    /* remove every entry while the directory is being read */
+    assert((dir = opendir("/test_large_dir")) != NULL);
+
+    while ((ent = readdir(dir)))
+    {
+        if (strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0)
+            continue;
+
+        snprintf(path, sizeof(path), "/test_large_dir/%s", ent->d_name);
+        assert(unlink(path) == 0);
+        count++;
+    }
+
+    closedir(dir);
+    assert(count == n);
+    assert(rmdir("/test_large_dir") == 0);
+
+    _passed(__FUNCTION__);
+}
+
 int main(int argc, const char* argv[])
 {
     if (argc != 2)
@@ -1117,6 +1198,8 @@ int main(int argc, const char* argv[])
     test_sync();
     test_append();
     test_rename_dir();
+    test_sparse();
+    test_large_dir();
 
     printf("=== passed all tests (%s)\n", argv[0]);
 
@@ -0,0 +1,129 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <assert.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/* measures how ramfs read throughput scales with the number of threads: each
+ * thread reads and stats its own file (or all threads share one file) */
+
+#define MAX_THREADS 8
+#define ITERATIONS 20000
+#define FILE_SIZE 65536
+#define READ_SIZE 4096
+
+typedef struct args
+{
+    char path[64];
+} args_t;
+
+static double _now(void)
+{
+    struct timespec ts;
+    assert(clock_gettime(CLOCK_MONOTONIC, &ts) == 0);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void _create_file(const char* path)
+{
+    static char buf[FILE_SIZE];
+    int fd;
+
+    memset(buf, 'x', sizeof(buf));
+    assert((fd = open(path, O_CREAT | O_WRONLY | O_TRUNC, 0666)) >= 0);
+    assert(write(fd, buf, sizeof(buf)) == sizeof(buf));
+    assert(close(fd) == 0);
+}
+
+static void* _thread(void* arg)
+{
+    const args_t* args = (const args_t*)arg;
+    char buf[READ_SIZE];
+    struct stat st;
+    int fd;
+
+    assert((fd = open(args->path, O_RDONLY)) >= 0);
+
+    for (size_t i = 0; i < ITERATIONS; i++)
+    {
+        off_t off = (off_t)((i * READ_SIZE) % FILE_SIZE);
+
+        assert(pread(fd, buf, sizeof(buf), off) == sizeof(buf));
+        assert(buf[0] == 'x');
+        assert(stat(args->path, &st) == 0);
+        assert(st.st_size == FILE_SIZE);
+    }
+
+    assert(close(fd) == 0);
+    return NULL;
+}
+
+static void _bench(size_t nthreads, bool shared)
+{
+    pthread_t threads[MAX_THREADS];
+    args_t args[MAX_THREADS];
+    const size_t ncalls = 2 * ITERATIONS * nthreads;
+    double start;
+    double secs;
+
+    for (size_t i = 0; i < nthreads; i++)
+    {
+        size_t n = shared ? 0 : i;
+        snprintf(args[i].path, sizeof(args[i].path), "/tmp/fsperf%zu", n);
+    }
+
+    start = _now();
+
+    for (size_t i = 0; i < nthreads; i++)
+        assert(pthread_create(&threads[i], NULL, _thread, &args[i]) == 0);
+
+    for (size_t i = 0; i < nthreads; i++)
+        assert(pthread_join(threads[i], NULL) == 0);
+
+    secs = _now() - start;
+
+    printf(
+        "%-8s %2zu threads %10zu calls %8.3f sec %12.0f calls/sec\n",
+        shared ? "shared" : "private",
+        nthreads,
+        ncalls,
+        secs,
+        (double)ncalls / secs);
+}
+
+int main(int argc, const char* argv[])
+{
+    char path[64];
+
+    mkdir("/tmp", 0777);
+
+    for (size_t i = 0; i < MAX_THREADS; i++)
+    {
+        snprintf(path, sizeof(path), "/tmp/fsperf%zu", i);
+        _create_file(path);
+    }
+
+    for (size_t n = 1; n <= MAX_THREADS; n *= 2)
+        _bench(n, false);
+
+    for (size_t n = 1; n <= MAX_THREADS; n *= 2)
+        _bench(n, true);
+
+    for (size_t i = 0; i < MAX_THREADS; i++)
+    {
+        snprintf(path, sizeof(path), "/tmp/fsperf%zu", i);
+        assert(unlink(path) == 0);
+    }
+
+    printf("=== passed test (%s)\n", argv[0]);
+
+    return 0;
+}
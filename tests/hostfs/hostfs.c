@@ -1,6 +1,7 @@
 // Copyright (c) Microsoft Corporation.
 // Licensed under the MIT License.
 
+#define _GNU_SOURCE
 #include <assert.h>
 #include <dirent.h>
 #include <errno.h>
@@ -10,14 +11,253 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/mount.h>
+#include <sys/sendfile.h>
 #include <sys/stat.h>
 #include <sys/statfs.h>
+#include <sys/syscall.h>
 #include <sys/uio.h>
 #include <unistd.h>
 
 const char alpha[] = "abcdefghijklmnopqrstuvwxyz";
 const char ALPHA[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
 
+/* enough long names for several 64 KiB getdents chunks on the host and for
+ * a listing too large to be cached */
+#define NUM_ENTRIES 2500
+#define NAME_LEN 100
+#define MANY_DIR "/mnt/host/many"
+
+struct linux_dirent64
+{
+    ino64_t d_ino;
+    off64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+static void _entry_name(char name[NAME_LEN + 1], size_t i)
+{
+    memset(name, 'n', NAME_LEN);
+    snprintf(name, NAME_LEN + 1, "%05zu", i);
+    name[5] = 'n';
+    name[NAME_LEN] = '\0';
+}
+
+/* index of a name made by _entry_name() (or -1 for "." and "..") */
+static long _entry_index(const char* name)
+{
+    if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0)
+        return -1;
+
+    assert(strlen(name) == NAME_LEN);
+    return strtol(name, NULL, 10);
+}
+
+/* read the rest of the directory with getdents64() into SEEN, returning the
+ * d_off of the last record */
+static off_t _read_entries(int fd, size_t bufsize, char* seen)
+{
+    char buf[bufsize];
+    off_t off = -1;
+    long n;
+
+    while ((n = syscall(SYS_getdents64, fd, buf, bufsize)) > 0)
+    {
+        for (long i = 0; i < n;)
+        {
+            struct linux_dirent64* ent = (struct linux_dirent64*)(buf + i);
+            long index = _entry_index(ent->d_name);
+
+            if (index >= 0)
+            {
+                assert(index < NUM_ENTRIES);
+                assert(!seen[index]);
+                seen[index] = 1;
+            }
+
+            off = ent->d_off;
+            i += ent->d_reclen;
+        }
+    }
+
+    assert(n == 0);
+    return off;
+}
+
+static void _check_all_seen(const char* seen)
+{
+    for (size_t i = 0; i < NUM_ENTRIES; i++)
+        assert(seen[i]);
+}
+
+/* listings that span several host chunks, read with small buffers */
+static void test_getdents_chunks(void)
+{
+    char name[PATH_MAX];
+    static char seen[NUM_ENTRIES];
+    int fd;
+
+    assert(mkdir(MANY_DIR, 0777) == 0);
+
+    for (size_t i = 0; i < NUM_ENTRIES; i++)
+    {
+        char entry[NAME_LEN + 1];
+
+        _entry_name(entry, i);
+        snprintf(name, sizeof(name), "%s/%s", MANY_DIR, entry);
+        assert((fd = creat(name, 0666)) >= 0);
+        assert(close(fd) == 0);
+    }
+
+    /* twice: the second pass may come from the cache */
+    for (size_t pass = 0; pass < 2; pass++)
+    {
+        memset(seen, 0, sizeof(seen));
+        assert((fd = open(MANY_DIR, O_RDONLY | O_DIRECTORY)) >= 0);
+        _read_entries(fd, 1024, seen);
+        assert(close(fd) == 0);
+        _check_all_seen(seen);
+    }
+
+    /* a buffer too small for one record */
+    assert((fd = open(MANY_DIR, O_RDONLY | O_DIRECTORY)) >= 0);
+    {
+        char buf[20];
+        assert(syscall(SYS_getdents64, fd, buf, sizeof(buf)) == -1);
+        assert(errno == EINVAL);
+    }
+    assert(close(fd) == 0);
+
+    printf("=== passed test (%s)\n", __FUNCTION__);
+}
+
+/* the directory position is the one of the records returned so far, not
+ * the one of the chunk that the kernel read ahead from the host */
+static void test_dir_seek(void)
+{
+    static char seen[NUM_ENTRIES];
+    static char seen2[NUM_ENTRIES];
+    char buf[1024];
+    off_t pos;
+    long n;
+    int fd;
+
+    assert((fd = open(MANY_DIR, O_RDONLY | O_DIRECTORY)) >= 0);
+
+    /* read a few records, then remember the position */
+    assert((n = syscall(SYS_getdents64, fd, buf, sizeof(buf))) > 0);
+    {
+        struct linux_dirent64* ent = NULL;
+
+        memset(seen, 0, sizeof(seen));
+
+        for (long i = 0; i < n; i += ent->d_reclen)
+        {
+            long index;
+
+            ent = (struct linux_dirent64*)(buf + i);
+
+            if ((index = _entry_index(ent->d_name)) >= 0)
+                seen[index] = 1;
+        }
+
+        pos = lseek(fd, 0, SEEK_CUR);
+        assert(pos == ent->d_off);
+    }
+
+    /* a relative seek starts from that position */
+    assert(lseek(fd, 0, SEEK_CUR) == pos);
+    memcpy(seen2, seen, sizeof(seen));
+    _read_entries(fd, sizeof(buf), seen);
+    _check_all_seen(seen);
+
+    /* so does an absolute seek back to it */
+    assert(lseek(fd, pos, SEEK_SET) == pos);
+    _read_entries(fd, sizeof(buf), seen2);
+    _check_all_seen(seen2);
+
+    /* rewind */
+    assert(lseek(fd, 0, SEEK_SET) == 0);
+    memset(seen, 0, sizeof(seen));
+    _read_entries(fd, sizeof(buf), seen);
+    _check_all_seen(seen);
+
+    assert(close(fd) == 0);
+
+    /* telldir() and seekdir() round trips */
+    {
+        DIR* dir;
+        struct dirent* ent;
+        long tells[64];
+        char names[64][NAME_LEN + 1];
+        size_t count = 0;
+
+        assert((dir = opendir(MANY_DIR)));
+
+        while (count < 64 && (ent = readdir(dir)))
+        {
+            strcpy(names[count], ent->d_name);
+            tells[count++] = telldir(dir);
+        }
+
+        assert(count == 64);
+
+        /* seeking to the position after entry i yields entry i + 1 */
+        for (size_t i = count - 1; i-- > 0;)
+        {
+            seekdir(dir, tells[i]);
+            assert(telldir(dir) == tells[i]);
+            assert((ent = readdir(dir)));
+            assert(strcmp(ent->d_name, names[i + 1]) == 0);
+        }
+
+        assert(closedir(dir) == 0);
+    }
+
+    printf("=== passed test (%s)\n", __FUNCTION__);
+}
+
+/* changes made through hostfs are seen at once, even with the cache on */
+static void test_cache_invalidation(void)
+{
+    const char filename[] = "/mnt/host/cached";
+    struct stat buf;
+    DIR* dir;
+    struct dirent* ent;
+    int fd;
+
+    assert((fd = creat(filename, 0666)) >= 0);
+    assert(write(fd, alpha, sizeof(alpha)) == sizeof(alpha));
+    assert(close(fd) == 0);
+
+    /* fill the attribute and listing caches */
+    assert(stat(filename, &buf) == 0);
+    assert(buf.st_size == sizeof(alpha));
+    assert((dir = opendir("/mnt/host")));
+    while ((ent = readdir(dir)))
+        ;
+    assert(closedir(dir) == 0);
+
+    /* a truncation changes the size */
+    assert(truncate(filename, 1) == 0);
+    assert(stat(filename, &buf) == 0);
+    assert(buf.st_size == 1);
+
+    /* an unlink removes the file from the caches */
+    assert(unlink(filename) == 0);
+    assert(stat(filename, &buf) == -1 && errno == ENOENT);
+    assert(access(filename, F_OK) == -1 && errno == ENOENT);
+    assert(open(filename, O_RDONLY) == -1 && errno == ENOENT);
+
+    assert((dir = opendir("/mnt/host")));
+    while ((ent = readdir(dir)))
+        assert(strcmp(ent->d_name, "cached") != 0);
+    assert(closedir(dir) == 0);
+
+    printf("=== passed test (%s)\n", __FUNCTION__);
+}
+
 int main(int argc, const char* argv[])
 {
     int fd;
@@ -334,6 +574,78 @@ int main(int argc, const char* argv[])
         assert(unlink(filename) == 0);
     }
 
+    /* test sendfile() and copy_file_range() between host files (done by the
+     * host rather than through the kernel) */
+    {
+        const char srcname[] = "/mnt/host/src";
+        const char dstname[] = "/mnt/host/dst";
+        const size_t size = 256 * 1024;
+        char* data;
+        char* copy;
+        int src;
+        int dst;
+        off_t off;
+        loff_t off_in;
+        loff_t off_out;
+        struct stat buf;
+
+        assert((data = malloc(size)));
+        assert((copy = malloc(size)));
+
+        for (size_t i = 0; i < size; i++)
+            data[i] = alpha[i % (sizeof(alpha) - 1)];
+
+        assert((src = open(srcname, O_RDWR | O_CREAT | O_TRUNC, 0666)) >= 0);
+        assert(write(src, data, size) == size);
+        assert((dst = open(dstname, O_RDWR | O_CREAT | O_TRUNC, 0666)) >= 0);
+
+        /* with an offset: the file position of src is unchanged */
+        off = 0;
+        assert(sendfile(dst, src, &off, size) == size);
+        assert(off == size);
+        assert(lseek(src, 0, SEEK_CUR) == size);
+        assert(lseek(dst, 0, SEEK_CUR) == size);
+
+        /* without an offset: copies from the file position (at the end) */
+        assert(sendfile(dst, src, NULL, size) == 0);
+
+        /* the attributes reflect what the host wrote */
+        assert(stat(dstname, &buf) == 0);
+        assert(buf.st_size == size);
+
+        assert(pread(dst, copy, size, 0) == size);
+        assert(memcmp(data, copy, size) == 0);
+
+        /* copy the second half of src over the first half of dst */
+        off_in = size / 2;
+        off_out = 0;
+        assert(
+            copy_file_range(src, &off_in, dst, &off_out, size / 2, 0) ==
+            size / 2);
+        assert(off_in == size && off_out == size / 2);
+        assert(pread(dst, copy, size, 0) == size);
+        assert(memcmp(copy, data + size / 2, size / 2) == 0);
+        assert(memcmp(copy + size / 2, data + size / 2, size / 2) == 0);
+
+        /* copying at the end of src copies nothing */
+        assert(copy_file_range(src, &off_in, dst, &off_out, 1, 0) == 0);
+
+        /* unsupported flags */
+        assert(copy_file_range(src, NULL, dst, NULL, 1, 1) == -1);
+        assert(errno == EINVAL);
+
+        assert(close(src) == 0);
+        assert(close(dst) == 0);
+        assert(unlink(srcname) == 0);
+        assert(unlink(dstname) == 0);
+        free(data);
+        free(copy);
+    }
+
+    test_getdents_chunks();
+    test_dir_seek();
+    test_cache_invalidation();
+
     assert(umount("/mnt/host") == 0);
 
     printf("=== passed test (%s)\n", argv[0]);
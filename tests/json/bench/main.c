@@ -0,0 +1,323 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <myst/json.h>
+
+/*
+**==============================================================================
+**
+** Parser benchmark: parses a generated configuration with large
+** EnvironmentVariables and Mount arrays in three ways:
+**
+**     match - json_match() with every pattern in turn (the classic callback)
+**     trie  - json_trie_match() with the patterns compiled into a trie
+**     slice - json_trie_match() in zero_copy mode (input left unmodified)
+**
+** All three must see the same values.
+**
+**==============================================================================
+*/
+
+const char* arg0;
+
+static const char* _patterns[] = {
+    "version",
+    "Debug",
+    "ProductID",
+    "SecurityVersion",
+    "UserMemSize",
+    "MainStackSize",
+    "ThreadStackSize",
+    "ApplicationPath",
+    "HostApplicationParameters",
+    "ApplicationParameters",
+    "EnvironmentVariables",
+    "HostEnvironmentVariables",
+    "CurrentWorkingDirectory",
+    "Hostname",
+    "ForkMode",
+    "Mount.Target",
+    "Mount.Type",
+    "Mount.Flags",
+    "Mount.PublicKey",
+    "Mount.RootHash",
+    "UnhandledSyscallEnosys",
+    "Secret.ID",
+    "Secret.SrsAddress",
+    "Secret.LocalPath",
+};
+
+#define NUM_PATTERNS (sizeof(_patterns) / sizeof(_patterns[0]))
+
+typedef enum bench_mode
+{
+    MODE_MATCH,
+    MODE_TRIE,
+    MODE_SLICE,
+} bench_mode_t;
+
+typedef struct stats
+{
+    size_t values[NUM_PATTERNS];
+    size_t string_bytes;
+} stats_t;
+
+typedef struct callback_data
+{
+    bench_mode_t mode;
+    json_trie_t* trie;
+    stats_t stats;
+} callback_data_t;
+
+static json_result_t _callback(
+    json_parser_t* parser,
+    json_reason_t reason,
+    json_type_t type,
+    const json_union_t* un,
+    void* callback_data)
+{
+    callback_data_t* cd = (callback_data_t*)callback_data;
+    long id = -1;
+
+    if (reason != JSON_REASON_VALUE)
+        return JSON_OK;
+
+    if (cd->mode == MODE_MATCH)
+    {
+        for (size_t i = 0; i < NUM_PATTERNS; i++)
+        {
+            if (json_match(parser, _patterns[i]) == JSON_OK)
+            {
+                id = (long)i;
+                break;
+            }
+        }
+    }
+    else
+    {
+        id = json_trie_match(cd->trie, parser);
+    }
+
+    if (id == -1)
+        return JSON_OK;
+
+    cd->stats.values[id]++;
+
+    if (type == JSON_TYPE_STRING)
+    {
+        if (cd->mode == MODE_SLICE)
+            cd->stats.string_bytes += un->slice.size;
+        else
+            cd->stats.string_bytes += strlen(un->string);
+    }
+
+    return JSON_OK;
+}
+
+static char* _generate(size_t num_env, size_t num_mounts, size_t* size)
+{
+    char* data = NULL;
+    FILE* os;
+
+    if (!(os = open_memstream(&data, size)))
+    {
+        fprintf(stderr, "%s: open_memstream() failed\n", arg0);
+        exit(1);
+    }
+
+    fprintf(os, "{\n");
+    fprintf(os, "    \"version\": \"0.1\",\n");
+    fprintf(os, "    \"Debug\": 1,\n");
+    fprintf(os, "    \"UserMemSize\": \"1024m\",\n");
+    fprintf(os, "    \"ApplicationPath\": \"/bin/app\",\n");
+    fprintf(os, "    \"ApplicationParameters\": [\"--verbose\", \"-x\"],\n");
+    fprintf(os, "    \"EnvironmentVariables\": [\n");
+
+    for (size_t i = 0; i < num_env; i++)
+    {
+        fprintf(
+            os,
+            "        \"VARIABLE_%zu=/usr/local/lib/value/%zu\"%s\n",
+            i,
+            i * 7,
+            i + 1 == num_env ? "" : ",");
+    }
+
+    fprintf(os, "    ],\n");
+    fprintf(os, "    \"Mount\": [\n");
+
+    for (size_t i = 0; i < num_mounts; i++)
+    {
+        fprintf(os, "        {\n");
+        fprintf(os, "            \"Target\": \"/mnt/target%zu\",\n", i);
+        fprintf(os, "            \"Type\": \"hostfs\",\n");
+        fprintf(os, "            \"Flags\": [\"ro\", \"nosuid\"],\n");
+        fprintf(os, "            \"PublicKey\": null\n");
+        fprintf(os, "        }%s\n", i + 1 == num_mounts ? "" : ",");
+    }
+
+    fprintf(os, "    ],\n");
+    fprintf(os, "    \"ForkMode\": \"none\"\n");
+    fprintf(os, "}\n");
+
+    fclose(os);
+
+    return data;
+}
+
+static double _now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void _bench(
+    const char* name,
+    bench_mode_t mode,
+    json_trie_t* trie,
+    const char* json,
+    size_t size,
+    size_t iterations,
+    stats_t* stats)
+{
+    char* data;
+    double elapsed = 0;
+    static json_allocator_t allocator = {
+        malloc,
+        free,
+    };
+
+    if (!(data = malloc(size + 1)))
+    {
+        fprintf(stderr, "%s: out of memory\n", arg0);
+        exit(1);
+    }
+
+    for (size_t i = 0; i < iterations; i++)
+    {
+        json_parser_t parser;
+        callback_data_t cd;
+        json_parser_options_t options = {1, mode == MODE_SLICE};
+        json_result_t r;
+        double start;
+
+        /* the parser destroys its input (except in zero-copy mode) */
+        memcpy(data, json, size + 1);
+
+        memset(&cd, 0, sizeof(cd));
+        cd.mode = mode;
+        cd.trie = trie;
+
+        start = _now();
+
+        if ((r = json_parser_init(
+                 &parser, data, size, _callback, &cd, &allocator, &options)) !=
+            JSON_OK)
+        {
+            fprintf(stderr, "%s: json_parser_init() failed: %d\n", arg0, r);
+            exit(1);
+        }
+
+        if ((r = json_parser_parse(&parser)) != JSON_OK)
+        {
+            fprintf(stderr, "%s: json_parser_parse() failed: %d\n", arg0, r);
+            exit(1);
+        }
+
+        elapsed += _now() - start;
+
+        /* zero-copy mode must leave the input as is */
+        if (mode == MODE_SLICE)
+            assert(memcmp(data, json, size) == 0);
+
+        *stats = cd.stats;
+    }
+
+    printf(
+        "=== %s: %s: %.3lf ms/parse (%.1lf MB/s)\n",
+        arg0,
+        name,
+        elapsed * 1000 / (double)iterations,
+        (double)(size * iterations) / elapsed / (1024 * 1024));
+
+    free(data);
+}
+
+int main(int argc, char** argv)
+{
+    size_t num_env = 10000;
+    size_t num_mounts = 1000;
+    size_t iterations = 20;
+    char* json;
+    size_t size;
+    json_trie_node_t nodes[64];
+    json_trie_t trie;
+    stats_t stats[3];
+
+    arg0 = argv[0];
+
+    if (argc > 1)
+        num_env = strtoul(argv[1], NULL, 10);
+
+    if (argc > 2)
+        num_mounts = strtoul(argv[2], NULL, 10);
+
+    if (argc > 3)
+        iterations = strtoul(argv[3], NULL, 10);
+
+    if (argc > 4 || iterations == 0)
+    {
+        fprintf(
+            stderr,
+            "Usage: %s [num-env-vars [num-mounts [iterations]]]\n",
+            argv[0]);
+        exit(1);
+    }
+
+    json = _generate(num_env, num_mounts, &size);
+
+    assert(json_trie_init(&trie, nodes, 64) == JSON_OK);
+
+    for (size_t i = 0; i < NUM_PATTERNS; i++)
+        assert(json_trie_add(&trie, _patterns[i], (long)i) == JSON_OK);
+
+    /* duplicate patterns are rejected */
+    assert(json_trie_add(&trie, "Mount.Target", 0) == JSON_BAD_PARAMETER);
+
+    printf("=== %s: %zu bytes\n", arg0, size);
+
+    _bench("match", MODE_MATCH, NULL, json, size, iterations, &stats[0]);
+    _bench("trie", MODE_TRIE, &trie, json, size, iterations, &stats[1]);
+    _bench("slice", MODE_SLICE, &trie, json, size, iterations, &stats[2]);
+
+    assert(memcmp(&stats[0], &stats[1], sizeof(stats_t)) == 0);
+    assert(memcmp(&stats[0], &stats[2], sizeof(stats_t)) == 0);
+
+    assert(stats[0].values[10] == num_env);
+    assert(stats[0].values[15] == num_mounts);
+    assert(stats[0].values[17] == 2 * num_mounts);
+
+    /* unescaping a slice */
+    {
+        const char text[] = "a\\\"b\\u0041\\n";
+        json_slice_t slice = {text, sizeof(text) - 1};
+        char buf[sizeof(text)];
+
+        assert(json_slice_unescape(&slice, buf, sizeof(buf)) == JSON_OK);
+        assert(strcmp(buf, "a\"bA\n") == 0);
+        assert(json_slice_unescape(&slice, buf, 3) == JSON_BUFFER_OVERFLOW);
+    }
+
+    free(json);
+
+    printf("=== passed test (%s)\n", arg0);
+
+    return 0;
+}
@@ -0,0 +1,159 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <assert.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* files whose contents the kernel produces when they are first used */
+#define RESOLV_CONF "/etc/resolv.conf"
+#define CERT_PATH "/tmp/myst.crt"
+#define PKEY_PATH "/tmp/myst.key"
+#define REPORT_PATH "/tmp/myst.report"
+
+#define NTHREADS 8
+#define MAX_SIZE (64 * 1024)
+
+typedef struct reader
+{
+    pthread_t thread;
+    const char* path;
+    char data[MAX_SIZE];
+    ssize_t size;
+} reader_t;
+
+static pthread_barrier_t _barrier;
+
+static ssize_t _read_file(const char* path, char* data, size_t size)
+{
+    int fd;
+    ssize_t n = 0;
+    ssize_t r;
+
+    assert((fd = open(path, O_RDONLY)) >= 0);
+
+    while ((r = read(fd, data + n, size - n)) > 0)
+        n += r;
+
+    assert(r == 0);
+    assert(close(fd) == 0);
+
+    return n;
+}
+
+static void* _reader(void* arg)
+{
+    reader_t* reader = (reader_t*)arg;
+
+    /* make the threads race for the first use */
+    pthread_barrier_wait(&_barrier);
+    reader->size = _read_file(reader->path, reader->data, MAX_SIZE);
+
+    return NULL;
+}
+
+/* read the given files from several threads at once: the contents must be
+ * produced once and every thread must see all of them */
+static void _read_concurrently(const char* paths[], size_t npaths)
+{
+    static reader_t readers[NTHREADS];
+
+    assert(pthread_barrier_init(&_barrier, NULL, NTHREADS) == 0);
+
+    for (size_t i = 0; i < NTHREADS; i++)
+    {
+        reader_t* reader = &readers[i];
+
+        reader->path = paths[i % npaths];
+        assert(pthread_create(&reader->thread, NULL, _reader, reader) == 0);
+    }
+
+    for (size_t i = 0; i < NTHREADS; i++)
+        assert(pthread_join(readers[i].thread, NULL) == 0);
+
+    for (size_t i = npaths; i < NTHREADS; i++)
+    {
+        const reader_t* first = &readers[i % npaths];
+
+        assert(readers[i].size == first->size);
+        assert(memcmp(readers[i].data, first->data, first->size) == 0);
+    }
+
+    for (size_t i = 0; i < npaths; i++)
+    {
+        struct stat buf;
+
+        assert(stat(paths[i], &buf) == 0);
+        assert(S_ISREG(buf.st_mode));
+        assert(buf.st_size == readers[i].size);
+    }
+
+    assert(pthread_barrier_destroy(&_barrier) == 0);
+}
+
+static void test_resolv_conf(void)
+{
+    const char* paths[] = {RESOLV_CONF};
+    const char text[] = "nameserver 127.0.0.1\n";
+    char data[MAX_SIZE];
+    struct stat buf;
+    int fd;
+
+    _read_concurrently(paths, 1);
+
+    /* the host file was loaded */
+    assert(stat(RESOLV_CONF, &buf) == 0);
+    assert(buf.st_size > 0);
+
+    /* once loaded, it is an ordinary file */
+    assert((fd = open(RESOLV_CONF, O_WRONLY | O_TRUNC)) >= 0);
+    assert(write(fd, text, sizeof(text) - 1) == sizeof(text) - 1);
+    assert(close(fd) == 0);
+
+    assert(_read_file(RESOLV_CONF, data, sizeof(data)) == sizeof(text) - 1);
+    assert(memcmp(data, text, sizeof(text) - 1) == 0);
+
+    printf("=== passed test (%s)\n", __FUNCTION__);
+}
+
+static void test_credentials(void)
+{
+    const char* paths[] = {CERT_PATH, PKEY_PATH, REPORT_PATH};
+    char data[MAX_SIZE];
+    ssize_t n;
+
+    /* one generation fills every file, whichever is used first */
+    _read_concurrently(paths, 3);
+
+    n = _read_file(CERT_PATH, data, sizeof(data) - 1);
+    data[n] = '\0';
+    assert(strstr(data, "BEGIN CERTIFICATE"));
+
+    n = _read_file(PKEY_PATH, data, sizeof(data) - 1);
+    data[n] = '\0';
+    assert(strstr(data, "PRIVATE KEY"));
+
+    assert(_read_file(REPORT_PATH, data, sizeof(data)) > 0);
+
+    printf("=== passed test (%s)\n", __FUNCTION__);
+}
+
+int main(int argc, const char* argv[])
+{
+    const char* target = getenv("MYST_TARGET");
+
+    test_resolv_conf();
+
+    /* only the SGX target can generate credentials */
+    if (target && strcmp(target, "sgx") == 0)
+        test_credentials();
+
+    printf("=== passed test (%s)\n", argv[0]);
+
+    return 0;
+}
@@ -0,0 +1,115 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mount.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Resolving /data/l1 takes the shared lock of the root ramfs, crosses into
+ * the ramfs mounted on /mnt/ramfs and comes back to the root ramfs through
+ * an absolute symlink, so it takes the root's shared lock a second time.
+ * Writers that queue for the exclusive lock in between must neither deadlock
+ * with these readers nor be starved by them.
+ *
+ *     /data/l1 -> /mnt/ramfs/l2 -> /data/file
+ */
+
+#define IMAGE "/ramfs_image"
+#define MNT "/mnt/ramfs"
+#define FILE_PATH "/data/file"
+#define LINK1 "/data/l1"
+#define LINK2 MNT "/l2"
+
+#define NREADERS 4
+#define NWRITERS 2
+#define ITERATIONS 2000
+
+static const char _data[] = "lockfs";
+
+static void* _reader(void* arg)
+{
+    (void)arg;
+
+    for (size_t i = 0; i < ITERATIONS; i++)
+    {
+        struct stat st;
+        char path[PATH_MAX];
+
+        assert(stat(LINK1, &st) == 0);
+        assert(st.st_size == sizeof(_data));
+        assert(access(LINK1, R_OK) == 0);
+        assert(realpath(LINK1, path));
+        assert(strcmp(path, FILE_PATH) == 0);
+    }
+
+    return NULL;
+}
+
+static void* _writer(void* arg)
+{
+    char path[PATH_MAX];
+    int fd;
+
+    snprintf(path, sizeof(path), "/data/w%ld", (long)arg);
+
+    for (size_t i = 0; i < ITERATIONS; i++)
+    {
+        assert((fd = open(path, O_CREAT | O_WRONLY | O_TRUNC, 0666)) >= 0);
+        assert(write(fd, _data, sizeof(_data)) == sizeof(_data));
+        assert(close(fd) == 0);
+        assert(unlink(path) == 0);
+    }
+
+    return NULL;
+}
+
+static void test_recursive_shared_lock(void)
+{
+    pthread_t readers[NREADERS];
+    pthread_t writers[NWRITERS];
+    int fd;
+
+    assert(mkdir("/data", 0777) == 0);
+    assert(mkdir("/mnt", 0777) == 0 || errno == EEXIST);
+    assert(mkdir(MNT, 0777) == 0);
+    assert(mount(IMAGE, MNT, "ramfs", 0, NULL) == 0);
+
+    assert((fd = open(FILE_PATH, O_CREAT | O_WRONLY, 0666)) >= 0);
+    assert(write(fd, _data, sizeof(_data)) == sizeof(_data));
+    assert(close(fd) == 0);
+    assert(symlink(FILE_PATH, LINK2) == 0);
+    assert(symlink(LINK2, LINK1) == 0);
+
+    for (long i = 0; i < NREADERS; i++)
+        assert(pthread_create(&readers[i], NULL, _reader, NULL) == 0);
+
+    for (long i = 0; i < NWRITERS; i++)
+        assert(pthread_create(&writers[i], NULL, _writer, (void*)i) == 0);
+
+    for (size_t i = 0; i < NREADERS; i++)
+        assert(pthread_join(readers[i], NULL) == 0);
+
+    for (size_t i = 0; i < NWRITERS; i++)
+        assert(pthread_join(writers[i], NULL) == 0);
+
+    assert(umount(MNT) == 0);
+
+    printf("=== passed test (%s)\n", __FUNCTION__);
+}
+
+int main(int argc, const char* argv[])
+{
+    test_recursive_shared_lock();
+
+    printf("=== passed test (%s)\n", argv[0]);
+
+    return 0;
+}
@@ -0,0 +1,139 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#define _GNU_SOURCE
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MEMBARRIER_CMD_QUERY 0
+#define MEMBARRIER_CMD_PRIVATE_EXPEDITED (1 << 3)
+#define MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED (1 << 4)
+
+#ifndef PAGE_SIZE
+#define PAGE_SIZE 4096
+#endif
+
+#define NTHREADS 4
+#define ITERATIONS 10000
+
+static volatile int _stop;
+
+static long _membarrier(int cmd, unsigned int flags)
+{
+    return syscall(SYS_membarrier, cmd, flags, 0);
+}
+
+static uint64_t _now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+static void* _spin(void* arg)
+{
+    volatile uint64_t* counter = arg;
+
+    while (!_stop)
+        (*counter)++;
+
+    return NULL;
+}
+
+static void test_membarrier(void)
+{
+    long mask = _membarrier(MEMBARRIER_CMD_QUERY, 0);
+
+    assert(mask >= 0);
+    assert(mask & MEMBARRIER_CMD_PRIVATE_EXPEDITED);
+    assert(mask & MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED);
+
+    /* the process must register first */
+    assert(_membarrier(MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0) == -1);
+    assert(errno == EPERM);
+
+    assert(_membarrier(MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0) == 0);
+    assert(_membarrier(MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0) == 0);
+
+    /* bad flags and unsupported commands */
+    assert(_membarrier(MEMBARRIER_CMD_PRIVATE_EXPEDITED, 1) == -1);
+    assert(errno == EINVAL);
+    assert(_membarrier(1 << 30, 0) == -1);
+    assert(errno == EINVAL);
+
+    printf("=== passed test (%s)\n", __FUNCTION__);
+}
+
+/* what runtimes do when membarrier() is missing: changing the protection of
+ * a dirty page makes the OS interrupt every CPU running the process */
+static void _flush_process_write_buffers(uint8_t* page)
+{
+    *page = 1;
+    assert(mprotect(page, PAGE_SIZE, PROT_READ) == 0);
+    assert(mprotect(page, PAGE_SIZE, PROT_READ | PROT_WRITE) == 0);
+}
+
+static void bench_membarrier(void)
+{
+    pthread_t threads[NTHREADS];
+    uint64_t counters[NTHREADS] = {0};
+    uint64_t start;
+    uint64_t membarrier_nsec;
+    uint64_t mprotect_nsec;
+    uint8_t* page;
+
+    page = mmap(
+        NULL,
+        PAGE_SIZE,
+        PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS,
+        -1,
+        0);
+    assert(page != MAP_FAILED);
+
+    /* other threads must be running for the barrier to do any work */
+    for (size_t i = 0; i < NTHREADS; i++)
+        assert(pthread_create(&threads[i], NULL, _spin, &counters[i]) == 0);
+
+    start = _now();
+    for (size_t i = 0; i < ITERATIONS; i++)
+        assert(_membarrier(MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0) == 0);
+    membarrier_nsec = _now() - start;
+
+    start = _now();
+    for (size_t i = 0; i < ITERATIONS; i++)
+        _flush_process_write_buffers(page);
+    mprotect_nsec = _now() - start;
+
+    _stop = 1;
+
+    for (size_t i = 0; i < NTHREADS; i++)
+        assert(pthread_join(threads[i], NULL) == 0);
+
+    assert(munmap(page, PAGE_SIZE) == 0);
+
+    printf(
+        "membarrier: %lu nsec/call, mprotect fallback: %lu nsec/call\n",
+        membarrier_nsec / ITERATIONS,
+        mprotect_nsec / ITERATIONS);
+
+    printf("=== passed test (%s)\n", __FUNCTION__);
+}
+
+int main(int argc, const char* argv[])
+{
+    test_membarrier();
+    bench_membarrier();
+
+    printf("=== passed test (%s)\n", argv[0]);
+
+    return 0;
+}
@@ -2,6 +2,7 @@
 // Licensed under the MIT License.
 
 #include <assert.h>
+#include <errno.h>
 #include <limits.h>
 #include <malloc.h>
 #include <stdarg.h>
@@ -29,6 +30,17 @@ int myst_tcall_mprotect(void* addr, size_t len, int prot)
     return mprotect(addr, len, prot);
 }
 
+/* set to false to test the SGX path, where pages cannot be released */
+static bool _host_madvise = true;
+
+int myst_tcall_madvise(void* addr, size_t len, int advice)
+{
+    if (!_host_madvise)
+        return -ENOTSUP;
+
+    return madvise(addr, len, advice) == 0 ? 0 : -errno;
+}
+
 void __myst_panic(
     const char* file,
     size_t line,
@@ -1390,6 +1402,102 @@ void test_prot_vector()
     printf("=== passed test (%s)\n", __FUNCTION__);
 }
 
+static bool _is_filled(const void* addr, size_t length, uint8_t c)
+{
+    const uint8_t* p = addr;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        if (p[i] != c)
+            return false;
+    }
+
+    return true;
+}
+
+void test_madvise()
+{
+    myst_mman_t h;
+    const size_t heap_size = 64 * 1024 * 1024;
+    int flags = MYST_MAP_ANONYMOUS | MYST_MAP_PRIVATE;
+    int rw = MYST_PROT_READ | MYST_PROT_WRITE;
+    int prot_val;
+    bool consistent;
+    uint8_t* addr;
+    void* brk = NULL;
+
+    assert(_init_mman(&h, heap_size) == 0);
+
+    if (myst_mman_mmap(&h, NULL, 8 * PAGE_SIZE, rw, flags, (void**)&addr) != 0)
+    {
+        printf("ERROR: myst_mman_mmap(): %s\n", h.err);
+        assert("myst_mman_mmap(): failed" == NULL);
+    }
+
+    assert(myst_mman_brk(&h, (void*)(h.start + PAGE_SIZE), &brk) == 0);
+
+    /* bad parameters */
+    assert(myst_mman_madvise(&h, addr, 0, MYST_MADV_DONTNEED) == 0);
+    assert(myst_mman_madvise(&h, addr + 1, 1, MYST_MADV_DONTNEED) == -EINVAL);
+    assert(myst_mman_madvise(&h, addr, PAGE_SIZE, 1000) == -EINVAL);
+    assert(
+        myst_mman_madvise(&h, (void*)h.brk, PAGE_SIZE, MYST_MADV_NORMAL) ==
+        -ENOMEM);
+    assert(
+        myst_mman_madvise(&h, (void*)h.end, PAGE_SIZE, MYST_MADV_NORMAL) ==
+        -ENOMEM);
+    assert(
+        myst_mman_madvise(
+            &h, (void*)h.start, PAGE_SIZE, MYST_MADV_WILLNEED) == 0);
+
+    /* the host releases the pages */
+    memset(addr, 0xff, 8 * PAGE_SIZE);
+    assert(
+        myst_mman_madvise(
+            &h, addr + 2 * PAGE_SIZE, 4 * PAGE_SIZE, MYST_MADV_DONTNEED) == 0);
+    assert(_is_filled(addr, 2 * PAGE_SIZE, 0xff));
+    assert(_is_filled(addr + 2 * PAGE_SIZE, 4 * PAGE_SIZE, 0));
+    assert(_is_filled(addr + 6 * PAGE_SIZE, 2 * PAGE_SIZE, 0xff));
+    assert(h.dontneed_size == 4 * PAGE_SIZE);
+    assert(h.released_size == 4 * PAGE_SIZE);
+
+    assert(myst_mman_madvise(&h, addr, PAGE_SIZE, MYST_MADV_FREE) == 0);
+    assert(h.lazyfree_size == PAGE_SIZE);
+
+    /* the host refuses: zero-fill accessible pages and defer the others */
+    _host_madvise = false;
+    memset(addr, 0xff, 8 * PAGE_SIZE);
+    _mman_protect(&h, addr, 2 * PAGE_SIZE, MYST_PROT_READ);
+    _mman_protect(&h, addr + 6 * PAGE_SIZE, 2 * PAGE_SIZE, MYST_PROT_NONE);
+    assert(
+        myst_mman_madvise(&h, addr, 8 * PAGE_SIZE, MYST_MADV_DONTNEED) == 0);
+    assert(h.dontneed_size == 12 * PAGE_SIZE);
+    assert(h.released_size == 4 * PAGE_SIZE);
+
+    _mman_get_prot(&h, addr, 2 * PAGE_SIZE, &prot_val, &consistent);
+    assert(prot_val == MYST_PROT_READ && consistent);
+    assert(_is_filled(addr, 6 * PAGE_SIZE, 0));
+
+    _mman_get_prot(&h, addr + 6 * PAGE_SIZE, PAGE_SIZE, &prot_val, &consistent);
+    assert(prot_val == 0x80 /* MYST_PENDING_ZEROING_FLAG */);
+    _mman_protect(&h, addr + 6 * PAGE_SIZE, 2 * PAGE_SIZE, rw);
+    assert(_is_filled(addr + 6 * PAGE_SIZE, 2 * PAGE_SIZE, 0));
+
+    /* MADV_FREE keeps the contents when the host refuses */
+    memset(addr + 6 * PAGE_SIZE, 0xff, PAGE_SIZE);
+    assert(
+        myst_mman_madvise(
+            &h, addr + 6 * PAGE_SIZE, PAGE_SIZE, MYST_MADV_FREE) == 0);
+    assert(_is_filled(addr + 6 * PAGE_SIZE, PAGE_SIZE, 0xff));
+    assert(h.lazyfree_size == PAGE_SIZE);
+    _host_madvise = true;
+
+    assert(myst_mman_is_sane(&h));
+
+    _free_mman(&h);
+    printf("=== passed test (%s)\n", __FUNCTION__);
+}
+
 void test_mman(void)
 {
     test_mman_1();
@@ -1406,4 +1514,5 @@ void test_mman(void)
     test_out_of_memory();
     test_mman_randomly();
     test_prot_vector();
+    test_madvise();
 }
@@ -0,0 +1,351 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#define _GNU_SOURCE
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <spawn.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MPOL_DEFAULT 0
+#define MPOL_PREFERRED 1
+#define MPOL_BIND 2
+#define MPOL_INTERLEAVE 3
+#define MPOL_F_STATIC_NODES (1 << 15)
+#define MPOL_F_RELATIVE_NODES (1 << 14)
+#define MPOL_F_NODE (1 << 0)
+#define MPOL_F_ADDR (1 << 1)
+#define MPOL_F_MEMS_ALLOWED (1 << 2)
+#define MPOL_MF_MOVE (1 << 1)
+
+#define MAXNODE 64
+#define PAGE_SIZE 4096
+#define ITERATIONS 100000
+
+#define CPULIST_PATH "/sys/devices/system/node/node%u/cpulist"
+
+static long _getcpu(unsigned* cpu, unsigned* node)
+{
+    return syscall(SYS_getcpu, cpu, node, NULL);
+}
+
+static long _set_mempolicy(int mode, const unsigned long* mask)
+{
+    return syscall(SYS_set_mempolicy, mode, mask, MAXNODE + 1);
+}
+
+static long _get_mempolicy(
+    int* mode,
+    unsigned long* mask,
+    void* addr,
+    unsigned long flags)
+{
+    return syscall(SYS_get_mempolicy, mode, mask, MAXNODE, addr, flags);
+}
+
+static long _mbind(
+    void* addr,
+    size_t len,
+    int mode,
+    const unsigned long* mask,
+    unsigned flags)
+{
+    return syscall(SYS_mbind, addr, len, mode, mask, MAXNODE + 1, flags);
+}
+
+static uint64_t _now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+static void _read_file(const char* path, char* buf, size_t size)
+{
+    int fd = open(path, O_RDONLY);
+    ssize_t n;
+
+    assert(fd >= 0);
+    n = read(fd, buf, size - 1);
+    assert(n > 0);
+    buf[n] = '\0';
+    assert(close(fd) == 0);
+}
+
+static unsigned long _online_nodes(void)
+{
+    unsigned long mask = 0;
+    int mode = -1;
+
+    assert(_get_mempolicy(&mode, &mask, NULL, MPOL_F_MEMS_ALLOWED) == 0);
+    assert(mode == MPOL_DEFAULT);
+    assert(mask != 0);
+
+    return mask;
+}
+
+static void test_getcpu(void)
+{
+    const long ncpus = sysconf(_SC_NPROCESSORS_CONF);
+    const unsigned long nodes = _online_nodes();
+    unsigned cpu = -1;
+    unsigned node = -1;
+
+    assert(_getcpu(&cpu, &node) == 0);
+    assert(cpu < (unsigned)ncpus);
+    assert(node < MAXNODE && (nodes & (1UL << node)));
+
+    /* either argument may be null */
+    assert(_getcpu(NULL, &node) == 0);
+    assert(_getcpu(&cpu, NULL) == 0);
+
+    /* the reported CPU follows the affinity of the thread */
+    {
+        cpu_set_t set;
+
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        assert(sched_setaffinity(0, sizeof(set), &set) == 0);
+        sched_yield();
+
+        for (size_t i = 0; i < 100; i++)
+        {
+            unsigned c;
+            assert(_getcpu(&c, NULL) == 0);
+            assert(c == cpu);
+        }
+
+        for (long i = 0; i < ncpus; i++)
+            CPU_SET(i, &set);
+        assert(sched_setaffinity(0, sizeof(set), &set) == 0);
+    }
+
+    printf("=== passed test (%s)\n", __FUNCTION__);
+}
+
+static void test_sysfs(void)
+{
+    const unsigned long nodes = _online_nodes();
+    char buf[4096];
+    char path[128];
+
+    _read_file("/sys/devices/system/cpu/online", buf, sizeof(buf));
+    assert(buf[0] >= '0' && buf[0] <= '9');
+
+    _read_file("/sys/devices/system/node/online", buf, sizeof(buf));
+    assert(buf[0] >= '0' && buf[0] <= '9');
+
+    for (unsigned node = 0; node < MAXNODE; node++)
+    {
+        if (!(nodes & (1UL << node)))
+            continue;
+
+        snprintf(path, sizeof(path), CPULIST_PATH, node);
+        _read_file(path, buf, sizeof(buf));
+    }
+
+    printf("=== passed test (%s)\n", __FUNCTION__);
+}
+
+static void test_mempolicy(void)
+{
+    const unsigned long nodes = _online_nodes();
+    const unsigned long first = nodes & -nodes;
+    unsigned long mask = 0;
+    int mode = -1;
+
+    /* the default policy */
+    assert(_get_mempolicy(&mode, &mask, NULL, 0) == 0);
+    assert(mode == MPOL_DEFAULT);
+    assert(mask == 0);
+
+    assert(_set_mempolicy(MPOL_BIND, &first) == 0);
+    assert(_get_mempolicy(&mode, &mask, NULL, 0) == 0);
+    assert(mode == MPOL_BIND);
+    assert(mask == first);
+
+    /* MPOL_F_NODE needs an interleave policy */
+    assert(_get_mempolicy(&mode, NULL, NULL, MPOL_F_NODE) == -1);
+    assert(errno == EINVAL);
+
+    assert(_set_mempolicy(MPOL_INTERLEAVE, &nodes) == 0);
+    assert(_get_mempolicy(&mode, NULL, NULL, MPOL_F_NODE) == 0);
+    assert(nodes & (1UL << mode));
+
+    assert(_set_mempolicy(MPOL_PREFERRED | MPOL_F_STATIC_NODES, &first) == 0);
+    assert(_get_mempolicy(&mode, NULL, NULL, 0) == 0);
+    assert(mode == (MPOL_PREFERRED | MPOL_F_STATIC_NODES));
+
+    assert(_set_mempolicy(MPOL_DEFAULT, NULL) == 0);
+    assert(_get_mempolicy(&mode, &mask, NULL, 0) == 0);
+    assert(mode == MPOL_DEFAULT);
+    assert(mask == 0);
+
+    /* invalid policies */
+    assert(_set_mempolicy(MPOL_BIND, NULL) == -1 && errno == EINVAL);
+    assert(_set_mempolicy(MPOL_DEFAULT, &first) == -1 && errno == EINVAL);
+    assert(_set_mempolicy(100, NULL) == -1 && errno == EINVAL);
+    assert(
+        _set_mempolicy(
+            MPOL_BIND | MPOL_F_STATIC_NODES | MPOL_F_RELATIVE_NODES, &first) ==
+        -1);
+    assert(errno == EINVAL);
+
+    if (~nodes)
+    {
+        const unsigned long offline = ~nodes & -~nodes;
+        assert(_set_mempolicy(MPOL_BIND, &offline) == -1 && errno == EINVAL);
+    }
+
+    /* bad flags and addresses */
+    assert(_get_mempolicy(&mode, NULL, NULL, 0x100) == -1 && errno == EINVAL);
+    assert(_get_mempolicy(&mode, NULL, &mode, 0) == -1 && errno == EINVAL);
+    assert(
+        _get_mempolicy(&mode, NULL, NULL, MPOL_F_MEMS_ALLOWED | MPOL_F_NODE) ==
+        -1);
+    assert(errno == EINVAL);
+
+    printf("=== passed test (%s)\n", __FUNCTION__);
+}
+
+static void test_mbind(void)
+{
+    const unsigned long nodes = _online_nodes();
+    const unsigned long first = nodes & -nodes;
+    const size_t size = 16 * PAGE_SIZE;
+    unsigned long mask = 0;
+    int mode = -1;
+    char* p;
+    char* q;
+
+    p = mmap(
+        NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    assert(p != MAP_FAILED);
+
+    assert(_mbind(p, size, MPOL_BIND, &first, 0) == 0);
+    assert(_get_mempolicy(&mode, &mask, p + size - 1, MPOL_F_ADDR) == 0);
+    assert(mode == MPOL_BIND && mask == first);
+
+    /* a policy for part of the range splits the recorded one */
+    assert(_mbind(p + PAGE_SIZE, PAGE_SIZE, MPOL_PREFERRED, &first, 0) == 0);
+    assert(_get_mempolicy(&mode, &mask, p, MPOL_F_ADDR) == 0);
+    assert(mode == MPOL_BIND && mask == first);
+    assert(_get_mempolicy(&mode, &mask, p + PAGE_SIZE, MPOL_F_ADDR) == 0);
+    assert(mode == MPOL_PREFERRED && mask == first);
+    assert(_get_mempolicy(&mode, &mask, p + 2 * PAGE_SIZE, MPOL_F_ADDR) == 0);
+    assert(mode == MPOL_BIND && mask == first);
+
+    assert(_mbind(p, size, MPOL_PREFERRED, &first, MPOL_MF_MOVE) == 0);
+    memset(p, 0xab, size);
+    assert(_mbind(p, size, MPOL_DEFAULT, NULL, 0) == 0);
+    assert(_get_mempolicy(&mode, &mask, p, MPOL_F_ADDR) == 0);
+    assert(mode == MPOL_DEFAULT && mask == 0);
+
+    /* the thread's policy does not show as the policy of a range */
+    assert(_set_mempolicy(MPOL_BIND, &first) == 0);
+    q = mmap(
+        NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    assert(q != MAP_FAILED);
+    memset(q, 0xcd, size);
+    assert(_get_mempolicy(&mode, &mask, q, MPOL_F_ADDR) == 0);
+    assert(mode == MPOL_DEFAULT && mask == 0);
+    assert(_set_mempolicy(MPOL_DEFAULT, NULL) == 0);
+
+    /* unmapped pages lose their policy */
+    assert(_mbind(q, size, MPOL_BIND, &first, 0) == 0);
+    assert(munmap(q, size) == 0);
+    assert(_get_mempolicy(&mode, NULL, q, MPOL_F_ADDR) == -1);
+    assert(errno == EFAULT);
+
+    /* the node that backs the page */
+    assert(_get_mempolicy(&mode, NULL, p, MPOL_F_ADDR | MPOL_F_NODE) == 0);
+    assert(nodes & (1UL << mode));
+
+    /* an empty range is ignored */
+    assert(_mbind(p, 0, MPOL_BIND, &first, 0) == 0);
+
+    /* invalid arguments */
+    assert(_mbind(p + 1, PAGE_SIZE, MPOL_BIND, &first, 0) == -1);
+    assert(errno == EINVAL);
+    assert(_mbind(p, size, MPOL_BIND, NULL, 0) == -1 && errno == EINVAL);
+    assert(_mbind(p, size, MPOL_BIND, &first, 0x80) == -1 && errno == EINVAL);
+
+    assert(munmap(p, size) == 0);
+
+    printf("=== passed test (%s)\n", __FUNCTION__);
+}
+
+/* the child started by test_inherit() checks the policy it inherited */
+static int _child(void)
+{
+    const unsigned long nodes = _online_nodes();
+    const unsigned long first = nodes & -nodes;
+    unsigned long mask = 0;
+    int mode = -1;
+
+    assert(_get_mempolicy(&mode, &mask, NULL, 0) == 0);
+    assert(mode == MPOL_BIND);
+    assert(mask == first);
+
+    return 0;
+}
+
+static void test_inherit(const char* path)
+{
+    const unsigned long nodes = _online_nodes();
+    const unsigned long first = nodes & -nodes;
+    char* argv[] = {(char*)path, "child", NULL};
+    pid_t pid;
+    int status;
+
+    /* the policy survives the fork and the exec of posix_spawn() */
+    assert(_set_mempolicy(MPOL_BIND, &first) == 0);
+    assert(posix_spawn(&pid, path, NULL, NULL, argv, NULL) == 0);
+    assert(waitpid(pid, &status, 0) == pid);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    assert(_set_mempolicy(MPOL_DEFAULT, NULL) == 0);
+
+    printf("=== passed test (%s)\n", __FUNCTION__);
+}
+
+static void bench_getcpu(void)
+{
+    unsigned cpu;
+    uint64_t start;
+    uint64_t nsec;
+
+    start = _now();
+    for (size_t i = 0; i < ITERATIONS; i++)
+        assert(_getcpu(&cpu, NULL) == 0);
+    nsec = _now() - start;
+
+    printf("getcpu: %lu nsec/call\n", nsec / ITERATIONS);
+
+    printf("=== passed test (%s)\n", __FUNCTION__);
+}
+
+int main(int argc, const char* argv[])
+{
+    if (argc == 2 && strcmp(argv[1], "child") == 0)
+        return _child();
+
+    test_getcpu();
+    test_sysfs();
+    test_mempolicy();
+    test_mbind();
+    test_inherit(argv[0]);
+    bench_getcpu();
+
+    printf("=== passed test (%s)\n", argv[0]);
+
+    return 0;
+}
@@ -0,0 +1,342 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#define _GNU_SOURCE
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <spawn.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+extern char** environ;
+
+#define RSEQ_FLAG_UNREGISTER (1 << 0)
+#define RSEQ_SIG 0x53053053
+
+#define NTHREADS 4
+#define ITERATIONS 100000
+
+struct rseq_area
+{
+    uint32_t cpu_id_start;
+    volatile uint32_t cpu_id;
+    volatile uint64_t rseq_cs;
+    uint32_t flags;
+} __attribute__((aligned(32)));
+
+static __thread struct rseq_area _rseq;
+
+static long _sys_rseq(struct rseq_area* rseq, uint32_t len, int flags)
+{
+    return syscall(SYS_rseq, rseq, len, flags, RSEQ_SIG);
+}
+
+static void _register(void)
+{
+    assert(_sys_rseq(&_rseq, sizeof(_rseq), 0) == 0);
+}
+
+static void _unregister(void)
+{
+    assert(_sys_rseq(&_rseq, sizeof(_rseq), RSEQ_FLAG_UNREGISTER) == 0);
+}
+
+/* add one to the counter of the current CPU (zero if not aborted) */
+static int _percpu_inc(uint64_t* counters, uint32_t* cpu_out)
+{
+    const uint32_t cpu = _rseq.cpu_id_start;
+
+    __asm__ __volatile__ goto(
+        ".pushsection __rseq_cs, \"aw\"\n\t"
+        ".balign 32\n\t"
+        "3:\n\t"
+        ".long 0x0, 0x0\n\t"
+        ".quad 1f, (2f - 1f), 4f\n\t"
+        ".popsection\n\t"
+        "leaq 3b(%%rip), %%rax\n\t"
+        "movq %%rax, %[rseq_cs]\n\t"
+        "1:\n\t"
+        "cmpl %[cpu], %[cpu_id]\n\t"
+        "jnz %l[abort]\n\t"
+        "addq $1, (%[counter])\n\t"
+        "2:\n\t"
+        ".pushsection __rseq_failure, \"ax\"\n\t"
+        ".long 0x53053053\n\t"
+        "4:\n\t"
+        "jmp %l[abort]\n\t"
+        ".popsection\n\t"
+        :
+        : [rseq_cs] "m"(_rseq.rseq_cs),
+          [cpu_id] "m"(_rseq.cpu_id),
+          [cpu] "r"(cpu),
+          [counter] "r"(&counters[cpu * 8])
+        : "memory", "cc", "rax"
+        : abort);
+
+    *cpu_out = cpu;
+    return 0;
+
+abort:
+    return -1;
+}
+
+/* run ud2 inside a critical section whose abort handler is preceded by the
+ * given signature (zero if not aborted) */
+#define FAULT_IN_CS(SIG)                                 \
+    __asm__ __volatile__ goto(                           \
+        ".pushsection __rseq_cs, \"aw\"\n\t"             \
+        ".balign 32\n\t"                                 \
+        "3:\n\t"                                         \
+        ".long 0x0, 0x0\n\t"                             \
+        ".quad 1f, (2f - 1f), 4f\n\t"                    \
+        ".popsection\n\t"                                \
+        "leaq 3b(%%rip), %%rax\n\t"                      \
+        "movq %%rax, %[rseq_cs]\n\t"                     \
+        "1:\n\t"                                         \
+        "ud2\n\t"                                        \
+        "2:\n\t"                                         \
+        ".pushsection __rseq_failure, \"ax\"\n\t"        \
+        ".long " #SIG "\n\t"                             \
+        "4:\n\t"                                         \
+        "jmp %l[abort]\n\t"                              \
+        ".popsection\n\t"                                \
+        :                                                \
+        : [rseq_cs] "m"(_rseq.rseq_cs)                   \
+        : "memory", "cc", "rax"                          \
+        : abort)
+
+static int _fault_in_cs(void)
+{
+    FAULT_IN_CS(0x53053053);
+    return 0;
+
+abort:
+    return -1;
+}
+
+static int _fault_in_cs_bad_sig(void)
+{
+    FAULT_IN_CS(0x12345678);
+    return 0;
+
+abort:
+    return -1;
+}
+
+static void test_register(void)
+{
+    struct rseq_area other;
+
+    _register();
+    assert(_rseq.cpu_id != (uint32_t)-1);
+    assert(_rseq.cpu_id == _rseq.cpu_id_start);
+    assert(_rseq.cpu_id < (uint32_t)sysconf(_SC_NPROCESSORS_CONF));
+
+    /* registering again */
+    assert(_sys_rseq(&_rseq, sizeof(_rseq), 0) == -1 && errno == EBUSY);
+    assert(syscall(SYS_rseq, &_rseq, sizeof(_rseq), 0, 0) == -1);
+    assert(errno == EPERM);
+    assert(_sys_rseq(&other, sizeof(other), 0) == -1 && errno == EINVAL);
+
+    /* unregistering with the wrong arguments */
+    assert(_sys_rseq(&other, sizeof(other), RSEQ_FLAG_UNREGISTER) == -1);
+    assert(errno == EINVAL);
+    assert(_sys_rseq(&_rseq, 16, RSEQ_FLAG_UNREGISTER) == -1);
+    assert(errno == EINVAL);
+    assert(syscall(SYS_rseq, &_rseq, sizeof(_rseq), 1, 0) == -1);
+    assert(errno == EPERM);
+
+    _unregister();
+    assert(_rseq.cpu_id == (uint32_t)-1);
+    assert(_sys_rseq(&_rseq, sizeof(_rseq), RSEQ_FLAG_UNREGISTER) == -1);
+    assert(errno == EINVAL);
+
+    /* invalid areas and flags */
+    assert(_sys_rseq((void*)((char*)&other + 8), 32, 0) == -1);
+    assert(errno == EINVAL);
+    assert(_sys_rseq(&_rseq, 16, 0) == -1 && errno == EINVAL);
+    assert(_sys_rseq(&_rseq, sizeof(_rseq), 0x80) == -1 && errno == EINVAL);
+    assert(_sys_rseq((void*)32, 32, 0) == -1 && errno == EFAULT);
+
+    printf("=== passed test (%s)\n", __FUNCTION__);
+}
+
+static uint64_t _counters[1024 * 8];
+static uint64_t _nincs[NTHREADS];
+
+static void* _counter_thread(void* arg)
+{
+    const size_t index = (size_t)arg;
+    const uint32_t ncpus = (uint32_t)sysconf(_SC_NPROCESSORS_CONF);
+
+    _register();
+
+    for (size_t i = 0; i < ITERATIONS; i++)
+    {
+        uint32_t cpu;
+
+        while (_percpu_inc(_counters, &cpu) != 0)
+            ;
+
+        assert(cpu < ncpus);
+        _nincs[index]++;
+
+        /* give the kernel a chance to move the thread */
+        if (i % 1000 == 0)
+            sched_yield();
+    }
+
+    _unregister();
+
+    return NULL;
+}
+
+static void test_percpu_counters(void)
+{
+    long nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+    pthread_t threads[NTHREADS];
+    uint64_t sum = 0;
+
+    if (nthreads > NTHREADS)
+        nthreads = NTHREADS;
+
+    for (long i = 0; i < nthreads; i++)
+    {
+        void* arg = (void*)i;
+        assert(pthread_create(&threads[i], NULL, _counter_thread, arg) == 0);
+    }
+
+    for (long i = 0; i < nthreads; i++)
+        assert(pthread_join(threads[i], NULL) == 0);
+
+    for (size_t i = 0; i < sizeof(_counters) / sizeof(_counters[0]); i++)
+        sum += _counters[i];
+
+    /* no increment was lost or done twice */
+    assert(sum == (uint64_t)nthreads * ITERATIONS);
+
+    for (long i = 0; i < nthreads; i++)
+        assert(_nincs[i] == ITERATIONS);
+
+    printf("=== passed test (%s)\n", __FUNCTION__);
+}
+
+static volatile int _nsigill;
+
+static void _sigill_handler(int sig, siginfo_t* si, void* context)
+{
+    ucontext_t* uc = (ucontext_t*)context;
+    const uint8_t* ip = (const uint8_t*)uc->uc_mcontext.gregs[REG_RIP];
+
+    (void)sig;
+    (void)si;
+
+    _nsigill++;
+
+    /* skip the ud2 if the critical section was not aborted */
+    if (ip[0] == 0x0f && ip[1] == 0x0b)
+        uc->uc_mcontext.gregs[REG_RIP] += 2;
+}
+
+static void test_abort_on_signal(void)
+{
+    struct sigaction act;
+
+    memset(&act, 0, sizeof(act));
+    act.sa_sigaction = _sigill_handler;
+    act.sa_flags = SA_SIGINFO;
+    assert(sigaction(SIGILL, &act, NULL) == 0);
+
+    _register();
+
+    /* the handler runs at the abort handler, not at the ud2 */
+    assert(_fault_in_cs() == -1);
+    assert(_nsigill == 1);
+
+    /* the kernel cleared the descriptor */
+    assert(_rseq.rseq_cs == 0);
+
+    _unregister();
+
+    printf("=== passed test (%s)\n", __FUNCTION__);
+}
+
+/* the child started by test_abort_failure() */
+static int _bad_sig_child(void)
+{
+    struct sigaction act;
+
+    memset(&act, 0, sizeof(act));
+    act.sa_sigaction = _sigill_handler;
+    act.sa_flags = SA_SIGINFO;
+    assert(sigaction(SIGILL, &act, NULL) == 0);
+
+    _register();
+
+    /* the abort handler has the wrong signature: SIGSEGV must kill the
+     * process before the SIGILL handler runs */
+    _fault_in_cs_bad_sig();
+
+    return 1;
+}
+
+static void test_abort_failure(const char* path)
+{
+    char* argv[] = {(char*)path, "bad-sig", NULL};
+    pid_t pid;
+    int status;
+
+    assert(posix_spawn(&pid, path, NULL, NULL, argv, environ) == 0);
+    assert(waitpid(pid, &status, 0) == pid);
+    assert(WIFSIGNALED(status));
+    assert(WTERMSIG(status) == SIGSEGV);
+
+    printf("=== passed test (%s)\n", __FUNCTION__);
+}
+
+static void test_fork(void)
+{
+    pid_t pid;
+    int status;
+
+    _register();
+
+    if ((pid = fork()) == 0)
+    {
+        /* the child is still registered, on a valid CPU id */
+        assert(_sys_rseq(&_rseq, sizeof(_rseq), 0) == -1 && errno == EBUSY);
+        assert(_rseq.cpu_id < (uint32_t)sysconf(_SC_NPROCESSORS_CONF));
+        _exit(0);
+    }
+
+    assert(pid > 0);
+    assert(waitpid(pid, &status, 0) == pid);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    _unregister();
+
+    printf("=== passed test (%s)\n", __FUNCTION__);
+}
+
+int main(int argc, const char* argv[])
+{
+    if (argc == 2 && strcmp(argv[1], "bad-sig") == 0)
+        return _bad_sig_child();
+
+    test_register();
+    test_percpu_counters();
+    test_abort_on_signal();
+    test_abort_failure(argv[0]);
+    test_fork();
+
+    printf("=== passed test (%s)\n", argv[0]);
+
+    return 0;
+}
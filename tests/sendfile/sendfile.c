@@ -8,13 +8,17 @@
 #include <assert.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
 #include <poll.h>
 #include <pthread.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <sys/sendfile.h>
 #include <sys/syscall.h>
 #include <sys/time.h>
+#include <sys/uio.h>
 #include <time.h>
 #include <unistd.h>
 
@@ -34,11 +38,105 @@ static void* _client_thread_func(void* arg)
     run_client(port);
 }
 
+/* move /bigfile through a pipe with splice() and check the copy */
+static void _test_splice(void)
+{
+    int in;
+    int out;
+    int pipefd[2];
+    char* data_in;
+    char* data_out;
+    size_t total = 0;
+    loff_t off_out = 0;
+
+    assert((in = open("/bigfile", O_RDONLY)) >= 0);
+    assert((out = open("/splicefile", O_RDWR | O_CREAT | O_TRUNC, 0666)) >= 0);
+    assert(pipe(pipefd) == 0);
+
+    /* splice() requires one end to be a pipe */
+    assert(splice(in, NULL, out, NULL, 1, 0) == -1 && errno == EINVAL);
+
+    /* pipe ends have no offset */
+    assert(splice(in, NULL, pipefd[1], &off_out, 1, 0) == -1);
+    assert(errno == ESPIPE);
+
+    while (total < BIG_FILE_SIZE)
+    {
+        ssize_t n = splice(in, NULL, pipefd[1], NULL, BIG_FILE_SIZE, 0);
+        assert(n > 0);
+
+        for (ssize_t r = n; r > 0;)
+        {
+            ssize_t m = splice(pipefd[0], NULL, out, &off_out, r, 0);
+            assert(m > 0);
+            r -= m;
+        }
+
+        total += n;
+    }
+
+    assert(off_out == BIG_FILE_SIZE);
+    assert(lseek(out, 0, SEEK_CUR) == 0);
+
+    assert((data_in = malloc(BIG_FILE_SIZE)));
+    assert((data_out = malloc(BIG_FILE_SIZE)));
+    assert(pread(in, data_in, BIG_FILE_SIZE, 0) == BIG_FILE_SIZE);
+    assert(pread(out, data_out, BIG_FILE_SIZE, 0) == BIG_FILE_SIZE);
+    assert(memcmp(data_in, data_out, BIG_FILE_SIZE) == 0);
+
+    /* vmsplice() copies user memory into the pipe */
+    {
+        char buf[4];
+        struct iovec iov = {.iov_base = "abcd", .iov_len = 4};
+
+        assert(vmsplice(pipefd[1], &iov, 1, 0) == 4);
+        assert(read(pipefd[0], buf, sizeof(buf)) == 4);
+        assert(memcmp(buf, "abcd", 4) == 0);
+    }
+
+    /* SPLICE_F_NONBLOCK fails rather than waiting on a pipe */
+    {
+        char buf[PIPE_BUF];
+        int pipesz;
+
+        assert(splice(pipefd[0], NULL, out, &off_out, 1, SPLICE_F_NONBLOCK) ==
+               -1);
+        assert(errno == EAGAIN);
+
+        assert((pipesz = fcntl(pipefd[1], F_GETPIPE_SZ)) > 0);
+        memset(buf, 0xab, sizeof(buf));
+
+        for (int i = 0; i < pipesz / PIPE_BUF; i++)
+            assert(write(pipefd[1], buf, sizeof(buf)) == sizeof(buf));
+
+        assert(splice(in, NULL, pipefd[1], NULL, 1, SPLICE_F_NONBLOCK) == -1);
+        assert(errno == EAGAIN);
+
+        /* no input was consumed */
+        assert(lseek(in, 0, SEEK_CUR) == BIG_FILE_SIZE);
+
+        for (int i = 0; i < pipesz / PIPE_BUF; i++)
+            assert(read(pipefd[0], buf, sizeof(buf)) == sizeof(buf));
+    }
+
+    free(data_in);
+    free(data_out);
+    close(pipefd[0]);
+    close(pipefd[1]);
+    close(in);
+    close(out);
+    unlink("/splicefile");
+
+    printf("=== passed splice test\n");
+}
+
 int main(int argc, const char* argv[])
 {
     pthread_t sthread;
     pthread_t cthread;
 
+    _test_splice();
+
     assert(pthread_create(&sthread, NULL, _server_thread_func, NULL) == 0);
     sleep_msec(100);
     assert(pthread_create(&cthread, NULL, _client_thread_func, NULL) == 0);
@@ -4,6 +4,7 @@
 // Copyright (c) Microsoft Corporation.
 // Licensed under the MIT License.
 
+#define _GNU_SOURCE
 #include <assert.h>
 #include <errno.h>
 #include <fcntl.h>
@@ -11,8 +12,10 @@
 #include <pthread.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <time.h>
 #include <unistd.h>
 
@@ -226,11 +229,273 @@ static void* _cli_thread_func(void* arg)
     return NULL;
 }
 
+/* send and receive batches of UDP datagrams with sendmmsg/recvmmsg */
+static void _test_mmsg(void)
+{
+    enum
+    {
+        N = 64
+    };
+    int rsock;
+    int ssock;
+    struct sockaddr_in addr;
+    socklen_t addrlen = sizeof(addr);
+    struct mmsghdr msgs[N];
+    struct iovec iovs[N][2];
+    char bufs[N][32];
+    struct sockaddr_in names[N];
+    struct timespec timeout = {5, 0};
+    int total = 0;
+
+    assert((rsock = socket(AF_INET, SOCK_DGRAM, 0)) >= 0);
+    assert((ssock = socket(AF_INET, SOCK_DGRAM, 0)) >= 0);
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    assert(bind(rsock, (struct sockaddr*)&addr, sizeof(addr)) == 0);
+    assert(getsockname(rsock, (struct sockaddr*)&addr, &addrlen) == 0);
+
+    /* send N datagrams, each gathered from two iovec elements */
+    memset(msgs, 0, sizeof(msgs));
+
+    for (int i = 0; i < N; i++)
+    {
+        snprintf(bufs[i], sizeof(bufs[i]), "message %d", i);
+        iovs[i][0].iov_base = bufs[i];
+        iovs[i][0].iov_len = 8;
+        iovs[i][1].iov_base = bufs[i] + 8;
+        iovs[i][1].iov_len = strlen(bufs[i]) - 8;
+        msgs[i].msg_hdr.msg_name = &addr;
+        msgs[i].msg_hdr.msg_namelen = sizeof(addr);
+        msgs[i].msg_hdr.msg_iov = iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 2;
+    }
+
+    assert(sendmmsg(ssock, msgs, N, 0) == N);
+
+    for (int i = 0; i < N; i++)
+        assert(msgs[i].msg_len == strlen(bufs[i]));
+
+    /* receive them in batches, scattering each datagram over two buffers */
+    while (total < N)
+    {
+        int n;
+
+        memset(msgs, 0, sizeof(msgs));
+        memset(bufs, 0, sizeof(bufs));
+
+        for (int i = 0; i < N; i++)
+        {
+            iovs[i][0].iov_base = bufs[i];
+            iovs[i][0].iov_len = 4;
+            iovs[i][1].iov_base = bufs[i] + 4;
+            iovs[i][1].iov_len = sizeof(bufs[i]) - 5;
+            msgs[i].msg_hdr.msg_name = &names[i];
+            msgs[i].msg_hdr.msg_namelen = sizeof(names[i]);
+            msgs[i].msg_hdr.msg_iov = iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 2;
+        }
+
+        n = recvmmsg(rsock, msgs, N - total, MSG_WAITFORONE, &timeout);
+        assert(n > 0);
+
+        for (int i = 0; i < n; i++)
+        {
+            char expect[32];
+
+            snprintf(expect, sizeof(expect), "message %d", total + i);
+            assert(msgs[i].msg_len == strlen(expect));
+            assert(strcmp(bufs[i], expect) == 0);
+            assert(msgs[i].msg_hdr.msg_namelen == sizeof(struct sockaddr_in));
+            assert(names[i].sin_family == AF_INET);
+        }
+
+        total += n;
+    }
+
+    /* nothing left to receive */
+    assert(recvmmsg(rsock, msgs, N, MSG_DONTWAIT, NULL) == -1);
+    assert(errno == EAGAIN);
+
+    close(ssock);
+    close(rsock);
+
+    printf("=== passed mmsg test\n");
+}
+
+/* writev() a header and a body that spans several transfers, then readv()
+ * them back into separate buffers */
+static void _test_vectored_stream(void)
+{
+    enum
+    {
+        HDR_SIZE = 64,
+        BODY_SIZE = 100 * 1024
+    };
+    int lsock;
+    int ssock;
+    int rsock;
+    struct sockaddr_in addr;
+    socklen_t addrlen = sizeof(addr);
+    char hdr[HDR_SIZE];
+    char* body;
+    char rhdr[HDR_SIZE];
+    char* rbody;
+    struct iovec iov[2];
+    size_t got = 0;
+
+    assert((body = malloc(BODY_SIZE)));
+    assert((rbody = calloc(1, BODY_SIZE)));
+
+    for (size_t i = 0; i < HDR_SIZE; i++)
+        hdr[i] = alpha[i % 26];
+
+    for (size_t i = 0; i < BODY_SIZE; i++)
+        body[i] = (char)(i * 7);
+
+    assert((lsock = socket(AF_INET, SOCK_STREAM, 0)) >= 0);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    assert(bind(lsock, (struct sockaddr*)&addr, sizeof(addr)) == 0);
+    assert(getsockname(lsock, (struct sockaddr*)&addr, &addrlen) == 0);
+    assert(listen(lsock, 1) == 0);
+
+    assert((ssock = socket(AF_INET, SOCK_STREAM, 0)) >= 0);
+    assert(connect(ssock, (struct sockaddr*)&addr, sizeof(addr)) == 0);
+    assert((rsock = accept(lsock, NULL, NULL)) >= 0);
+
+    iov[0].iov_base = hdr;
+    iov[0].iov_len = HDR_SIZE;
+    iov[1].iov_base = body;
+    iov[1].iov_len = BODY_SIZE;
+    assert(writev(ssock, iov, 2) == HDR_SIZE + BODY_SIZE);
+
+    while (got < HDR_SIZE + BODY_SIZE)
+    {
+        struct iovec* v = iov;
+        int n = 2;
+        ssize_t r;
+
+        iov[0].iov_base = rhdr + got;
+        iov[0].iov_len = HDR_SIZE - got;
+        iov[1].iov_base = rbody;
+        iov[1].iov_len = BODY_SIZE;
+
+        if (got >= HDR_SIZE)
+        {
+            iov[1].iov_base = rbody + (got - HDR_SIZE);
+            iov[1].iov_len = BODY_SIZE - (got - HDR_SIZE);
+            v = &iov[1];
+            n = 1;
+        }
+
+        assert((r = readv(rsock, v, n)) > 0);
+        got += (size_t)r;
+    }
+
+    assert(memcmp(rhdr, hdr, HDR_SIZE) == 0);
+    assert(memcmp(rbody, body, BODY_SIZE) == 0);
+
+    close(rsock);
+    close(ssock);
+    close(lsock);
+    free(body);
+    free(rbody);
+
+    printf("=== passed vectored stream test\n");
+}
+
+/* each writev() sends one datagram and each readv() receives one, however
+ * large the vector (the SGX target must not split them across calls) */
+static void _test_vectored_datagram(void)
+{
+    enum
+    {
+        HDR_SIZE = 64,
+        BODY_SIZE = 40 * 1024,
+        MAX_UDP_SIZE = 65507
+    };
+    int ssock;
+    int rsock;
+    struct sockaddr_in addr;
+    socklen_t addrlen = sizeof(addr);
+    char hdr[HDR_SIZE];
+    char* body;
+    char rhdr[HDR_SIZE];
+    char* rbody;
+    struct iovec iov[2];
+
+    assert((body = malloc(MAX_UDP_SIZE + 1)));
+    assert((rbody = malloc(MAX_UDP_SIZE + 1)));
+
+    for (size_t i = 0; i < HDR_SIZE; i++)
+        hdr[i] = alpha[i % 26];
+
+    for (size_t i = 0; i < BODY_SIZE; i++)
+        body[i] = (char)(i * 7);
+
+    assert((rsock = socket(AF_INET, SOCK_DGRAM, 0)) >= 0);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    assert(bind(rsock, (struct sockaddr*)&addr, sizeof(addr)) == 0);
+    assert(getsockname(rsock, (struct sockaddr*)&addr, &addrlen) == 0);
+
+    assert((ssock = socket(AF_INET, SOCK_DGRAM, 0)) >= 0);
+    assert(connect(ssock, (struct sockaddr*)&addr, sizeof(addr)) == 0);
+
+    /* two datagrams of different sizes */
+    iov[0].iov_base = hdr;
+    iov[0].iov_len = HDR_SIZE;
+    iov[1].iov_base = body;
+    iov[1].iov_len = BODY_SIZE;
+    assert(writev(ssock, iov, 2) == HDR_SIZE + BODY_SIZE);
+    iov[1].iov_len = BODY_SIZE / 2;
+    assert(writev(ssock, iov, 2) == HDR_SIZE + BODY_SIZE / 2);
+
+    /* a datagram larger than UDP allows is refused, not split */
+    iov[1].iov_len = MAX_UDP_SIZE;
+    assert(writev(ssock, iov, 2) == -1 && errno == EMSGSIZE);
+
+    /* read them back with vectors larger than the datagrams */
+    iov[0].iov_base = rhdr;
+    iov[1].iov_base = rbody;
+    iov[1].iov_len = MAX_UDP_SIZE;
+
+    memset(rbody, 0, MAX_UDP_SIZE);
+    assert(readv(rsock, iov, 2) == HDR_SIZE + BODY_SIZE);
+    assert(memcmp(rhdr, hdr, HDR_SIZE) == 0);
+    assert(memcmp(rbody, body, BODY_SIZE) == 0);
+
+    memset(rbody, 0, MAX_UDP_SIZE);
+    assert(readv(rsock, iov, 2) == HDR_SIZE + BODY_SIZE / 2);
+    assert(memcmp(rhdr, hdr, HDR_SIZE) == 0);
+    assert(memcmp(rbody, body, BODY_SIZE / 2) == 0);
+
+    /* nothing else was sent */
+    assert(recv(rsock, rbody, MAX_UDP_SIZE, MSG_DONTWAIT) == -1);
+    assert(errno == EAGAIN);
+
+    close(rsock);
+    close(ssock);
+    free(body);
+    free(rbody);
+
+    printf("=== passed vectored datagram test\n");
+}
+
 int main(int argc, const char* argv[])
 {
     pthread_t srv_thread;
     pthread_t cli_thread;
 
+    _test_mmsg();
+    _test_vectored_stream();
+    _test_vectored_datagram();
+
     assert(pthread_create(&srv_thread, NULL, _srv_thread_func, NULL) == 0);
     _sleep_msec(100);
     assert(pthread_create(&cli_thread, NULL, _cli_thread_func, NULL) == 0);
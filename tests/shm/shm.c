@@ -0,0 +1,456 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#define _GNU_SOURCE
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/shm.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
+
+#ifndef MFD_ALLOW_SEALING
+#define MFD_ALLOW_SEALING 0x0002U
+#endif
+
+#ifndef F_ADD_SEALS
+#define F_ADD_SEALS 1033
+#define F_GET_SEALS 1034
+#define F_SEAL_SEAL 0x0001
+#define F_SEAL_SHRINK 0x0002
+#define F_SEAL_GROW 0x0004
+#define F_SEAL_WRITE 0x0008
+#endif
+
+#define PAGE_SIZE 4096
+
+static int _memfd_create(const char* name, unsigned int flags)
+{
+    return (int)syscall(SYS_memfd_create, name, flags);
+}
+
+static void test_memfd(void)
+{
+    const size_t size = 3 * PAGE_SIZE;
+    char buf[16];
+    struct stat st;
+    char* p;
+    char* q;
+    int fd;
+
+    fd = _memfd_create("test", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    assert(fd >= 0);
+    assert(fcntl(fd, F_GETFD) == FD_CLOEXEC);
+
+    assert(ftruncate(fd, size) == 0);
+    assert(fstat(fd, &st) == 0);
+    assert(st.st_size == (off_t)size);
+
+    /* both mappings see the same pages */
+    p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    assert(p != MAP_FAILED);
+    q = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    assert(q != MAP_FAILED);
+
+    strcpy(p + PAGE_SIZE, "hello");
+    assert(strcmp(q + PAGE_SIZE, "hello") == 0);
+
+    /* stores through the mapping are visible through the file */
+    assert(pread(fd, buf, 6, PAGE_SIZE) == 6);
+    assert(strcmp(buf, "hello") == 0);
+
+    /* and the other way round */
+    assert(pwrite(fd, "world", 6, 0) == 6);
+    assert(strcmp(p, "world") == 0);
+
+    /* a write seal needs all writable mappings gone */
+    assert(fcntl(fd, F_ADD_SEALS, F_SEAL_WRITE) == -1 && errno == EBUSY);
+    assert(munmap(p, size) == 0);
+    assert(munmap(q, size) == 0);
+
+    assert(fcntl(fd, F_ADD_SEALS, F_SEAL_WRITE | F_SEAL_SHRINK) == 0);
+    assert(fcntl(fd, F_GET_SEALS) == (F_SEAL_WRITE | F_SEAL_SHRINK));
+    assert(write(fd, "x", 1) == -1 && errno == EPERM);
+    assert(ftruncate(fd, PAGE_SIZE) == -1 && errno == EPERM);
+    assert(mmap(NULL, size, PROT_WRITE, MAP_SHARED, fd, 0) == MAP_FAILED);
+
+    /* read-only mappings are still allowed */
+    p = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    assert(p != MAP_FAILED);
+    assert(strcmp(p + PAGE_SIZE, "hello") == 0);
+    assert(munmap(p, size) == 0);
+
+    assert(fcntl(fd, F_ADD_SEALS, F_SEAL_SEAL) == 0);
+    assert(fcntl(fd, F_ADD_SEALS, F_SEAL_GROW) == -1 && errno == EPERM);
+
+    assert(close(fd) == 0);
+
+    /* sealing must be asked for */
+    fd = _memfd_create("unsealable", 0);
+    assert(fd >= 0);
+    assert(fcntl(fd, F_GET_SEALS) == F_SEAL_SEAL);
+    assert(fcntl(fd, F_ADD_SEALS, F_SEAL_GROW) == -1 && errno == EPERM);
+    assert(close(fd) == 0);
+
+    assert(_memfd_create("bad", 0x100) == -1 && errno == EINVAL);
+
+    printf("=== passed test (%s)\n", __FUNCTION__);
+}
+
+static void test_shm_open(void)
+{
+    const size_t size = 2 * PAGE_SIZE;
+    struct stat st;
+    char* p;
+    char* q;
+    int fd;
+    int fd2;
+
+    fd = shm_open("/myst-shm", O_RDWR | O_CREAT | O_EXCL, 0600);
+    assert(fd >= 0);
+    assert(shm_open("/myst-shm", O_RDWR | O_CREAT | O_EXCL, 0600) == -1);
+    assert(errno == EEXIST);
+    assert(access("/dev/shm/myst-shm", F_OK) == 0);
+
+    assert(ftruncate(fd, size) == 0);
+    p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    assert(p != MAP_FAILED);
+    assert(close(fd) == 0);
+
+    /* a second open finds the same object */
+    fd2 = shm_open("/myst-shm", O_RDWR, 0);
+    assert(fd2 >= 0);
+    assert(fstat(fd2, &st) == 0);
+    assert(st.st_size == (off_t)size);
+    q = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd2, 0);
+    assert(q != MAP_FAILED);
+    strcpy(p, "shared");
+    assert(strcmp(q, "shared") == 0);
+
+    /* the object outlives its name while mapped */
+    assert(shm_unlink("/myst-shm") == 0);
+    assert(access("/dev/shm/myst-shm", F_OK) == -1 && errno == ENOENT);
+    assert(shm_open("/myst-shm", O_RDWR, 0) == -1 && errno == ENOENT);
+    assert(strcmp(q, "shared") == 0);
+
+    assert(munmap(p, size) == 0);
+    assert(munmap(q, size) == 0);
+    assert(close(fd2) == 0);
+
+    printf("=== passed test (%s)\n", __FUNCTION__);
+}
+
+static void test_sysv(void)
+{
+    const size_t size = 10000;
+    struct shmid_ds ds;
+    char* p;
+    char* q;
+    int shmid;
+
+    shmid = shmget(IPC_PRIVATE, size, IPC_CREAT | 0600);
+    assert(shmid >= 0);
+
+    p = shmat(shmid, NULL, 0);
+    assert(p != (void*)-1);
+    q = shmat(shmid, NULL, SHM_RDONLY);
+    assert(q != (void*)-1);
+
+    /* new segments are zero-filled */
+    for (size_t i = 0; i < size; i++)
+        assert(p[i] == 0);
+
+    strcpy(p + 5000, "segment");
+    assert(strcmp(q + 5000, "segment") == 0);
+
+    assert(shmctl(shmid, IPC_STAT, &ds) == 0);
+    assert(ds.shm_segsz == size);
+    assert(ds.shm_nattch == 2);
+    assert(ds.shm_cpid == getpid());
+
+    /* the segment goes away after the last detach */
+    assert(shmctl(shmid, IPC_RMID, NULL) == 0);
+    assert(shmdt(q) == 0);
+    assert(shmctl(shmid, IPC_STAT, &ds) == 0);
+    assert(ds.shm_nattch == 1);
+    assert(strcmp(p + 5000, "segment") == 0);
+    assert(shmctl(shmid, IPC_STAT, (struct shmid_ds*)8) == -1);
+    assert(errno == EFAULT);
+    assert(shmctl(shmid, IPC_SET, (struct shmid_ds*)8) == -1);
+    assert(errno == EFAULT);
+    assert(shmdt(p) == 0);
+    assert(shmdt(p) == -1 && errno == EINVAL);
+    assert(shmctl(shmid, IPC_STAT, &ds) == -1 && errno == EINVAL);
+
+    /* keyed segments */
+    shmid = shmget(0x1234, PAGE_SIZE, IPC_CREAT | IPC_EXCL | 0600);
+    assert(shmid >= 0);
+    assert(shmget(0x1234, PAGE_SIZE, 0) == shmid);
+    assert(shmget(0x1234, 2 * PAGE_SIZE, 0) == -1 && errno == EINVAL);
+    assert(shmget(0x1234, PAGE_SIZE, IPC_CREAT | IPC_EXCL) == -1);
+    assert(errno == EEXIST);
+    assert(shmctl(shmid, IPC_RMID, NULL) == 0);
+    assert(shmget(0x1234, PAGE_SIZE, 0) == -1 && errno == ENOENT);
+
+    printf("=== passed test (%s)\n", __FUNCTION__);
+}
+
+/*
+**==============================================================================
+**
+** sharing between processes: the parent and a child map the same object,
+** then each one writes to it and checks that the other one sees the write
+**
+**==============================================================================
+*/
+
+#define SHARED_SIZE (3 * PAGE_SIZE)
+#define SHM_NAME "/myst-shm-shared"
+#define SHM_KEY 0x5678
+
+/* map the object named by the arguments (see _test_sharing()) */
+static char* _map_object(const char* kind, const char* arg)
+{
+    char* p;
+
+    if (strcmp(kind, "sysv") == 0)
+    {
+        int shmid = shmget(atoi(arg), SHARED_SIZE, 0);
+
+        assert(shmid >= 0);
+        assert((p = shmat(shmid, NULL, 0)) != (void*)-1);
+    }
+    else
+    {
+        int fd = strcmp(kind, "memfd") == 0 ? atoi(arg)
+                                             : shm_open(arg, O_RDWR, 0);
+
+        assert(fd >= 0);
+        p = mmap(NULL, SHARED_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        assert(p != MAP_FAILED);
+        assert(close(fd) == 0);
+    }
+
+    return p;
+}
+
+static void _unmap_object(const char* kind, char* p)
+{
+    if (strcmp(kind, "sysv") == 0)
+        assert(shmdt(p) == 0);
+    else
+        assert(munmap(p, SHARED_SIZE) == 0);
+}
+
+static int _child(const char* kind, const char* arg)
+{
+    char* p = _map_object(kind, arg);
+    char c = 0;
+
+    /* the parent wrote this before starting the child */
+    assert(strcmp(p, "parent") == 0);
+    strcpy(p + PAGE_SIZE, "child");
+
+    /* tell the parent and wait for its second write */
+    assert(write(STDOUT_FILENO, &c, 1) == 1);
+    assert(read(STDIN_FILENO, &c, 1) == 1);
+    assert(strcmp(p + 2 * PAGE_SIZE, "parent again") == 0);
+
+    _unmap_object(kind, p);
+
+    return 0;
+}
+
+static void _test_sharing(
+    const char* path,
+    const char* kind,
+    const char* arg,
+    char* p)
+{
+    int to_child[2];
+    int from_child[2];
+    posix_spawn_file_actions_t fa;
+    char* argv[] = {(char*)path, "child", (char*)kind, (char*)arg, NULL};
+    pid_t pid;
+    int status;
+    char c = 0;
+
+    strcpy(p, "parent");
+
+    assert(pipe(to_child) == 0);
+    assert(pipe(from_child) == 0);
+
+    assert(posix_spawn_file_actions_init(&fa) == 0);
+    assert(posix_spawn_file_actions_adddup2(&fa, to_child[0], 0) == 0);
+    assert(posix_spawn_file_actions_adddup2(&fa, from_child[1], 1) == 0);
+    assert(posix_spawn_file_actions_addclose(&fa, to_child[1]) == 0);
+    assert(posix_spawn_file_actions_addclose(&fa, from_child[0]) == 0);
+    assert(posix_spawn(&pid, path, &fa, NULL, argv, NULL) == 0);
+    assert(posix_spawn_file_actions_destroy(&fa) == 0);
+
+    assert(close(to_child[0]) == 0);
+    assert(close(from_child[1]) == 0);
+
+    /* the child's write shows up in the parent's mapping */
+    assert(read(from_child[0], &c, 1) == 1);
+    assert(strcmp(p + PAGE_SIZE, "child") == 0);
+
+    /* and the parent's second write in the child's */
+    strcpy(p + 2 * PAGE_SIZE, "parent again");
+    assert(write(to_child[1], &c, 1) == 1);
+
+    assert(waitpid(pid, &status, 0) == pid);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    assert(close(to_child[1]) == 0);
+    assert(close(from_child[0]) == 0);
+
+    /* the writes stay after the child unmapped the object and exited */
+    assert(strcmp(p + PAGE_SIZE, "child") == 0);
+}
+
+static void test_sharing(const char* path)
+{
+    char arg[32];
+    char* p;
+    int fd;
+    int shmid;
+
+    /* memfd: the child inherits the file descriptor */
+    assert((fd = _memfd_create("shared", 0)) >= 0);
+    assert(ftruncate(fd, SHARED_SIZE) == 0);
+    p = mmap(NULL, SHARED_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    assert(p != MAP_FAILED);
+    snprintf(arg, sizeof(arg), "%d", fd);
+    _test_sharing(path, "memfd", arg, p);
+    assert(munmap(p, SHARED_SIZE) == 0);
+    assert(close(fd) == 0);
+
+    /* POSIX shm: the child opens the object by name */
+    assert((fd = shm_open(SHM_NAME, O_RDWR | O_CREAT | O_EXCL, 0600)) >= 0);
+    assert(ftruncate(fd, SHARED_SIZE) == 0);
+    p = mmap(NULL, SHARED_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    assert(p != MAP_FAILED);
+    assert(close(fd) == 0);
+    _test_sharing(path, "shm", SHM_NAME, p);
+    assert(munmap(p, SHARED_SIZE) == 0);
+    assert(shm_unlink(SHM_NAME) == 0);
+
+    /* SysV: the child looks the segment up by key */
+    shmid = shmget(SHM_KEY, SHARED_SIZE, IPC_CREAT | IPC_EXCL | 0600);
+    assert(shmid >= 0);
+    assert((p = shmat(shmid, NULL, 0)) != (void*)-1);
+    snprintf(arg, sizeof(arg), "%d", SHM_KEY);
+    _test_sharing(path, "sysv", arg, p);
+    assert(shmdt(p) == 0);
+    assert(shmctl(shmid, IPC_RMID, NULL) == 0);
+
+    printf("=== passed test (%s)\n", __FUNCTION__);
+}
+
+static void test_madvise(void)
+{
+    const size_t size = 2 * PAGE_SIZE;
+    char* p;
+    int fd;
+
+    assert((fd = _memfd_create("madvise", 0)) >= 0);
+    assert(ftruncate(fd, size) == 0);
+    p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    assert(p != MAP_FAILED);
+
+    /* discarding a shared mapping keeps the object's contents */
+    strcpy(p, "kept");
+    assert(madvise(p, size, MADV_DONTNEED) == 0);
+    assert(strcmp(p, "kept") == 0);
+
+    assert(munmap(p, size) == 0);
+    assert(close(fd) == 0);
+
+    printf("=== passed test (%s)\n", __FUNCTION__);
+}
+
+static void test_munmap(void)
+{
+    const size_t size = 4 * PAGE_SIZE;
+    char* p;
+    char* q;
+    char* r;
+    int fd;
+
+    assert((fd = _memfd_create("munmap", 0)) >= 0);
+    assert(ftruncate(fd, size) == 0);
+    p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    assert(p != MAP_FAILED);
+    strcpy(p, "head");
+    strcpy(p + 3 * PAGE_SIZE, "tail");
+
+    /* partial unmaps keep the rest of the mapping */
+    assert(munmap(p + PAGE_SIZE, PAGE_SIZE) == 0);
+    assert(strcmp(p, "head") == 0);
+    assert(strcmp(p + 3 * PAGE_SIZE, "tail") == 0);
+    assert(munmap(p, PAGE_SIZE) == 0);
+    assert(strcmp(p + 3 * PAGE_SIZE, "tail") == 0);
+    assert(munmap(p + 2 * PAGE_SIZE, 2 * PAGE_SIZE) == 0);
+
+    /* the object keeps its contents */
+    q = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    assert(q != MAP_FAILED);
+    assert(strcmp(q + 3 * PAGE_SIZE, "tail") == 0);
+
+    /* a fixed mapping can only be where the pages already are */
+    assert(mmap(q, size, PROT_READ, MAP_SHARED | MAP_FIXED, fd, 0) == q);
+    r = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+    assert(r != MAP_FAILED);
+    p = mmap(r, size, PROT_READ, MAP_SHARED | MAP_FIXED, fd, 0);
+    assert(p == MAP_FAILED && errno == EINVAL);
+    assert(munmap(q, size) == 0);
+
+    /* a range that also covers private pages unmaps those as well */
+    q = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    assert(q != MAP_FAILED);
+
+    if (q + size == r || r + size == q)
+    {
+        char* lo = (q < r) ? q : r;
+        assert(munmap(lo, 2 * size) == 0);
+        assert(madvise(r, size, MADV_DONTNEED) == -1 && errno == ENOMEM);
+    }
+    else
+    {
+        assert(munmap(q, size) == 0);
+        assert(munmap(r, size) == 0);
+    }
+
+    assert(close(fd) == 0);
+
+    printf("=== passed test (%s)\n", __FUNCTION__);
+}
+
+int main(int argc, const char* argv[])
+{
+    if (argc == 4 && strcmp(argv[1], "child") == 0)
+        return _child(argv[2], argv[3]);
+
+    test_memfd();
+    test_shm_open();
+    test_sysv();
+    test_sharing(argv[0]);
+    test_madvise();
+    test_munmap();
+
+    printf("=== passed test (%s)\n", argv[0]);
+
+    return 0;
+}
@@ -0,0 +1,198 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#define _GNU_SOURCE
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <unistd.h>
+
+static void _block(int signum)
+{
+    sigset_t mask;
+
+    sigemptyset(&mask);
+    sigaddset(&mask, signum);
+    assert(sigprocmask(SIG_BLOCK, &mask, NULL) == 0);
+}
+
+static void test_read(void)
+{
+    struct signalfd_siginfo ssi;
+    sigset_t mask;
+    int fd;
+
+    _block(SIGUSR1);
+
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGUSR1);
+    fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    assert(fd >= 0);
+    assert(fcntl(fd, F_GETFD) == FD_CLOEXEC);
+
+    /* nothing is pending yet */
+    assert(read(fd, &ssi, sizeof(ssi)) == -1 && errno == EAGAIN);
+
+    /* the buffer must hold at least one record */
+    assert(kill(getpid(), SIGUSR1) == 0);
+    assert(read(fd, &ssi, sizeof(ssi) - 1) == -1 && errno == EINVAL);
+
+    assert(read(fd, &ssi, sizeof(ssi)) == sizeof(ssi));
+    assert(ssi.ssi_signo == SIGUSR1);
+    assert(ssi.ssi_code == SI_USER);
+    assert(ssi.ssi_pid == (uint32_t)getpid());
+
+    /* the signal was consumed */
+    assert(read(fd, &ssi, sizeof(ssi)) == -1 && errno == EAGAIN);
+    sigpending(&mask);
+    assert(!sigismember(&mask, SIGUSR1));
+
+    assert(close(fd) == 0);
+
+    printf("=== passed test (%s)\n", __FUNCTION__);
+}
+
+static void test_queue(void)
+{
+    const int signum = SIGRTMIN + 1;
+    struct signalfd_siginfo ssi[8];
+    sigset_t mask;
+    int fd;
+
+    _block(signum);
+    _block(SIGUSR2);
+
+    sigemptyset(&mask);
+    sigaddset(&mask, signum);
+    sigaddset(&mask, SIGUSR2);
+    fd = signalfd(-1, &mask, SFD_NONBLOCK);
+    assert(fd >= 0);
+
+    /* real-time signals are queued, standard signals are not */
+    for (int i = 0; i < 3; i++)
+    {
+        assert(kill(getpid(), signum) == 0);
+        assert(kill(getpid(), SIGUSR2) == 0);
+    }
+
+    /* a single read returns several records, lowest signal first */
+    assert(read(fd, ssi, sizeof(ssi)) == 4 * sizeof(ssi[0]));
+    assert(ssi[0].ssi_signo == SIGUSR2);
+
+    for (int i = 0; i < 3; i++)
+        assert(ssi[i + 1].ssi_signo == (uint32_t)signum);
+
+    assert(read(fd, ssi, sizeof(ssi)) == -1 && errno == EAGAIN);
+    assert(close(fd) == 0);
+
+    printf("=== passed test (%s)\n", __FUNCTION__);
+}
+
+static void* _poll_thread(void* arg)
+{
+    int fd = *(int*)arg;
+    struct signalfd_siginfo ssi;
+    struct pollfd fds = {.fd = fd, .events = POLLIN};
+
+    assert(poll(&fds, 1, -1) == 1);
+    assert(fds.revents & POLLIN);
+
+    /* the signal was sent to the process rather than to this thread */
+    assert(read(fd, &ssi, sizeof(ssi)) == sizeof(ssi));
+    assert(ssi.ssi_signo == SIGCHLD);
+    assert(ssi.ssi_pid == (uint32_t)getpid());
+
+    assert(poll(&fds, 1, 0) == 0);
+
+    return NULL;
+}
+
+static void test_poll(void)
+{
+    struct pollfd fds;
+    pthread_t thread;
+    sigset_t mask;
+    int fd;
+
+    _block(SIGCHLD);
+
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGCHLD);
+    fd = signalfd(-1, &mask, 0);
+    assert(fd >= 0);
+
+    fds.fd = fd;
+    fds.events = POLLIN;
+    assert(poll(&fds, 1, 0) == 0);
+
+    /* the thread inherits the signal mask */
+    assert(pthread_create(&thread, NULL, _poll_thread, &fd) == 0);
+    usleep(100000);
+    assert(kill(getpid(), SIGCHLD) == 0);
+    assert(pthread_join(thread, NULL) == 0);
+
+    assert(close(fd) == 0);
+
+    printf("=== passed test (%s)\n", __FUNCTION__);
+}
+
+static void test_epoll(void)
+{
+    struct signalfd_siginfo ssi;
+    struct epoll_event event = {.events = EPOLLIN};
+    sigset_t mask;
+    int epfd;
+    int fd;
+
+    /* create the signalfd with an empty mask, then change it */
+    sigemptyset(&mask);
+    fd = signalfd(-1, &mask, SFD_NONBLOCK);
+    assert(fd >= 0);
+
+    _block(SIGUSR1);
+    sigaddset(&mask, SIGUSR1);
+    assert(signalfd(fd, &mask, 0) == fd);
+
+    /* only signalfds can be updated */
+    assert(signalfd(STDOUT_FILENO, &mask, 0) == -1 && errno == EINVAL);
+
+    epfd = epoll_create1(0);
+    assert(epfd >= 0);
+    event.data.fd = fd;
+    assert(epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &event) == 0);
+    assert(epoll_wait(epfd, &event, 1, 0) == 0);
+
+    assert(raise(SIGUSR1) == 0);
+
+    assert(epoll_wait(epfd, &event, 1, 1000) == 1);
+    assert(event.data.fd == fd);
+    assert(read(fd, &ssi, sizeof(ssi)) == sizeof(ssi));
+    assert(ssi.ssi_signo == SIGUSR1);
+    assert(ssi.ssi_code == SI_TKILL);
+
+    assert(epoll_wait(epfd, &event, 1, 0) == 0);
+
+    assert(close(epfd) == 0);
+    assert(close(fd) == 0);
+
+    printf("=== passed test (%s)\n", __FUNCTION__);
+}
+
+int main(int argc, const char* argv[])
+{
+    test_read();
+    test_queue();
+    test_poll();
+    test_epoll();
+
+    printf("=== passed test (%s)\n", argv[0]);
+
+    return 0;
+}
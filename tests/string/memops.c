@@ -0,0 +1,321 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <myst/memops.h>
+
+/* exhaustive correctness checks and a throughput comparison of the kernel's
+ * vectorized memory and string routines (kernel/memops.c) */
+
+#define MAX_SIZE 300
+#define MAX_ALIGN 32
+#define BUF_SIZE (MAX_SIZE + 2 * MAX_ALIGN + 64)
+
+typedef void* (*copy_t)(void*, const void*, size_t);
+typedef void* (*fill_t)(void*, int, size_t);
+typedef int (*compare_t)(const void*, const void*, size_t);
+typedef size_t (*length_t)(const char*);
+
+typedef struct variant
+{
+    const char* name;
+    uint32_t features;
+    copy_t memcpy;
+    copy_t memmove;
+    fill_t memset;
+    compare_t memcmp;
+    length_t strlen;
+} variant_t;
+
+static const variant_t _variants[] = {
+    {
+        "sse2",
+        0,
+        myst_memcpy_sse2,
+        myst_memmove_sse2,
+        myst_memset_sse2,
+        myst_memcmp_sse2,
+        myst_strlen_sse2,
+    },
+    {
+        "avx2",
+        MYST_MEMOPS_AVX2,
+        myst_memcpy_avx2,
+        myst_memmove_avx2,
+        myst_memset_avx2,
+        myst_memcmp_avx2,
+        myst_strlen_avx2,
+    },
+    {
+        "erms",
+        MYST_MEMOPS_ERMS,
+        myst_memcpy_erms,
+        NULL,
+        myst_memset_erms,
+        NULL,
+        NULL,
+    },
+};
+
+static uint8_t _src[BUF_SIZE];
+static uint8_t _dest[BUF_SIZE];
+static uint8_t _expect[BUF_SIZE];
+
+static void _fill_pattern(uint8_t* buf, size_t size, unsigned seed)
+{
+    for (size_t i = 0; i < size; i++)
+        buf[i] = (uint8_t)(i * 7 + seed * 13 + 1);
+}
+
+static int _sign(int x)
+{
+    return (x > 0) - (x < 0);
+}
+
+static void _test_memcpy(const variant_t* v, copy_t copy, size_t max_size)
+{
+    for (size_t n = 0; n <= max_size; n++)
+    {
+        for (size_t da = 0; da < MAX_ALIGN; da++)
+        {
+            for (size_t sa = 0; sa < MAX_ALIGN; sa++)
+            {
+                _fill_pattern(_src, BUF_SIZE, (unsigned)n);
+                memset(_dest, 0xee, BUF_SIZE);
+                memset(_expect, 0xee, BUF_SIZE);
+
+                for (size_t i = 0; i < n; i++)
+                    _expect[da + i] = _src[sa + i];
+
+                assert((*copy)(_dest + da, _src + sa, n) == _dest + da);
+
+                if (memcmp(_dest, _expect, BUF_SIZE) != 0)
+                {
+                    fprintf(stderr, "%s: copy n=%zu\n", v->name, n);
+                    assert(0);
+                }
+            }
+        }
+    }
+}
+
+static void _test_memmove(const variant_t* v)
+{
+    /* every overlap of source and destination in both directions */
+    for (size_t n = 0; n <= MAX_SIZE; n++)
+    {
+        for (size_t so = 0; so < 2 * MAX_ALIGN; so++)
+        {
+            for (size_t dof = 0; dof < 2 * MAX_ALIGN; dof++)
+            {
+                uint8_t* buf = _dest;
+
+                _fill_pattern(buf, BUF_SIZE, (unsigned)n);
+                memcpy(_expect, buf, BUF_SIZE);
+
+                for (size_t i = 0; i < n; i++)
+                    _expect[dof + i] = buf[so + i];
+
+                assert((*v->memmove)(buf + dof, buf + so, n) == buf + dof);
+
+                if (memcmp(buf, _expect, BUF_SIZE) != 0)
+                {
+                    fprintf(
+                        stderr,
+                        "%s: memmove n=%zu src=%zu dest=%zu\n",
+                        v->name,
+                        n,
+                        so,
+                        dof);
+                    assert(0);
+                }
+            }
+        }
+    }
+}
+
+static void _test_memset(const variant_t* v, size_t max_size)
+{
+    for (size_t n = 0; n <= max_size; n++)
+    {
+        for (size_t a = 0; a < MAX_ALIGN; a++)
+        {
+            int c = (int)(n % 255) + 1;
+
+            memset(_dest, 0xee, BUF_SIZE);
+            memset(_expect, 0xee, BUF_SIZE);
+
+            for (size_t i = 0; i < n; i++)
+                _expect[a + i] = (uint8_t)c;
+
+            assert((*v->memset)(_dest + a, c, n) == _dest + a);
+            assert(memcmp(_dest, _expect, BUF_SIZE) == 0);
+        }
+    }
+}
+
+static void _test_memcmp(const variant_t* v)
+{
+    for (size_t n = 0; n <= MAX_SIZE; n++)
+    {
+        for (size_t a = 0; a < MAX_ALIGN; a++)
+        {
+            uint8_t* p = _src + a;
+            uint8_t* q = _dest + (MAX_ALIGN - 1 - a);
+
+            _fill_pattern(p, n, 1);
+            memcpy(q, p, n);
+            assert((*v->memcmp)(p, q, n) == 0);
+
+            /* a difference at every position and in both directions */
+            for (size_t i = 0; i < n; i++)
+            {
+                uint8_t save = q[i];
+
+                q[i] = (uint8_t)(p[i] + 0x80);
+                assert(_sign((*v->memcmp)(p, q, n)) == _sign(p[i] - q[i]));
+                assert(_sign((*v->memcmp)(q, p, n)) == _sign(q[i] - p[i]));
+                q[i] = save;
+            }
+        }
+    }
+}
+
+static void _test_strlen(const variant_t* v)
+{
+    for (size_t n = 0; n <= MAX_SIZE; n++)
+    {
+        for (size_t a = 0; a < MAX_ALIGN; a++)
+        {
+            char* s = (char*)_src + a;
+
+            memset(_src, 'x', BUF_SIZE);
+            s[n] = '\0';
+            assert((*v->strlen)(s) == n);
+        }
+    }
+}
+
+static double _now(void)
+{
+    struct timespec ts;
+    assert(clock_gettime(CLOCK_MONOTONIC, &ts) == 0);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void* _byte_memcpy(void* dest, const void* src, size_t n)
+{
+    volatile uint8_t* p = dest;
+    const uint8_t* q = src;
+
+    while (n--)
+        *p++ = *q++;
+
+    return dest;
+}
+
+static void _bench_copy(const char* name, copy_t copy)
+{
+    static const size_t sizes[] = {16, 256, 4096, 65536, 1048576};
+    uint8_t* src = malloc(sizes[4] + 1);
+    uint8_t* dest = malloc(sizes[4] + 1);
+
+    assert(src && dest);
+    memset(src, 1, sizes[4] + 1);
+
+    printf("memcpy %-5s", name);
+
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+    {
+        const size_t total = 64 * 1024 * 1024;
+        const size_t iterations = total / sizes[i];
+        double start = _now();
+
+        /* misalign the source by one byte */
+        for (size_t j = 0; j < iterations; j++)
+            (*copy)(dest, src + 1, sizes[i]);
+
+        printf(" %7zu:%6.2f", sizes[i], (double)total / (_now() - start) / 1e9);
+    }
+
+    printf(" GB/s\n");
+
+    free(src);
+    free(dest);
+}
+
+void test_memops(void)
+{
+    const uint32_t features = myst_memops_features();
+
+    printf(
+        "memops features: avx2=%d erms=%d\n",
+        !!(features & MYST_MEMOPS_AVX2),
+        !!(features & MYST_MEMOPS_ERMS));
+
+    for (size_t i = 0; i < sizeof(_variants) / sizeof(_variants[0]); i++)
+    {
+        const variant_t* v = &_variants[i];
+
+        if ((v->features & features) != v->features)
+            continue;
+
+        _test_memcpy(v, v->memcpy, MAX_SIZE);
+
+        if (v->memmove)
+        {
+            _test_memcpy(v, v->memmove, MAX_SIZE);
+            _test_memmove(v);
+        }
+
+        _test_memset(v, MAX_SIZE);
+
+        if (v->memcmp)
+            _test_memcmp(v);
+
+        if (v->strlen)
+            _test_strlen(v);
+
+        printf("memops %s: passed\n", v->name);
+    }
+
+    /* exercise the ERMS thresholds and the kernel dispatch table */
+    myst_memops_init();
+    {
+        const size_t n = 8192;
+        uint8_t* a = malloc(n + 64);
+        uint8_t* b = malloc(n + 64);
+
+        assert(a && b);
+
+        for (size_t size = 1024; size <= n; size += 509)
+        {
+            _fill_pattern(a, n + 64, (unsigned)size);
+            memset(b, 0, n + 64);
+            (*__myst_memops.memcpy)(b + 3, a + 5, size);
+            assert(memcmp(b + 3, a + 5, size) == 0);
+            assert(b[3 + size] == 0);
+            (*__myst_memops.memset)(b + 1, 0x5a, size);
+
+            for (size_t j = 0; j < size; j++)
+                assert(b[1 + j] == 0x5a);
+        }
+
+        free(a);
+        free(b);
+    }
+
+    _bench_copy("byte", _byte_memcpy);
+
+    for (size_t i = 0; i < sizeof(_variants) / sizeof(_variants[0]); i++)
+    {
+        if ((_variants[i].features & features) == _variants[i].features)
+            _bench_copy(_variants[i].name, _variants[i].memcpy);
+    }
+}
@@ -6,6 +6,8 @@
 #include <stdio.h>
 #include <string.h>
 
+extern void test_memops(void);
+
 int main(int argc, const char* argv[])
 {
     string_t s;
@@ -26,6 +28,8 @@ int main(int argc, const char* argv[])
 
     assert(strcmp(string_ptr(&s), "red green bluexy") == 0);
 
+    test_memops();
+
     printf("=== passed test (%s)\n", argv[0]);
 
     return 0;
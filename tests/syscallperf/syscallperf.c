@@ -0,0 +1,139 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <assert.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+/* measures the cost of a null system call (one that is handled entirely by
+ * the kernel) from one and from several threads, compares the dispatch paths
+ * of the kernel (see _fast_syscalls[] in kernel/syscall.c), and checks that
+ * system calls made by signal handlers (nested system calls) still work */
+
+#define ITERATIONS 1000000
+#define NTHREADS 4
+
+static pid_t _pid;
+
+static double _now(void)
+{
+    struct timespec ts;
+    assert(clock_gettime(CLOCK_MONOTONIC, &ts) == 0);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void _report(const char* name, size_t ncalls, double start)
+{
+    double secs = _now() - start;
+    printf(
+        "%-10s %10zu calls %8.3f sec %8.0f nsec/call\n",
+        name,
+        ncalls,
+        secs,
+        secs * 1e9 / (double)ncalls);
+}
+
+static void* _getpid_loop(void* arg)
+{
+    (void)arg;
+
+    for (size_t i = 0; i < ITERATIONS; i++)
+        assert(syscall(SYS_getpid) == _pid);
+
+    return NULL;
+}
+
+static void _bench_one_thread(void)
+{
+    double start = _now();
+
+    _getpid_loop(NULL);
+    _report("getpid", ITERATIONS, start);
+}
+
+static void _bench_dispatch(void)
+{
+    struct timespec ts;
+    double start;
+
+    /* handled by the switch in _syscall() */
+    start = _now();
+    for (size_t i = 0; i < ITERATIONS; i++)
+        syscall(SYS_getuid);
+    _report("getuid", ITERATIONS, start);
+
+    /* handled by a _fast_syscalls[] entry after the kernel entry */
+    start = _now();
+    for (size_t i = 0; i < ITERATIONS; i++)
+        syscall(SYS_getppid);
+    _report("getppid", ITERATIONS, start);
+
+    /* a SYSCALL_DIRECT entry (the C runtime's clock_gettime() may not make
+     * a system call at all, so make one explicitly) */
+    start = _now();
+    for (size_t i = 0; i < ITERATIONS; i++)
+        assert(syscall(SYS_clock_gettime, CLOCK_MONOTONIC, &ts) == 0);
+    _report("clock", ITERATIONS, start);
+}
+
+static void _bench_threads(void)
+{
+    pthread_t threads[NTHREADS];
+    double start = _now();
+
+    for (size_t i = 0; i < NTHREADS; i++)
+        assert(pthread_create(&threads[i], NULL, _getpid_loop, NULL) == 0);
+
+    for (size_t i = 0; i < NTHREADS; i++)
+        assert(pthread_join(threads[i], NULL) == 0);
+
+    _report("getpid x4", NTHREADS * ITERATIONS, start);
+}
+
+static volatile size_t _nhandled;
+
+static void _handler(int signum)
+{
+    /* runs while the kill() below is returning, so these are nested */
+    assert(signum == SIGUSR1);
+    assert(syscall(SYS_getpid) == _pid);
+    assert(syscall(SYS_gettid) == _pid);
+    _nhandled++;
+}
+
+static void _test_nested(void)
+{
+    const size_t n = 10000;
+    struct sigaction sa = {.sa_handler = _handler};
+
+    assert(sigaction(SIGUSR1, &sa, NULL) == 0);
+
+    for (size_t i = 0; i < n; i++)
+    {
+        assert(kill(_pid, SIGUSR1) == 0);
+        assert(syscall(SYS_getpid) == _pid);
+    }
+
+    assert(_nhandled == n);
+
+    printf("=== passed test (%s)\n", __FUNCTION__);
+}
+
+int main(int argc, const char* argv[])
+{
+    _pid = getpid();
+
+    _bench_one_thread();
+    _bench_dispatch();
+    _bench_threads();
+    _test_nested();
+
+    printf("=== passed test (%s)\n", argv[0]);
+
+    return 0;
+}
@@ -0,0 +1,126 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <arpa/inet.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mount.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/* measures the throughput of cheap syscalls that are forwarded to the host
+ * as tcalls (one per class that --exitless-calls can select) */
+
+#define ITERATIONS 100000
+
+static double _now(void)
+{
+    struct timespec ts;
+    assert(clock_gettime(CLOCK_MONOTONIC, &ts) == 0);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void _report(const char* name, size_t ncalls, double start)
+{
+    double secs = _now() - start;
+    printf(
+        "%-8s %10zu calls %8.3f sec %12.0f calls/sec\n",
+        name,
+        ncalls,
+        secs,
+        (double)ncalls / secs);
+}
+
+static void _bench_files(const char* dir)
+{
+    char path[256];
+    int fd;
+    char c = 'x';
+    double start;
+
+    snprintf(path, sizeof(path), "%s/tcallperf", dir);
+    assert((fd = open(path, O_CREAT | O_RDWR | O_TRUNC, 0666)) >= 0);
+
+    start = _now();
+
+    for (size_t i = 0; i < ITERATIONS; i++)
+    {
+        assert(pwrite(fd, &c, 1, 0) == 1);
+        assert(pread(fd, &c, 1, 0) == 1);
+    }
+
+    _report("files", 2 * ITERATIONS, start);
+
+    assert(close(fd) == 0);
+    assert(unlink(path) == 0);
+}
+
+static void _bench_sockets(void)
+{
+    int sd;
+    struct sockaddr_in addr;
+    socklen_t addrlen = sizeof(addr);
+    char c = 'x';
+    double start;
+
+    assert((sd = socket(AF_INET, SOCK_DGRAM, 0)) >= 0);
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    assert(bind(sd, (struct sockaddr*)&addr, sizeof(addr)) == 0);
+    assert(getsockname(sd, (struct sockaddr*)&addr, &addrlen) == 0);
+    assert(connect(sd, (struct sockaddr*)&addr, addrlen) == 0);
+
+    start = _now();
+
+    for (size_t i = 0; i < ITERATIONS; i++)
+    {
+        assert(send(sd, &c, 1, 0) == 1);
+        assert(recv(sd, &c, 1, 0) == 1);
+    }
+
+    _report("sockets", 2 * ITERATIONS, start);
+
+    assert(close(sd) == 0);
+}
+
+static void _bench_clock(void)
+{
+    struct timespec ts;
+    double start = _now();
+
+    for (size_t i = 0; i < ITERATIONS; i++)
+        assert(clock_gettime(CLOCK_REALTIME, &ts) == 0);
+
+    _report("clock", ITERATIONS, start);
+}
+
+int main(int argc, const char* argv[])
+{
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s host-directory\n", argv[0]);
+        exit(1);
+    }
+
+    assert(mkdir("/mnt", 0777) == 0);
+    assert(mkdir("/mnt/host", 0777) == 0);
+    assert(mount(argv[1], "/mnt/host", "hostfs", 0, NULL) == 0);
+
+    _bench_files("/mnt/host");
+    _bench_sockets();
+    _bench_clock();
+
+    assert(umount("/mnt/host") == 0);
+
+    printf("=== passed test (%s)\n", argv[0]);
+
+    return 0;
+}
@@ -0,0 +1,309 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MSEC 1000000L
+
+static uint64_t _now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+static void _set(struct itimerspec* its, long value_ns, long interval_ns)
+{
+    its->it_value.tv_sec = value_ns / 1000000000;
+    its->it_value.tv_nsec = value_ns % 1000000000;
+    its->it_interval.tv_sec = interval_ns / 1000000000;
+    its->it_interval.tv_nsec = interval_ns % 1000000000;
+}
+
+static void test_timerfd_oneshot(void)
+{
+    struct itimerspec its;
+    struct itimerspec curr;
+    uint64_t start = _now();
+    uint64_t count;
+    int fd;
+
+    assert((fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC)) >= 0);
+
+    /* a disarmed timer reads as zero */
+    assert(timerfd_gettime(fd, &curr) == 0);
+    assert(curr.it_value.tv_sec == 0 && curr.it_value.tv_nsec == 0);
+
+    _set(&its, 50 * MSEC, 0);
+    assert(timerfd_settime(fd, 0, &its, NULL) == 0);
+
+    assert(timerfd_gettime(fd, &curr) == 0);
+    assert(curr.it_value.tv_sec == 0);
+    assert(curr.it_value.tv_nsec > 0 && curr.it_value.tv_nsec <= 50 * MSEC);
+
+    /* the blocking read waits for the expiration */
+    assert(read(fd, &count, sizeof(count)) == sizeof(count));
+    assert(count == 1);
+    assert(_now() - start >= 50 * MSEC);
+
+    /* writes and short reads fail */
+    assert(write(fd, &count, sizeof(count)) == -1 && errno == EINVAL);
+    assert(read(fd, &count, 4) == -1 && errno == EINVAL);
+
+    assert(close(fd) == 0);
+
+    printf("=== passed test (%s)\n", __FUNCTION__);
+}
+
+static void test_timerfd_periodic(void)
+{
+    struct itimerspec its;
+    struct itimerspec old;
+    struct pollfd pfd;
+    uint64_t count;
+    int fd;
+
+    assert((fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK)) >= 0);
+    assert(fcntl(fd, F_GETFL) & O_NONBLOCK);
+
+    /* nothing to read before the first expiration */
+    assert(read(fd, &count, sizeof(count)) == -1 && errno == EAGAIN);
+
+    _set(&its, 10 * MSEC, 10 * MSEC);
+    assert(timerfd_settime(fd, 0, &its, NULL) == 0);
+
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    assert(poll(&pfd, 1, 1000) == 1);
+    assert(pfd.revents & POLLIN);
+
+    /* missed periods accumulate in the counter */
+    usleep(100 * 1000);
+    assert(read(fd, &count, sizeof(count)) == sizeof(count));
+    assert(count >= 5);
+
+    /* re-arming returns the old setting and discards the expirations */
+    _set(&its, 0, 0);
+    assert(timerfd_settime(fd, 0, &its, &old) == 0);
+    assert(old.it_interval.tv_sec == 0);
+    assert(old.it_interval.tv_nsec == 10 * MSEC);
+    usleep(20 * 1000);
+    assert(read(fd, &count, sizeof(count)) == -1 && errno == EAGAIN);
+
+    assert(close(fd) == 0);
+
+    printf("=== passed test (%s)\n", __FUNCTION__);
+}
+
+static void test_timerfd_abstime_epoll(void)
+{
+    struct itimerspec its;
+    struct timespec now;
+    struct epoll_event ev;
+    uint64_t count;
+    int fd;
+    int dupfd;
+    int epfd;
+
+    assert((fd = timerfd_create(CLOCK_REALTIME, 0)) >= 0);
+    assert((dupfd = dup(fd)) >= 0);
+    assert((epfd = epoll_create1(0)) >= 0);
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = dupfd;
+    assert(epoll_ctl(epfd, EPOLL_CTL_ADD, dupfd, &ev) == 0);
+
+    /* an absolute expiration on the realtime clock */
+    clock_gettime(CLOCK_REALTIME, &now);
+    memset(&its, 0, sizeof(its));
+    its.it_value = now;
+    its.it_value.tv_nsec += 30 * MSEC;
+
+    if (its.it_value.tv_nsec >= 1000000000)
+    {
+        its.it_value.tv_sec++;
+        its.it_value.tv_nsec -= 1000000000;
+    }
+
+    assert(timerfd_settime(fd, TFD_TIMER_ABSTIME, &its, NULL) == 0);
+
+    /* the duplicate shares the timer */
+    memset(&ev, 0, sizeof(ev));
+    assert(epoll_wait(epfd, &ev, 1, 1000) == 1);
+    assert(ev.data.fd == dupfd);
+    assert(read(dupfd, &count, sizeof(count)) == sizeof(count));
+    assert(count == 1);
+
+    assert(close(epfd) == 0);
+    assert(close(dupfd) == 0);
+    assert(close(fd) == 0);
+
+    printf("=== passed test (%s)\n", __FUNCTION__);
+}
+
+static volatile sig_atomic_t _nsignals;
+static volatile int _sival;
+
+static void _handler(int sig, siginfo_t* si, void* context)
+{
+    (void)context;
+
+    if (sig == SIGRTMIN && si->si_code == SI_TIMER)
+    {
+        _sival = si->si_value.sival_int;
+        _nsignals++;
+    }
+}
+
+static void test_posix_timer(void)
+{
+    struct sigaction sa;
+    struct sigevent sev;
+    struct itimerspec its;
+    struct itimerspec curr;
+    timer_t timer;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_sigaction = _handler;
+    sa.sa_flags = SA_SIGINFO;
+    assert(sigaction(SIGRTMIN, &sa, NULL) == 0);
+
+    memset(&sev, 0, sizeof(sev));
+    sev.sigev_notify = SIGEV_SIGNAL;
+    sev.sigev_signo = SIGRTMIN;
+    sev.sigev_value.sival_int = 12345;
+    assert(timer_create(CLOCK_MONOTONIC, &sev, &timer) == 0);
+
+    _set(&its, 20 * MSEC, 20 * MSEC);
+    assert(timer_settime(timer, 0, &its, NULL) == 0);
+
+    assert(timer_gettime(timer, &curr) == 0);
+    assert(curr.it_interval.tv_nsec == 20 * MSEC);
+
+    for (size_t i = 0; i < 200 && _nsignals < 3; i++)
+        usleep(10 * 1000);
+
+    assert(_nsignals >= 3);
+    assert(_sival == 12345);
+    assert(timer_getoverrun(timer) >= 0);
+
+    assert(timer_delete(timer) == 0);
+
+    /* a bad timer id fails even when a ticker is needed */
+    assert(timer_settime((timer_t)12345, 0, &its, NULL) == -1);
+    assert(errno == EINVAL);
+
+    /* the deleted timer is gone */
+    assert(timer_gettime(timer, &curr) == -1 && errno == EINVAL);
+
+    /* unsupported clocks are rejected */
+    assert(timer_create(CLOCK_THREAD_CPUTIME_ID + 100, &sev, &timer) == -1);
+
+    printf("=== passed test (%s)\n", __FUNCTION__);
+}
+
+/* arm a timer (so this process runs the timers) and exit when told to */
+static int _child(void)
+{
+    struct itimerspec its;
+    uint64_t count;
+    char c = 0;
+    int fd;
+
+    assert((fd = timerfd_create(CLOCK_MONOTONIC, 0)) >= 0);
+    _set(&its, MSEC, 0);
+    assert(timerfd_settime(fd, 0, &its, NULL) == 0);
+    assert(read(fd, &count, sizeof(count)) == sizeof(count));
+
+    assert(write(STDOUT_FILENO, &c, 1) == 1);
+    assert(read(STDIN_FILENO, &c, 1) == 0);
+
+    return 0;
+}
+
+/* the timers of a process keep running after the process that ran them
+ * (here, the first one to arm a timer) exits */
+static void test_ticker_handoff(const char* path)
+{
+    int to_child[2];
+    int from_child[2];
+    posix_spawn_file_actions_t fa;
+    char* argv[] = {(char*)path, "child", NULL};
+    struct itimerspec its;
+    uint64_t count;
+    pid_t pid;
+    int status;
+    char c;
+    int fd;
+
+    assert(pipe(to_child) == 0);
+    assert(pipe(from_child) == 0);
+
+    assert(posix_spawn_file_actions_init(&fa) == 0);
+    assert(posix_spawn_file_actions_adddup2(&fa, to_child[0], 0) == 0);
+    assert(posix_spawn_file_actions_adddup2(&fa, from_child[1], 1) == 0);
+    assert(posix_spawn_file_actions_addclose(&fa, to_child[1]) == 0);
+    assert(posix_spawn_file_actions_addclose(&fa, from_child[0]) == 0);
+    assert(posix_spawn(&pid, path, &fa, NULL, argv, NULL) == 0);
+    assert(posix_spawn_file_actions_destroy(&fa) == 0);
+
+    assert(close(to_child[0]) == 0);
+    assert(close(from_child[1]) == 0);
+
+    /* wait for the child to run the timers */
+    assert(read(from_child[0], &c, 1) == 1);
+
+    assert((fd = timerfd_create(CLOCK_MONOTONIC, 0)) >= 0);
+    _set(&its, 10 * MSEC, 10 * MSEC);
+    assert(timerfd_settime(fd, 0, &its, NULL) == 0);
+
+    /* let the child exit */
+    assert(close(to_child[1]) == 0);
+    assert(waitpid(pid, &status, 0) == pid);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    assert(close(from_child[0]) == 0);
+
+    for (size_t i = 0; i < 3; i++)
+    {
+        struct pollfd pfd = {.fd = fd, .events = POLLIN};
+
+        assert(poll(&pfd, 1, 1000) == 1);
+        assert(read(fd, &count, sizeof(count)) == sizeof(count));
+        assert(count >= 1);
+    }
+
+    assert(close(fd) == 0);
+
+    printf("=== passed test (%s)\n", __FUNCTION__);
+}
+
+int main(int argc, const char* argv[])
+{
+    if (argc == 2 && strcmp(argv[1], "child") == 0)
+        return _child();
+
+    /* (runs first so that the child is the first to arm a timer) */
+    test_ticker_handoff(argv[0]);
+    test_timerfd_oneshot();
+    test_timerfd_periodic();
+    test_timerfd_abstime_epoll();
+    test_posix_timer();
+
+    printf("=== passed test (%s)\n", argv[0]);
+
+    return 0;
+}
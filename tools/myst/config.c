@@ -95,16 +95,113 @@ done:
     return ret;
 }
 
+/* the configuration settings (the paths of the matching JSON values) */
+typedef enum config_key
+{
+    CONFIG_VERSION,
+    CONFIG_DEBUG,
+    CONFIG_PRODUCT_ID,
+    CONFIG_SECURITY_VERSION,
+    CONFIG_CREATE_ZERO_BASE_ENCLAVE,
+    CONFIG_ENCLAVE_START_ADDRESS,
+    CONFIG_USER_MEM_SIZE,
+    CONFIG_MEMORY_SIZE,
+    CONFIG_MAIN_STACK_SIZE,
+    CONFIG_THREAD_STACK_SIZE,
+    CONFIG_HOST_STAGING_BUFFER_SIZE,
+    CONFIG_HOSTFS_CACHE_TTL,
+    CONFIG_MAX_AFFINITY_CPUS,
+    CONFIG_NO_BRK,
+    CONFIG_EXEC_STACK,
+    CONFIG_APPLICATION_PATH,
+    CONFIG_HOST_APPLICATION_PARAMETERS,
+    CONFIG_APPLICATION_PARAMETERS,
+    CONFIG_ENVIRONMENT_VARIABLES,
+    CONFIG_HOST_ENVIRONMENT_VARIABLES,
+    CONFIG_CURRENT_WORKING_DIRECTORY,
+    CONFIG_HOSTNAME,
+    CONFIG_FORK_MODE,
+    CONFIG_MOUNT_TARGET,
+    CONFIG_MOUNT_TYPE,
+    CONFIG_MOUNT_FLAGS,
+    CONFIG_MOUNT_PUBLIC_KEY,
+    CONFIG_MOUNT_ROOT_HASH,
+    CONFIG_UNHANDLED_SYSCALL_ENOSYS,
+    CONFIG_SECRET_ID,
+    CONFIG_SECRET_SRS_ADDRESS,
+    CONFIG_SECRET_SRS_API_VERSION,
+    CONFIG_SECRET_LOCAL_PATH,
+    CONFIG_SECRET_CLIENT_LIB,
+    CONFIG_SECRET_VERBOSE,
+    CONFIG_MOUNT,
+    CONFIG_SECRET,
+    CONFIG_NUM_KEYS,
+} config_key_t;
+
+static const char* const _config_patterns[CONFIG_NUM_KEYS] = {
+    [CONFIG_VERSION] = "version",
+    [CONFIG_DEBUG] = "Debug",
+    [CONFIG_PRODUCT_ID] = "ProductID",
+    [CONFIG_SECURITY_VERSION] = "SecurityVersion",
+    [CONFIG_CREATE_ZERO_BASE_ENCLAVE] = "CreateZeroBaseEnclave",
+    [CONFIG_ENCLAVE_START_ADDRESS] = "EnclaveStartAddress",
+    [CONFIG_USER_MEM_SIZE] = "UserMemSize",
+    [CONFIG_MEMORY_SIZE] = "MemorySize",
+    [CONFIG_MAIN_STACK_SIZE] = "MainStackSize",
+    [CONFIG_THREAD_STACK_SIZE] = "ThreadStackSize",
+    [CONFIG_HOST_STAGING_BUFFER_SIZE] = "HostStagingBufferSize",
+    [CONFIG_HOSTFS_CACHE_TTL] = "HostfsCacheTTL",
+    [CONFIG_MAX_AFFINITY_CPUS] = "MaxAffinityCPUs",
+    [CONFIG_NO_BRK] = "NoBrk",
+    [CONFIG_EXEC_STACK] = "ExecStack",
+    [CONFIG_APPLICATION_PATH] = "ApplicationPath",
+    [CONFIG_HOST_APPLICATION_PARAMETERS] = "HostApplicationParameters",
+    [CONFIG_APPLICATION_PARAMETERS] = "ApplicationParameters",
+    [CONFIG_ENVIRONMENT_VARIABLES] = "EnvironmentVariables",
+    [CONFIG_HOST_ENVIRONMENT_VARIABLES] = "HostEnvironmentVariables",
+    [CONFIG_CURRENT_WORKING_DIRECTORY] = "CurrentWorkingDirectory",
+    [CONFIG_HOSTNAME] = "Hostname",
+    [CONFIG_FORK_MODE] = "ForkMode",
+    [CONFIG_MOUNT_TARGET] = "Mount.Target",
+    [CONFIG_MOUNT_TYPE] = "Mount.Type",
+    [CONFIG_MOUNT_FLAGS] = "Mount.Flags",
+    [CONFIG_MOUNT_PUBLIC_KEY] = "Mount.PublicKey",
+    [CONFIG_MOUNT_ROOT_HASH] = "Mount.RootHash",
+    [CONFIG_UNHANDLED_SYSCALL_ENOSYS] = "UnhandledSyscallEnosys",
+    [CONFIG_SECRET_ID] = "Secret.ID",
+    [CONFIG_SECRET_SRS_ADDRESS] = "Secret.SrsAddress",
+    [CONFIG_SECRET_SRS_API_VERSION] = "Secret.SrsApiVersion",
+    [CONFIG_SECRET_LOCAL_PATH] = "Secret.LocalPath",
+    [CONFIG_SECRET_CLIENT_LIB] = "Secret.ClientLib",
+    [CONFIG_SECRET_VERBOSE] = "Secret.Verbose",
+    [CONFIG_MOUNT] = "Mount",
+    [CONFIG_SECRET] = "Secret",
+};
+
+/* more than enough for the path elements of all the patterns above */
+#define CONFIG_TRIE_MAX_NODES 64
+
+typedef struct config_parser
+{
+    config_parsed_data_t* parsed_data;
+    json_trie_t trie;
+    json_trie_node_t nodes[CONFIG_TRIE_MAX_NODES];
+} config_parser_t;
+
 static json_result_t _json_read_callback(
     json_parser_t* parser,
     json_reason_t reason,
     json_type_t type,
     const json_union_t* un,
-    void* _parsed_data)
+    void* callback_data)
 {
-    config_parsed_data_t* parsed_data = (config_parsed_data_t*)_parsed_data;
+    config_parser_t* cp = (config_parser_t*)callback_data;
+    config_parsed_data_t* parsed_data = cp->parsed_data;
     json_result_t ret = JSON_FAILED;
 
+    /* match the path once rather than trying every pattern in turn */
+    const long key = json_trie_match(&cp->trie, parser);
+
     switch (reason)
     {
         case JSON_REASON_VALUE:
@@ -112,7 +209,7 @@ static json_result_t _json_read_callback(
             // configuration schema version. This should be the first
             // entry in the JSON configuration so we know how to parse
             // everything else
-            if (json_match(parser, "version") == JSON_OK)
+            if (key == CONFIG_VERSION)
             {
                 if (type == JSON_TYPE_STRING)
                 {
@@ -125,7 +222,7 @@ static json_result_t _json_read_callback(
             }
 
             // OE Config generation only
-            else if (json_match(parser, "Debug") == JSON_OK)
+            else if (key == CONFIG_DEBUG)
             {
                 if (((type == JSON_TYPE_BOOLEAN) && un->boolean) ||
                     ((type == JSON_TYPE_INTEGER) && un->integer))
@@ -140,7 +237,7 @@ static json_result_t _json_read_callback(
                 else
                     CONFIG_RAISE(JSON_TYPE_MISMATCH);
             }
-            else if (json_match(parser, "ProductID") == JSON_OK)
+            else if (key == CONFIG_PRODUCT_ID)
             {
                 if (type == JSON_TYPE_INTEGER)
                 {
@@ -149,7 +246,7 @@ static json_result_t _json_read_callback(
                 else
                     CONFIG_RAISE(JSON_TYPE_MISMATCH);
             }
-            else if (json_match(parser, "SecurityVersion") == JSON_OK)
+            else if (key == CONFIG_SECURITY_VERSION)
             {
                 if (type == JSON_TYPE_INTEGER)
                 {
@@ -159,7 +256,7 @@ static json_result_t _json_read_callback(
                 else
                     CONFIG_RAISE(JSON_TYPE_MISMATCH);
             }
-            else if (json_match(parser, "CreateZeroBaseEnclave") == JSON_OK)
+            else if (key == CONFIG_CREATE_ZERO_BASE_ENCLAVE)
             {
                 if ((type == JSON_TYPE_BOOLEAN) && un->boolean)
                 {
@@ -172,7 +269,7 @@ static json_result_t _json_read_callback(
                 else
                     CONFIG_RAISE(JSON_TYPE_MISMATCH);
             }
-            else if (json_match(parser, "EnclaveStartAddress") == JSON_OK)
+            else if (key == CONFIG_ENCLAVE_START_ADDRESS)
             {
                 ret = _extract_start_address(
                     type, un, &parsed_data->oe_start_address);
@@ -181,20 +278,20 @@ static json_result_t _json_read_callback(
             }
 
             // Mystikos configuration
-            else if (json_match(parser, "UserMemSize") == JSON_OK)
+            else if (key == CONFIG_USER_MEM_SIZE)
             {
                 /* legacy setting (kept for backwards compatibility) */
                 ret = _extract_mem_size(type, un, &parsed_data->heap_pages);
                 if (ret != JSON_OK)
                     CONFIG_RAISE(ret);
             }
-            else if (json_match(parser, "MemorySize") == JSON_OK)
+            else if (key == CONFIG_MEMORY_SIZE)
             {
                 ret = _extract_mem_size(type, un, &parsed_data->heap_pages);
                 if (ret != JSON_OK)
                     CONFIG_RAISE(ret);
             }
-            else if (json_match(parser, "MainStackSize") == JSON_OK)
+            else if (key == CONFIG_MAIN_STACK_SIZE)
             {
                 uint64_t main_stack_pages = 0;
                 ret = _extract_mem_size(type, un, &main_stack_pages);
@@ -202,7 +299,7 @@ static json_result_t _json_read_callback(
                     CONFIG_RAISE(ret);
                 parsed_data->main_stack_size = main_stack_pages * PAGE_SIZE;
             }
-            else if (json_match(parser, "ThreadStackSize") == JSON_OK)
+            else if (key == CONFIG_THREAD_STACK_SIZE)
             {
                 uint64_t thread_stack_pages = 0;
                 ret = _extract_mem_size(type, un, &thread_stack_pages);
@@ -210,7 +307,26 @@ static json_result_t _json_read_callback(
                     CONFIG_RAISE(ret);
                 parsed_data->thread_stack_size = thread_stack_pages * PAGE_SIZE;
             }
-            else if (json_match(parser, "MaxAffinityCPUs") == JSON_OK)
+            else if (key == CONFIG_HOST_STAGING_BUFFER_SIZE)
+            {
+                uint64_t staging_pages = 0;
+                ret = _extract_mem_size(type, un, &staging_pages);
+                if (ret != JSON_OK)
+                    CONFIG_RAISE(ret);
+                parsed_data->host_staging_buffer_size =
+                    staging_pages * PAGE_SIZE;
+            }
+            else if (key == CONFIG_HOSTFS_CACHE_TTL)
+            {
+                if (type != JSON_TYPE_INTEGER)
+                    CONFIG_RAISE(JSON_TYPE_MISMATCH);
+
+                if (un->integer < 0)
+                    CONFIG_RAISE(JSON_OUT_OF_BOUNDS);
+
+                parsed_data->hostfs_cache_ttl = (size_t)un->integer;
+            }
+            else if (key == CONFIG_MAX_AFFINITY_CPUS)
             {
                 if (type != JSON_TYPE_INTEGER)
                     CONFIG_RAISE(JSON_TYPE_MISMATCH);
@@ -220,7 +336,7 @@ static json_result_t _json_read_callback(
 
                 parsed_data->max_affinity_cpus = (size_t)un->integer;
             }
-            else if (json_match(parser, "NoBrk") == JSON_OK)
+            else if (key == CONFIG_NO_BRK)
             {
                 if (type == JSON_TYPE_BOOLEAN)
                     parsed_data->no_brk = un->boolean;
@@ -229,7 +345,7 @@ static json_result_t _json_read_callback(
                 else
                     CONFIG_RAISE(JSON_TYPE_MISMATCH);
             }
-            else if (json_match(parser, "ExecStack") == JSON_OK)
+            else if (key == CONFIG_EXEC_STACK)
             {
                 if (type == JSON_TYPE_BOOLEAN)
                     parsed_data->exec_stack = un->boolean;
@@ -238,14 +354,14 @@ static json_result_t _json_read_callback(
                 else
                     CONFIG_RAISE(JSON_TYPE_MISMATCH);
             }
-            else if (json_match(parser, "ApplicationPath") == JSON_OK)
+            else if (key == CONFIG_APPLICATION_PATH)
             {
                 if (type == JSON_TYPE_STRING)
                     parsed_data->application_path = un->string;
                 else
                     CONFIG_RAISE(JSON_TYPE_MISMATCH);
             }
-            else if (json_match(parser, "HostApplicationParameters") == JSON_OK)
+            else if (key == CONFIG_HOST_APPLICATION_PARAMETERS)
             {
                 if (type == JSON_TYPE_BOOLEAN)
                     parsed_data->allow_host_parameters = un->boolean;
@@ -255,7 +371,7 @@ static json_result_t _json_read_callback(
                 else
                     CONFIG_RAISE(JSON_TYPE_MISMATCH);
             }
-            else if (json_match(parser, "ApplicationParameters") == JSON_OK)
+            else if (key == CONFIG_APPLICATION_PARAMETERS)
             {
                 if (type == JSON_TYPE_STRING)
                     parsed_data->application_parameters[parser->path[0].index] =
@@ -263,7 +379,7 @@ static json_result_t _json_read_callback(
                 else
                     CONFIG_RAISE(JSON_TYPE_MISMATCH);
             }
-            else if (json_match(parser, "EnvironmentVariables") == JSON_OK)
+            else if (key == CONFIG_ENVIRONMENT_VARIABLES)
             {
                 if (type == JSON_TYPE_STRING)
                     parsed_data
@@ -272,7 +388,7 @@ static json_result_t _json_read_callback(
                 else
                     CONFIG_RAISE(JSON_TYPE_MISMATCH);
             }
-            else if (json_match(parser, "HostEnvironmentVariables") == JSON_OK)
+            else if (key == CONFIG_HOST_ENVIRONMENT_VARIABLES)
             {
                 if (type == JSON_TYPE_STRING)
                     parsed_data
@@ -281,21 +397,21 @@ static json_result_t _json_read_callback(
                 else
                     CONFIG_RAISE(JSON_TYPE_MISMATCH);
             }
-            else if (json_match(parser, "CurrentWorkingDirectory") == JSON_OK)
+            else if (key == CONFIG_CURRENT_WORKING_DIRECTORY)
             {
                 if (type == JSON_TYPE_STRING)
                     parsed_data->cwd = un->string;
                 else
                     CONFIG_RAISE(JSON_TYPE_MISMATCH);
             }
-            else if (json_match(parser, "Hostname") == JSON_OK)
+            else if (key == CONFIG_HOSTNAME)
             {
                 if (type == JSON_TYPE_STRING)
                     parsed_data->hostname = un->string;
                 else
                     CONFIG_RAISE(JSON_TYPE_MISMATCH);
             }
-            else if (json_match(parser, "ForkMode") == JSON_OK)
+            else if (key == CONFIG_FORK_MODE)
             {
                 if (type == JSON_TYPE_STRING)
                 {
@@ -313,7 +429,7 @@ static json_result_t _json_read_callback(
                 else
                     CONFIG_RAISE(JSON_TYPE_MISMATCH);
             }
-            else if (json_match(parser, "Mount.Target") == JSON_OK)
+            else if (key == CONFIG_MOUNT_TARGET)
             {
                 if (type == JSON_TYPE_STRING)
                     parsed_data->mounts.mounts[parser->path[0].index].target =
@@ -321,7 +437,7 @@ static json_result_t _json_read_callback(
                 else
                     CONFIG_RAISE(JSON_TYPE_MISMATCH);
             }
-            else if (json_match(parser, "Mount.Type") == JSON_OK)
+            else if (key == CONFIG_MOUNT_TYPE)
             {
                 if (type == JSON_TYPE_STRING)
                     parsed_data->mounts.mounts[parser->path[0].index].fs_type =
@@ -329,7 +445,7 @@ static json_result_t _json_read_callback(
                 else
                     CONFIG_RAISE(JSON_TYPE_MISMATCH);
             }
-            else if (json_match(parser, "Mount.Flags") == JSON_OK)
+            else if (key == CONFIG_MOUNT_FLAGS)
             {
                 if (type == JSON_TYPE_STRING)
                     parsed_data->mounts.mounts[parser->path[0].index]
@@ -337,7 +453,7 @@ static json_result_t _json_read_callback(
                 else
                     CONFIG_RAISE(JSON_TYPE_MISMATCH);
             }
-            else if (json_match(parser, "Mount.PublicKey") == JSON_OK)
+            else if (key == CONFIG_MOUNT_PUBLIC_KEY)
             {
                 if (type == JSON_TYPE_STRING)
                     parsed_data->mounts.mounts[parser->path[0].index]
@@ -348,7 +464,7 @@ static json_result_t _json_read_callback(
                 else
                     CONFIG_RAISE(JSON_TYPE_MISMATCH);
             }
-            else if (json_match(parser, "Mount.RootHash") == JSON_OK)
+            else if (key == CONFIG_MOUNT_ROOT_HASH)
             {
                 if (type == JSON_TYPE_STRING)
                     parsed_data->mounts.mounts[parser->path[0].index].roothash =
@@ -359,7 +475,7 @@ static json_result_t _json_read_callback(
                 else
                     CONFIG_RAISE(JSON_TYPE_MISMATCH);
             }
-            else if (json_match(parser, "UnhandledSyscallEnosys") == JSON_OK)
+            else if (key == CONFIG_UNHANDLED_SYSCALL_ENOSYS)
             {
                 if (type == JSON_TYPE_BOOLEAN)
                     parsed_data->unhandled_syscall_enosys = un->boolean;
@@ -369,7 +485,7 @@ static json_result_t _json_read_callback(
                 else
                     CONFIG_RAISE(JSON_TYPE_MISMATCH);
             }
-            else if (json_match(parser, "Secret.ID") == JSON_OK)
+            else if (key == CONFIG_SECRET_ID)
             {
                 if (type == JSON_TYPE_STRING)
                     parsed_data->wanted_secrets.secrets[parser->path[0].index]
@@ -377,7 +493,7 @@ static json_result_t _json_read_callback(
                 else
                     CONFIG_RAISE(JSON_TYPE_MISMATCH);
             }
-            else if (json_match(parser, "Secret.SrsAddress") == JSON_OK)
+            else if (key == CONFIG_SECRET_SRS_ADDRESS)
             {
                 if (type == JSON_TYPE_STRING)
                     parsed_data->wanted_secrets.secrets[parser->path[0].index]
@@ -385,7 +501,7 @@ static json_result_t _json_read_callback(
                 else
                     CONFIG_RAISE(JSON_TYPE_MISMATCH);
             }
-            else if (json_match(parser, "Secret.SrsApiVersion") == JSON_OK)
+            else if (key == CONFIG_SECRET_SRS_API_VERSION)
             {
                 if (type == JSON_TYPE_STRING)
                     parsed_data->wanted_secrets.secrets[parser->path[0].index]
@@ -396,7 +512,7 @@ static json_result_t _json_read_callback(
                 else
                     CONFIG_RAISE(JSON_TYPE_MISMATCH);
             }
-            else if (json_match(parser, "Secret.LocalPath") == JSON_OK)
+            else if (key == CONFIG_SECRET_LOCAL_PATH)
             {
                 if (type == JSON_TYPE_STRING)
                     parsed_data->wanted_secrets.secrets[parser->path[0].index]
@@ -404,7 +520,7 @@ static json_result_t _json_read_callback(
                 else
                     CONFIG_RAISE(JSON_TYPE_MISMATCH);
             }
-            else if (json_match(parser, "Secret.ClientLib") == JSON_OK)
+            else if (key == CONFIG_SECRET_CLIENT_LIB)
             {
                 if (type == JSON_TYPE_STRING)
                     parsed_data->wanted_secrets.secrets[parser->path[0].index]
@@ -412,7 +528,7 @@ static json_result_t _json_read_callback(
                 else
                     CONFIG_RAISE(JSON_TYPE_MISMATCH);
             }
-            else if (json_match(parser, "Secret.Verbose") == JSON_OK)
+            else if (key == CONFIG_SECRET_VERBOSE)
             {
                 if (type == JSON_TYPE_BOOLEAN)
                     parsed_data->wanted_secrets.secrets[parser->path[0].index]
@@ -433,41 +549,41 @@ static json_result_t _json_read_callback(
 
         case JSON_REASON_BEGIN_ARRAY:
         {
-            if (json_match(parser, "ApplicationParameters") == JSON_OK)
+            if (key == CONFIG_APPLICATION_PARAMETERS)
             {
                 parsed_data->application_parameters =
                     calloc(parser->path[0].size + 1, sizeof(char*));
                 parsed_data->application_parameters_count =
                     parser->path[0].size;
             }
-            else if (json_match(parser, "EnvironmentVariables") == JSON_OK)
+            else if (key == CONFIG_ENVIRONMENT_VARIABLES)
             {
                 parsed_data->enclave_environment_variables =
                     calloc(parser->path[0].size + 1, sizeof(char*));
                 parsed_data->enclave_environment_variables_count =
                     parser->path[0].size;
             }
-            else if (json_match(parser, "HostEnvironmentVariables") == JSON_OK)
+            else if (key == CONFIG_HOST_ENVIRONMENT_VARIABLES)
             {
                 parsed_data->host_environment_variables =
                     calloc(parser->path[0].size + 1, sizeof(char*));
                 parsed_data->host_environment_variables_count =
                     parser->path[0].size;
             }
-            else if (json_match(parser, "Mount") == JSON_OK)
+            else if (key == CONFIG_MOUNT)
             {
                 parsed_data->mounts.mounts = calloc(
                     parser->path[0].size, sizeof(myst_mount_point_config_t));
                 parsed_data->mounts.mounts_count = parser->path[0].size;
             }
-            else if (json_match(parser, "Mount.Flags") == JSON_OK)
+            else if (key == CONFIG_MOUNT_FLAGS)
             {
                 parsed_data->mounts.mounts[parser->path[0].index].flags =
                     calloc(parser->path[1].size, sizeof(char*));
                 parsed_data->mounts.mounts[parser->path[0].index].flags_count =
                     parser->path[1].size;
             }
-            else if (json_match(parser, "Secret") == JSON_OK)
+            else if (key == CONFIG_SECRET)
             {
                 parsed_data->wanted_secrets.secrets =
                     calloc(parser->path[0].size, sizeof(myst_wanted_secret_t));
@@ -492,6 +608,7 @@ int parse_config(config_parsed_data_t* parsed_data)
 {
     int ret = -1;
     json_parser_t parser;
+    config_parser_t* cp = NULL;
     const json_parser_options_t options = {1};
     static json_allocator_t allocator = {
         malloc,
@@ -506,12 +623,33 @@ int parse_config(config_parsed_data_t* parsed_data)
         parsed_data->oe_start_address = ENCLAVE_START_ADDRESS;
     }
 
+    /* compile the configuration patterns */
+    if (!(cp = calloc(1, sizeof(config_parser_t))))
+        CONFIG_RAISE(JSON_OUT_OF_MEMORY);
+
+    cp->parsed_data = parsed_data;
+
+    if ((ret = json_trie_init(&cp->trie, cp->nodes, CONFIG_TRIE_MAX_NODES)) !=
+        JSON_OK)
+    {
+        CONFIG_RAISE(ret);
+    }
+
+    for (long i = 0; i < CONFIG_NUM_KEYS; i++)
+    {
+        if ((ret = json_trie_add(&cp->trie, _config_patterns[i], i)) !=
+            JSON_OK)
+        {
+            CONFIG_RAISE(ret);
+        }
+    }
+
     if ((ret = json_parser_init(
              &parser,
              (char*)parsed_data->buffer,
              parsed_data->buffer_length,
              _json_read_callback,
-             parsed_data,
+             cp,
              &allocator,
              &options)) != JSON_OK)
     {
@@ -530,6 +668,10 @@ int parse_config(config_parsed_data_t* parsed_data)
     ret = 0;
 
 done:
+
+    if (cp)
+        free(cp);
+
     return ret;
 }
 
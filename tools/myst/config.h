@@ -84,6 +84,10 @@ typedef struct _config_parsed_data_t
 
     size_t main_stack_size;
     size_t thread_stack_size;
+    /* size of the per-thread host buffer used for bulk I/O transfers */
+    size_t host_staging_buffer_size;
+    /* lifetime of cached hostfs attributes in milliseconds (zero disables) */
+    size_t hostfs_cache_ttl;
     /* maximum number of CPUs in the kernel (for thread affinity) */
     size_t max_affinity_cpus;
 
@@ -6,14 +6,143 @@
 #include <errno.h>
 #include <myst/clock.h>
 #include <myst/syscall.h>
+#include <stdbool.h>
 #include <stdio.h>
 
 static long _realtime0 = 0;
 static long _monotime0 = 0;
-static volatile long* _monotime_now = 0;
+static struct clock_ctrl* _ctrl = 0;
 static long _realtime_delta = 0;
 static long enc_clock_res = 0;
 
+/* the last monotonic time returned (updated lock-free) */
+static long _monotime_last = 0;
+
+/*
+** TSC interpolation: between two host ticks, the monotonic clock advances by
+** the TSC cycles elapsed since the host sampled its TSC at the last tick. The
+** TSC rate is calibrated from the host ticks themselves. Interpolation is off
+** when RDTSC is emulated (SGX1), until the calibration is done, or if the rate
+** is implausible.
+*/
+
+/* how long to observe the host ticks before calibrating the TSC rate */
+#define TSC_CALIBRATION_NS (50 * 1000 * 1000)
+
+/* never interpolate further than this past the last host tick */
+#define TSC_MAX_INTERPOLATION_NS (1000 * 1000)
+
+/* plausible TSC rates: 0.1 to 10 nanoseconds per cycle (as 32.32 numbers) */
+#define TSC_MIN_MULT ((1UL << 32) / 10)
+#define TSC_MAX_MULT ((1UL << 32) * 10)
+
+/* give up waiting for the host to finish an update after so many retries */
+#define SEQ_MAX_RETRIES 64
+
+static volatile bool _tsc_enabled = false;
+static long _tsc_base_now = 0;
+static unsigned long _tsc_base_tsc = 0;
+
+/* nanoseconds per cycle as a 32.32 fixed-point number (0 if uncalibrated) */
+static unsigned long _tsc_mult = 0;
+
+static __inline__ unsigned long _rdtsc(void)
+{
+    unsigned int lo;
+    unsigned int hi;
+
+    __asm__ __volatile__("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((unsigned long)hi << 32) | lo;
+}
+
+void myst_clock_disable_tsc(void)
+{
+    _tsc_enabled = false;
+}
+
+/* read the host tick and the host TSC at that tick (seqlock reader) */
+static bool _read_tick(long* now, unsigned long* tsc)
+{
+    for (size_t i = 0; i < SEQ_MAX_RETRIES; i++)
+    {
+        unsigned long seq = __atomic_load_n(&_ctrl->seq, __ATOMIC_ACQUIRE);
+
+        if (seq & 1)
+        {
+            __builtin_ia32_pause();
+            continue;
+        }
+
+        *now = _ctrl->now;
+        *tsc = _ctrl->tsc;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+        if (__atomic_load_n(&_ctrl->seq, __ATOMIC_RELAXED) == seq)
+            return true;
+    }
+
+    /* the host keeps the update pending: use the tick without the TSC */
+    *now = _ctrl->now;
+    *tsc = 0;
+    return false;
+}
+
+static void _calibrate_tsc(long now, unsigned long tsc)
+{
+    unsigned long ns = (unsigned long)(now - _tsc_base_now);
+    unsigned long cycles = tsc - _tsc_base_tsc;
+    unsigned long mult;
+
+    if (now - _tsc_base_now < TSC_CALIBRATION_NS || tsc <= _tsc_base_tsc)
+        return;
+
+    /* keep ns << 32 within 64 bits (the ratio is all that matters) */
+    while (ns >= (1UL << 31))
+    {
+        ns >>= 1;
+        cycles >>= 1;
+    }
+
+    if (cycles == 0)
+        return;
+
+    mult = (ns << 32) / cycles;
+
+    if (mult < TSC_MIN_MULT || mult > TSC_MAX_MULT)
+    {
+        _tsc_enabled = false;
+        return;
+    }
+
+    /* racing threads compute nearly the same value: last store wins */
+    __atomic_store_n(&_tsc_mult, mult, __ATOMIC_RELAXED);
+}
+
+/* nanoseconds elapsed since the host sampled the given TSC value */
+static long _interpolate(long now, unsigned long tsc)
+{
+    unsigned long mult;
+    unsigned long cur;
+    unsigned long ns;
+
+    if (!_tsc_enabled || tsc == 0)
+        return 0;
+
+    if (!(mult = __atomic_load_n(&_tsc_mult, __ATOMIC_RELAXED)))
+    {
+        _calibrate_tsc(now, tsc);
+        return 0;
+    }
+
+    /* the TSCs of different cores may be slightly apart */
+    if ((cur = _rdtsc()) <= tsc)
+        return 0;
+
+    ns = (unsigned long)(((unsigned __int128)(cur - tsc) * mult) >> 32);
+
+    return ns < TSC_MAX_INTERPOLATION_NS ? (long)ns : TSC_MAX_INTERPOLATION_NS;
+}
+
 int myst_setup_clock(struct clock_ctrl* ctrl)
 {
     int ret = -1;
@@ -32,15 +161,25 @@ int myst_setup_clock(struct clock_ctrl* ctrl)
             goto done;
 
         // If ctrl is outside of the enclave, ctrl->now
-        // should be outside too. _monotime_now is a host address. The address
+        // should be outside too. _ctrl is a host address. The address
         // is saved in the enclave, but we are still subject to malicious host's
-        // manipulating of the value at the address, including but not limited
+        // manipulating of the values at the address, including but not limited
         // to, decreaing the value over time, i.e., a clock goes backward. Both
         // _get_monotime and _get_realtime are guarded against such attacks.
-        _monotime_now = &ctrl->now;
+        _ctrl = ctrl;
+        _monotime_last = _monotime0;
 
         enc_clock_res = (long)ctrl->interval;
 
+        // Probe RDTSC: the exception handler disables the TSC if it is
+        // emulated with an OCALL.
+        _tsc_enabled = true;
+        _read_tick(&_tsc_base_now, &_tsc_base_tsc);
+        _rdtsc();
+
+        if (_tsc_base_tsc == 0)
+            _tsc_enabled = false;
+
         ret = 0;
     }
 done:
@@ -59,21 +198,31 @@ static void _check(bool overflowed)
 /* Return monotonic clock in nanoseconds since a starting point */
 static long _get_monotime()
 {
-    static long prev = 0;
-    if (prev == 0)
-        prev = _monotime0;
-    long now = *_monotime_now;
-    if (now > prev)
-    {
-        prev = now;
-        return now;
-    }
-    else
+    long now;
+    unsigned long tsc;
+    long prev;
+    long next;
+
+    _read_tick(&now, &tsc);
+    _check(__builtin_saddl_overflow(now, _interpolate(now, tsc), &now));
+
+    // Maintain monotonicity across all threads without a lock. If the clock
+    // did not advance (or the host moved it backward), return one nanosecond
+    // past the last value.
+    prev = __atomic_load_n(&_monotime_last, __ATOMIC_RELAXED);
+
+    do
     {
-        // maintain monotonicity.
-        // TODO: issue a warning. Host might be playing tricks.
-        return ++prev;
-    }
+        next = (now > prev) ? now : prev + 1;
+    } while (!__atomic_compare_exchange_n(
+        &_monotime_last,
+        &prev,
+        next,
+        true,
+        __ATOMIC_RELAXED,
+        __ATOMIC_RELAXED));
+
+    return next;
 }
 
 static long _get_boottime()
@@ -88,9 +237,10 @@ static long _get_realtime()
     // Derive the realtime clock from the monotonic clock.
     // Any adjustment to the system clock is invisible to the
     // enclave application once it is launched.
+    long delta = __atomic_load_n(&_realtime_delta, __ATOMIC_RELAXED);
     long ret = _get_monotime() - _monotime0;
     _check(__builtin_saddl_overflow(ret, _realtime0, &ret));
-    _check(__builtin_saddl_overflow(ret, _realtime_delta, &ret));
+    _check(__builtin_saddl_overflow(ret, delta, &ret));
     return ret;
 }
 
@@ -142,17 +292,23 @@ long myst_tcall_clock_settime(clockid_t clk_id, struct timespec* tp)
     {
         long new_time = tp->tv_sec * NANO_IN_SECOND + tp->tv_nsec;
         long cur_time = (long)_get_realtime();
+        long delta;
 
         if (new_time <= cur_time)
             return 0; // trying to set clock backward, make it no-op
 
         /* possible overflow, make it no-op */
         if (__builtin_add_overflow(
-                _realtime_delta, (new_time - cur_time), &_realtime_delta))
+                __atomic_load_n(&_realtime_delta, __ATOMIC_RELAXED),
+                (new_time - cur_time),
+                &delta))
         {
             return -EINVAL; // possible overflow, make it no-op
         }
 
+        /* readers are lock-free (the kernel serializes the writers) */
+        __atomic_store_n(&_realtime_delta, delta, __ATOMIC_RELAXED);
+
         return 0;
     }
 
@@ -193,6 +193,12 @@ static size_t _get_num_tcs(void)
 
 int myst_setup_clock(struct clock_ctrl*);
 
+int myst_setup_exitless(struct myst_exitless*);
+
+void myst_setup_staged_io(size_t size);
+
+void myst_free_staging_buffer(void);
+
 static void _sanitize_xsave_area_fields(uint64_t* rbx, uint64_t* rcx)
 {
     assert(rbx && rcx);
@@ -296,6 +302,9 @@ static uint64_t _vectored_handler(oe_exception_record_t* er)
                 uint32_t rax = 0;
                 uint32_t rdx = 0;
 
+                /* The clock must not interpolate with an emulated TSC */
+                myst_clock_disable_tsc();
+
                 /* Ask host to execute RDTSC instruction */
                 if (myst_rdtsc_ocall(&rax, &rdx) != OE_OK)
                 {
@@ -589,6 +598,14 @@ static long _enter(void* arg_)
         assert(0);
     }
 
+    if (myst_setup_exitless(shared_memory->exitless))
+    {
+        fprintf(stderr, "myst_setup_exitless() failed\n");
+        assert(0);
+    }
+
+    myst_setup_staged_io(final_options.base.host_staging_buffer_size);
+
     /* Enter the kernel image */
     {
         myst_kernel_entry_t entry;
@@ -644,6 +661,7 @@ static long _enter(void* arg_)
                                      ? final_options.base.main_stack_size
                                      : MYST_PROCESS_INIT_STACK_SIZE;
         _kargs.thread_stack_size = final_options.base.thread_stack_size;
+        _kargs.hostfs_cache_ttl = final_options.base.hostfs_cache_ttl;
 
         /* whether user-space FSGSBASE instructions are supported */
         _kargs.have_fsgsbase_instructions =
@@ -674,6 +692,7 @@ static long _enter(void* arg_)
         }
 
         ret = (*entry)(&_kargs);
+        myst_free_staging_buffer();
     }
 
 done:
@@ -741,7 +760,9 @@ int myst_enter_ecall(
 
 long myst_run_thread_ecall(uint64_t cookie, uint64_t event, pid_t target_tid)
 {
-    return myst_run_thread(cookie, event, target_tid);
+    long ret = myst_run_thread(cookie, event, target_tid);
+    myst_free_staging_buffer();
+    return ret;
 }
 
 /* This overrides the weak version in libmystkernel.a */
@@ -957,6 +978,16 @@ long myst_tcall_interrupt_thread(pid_t tid)
     return retval;
 }
 
+long myst_tcall_membarrier(int cmd, unsigned int flags)
+{
+    long retval = 0;
+
+    if (myst_membarrier_ocall(&retval, cmd, flags) != OE_OK)
+        return -ENOSYS;
+
+    return retval;
+}
+
 long myst_tcall_write_console(int fd, const void* buf, size_t count)
 {
     long ret = 0;
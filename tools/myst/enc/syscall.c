@@ -9,11 +9,13 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/ioctl.h>
+#include <sys/socket.h>
 #include <sys/stat.h>
 #include <syscall.h>
 #include <unistd.h>
 
 #include <myst/eraise.h>
+#include <myst/exitless.h>
 #include <myst/iov.h>
 #include <myst/syscall.h>
 #include <myst/tcall.h>
@@ -33,7 +35,8 @@
 // oe_host_free(), thereby incurring two extra ocalls. So attempting to perform
 // one read ocall, results in three ocalls. To avoid this overhead, we must
 // limit the buffer size to ensure the "ocall buffer" will be sufficient.
-// This buffer size is used by the read-write family of functions.
+// This buffer size is used by the read-write family of functions. Larger
+// transfers are copied through a per-thread host buffer (see staged I/O).
 #define MAX_BUFFER_SIZE 8192
 
 static long _fstat(int fd, struct stat* statbuf);
@@ -607,6 +610,300 @@ done:
     return ret;
 }
 
+/* the payloads passed to the host by one sendmmsg/recvmmsg ocall are capped
+ * at this size (though the first message is always passed) */
+#define MAX_MMSG_DATA_SIZE (256 * 1024)
+
+/* the flat buffers passed to the mmsg ocalls */
+typedef struct mmsg_buffers
+{
+    unsigned int vlen;
+    struct myst_mmsg* msgs;
+    struct myst_mmsg* caps; /* enclave copy of the sizes passed in msgs */
+    uint8_t* data;
+    size_t data_size;
+    uint8_t* names;
+    size_t names_size;
+    uint8_t* controls;
+    size_t controls_size;
+} mmsg_buffers_t;
+
+static void _free_mmsg_buffers(mmsg_buffers_t* b)
+{
+    free(b->msgs);
+    free(b->caps);
+    free(b->data);
+    free(b->names);
+    free(b->controls);
+}
+
+static long _init_mmsg_buffers(
+    const struct mmsghdr* msgvec,
+    unsigned int vlen,
+    mmsg_buffers_t* b)
+{
+    long ret = 0;
+
+    memset(b, 0, sizeof(mmsg_buffers_t));
+
+    if (!(b->msgs = calloc(vlen, sizeof(struct myst_mmsg))))
+        ERAISE(-ENOMEM);
+
+    for (unsigned int i = 0; i < vlen; i++)
+    {
+        const struct msghdr* msg = &msgvec[i].msg_hdr;
+        struct myst_mmsg* m = &b->msgs[i];
+        ssize_t len = 0;
+
+        if (msg->msg_iovlen)
+            ECHECK(len = myst_iov_len(msg->msg_iov, msg->msg_iovlen));
+
+        if (i > 0 && b->data_size + (size_t)len > MAX_MMSG_DATA_SIZE)
+            break;
+
+        if (msg->msg_name)
+        {
+            if (msg->msg_namelen > sizeof(struct sockaddr_storage))
+                ERAISE(-EINVAL);
+
+            m->namelen = msg->msg_namelen;
+        }
+
+        if (msg->msg_control)
+            m->controllen = msg->msg_controllen;
+
+        m->len = (size_t)len;
+        b->data_size += m->len;
+        b->names_size += m->namelen;
+        b->controls_size += m->controllen;
+        b->vlen++;
+    }
+
+    if (!(b->caps = malloc(b->vlen * sizeof(struct myst_mmsg))))
+        ERAISE(-ENOMEM);
+
+    memcpy(b->caps, b->msgs, b->vlen * sizeof(struct myst_mmsg));
+
+    if (b->data_size && !(b->data = malloc(b->data_size)))
+        ERAISE(-ENOMEM);
+
+    if (b->names_size && !(b->names = malloc(b->names_size)))
+        ERAISE(-ENOMEM);
+
+    if (b->controls_size && !(b->controls = malloc(b->controls_size)))
+        ERAISE(-ENOMEM);
+
+done:
+    return ret;
+}
+
+static long _sendmmsg(
+    int sockfd,
+    struct mmsghdr* msgvec,
+    unsigned int vlen,
+    int flags,
+    typeof(myst_sendmmsg_ocall) ocall)
+{
+    long ret = 0;
+    long retval;
+    mmsg_buffers_t b;
+    size_t data_off = 0;
+    size_t names_off = 0;
+    size_t controls_off = 0;
+
+    memset(&b, 0, sizeof(b));
+
+    if (sockfd < 0 || !msgvec || vlen == 0 || vlen > UIO_MAXIOV)
+        ERAISE(-EINVAL);
+
+    ECHECK(_init_mmsg_buffers(msgvec, vlen, &b));
+
+    /* flatten the messages into the buffers */
+    for (unsigned int i = 0; i < b.vlen; i++)
+    {
+        const struct msghdr* msg = &msgvec[i].msg_hdr;
+        const struct myst_mmsg* cap = &b.caps[i];
+        uint8_t* ptr = b.data + data_off;
+
+        for (int j = 0; j < (int)msg->msg_iovlen; j++)
+        {
+            const struct iovec* v = &msg->msg_iov[j];
+
+            if (v->iov_len)
+                memcpy(ptr, v->iov_base, v->iov_len);
+
+            ptr += v->iov_len;
+        }
+
+        if (cap->namelen)
+            memcpy(b.names + names_off, msg->msg_name, cap->namelen);
+
+        if (cap->controllen)
+        {
+            memcpy(
+                b.controls + controls_off, msg->msg_control, cap->controllen);
+        }
+
+        data_off += cap->len;
+        names_off += cap->namelen;
+        controls_off += cap->controllen;
+    }
+
+    if (ocall(
+            &retval,
+            sockfd,
+            b.msgs,
+            b.vlen,
+            b.data,
+            b.data_size,
+            b.names,
+            b.names_size,
+            b.controls,
+            b.controls_size,
+            flags) != OE_OK)
+    {
+        ERAISE(-EINVAL);
+    }
+
+    ECHECK(retval);
+
+    /* guard against the host returning too large a count */
+    if (retval > (long)b.vlen)
+        ERAISE(-EINVAL);
+
+    for (long i = 0; i < retval; i++)
+    {
+        /* guard against host returning a size bigger than the message */
+        if (b.msgs[i].msg_len > b.caps[i].len)
+            ERAISE(-EINVAL);
+
+        msgvec[i].msg_len = b.msgs[i].msg_len;
+    }
+
+    ret = retval;
+
+done:
+    _free_mmsg_buffers(&b);
+    return ret;
+}
+
+static long _recvmmsg(
+    int sockfd,
+    struct mmsghdr* msgvec,
+    unsigned int vlen,
+    int flags,
+    typeof(myst_recvmmsg_ocall) ocall)
+{
+    long ret = 0;
+    long retval;
+    mmsg_buffers_t b;
+    size_t data_off = 0;
+    size_t names_off = 0;
+    size_t controls_off = 0;
+
+    memset(&b, 0, sizeof(b));
+
+    if (sockfd < 0 || !msgvec || vlen == 0 || vlen > UIO_MAXIOV)
+        ERAISE(-EINVAL);
+
+    ECHECK(_init_mmsg_buffers(msgvec, vlen, &b));
+
+    if (ocall(
+            &retval,
+            sockfd,
+            b.msgs,
+            b.vlen,
+            b.data,
+            b.data_size,
+            b.names,
+            b.names_size,
+            b.controls,
+            b.controls_size,
+            flags) != OE_OK)
+    {
+        ERAISE(-EINVAL);
+    }
+
+    ECHECK(retval);
+
+    /* guard against the host returning too large a count */
+    if (retval > (long)b.vlen)
+        ERAISE(-EINVAL);
+
+    /* scatter the buffers onto the messages (using the enclave's sizes) */
+    for (long i = 0; i < retval; i++)
+    {
+        struct msghdr* msg = &msgvec[i].msg_hdr;
+        const struct myst_mmsg* cap = &b.caps[i];
+        const struct myst_mmsg* out = &b.msgs[i];
+
+        /* guard against host returning a size larger than the buffer */
+        if (out->msg_len > cap->len)
+            ERAISE(-EINVAL);
+
+        if (msg->msg_iovlen)
+        {
+            ECHECK(myst_iov_scatter(
+                msg->msg_iov,
+                msg->msg_iovlen,
+                b.data + data_off,
+                out->msg_len));
+        }
+
+        msg->msg_flags = out->msg_flags;
+
+        if (msg->msg_name)
+        {
+            size_t namelen = out->namelen;
+
+            if (namelen > sizeof(struct sockaddr_storage))
+                ERAISE(-EINVAL);
+
+            if (namelen > cap->namelen)
+                namelen = cap->namelen;
+
+            memcpy(msg->msg_name, b.names + names_off, namelen);
+
+            /* note: namelen may legitimately be bigger due to truncation */
+            msg->msg_namelen = out->namelen;
+        }
+        else
+        {
+            msg->msg_namelen = 0;
+        }
+
+        if (msg->msg_control)
+        {
+            size_t controllen = out->controllen;
+
+            if (controllen > cap->controllen)
+            {
+                controllen = cap->controllen;
+                msg->msg_flags |= MSG_CTRUNC;
+            }
+
+            memcpy(msg->msg_control, b.controls + controls_off, controllen);
+            msg->msg_controllen = controllen;
+        }
+        else
+        {
+            msg->msg_controllen = 0;
+        }
+
+        msgvec[i].msg_len = out->msg_len;
+
+        data_off += cap->len;
+        names_off += cap->namelen;
+        controls_off += cap->controllen;
+    }
+
+    ret = retval;
+
+done:
+    _free_mmsg_buffers(&b);
+    return ret;
+}
+
 static long _shutdown(int sockfd, int how)
 {
     long ret;
@@ -1532,6 +1829,77 @@ done:
 }
 #endif
 
+#ifdef MYST_ENABLE_HOSTFS
+static long _sendfile(int out_fd, int in_fd, off_t* offset, size_t count)
+{
+    long ret = 0;
+    long retval;
+
+    if (out_fd < 0 || in_fd < 0 || count > SSIZE_MAX)
+    {
+        ret = -EINVAL;
+        goto done;
+    }
+
+    if (myst_sendfile_ocall(&retval, out_fd, in_fd, offset, count) != OE_OK)
+    {
+        ret = -EINVAL;
+        goto done;
+    }
+
+    /* guard against host setting the return value greater than count */
+    if (retval > (long)count)
+    {
+        ret = -EINVAL;
+        goto done;
+    }
+
+    ret = retval;
+
+done:
+    return ret;
+}
+#endif
+
+#ifdef MYST_ENABLE_HOSTFS
+static long _copy_file_range(
+    int fd_in,
+    off_t* off_in,
+    int fd_out,
+    off_t* off_out,
+    size_t len,
+    unsigned int flags)
+{
+    long ret = 0;
+    long retval;
+
+    if (fd_in < 0 || fd_out < 0 || len > SSIZE_MAX)
+    {
+        ret = -EINVAL;
+        goto done;
+    }
+
+    if (myst_copy_file_range_ocall(
+            &retval, fd_in, off_in, fd_out, off_out, len, flags) != OE_OK)
+    {
+        ret = -EINVAL;
+        goto done;
+    }
+
+    /* guard against host setting the return value greater than len */
+    if (retval > (long)len)
+    {
+        ret = -EINVAL;
+        goto done;
+    }
+
+    ret = retval;
+
+done:
+    return ret;
+}
+#endif
+
 #ifdef MYST_ENABLE_HOSTFS
 static long _utimensat(
     int dirfd,
@@ -1870,6 +2238,435 @@ done:
     return ret;
 }
 
+/*
+**==============================================================================
+**
+** staged I/O:
+**
+** Transfers larger than MAX_BUFFER_SIZE are copied through a per-thread
+** staging buffer in host memory that is allocated on first use and passed to
+** the host as a raw pointer. This avoids the OE ocall buffer (and the extra
+** oe_host_malloc/oe_host_free ocalls) so that a large read or write costs one
+** OCALL and one copy across the boundary instead of being split into many
+** MAX_BUFFER_SIZE transfers.
+**
+**==============================================================================
+*/
+
+#define DEFAULT_STAGING_BUFFER_SIZE (1024 * 1024)
+#define MAX_STAGING_BUFFER_SIZE (64 * 1024 * 1024)
+
+static size_t _staging_buffer_size = DEFAULT_STAGING_BUFFER_SIZE;
+static __thread void* _staging_buffer;
+
+void myst_setup_staged_io(size_t size)
+{
+    if (size == 0)
+        size = DEFAULT_STAGING_BUFFER_SIZE;
+    else if (size > MAX_STAGING_BUFFER_SIZE)
+        size = MAX_STAGING_BUFFER_SIZE;
+
+    /* buffers no larger than the OCALL limit are never used */
+    _staging_buffer_size = (size > MAX_BUFFER_SIZE) ? size : 0;
+}
+
+/* called before an enclave thread returns to the host for good */
+void myst_free_staging_buffer(void)
+{
+    if (_staging_buffer)
+    {
+        oe_host_free(_staging_buffer);
+        _staging_buffer = NULL;
+    }
+}
+
+/* return this thread's staging buffer (and its size), allocating it first */
+static void* _get_staging_buffer(size_t* size)
+{
+    /* vectored I/O uses the buffer even when staged I/O is disabled */
+    *size = _staging_buffer_size ? _staging_buffer_size : MAX_BUFFER_SIZE;
+
+    if (!_staging_buffer)
+        _staging_buffer = oe_host_malloc(*size);
+
+    return _staging_buffer;
+}
+
+static bool _is_staged_io(long n, const long params[6])
+{
+    if (_staging_buffer_size == 0 || (size_t)params[2] <= MAX_BUFFER_SIZE)
+        return false;
+
+    switch (n)
+    {
+        case SYS_read:
+        case SYS_write:
+        case SYS_pread64:
+        case SYS_pwrite64:
+        case MYST_TCALL_READ_BLOCK:
+        case MYST_TCALL_WRITE_BLOCK:
+        case SYS_getdents64:
+            return true;
+        case SYS_recvfrom:
+        case SYS_sendto:
+        case MYST_TCALL_RECVFROM_BLOCK:
+        case MYST_TCALL_SENDTO_BLOCK:
+            /* socket addresses are not staged */
+            return !params[4] && !params[5];
+        default:
+            return false;
+    }
+}
+
+static long _staged_io(long n, const long params[6])
+{
+    long ret = 0;
+    long retval;
+    int fd = (int)params[0];
+    void* buf = (void*)params[1];
+    size_t count = (size_t)params[2];
+    bool output;
+    void* staging_buffer;
+    size_t size;
+
+    if (fd < 0 || !buf || count > SSIZE_MAX)
+        ERAISE(-EINVAL);
+
+    output = (n == SYS_read || n == SYS_pread64 || n == SYS_recvfrom ||
+              n == MYST_TCALL_READ_BLOCK || n == MYST_TCALL_RECVFROM_BLOCK ||
+              n == SYS_getdents64);
+
+    if (!(staging_buffer = _get_staging_buffer(&size)))
+        ERAISE(-ENOMEM);
+
+    if (count > size)
+        count = size;
+
+    if (!output)
+        memcpy(staging_buffer, buf, count);
+
+    if (myst_staged_io_ocall(
+            &retval, n, fd, staging_buffer, count, params[3]) != OE_OK)
+    {
+        ERAISE(-EINVAL);
+    }
+
+    if (retval < 0)
+    {
+        ret = retval;
+        goto done;
+    }
+
+    /* guard against host returning a size bigger than the buffer */
+    if (retval > (ssize_t)count)
+        ERAISE(-EINVAL);
+
+    if (output)
+        memcpy(buf, staging_buffer, (size_t)retval);
+
+    ret = retval;
+
+done:
+    return ret;
+}
+
+/*
+**==============================================================================
+**
+** vectored I/O:
+**
+** readv() and writev() are carried out as read and write calls on the
+** staging buffer. The enclave gathers the caller's vector straight into the
+** buffer (or scatters the buffer straight into the vector), so the vector is
+** never flattened in enclave memory first and each byte is copied across the
+** boundary once. Vectors larger than the buffer take several ocalls, which
+** stop at the first short count. Splitting is only correct for byte streams:
+** on a datagram socket each call would send (or consume) a separate
+** datagram, so such vectors go to the host in one call through a temporary
+** buffer (up to MAX_DATAGRAM_SIZE).
+**
+**==============================================================================
+*/
+
+/* the largest datagram that readv() and writev() transfer in one call */
+#define MAX_DATAGRAM_SIZE (1024 * 1024)
+
+/* whether FD carries a byte stream, which may be split across calls */
+static bool _is_stream(int fd)
+{
+    int type;
+    socklen_t len = sizeof(type);
+
+    /* anything but a socket (file, pipe, terminal) is a stream */
+    if (_getsockopt(fd, SOL_SOCKET, SO_TYPE, &type, &len) != 0)
+        return true;
+
+    return type == SOCK_STREAM;
+}
+
+static long _vectored_io(long n, const long params[6])
+{
+    long ret = 0;
+    int fd = (int)params[0];
+    const struct iovec* iov = (const struct iovec*)params[1];
+    int iovcnt = (int)params[2];
+    const bool output = (n == SYS_readv || n == MYST_TCALL_READV_BLOCK);
+    long op;
+    ssize_t len;
+    void* staging_buffer;
+    size_t size;
+    void* datagram_buffer = NULL;
+    myst_iov_cursor_t cursor;
+    size_t total = 0;
+
+    if (fd < 0 || iovcnt < 0 || iovcnt > IOV_MAX)
+        ERAISE(-EINVAL);
+
+    ECHECK(len = myst_iov_len(iov, iovcnt));
+
+    switch (n)
+    {
+        case SYS_readv:
+            op = SYS_read;
+            break;
+        case MYST_TCALL_READV_BLOCK:
+            op = MYST_TCALL_READ_BLOCK;
+            break;
+        case SYS_writev:
+            op = SYS_write;
+            break;
+        case MYST_TCALL_WRITEV_BLOCK:
+            op = MYST_TCALL_WRITE_BLOCK;
+            break;
+        default:
+            ERAISE(-ENOSYS);
+    }
+
+    if (!(staging_buffer = _get_staging_buffer(&size)))
+        ERAISE(-ENOMEM);
+
+    /* a datagram must not be split: transfer it in one call */
+    if ((size_t)len > size && !_is_stream(fd))
+    {
+        if ((size_t)len > MAX_DATAGRAM_SIZE)
+        {
+            /* larger datagrams are truncated by readv() anyway */
+            if (!output)
+                ERAISE(-EMSGSIZE);
+
+            len = MAX_DATAGRAM_SIZE;
+        }
+
+        if (!(datagram_buffer = oe_host_malloc((size_t)len)))
+            ERAISE(-ENOMEM);
+
+        staging_buffer = datagram_buffer;
+        size = (size_t)len;
+    }
+
+    myst_iov_cursor_init(&cursor, iov, iovcnt);
+
+    while (total < (size_t)len)
+    {
+        size_t count = (size_t)len - total;
+        long retval;
+
+        if (count > size)
+            count = size;
+
+        if (!output)
+            myst_iov_cursor_gather(&cursor, staging_buffer, count);
+
+        if (myst_staged_io_ocall(
+                &retval, op, fd, staging_buffer, count, 0) != OE_OK)
+        {
+            ERAISE(-EINVAL);
+        }
+
+        if (retval < 0)
+        {
+            /* report the bytes already transferred */
+            if (total == 0)
+                ret = retval;
+            break;
+        }
+
+        /* guard against host returning a size bigger than the buffer */
+        if (retval > (ssize_t)count)
+            ERAISE(-EINVAL);
+
+        if (output)
+            myst_iov_cursor_scatter(&cursor, staging_buffer, retval);
+
+        total += (size_t)retval;
+
+        if ((size_t)retval < count || datagram_buffer)
+            break;
+
+        /* only the first read may block (like readv() on a blocking fd) */
+        if (op == MYST_TCALL_READ_BLOCK)
+            op = SYS_read;
+    }
+
+    if (ret == 0)
+        ret = (long)total;
+
+done:
+
+    if (datagram_buffer)
+        oe_host_free(datagram_buffer);
+
+    return ret;
+}
+
+/*
+**==============================================================================
+**
+** exitless tcalls:
+**
+** Requests are staged in the data area of a slot of the host-resident queue
+** and executed by host worker threads without leaving the enclave. Only
+** calls whose buffers fit in the staging area are eligible; all others (and
+** any request the workers do not pick up in time) fall back to an OCALL.
+**
+**==============================================================================
+*/
+
+static myst_exitless_t* _exitless;
+static uint32_t _exitless_classes;
+
+int myst_setup_exitless(struct myst_exitless* queue)
+{
+    if (!queue)
+        return 0;
+
+    if (!oe_is_outside_enclave(queue, sizeof(myst_exitless_t)))
+        return -1;
+
+    /* the clock class is already serviced inside the enclave */
+    _exitless_classes = queue->classes & ~MYST_EXITLESS_CLOCK;
+    _exitless = queue;
+
+    return 0;
+}
+
+/* a request that runs long on the host is waited for with yield OCALLs */
+static void _exitless_yield(void)
+{
+    _sched_yield();
+}
+
+static int _exitless_tcall(long n, const long params[6], long* ret)
+{
+    int r = -EAGAIN;
+    myst_exitless_slot_t* slot;
+    long args[6];
+    void* buf = (void*)params[1];
+    size_t count = 0;
+    bool copy_out = false;
+
+    if (!(slot = myst_exitless_acquire(_exitless)))
+        return -EAGAIN;
+
+    memcpy(args, params, sizeof(args));
+
+    switch (n)
+    {
+        case SYS_recvfrom:
+        {
+            /* source addresses are not staged */
+            if (params[4] || params[5])
+                goto done;
+        }
+        /* fallthrough */
+        case SYS_read:
+        case SYS_pread64:
+        {
+            if ((!buf && params[2]) || (size_t)params[2] > SSIZE_MAX)
+                goto done;
+
+            count = (size_t)params[2];
+
+            if (count > MYST_EXITLESS_DATA_SIZE)
+                count = MYST_EXITLESS_DATA_SIZE;
+
+            args[1] = (long)slot->data;
+            args[2] = (long)count;
+            copy_out = true;
+            break;
+        }
+        case SYS_sendto:
+        {
+            /* destination addresses are not staged */
+            if (params[4] || params[5])
+                goto done;
+        }
+        /* fallthrough */
+        case SYS_write:
+        case SYS_pwrite64:
+        {
+            if ((!buf && params[2]) || (size_t)params[2] > SSIZE_MAX)
+                goto done;
+
+            count = (size_t)params[2];
+
+            if (count > MYST_EXITLESS_DATA_SIZE)
+                count = MYST_EXITLESS_DATA_SIZE;
+
+            memcpy(slot->data, buf, count);
+            args[1] = (long)slot->data;
+            args[2] = (long)count;
+            break;
+        }
+        case SYS_fstat:
+        {
+            if (!buf)
+                goto done;
+
+            count = sizeof(struct stat);
+            args[1] = (long)slot->data;
+            break;
+        }
+        case SYS_close:
+        case SYS_lseek:
+        case SYS_fsync:
+        case SYS_fdatasync:
+        case SYS_ftruncate:
+        case SYS_shutdown:
+        case SYS_listen:
+        {
+            break;
+        }
+        default:
+        {
+            goto done;
+        }
+    }
+
+    r = myst_exitless_post(_exitless, slot, n, args, ret, _exitless_yield);
+
+    if (r != 0)
+        goto done;
+
+    if (n == SYS_fstat)
+    {
+        if (*ret == 0)
+            memcpy(buf, slot->data, count);
+    }
+    else if (count)
+    {
+        /* guard against host returning a size bigger than the buffer */
+        if (*ret > (long)count)
+            *ret = -EINVAL;
+        else if (copy_out && *ret > 0)
+            memcpy(buf, slot->data, (size_t)*ret);
+    }
+
+done:
+    myst_exitless_release(slot);
+    return r;
+}
+
 long myst_handle_tcall(long n, long params[6])
 {
     const long a = params[0];
@@ -1879,6 +2676,26 @@ long myst_handle_tcall(long n, long params[6])
     const long e = params[4];
     const long f = params[5];
 
+    if (_is_staged_io(n, params))
+        return _staged_io(n, params);
+
+    switch (n)
+    {
+        case SYS_readv:
+        case SYS_writev:
+        case MYST_TCALL_READV_BLOCK:
+        case MYST_TCALL_WRITEV_BLOCK:
+            return _vectored_io(n, params);
+    }
+
+    if (_exitless && (myst_exitless_class(n) & _exitless_classes))
+    {
+        long ret;
+
+        if (_exitless_tcall(n, params, &ret) == 0)
+            return ret;
+    }
+
     switch (n)
     {
         case SYS_read:
@@ -2025,6 +2842,42 @@ long myst_handle_tcall(long n, long params[6])
             return _recvmsg(
                 (int)a, (struct msghdr*)b, (int)c, myst_recvmsg_block_ocall);
         }
+        case SYS_sendmmsg:
+        {
+            return _sendmmsg(
+                (int)a,
+                (struct mmsghdr*)b,
+                (unsigned int)c,
+                (int)d,
+                myst_sendmmsg_ocall);
+        }
+        case MYST_TCALL_SENDMMSG_BLOCK:
+        {
+            return _sendmmsg(
+                (int)a,
+                (struct mmsghdr*)b,
+                (unsigned int)c,
+                (int)d,
+                myst_sendmmsg_block_ocall);
+        }
+        case SYS_recvmmsg:
+        {
+            return _recvmmsg(
+                (int)a,
+                (struct mmsghdr*)b,
+                (unsigned int)c,
+                (int)d,
+                myst_recvmmsg_ocall);
+        }
+        case MYST_TCALL_RECVMMSG_BLOCK:
+        {
+            return _recvmmsg(
+                (int)a,
+                (struct mmsghdr*)b,
+                (unsigned int)c,
+                (int)d,
+                myst_recvmmsg_block_ocall);
+        }
         case SYS_shutdown:
         {
             return _shutdown((int)a, (int)b);
@@ -2168,6 +3021,15 @@ long myst_handle_tcall(long n, long params[6])
         {
             return _lseek((int)a, b, (int)c);
         }
+        case SYS_sendfile:
+        {
+            return _sendfile((int)a, (int)b, (off_t*)c, (size_t)d);
+        }
+        case SYS_copy_file_range:
+        {
+            return _copy_file_range(
+                (int)a, (off_t*)b, (int)c, (off_t*)d, (size_t)e, (unsigned)f);
+        }
         case SYS_utimensat:
         {
             return _utimensat(
@@ -51,7 +51,7 @@ int _mkcpio(int argc, const char* argv[])
     const char* directory = argv[2];
     const char* cpioarchive = argv[3];
 
-    if (myst_cpio_pack(directory, cpioarchive) != 0)
+    if (myst_cpio_pack_parallel(directory, cpioarchive, 0) != 0)
     {
         _err(
             "failed to create CPIO archive from %s: %s",
@@ -76,7 +76,7 @@ int _excpio(int argc, const char* argv[])
     const char* cpioarchive = argv[2];
     const char* directory = argv[3];
 
-    if (myst_cpio_unpack(cpioarchive, directory) != 0)
+    if (myst_cpio_unpack_parallel(cpioarchive, directory, 0) != 0)
     {
         _err(
             "failed to extract CPIO archive to %s: %s", directory, cpioarchive);
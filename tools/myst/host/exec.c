@@ -24,6 +24,7 @@
 #include <myst/buf.h>
 #include <myst/cpio.h>
 #include <myst/eraise.h>
+#include <myst/exitless.h>
 #include <myst/file.h>
 #include <myst/fssig.h>
 #include <myst/getopt.h>
@@ -203,6 +204,16 @@ static void _wait_on_child_threads(void)
     }
 }
 
+/* executes requests posted by the enclave to the exitless tcall queue; the
+ * enclave has already staged any buffers in the untrusted slot data area */
+static long _exitless_syscall(long n, long params[6])
+{
+    long ret = syscall(
+        n, params[0], params[1], params[2], params[3], params[4], params[5]);
+
+    return (ret < 0) ? -errno : ret;
+}
+
 int exec_launch_enclave(
     const char* enc_path,
     oe_enclave_type_t type,
@@ -279,6 +290,29 @@ int exec_launch_enclave(
     /* Get clock times right before entering the enclave */
     shm_create_clock(&shared_memory, CLOCK_TICK);
 
+    /* The enclave reads the clock from shared memory without exiting */
+    if (options->exitless_classes & MYST_EXITLESS_CLOCK)
+    {
+        fprintf(
+            stderr,
+            "myst: warning: ignoring the \"clock\" class of "
+            "--exitless-calls (the enclave reads the clock without "
+            "exiting)\n");
+        options->exitless_classes &= ~MYST_EXITLESS_CLOCK;
+    }
+
+    /* Start the exitless tcall workers if any tcall classes were selected */
+    if (options->exitless_classes)
+    {
+        if (!(shared_memory.exitless = myst_exitless_create(
+                  options->exitless_classes,
+                  options->exitless_workers,
+                  _exitless_syscall)))
+        {
+            _err("failed to create the exitless tcall queue");
+        }
+    }
+
     /* Set a MYST_INTERRUPT_THREAD_SIGNAL handler */
     old_sighandler =
         sigset(MYST_INTERRUPT_THREAD_SIGNAL, _interrupt_thread_signal_handler);
@@ -326,6 +360,12 @@ int exec_launch_enclave(
 
     shm_free_clock(&shared_memory);
 
+    if (shared_memory.exitless)
+    {
+        myst_exitless_free(shared_memory.exitless);
+        shared_memory.exitless = NULL;
+    }
+
     free(argv_buf.data);
     free(envp_buf.data);
     free(mount_mappings_buf.data);
@@ -372,6 +412,22 @@ Options:\n\
                             it encounters an unimplemented syscall\n\
                             'true' implies the syscall would not terminate\n\
                             and instead return ENOSYS.\n\
+    --exitless-calls <classes>\n\
+                         -- comma separated list of tcall classes (sockets,\n\
+                            files, clock or all) serviced by host worker\n\
+                            threads without exiting the enclave (clock\n\
+                            is ignored: the enclave never exits for it)\n\
+    --exitless-workers <n>\n\
+                         -- number of host worker threads polling for\n\
+                            exitless tcalls (default 2)\n\
+    --host-staging-buffer-size <size>\n\
+                         -- size of the per-thread host buffer used to\n\
+                            transfer large reads and writes in a single\n\
+                            enclave exit (default 1m)\n\
+    --hostfs-cache-ttl <msec>\n\
+                         -- cache hostfs file attributes and directory\n\
+                            listings for this many milliseconds\n\
+                            (default 0, no caching)\n\
 \n"
 
 int exec_action(int argc, const char* argv[], const char* envp[])
@@ -484,6 +540,27 @@ int exec_action(int argc, const char* argv[], const char* envp[])
             return 1;
         }
 
+        if (get_exitless_opts(
+                &argc,
+                argv,
+                &options.exitless_classes,
+                &options.exitless_workers) != 0)
+        {
+            fprintf(
+                stderr,
+                "%s: invalid --exitless-calls or --exitless-workers option. "
+                "Classes must be a comma separated list of \"sockets\", "
+                "\"files\" and \"clock\" (or \"all\")\n",
+                argv[0]);
+            return 1;
+        }
+
+        if (get_hostfs_cache_opts(&argc, argv, &options.hostfs_cache_ttl) != 0)
+        {
+            fprintf(stderr, "%s: invalid --hostfs-cache-ttl option\n", argv[0]);
+            return 1;
+        }
+
         /* Get MYST_MEMCHECK environment variable */
         {
             const char* env;
@@ -565,6 +642,30 @@ int exec_action(int argc, const char* argv[], const char* envp[])
             }
         }
 
+        /* Get --host-staging-buffer-size */
+        {
+            const char* opt = "--host-staging-buffer-size";
+            const char* arg = NULL;
+
+            if (cli_getopt(&argc, argv, opt, &arg) == 0)
+            {
+                if (arg)
+                {
+                    if ((myst_expand_size_string_to_ulong(
+                             arg, &options.host_staging_buffer_size) != 0) ||
+                        (myst_round_up(
+                             options.host_staging_buffer_size,
+                             PAGE_SIZE,
+                             &options.host_staging_buffer_size) != 0))
+                    {
+                        _err(
+                            "%s <size> -- bad suffix (must be k, m, or g)\n",
+                            opt);
+                    }
+                }
+            }
+        }
+
         /* Get --app-config option if it exists, otherwise we use default values
          */
         cli_getopt(&argc, argv, "--app-config-path", &commandline_config);
@@ -771,6 +872,16 @@ long myst_interrupt_thread_ocall(pid_t tid)
     return myst_tcall_interrupt_thread(tid);
 }
 
+long myst_membarrier_ocall(int cmd, unsigned int flags)
+{
+    long ret = syscall(SYS_membarrier, cmd, flags, 0);
+
+    if (ret < 0)
+        ret = -errno;
+
+    return ret;
+}
+
 long myst_write_console_ocall(int fd, const void* buf, size_t count)
 {
     long ret = 0;
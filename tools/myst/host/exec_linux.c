@@ -5,6 +5,7 @@
 #include <assert.h>
 #include <linux/futex.h>
 #include <pthread.h>
+#include <sched.h>
 #include <signal.h>
 #include <stdbool.h>
 #include <stdio.h>
@@ -18,6 +19,7 @@
 #include <myst/cpio.h>
 #include <myst/elf.h>
 #include <myst/eraise.h>
+#include <myst/exitless.h>
 #include <myst/file.h>
 #include <myst/hex.h>
 #include <myst/kernel.h>
@@ -82,6 +84,17 @@ Options:\n\
                             it encounters an unimplemented syscall\n\
                             'true' implies the syscall would not terminate\n\
                             and instead return ENOSYS.\n\
+    --exitless-calls <classes>\n\
+                         -- comma separated list of tcall classes (sockets,\n\
+                            files, clock or all) serviced by host worker\n\
+                            threads instead of the calling thread\n\
+    --exitless-workers <n>\n\
+                         -- number of host worker threads polling for\n\
+                            exitless tcalls (default 2)\n\
+    --hostfs-cache-ttl <msec>\n\
+                         -- cache hostfs file attributes and directory\n\
+                            listings for this many milliseconds\n\
+                            (default 0, no caching)\n\
 \n\
 "
 
@@ -157,6 +170,15 @@ static void _get_options(
             "supported\n",
             argv[0]);
 
+    if (get_exitless_opts(
+            argc, argv, &opts->exitless_classes, &opts->exitless_workers) != 0)
+    {
+        _err("invalid --exitless-calls or --exitless-workers option");
+    }
+
+    if (get_hostfs_cache_opts(argc, argv, &opts->hostfs_cache_ttl) != 0)
+        _err("invalid --hostfs-cache-ttl option");
+
     /* Get --max-affinity-cpus */
     {
         const char* arg = NULL;
@@ -501,6 +523,8 @@ static int _enter_kernel(
 
     kernel_args.perf = final_options.base.perf;
 
+    kernel_args.hostfs_cache_ttl = final_options.base.hostfs_cache_ttl;
+
     /* check whether FSGSBASE instructions are supported */
     if (test_user_space_fsgsbase() == 0)
         kernel_args.have_fsgsbase_instructions = true;
@@ -555,8 +579,30 @@ done:
     return ret;
 }
 
+/* exitless tcall queue (null unless --exitless-calls was given) */
+static myst_exitless_t* _exitless;
+
+static void _exitless_yield(void)
+{
+    sched_yield();
+}
+
 __attribute__((__unused__)) static long _tcall(long n, long params[6])
 {
+    if (_exitless && (myst_exitless_class(n) & _exitless->classes))
+    {
+        long ret;
+
+        if (myst_exitless_call(
+                _exitless, n, params, &ret, _exitless_yield) == 0)
+        {
+            return ret;
+        }
+
+        /* fall back to a direct call and get the parked workers going */
+        myst_exitless_wake(_exitless);
+    }
+
     return myst_tcall(n, params);
 }
 
@@ -681,6 +727,16 @@ int exec_linux_action(int argc, const char* argv[], const char* envp[])
     sigaddset(&set, MYST_INTERRUPT_THREAD_SIGNAL);
     sigprocmask(SIG_BLOCK, &set, NULL);
 
+    /* Start the exitless tcall workers if any tcall classes were selected */
+    if (opts.exitless_classes)
+    {
+        if (!(_exitless = myst_exitless_create(
+                  opts.exitless_classes, opts.exitless_workers, myst_tcall)))
+        {
+            _err("failed to create the exitless tcall queue");
+        }
+    }
+
     /* Enter the kernel image */
     if (_enter_kernel(
             argc,
@@ -705,6 +761,12 @@ int exec_linux_action(int argc, const char* argv[], const char* envp[])
     /* restore the old MYST_INTERRUPT_THREAD_SIGNAL handler */
     sigset(MYST_INTERRUPT_THREAD_SIGNAL, old_sighandler);
 
+    if (_exitless)
+    {
+        myst_exitless_free(_exitless);
+        _exitless = NULL;
+    }
+
     myst_args_release(&mount_mappings);
 
     free_region_details();
@@ -0,0 +1,828 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+
+#include <myst/byteorder.h>
+#include <myst/eraise.h>
+#include <myst/luks.h>
+#include <myst/verity.h>
+
+#include "image.h"
+
+/*
+**==============================================================================
+**
+** In-process image builder for myst mkext2.
+**
+** The image is produced in one streaming pass over the ext2 file system: the
+** data blocks are divided into chunks, and every thread repeatedly takes the
+** next chunk, encrypts its sectors (LUKS images only), writes them to the
+** image, and hashes the resulting blocks into the leaves of the dm-verity hash
+** tree. The upper levels of the tree are small and are computed afterwards.
+**
+** The layouts are those read by utils/luksblkdev.c and utils/verityblkdev.c
+** (and produced by cryptsetup luksFormat --type luks1 and veritysetup format),
+** so the images still open on Linux.
+**
+**==============================================================================
+*/
+
+#define MAX_THREADS 64
+
+/* dm-verity data and hash block size */
+#define BLOCK_SIZE 4096
+
+/* number of data blocks handled by a thread at a time (1 MB) */
+#define CHUNK_BLOCKS 256
+
+#define HASH_SIZE MYST_SHA256_SIZE
+
+#define DIGESTS_PER_BLOCK (BLOCK_SIZE / HASH_SIZE)
+
+/* LUKS1 definitions (see the LUKS On-Disk Format Specification) */
+#define LUKS_VERSION 1
+#define LUKS_KEY_ENABLED 0x00AC71F3
+#define LUKS_KEY_DISABLED 0x0000DEAD
+#define LUKS_STRIPES 4000
+#define LUKS_ALIGN_KEYSLOTS 4096
+#define LUKS_PAYLOAD_OFFSET (MKEXT2_LUKS_HEADER_SIZE / LUKS_SECTOR_SIZE)
+#define LUKS_MK_DIGEST_ITERATIONS 100000
+#define LUKS_KEYSLOT_ITERATIONS 1000000
+
+/* size of the anti-forensic key material of one key slot */
+#define LUKS_AF_SIZE (MKEXT2_LUKS_KEY_SIZE * LUKS_STRIPES)
+
+/* sectors taken by one key slot (aligned like cryptsetup does) */
+#define LUKS_KEYSLOT_SECTORS                                           \
+    (((LUKS_AF_SIZE + LUKS_ALIGN_KEYSLOTS - 1) / LUKS_ALIGN_KEYSLOTS) * \
+     (LUKS_ALIGN_KEYSLOTS / LUKS_SECTOR_SIZE))
+
+#define LUKS_FIRST_KEYSLOT_SECTOR (LUKS_ALIGN_KEYSLOTS / LUKS_SECTOR_SIZE)
+
+_Static_assert(LUKS_AF_SIZE % LUKS_SECTOR_SIZE == 0, "");
+_Static_assert(
+    LUKS_FIRST_KEYSLOT_SECTOR + LUKS_SLOTS_SIZE * LUKS_KEYSLOT_SECTORS <=
+        LUKS_PAYLOAD_OFFSET,
+    "");
+_Static_assert(MKEXT2_LUKS_HEADER_SIZE % BLOCK_SIZE == 0, "");
+
+typedef struct stream
+{
+    /* the unencrypted LUKS header area (LUKS images only) */
+    const uint8_t* header;
+    size_t header_size;
+
+    /* the mapped ext2 file system (the LUKS payload) */
+    const uint8_t* payload;
+
+    /* the master key (LUKS images only) */
+    const uint8_t* masterkey;
+
+    /* the output image (-1 when hashing the ext2 image in place) */
+    int fd;
+
+    /* the verity salt and the leaves of the hash tree */
+    const uint8_t* salt;
+    uint8_t* leaves;
+
+    size_t num_blocks;
+    size_t num_chunks;
+
+    /* index of the next chunk (shared by all threads) */
+    size_t next;
+    int failed;
+} stream_t;
+
+static size_t _num_threads(size_t num_threads)
+{
+    if (num_threads == 0)
+    {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        num_threads = (n > 0) ? (size_t)n : 1;
+    }
+
+    return num_threads > MAX_THREADS ? MAX_THREADS : num_threads;
+}
+
+static int _pwrite_all(int fd, const void* data, size_t size, off_t offset)
+{
+    int ret = 0;
+    const uint8_t* p = (const uint8_t*)data;
+
+    while (size > 0)
+    {
+        ssize_t n = pwrite(fd, p, size, offset);
+
+        if (n < 0 && errno == EINTR)
+            continue;
+
+        if (n <= 0)
+            ERAISE(-EIO);
+
+        p += n;
+        size -= (size_t)n;
+        offset += n;
+    }
+
+done:
+    return ret;
+}
+
+static int _hash_block(const uint8_t* salt, const void* block, uint8_t* hash)
+{
+    int ret = 0;
+    myst_sha256_ctx_t ctx;
+
+    ECHECK(myst_sha256_start(&ctx));
+    ECHECK(myst_sha256_update(&ctx, salt, HASH_SIZE));
+    ECHECK(myst_sha256_update(&ctx, block, BLOCK_SIZE));
+    ECHECK(myst_sha256_finish(&ctx, (myst_sha256_t*)hash));
+
+done:
+    return ret;
+}
+
+/* encrypt whole sectors with aes-xts-plain64 (the context holds the key) */
+static int _encrypt_sectors(
+    EVP_CIPHER_CTX* ctx,
+    const uint8_t* in,
+    uint8_t* out,
+    size_t size,
+    uint64_t sector)
+{
+    int ret = 0;
+
+    for (size_t i = 0; i < size; i += LUKS_SECTOR_SIZE, sector++)
+    {
+        uint8_t iv[16] = {0};
+        int n;
+
+        /* plain64: the little-endian 64-bit sector number */
+        for (size_t j = 0; j < sizeof(uint64_t); j++)
+            iv[j] = (uint8_t)(sector >> (8 * j));
+
+        if (!EVP_EncryptInit_ex(ctx, NULL, NULL, NULL, iv))
+            ERAISE(-EINVAL);
+
+        if (!EVP_EncryptUpdate(ctx, out + i, &n, in + i, LUKS_SECTOR_SIZE) ||
+            n != LUKS_SECTOR_SIZE)
+        {
+            ERAISE(-EINVAL);
+        }
+    }
+
+done:
+    return ret;
+}
+
+static int _stream_chunk(
+    stream_t* s,
+    EVP_CIPHER_CTX* ctx,
+    uint8_t* buf,
+    size_t chunk)
+{
+    int ret = 0;
+    const size_t first = chunk * CHUNK_BLOCKS;
+    const size_t rem = s->num_blocks - first;
+    const size_t count = rem < CHUNK_BLOCKS ? rem : CHUNK_BLOCKS;
+    const size_t offset = first * BLOCK_SIZE;
+    const uint8_t* data;
+
+    if (s->masterkey)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            const size_t pos = offset + i * BLOCK_SIZE;
+            uint8_t* out = buf + i * BLOCK_SIZE;
+
+            if (pos < s->header_size)
+            {
+                memcpy(out, s->header + pos, BLOCK_SIZE);
+            }
+            else
+            {
+                const size_t n = pos - s->header_size;
+                const uint64_t sector = n / LUKS_SECTOR_SIZE;
+                const uint8_t* in = s->payload + n;
+
+                ECHECK(_encrypt_sectors(ctx, in, out, BLOCK_SIZE, sector));
+            }
+        }
+
+        ECHECK(_pwrite_all(s->fd, buf, count * BLOCK_SIZE, (off_t)offset));
+        data = buf;
+    }
+    else
+    {
+        /* hash the ext2 image in place */
+        data = s->payload + offset;
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        uint8_t* leaf = s->leaves + (first + i) * HASH_SIZE;
+        ECHECK(_hash_block(s->salt, data + i * BLOCK_SIZE, leaf));
+    }
+
+done:
+    return ret;
+}
+
+static void* _stream_thread(void* arg)
+{
+    stream_t* s = (stream_t*)arg;
+    EVP_CIPHER_CTX* ctx = NULL;
+    uint8_t* buf = NULL;
+    bool failed = true;
+
+    if (s->masterkey)
+    {
+        if (!(buf = malloc(CHUNK_BLOCKS * BLOCK_SIZE)))
+            goto done;
+
+        if (!(ctx = EVP_CIPHER_CTX_new()))
+            goto done;
+
+        if (!EVP_EncryptInit_ex(
+                ctx, EVP_aes_256_xts(), NULL, s->masterkey, NULL))
+        {
+            goto done;
+        }
+    }
+
+    while (!__atomic_load_n(&s->failed, __ATOMIC_RELAXED))
+    {
+        size_t i = __atomic_fetch_add(&s->next, 1, __ATOMIC_RELAXED);
+
+        if (i >= s->num_chunks)
+            break;
+
+        if (_stream_chunk(s, ctx, buf, i) != 0)
+            goto done;
+    }
+
+    failed = false;
+
+done:
+
+    if (failed)
+        __atomic_store_n(&s->failed, 1, __ATOMIC_RELAXED);
+
+    EVP_CIPHER_CTX_free(ctx);
+    free(buf);
+
+    return NULL;
+}
+
+/* run the streaming pass on all threads (including this one) */
+static int _stream(stream_t* s, size_t num_threads)
+{
+    int ret = 0;
+    pthread_t threads[MAX_THREADS];
+    size_t nthreads = 0;
+
+    s->num_chunks = (s->num_blocks + CHUNK_BLOCKS - 1) / CHUNK_BLOCKS;
+    num_threads = _num_threads(num_threads);
+
+    if (num_threads > s->num_chunks)
+        num_threads = s->num_chunks;
+
+    for (size_t i = 1; i < num_threads; i++)
+    {
+        if (pthread_create(&threads[nthreads], NULL, _stream_thread, s) != 0)
+            break;
+
+        nthreads++;
+    }
+
+    _stream_thread(s);
+
+    for (size_t i = 0; i < nthreads; i++)
+        pthread_join(threads[i], NULL);
+
+    if (s->failed)
+        ERAISE(-EIO);
+
+done:
+    return ret;
+}
+
+/*
+**==============================================================================
+**
+** dm-verity hash tree:
+**
+**==============================================================================
+*/
+
+typedef struct level
+{
+    size_t nnodes;
+    size_t offset;
+} level_t;
+
+typedef struct hash_tree
+{
+    myst_verity_sb_t sb;
+    level_t levels[32];
+    size_t nlevels;
+    size_t total_nodes;
+    uint8_t* data;
+} hash_tree_t;
+
+/* lay out the tree as utils/verityblkdev.c expects: root level first */
+static int _init_hash_tree(hash_tree_t* tree, size_t num_blocks)
+{
+    int ret = 0;
+    size_t offset = 0;
+    size_t n = num_blocks;
+
+    memset(tree, 0, sizeof(hash_tree_t));
+
+    if (num_blocks == 0)
+        ERAISE(-EINVAL);
+
+    do
+    {
+        n = (n + DIGESTS_PER_BLOCK - 1) / DIGESTS_PER_BLOCK;
+        tree->levels[tree->nlevels++].nnodes = n;
+        tree->total_nodes += n;
+    } while (n > 1);
+
+    for (ssize_t i = (ssize_t)tree->nlevels - 1; i >= 0; i--)
+    {
+        tree->levels[i].offset = offset;
+        offset += tree->levels[i].nnodes;
+    }
+
+    if (!(tree->data = calloc(tree->total_nodes, BLOCK_SIZE)))
+        ERAISE(-ENOMEM);
+
+    /* initialize the superblock (with a random salt and UUID) */
+    memcpy(tree->sb.signature, "verity\0\0", 8);
+    tree->sb.version = 1;
+    tree->sb.hash_type = 1;
+    strcpy(tree->sb.algorithm, "sha256");
+    tree->sb.data_block_size = BLOCK_SIZE;
+    tree->sb.hash_block_size = BLOCK_SIZE;
+    tree->sb.data_blocks = num_blocks;
+    tree->sb.salt_size = HASH_SIZE;
+
+    if (RAND_bytes(tree->sb.uuid, sizeof(tree->sb.uuid)) != 1 ||
+        RAND_bytes(tree->sb.salt, HASH_SIZE) != 1)
+    {
+        ERAISE(-EIO);
+    }
+
+done:
+    return ret;
+}
+
+static uint8_t* _hash_tree_leaves(hash_tree_t* tree)
+{
+    return tree->data + tree->levels[0].offset * BLOCK_SIZE;
+}
+
+/* hash the upper levels (the leaves are filled in by the streaming pass) */
+static int _finish_hash_tree(hash_tree_t* tree, myst_sha256_t* root_hash)
+{
+    int ret = 0;
+    const uint8_t* salt = tree->sb.salt;
+
+    for (size_t i = 0; i + 1 < tree->nlevels; i++)
+    {
+        const level_t* level = &tree->levels[i];
+        const uint8_t* node = tree->data + level->offset * BLOCK_SIZE;
+        uint8_t* parent = tree->data + tree->levels[i + 1].offset * BLOCK_SIZE;
+
+        for (size_t j = 0; j < level->nnodes; j++)
+        {
+            const void* block = node + j * BLOCK_SIZE;
+            ECHECK(_hash_block(salt, block, parent + j * HASH_SIZE));
+        }
+    }
+
+    /* the root hash is the hash of the single top-level block */
+    ECHECK(_hash_block(salt, tree->data, root_hash->data));
+
+done:
+    return ret;
+}
+
+static int _write_hash_tree(hash_tree_t* tree, int fd, size_t hash_offset)
+{
+    int ret = 0;
+    struct locals
+    {
+        uint8_t block[BLOCK_SIZE];
+    };
+    struct locals* locals = NULL;
+
+    if (!(locals = calloc(1, sizeof(struct locals))))
+        ERAISE(-ENOMEM);
+
+    /* the superblock takes up a whole hash block */
+    memcpy(locals->block, &tree->sb, sizeof(tree->sb));
+    ECHECK(_pwrite_all(fd, locals->block, BLOCK_SIZE, (off_t)hash_offset));
+
+    ECHECK(_pwrite_all(
+        fd,
+        tree->data,
+        tree->total_nodes * BLOCK_SIZE,
+        (off_t)(hash_offset + BLOCK_SIZE)));
+
+done:
+
+    if (locals)
+        free(locals);
+
+    return ret;
+}
+
+int mkext2_append_hash_tree(
+    const char* image,
+    size_t image_size,
+    size_t num_threads,
+    myst_sha256_t* root_hash)
+{
+    int ret = 0;
+    int fd = -1;
+    void* data = MAP_FAILED;
+    hash_tree_t tree;
+    stream_t s;
+
+    memset(&tree, 0, sizeof(tree));
+    memset(&s, 0, sizeof(s));
+
+    if (!image || image_size == 0 || image_size % BLOCK_SIZE || !root_hash)
+        ERAISE(-EINVAL);
+
+    if ((fd = open(image, O_RDWR)) < 0)
+        ERAISE(-errno);
+
+    data = mmap(NULL, image_size, PROT_READ, MAP_SHARED, fd, 0);
+
+    if (data == MAP_FAILED)
+        ERAISE(-errno);
+
+    ECHECK(_init_hash_tree(&tree, image_size / BLOCK_SIZE));
+
+    s.payload = data;
+    s.fd = -1;
+    s.salt = tree.sb.salt;
+    s.leaves = _hash_tree_leaves(&tree);
+    s.num_blocks = tree.sb.data_blocks;
+    ECHECK(_stream(&s, num_threads));
+
+    ECHECK(_finish_hash_tree(&tree, root_hash));
+    ECHECK(_write_hash_tree(&tree, fd, image_size));
+
+done:
+
+    if (data != MAP_FAILED)
+        munmap(data, image_size);
+
+    if (fd >= 0)
+        close(fd);
+
+    free(tree.data);
+
+    return ret;
+}
+
+/*
+**==============================================================================
+**
+** LUKS1 header:
+**
+**==============================================================================
+*/
+
+static void _phdr_to_big_endian(luks_phdr_t* phdr)
+{
+    if (!myst_is_big_endian())
+    {
+        phdr->version = myst_swap_u16(phdr->version);
+        phdr->payload_offset = myst_swap_u32(phdr->payload_offset);
+        phdr->key_bytes = myst_swap_u32(phdr->key_bytes);
+        phdr->mk_digest_iter = myst_swap_u32(phdr->mk_digest_iter);
+
+        for (size_t i = 0; i < LUKS_SLOTS_SIZE; i++)
+        {
+            luks_keyslot_t* p = &phdr->slots[i];
+            p->active = myst_swap_u32(p->active);
+            p->iterations = myst_swap_u32(p->iterations);
+            p->key_material_offset = myst_swap_u32(p->key_material_offset);
+            p->stripes = myst_swap_u32(p->stripes);
+        }
+    }
+}
+
+/* the anti-forensic diffusion function of LUKS1 (with SHA-256) */
+static int _af_diffuse(uint8_t* buf, size_t size)
+{
+    int ret = 0;
+
+    for (size_t i = 0; i * HASH_SIZE < size; i++)
+    {
+        const size_t n = size - i * HASH_SIZE;
+        const size_t len = n < HASH_SIZE ? n : HASH_SIZE;
+        const uint32_t iv = myst_swap_u32((uint32_t)i);
+        myst_sha256_ctx_t ctx;
+        myst_sha256_t hash;
+
+        ECHECK(myst_sha256_start(&ctx));
+        ECHECK(myst_sha256_update(&ctx, &iv, sizeof(iv)));
+        ECHECK(myst_sha256_update(&ctx, buf + i * HASH_SIZE, len));
+        ECHECK(myst_sha256_finish(&ctx, &hash));
+        memcpy(buf + i * HASH_SIZE, hash.data, len);
+    }
+
+done:
+    return ret;
+}
+
+/* split the key into LUKS_STRIPES stripes (the LUKS1 AF-splitter) */
+static int _af_split(const uint8_t* key, uint8_t* stripes)
+{
+    int ret = 0;
+    const size_t n = MKEXT2_LUKS_KEY_SIZE;
+    uint8_t block[MKEXT2_LUKS_KEY_SIZE] = {0};
+    size_t i;
+
+    if (RAND_bytes(stripes, (LUKS_STRIPES - 1) * n) != 1)
+        ERAISE(-EIO);
+
+    for (i = 0; i < LUKS_STRIPES - 1; i++)
+    {
+        for (size_t j = 0; j < n; j++)
+            block[j] ^= stripes[i * n + j];
+
+        ECHECK(_af_diffuse(block, n));
+    }
+
+    for (size_t j = 0; j < n; j++)
+        stripes[i * n + j] = block[j] ^ key[j];
+
+done:
+    return ret;
+}
+
+/* add the passphrase to the given key slot (writing its key material) */
+static int _add_keyslot(
+    luks_keyslot_t* slot,
+    const uint8_t* masterkey,
+    const char* passphrase,
+    uint8_t* material)
+{
+    int ret = 0;
+    EVP_CIPHER_CTX* ctx = NULL;
+    struct locals
+    {
+        uint8_t key[MKEXT2_LUKS_KEY_SIZE];
+        uint8_t stripes[LUKS_AF_SIZE];
+    };
+    struct locals* locals = NULL;
+
+    if (!(locals = malloc(sizeof(struct locals))))
+        ERAISE(-ENOMEM);
+
+    slot->active = LUKS_KEY_ENABLED;
+    slot->iterations = LUKS_KEYSLOT_ITERATIONS;
+
+    if (RAND_bytes(slot->salt, LUKS_SALT_SIZE) != 1)
+        ERAISE(-EIO);
+
+    /* derive the key that encrypts the key material from the passphrase */
+    if (!PKCS5_PBKDF2_HMAC(
+            passphrase,
+            (int)strlen(passphrase),
+            slot->salt,
+            LUKS_SALT_SIZE,
+            (int)slot->iterations,
+            EVP_sha256(),
+            sizeof(locals->key),
+            locals->key))
+    {
+        ERAISE(-EIO);
+    }
+
+    ECHECK(_af_split(masterkey, locals->stripes));
+
+    if (!(ctx = EVP_CIPHER_CTX_new()))
+        ERAISE(-ENOMEM);
+
+    if (!EVP_EncryptInit_ex(ctx, EVP_aes_256_xts(), NULL, locals->key, NULL))
+        ERAISE(-EINVAL);
+
+    ECHECK(_encrypt_sectors(ctx, locals->stripes, material, LUKS_AF_SIZE, 0));
+
+done:
+
+    EVP_CIPHER_CTX_free(ctx);
+
+    if (locals)
+    {
+        OPENSSL_cleanse(locals, sizeof(struct locals));
+        free(locals);
+    }
+
+    return ret;
+}
+
+/* format the LUKS1 header area (MKEXT2_LUKS_HEADER_SIZE zero-filled bytes) */
+static int _format_luks_header(
+    uint8_t* header,
+    const uint8_t* masterkey,
+    const char* passphrase)
+{
+    int ret = 0;
+    static const uint8_t _magic[] = {'L', 'U', 'K', 'S', 0xba, 0xbe};
+    luks_phdr_t phdr;
+    uint8_t uuid[16];
+
+    memset(&phdr, 0, sizeof(phdr));
+    memcpy(phdr.magic, _magic, sizeof(_magic));
+    phdr.version = LUKS_VERSION;
+    strcpy(phdr.cipher_name, "aes");
+    strcpy(phdr.cipher_mode, "xts-plain64");
+    strcpy(phdr.hash_spec, "sha256");
+    phdr.payload_offset = LUKS_PAYLOAD_OFFSET;
+    phdr.key_bytes = MKEXT2_LUKS_KEY_SIZE;
+    phdr.mk_digest_iter = LUKS_MK_DIGEST_ITERATIONS;
+
+    if (RAND_bytes(phdr.mk_digest_salt, LUKS_SALT_SIZE) != 1)
+        ERAISE(-EIO);
+
+    if (!PKCS5_PBKDF2_HMAC(
+            (const char*)masterkey,
+            MKEXT2_LUKS_KEY_SIZE,
+            phdr.mk_digest_salt,
+            LUKS_SALT_SIZE,
+            (int)phdr.mk_digest_iter,
+            EVP_sha256(),
+            LUKS_DIGEST_SIZE,
+            phdr.mk_digest))
+    {
+        ERAISE(-EIO);
+    }
+
+    /* random (version 4) UUID */
+    {
+        if (RAND_bytes(uuid, sizeof(uuid)) != 1)
+            ERAISE(-EIO);
+
+        uuid[6] = (uuid[6] & 0x0f) | 0x40;
+        uuid[8] = (uuid[8] & 0x3f) | 0x80;
+
+        snprintf(
+            phdr.uuid,
+            sizeof(phdr.uuid),
+            "%02x%02x%02x%02x-%02x%02x-%02x%02x-%02x%02x-"
+            "%02x%02x%02x%02x%02x%02x",
+            uuid[0],
+            uuid[1],
+            uuid[2],
+            uuid[3],
+            uuid[4],
+            uuid[5],
+            uuid[6],
+            uuid[7],
+            uuid[8],
+            uuid[9],
+            uuid[10],
+            uuid[11],
+            uuid[12],
+            uuid[13],
+            uuid[14],
+            uuid[15]);
+    }
+
+    for (size_t i = 0; i < LUKS_SLOTS_SIZE; i++)
+    {
+        luks_keyslot_t* slot = &phdr.slots[i];
+
+        slot->active = LUKS_KEY_DISABLED;
+        slot->key_material_offset =
+            LUKS_FIRST_KEYSLOT_SECTOR + i * LUKS_KEYSLOT_SECTORS;
+        slot->stripes = LUKS_STRIPES;
+    }
+
+    if (passphrase)
+    {
+        luks_keyslot_t* slot = &phdr.slots[0];
+        uint8_t* material =
+            header + slot->key_material_offset * LUKS_SECTOR_SIZE;
+
+        ECHECK(_add_keyslot(slot, masterkey, passphrase, material));
+    }
+
+    _phdr_to_big_endian(&phdr);
+    memcpy(header, &phdr, sizeof(phdr));
+
+done:
+    return ret;
+}
+
+int mkext2_create_luks_image(
+    const char* ext2,
+    const char* image,
+    size_t image_size,
+    const uint8_t masterkey[MKEXT2_LUKS_KEY_SIZE],
+    const char* passphrase,
+    size_t num_threads,
+    myst_sha256_t* root_hash)
+{
+    int ret = 0;
+    int fd = -1;
+    int ext2_fd = -1;
+    void* data = MAP_FAILED;
+    size_t ext2_size = 0;
+    uint8_t* header = NULL;
+    hash_tree_t tree;
+    stream_t s;
+
+    memset(&tree, 0, sizeof(tree));
+    memset(&s, 0, sizeof(s));
+
+    if (!ext2 || !image || !masterkey || !root_hash)
+        ERAISE(-EINVAL);
+
+    if (image_size <= MKEXT2_LUKS_HEADER_SIZE || image_size % BLOCK_SIZE)
+        ERAISE(-EINVAL);
+
+    ext2_size = image_size - MKEXT2_LUKS_HEADER_SIZE;
+
+    /* map the ext2 file system */
+    {
+        struct stat st;
+
+        if ((ext2_fd = open(ext2, O_RDONLY)) < 0)
+            ERAISE(-errno);
+
+        if (fstat(ext2_fd, &st) != 0)
+            ERAISE(-errno);
+
+        if ((size_t)st.st_size != ext2_size)
+            ERAISE(-EINVAL);
+
+        data = mmap(NULL, ext2_size, PROT_READ, MAP_PRIVATE, ext2_fd, 0);
+
+        if (data == MAP_FAILED)
+            ERAISE(-errno);
+    }
+
+    if (!(header = calloc(1, MKEXT2_LUKS_HEADER_SIZE)))
+        ERAISE(-ENOMEM);
+
+    ECHECK(_format_luks_header(header, masterkey, passphrase));
+
+    if ((fd = open(image, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0)
+        ERAISE(-errno);
+
+    ECHECK(_init_hash_tree(&tree, image_size / BLOCK_SIZE));
+
+    /* write and hash the header, and encrypt and hash the payload */
+    s.header = header;
+    s.header_size = MKEXT2_LUKS_HEADER_SIZE;
+    s.payload = data;
+    s.masterkey = masterkey;
+    s.fd = fd;
+    s.salt = tree.sb.salt;
+    s.leaves = _hash_tree_leaves(&tree);
+    s.num_blocks = tree.sb.data_blocks;
+    ECHECK(_stream(&s, num_threads));
+
+    ECHECK(_finish_hash_tree(&tree, root_hash));
+    ECHECK(_write_hash_tree(&tree, fd, image_size));
+
+done:
+
+    if (data != MAP_FAILED)
+        munmap(data, ext2_size);
+
+    if (ext2_fd >= 0)
+        close(ext2_fd);
+
+    if (fd >= 0)
+        close(fd);
+
+    free(header);
+
+    free(tree.data);
+
+    return ret;
+}
@@ -0,0 +1,43 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#ifndef _MYST_MKEXT2_IMAGE_H
+#define _MYST_MKEXT2_IMAGE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <myst/sha256.h>
+
+/* size of the LUKS1 headers and key material in front of the payload */
+#define MKEXT2_LUKS_HEADER_SIZE (2 * 1024 * 1024)
+
+/* size of the aes-xts-plain64 master key (two AES-256 keys) */
+#define MKEXT2_LUKS_KEY_SIZE 64
+
+/* Compute the dm-verity hash tree of the first image_size bytes of the given
+ * ext2 image and write it (superblock first) at offset image_size. If
+ * num_threads is zero, one thread per CPU is used.
+ */
+int mkext2_append_hash_tree(
+    const char* image,
+    size_t image_size,
+    size_t num_threads,
+    myst_sha256_t* root_hash);
+
+/* Create a LUKS1 (aes-xts-plain64) image of image_size bytes whose payload
+ * is the given ext2 image, followed by its dm-verity hash tree. The sectors
+ * are encrypted and hashed in a single pass on all threads. A key slot is
+ * added only if passphrase is not null. The ext2 image must be exactly
+ * image_size - MKEXT2_LUKS_HEADER_SIZE bytes.
+ */
+int mkext2_create_luks_image(
+    const char* ext2,
+    const char* image,
+    size_t image_size,
+    const uint8_t masterkey[MKEXT2_LUKS_KEY_SIZE],
+    const char* passphrase,
+    size_t num_threads,
+    myst_sha256_t* root_hash);
+
+#endif /* _MYST_MKEXT2_IMAGE_H */
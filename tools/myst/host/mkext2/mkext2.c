@@ -18,6 +18,7 @@
 #include <myst/strings.h>
 #include <oeprivate/rsa.h>
 #include "../utils.h"
+#include "image.h"
 
 typedef enum _oe_result
 {
@@ -33,9 +34,9 @@ Usage: %s %s [options] <directory> <disk-image>\n\
 Synopsis:\n\
     This tool converts a directory into an ext2 disk image. The image is\n\
     integrity-protected by appending a hash tree. The image may also be\n\
-    encrypted (--encrypt) and/or digitally signed (--sign). This tool\n\
-    employs standard Linux tools so that the image may be mounted by\n\
-    Linux as well as Mystikos.\n\
+    encrypted (--encrypt) and/or digitally signed (--sign). The image\n\
+    uses the standard LUKS1 and dm-verity formats so that it may be\n\
+    mounted by Linux as well as Mystikos. No root privileges are needed.\n\
 \n\
 Examples:\n\
     $ %s %s <dir> <image>\n\
@@ -221,105 +222,51 @@ static void _create_luks_image(
     const char* image,
     size_t size,
     const char* key_file,
-    const char* passphrase)
+    const char* passphrase,
+    myst_sha256_t* root_hash)
 {
-    char passphrase_buf[128];
-    bool remove_passphrase = false;
-    const size_t keybytes = 64;
-    const size_t keybits = 512;
-    struct stat st;
-    char tmpfile[] = "/tmp/mystXXXXXX";
-    const char* dmname;
-    char dmpath[PATH_MAX];
-    char mntdir[] = "/tmp/mystXXXXXX";
-
-    /* if no --passphrase option, then generate one */
-    if (!passphrase)
-    {
-        _execf(
-            passphrase_buf,
-            sizeof(passphrase_buf),
-            "head -c 32 /dev/urandom | hexdump -v -e '/1 \"%%02x\"'");
-
-        passphrase = passphrase_buf;
-        remove_passphrase = true;
-    }
+    void* key = NULL;
+    size_t key_size;
+    char ext2[PATH_MAX];
+    int fd;
 
-    /* check whether masterkey file exists */
-    if (stat(key_file, &st) != 0)
-        _err("key file not found: %s", key_file);
+    /* load the master key file */
+    if (myst_load_file(key_file, &key, &key_size) != 0)
+        _err("failed to load key file: %s", key_file);
 
     /* check the size of the masterkey file */
-    if (st.st_size != keybytes)
-        _err("master key file must be %zu bytes", keybytes);
+    if (key_size != MKEXT2_LUKS_KEY_SIZE)
+        _err("master key file must be %u bytes", MKEXT2_LUKS_KEY_SIZE);
 
-    /* create a zero-filled image */
-    _systemf("/usr/bin/head -c %zu /dev/zero > %s", size, image);
-
-    /* set the owner of this file to the sudo user if defined */
-    if (myst_chown_sudo_user(image) != 0)
-        _err("failed to chown to sudo user: %s", image);
-
-    /* do luksFormat on image */
-    _systemf(
-        "/bin/echo %s | /sbin/cryptsetup luksFormat "
-        "--type luks1 "
-        "--key-size=%zu "
-        "--cipher=aes-xts-plain64 "
-        "--master-key-file=%s "
-        "%s --key-file=-",
-        passphrase,
-        keybits,
-        key_file,
-        image);
-
-    /* find the dev-mapper name for opening the LUKS device */
+    /* create the unencrypted ext2 file system next to the image */
     {
-        int fd;
+        if (snprintf(ext2, sizeof(ext2), "%s.XXXXXX", image) >= sizeof(ext2))
+            _err("image path too long: %s", image);
 
-        if ((fd = mkstemp(tmpfile)) < 0)
-            _err("failed to create temporary file name");
+        if ((fd = mkstemp(ext2)) < 0)
+            _err("failed to create temporary file: %s", ext2);
 
         close(fd);
-        unlink(tmpfile);
-
-        dmname = myst_basename(tmpfile);
-        snprintf(dmpath, sizeof(dmpath), "/dev/mapper/%s", dmname);
     }
 
-    _systemf(
-        "/bin/echo %s | /sbin/cryptsetup luksOpen --key-file=- %s %s",
-        passphrase,
-        image,
-        dmname);
+    _create_ext2_image(dirname, ext2, size - MKEXT2_LUKS_HEADER_SIZE);
 
-    /* format the ext2 file system */
-    _systemf("/sbin/mke2fs -q %s", dmpath);
-
-    /* create the mount directory */
-    if (!mkdtemp(mntdir))
-        _err("failed to create temporary directory");
-
-    /* mount the directory */
-    _systemf("/bin/mount %s %s", dmpath, mntdir);
-
-    /* copy the directory into the mounted ext2 file system */
-    _systemf("/bin/tar c -C %s -f - .|/bin/tar x -C %s -f -", dirname, mntdir);
-
-    /* unmount the ext2 image */
-    _systemf("/bin/umount %s", mntdir);
-
-    /* remove the passphrase (if generated) */
-    if (remove_passphrase)
+    /* write the LUKS headers, the encrypted ext2 image, and the hash tree */
+    if (mkext2_create_luks_image(
+            ext2, image, size, key, passphrase, 0, root_hash) != 0)
     {
-        _systemf(
-            "echo %s | /sbin/cryptsetup luksRemoveKey %s --key-file=-",
-            passphrase,
-            image);
+        unlink(ext2);
+        _err("failed to create encrypted image: %s", image);
     }
 
-    /* close the luks device */
-    _systemf("/sbin/cryptsetup luksClose %s", dmname);
+    unlink(ext2);
+
+    /* set the owner of this file to the sudo user if defined */
+    if (myst_chown_sudo_user(image) != 0)
+        _err("failed to chown to sudo user: %s", image);
+
+    memset(key, 0, key_size);
+    free(key);
 }
 
 static void _append_hash_tree(
@@ -328,8 +275,6 @@ static void _append_hash_tree(
     myst_sha256_t* root_hash)
 {
     struct stat st;
-    char buf[256];
-    ssize_t n;
 
     if (stat(image, &st) != 0)
         _err("unexpected: image does not exist: %s", image);
@@ -337,17 +282,8 @@ static void _append_hash_tree(
     if (st.st_size != size)
         _err("unexpected: image size mismatch: %zu/%zu\n", st.st_size, size);
 
-    _execf(
-        buf,
-        sizeof(buf),
-        "veritysetup format --hash-offset=%zu %s %s | "
-        "grep '^Root hash:' | sed 's/Root hash:[\\t ]*//g'",
-        size,
-        image,
-        image);
-
-    if ((n = myst_ascii_to_bin(buf, root_hash->data, sizeof(*root_hash))) < 0)
-        _err("malformed root hash: %s", buf);
+    if (mkext2_append_hash_tree(image, size, 0, root_hash) != 0)
+        _err("failed to append hash tree: %s", image);
 }
 
 static int _sign(
@@ -519,9 +455,6 @@ int mkext2_action(int argc, const char* argv[])
         luks = true;
     }
 
-    if (luks && geteuid() != 0)
-        _err("mkext2 --encrypt option requires root privileges");
-
     /* get the --force option */
     if (_getopt(&argc, argv, "--force", NULL) == 0 ||
         _getopt(&argc, argv, "-f", NULL) == 0)
@@ -596,16 +529,21 @@ int mkext2_action(int argc, const char* argv[])
             size = n;
     }
 
+    /* the hash tree covers whole 4096-byte blocks */
+    size = (size + 4095) / 4096 * 4096;
+
     if (luks)
     {
-        _create_luks_image(dirname, image, size, key_file, passphrase);
+        /* encrypts and hashes the image in a single pass */
+        _create_luks_image(
+            dirname, image, size, key_file, passphrase, &root_hash);
     }
     else
     {
         _create_ext2_image(dirname, image, size);
+        _append_hash_tree(image, size, &root_hash);
     }
 
-    _append_hash_tree(image, size, &root_hash);
     _sign(image, pubkey, privkey, size, &root_hash);
 
     return 0;
@@ -14,6 +14,7 @@
 #include <unistd.h>
 
 #include <myst/args.h>
+#include <myst/cpioindex.h>
 #include <myst/elf.h>
 #include <myst/getopt.h>
 #include <myst/strings.h>
@@ -218,6 +219,16 @@ int _package(int argc, const char* argv[])
                 app_dir);
             goto done;
         }
+
+        /* let the kernel mount the archive without unpacking it (without
+         * an index, the kernel unpacks the archive at boot) */
+        if (myst_cpio_index_append(rootfs_file) != 0)
+        {
+            fprintf(
+                stderr,
+                "Warning: failed to index root filesystem \"%s\"\n",
+                rootfs_file);
+        }
     }
     else
     {
@@ -690,6 +701,26 @@ int _exec_package(
         }
     }
 
+    /* Get --exitless-calls and --exitless-workers (host-side transport) */
+    if (get_exitless_opts(
+            &argc,
+            argv,
+            &options.exitless_classes,
+            &options.exitless_workers) != 0)
+    {
+        fprintf(
+            stderr,
+            "%s: invalid --exitless-calls or --exitless-workers option\n",
+            argv[0]);
+        goto done;
+    }
+
+    if (get_hostfs_cache_opts(&argc, argv, &options.hostfs_cache_ttl) != 0)
+    {
+        fprintf(stderr, "%s: invalid --hostfs-cache-ttl option\n", argv[0]);
+        goto done;
+    }
+
     /* Get --rootfs=<path> option if any  */
     {
         const char* arg = NULL;
@@ -8,6 +8,15 @@
 
 static pthread_t _clock_thread;
 
+static unsigned long _rdtsc(void)
+{
+    unsigned int lo;
+    unsigned int hi;
+
+    __asm__ __volatile__("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((unsigned long)hi << 32) | lo;
+}
+
 static void* _host_clock_task(void* args)
 {
     struct timespec tp, sleep_tp;
@@ -21,9 +30,18 @@ static void* _host_clock_task(void* args)
     // Use __ATOMIC_ACQUIRE to prevent reordering by compilers.
     while (__atomic_load_n(&ctrl->done, __ATOMIC_ACQUIRE) == 0)
     {
+        unsigned long seq = ctrl->seq;
+
         nanosleep(&sleep_tp, NULL);
+
+        // Publish now and the TSC as a pair for the enclave, which
+        // interpolates between ticks with its own TSC reads.
+        __atomic_store_n(&ctrl->seq, seq + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
         clock_gettime(CLOCK_MONOTONIC, &tp);
         ctrl->now = tp.tv_sec * NANO_IN_SECOND + tp.tv_nsec;
+        ctrl->tsc = _rdtsc();
+        __atomic_store_n(&ctrl->seq, seq + 2, __ATOMIC_RELEASE);
     }
     return NULL;
 }
@@ -50,6 +68,7 @@ int shm_create_clock(struct myst_shm* shm, unsigned long clock_tick)
     clock_gettime(CLOCK_MONOTONIC, &tp);
     shm->clock->monotime0 = tp.tv_sec * NANO_IN_SECOND + tp.tv_nsec;
     shm->clock->now = shm->clock->monotime0;
+    shm->clock->tsc = _rdtsc();
 
     if (pthread_create(&_clock_thread, 0, _host_clock_task, (void*)shm->clock))
     {
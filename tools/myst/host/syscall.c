@@ -8,9 +8,11 @@
 #include <myst/tcall.h>
 #include <sched.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <sys/epoll.h>
 #include <sys/eventfd.h>
 #include <sys/ioctl.h>
+#include <sys/sendfile.h>
 #include <sys/stat.h>
 #include <sys/statfs.h>
 #include <sys/syscall.h>
@@ -108,6 +110,43 @@ long myst_write_block_ocall(int fd, const void* buf, size_t count)
         SYS_write, fd, POLLOUT, true, fd, buf, count);
 }
 
+/* Perform a read/write-family call on a staging buffer in host memory. The
+ * arg parameter is the file offset for pread64/pwrite64 and the flags for
+ * recvfrom/sendto. The enclave validates the result against count.
+ */
+long myst_staged_io_ocall(long n, int fd, void* buf, size_t count, long arg)
+{
+    switch (n)
+    {
+        case SYS_read:
+            return myst_read_ocall(fd, buf, count);
+        case MYST_TCALL_READ_BLOCK:
+            return myst_read_block_ocall(fd, buf, count);
+        case SYS_write:
+            return myst_write_ocall(fd, buf, count);
+        case MYST_TCALL_WRITE_BLOCK:
+            return myst_write_block_ocall(fd, buf, count);
+        case SYS_pread64:
+            return myst_pread64_ocall(fd, buf, count, (off_t)arg);
+        case SYS_pwrite64:
+            return myst_pwrite64_ocall(fd, buf, count, (off_t)arg);
+        case SYS_recvfrom:
+            return myst_recvfrom_ocall(fd, buf, count, (int)arg, NULL, NULL, 0);
+        case MYST_TCALL_RECVFROM_BLOCK:
+            return myst_recvfrom_block_ocall(
+                fd, buf, count, (int)arg, NULL, NULL, 0);
+        case SYS_sendto:
+            return myst_sendto_ocall(fd, buf, count, (int)arg, NULL, 0);
+        case MYST_TCALL_SENDTO_BLOCK:
+            return myst_sendto_block_ocall(fd, buf, count, (int)arg, NULL, 0);
+        case SYS_getdents64:
+            return myst_getdents64_ocall(
+                (unsigned int)fd, buf, (unsigned int)count);
+        default:
+            return -ENOSYS;
+    }
+}
+
 long myst_close_ocall(int fd)
 {
     RETURN(close(fd));
@@ -480,6 +519,328 @@ done:
     return ret;
 }
 
+/* build host message headers over the flat buffers of an mmsg ocall */
+static long _init_mmsghdrs(
+    struct myst_mmsg* msgs,
+    unsigned int vlen,
+    const void* data,
+    size_t data_size,
+    const void* names,
+    size_t names_size,
+    const void* controls,
+    size_t controls_size,
+    struct mmsghdr** msgvec_out,
+    struct iovec** iov_out)
+{
+    long ret = 0;
+    struct mmsghdr* msgvec = NULL;
+    struct iovec* iov = NULL;
+    size_t data_off = 0;
+    size_t names_off = 0;
+    size_t controls_off = 0;
+
+    if (!(msgvec = calloc(vlen, sizeof(struct mmsghdr))))
+        ERAISE(-ENOMEM);
+
+    if (!(iov = calloc(vlen, sizeof(struct iovec))))
+        ERAISE(-ENOMEM);
+
+    for (unsigned int i = 0; i < vlen; i++)
+    {
+        struct msghdr* msg = &msgvec[i].msg_hdr;
+
+        if (msgs[i].len > data_size - data_off ||
+            msgs[i].namelen > names_size - names_off ||
+            msgs[i].controllen > controls_size - controls_off)
+        {
+            ERAISE(-EINVAL);
+        }
+
+        iov[i].iov_base = (uint8_t*)data + data_off;
+        iov[i].iov_len = msgs[i].len;
+        msg->msg_iov = &iov[i];
+        msg->msg_iovlen = 1;
+
+        if (msgs[i].namelen)
+        {
+            msg->msg_name = (uint8_t*)names + names_off;
+            msg->msg_namelen = msgs[i].namelen;
+        }
+
+        if (msgs[i].controllen)
+        {
+            msg->msg_control = (uint8_t*)controls + controls_off;
+            msg->msg_controllen = msgs[i].controllen;
+        }
+
+        data_off += msgs[i].len;
+        names_off += msgs[i].namelen;
+        controls_off += msgs[i].controllen;
+    }
+
+    *msgvec_out = msgvec;
+    msgvec = NULL;
+    *iov_out = iov;
+    iov = NULL;
+
+done:
+
+    if (msgvec)
+        free(msgvec);
+
+    if (iov)
+        free(iov);
+
+    return ret;
+}
+
+static long _sendmmsg(
+    int sockfd,
+    struct myst_mmsg* msgs,
+    unsigned int vlen,
+    const void* data,
+    size_t data_size,
+    const void* names,
+    size_t names_size,
+    const void* controls,
+    size_t controls_size,
+    int flags,
+    bool block)
+{
+    long ret = 0;
+    struct mmsghdr* msgvec = NULL;
+    struct iovec* iov = NULL;
+    long retval;
+
+    ECHECK(_init_mmsghdrs(
+        msgs,
+        vlen,
+        data,
+        data_size,
+        names,
+        names_size,
+        controls,
+        controls_size,
+        &msgvec,
+        &iov));
+
+    if (block)
+    {
+        /* Don't retry EAGAIN|EINPPROGRESS if this flag is present */
+        bool retry = !(flags & MSG_DONTWAIT);
+
+        ECHECK(
+            retval = myst_interruptible_syscall(
+                SYS_sendmmsg,
+                sockfd,
+                POLLOUT,
+                retry,
+                sockfd,
+                msgvec,
+                vlen,
+                flags));
+    }
+    else if ((retval = syscall(SYS_sendmmsg, sockfd, msgvec, vlen, flags)) < 0)
+    {
+        ERAISE(-errno);
+    }
+
+    for (long i = 0; i < retval; i++)
+        msgs[i].msg_len = msgvec[i].msg_len;
+
+    ret = retval;
+
+done:
+
+    if (msgvec)
+        free(msgvec);
+
+    if (iov)
+        free(iov);
+
+    return ret;
+}
+
+static long _recvmmsg(
+    int sockfd,
+    struct myst_mmsg* msgs,
+    unsigned int vlen,
+    void* data,
+    size_t data_size,
+    void* names,
+    size_t names_size,
+    void* controls,
+    size_t controls_size,
+    int flags,
+    bool block)
+{
+    long ret = 0;
+    struct mmsghdr* msgvec = NULL;
+    struct iovec* iov = NULL;
+    long retval;
+
+    ECHECK(_init_mmsghdrs(
+        msgs,
+        vlen,
+        data,
+        data_size,
+        names,
+        names_size,
+        controls,
+        controls_size,
+        &msgvec,
+        &iov));
+
+    /* the enclave kernel implements the timeout of recvmmsg() */
+    if (block)
+    {
+        /* Don't retry EAGAIN|EINPPROGRESS if these flags are present */
+        bool retry = !(flags & (MSG_ERRQUEUE | MSG_DONTWAIT));
+
+        ECHECK(
+            retval = myst_interruptible_syscall(
+                SYS_recvmmsg,
+                sockfd,
+                POLLIN,
+                retry,
+                sockfd,
+                msgvec,
+                vlen,
+                flags));
+    }
+    else if (
+        (retval = syscall(SYS_recvmmsg, sockfd, msgvec, vlen, flags, NULL)) < 0)
+    {
+        ERAISE(-errno);
+    }
+
+    for (long i = 0; i < retval; i++)
+    {
+        const struct msghdr* msg = &msgvec[i].msg_hdr;
+
+        msgs[i].msg_len = msgvec[i].msg_len;
+        msgs[i].namelen = msg->msg_name ? msg->msg_namelen : 0;
+        msgs[i].controllen = msg->msg_control ? msg->msg_controllen : 0;
+        msgs[i].msg_flags = msg->msg_flags;
+    }
+
+    ret = retval;
+
+done:
+
+    if (msgvec)
+        free(msgvec);
+
+    if (iov)
+        free(iov);
+
+    return ret;
+}
+
+long myst_sendmmsg_ocall(
+    int sockfd,
+    struct myst_mmsg* msgs,
+    unsigned int vlen,
+    const void* data,
+    size_t data_size,
+    const void* names,
+    size_t names_size,
+    const void* controls,
+    size_t controls_size,
+    int flags)
+{
+    return _sendmmsg(
+        sockfd,
+        msgs,
+        vlen,
+        data,
+        data_size,
+        names,
+        names_size,
+        controls,
+        controls_size,
+        flags,
+        false);
+}
+
+long myst_sendmmsg_block_ocall(
+    int sockfd,
+    struct myst_mmsg* msgs,
+    unsigned int vlen,
+    const void* data,
+    size_t data_size,
+    const void* names,
+    size_t names_size,
+    const void* controls,
+    size_t controls_size,
+    int flags)
+{
+    return _sendmmsg(
+        sockfd,
+        msgs,
+        vlen,
+        data,
+        data_size,
+        names,
+        names_size,
+        controls,
+        controls_size,
+        flags,
+        true);
+}
+
+long myst_recvmmsg_ocall(
+    int sockfd,
+    struct myst_mmsg* msgs,
+    unsigned int vlen,
+    void* data,
+    size_t data_size,
+    void* names,
+    size_t names_size,
+    void* controls,
+    size_t controls_size,
+    int flags)
+{
+    return _recvmmsg(
+        sockfd,
+        msgs,
+        vlen,
+        data,
+        data_size,
+        names,
+        names_size,
+        controls,
+        controls_size,
+        flags,
+        false);
+}
+
+long myst_recvmmsg_block_ocall(
+    int sockfd,
+    struct myst_mmsg* msgs,
+    unsigned int vlen,
+    void* data,
+    size_t data_size,
+    void* names,
+    size_t names_size,
+    void* controls,
+    size_t controls_size,
+    int flags)
+{
+    return _recvmmsg(
+        sockfd,
+        msgs,
+        vlen,
+        data,
+        data_size,
+        names,
+        names_size,
+        controls,
+        controls_size,
+        flags,
+        true);
+}
+
 long myst_shutdown_ocall(int sockfd, int how)
 {
     RETURN(shutdown(sockfd, how));
@@ -697,6 +1058,23 @@ long myst_lseek_ocall(int fd, off_t offset, int whence)
     RETURN(lseek(fd, offset, whence));
 }
 
+long myst_sendfile_ocall(int out_fd, int in_fd, off_t* offset, size_t count)
+{
+    RETURN(sendfile(out_fd, in_fd, offset, count));
+}
+
+long myst_copy_file_range_ocall(
+    int fd_in,
+    off_t* off_in,
+    int fd_out,
+    off_t* off_out,
+    size_t len,
+    unsigned int flags)
+{
+    RETURN(syscall(
+        SYS_copy_file_range, fd_in, off_in, fd_out, off_out, len, flags));
+}
+
 long myst_utimensat_ocall(
     int dirfd,
     const char* pathname,
@@ -16,6 +16,7 @@
 #include <unistd.h>
 
 #include <myst/args.h>
+#include <myst/exitless.h>
 #include <myst/getopt.h>
 #include <myst/strings.h>
 
@@ -357,4 +358,70 @@ int get_fork_mode_opts(
     }
 
     return 0;
-}
\ No newline at end of file
+}
+
+int get_exitless_opts(
+    int* argc,
+    const char* argv[],
+    uint32_t* classes,
+    size_t* num_workers)
+{
+    const char* arg = NULL;
+
+    if (!classes || !num_workers)
+        return -1;
+
+    *classes = 0;
+    *num_workers = 0;
+
+    if (cli_getopt(argc, argv, "--exitless-calls", &arg) == 0)
+    {
+        if (arg == NULL || myst_exitless_parse_classes(arg, classes) != 0)
+            return -1;
+    }
+
+    if (cli_getopt(argc, argv, "--exitless-workers", &arg) == 0)
+    {
+        char* end = NULL;
+        size_t val;
+
+        if (arg == NULL)
+            return -1;
+
+        val = strtoull(arg, &end, 10);
+
+        if (!end || *end != '\0' || val == 0 ||
+            val > MYST_EXITLESS_MAX_WORKERS)
+            return -1;
+
+        *num_workers = val;
+    }
+
+    return 0;
+}
+
+int get_hostfs_cache_opts(int* argc, const char* argv[], size_t* ttl)
+{
+    const char* arg = NULL;
+
+    if (!ttl)
+        return -1;
+
+    if (cli_getopt(argc, argv, "--hostfs-cache-ttl", &arg) == 0)
+    {
+        char* end = NULL;
+        size_t val;
+
+        if (arg == NULL)
+            return -1;
+
+        val = strtoull(arg, &end, 10);
+
+        if (!end || *end != '\0')
+            return -1;
+
+        *ttl = val;
+    }
+
+    return 0;
+}
@@ -55,6 +55,16 @@ int get_fork_mode_opts(
     const char* argv[],
     myst_fork_mode_t* fork_mode);
 
+// get --exitless-calls=<classes> and --exitless-workers=<n> options
+int get_exitless_opts(
+    int* argc,
+    const char* argv[],
+    uint32_t* classes,
+    size_t* num_workers);
+
+// get --hostfs-cache-ttl=<msec> option
+int get_hostfs_cache_opts(int* argc, const char* argv[], size_t* ttl);
+
 long myst_add_symbol_file_by_path(
     const char* path,
     const void* text_data,
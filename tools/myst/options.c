@@ -66,6 +66,9 @@ long determine_final_options(
         final_opts->base.max_affinity_cpus = parsed_config->max_affinity_cpus;
         final_opts->base.main_stack_size = parsed_config->main_stack_size;
         final_opts->base.thread_stack_size = parsed_config->thread_stack_size;
+        final_opts->base.host_staging_buffer_size =
+            parsed_config->host_staging_buffer_size;
+        final_opts->base.hostfs_cache_ttl = parsed_config->hostfs_cache_ttl;
         final_opts->base.fork_mode = parsed_config->fork_mode;
         final_opts->base.nobrk = parsed_config->no_brk;
         final_opts->base.exec_stack = parsed_config->exec_stack;
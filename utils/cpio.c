@@ -485,50 +485,113 @@ done:
     return ret;
 }
 
-int myst_cpio_write_entry(myst_cpio_t* cpio, const myst_cpio_entry_t* entry)
+int myst_cpio_get_fd(myst_cpio_t* cpio)
 {
-    int ret = -1;
-    cpio_header_t h;
-    size_t namesize;
+    if (!cpio)
+        return -1;
 
-    if (!cpio || cpio->fd < 0 || !entry)
-        GOTO(done);
+    return cpio->fd;
+}
 
+/* Check that the entry can be archived and get the size of its name. Returns
+ * 1 if the entry should be written, 0 if it is skipped, and -1 on error.
+ */
+static int _check_entry(const myst_cpio_entry_t* entry, size_t* namesize)
+{
     /* ATTN: Skip character files and fifos */
     if (S_ISCHR(entry->mode) || S_ISFIFO(entry->mode))
-    {
-        ret = 0;
-        goto done;
-    }
+        return 0;
 
     /* Check file type. */
     if (!S_ISREG(entry->mode) && !S_ISDIR(entry->mode) && !S_ISLNK(entry->mode))
     {
         PRINTF("entry=%s mode=%o\n", entry->name, entry->mode);
-        GOTO(done);
+        return -1;
     }
 
     /* Calculate the size of the name */
-    if ((namesize = strlen(entry->name) + 1) > MYST_CPIO_PATH_MAX)
+    if ((*namesize = strlen(entry->name) + 1) > MYST_CPIO_PATH_MAX)
+        return -1;
+
+    return 1;
+}
+
+static void _format_header(
+    cpio_header_t* h,
+    const myst_cpio_entry_t* entry,
+    size_t namesize)
+{
+    memset(h, 0, sizeof(cpio_header_t));
+    memcpy(h->magic, "070701", sizeof(h->magic));
+    _uint_to_hex(h->ino, 0);
+    _uint_to_hex(h->mode, entry->mode);
+    _uint_to_hex(h->uid, 0);
+    _uint_to_hex(h->gid, 0);
+    _uint_to_hex(h->nlink, 1);
+    _uint_to_hex(h->mtime, 0x56734BA4); /* hardcode a time */
+    _uint_to_hex(h->filesize, (unsigned int)entry->size);
+    _uint_to_hex(h->devmajor, 8);
+    _uint_to_hex(h->devminor, 2);
+    _uint_to_hex(h->rdevmajor, 0);
+    _uint_to_hex(h->rdevminor, 0);
+    _uint_to_hex(h->namesize, (unsigned int)namesize);
+    _uint_to_hex(h->check, 0);
+}
+
+ssize_t myst_cpio_format_entry(
+    const myst_cpio_entry_t* entry,
+    void* buf,
+    size_t size)
+{
+    uint8_t* p = (uint8_t*)buf;
+    size_t namesize;
+    size_t n;
+    int r;
+
+    if (!entry || !buf)
+        return -1;
+
+    if ((r = _check_entry(entry, &namesize)) <= 0)
+        return r;
+
+    /* header + name + padding to a four-byte boundary */
+    if (myst_round_up(sizeof(cpio_header_t) + namesize, 4, &n) != 0)
+        return -1;
+
+    if (n > size)
+        return -1;
+
+    _format_header((cpio_header_t*)p, entry, namesize);
+    p += sizeof(cpio_header_t);
+    memcpy(p, entry->name, namesize);
+    p += namesize;
+    memset(p, 0, n - sizeof(cpio_header_t) - namesize);
+
+    return (ssize_t)n;
+}
+
+int myst_cpio_write_entry(myst_cpio_t* cpio, const myst_cpio_entry_t* entry)
+{
+    int ret = -1;
+    cpio_header_t h;
+    size_t namesize;
+    int r;
+
+    if (!cpio || cpio->fd < 0 || !entry)
         GOTO(done);
 
+    if ((r = _check_entry(entry, &namesize)) < 0)
+        GOTO(done);
+
+    if (r == 0)
+    {
+        ret = 0;
+        goto done;
+    }
+
     /* Write the CPIO header */
     {
-        memset(&h, 0, sizeof(h));
-        memcpy(h.magic, "070701", sizeof(h.magic));
-        _uint_to_hex(h.ino, 0);
-        _uint_to_hex(h.mode, entry->mode);
-        _uint_to_hex(h.uid, 0);
-        _uint_to_hex(h.gid, 0);
-        _uint_to_hex(h.nlink, 1);
-        _uint_to_hex(h.mtime, 0x56734BA4); /* hardcode a time */
-        _uint_to_hex(h.filesize, (unsigned int)entry->size);
-        _uint_to_hex(h.devmajor, 8);
-        _uint_to_hex(h.devminor, 2);
-        _uint_to_hex(h.rdevmajor, 0);
-        _uint_to_hex(h.rdevminor, 0);
-        _uint_to_hex(h.namesize, (unsigned int)namesize);
-        _uint_to_hex(h.check, 0);
+        _format_header(&h, entry, namesize);
 
         if (write(cpio->fd, &h, sizeof(h)) != sizeof(h))
             GOTO(done);
@@ -659,7 +722,7 @@ int myst_cpio_unpack(const char* source, const char* target)
             locals->target[n] = '\0';
 
             /* create the symlink */
-            if (symlink(target, locals->path) != 0)
+            if (symlink(locals->target, locals->path) != 0)
                 GOTO(done);
         }
         else
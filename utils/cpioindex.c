@@ -0,0 +1,600 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <myst/cpio.h>
+#include <myst/cpioindex.h>
+#include <myst/eraise.h>
+#include <myst/file.h>
+#include <myst/round.h>
+
+#define ALIGNMENT 8
+
+/*
+**==============================================================================
+**
+** building:
+**
+**==============================================================================
+*/
+
+typedef struct entry
+{
+    char* path; /* normalized path (no leading "./" or "/") */
+    const char* name;
+    uint32_t mode;
+    uint64_t offset;
+    uint64_t size;
+} entry_t;
+
+/* a (parent, name) pair used to group the children of every directory */
+typedef struct child
+{
+    size_t parent; /* index of the parent entry plus one (0 is the root) */
+    const char* name;
+    size_t entry;
+} child_t;
+
+static int _compare_entries(const void* a, const void* b)
+{
+    return strcmp(((const entry_t*)a)->path, ((const entry_t*)b)->path);
+}
+
+static int _compare_children(const void* a, const void* b)
+{
+    const child_t* x = (const child_t*)a;
+    const child_t* y = (const child_t*)b;
+
+    if (x->parent != y->parent)
+        return (x->parent < y->parent) ? -1 : 1;
+
+    return strcmp(x->name, y->name);
+}
+
+static void _free_entries(entry_t* entries, size_t num_entries)
+{
+    if (entries)
+    {
+        for (size_t i = 0; i < num_entries; i++)
+            free(entries[i].path);
+
+        free(entries);
+    }
+}
+
+/* strip leading "./" and "/" and trailing "/" (returns null for the root) */
+static char* _normalize(const char* name)
+{
+    char* path;
+    size_t len;
+
+    for (;;)
+    {
+        if (name[0] == '.' && name[1] == '/')
+            name += 2;
+        else if (name[0] == '/')
+            name++;
+        else
+            break;
+    }
+
+    if (*name == '\0' || strcmp(name, ".") == 0)
+        return NULL;
+
+    if (!(path = strdup(name)))
+        return NULL;
+
+    len = strlen(path);
+
+    while (len > 1 && path[len - 1] == '/')
+        path[--len] = '\0';
+
+    return path;
+}
+
+/* read the entries of the archive and sort them by path */
+static int _read_entries(
+    const void* cpio_data,
+    size_t cpio_size,
+    entry_t** entries_out,
+    size_t* num_entries_out)
+{
+    int ret = 0;
+    entry_t* entries = NULL;
+    size_t num_entries = 0;
+    size_t capacity = 0;
+    size_t pos = 0;
+    myst_cpio_entry_t* ent = NULL;
+
+    if (!(ent = malloc(sizeof(myst_cpio_entry_t))))
+        ERAISE(-ENOMEM);
+
+    for (;;)
+    {
+        const void* file_data;
+        entry_t* e;
+        int r;
+
+        if ((r = myst_cpio_next_entry(
+                 cpio_data, cpio_size, &pos, ent, &file_data)) == 0)
+        {
+            break;
+        }
+
+        if (r < 0)
+            ERAISE(-EINVAL);
+
+        if (!S_ISDIR(ent->mode) && !S_ISREG(ent->mode) && !S_ISLNK(ent->mode))
+            ERAISE(-EINVAL);
+
+        if (num_entries == capacity)
+        {
+            size_t n = capacity ? capacity * 2 : 256;
+
+            if (!(e = realloc(entries, n * sizeof(entry_t))))
+                ERAISE(-ENOMEM);
+
+            entries = e;
+            capacity = n;
+        }
+
+        e = &entries[num_entries];
+
+        if (!(e->path = _normalize(ent->name)))
+        {
+            /* skip the root directory itself */
+            if (S_ISDIR(ent->mode))
+                continue;
+
+            ERAISE(-EINVAL);
+        }
+
+        num_entries++;
+
+        if ((e->name = strrchr(e->path, '/')))
+            e->name++;
+        else
+            e->name = e->path;
+
+        if (strcmp(e->name, ".") == 0 || strcmp(e->name, "..") == 0)
+            ERAISE(-EINVAL);
+
+        e->mode = ent->mode;
+        e->offset = (uint64_t)((const uint8_t*)file_data - (uint8_t*)cpio_data);
+        e->size = ent->size;
+    }
+
+    if (num_entries)
+        qsort(entries, num_entries, sizeof(entry_t), _compare_entries);
+
+    /* the kernel cannot represent duplicate paths */
+    for (size_t i = 1; i < num_entries; i++)
+    {
+        if (strcmp(entries[i - 1].path, entries[i].path) == 0)
+            ERAISE(-EINVAL);
+    }
+
+    *entries_out = entries;
+    *num_entries_out = num_entries;
+    entries = NULL;
+    num_entries = 0;
+
+done:
+
+    _free_entries(entries, num_entries);
+
+    if (ent)
+        free(ent);
+
+    return ret;
+}
+
+/* find the parent of the given entry (0 for the root, else index plus one) */
+static int _find_parent(
+    const entry_t* entries,
+    size_t num_entries,
+    const entry_t* entry,
+    size_t* parent)
+{
+    int ret = 0;
+    size_t len = (size_t)(entry->name - entry->path);
+    size_t lo = 0;
+    size_t hi = num_entries;
+
+    *parent = 0;
+
+    if (len == 0)
+        goto done;
+
+    /* exclude the separator */
+    len--;
+
+    while (lo < hi)
+    {
+        const size_t mid = lo + (hi - lo) / 2;
+        const char* path = entries[mid].path;
+        int r = strncmp(path, entry->path, len);
+
+        if (r == 0 && path[len] != '\0')
+            r = 1;
+
+        if (r == 0)
+        {
+            if (!S_ISDIR(entries[mid].mode))
+                ERAISE(-ENOTDIR);
+
+            *parent = mid + 1;
+            goto done;
+        }
+
+        if (r < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    /* the archive has no entry for the parent directory */
+    ERAISE(-ENOENT);
+
+done:
+    return ret;
+}
+
+static int _append_padding(myst_buf_t* buf)
+{
+    static const uint8_t zeros[ALIGNMENT];
+    const size_t r = buf->size % ALIGNMENT;
+
+    if (r && myst_buf_append(buf, zeros, ALIGNMENT - r) != 0)
+        return -ENOMEM;
+
+    return 0;
+}
+
+int myst_cpio_index_build(
+    const void* cpio_data,
+    size_t cpio_size,
+    myst_buf_t* index_out)
+{
+    int ret = 0;
+    entry_t* entries = NULL;
+    size_t num_entries = 0;
+    child_t* children = NULL;
+    size_t* queue = NULL;
+    size_t* first = NULL;
+    myst_cpio_index_inode_t* inodes = NULL;
+    myst_buf_t strings = MYST_BUF_INITIALIZER;
+    myst_buf_t buf = MYST_BUF_INITIALIZER;
+    size_t num_inodes;
+    uint64_t offset;
+
+    if (!cpio_data || !cpio_size || !index_out)
+        ERAISE(-EINVAL);
+
+    ECHECK(_read_entries(cpio_data, cpio_size, &entries, &num_entries));
+
+    if ((num_inodes = num_entries + 1) > UINT32_MAX)
+        ERAISE(-EFBIG);
+
+    /* group the entries by parent, sorted by name within each group */
+    if (!(children = calloc(num_inodes, sizeof(child_t))))
+        ERAISE(-ENOMEM);
+
+    for (size_t i = 0; i < num_entries; i++)
+    {
+        ECHECK(_find_parent(
+            entries, num_entries, &entries[i], &children[i].parent));
+        children[i].name = entries[i].name;
+        children[i].entry = i + 1;
+    }
+
+    if (num_entries)
+        qsort(children, num_entries, sizeof(child_t), _compare_children);
+
+    /* first[p] is the first child of entry p (first[p + 1] ends the range) */
+    if (!(first = calloc(num_inodes + 1, sizeof(size_t))))
+        ERAISE(-ENOMEM);
+
+    for (size_t i = 0; i < num_entries; i++)
+        first[children[i].parent + 1]++;
+
+    for (size_t i = 0; i < num_inodes; i++)
+        first[i + 1] += first[i];
+
+    /* number the inodes breadth first so that siblings are consecutive */
+    if (!(queue = calloc(num_inodes, sizeof(size_t))))
+        ERAISE(-ENOMEM);
+
+    if (!(inodes = calloc(num_inodes, sizeof(myst_cpio_index_inode_t))))
+        ERAISE(-ENOMEM);
+
+    /* the root directory has an empty name */
+    if (myst_buf_append(&strings, "", 1) != 0)
+        ERAISE(-ENOMEM);
+
+    inodes[0].mode = S_IFDIR | 0755;
+
+    for (size_t ino = 0, next = 1; ino < num_inodes; ino++)
+    {
+        const size_t e = queue[ino];
+        myst_cpio_index_inode_t* inode = &inodes[ino];
+
+        if (e != 0)
+        {
+            const entry_t* entry = &entries[e - 1];
+
+            if (strings.size > UINT32_MAX)
+                ERAISE(-EFBIG);
+
+            inode->mode = entry->mode;
+            inode->name = (uint32_t)strings.size;
+
+            if (myst_buf_append(
+                    &strings, entry->name, strlen(entry->name) + 1) != 0)
+            {
+                ERAISE(-ENOMEM);
+            }
+
+            if (!S_ISDIR(entry->mode))
+            {
+                inode->offset = entry->offset;
+                inode->size = entry->size;
+                continue;
+            }
+        }
+
+        inode->first_child = (uint32_t)next;
+        inode->num_children = (uint32_t)(first[e + 1] - first[e]);
+
+        for (size_t i = first[e]; i < first[e + 1]; i++)
+        {
+            const size_t c = children[i].entry;
+
+            if (S_ISDIR(entries[c - 1].mode))
+                inode->num_subdirs++;
+
+            queue[next++] = c;
+        }
+    }
+
+    /* [padding][header][inodes][strings][padding][footer] */
+    ECHECK(myst_round_up(cpio_size, ALIGNMENT, &offset));
+
+    {
+        myst_cpio_index_header_t header;
+        myst_cpio_index_footer_t footer;
+
+        memset(&header, 0, sizeof(header));
+        header.magic = MYST_CPIO_INDEX_MAGIC;
+        header.version = MYST_CPIO_INDEX_VERSION;
+        header.num_inodes = (uint32_t)num_inodes;
+        header.archive_size = cpio_size;
+        header.strings_size = strings.size;
+
+        footer.offset = offset;
+        footer.magic = MYST_CPIO_INDEX_MAGIC;
+
+        if (myst_buf_resize(&buf, offset - cpio_size) != 0)
+            ERAISE(-ENOMEM);
+
+        if (buf.size)
+            memset(buf.data, 0, buf.size);
+
+        if (myst_buf_append(&buf, &header, sizeof(header)) != 0 ||
+            myst_buf_append(
+                &buf, inodes, num_inodes * sizeof(myst_cpio_index_inode_t)) !=
+                0 ||
+            myst_buf_append(&buf, strings.data, strings.size) != 0)
+        {
+            ERAISE(-ENOMEM);
+        }
+
+        /* (the padding so far is a multiple of ALIGNMENT too) */
+        ECHECK(_append_padding(&buf));
+
+        if (myst_buf_append(&buf, &footer, sizeof(footer)) != 0)
+            ERAISE(-ENOMEM);
+    }
+
+    *index_out = buf;
+    memset(&buf, 0, sizeof(buf));
+
+done:
+
+    _free_entries(entries, num_entries);
+
+    if (children)
+        free(children);
+
+    if (first)
+        free(first);
+
+    if (queue)
+        free(queue);
+
+    if (inodes)
+        free(inodes);
+
+    myst_buf_release(&strings);
+    myst_buf_release(&buf);
+
+    return ret;
+}
+
+int myst_cpio_index_append(const char* path)
+{
+    int ret = 0;
+    void* data = NULL;
+    size_t size;
+    myst_cpio_index_t index;
+    myst_buf_t buf = MYST_BUF_INITIALIZER;
+    int fd = -1;
+
+    if (!path)
+        ERAISE(-EINVAL);
+
+    ECHECK(myst_load_file(path, &data, &size));
+
+    if (!myst_is_cpio_archive(data, size))
+        ERAISE(-EINVAL);
+
+    /* the archive is already indexed */
+    if (myst_cpio_index_find(data, size, &index) == 0)
+        goto done;
+
+    ECHECK(myst_cpio_index_build(data, size, &buf));
+
+    if ((fd = open(path, O_WRONLY | O_APPEND)) < 0)
+        ERAISE(-errno);
+
+    ECHECK(myst_write_file_fd(fd, buf.data, buf.size));
+
+done:
+
+    if (fd >= 0)
+        close(fd);
+
+    if (data)
+        free(data);
+
+    myst_buf_release(&buf);
+
+    return ret;
+}
+
+/*
+**==============================================================================
+**
+** validation:
+**
+**==============================================================================
+*/
+
+static int _check_inode(
+    const myst_cpio_index_t* index,
+    size_t ino,
+    const myst_cpio_index_inode_t* inode)
+{
+    int ret = 0;
+
+    if (inode->name >= index->strings_size)
+        ERAISE_QUIET(-EINVAL);
+
+    if (S_ISDIR(inode->mode))
+    {
+        const size_t first = inode->first_child;
+        const size_t end = first + inode->num_children;
+        size_t num_subdirs = 0;
+
+        /* children follow their parent, so the tree has no cycles */
+        if (first <= ino || end < first || end > index->num_inodes)
+            ERAISE_QUIET(-EINVAL);
+
+        for (size_t i = first; i < end; i++)
+        {
+            if (S_ISDIR(index->inodes[i].mode))
+                num_subdirs++;
+        }
+
+        if (num_subdirs != inode->num_subdirs)
+            ERAISE_QUIET(-EINVAL);
+    }
+    else if (S_ISREG(inode->mode) || S_ISLNK(inode->mode))
+    {
+        if (inode->offset > index->archive_size ||
+            inode->size > index->archive_size - inode->offset)
+        {
+            ERAISE_QUIET(-EINVAL);
+        }
+    }
+    else
+    {
+        ERAISE_QUIET(-EINVAL);
+    }
+
+done:
+    return ret;
+}
+
+int myst_cpio_index_find(
+    const void* image,
+    size_t image_size,
+    myst_cpio_index_t* index)
+{
+    int ret = 0;
+    const uint8_t* p = (const uint8_t*)image;
+    myst_cpio_index_footer_t footer;
+    myst_cpio_index_header_t header;
+    size_t end;
+    size_t inodes_size;
+
+    if (index)
+        memset(index, 0, sizeof(myst_cpio_index_t));
+
+    if (!image || !index)
+        ERAISE(-EINVAL);
+
+    if (image_size < sizeof(footer) + sizeof(header))
+        ERAISE_QUIET(-ENOENT);
+
+    end = image_size - sizeof(footer);
+    memcpy(&footer, p + end, sizeof(footer));
+
+    if (footer.magic != MYST_CPIO_INDEX_MAGIC)
+        ERAISE_QUIET(-ENOENT);
+
+    if (footer.offset % ALIGNMENT || footer.offset > end - sizeof(header))
+        ERAISE_QUIET(-EINVAL);
+
+    memcpy(&header, p + footer.offset, sizeof(header));
+
+    if (header.magic != MYST_CPIO_INDEX_MAGIC ||
+        header.version != MYST_CPIO_INDEX_VERSION || header.num_inodes == 0 ||
+        header.archive_size > footer.offset)
+    {
+        ERAISE_QUIET(-EINVAL);
+    }
+
+    inodes_size = header.num_inodes * sizeof(myst_cpio_index_inode_t);
+
+    if (inodes_size > end - footer.offset - sizeof(header) ||
+        header.strings_size == 0 ||
+        header.strings_size >
+            end - footer.offset - sizeof(header) - inodes_size)
+    {
+        ERAISE_QUIET(-EINVAL);
+    }
+
+    index->archive = p;
+    index->archive_size = header.archive_size;
+    index->inodes = (const myst_cpio_index_inode_t*)(p + footer.offset +
+                                                     sizeof(header));
+    index->num_inodes = header.num_inodes;
+    index->strings = (const char*)index->inodes + inodes_size;
+    index->strings_size = header.strings_size;
+
+    /* every name is terminated by the end of the string table */
+    if (index->strings[index->strings_size - 1] != '\0')
+        ERAISE_QUIET(-EINVAL);
+
+    if (!S_ISDIR(index->inodes[0].mode))
+        ERAISE_QUIET(-EINVAL);
+
+    for (size_t i = 0; i < index->num_inodes; i++)
+    {
+        if ((ret = _check_inode(index, i, &index->inodes[i])) != 0)
+            goto done;
+    }
+
+done:
+
+    if (ret != 0 && index)
+        memset(index, 0, sizeof(myst_cpio_index_t));
+
+    return ret;
+}
@@ -1,4 +1,5 @@
 #include <errno.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
@@ -143,3 +144,70 @@ long myst_iov_scatter(
 done:
     return ret;
 }
+
+void myst_iov_cursor_init(
+    myst_iov_cursor_t* cursor,
+    const struct iovec* iov,
+    int iovcnt)
+{
+    cursor->iov = iov;
+    cursor->iovcnt = iovcnt;
+    cursor->index = 0;
+    cursor->offset = 0;
+}
+
+static size_t _cursor_copy(
+    myst_iov_cursor_t* cursor,
+    uint8_t* buf,
+    size_t count,
+    bool to_iov)
+{
+    size_t r = count;
+
+    while (r > 0 && cursor->index < cursor->iovcnt)
+    {
+        const struct iovec* v = &cursor->iov[cursor->index];
+        size_t n = v->iov_len - cursor->offset;
+
+        if (n > r)
+            n = r;
+
+        if (n)
+        {
+            uint8_t* base = (uint8_t*)v->iov_base + cursor->offset;
+
+            if (to_iov)
+                memcpy(base, buf, n);
+            else
+                memcpy(buf, base, n);
+
+            buf += n;
+            r -= n;
+            cursor->offset += n;
+        }
+
+        if (cursor->offset == v->iov_len)
+        {
+            cursor->index++;
+            cursor->offset = 0;
+        }
+    }
+
+    return count - r;
+}
+
+size_t myst_iov_cursor_gather(
+    myst_iov_cursor_t* cursor,
+    void* buf,
+    size_t count)
+{
+    return _cursor_copy(cursor, buf, count, false);
+}
+
+size_t myst_iov_cursor_scatter(
+    myst_iov_cursor_t* cursor,
+    const void* buf,
+    size_t count)
+{
+    return _cursor_copy(cursor, (uint8_t*)buf, count, true);
+}